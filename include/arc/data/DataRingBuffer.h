@@ -0,0 +1 @@
+#include "../../../src/hed/libs/data/DataRingBuffer.h"
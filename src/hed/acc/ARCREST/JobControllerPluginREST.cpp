@@ -6,6 +6,7 @@
 
 #include <glib.h>
 
+#include <arc/Thread.h>
 #include <arc/StringConv.h>
 #include <arc/UserConfig.h>
 #include <arc/XMLNode.h>
@@ -25,6 +26,9 @@ namespace Arc {
 
   Logger JobControllerPluginREST::logger(Logger::getRootLogger(), "JobControllerPlugin.REST");
 
+  // Maximal number of jobs sent to service in single request
+  static const unsigned int jobs_per_request = 1000;
+
   class JobStateARCREST: public JobState {
   public:
     JobStateARCREST(const std::string& state): JobState(state, &StateMap) {}
@@ -81,107 +85,119 @@ namespace Arc {
     return pos != std::string::npos && lower(endpoint.substr(0, pos)) != "http" && lower(endpoint.substr(0, pos)) != "https";
   }
 
+  // Jobs are identified in requests by last part of their ID
+  static std::string GetLocalJobID(const std::string& id) {
+    std::string::size_type pos = id.rfind('/');
+    if(pos == std::string::npos) return id;
+    return id.substr(pos+1);
+  }
+
+  // Jobs which belong to same service
+  class ServiceJobs {
+   public:
+    URL url;
+    std::list<std::string> IDs;
+  };
+
+  // Serializes calls to processor which is shared by threads
+  class LockedInfoNodeProcessor: public JobControllerPluginREST::InfoNodeProcessor {
+   public:
+    LockedInfoNodeProcessor(JobControllerPluginREST::InfoNodeProcessor& processor): processor(processor) {}
+
+    virtual void operator()(std::string const& id, XMLNode node) {
+      Glib::Mutex::Lock lock_(lock);
+      processor(id, node);
+    }
+
+   private:
+    JobControllerPluginREST::InfoNodeProcessor& processor;
+    Glib::Mutex lock;
+  };
+
+  // Services waiting to be processed and collected results. Shared
+  // by all threads processing single operation.
+  class ServiceJobsQueue {
+   public:
+    ServiceJobsQueue(const UserConfig* usercfg, std::string const& action, int successCode,
+                     JobControllerPluginREST::InfoNodeProcessor& infoNodeProcessor):
+      usercfg(usercfg), action(action), successCode(successCode), processor(infoNodeProcessor), ok(true) {}
+
+    void Process(void) {
+      for(;;) {
+        ServiceJobs service;
+        {
+          Glib::Mutex::Lock lock_(lock);
+          if(services.empty()) break;
+          service = services.front();
+          services.pop_front();
+        }
+        std::list<std::string> processed;
+        std::list<std::string> notProcessed;
+        bool result = JobControllerPluginREST::ProcessJobs(usercfg, service.url, action, successCode,
+                                                           service.IDs, processed, notProcessed, processor);
+        Glib::Mutex::Lock lock_(lock);
+        IDsProcessed.splice(IDsProcessed.end(), processed);
+        IDsNotProcessed.splice(IDsNotProcessed.end(), notProcessed);
+        if(!result) ok = false;
+      }
+    }
+
+    static void ProcessThread(void* arg) {
+      reinterpret_cast<ServiceJobsQueue*>(arg)->Process();
+    }
+
+    const UserConfig* usercfg;
+    std::string action;
+    int successCode;
+    LockedInfoNodeProcessor processor;
+    Glib::Mutex lock;
+    std::list<ServiceJobs> services;
+    std::list<std::string> IDsProcessed;
+    std::list<std::string> IDsNotProcessed;
+    bool ok;
+  };
+
   void JobControllerPluginREST::UpdateJobs(std::list<Job*>& jobs, std::list<std::string>& IDsProcessed, std::list<std::string>& IDsNotProcessed, bool isGrouped) const {
     class JobStateProcessor: public InfoNodeProcessor {
      public:
-      JobStateProcessor(std::list<Job*>& jobs): jobs(jobs) {}
+      JobStateProcessor(std::list<Job*>& jobs) {
+        for(std::list<Job*>::iterator itJob = jobs.begin(); itJob != jobs.end(); ++itJob) {
+          jobsById[(*itJob)->JobID] = *itJob;
+        }
+      }
 
       virtual void operator()(std::string const& id, XMLNode node) {
-        std::string job_id = node["id"];
         std::string job_state = node["state"];
-        if(!job_state.empty() && !job_id.empty()) {
-          for(std::list<Job*>::iterator itJob = jobs.begin(); itJob != jobs.end(); ++itJob) {
-            std::string id = (*itJob)->JobID;
-            std::string::size_type pos = id.rfind('/');
-            if(pos != std::string::npos) id.erase(0,pos+1);
-            if(job_id == id) {
-              (*itJob)->State = JobStateARCREST(job_state);
-              // (*itJob)->RestartState = ;
-              // (*itJob)->StageInDir = (std::string)aid["esainfo:StageInDirectory"];
-              // (*itJob)->StageOutDir = (std::string)aid["esainfo:StageInDirectory"];
-              // (*itJob)->SessionDir = (std::string)aid["esainfo:StageInDirectory"];
-              // (*itJob)->DelegationID.push_back ;
-              // (*itJob)->JobID = ;
-              break;
-            }
+        if(!job_state.empty()) {
+          std::map<std::string,Job*>::iterator itJob = jobsById.find(id);
+          if(itJob != jobsById.end()) {
+            itJob->second->State = JobStateARCREST(job_state);
+            // itJob->second->RestartState = ;
+            // itJob->second->StageInDir = (std::string)aid["esainfo:StageInDirectory"];
+            // itJob->second->StageOutDir = (std::string)aid["esainfo:StageInDirectory"];
+            // itJob->second->SessionDir = (std::string)aid["esainfo:StageInDirectory"];
+            // itJob->second->DelegationID.push_back ;
+            // itJob->second->JobID = ;
           }
         }
       }
 
      private:
-      std::list<Job*>& jobs;
+      std::map<std::string,Job*> jobsById;
     };
 
     JobStateProcessor stateProcessor(jobs);
-    Arc::URL currentServiceUrl;
-    std::list<std::string> IDs;
-    for (std::list<Job*>::const_iterator it = jobs.begin(); it != jobs.end(); ++it) {
-      if(!currentServiceUrl || (currentServiceUrl != GetAddressOfResource(**it))) {
-        if(!IDs.empty()) {
-          std::list<std::string> fakeIDs = IDs;
-          ProcessJobs(usercfg, currentServiceUrl, "status", 200, IDs, IDsProcessed, IDsNotProcessed, stateProcessor);
-        }
-        currentServiceUrl = GetAddressOfResource(**it);
-      }
-
-      IDs.push_back((*it)->JobID);
-    }
-    if(!IDs.empty()) {
-      std::list<std::string> fakeIDs = IDs;
-      ProcessJobs(usercfg, currentServiceUrl, "status", 200, IDs, IDsProcessed, IDsNotProcessed, stateProcessor);
-    }
+    ProcessJobs(jobs, "status", 200, IDsProcessed, IDsNotProcessed, stateProcessor);
   }
 
   bool JobControllerPluginREST::CleanJobs(const std::list<Job*>& jobs, std::list<std::string>& IDsProcessed, std::list<std::string>& IDsNotProcessed, bool isGrouped) const {
-    bool ok = true;
-    
     InfoNodeProcessor infoNodeProcessor;
-    Arc::URL currentServiceUrl;
-    std::list<std::string> IDs;
-    for (std::list<Job*>::const_iterator it = jobs.begin(); it != jobs.end(); ++it) {
-      if(!currentServiceUrl || (currentServiceUrl != GetAddressOfResource(**it))) {
-        if(!IDs.empty()) {
-          if (!ProcessJobs(usercfg, currentServiceUrl, "clean", 202, IDs, IDsProcessed, IDsNotProcessed, infoNodeProcessor))
-            ok = false;
-        }
-        currentServiceUrl = GetAddressOfResource(**it);
-      }
-
-      IDs.push_back((*it)->JobID);
-    }
-    if(!IDs.empty()) {
-      if (!ProcessJobs(usercfg, currentServiceUrl, "clean", 202, IDs, IDsProcessed, IDsNotProcessed, infoNodeProcessor)) {
-        ok = false;
-      }
-    }
-
-    return ok;
+    return ProcessJobs(jobs, "clean", 202, IDsProcessed, IDsNotProcessed, infoNodeProcessor);
   }
 
   bool JobControllerPluginREST::CancelJobs(const std::list<Job*>& jobs, std::list<std::string>& IDsProcessed, std::list<std::string>& IDsNotProcessed, bool isGrouped) const {
-    bool ok = true;
-    
     InfoNodeProcessor infoNodeProcessor;
-    Arc::URL currentServiceUrl;
-    std::list<std::string> IDs;
-    for (std::list<Job*>::const_iterator it = jobs.begin(); it != jobs.end(); ++it) {
-      if(!currentServiceUrl || (currentServiceUrl != GetAddressOfResource(**it))) {
-        if(!IDs.empty()) {
-          if (!ProcessJobs(usercfg, currentServiceUrl, "kill", 202, IDs, IDsProcessed, IDsNotProcessed, infoNodeProcessor))
-            ok = false;
-        }
-        currentServiceUrl = GetAddressOfResource(**it);
-      }
-
-      IDs.push_back((*it)->JobID);
-    }
-    if(!IDs.empty()) {
-      if (!ProcessJobs(usercfg, currentServiceUrl, "kill", 202, IDs, IDsProcessed, IDsNotProcessed, infoNodeProcessor)) {
-        ok = false;
-      }
-    }
-
-    return ok;
+    return ProcessJobs(jobs, "kill", 202, IDsProcessed, IDsNotProcessed, infoNodeProcessor);
   }
 
   bool JobControllerPluginREST::RenewJobs(const std::list<Job*>& jobs, std::list<std::string>& IDsProcessed, std::list<std::string>& IDsNotProcessed, bool isGrouped) const {
@@ -219,30 +235,45 @@ namespace Arc {
   }
 
   bool JobControllerPluginREST::ResumeJobs(const std::list<Job*>& jobs, std::list<std::string>& IDsProcessed, std::list<std::string>& IDsNotProcessed, bool isGrouped) const {
-    bool ok = true;
-    
     InfoNodeProcessor infoNodeProcessor;
-    Arc::URL currentServiceUrl;
-    std::list<std::string> IDs;
-    for (std::list<Job*>::const_iterator it = jobs.begin(); it != jobs.end(); ++it) {
-      if(!currentServiceUrl || (currentServiceUrl != GetAddressOfResource(**it))) {
-        if(!IDs.empty()) {
-          if (!ProcessJobs(usercfg, currentServiceUrl, "restart", 202, IDs, IDsProcessed, IDsNotProcessed, infoNodeProcessor)) {
-            ok = false;
-          }
-        }
-        currentServiceUrl = GetAddressOfResource(**it);
-      }
+    return ProcessJobs(jobs, "restart", 202, IDsProcessed, IDsNotProcessed, infoNodeProcessor);
+  }
 
-      IDs.push_back((*it)->JobID);
+  bool JobControllerPluginREST::ProcessJobs(const std::list<Job*>& jobs, std::string const & action, int successCode,
+          std::list<std::string>& IDsProcessed, std::list<std::string>& IDsNotProcessed,
+          InfoNodeProcessor& infoNodeProcessor) const {
+    ServiceJobsQueue queue(usercfg, action, successCode, infoNodeProcessor);
+    {
+      // Jobs of same service are collected together independently of their order
+      std::map<std::string,ServiceJobs> services;
+      for (std::list<Job*>::const_iterator it = jobs.begin(); it != jobs.end(); ++it) {
+        URL serviceUrl = GetAddressOfResource(**it);
+        ServiceJobs& service = services[serviceUrl.fullstr()];
+        if(service.IDs.empty()) service.url = serviceUrl;
+        service.IDs.push_back((*it)->JobID);
+      }
+      for(std::map<std::string,ServiceJobs>::iterator it = services.begin(); it != services.end(); ++it) {
+        queue.services.push_back(it->second);
+      }
     }
-    if(!IDs.empty()) {
-      if (!ProcessJobs(usercfg, currentServiceUrl, "restart", 202, IDs, IDsProcessed, IDsNotProcessed, infoNodeProcessor)) {
-        ok = false;
+    if(queue.services.empty()) return true;
+
+    // Current thread takes part in processing too
+    int threads = usercfg->ParallelRequests();
+    if(threads > (int)queue.services.size()) threads = queue.services.size();
+    SimpleCounter counter;
+    for(int n = 1; n < threads; ++n) {
+      if(!CreateThreadFunction(&ServiceJobsQueue::ProcessThread, &queue, &counter)) {
+        logger.msg(DEBUG, "Failed to start thread for processing jobs - continuing with %i threads", n);
+        break;
       }
     }
+    queue.Process();
+    counter.wait();
 
-    return ok;
+    IDsProcessed.splice(IDsProcessed.end(), queue.IDsProcessed);
+    IDsNotProcessed.splice(IDsNotProcessed.end(), queue.IDsNotProcessed);
+    return queue.ok;
   }
 
   bool JobControllerPluginREST::ProcessJobs(const UserConfig* usercfg, Arc::URL const & resourceUrl, std::string const & action, int successCode,
@@ -254,18 +285,38 @@ namespace Arc {
 
     Arc::MCCConfig cfg;
     usercfg->ApplyToConfig(cfg);
+    // Same client is used for all batches to keep connection open
     Arc::ClientHTTP client(cfg, statusUrl);
+    bool ok = true;
+    std::list<std::string> notReturnedIDs;
+    while(!IDs.empty()) {
+      // Local job id -> job id as passed by caller
+      std::map<std::string,std::string> batchIDs;
+      while(!IDs.empty() && (batchIDs.size() < jobs_per_request)) {
+        batchIDs.insert(std::pair<std::string,std::string>(GetLocalJobID(IDs.front()), IDs.front()));
+        IDs.pop_front();
+      }
+      if(!ProcessJobsRequest(client, successCode, batchIDs, IDsProcessed, IDsNotProcessed, infoNodeProcessor))
+        ok = false;
+      for(std::map<std::string,std::string>::iterator it = batchIDs.begin(); it != batchIDs.end(); ++it) {
+        notReturnedIDs.push_back(it->second);
+      }
+    }
+    IDs.swap(notReturnedIDs);
+    return ok;
+  }
+
+  bool JobControllerPluginREST::ProcessJobsRequest(ClientHTTP& client, int successCode,
+          std::map<std::string,std::string>& IDs, std::list<std::string>& IDsProcessed, std::list<std::string>& IDsNotProcessed,
+          InfoNodeProcessor& infoNodeProcessor) {
     Arc::PayloadRaw request;
     Arc::PayloadRawInterface* response(NULL);
     Arc::HTTPClientInfo info;
     {
       XMLNode jobs_id_list("<jobs/>");
-      for (std::list<std::string>::const_iterator it = IDs.begin(); it != IDs.end(); ++it) {
-        std::string id(*it);
-        std::string::size_type pos = id.rfind('/');
-        if(pos != std::string::npos) id.erase(0,pos+1);
+      for (std::map<std::string,std::string>::const_iterator it = IDs.begin(); it != IDs.end(); ++it) {
         Arc::XMLNode job = jobs_id_list.NewChild("job");
-        job.NewChild("id") = id;
+        job.NewChild("id") = it->first;
       }
       std::string jobs_id_str;
       jobs_id_list.GetXML(jobs_id_str);
@@ -278,10 +329,11 @@ namespace Arc {
       logger.msg(WARNING, "Failed to process jobs - wrong response: %u", info.code);
       if(response && response->Content()) logger.msg(DEBUG, "Content: %s", response->Content());
       delete response; response = NULL;
-      for (std::list<std::string>::const_iterator it = IDs.begin(); it != IDs.end(); ++it) {
-        logger.msg(WARNING, "Failed to process job: %s", *it);
-        IDsNotProcessed.push_back(*it);
+      for (std::map<std::string,std::string>::const_iterator it = IDs.begin(); it != IDs.end(); ++it) {
+        logger.msg(WARNING, "Failed to process job: %s", it->second);
+        IDsNotProcessed.push_back(it->second);
       }
+      IDs.clear();
       return false;
     }
 
@@ -290,10 +342,11 @@ namespace Arc {
     delete response; response = NULL;
     if(!jobs_list || (jobs_list.Name() != "jobs")) {
       logger.msg(WARNING, "Failed to process jobs - failed to parse response");
-      for (std::list<std::string>::const_iterator it = IDs.begin(); it != IDs.end(); ++it) {
-        logger.msg(WARNING, "Failed to process job: %s", *it);
-        IDsNotProcessed.push_back(*it);
+      for (std::map<std::string,std::string>::const_iterator it = IDs.begin(); it != IDs.end(); ++it) {
+        logger.msg(WARNING, "Failed to process job: %s", it->second);
+        IDsNotProcessed.push_back(it->second);
       }
+      IDs.clear();
       return false;
     }
 
@@ -301,9 +354,9 @@ namespace Arc {
     Arc::XMLNode job_item = jobs_list["job"];
     for (;; ++job_item) {
       if(!job_item) { // no more jobs returned 
-        for (std::list<std::string>::const_iterator it = IDs.begin(); it != IDs.end(); ++it) {
-          logger.msg(WARNING, "No response returned: %s", *it);
-          IDsNotProcessed.push_back(*it);
+        for (std::map<std::string,std::string>::const_iterator it = IDs.begin(); it != IDs.end(); ++it) {
+          logger.msg(WARNING, "No response returned: %s", it->second);
+          IDsNotProcessed.push_back(it->second);
           ok = false;
         }
         break;
@@ -315,24 +368,18 @@ namespace Arc {
       if(jid.empty()) {
         // hmm
       } else {
-        std::list<std::string>::iterator it = IDs.begin();
-        for (; it != IDs.end(); ++it) {
-          std::string id(*it);
-          std::string::size_type pos = id.rfind('/');
-          if(pos != std::string::npos) id.erase(0,pos+1);
-          if (id == jid) break;
-        }
+        std::map<std::string,std::string>::iterator it = IDs.find(jid);
         if(it == IDs.end()) {
           // hmm again
         } else {
           if(jcode != Arc::tostring(successCode)) {
             logger.msg(WARNING, "Failed to process job: %s - %s %s", jid, jcode, jreason);
-            IDsNotProcessed.push_back(*it);
+            IDsNotProcessed.push_back(it->second);
             ok = false;
           } else {
-            IDsProcessed.push_back(*it);
+            IDsProcessed.push_back(it->second);
           }
-          infoNodeProcessor(*it, job_item);
+          infoNodeProcessor(it->second, job_item);
           IDs.erase(it);
         }
       }
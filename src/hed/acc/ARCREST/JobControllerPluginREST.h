@@ -3,10 +3,14 @@
 #ifndef __ARC_JOBCONTROLLERREST_H__
 #define __ARC_JOBCONTROLLERREST_H__
 
+#include <map>
+
 #include <arc/compute/JobControllerPlugin.h>
 
 namespace Arc {
 
+  class ClientHTTP;
+
   class JobControllerPluginREST : public JobControllerPlugin {
   public:
     JobControllerPluginREST(const UserConfig& usercfg, PluginArgument* parg) : JobControllerPlugin(usercfg, parg) { supportedInterfaces.push_back("org.nordugrid.arcrest"); }
@@ -34,6 +38,9 @@ namespace Arc {
       virtual void operator()(std::string const& job_id, XMLNode info_node) {};
     };
 
+    /// Applies action to jobs of single service
+    /** Jobs are sent in batches through same connection. On return IDs
+        contains jobs for which service returned no information. */
     static bool ProcessJobs(const UserConfig* usercfg, Arc::URL const & resourceUrl, std::string const & action, int successCode,
           std::list<std::string>& IDs, std::list<std::string>& IDsProcessed, std::list<std::string>& IDsNotProcessed,
           InfoNodeProcessor& infoNodeProcessor);
@@ -42,6 +49,17 @@ namespace Arc {
     static URL GetAddressOfResource(const Job& job);
     static Logger logger;
 
+    /// Applies action to jobs of any services
+    /** Jobs are grouped by service and services are contacted in parallel.
+        Calls to infoNodeProcessor are serialized. */
+    bool ProcessJobs(const std::list<Job*>& jobs, std::string const & action, int successCode,
+          std::list<std::string>& IDsProcessed, std::list<std::string>& IDsNotProcessed,
+          InfoNodeProcessor& infoNodeProcessor) const;
+
+    static bool ProcessJobsRequest(ClientHTTP& client, int successCode,
+          std::map<std::string,std::string>& IDs, std::list<std::string>& IDsProcessed, std::list<std::string>& IDsNotProcessed,
+          InfoNodeProcessor& infoNodeProcessor);
+
   };
 
 } // namespace Arc
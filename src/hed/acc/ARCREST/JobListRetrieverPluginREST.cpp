@@ -84,29 +84,30 @@ namespace Arc {
 
     class JobDelegationsProcessor: public JobControllerPluginREST::InfoNodeProcessor {
      public:
-      JobDelegationsProcessor(std::list<Job*>& jobs): jobs(jobs) {}
+      JobDelegationsProcessor(std::list<Job*>& jobs) {
+        for(std::list<Job*>::iterator itJob = jobs.begin(); itJob != jobs.end(); ++itJob) {
+          std::string id = (*itJob)->JobID;
+          std::string::size_type pos = id.rfind('/');
+          if(pos != std::string::npos) id.erase(0,pos+1);
+          jobsById[id] = *itJob;
+        }
+      }
 
       virtual void operator()(std::string const& id, XMLNode node) {
-        std::string job_id = node["id"];
         XMLNode job_delegation_id = node["delegation_id"];
-        if((bool)job_delegation_id && !job_id.empty()) {
-          for(std::list<Job*>::iterator itJob = jobs.begin(); itJob != jobs.end(); ++itJob) {
-            std::string id = (*itJob)->JobID;
-            std::string::size_type pos = id.rfind('/');
-            if(pos != std::string::npos) id.erase(0,pos+1);
-            if(job_id == id) {
-              while(job_delegation_id) {
-                (*itJob)->DelegationID.push_back((std::string)job_delegation_id);
-                ++job_delegation_id;
-              }
-              break;
+        if((bool)job_delegation_id) {
+          std::map<std::string,Job*>::iterator itJob = jobsById.find(id);
+          if(itJob != jobsById.end()) {
+            while(job_delegation_id) {
+              itJob->second->DelegationID.push_back((std::string)job_delegation_id);
+              ++job_delegation_id;
             }
           }
         }
       }
 
      private:
-      std::list<Job*>& jobs;
+      std::map<std::string,Job*> jobsById;
     };
 
     std::list<std::string> processedIDs;
@@ -37,6 +37,18 @@ static void sig_shutdown(int)
     req_shutdown = true;
 }
 
+static std::list<Arc::LogQueue*> log_queues;
+
+static void flush_logger(void)
+{
+    if (log_queues.empty()) return;
+    Arc::Logger::rootLogger.removeDestinations();
+    for (std::list<Arc::LogQueue*>::iterator q = log_queues.begin(); q != log_queues.end(); ++q) {
+      delete *q;
+    }
+    log_queues.clear();
+}
+
 static void do_shutdown(void)
 {
     if(main_daemon) main_daemon->shutdown();
@@ -44,6 +56,7 @@ static void do_shutdown(void)
     if(loader) delete loader;
     if(main_daemon) delete main_daemon;
     logger.msg(Arc::DEBUG, "exit");
+    flush_logger();
     _exit(exit_code);
 }
 
@@ -206,6 +219,22 @@ static std::string init_logger(Arc::XMLNode log, bool foreground)
     return default_log;
 }
 
+// Log files are written from separate thread. Must be called after
+// daemonization because threads do not survive fork().
+static void init_async_logger(Arc::XMLNode log)
+{
+    if (!is_true(log["Asynchronous"])) return;
+    std::list<Arc::LogDestination*> dests = Arc::Logger::rootLogger.getDestinations();
+    for (std::list<Arc::LogDestination*>::iterator i = dests.begin(); i != dests.end(); ++i) {
+      if (!dynamic_cast<Arc::LogFile*>(*i)) continue;
+      Arc::LogQueue* q = new Arc::LogQueue(**i);
+      q->setFormat((*i)->getFormat());
+      log_queues.push_back(q);
+      *i = q;
+    }
+    Arc::Logger::rootLogger.setDestinations(dests);
+}
+
 static uid_t get_uid(const std::string &name)
 {
     struct passwd *ent;
@@ -407,6 +436,7 @@ int main(int argc, char **argv)
             if (!is_true((config)["Server"]["Foreground"])) {
                 main_daemon = new Arc::Daemon(pid_file, root_log_file, is_true((config)["Server"]["Watchdog"]), &daemon_kick);
             }
+            init_async_logger(config["Server"]["Logger"]);
             // set signal handlers
             signal(SIGTERM, sig_shutdown);
             signal(SIGINT, sig_shutdown);
@@ -12,6 +12,8 @@
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <limits.h>
 #include <unistd.h>
 
 #include <glibmm.h>
@@ -21,6 +23,7 @@
 #include <arc/URL.h>
 #include <arc/StringConv.h>
 #include <arc/data/DataBuffer.h>
+#include <arc/data/DataRingBuffer.h>
 #include <arc/data/DataCallback.h>
 #include <arc/CheckSum.h>
 #include <arc/FileUtils.h>
@@ -47,7 +50,9 @@ namespace ArcDMCFile {
       reading(false),
       writing(false),
       is_channel(false),
-      channel_num(0) {
+      channel_num(0),
+      ring(NULL),
+      ring_checksums(false) {
     fd = -1;
     fa = NULL;
     if (url.Protocol() == "file") {
@@ -354,6 +359,154 @@ namespace ArcDMCFile {
     }
   }
 
+  void DataPointFile::read_file_vectored_start(void* arg) {
+    ((DataPointFile*)arg)->read_file_vectored();
+  }
+
+  void DataPointFile::read_file_vectored() {
+    bool limit_length = false;
+    unsigned long long int range_length = 0;
+    unsigned long long int offset = 0;
+    if (range_end > range_start) {
+      range_length = range_end - range_start;
+      limit_length = true;
+      offset = range_start;
+    }
+    ::lseek(fd, offset, SEEK_SET);
+    unsigned int iov_max = ring->buffer_count();
+#ifdef IOV_MAX
+    if (iov_max > IOV_MAX) iov_max = IOV_MAX;
+#endif
+    struct iovec* iov = new struct iovec[iov_max];
+    for (;;) {
+      if (limit_length) if (range_length == 0) break;
+      /* 1. claim free slots */
+      unsigned int n = ring->for_read(iov, iov_max, true);
+      if (n == 0) {
+        /* failed to get slots - must be error or request to exit */
+        ring->error_read(true);
+        break;
+      }
+      if (limit_length) {
+        unsigned long long int l = 0;
+        unsigned int nn = 0;
+        for (; (nn < n) && (l < range_length); ++nn) {
+          if (iov[nn].iov_len > (range_length - l)) iov[nn].iov_len = range_length - l;
+          l += iov[nn].iov_len;
+        }
+        n = nn;
+      }
+      /* 2. read directly into slots */
+      ssize_t ll = ::readv(fd, iov, n);
+      if (ll == -1) {
+        ring->is_read(0, offset);
+        if (errno == EINTR) continue;
+        logger.msg(VERBOSE, "Failed to read file %s: %s", url.Path(), StrError(errno));
+        ring->error_read(true);
+        break;
+      }
+      /* 3. announce */
+      ring->is_read(ll, offset);
+      if (ll == 0) break; /* eof */
+      if (limit_length) range_length -= ll;
+      offset += ll;
+    }
+    delete[] iov;
+    if(fd != -1) close(fd);
+    fd = -1;
+    ring->eof_read(true);
+  }
+
+  void DataPointFile::write_file_vectored_start(void* arg) {
+    ((DataPointFile*)arg)->write_file_vectored();
+  }
+
+  void DataPointFile::write_file_vectored() {
+    unsigned long long int cksum_p = 0;
+    bool do_cksum = (!ring_checksums) && (checksums.size() > 0);
+    unsigned int iov_max = ring->buffer_count();
+#ifdef IOV_MAX
+    if (iov_max > IOV_MAX) iov_max = IOV_MAX;
+#endif
+    struct iovec* iov = new struct iovec[iov_max];
+    for (;;) {
+      /* 1. claim filled slots */
+      unsigned long long int p;
+      unsigned int n = ring->for_write(iov, iov_max, p, true);
+      if (n == 0) {
+        /* no more data - must be end of data, error or request to exit */
+        if (!ring->eof_read())
+          ring->error_write(true);
+        ring->eof_write(true);
+        break;
+      }
+      /* 2. checksum - data comes in order, so only start may be missing */
+      if (do_cksum) {
+        if (p != cksum_p) {
+          do_cksum = false;
+        } else {
+          for (unsigned int i = 0; i < n; ++i) {
+            for(std::list<CheckSum*>::iterator cksum = checksums.begin();
+                      cksum != checksums.end(); ++cksum) {
+              if(*cksum) (*cksum)->add(iov[i].iov_base, iov[i].iov_len);
+            }
+            cksum_p += iov[i].iov_len;
+          }
+        }
+      }
+      /* 3. write all slots, writev() may write only part of data */
+      bool failed = false;
+      if (!is_channel && (::lseek(fd, p, SEEK_SET) != (off_t)p)) {
+        failed = true;
+      }
+      struct iovec* v = iov;
+      unsigned int vn = n;
+      while (!failed && (vn > 0)) {
+        ssize_t ll = ::writev(fd, v, vn);
+        if (ll == -1) {
+          if (errno == EINTR) continue;
+          failed = true;
+          break;
+        }
+        while ((vn > 0) && ((size_t)ll >= v->iov_len)) {
+          ll -= v->iov_len; ++v; --vn;
+        }
+        if (vn > 0) {
+          v->iov_base = ((char*)(v->iov_base)) + ll;
+          v->iov_len -= ll;
+        }
+      }
+      if (failed) {
+        logger.msg(VERBOSE, "Failed to write file %s: %s", url.Path(), StrError(errno));
+        ring->is_written(0);
+        ring->error_write(true);
+        ring->eof_write(true);
+        break;
+      }
+      /* 4. announce */
+      ring->is_written(n);
+    }
+    delete[] iov;
+    if (fd != -1) {
+      // This is for broken filesystems. Specifically for Lustre.
+      if (fsync(fd) != 0 && errno != EINVAL) { // this error is caused by special files like stdout
+        logger.msg(ERROR, "fsync of file %s failed: %s", url.Path(), StrError(errno));
+        ring->error_write(true);
+      }
+      if(close(fd) != 0) {
+        logger.msg(ERROR, "closing file %s failed: %s", url.Path(), StrError(errno));
+        ring->error_write(true);
+      }
+      fd = -1;
+    }
+    if((do_cksum) && (cksum_p == ring->eof_position())) {
+      for(std::list<CheckSum*>::iterator cksum = checksums.begin();
+                cksum != checksums.end(); ++cksum) {
+        if(*cksum) (*cksum)->end();
+      }
+    }
+  }
+
   DataStatus DataPointFile::Check(bool check_meta) {
     if (reading) return DataStatus(DataStatus::IsReadingError, EARCLOGIC);
     if (writing) return DataStatus(DataStatus::IsWritingError, EARCLOGIC);
@@ -535,10 +688,14 @@ namespace ArcDMCFile {
   }
 
 
-  DataStatus DataPointFile::StartReading(DataBuffer& buf) {
-    if (reading) return DataStatus::IsReadingError;
-    if (writing) return DataStatus::IsWritingError;
-    reading = true;
+  bool DataPointFile::switch_user() const {
+    if (is_channel) return false;
+    uid_t uid = usercfg.GetUser().get_uid();
+    gid_t gid = usercfg.GetUser().get_gid();
+    return !(((!uid) || (uid == getuid())) && ((!gid) || (gid == getgid())));
+  }
+
+  DataStatus DataPointFile::open_read() {
     /* try to open */
     int flags = O_RDONLY;
     uid_t uid = usercfg.GetUser().get_uid();
@@ -548,16 +705,14 @@ namespace ArcDMCFile {
       fa = NULL;
       fd = open_channel();
       if (fd == -1) {
-        reading = false;
         return DataStatus(DataStatus::ReadStartError, EBADF, "Channel number is not defined");
       }
     }
-    else if(((!uid) || (uid == getuid())) && ((!gid) || (gid == getgid()))) {
+    else if(!switch_user()) {
       fa = NULL;
       fd = ::open(url.Path().c_str(), flags);
       if (fd == -1) {
         logger.msg(VERBOSE, "Failed to open %s for reading: %s", url.Path(), StrError(errno));
-        reading = false;
         return DataStatus(DataStatus::ReadStartError, errno, "Failed to open file "+url.Path()+" for reading");
       }
       /* provide some metadata */
@@ -572,13 +727,11 @@ namespace ArcDMCFile {
       if(!fa->fa_setuid(uid,gid)) {
         delete fa; fa = NULL;
         logger.msg(VERBOSE, "Failed to switch user id to %d/%d", (unsigned int)uid, (unsigned int)gid);
-        reading = false;
         return DataStatus(DataStatus::ReadStartError, EARCUIDSWITCH, "Failed to switch user id to "+tostring(uid)+"/"+tostring(gid));
       }
       if(!fa->fa_open(url.Path(), flags, 0)) {
         delete fa; fa = NULL;
         logger.msg(VERBOSE, "Failed to create/open file %s: %s", url.Path(), StrError(errno));
-        reading = false;
         return DataStatus(DataStatus::ReadStartError, errno, "Failed to open file "+url.Path()+" for reading");
       }
       struct stat st;
@@ -587,7 +740,20 @@ namespace ArcDMCFile {
         SetModified(st.st_mtime);
       }
     }
+    return DataStatus::Success;
+  }
+
+  DataStatus DataPointFile::StartReading(DataBuffer& buf) {
+    if (reading) return DataStatus::IsReadingError;
+    if (writing) return DataStatus::IsWritingError;
+    reading = true;
+    DataStatus res = open_read();
+    if (!res) {
+      reading = false;
+      return res;
+    }
     buffer = &buf;
+    ring = NULL;
     /* create thread to maintain reading */
     if(!CreateThreadFunction(&DataPointFile::read_file_start,this,&transfers_started)) {
       if(fd != -1) ::close(fd);
@@ -600,9 +766,54 @@ namespace ArcDMCFile {
     return DataStatus::Success;
   }
 
+  DataStatus DataPointFile::StartReadingVectored(DataRingBuffer& buf) {
+    if (reading) return DataStatus::IsReadingError;
+    if (writing) return DataStatus::IsWritingError;
+    // readv() is not available through FileAccess
+    if (switch_user()) return DataStatus(DataStatus::UnimplementedError, EOPNOTSUPP);
+    reading = true;
+    DataStatus res = open_read();
+    if (!res) {
+      reading = false;
+      return res;
+    }
+    ring = &buf;
+    buffer = NULL;
+    if (range_end <= range_start) {
+      for(std::list<CheckSum*>::iterator cksum = checksums.begin();
+                cksum != checksums.end(); ++cksum) {
+        if(*cksum) ring->add(*cksum);
+      }
+    }
+    /* create thread to maintain reading */
+    if(!CreateThreadFunction(&DataPointFile::read_file_vectored_start,this,&transfers_started)) {
+      if(fd != -1) ::close(fd);
+      fd = -1;
+      logger.msg(VERBOSE, "Failed to create thread");
+      ring->error_read(true);
+      ring = NULL;
+      reading = false;
+      return DataStatus(DataStatus::ReadStartError, "Failed to create new thread");
+    }
+    return DataStatus::Success;
+  }
+
   DataStatus DataPointFile::StopReading() {
     if (!reading) return DataStatus(DataStatus::ReadStopError, EARCLOGIC, "Not reading");
     reading = false;
+    if (ring) {
+      if (!ring->eof_read()) {
+        ring->error_read(true);      /* trigger transfer error */
+        if(fd != -1) ::close(fd);
+        fd = -1;
+      }
+      transfers_started.wait();         /* wait till reading thread exited */
+      ring->wait_checksum();
+      bool failed = ring->error_read();
+      ring = NULL;
+      if (failed) return DataStatus::ReadError;
+      return DataStatus::Success;
+    }
     if (!buffer->eof_read()) {
       buffer->error_read(true);      /* trigger transfer error */
       if(fd != -1) ::close(fd);
@@ -651,20 +862,13 @@ namespace ArcDMCFile {
 #endif
   }
 
-  DataStatus DataPointFile::StartWriting(DataBuffer& buf, DataCallback *space_cb) {
-    if (reading) return DataStatus::IsReadingError;
-    if (writing) return DataStatus::IsWritingError;
-    writing = true;
+  DataStatus DataPointFile::open_write(DataCallback *space_cb, DataSpeed& speed) {
     uid_t uid = usercfg.GetUser().get_uid();
     gid_t gid = usercfg.GetUser().get_gid();
     /* try to open */
-    buffer = &buf;
     if (is_channel) {
       fd = open_channel();
       if (fd == -1) {
-        buffer->error_write(true);
-        buffer->eof_write(true);
-        writing = false;
         return DataStatus(DataStatus::WriteStartError, EBADF, "Channel number is not defined");
       }
     }
@@ -674,31 +878,22 @@ namespace ArcDMCFile {
       /* make directories */
       if (url.Path().empty()) {
         logger.msg(VERBOSE, "Invalid url: %s", url.str());
-        buffer->error_write(true);
-        buffer->eof_write(true);
-        writing = false;
         return DataStatus(DataStatus::WriteStartError, EINVAL, "Invalid URL "+url.str());
       }
       std::string dirpath = Glib::path_get_dirname(url.Path());
       if(dirpath == ".") dirpath = G_DIR_SEPARATOR_S; // shouldn't happen
       if (!DirCreate(dirpath, uid, gid, S_IRWXU, true)) {
         logger.msg(VERBOSE, "Failed to create directory %s: %s", dirpath, StrError(errno));
-        buffer->error_write(true);
-        buffer->eof_write(true);
-        writing = false;
         return DataStatus(DataStatus::WriteStartError, errno, "Failed to create directory "+dirpath);
       }
 
       /* try to create file. Opening an existing file will cause failure */
       int flags = (checksums.size() > 0)?O_RDWR:O_WRONLY;
-      if(((!uid) || (uid == getuid())) && ((!gid) || (gid == getgid()))) {
+      if(!switch_user()) {
         fa = NULL;
         fd = ::open(url.Path().c_str(), flags | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
         if (fd == -1) {
           logger.msg(VERBOSE, "Failed to create file %s: %s", url.Path(), StrError(errno));
-          buffer->error_write(true);
-          buffer->eof_write(true);
-          writing = false;
           return DataStatus(DataStatus::WriteStartError, errno, "Failed to create file "+url.Path());
         }
       } else {
@@ -707,23 +902,17 @@ namespace ArcDMCFile {
         if(!fa->fa_setuid(uid,gid)) {
           delete fa; fa = NULL;
           logger.msg(VERBOSE, "Failed to switch user id to %d/%d", (unsigned int)uid, (unsigned int)gid);
-          buffer->error_write(true);
-          buffer->eof_write(true);
-          writing = false;
           return DataStatus(DataStatus::WriteStartError, EARCUIDSWITCH, "Failed to switch user id to "+tostring(uid)+"/"+tostring(gid));
         }
         if(!fa->fa_open(url.Path(), flags | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR)) {
           delete fa; fa = NULL;
           logger.msg(VERBOSE, "Failed to create file %s: %s", url.Path(), StrError(errno));
-          buffer->error_write(true);
-          buffer->eof_write(true);
-          writing = false;
           return DataStatus(DataStatus::WriteStartError, errno, "Failed to create file "+url.Path());
         }
       }
 
       /* preallocate space */
-      buffer->speed.hold(true);
+      speed.hold(true);
       if (additional_checks && CheckSize() && GetSize() > 0) {
         unsigned long long int fsize = GetSize();
         logger.msg(INFO, "setting file %s to size %llu", url.Path(), fsize);
@@ -747,17 +936,30 @@ namespace ArcDMCFile {
             fa->fa_close(); delete fa; fa = NULL;
           }
           logger.msg(VERBOSE, "Failed to preallocate space for %s", url.Path());
-          buffer->speed.reset();
-          buffer->speed.hold(false);
-          buffer->error_write(true);
-          buffer->eof_write(true);
-          writing = false;
+          speed.reset();
+          speed.hold(false);
           return DataStatus(DataStatus::WriteStartError, ENOSPC, "Failed to preallocate space for file "+url.Path());
         }
       }
     }
-    buffer->speed.reset();
-    buffer->speed.hold(false);
+    speed.reset();
+    speed.hold(false);
+    return DataStatus::Success;
+  }
+
+  DataStatus DataPointFile::StartWriting(DataBuffer& buf, DataCallback *space_cb) {
+    if (reading) return DataStatus::IsReadingError;
+    if (writing) return DataStatus::IsWritingError;
+    writing = true;
+    buffer = &buf;
+    ring = NULL;
+    DataStatus res = open_write(space_cb, buffer->speed);
+    if (!res) {
+      buffer->error_write(true);
+      buffer->eof_write(true);
+      writing = false;
+      return res;
+    }
     /* create thread to maintain writing */
     if(!CreateThreadFunction(&DataPointFile::write_file_start,this,&transfers_started)) {
       if(fd != -1) { close(fd); fd = -1; }
@@ -770,20 +972,70 @@ namespace ArcDMCFile {
     return DataStatus::Success;
   }
 
+  DataStatus DataPointFile::StartWritingVectored(DataRingBuffer& buf, DataCallback *space_cb) {
+    if (reading) return DataStatus::IsReadingError;
+    if (writing) return DataStatus::IsWritingError;
+    // writev() is not available through FileAccess
+    if (switch_user()) return DataStatus(DataStatus::UnimplementedError, EOPNOTSUPP);
+    writing = true;
+    ring = &buf;
+    buffer = NULL;
+    DataStatus res = open_write(space_cb, ring->speed);
+    if (!res) {
+      ring->error_write(true);
+      writing = false;
+      ring = NULL;
+      return res;
+    }
+    /* Checksums are computed by ring buffer if data did not start flowing
+       yet. Otherwise writing thread computes them. */
+    ring_checksums = true;
+    for(std::list<CheckSum*>::iterator cksum = checksums.begin();
+              cksum != checksums.end(); ++cksum) {
+      if(*cksum && (ring->add(*cksum) < 0)) ring_checksums = false;
+    }
+    /* create thread to maintain writing */
+    if(!CreateThreadFunction(&DataPointFile::write_file_vectored_start,this,&transfers_started)) {
+      if(fd != -1) { close(fd); fd = -1; }
+      ring->error_write(true);
+      writing = false;
+      ring = NULL;
+      return DataStatus(DataStatus::WriteStartError, "Failed to create new thread");
+    }
+    return DataStatus::Success;
+  }
+
   DataStatus DataPointFile::StopWriting() {
     if (!writing) return DataStatus(DataStatus::WriteStopError, EARCLOGIC, "Not writing");
     writing = false;
-    if (!buffer->eof_write()) {
-      buffer->error_write(true);      /* trigger transfer error */
-      if(fd != -1) close(fd);
-      if(fa) fa->fa_close();
-      fd = -1;
+    bool failed = false;
+    bool write_failed = false;
+    if (ring) {
+      if (!ring->eof_write()) {
+        ring->error_write(true);      /* trigger transfer error */
+        if(fd != -1) close(fd);
+        fd = -1;
+      }
+      transfers_started.wait();         /* wait till writing thread exited */
+      if (ring_checksums) ring->wait_checksum();
+      failed = ring->error();
+      write_failed = ring->error_write();
+      ring = NULL;
+    } else {
+      if (!buffer->eof_write()) {
+        buffer->error_write(true);      /* trigger transfer error */
+        if(fd != -1) close(fd);
+        if(fa) fa->fa_close();
+        fd = -1;
+      }
+      // buffer->wait_eof_write();
+      transfers_started.wait();         /* wait till writing thread exited */
+      failed = buffer->error();
+      write_failed = buffer->error_write();
     }
-    // buffer->wait_eof_write();
-    transfers_started.wait();         /* wait till writing thread exited */
 
     // clean up if transfer failed for any reason
-    if (buffer->error()) {
+    if (failed) {
       bool err = false;
       if (fa) err = fa->fa_unlink(url.Path());
       else err = FileDelete(url.Path());
@@ -792,7 +1044,7 @@ namespace ArcDMCFile {
     delete fa; fa = NULL;
 
     // validate file size, if transfer succeeded
-    if (!buffer->error() && additional_checks && CheckSize() && !is_channel) {
+    if (!failed && additional_checks && CheckSize() && !is_channel) {
       struct stat st;
       std::string path = url.Path();
       if (!FileStat(path, &st, usercfg.GetUser().get_uid(), usercfg.GetUser().get_gid(), true)) {
@@ -807,10 +1059,14 @@ namespace ArcDMCFile {
     }
     
     // TODO: error description from writing thread
-    if (buffer->error_write()) return DataStatus::WriteError;
+    if (write_failed) return DataStatus::WriteError;
     return DataStatus::Success;
   }
 
+  bool DataPointFile::SupportsVectoredIO() const {
+    return !switch_user();
+  }
+
   bool DataPointFile::WriteOutOfOrder() const {
     if (!url)
       return false;
@@ -7,6 +7,7 @@
 
 #include <arc/Thread.h>
 #include <arc/data/DataPointDirect.h>
+#include <arc/data/DataSpeed.h>
 
 namespace ArcDMCFile {
 
@@ -28,6 +29,9 @@ namespace ArcDMCFile {
     virtual DataStatus StartReading(DataBuffer& buffer);
     virtual DataStatus StartWriting(DataBuffer& buffer,
                                     DataCallback *space_cb = NULL);
+    virtual DataStatus StartReadingVectored(DataRingBuffer& buffer);
+    virtual DataStatus StartWritingVectored(DataRingBuffer& buffer,
+                                            DataCallback *space_cb = NULL);
     virtual DataStatus StopReading();
     virtual DataStatus StopWriting();
     virtual DataStatus Check(bool check_meta);
@@ -37,20 +41,33 @@ namespace ArcDMCFile {
     virtual DataStatus CreateDirectory(bool with_parents=false);
     virtual DataStatus Rename(const URL& newurl);
     virtual bool WriteOutOfOrder() const;
+    virtual bool SupportsVectoredIO() const;
     virtual bool RequiresCredentials() const { return false; };
   private:
     SimpleCounter transfers_started;
     int open_channel();
+    /// Returns true if file must be accessed through FileAccess under other user id
+    bool switch_user() const;
+    DataStatus open_read();
+    DataStatus open_write(DataCallback *space_cb, DataSpeed& speed);
     static void read_file_start(void* arg);
     static void write_file_start(void* arg);
+    static void read_file_vectored_start(void* arg);
+    static void write_file_vectored_start(void* arg);
     void read_file();
     void write_file();
+    void read_file_vectored();
+    void write_file_vectored();
     bool reading;
     bool writing;
     int fd;
     FileAccess* fa;
     bool is_channel;
     unsigned int channel_num;
+    /// Set instead of buffer while vectored transfer is active
+    DataRingBuffer* ring;
+    /// Checksums of written data are computed by ring
+    bool ring_checksums;
     static Logger logger;
   };
 
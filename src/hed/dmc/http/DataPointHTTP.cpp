@@ -15,11 +15,13 @@
 #include <arc/StringConv.h>
 #include <arc/UserConfig.h>
 #include <arc/data/DataBuffer.h>
+#include <arc/data/DataRingBuffer.h>
 #include <arc/message/MCC.h>
 #include <arc/message/PayloadRaw.h>
 #include <arc/Utils.h>
 
 #include "StreamBuffer.h"
+#include "StreamRing.h"
 #include "DataPointHTTP.h"
 
 namespace ArcDMCHTTP {
@@ -59,6 +61,34 @@ using namespace Arc;
     void Unclaim(uint64_t start, uint64_t length);
   };
 
+  // Chooses number of parallel ranged streams from observed throughput.
+  // Number of streams is increased while aggregated throughput grows and
+  // last added stream is retired if it made throughput worse.
+  class StreamControl {
+  private:
+    Glib::Mutex lock_;
+    int max_;
+    int target_;
+    int active_;
+    bool increased_;
+    uint64_t bytes_;
+    double rate_;
+    Time since_;
+  public:
+    StreamControl(int max, int initial);
+    // Stream was started
+    void Started();
+    // Stream exited
+    void Finished();
+    // Check if stream should go on with next chunk. Stream which is
+    // told to stop is not counted anymore and must not call Finished().
+    bool Continue();
+    // Report data received by any stream. Returns true if new
+    // stream should be started.
+    bool Transferred(uint64_t length);
+    int Active();
+  };
+
   class PayloadMemConst
     : public PayloadRawInterface {
   private:
@@ -267,20 +297,93 @@ using namespace Arc;
     lock_.unlock();
   }
 
+  // Length of period over which throughput is measured
+  static const double stream_rate_period = 2.0;
+
+  StreamControl::StreamControl(int max, int initial):
+      max_(max), target_(initial), active_(0), increased_(false), bytes_(0), rate_(0) {
+    if (target_ > max_) target_ = max_;
+    if (target_ < 1) target_ = 1;
+  }
+
+  void StreamControl::Started() {
+    Glib::Mutex::Lock lock(lock_);
+    ++active_;
+  }
+
+  void StreamControl::Finished() {
+    Glib::Mutex::Lock lock(lock_);
+    --active_;
+  }
+
+  bool StreamControl::Continue() {
+    Glib::Mutex::Lock lock(lock_);
+    // Last stream never retires
+    if ((active_ <= target_) || (active_ <= 1)) return true;
+    // Retiring stream is removed from count immediately. Otherwise all
+    // streams checking before first of them exits would retire.
+    --active_;
+    return false;
+  }
+
+  bool StreamControl::Transferred(uint64_t length) {
+    Glib::Mutex::Lock lock(lock_);
+    bytes_ += length;
+    Period p = Time() - since_;
+    double elapsed = (double)p.GetPeriod() + (double)p.GetPeriodNanoseconds() / 1000000000.0;
+    if (elapsed < stream_rate_period) return false;
+    double rate = bytes_ / elapsed;
+    bytes_ = 0;
+    since_ = Time();
+    bool start = false;
+    if (rate > rate_ * 1.1) {
+      // Throughput is growing - try one stream more
+      if (target_ < max_) {
+        ++target_;
+        increased_ = true;
+        start = (active_ < target_);
+      }
+    } else if ((rate < rate_ * 0.9) && increased_ && (target_ > 1)) {
+      // Added stream made it worse
+      --target_;
+      increased_ = false;
+    } else {
+      increased_ = false;
+    }
+    rate_ = rate;
+    if (start) ++active_;
+    return start;
+  }
+
+  int StreamControl::Active() {
+    Glib::Mutex::Lock lock(lock_);
+    return active_;
+  }
+
   DataPointHTTP::DataPointHTTP(const URL& url, const UserConfig& usercfg, PluginArgument* parg)
     : DataPointDirect(url, usercfg, parg),
       reading(false),
       writing(false),
       chunks(NULL),
+      ring(NULL),
+      streams(NULL),
+      max_streams(0),
+      range_chunk(0),
       transfers_tofinish(0),
       partial_read_allowed(url.Option("httpgetpartial") == "yes"),
       partial_write_allowed(url.Option("httpputpartial") == "yes") {
+    strtoint(url.Option("httpstreams"), max_streams);
+    if (max_streams < 0) max_streams = 0;
+    if (max_streams > MAX_PARALLEL_STREAMS) max_streams = MAX_PARALLEL_STREAMS;
+    // Every stream needs buffer to write into
+    if (bufnum < max_streams) bufnum = max_streams;
   }
 
   DataPointHTTP::~DataPointHTTP() {
     StopReading();
     StopWriting();
     if (chunks) delete chunks;
+    if (streams) delete streams;
     for(std::multimap<std::string,ClientHTTP*>::iterator cl = clients.begin(); cl != clients.end(); ++cl) {
       delete cl->second;
     };
@@ -783,13 +886,40 @@ using namespace Arc;
     if (transfer_streams > MAX_PARALLEL_STREAMS) transfer_streams = MAX_PARALLEL_STREAMS;
     DataPointHTTP::buffer = &buffer;
     if (chunks) delete chunks;
-    chunks = new ChunkControl;
+    chunks = NULL;
+    if (streams) delete streams;
+    streams = NULL;
+    if ((max_streams > 1) && allow_out_of_order) {
+      // Ranged multi-stream mode. Object of known size is split into
+      // ranges which are fetched over parallel connections.
+      if (!CheckSize()) {
+        FileInfo file;
+        Stat(file, INFO_TYPE_CONTENT);
+      }
+      if (CheckSize() && (GetSize() > 0)) {
+        const uint64_t min_chunk = 1024*1024;
+        const uint64_t max_chunk = 64*1024*1024;
+        // Few ranges per stream, so that faster streams can take over
+        range_chunk = GetSize() / (max_streams * 4);
+        if (range_chunk < min_chunk) range_chunk = min_chunk;
+        if (range_chunk > max_chunk) range_chunk = max_chunk;
+        chunks = new ChunkControl(GetSize());
+        // Start with half of allowed streams and adapt to throughput
+        transfer_streams = (max_streams + 1) / 2;
+        streams = new StreamControl(max_streams, transfer_streams);
+        logger.msg(VERBOSE, "Reading %llu bytes in ranges of %llu bytes using up to %i streams",
+                   GetSize(), range_chunk, max_streams);
+      }
+    }
+    if (!chunks) chunks = new ChunkControl;
     transfer_lock.lock();
     transfers_tofinish = 0;
     for (int n = 0; n < transfer_streams; ++n) {
       HTTPInfo_t *info = new HTTPInfo_t;
       info->point = this;
+      if (streams) streams->Started();
       if (!CreateThreadFunction(&read_thread, info, &transfers_started)) {
+        if (streams) streams->Finished();
         delete info;
       } else {
         ++transfers_tofinish;
@@ -804,9 +934,56 @@ using namespace Arc;
     return DataStatus::Success;
   }
 
+  void DataPointHTTP::add_read_stream() {
+    // Called from one of running streams, so transfers_tofinish can't
+    // drop to 0 meanwhile.
+    HTTPInfo_t *info = new HTTPInfo_t;
+    info->point = this;
+    transfer_lock.lock();
+    if (!CreateThreadFunction(&read_thread, info, &transfers_started)) {
+      streams->Finished();
+      delete info;
+    } else {
+      ++transfers_tofinish;
+      logger.msg(DEBUG, "Throughput grows - using %i streams", streams->Active());
+    }
+    transfer_lock.unlock();
+  }
+
+  DataStatus DataPointHTTP::StartReadingVectored(DataRingBuffer& buffer) {
+    if (reading) return DataStatus::IsReadingError;
+    if (writing) return DataStatus::IsWritingError;
+    if (transfers_started.get() != 0) return DataStatus(DataStatus::IsReadingError, EARCLOGIC);
+    reading = true;
+    // Data must come in order, hence single stream is used
+    ring = &buffer;
+    DataPointHTTP::buffer = NULL;
+    HTTPInfo_t *info = new HTTPInfo_t;
+    info->point = this;
+    if (!CreateThreadFunction(&read_ring_thread, info, &transfers_started)) {
+      delete info;
+      ring->error_read(true);
+      ring = NULL;
+      reading = false;
+      return DataStatus::ReadStartError;
+    }
+    return DataStatus::Success;
+  }
+
   DataStatus DataPointHTTP::StopReading() {
     if (!reading) return DataStatus::ReadStopError;
     reading = false;
+    if (ring) {
+      if(!ring->eof_read()) ring->error_read(true);
+      while (transfers_started.get()) {
+        transfers_started.wait(10000); // Just in case
+      }
+      ring->wait_checksum();
+      bool failed = ring->error_read();
+      ring = NULL;
+      if (failed) return DataStatus::ReadError;
+      return DataStatus::Success;
+    }
     if (!buffer) return DataStatus(DataStatus::ReadStopError, EARCLOGIC, "Not reading");
     if(!buffer->eof_read()) buffer->error_read(true);
     while (transfers_started.get()) {
@@ -814,6 +991,8 @@ using namespace Arc;
     }
     if (chunks) delete chunks;
     chunks = NULL;
+    if (streams) delete streams;
+    streams = NULL;
     transfers_tofinish = 0;
     if (buffer->error_read()) {
       buffer = NULL;
@@ -856,9 +1035,40 @@ using namespace Arc;
     return DataStatus::Success;
   }
 
+  DataStatus DataPointHTTP::StartWritingVectored(DataRingBuffer& buffer,
+                                                 DataCallback*) {
+    if (reading) return DataStatus::IsReadingError;
+    if (writing) return DataStatus::IsWritingError;
+    if (transfers_started.get() != 0) return DataStatus(DataStatus::IsWritingError, EARCLOGIC);
+    writing = true;
+    // Whole body is sent in single PUT request
+    ring = &buffer;
+    DataPointHTTP::buffer = NULL;
+    HTTPInfo_t *info = new HTTPInfo_t;
+    info->point = this;
+    if (!CreateThreadFunction(&write_ring_thread, info, &transfers_started)) {
+      delete info;
+      ring->error_write(true);
+      ring = NULL;
+      writing = false;
+      return DataStatus::WriteStartError;
+    }
+    return DataStatus::Success;
+  }
+
   DataStatus DataPointHTTP::StopWriting() {
     if (!writing) return DataStatus::WriteStopError;
     writing = false;
+    if (ring) {
+      if(!ring->eof_write()) ring->error_write(true);
+      while (transfers_started.get()) {
+        transfers_started.wait(); // Just in case
+      }
+      bool failed = ring->error_write();
+      ring = NULL;
+      if (failed) return DataStatus::WriteError;
+      return DataStatus::Success;
+    }
     if (!buffer) return DataStatus(DataStatus::WriteStopError, EARCLOGIC, "Not writing");
     if(!buffer->eof_write()) buffer->error_write(true);
     while (transfers_started.get()) {
@@ -1073,11 +1283,17 @@ using namespace Arc;
     URL client_url = point.url;
     AutoPointer<ClientHTTP> client(point.acquire_client(client_url));
     bool transfer_failure = false;
+    bool retired = false;
     int retries = 0;
     std::string path = point.CurrentLocation().FullPathURIEncoded();
     DataStatus failure_code;
-    bool partial_allowed = point.partial_read_allowed && point.allow_out_of_order;
+    bool partial_allowed = (point.partial_read_allowed || point.streams) && point.allow_out_of_order;
     if(partial_allowed) for (;;) {
+      if (point.streams && !point.streams->Continue()) {
+        // Retired because of throughput
+        retired = true;
+        break;
+      }
       if(client && client->GetClosed()) client = point.acquire_client(client_url);
       if (!client) {
         transfer_failure = true;
@@ -1093,6 +1309,7 @@ using namespace Arc;
       uint64_t transfer_offset = 0;
       uint64_t chunk_length = 1024*1024;
       if(transfer_size > chunk_length) chunk_length = transfer_size;
+      if(point.streams) chunk_length = point.range_chunk;
       if (!(point.chunks->Get(transfer_offset, chunk_length))) {
         // No more chunks to transfer - quit this thread.
         point.buffer->is_read(transfer_handle, 0, 0);
@@ -1184,6 +1401,46 @@ using namespace Arc;
       // pick up useful information from HTTP header
       point.modified = transfer_info.lastModified;
       retries = 0;
+      if(point.streams && (instream->Pos() == transfer_offset) &&
+         (instream->Limit() == (transfer_offset + chunk_length))) {
+        // Server returned exactly requested range. Range stays claimed
+        // by this stream, hence data can be stored without serializing
+        // with other streams.
+        uint64_t pos = transfer_offset;
+        uint64_t end = transfer_offset + chunk_length;
+        bool buffer_failure = false;
+        while(pos < end) {
+          if (transfer_handle == -1) {
+            if (!point.buffer->for_read(transfer_handle, transfer_size, true)) {
+              buffer_failure = true;
+              break;
+            }
+          }
+          int l = transfer_size;
+          if (l > (end - pos)) l = end - pos;
+          if(!instream->Get((*point.buffer)[transfer_handle],l)) break;
+          point.buffer->is_read(transfer_handle, l, pos);
+          transfer_handle = -1;
+          pos += l;
+        }
+        if (transfer_handle != -1) point.buffer->is_read(transfer_handle, 0, 0);
+        if (inbuf) delete inbuf;
+        if (pos < end) {
+          // Let remaining part of range to be fetched again
+          point.chunks->Unclaim(pos, end - pos);
+          if (buffer_failure) break;
+          client = NULL;
+          if ((++retries) > 10) {
+            transfer_failure = true;
+            failure_code = DataStatus(DataStatus::ReadError, "Failed to read range of data");
+            break;
+          }
+          client = point.acquire_new_client(client_url);
+          continue;
+        }
+        if (point.streams->Transferred(chunk_length)) point.add_read_stream();
+        continue;
+      }
       // Exclude chunks after EOF. Normally that is not needed.
       // But Apache if asked about out of file range gets confused
       // and sends *whole* file instead of 416.
@@ -1225,6 +1482,7 @@ using namespace Arc;
     }
     point.transfer_lock.lock();
     --(point.transfers_tofinish);
+    if (point.streams && !retired) point.streams->Finished();
     if (transfer_failure) {
       point.failure_code = failure_code;
       point.buffer->error_read(true);
@@ -1468,6 +1726,181 @@ using namespace Arc;
     point.transfer_lock.unlock();
   }
 
+  void DataPointHTTP::read_ring_thread(void *arg) {
+    HTTPInfo_t& info = *((HTTPInfo_t*)arg);
+    DataPointHTTP& point = *(info.point);
+    DataRingBuffer& ring = *(point.ring);
+    URL client_url = point.url;
+    AutoPointer<ClientHTTP> client(point.acquire_client(client_url));
+    bool transfer_failure = false;
+    int retries = 0;
+    std::string path = point.CurrentLocation().FullPathURIEncoded();
+    DataStatus failure_code;
+    if (!client) transfer_failure = true;
+    if (client) for(;;) {  // for retries
+      HTTPClientInfo transfer_info;
+      PayloadRaw request;
+      PayloadStreamInterface *instream = NULL;
+      MCC_Status r = client->process(ClientHTTPAttributes("GET", path),
+                                     &request, &transfer_info,
+                                     &instream);
+      if (!r) {
+        if (instream) delete instream;
+        // Failed to transfer - retry with new connection
+        client = NULL;
+        if ((++retries) > 10) {
+          transfer_failure = true;
+          failure_code = DataStatus(DataStatus::ReadError, r.getExplanation());
+          break;
+        }
+        client = point.acquire_new_client(client_url);
+        if(client) continue;
+        transfer_failure = true;
+        break;
+      }
+      if((transfer_info.code == 301) || // permanent redirection
+         (transfer_info.code == 302) || // temporary redirection
+         (transfer_info.code == 303) || // POST to GET redirection
+         (transfer_info.code == 304)) { // redirection to cache
+        if (instream) delete instream;
+        point.release_client(client_url,client.Release());
+        client_url = transfer_info.location;
+        logger.msg(VERBOSE,"Redirecting to %s",transfer_info.location.str());
+        client = point.acquire_client(client_url);
+        if (client) {
+          path = client_url.FullPathURIEncoded();
+          continue;
+        }
+        transfer_failure = true;
+        break;
+      }
+      if ((transfer_info.code != 200) &&
+          (transfer_info.code != 206)) { // HTTP error - retry?
+        if (instream) delete instream;
+        if ((transfer_info.code == 500) ||
+            (transfer_info.code == 503) ||
+            (transfer_info.code == 504)) {
+          if ((++retries) <= 10) continue;
+        }
+        logger.msg(VERBOSE,"HTTP failure %u - %s",transfer_info.code,transfer_info.reason);
+        std::string reason = Arc::tostring(transfer_info.code) + " - " + transfer_info.reason;
+        failure_code = DataStatus(DataStatus::ReadError, point.http2errno(transfer_info.code), reason);
+        transfer_failure = true;
+        break;
+      }
+      if(!instream) {
+        transfer_failure = true;
+        break;
+      }
+      point.modified = transfer_info.lastModified;
+      // Pull from stream directly into ring slots. Every slot is filled
+      // completely before being passed on to keep number of hand-overs low.
+      bool eof = false;
+      while(!eof) {
+        struct iovec slot;
+        if (ring.for_read(&slot, 1, true) != 1) {
+          // No free slot - must be failure or close initiated externally
+          break;
+        }
+        uint64_t pos = instream->Pos();
+        unsigned int filled = 0;
+        while(filled < slot.iov_len) {
+          int l = slot.iov_len - filled;
+          if(!instream->Get(((char*)slot.iov_base) + filled, l)) {
+            //  Trying to find out if stream ended due to error
+            if((pos + filled) < instream->Size()) transfer_failure = true;
+            eof = true;
+            break;
+          }
+          filled += l;
+        }
+        ring.is_read(filled, pos);
+      }
+      delete instream;
+      break;
+    }
+    if (transfer_failure) {
+      point.failure_code = failure_code;
+      ring.error_read(true);
+    }
+    ring.eof_read(true);
+    point.release_client(client_url,client.Release());
+    delete &info;
+  }
+
+  void DataPointHTTP::write_ring_thread(void *arg) {
+    HTTPInfo_t& info = *((HTTPInfo_t*)arg);
+    DataPointHTTP& point = *(info.point);
+    DataRingBuffer& ring = *(point.ring);
+    URL client_url = point.url;
+    AutoPointer<ClientHTTP> client(point.acquire_client(client_url));
+    std::string path = client_url.FullPathURIEncoded();
+    bool transfer_failure = (!client);
+    // See write_single() for description of redirection handling
+    bool expect100 = true;
+    if (client) for (;;) {
+      std::multimap<std::string, std::string> attrs;
+      if(expect100) {
+        attrs.insert(std::pair<std::string, std::string>("EXPECT", "100-continue"));
+      }
+      StreamRing request(ring);
+      if (point.CheckSize()) request.Size(point.GetSize());
+      PayloadRawInterface *response = NULL;
+      HTTPClientInfo transfer_info;
+      MCC_Status r = client->process(ClientHTTPAttributes("PUT", path, attrs),
+                                     &request, &transfer_info, &response);
+      if (response) { delete response; response = NULL; }
+      if (!r) {
+        point.failure_code = DataStatus(DataStatus::WriteError, r.getExplanation());
+        client = NULL;
+        transfer_failure = true;
+        break;
+      }
+      if (transfer_info.code == 301 || // Moved permanently
+          transfer_info.code == 302 || // Found (temp redirection)
+          transfer_info.code == 307) { // Temporary redirection
+        point.release_client(client_url,client.Release());
+        client_url = transfer_info.location;
+        logger.msg(VERBOSE,"Redirecting to %s",transfer_info.location.str());
+        client = point.acquire_client(client_url);
+        if (client) {
+          expect100 = false;
+          path = client_url.FullPathURIEncoded();
+          continue;
+        }
+        point.failure_code = DataStatus(DataStatus::WriteError, "Failed to connect to redirected URL "+client_url.fullstr());
+        transfer_failure = true;
+        break;
+      }
+      if (transfer_info.code == 417) { // Expectation not supported
+        expect100 = false;
+        continue;
+      }
+      if ((transfer_info.code != 201) &&
+          (transfer_info.code != 200) &&
+          (transfer_info.code != 204)) {  // HTTP error
+        point.failure_code = DataStatus(DataStatus::WriteError, point.http2errno(transfer_info.code), transfer_info.reason);
+        transfer_failure = true;
+        break;
+      }
+      break;
+    }
+    if (!transfer_failure) {
+      // Request may be finished before all data was taken from ring
+      struct iovec slot;
+      unsigned long long int offset;
+      if (ring.for_write(&slot, 1, offset, true) != 0) {
+        ring.is_written(0);
+        point.failure_code = DataStatus(DataStatus::WriteError, "Not all data was sent");
+        transfer_failure = true;
+      }
+    }
+    if (transfer_failure) ring.error_write(true);
+    ring.eof_write(true);
+    point.release_client(client_url,client.Release());
+    delete &info;
+  }
+
   bool DataPointHTTP::SetURL(const URL& url) {
     if(url.Protocol() != this->url.Protocol()) return false;
     if(url.Host() != this->url.Host()) return false;
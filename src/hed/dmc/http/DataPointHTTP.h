@@ -12,6 +12,7 @@ namespace ArcDMCHTTP {
 using namespace Arc;
 
   class ChunkControl;
+  class StreamControl;
 
   /**
    * This class allows access through HTTP to remote resources. HTTP over SSL
@@ -35,15 +36,22 @@ using namespace Arc;
     virtual DataStatus List(std::list<FileInfo>& files, DataPointInfoType verb = INFO_TYPE_ALL);
     virtual DataStatus StartReading(DataBuffer& buffer);
     virtual DataStatus StartWriting(DataBuffer& buffer, DataCallback *space_cb = NULL);
+    virtual DataStatus StartReadingVectored(DataRingBuffer& buffer);
+    virtual DataStatus StartWritingVectored(DataRingBuffer& buffer, DataCallback *space_cb = NULL);
     virtual DataStatus StopReading();
     virtual DataStatus StopWriting();
     virtual bool RequiresCredentials() const { return url.Protocol() != "http"; };
     virtual bool WriteOutOfOrder() const { return partial_write_allowed; };
+    virtual bool SupportsVectoredIO() const { return true; };
   private:
     static void read_thread(void *arg);
+    /// Start one more ranged reading stream
+    void add_read_stream();
     static bool read_single(void *arg);
     static void write_thread(void *arg);
     static bool write_single(void *arg);
+    static void read_ring_thread(void *arg);
+    static void write_ring_thread(void *arg);
     DataStatus do_stat_http(URL& curl, FileInfo& file);
     DataStatus do_stat_webdav(URL& curl, FileInfo& file);
     DataStatus do_list_webdav(URL& rurl, std::list<FileInfo>& files, DataPointInfoType verb);
@@ -56,6 +64,14 @@ using namespace Arc;
     bool reading;
     bool writing;
     ChunkControl *chunks;
+    /// Set instead of buffer while vectored transfer is active
+    DataRingBuffer *ring;
+    /// Set while reading in ranged multi-stream mode
+    StreamControl *streams;
+    /// Maximal number of ranged streams requested by httpstreams option
+    int max_streams;
+    /// Size of range fetched by single request in multi-stream mode
+    uint64_t range_chunk;
     std::multimap<std::string,ClientHTTP*> clients;
     SimpleCounter transfers_started;
     int transfers_tofinish;
@@ -0,0 +1,93 @@
+// -*- indent-tabs-mode: nil -*-
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <cstring>
+
+#include "StreamRing.h"
+
+namespace ArcDMCHTTP {
+
+using namespace Arc;
+
+  StreamRing::StreamRing(DataRingBuffer& buffer):buffer_(buffer) {
+    slot_.iov_base = NULL;
+    slot_.iov_len = 0;
+    slot_taken_ = false;
+    slot_offset_ = 0;
+    current_offset_ = 0;
+    current_size_ = 0;
+  }
+
+  StreamRing::~StreamRing(void) {
+    if(slot_taken_) {
+      buffer_.is_written(0); slot_taken_ = false;
+    };
+  }
+
+  bool StreamRing::Get(char* buf,int& size) {
+    if(size < 0) return false;
+    if(!slot_taken_) {
+      // slot need to be obtained
+      if(buffer_.for_write(&slot_,1,slot_offset_,true) != 1) return false;
+      slot_taken_ = true;
+      if(slot_offset_ != current_offset_) {
+        buffer_.is_written(0); slot_taken_ = false;
+        buffer_.error_write(true);
+        return false;
+      };
+    };
+    // slot is already obtained
+    unsigned long long int slotend = slot_offset_ + slot_.iov_len;
+    unsigned long long int slotsize = slotend - current_offset_;
+    if(slotend > current_size_) current_size_ = slotend;
+    if(slotsize > (unsigned int)size) slotsize = size;
+    ::memcpy(buf,((char*)slot_.iov_base)+(current_offset_-slot_offset_),slotsize);
+    size = slotsize; current_offset_ += slotsize;
+    if(current_offset_ >= slotend) {
+      buffer_.is_written(1); slot_taken_ = false;
+    }
+    return true;
+  }
+
+  bool StreamRing::Put(const char* buf,Size_t size) {
+    // This implementation is unidirectonal
+    return false;
+  }
+
+  StreamRing::operator bool(void) {
+    return (bool)buffer_;
+  }
+
+  bool StreamRing::operator!(void) {
+    return !(bool)buffer_;
+  }
+
+  int StreamRing::Timeout(void) const {
+    return -1;
+  }
+
+  void StreamRing::Timeout(int /*to*/) {
+  }
+
+  PayloadStreamInterface::Size_t StreamRing::Pos(void) const {
+    return (PayloadStreamInterface::Size_t)current_offset_;
+  }
+
+  PayloadStreamInterface::Size_t StreamRing::Size(void) const {
+    return (PayloadStreamInterface::Size_t)current_size_;
+  }
+
+  PayloadStreamInterface::Size_t StreamRing::Limit(void) const {
+    return (PayloadStreamInterface::Size_t)current_size_;
+  }
+
+  void StreamRing::Size(PayloadStreamInterface::Size_t size) {
+    if(size < 0) return;
+    if((unsigned long long int)size > current_size_) current_size_ = size;
+  }
+
+} // namespace ArcDMCHTTP
+
@@ -0,0 +1,39 @@
+// -*- indent-tabs-mode: nil -*-
+
+#ifndef __ARCDMCHTTP_STREAMRING_H__
+#define __ARCDMCHTTP_STREAMRING_H__
+
+#include <arc/message/PayloadStream.h>
+#include <arc/data/DataRingBuffer.h>
+
+namespace ArcDMCHTTP {
+
+using namespace Arc;
+
+/// Stream which takes data sequentially from DataRingBuffer.
+class StreamRing: public PayloadStreamInterface {
+ public:
+  StreamRing(DataRingBuffer& buffer);
+  virtual ~StreamRing(void);
+  virtual bool Get(char* buf,int& size);
+  virtual bool Put(const char* buf,Size_t size);
+  virtual operator bool(void);
+  virtual bool operator!(void);
+  virtual int Timeout(void) const;
+  virtual void Timeout(int to);
+  virtual Size_t Pos(void) const;
+  virtual Size_t Size(void) const;
+  virtual Size_t Limit(void) const;
+  void Size(Size_t size);
+ private:
+  DataRingBuffer& buffer_;
+  struct iovec slot_;
+  bool slot_taken_;
+  unsigned long long int slot_offset_;
+  unsigned long long int current_offset_;
+  unsigned long long int current_size_;
+};
+
+} // namespace ArcDMCHTTP
+
+#endif // __ARCDMCHTTP_STREAMRING_H__
@@ -0,0 +1,317 @@
+// -*- indent-tabs-mode: nil -*-
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include <arc/StringConv.h>
+#include <arc/Thread.h>
+#include <arc/URL.h>
+#include <arc/UserConfig.h>
+#include <arc/data/DataBuffer.h>
+#include <arc/data/DataHandle.h>
+
+// Minimal HTTP/1.1 server serving single object with support for
+// byte ranges and persistent connections. It counts requests and
+// concurrent connections so that tests can check how object was fetched.
+class TestServer {
+ public:
+  TestServer(const std::string& content, bool ranges);
+  ~TestServer();
+  int Port() const { return port; }
+  int RangeRequests();
+  int GetRequests();
+  int MaxConnections();
+ private:
+  static void accept_thread(void* arg);
+  static void connection_thread(void* arg);
+  void serve(int s);
+  bool read_request(int s, std::string& buf, std::string& head);
+  const std::string content;
+  const bool ranges;
+  int listen_s;
+  int port;
+  bool exiting;
+  Glib::Mutex lock;
+  int connections;
+  int max_connections;
+  int range_requests;
+  int get_requests;
+  Arc::SimpleCounter threads;
+};
+
+struct ConnectionArg {
+  TestServer* server;
+  int s;
+};
+
+TestServer::TestServer(const std::string& content, bool ranges)
+  : content(content), ranges(ranges), listen_s(-1), port(0), exiting(false),
+    connections(0), max_connections(0), range_requests(0), get_requests(0) {
+  listen_s = ::socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  if ((::bind(listen_s, (struct sockaddr*)&addr, sizeof(addr)) != 0) ||
+      (::listen(listen_s, 32) != 0)) {
+    ::close(listen_s); listen_s = -1;
+    return;
+  }
+  socklen_t addrlen = sizeof(addr);
+  ::getsockname(listen_s, (struct sockaddr*)&addr, &addrlen);
+  port = ntohs(addr.sin_port);
+  Arc::CreateThreadFunction(&accept_thread, this, &threads);
+}
+
+TestServer::~TestServer() {
+  exiting = true;
+  if (listen_s != -1) {
+    ::shutdown(listen_s, SHUT_RDWR);
+    ::close(listen_s);
+  }
+  threads.wait();
+}
+
+int TestServer::RangeRequests() {
+  Glib::Mutex::Lock l(lock);
+  return range_requests;
+}
+
+int TestServer::GetRequests() {
+  Glib::Mutex::Lock l(lock);
+  return get_requests;
+}
+
+int TestServer::MaxConnections() {
+  Glib::Mutex::Lock l(lock);
+  return max_connections;
+}
+
+void TestServer::accept_thread(void* arg) {
+  TestServer& server = *(TestServer*)arg;
+  while (!server.exiting) {
+    int s = ::accept(server.listen_s, NULL, NULL);
+    if (s == -1) break;
+    ConnectionArg* carg = new ConnectionArg;
+    carg->server = &server;
+    carg->s = s;
+    if (!Arc::CreateThreadFunction(&connection_thread, carg, &server.threads)) {
+      ::close(s);
+      delete carg;
+    }
+  }
+}
+
+void TestServer::connection_thread(void* arg) {
+  ConnectionArg* carg = (ConnectionArg*)arg;
+  carg->server->serve(carg->s);
+  ::close(carg->s);
+  delete carg;
+}
+
+bool TestServer::read_request(int s, std::string& buf, std::string& head) {
+  for (;;) {
+    std::string::size_type p = buf.find("\r\n\r\n");
+    if (p != std::string::npos) {
+      head = buf.substr(0, p + 2);
+      buf.erase(0, p + 4);
+      return true;
+    }
+    char tmp[4096];
+    ssize_t l = ::recv(s, tmp, sizeof(tmp), 0);
+    if (l <= 0) return false;
+    buf.append(tmp, l);
+  }
+}
+
+static std::string header_value(const std::string& head, const std::string& name) {
+  std::string lhead = Arc::lower(head);
+  std::string::size_type p = lhead.find("\r\n" + Arc::lower(name) + ":");
+  if (p == std::string::npos) return "";
+  p += name.length() + 3;
+  std::string::size_type e = head.find("\r\n", p);
+  return Arc::trim(head.substr(p, e - p));
+}
+
+void TestServer::serve(int s) {
+  {
+    Glib::Mutex::Lock l(lock);
+    if ((++connections) > max_connections) max_connections = connections;
+  }
+  std::string buf;
+  std::string head;
+  while (!exiting && read_request(s, buf, head)) {
+    std::string method = head.substr(0, head.find(' '));
+    // Discard request body
+    unsigned long long int body = 0;
+    Arc::stringto(header_value(head, "Content-Length"), body);
+    while (buf.length() < body) {
+      char tmp[4096];
+      ssize_t l = ::recv(s, tmp, sizeof(tmp), 0);
+      if (l <= 0) break;
+      buf.append(tmp, l);
+    }
+    buf.erase(0, body);
+    std::string response;
+    unsigned long long int start = 0;
+    unsigned long long int end = content.length();
+    if ((method != "GET") && (method != "HEAD")) {
+      response = "HTTP/1.1 405 Method Not Allowed\r\nContent-Length: 0\r\n\r\n";
+    } else {
+      std::string range = header_value(head, "Range");
+      bool partial = false;
+      if (ranges && (range.compare(0, 6, "bytes=") == 0)) {
+        std::string::size_type d = range.find('-');
+        unsigned long long int rstart = 0;
+        unsigned long long int rend = 0;
+        if (Arc::stringto(range.substr(6, d - 6), rstart)) {
+          if (!Arc::stringto(range.substr(d + 1), rend) || (rend >= content.length()))
+            rend = content.length() - 1;
+          if (rstart >= content.length()) {
+            response = "HTTP/1.1 416 Requested Range Not Satisfiable\r\nContent-Length: 0\r\n\r\n";
+          } else {
+            start = rstart; end = rend + 1;
+            partial = true;
+          }
+        }
+      }
+      if (response.empty()) {
+        if (partial) {
+          response = "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes " +
+                     Arc::tostring(start) + "-" + Arc::tostring(end - 1) + "/" +
+                     Arc::tostring(content.length()) + "\r\n";
+        } else {
+          response = "HTTP/1.1 200 OK\r\n";
+        }
+        response += "Content-Type: application/octet-stream\r\nContent-Length: " +
+                    Arc::tostring(end - start) + "\r\n\r\n";
+        if (method == "GET") response += content.substr(start, end - start);
+      }
+      if (method == "GET") {
+        Glib::Mutex::Lock l(lock);
+        ++get_requests;
+        if (partial) ++range_requests;
+      }
+    }
+    // Emulate some network latency
+    ::usleep(10000);
+    std::string::size_type sent = 0;
+    while (sent < response.length()) {
+      ssize_t l = ::send(s, response.c_str() + sent, response.length() - sent, MSG_NOSIGNAL);
+      if (l <= 0) break;
+      sent += l;
+    }
+    if (sent < response.length()) break;
+  }
+  Glib::Mutex::Lock l(lock);
+  --connections;
+}
+
+
+class HTTPRangeTest
+  : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(HTTPRangeTest);
+  CPPUNIT_TEST(TestSingleStream);
+  CPPUNIT_TEST(TestMultiStream);
+  CPPUNIT_TEST(TestMultiStreamNoRanges);
+  CPPUNIT_TEST(TestMultiStreamInOrder);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp();
+  void TestSingleStream();
+  void TestMultiStream();
+  void TestMultiStreamNoRanges();
+  void TestMultiStreamInOrder();
+
+private:
+  std::string content;
+  bool fetch(const std::string& url, bool out_of_order, std::string& result);
+};
+
+void HTTPRangeTest::setUp() {
+  // Few ranges of minimal size and a bit more
+  content.resize(9*1024*1024 + 12345);
+  for (std::string::size_type n = 0; n < content.length(); ++n) content[n] = (char)(n % 251);
+}
+
+bool HTTPRangeTest::fetch(const std::string& url, bool out_of_order, std::string& result) {
+  Arc::UserConfig usercfg(Arc::initializeCredentialsType(Arc::initializeCredentialsType::SkipCredentials));
+  Arc::DataHandle handle(Arc::URL(url), usercfg);
+  if (!handle) return false;
+  handle->ReadOutOfOrder(out_of_order);
+  Arc::DataBuffer buffer(65536, 8);
+  if (!handle->StartReading(buffer)) return false;
+  result.assign(content.length(), '\0');
+  unsigned long long int received = 0;
+  for (;;) {
+    int h;
+    unsigned int l;
+    unsigned long long int p;
+    if (!buffer.for_write(h, l, p, true)) break;
+    if ((p + l) > result.length()) result.resize(p + l);
+    std::memcpy(&result[p], buffer[h], l);
+    received += l;
+    buffer.is_written(h);
+  }
+  buffer.eof_write(true);
+  if (!handle->StopReading()) return false;
+  // Server ignoring ranges may cause same data to be delivered more than once
+  return (received >= content.length()) && !buffer.error();
+}
+
+void HTTPRangeTest::TestSingleStream() {
+  TestServer server(content, true);
+  CPPUNIT_ASSERT(server.Port() != 0);
+  std::string result;
+  CPPUNIT_ASSERT(fetch("http://127.0.0.1:" + Arc::tostring(server.Port()) + "/data", true, result));
+  CPPUNIT_ASSERT(result == content);
+  CPPUNIT_ASSERT_EQUAL(1, server.GetRequests());
+  CPPUNIT_ASSERT_EQUAL(0, server.RangeRequests());
+}
+
+void HTTPRangeTest::TestMultiStream() {
+  TestServer server(content, true);
+  CPPUNIT_ASSERT(server.Port() != 0);
+  std::string result;
+  CPPUNIT_ASSERT(fetch("http://127.0.0.1:" + Arc::tostring(server.Port()) + "/data?httpstreams=4", true, result));
+  CPPUNIT_ASSERT(result == content);
+  // Size is 9 ranges of 1MB and remainder
+  CPPUNIT_ASSERT(server.RangeRequests() >= 10);
+  CPPUNIT_ASSERT(server.MaxConnections() >= 2);
+}
+
+void HTTPRangeTest::TestMultiStreamNoRanges() {
+  // Server ignores Range header and always returns whole object
+  TestServer server(content, false);
+  CPPUNIT_ASSERT(server.Port() != 0);
+  std::string result;
+  CPPUNIT_ASSERT(fetch("http://127.0.0.1:" + Arc::tostring(server.Port()) + "/data?httpstreams=4", true, result));
+  CPPUNIT_ASSERT(result == content);
+  CPPUNIT_ASSERT_EQUAL(0, server.RangeRequests());
+}
+
+void HTTPRangeTest::TestMultiStreamInOrder() {
+  // Destination can't accept data out of order - single stream is used
+  TestServer server(content, true);
+  CPPUNIT_ASSERT(server.Port() != 0);
+  std::string result;
+  CPPUNIT_ASSERT(fetch("http://127.0.0.1:" + Arc::tostring(server.Port()) + "/data?httpstreams=4", false, result));
+  CPPUNIT_ASSERT(result == content);
+  CPPUNIT_ASSERT_EQUAL(0, server.RangeRequests());
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(HTTPRangeTest);
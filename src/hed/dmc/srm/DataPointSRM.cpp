@@ -551,8 +551,8 @@ namespace ArcDMCSRM {
           if (srm_request->status() == SRM_REQUEST_FINISHED_SUCCESS && additional_checks && buffer && !CheckCheckSum()) {
             const CheckSum * calc_sum = buffer->checksum_object();
             if (calc_sum && *calc_sum && buffer->checksum_valid()) {
-              char buf[100];
-              calc_sum->print(buf,100);
+              char buf[CheckSum::MaxPrintLength];
+              calc_sum->print(buf,sizeof(buf));
               std::string csum(buf);
               if (!csum.empty() && csum.find(':') != std::string::npos) {
                 // get checksum info for checksum verification
@@ -4,15 +4,24 @@
 #include <config.h>
 #endif
 
+#include <atomic>
+#include <cstdlib>
 #include <cctype>
 #include <fstream>
 
 #include <fcntl.h>
 #include <sys/types.h>
 
+#include <openssl/evp.h>
+
 #include <arc/StringConv.h>
 #include <arc/CheckSum.h>
 
+#if defined(__GNUC__) && defined(__x86_64__)
+#define CHECKSUM_X86_64 1
+#include <immintrin.h>
+#endif
+
 
 // ----------------------------------------------------------------------------
 // This is CRC(32bit) implementation as in 'cksum' utility
@@ -87,8 +96,256 @@ static uint32_t gtable[256] = {
   0xBCB4666D, 0xB8757BDA, 0xB5365D03, 0xB1F740B4
 };
 
+// Tables for processing 8 bytes at once (slicing-by-8). Table 0 is gtable
+// and table k gives CRC of byte followed by k zero bytes.
+
+struct crc_slice_tables {
+  uint32_t t[8][256];
+  crc_slice_tables(void) {
+    for (int i = 0; i < 256; ++i) t[0][i] = gtable[i];
+    for (int k = 1; k < 8; ++k)
+      for (int i = 0; i < 256; ++i)
+        t[k][i] = (t[k-1][i] << 8) ^ gtable[t[k-1][i] >> 24];
+  }
+};
+
+static const crc_slice_tables& crc_tables(void) {
+  static const crc_slice_tables tables;
+  return tables;
+}
+
+// All CRC functions below take and return state of non-augmented (direct)
+// algorithm which is equal to (state*x^(8*len) + data*x^32) mod g.
+
+static uint32_t crc_bytewise(uint32_t r, const unsigned char *p, unsigned long long int len) {
+  for (; len; --len, ++p)
+    r = (r << 8) ^ gtable[(r >> 24) ^ *p];
+  return r;
+}
+
+static uint32_t crc_slice8(uint32_t r, const unsigned char *p, unsigned long long int len) {
+  const uint32_t (*t)[256] = crc_tables().t;
+  for (; len >= 8; len -= 8, p += 8) {
+    r ^= ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+         ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+    r = t[7][r >> 24] ^ t[6][(r >> 16) & 0xFF] ^
+        t[5][(r >> 8) & 0xFF] ^ t[4][r & 0xFF] ^
+        t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+  }
+  return crc_bytewise(r, p, len);
+}
+
+#ifdef CHECKSUM_X86_64
+
+// x^n mod g
+static uint64_t crc_xpow(unsigned int n) {
+  uint32_t r = 0x80000000; // x^31
+  for (n -= 31; n; --n)
+    r = (r << 1) ^ ((r & 0x80000000) ? 0x04C11DB7 : 0);
+  return r;
+}
+
+struct crc_fold_constants {
+  __m128i k128; // folds 128 bit block by 128 bits
+  __m128i k512; // folds 128 bit block by 512 bits
+  crc_fold_constants(void) {
+    // High half of block is multiplied by x^(n+64), low half by x^n
+    k128 = _mm_set_epi64x(crc_xpow(128+64), crc_xpow(128));
+    k512 = _mm_set_epi64x(crc_xpow(512+64), crc_xpow(512));
+  }
+};
+
+__attribute__((target("pclmul,ssse3")))
+static inline __m128i crc_fold(__m128i x, __m128i k, __m128i next) {
+  __m128i h = _mm_clmulepi64_si128(x, k, 0x11);
+  __m128i l = _mm_clmulepi64_si128(x, k, 0x00);
+  return _mm_xor_si128(_mm_xor_si128(h, l), next);
+}
+
+// Folds data into single 128 bit remainder using carry-less multiplication
+// in 4 independent streams, then finishes using tables. Data is loaded with
+// bytes reversed so that first byte holds highest coefficients.
+__attribute__((target("pclmul,ssse3")))
+static uint32_t crc_pclmul(uint32_t r, const unsigned char *p, unsigned long long int len) {
+  if (len < 64) return crc_slice8(r, p, len);
+  static const crc_fold_constants k;
+  const __m128i swap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  __m128i x0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p)), swap);
+  __m128i x1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + 16)), swap);
+  __m128i x2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + 32)), swap);
+  __m128i x3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + 48)), swap);
+  x0 = _mm_xor_si128(x0, _mm_set_epi32(r, 0, 0, 0));
+  p += 64; len -= 64;
+  for (; len >= 64; len -= 64, p += 64) {
+    x0 = crc_fold(x0, k.k512, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p)), swap));
+    x1 = crc_fold(x1, k.k512, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + 16)), swap));
+    x2 = crc_fold(x2, k.k512, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + 32)), swap));
+    x3 = crc_fold(x3, k.k512, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p + 48)), swap));
+  }
+  x0 = crc_fold(x0, k.k128, x1);
+  x0 = crc_fold(x0, k.k128, x2);
+  x0 = crc_fold(x0, k.k128, x3);
+  for (; len >= 16; len -= 16, p += 16)
+    x0 = crc_fold(x0, k.k128, _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(p)), swap));
+  unsigned char rest[16];
+  _mm_storeu_si128((__m128i*)rest, _mm_shuffle_epi8(x0, swap));
+  r = crc_slice8(0, rest, 16);
+  return crc_slice8(r, p, len);
+}
+
+#endif // CHECKSUM_X86_64
+
+// Adler-32 is computed by zlib unless vector instructions are available.
+// Vectorized code processes blocks of 32 or 64 bytes. Per block s1 grows by
+// sum of bytes and s2 by block_size*s1 plus bytes weighted by distance from
+// block end. Sums are reduced modulo 65521 often enough to fit 32 bits.
+
+#define ADLER_BASE 65521U
+#define ADLER_NMAX 5552U
+
+static uLong adler_zlib(uLong adler, const unsigned char *p, unsigned long long int len) {
+  // zlib takes length as unsigned int
+  for (; len > 0x40000000ULL; len -= 0x40000000ULL, p += 0x40000000ULL)
+    adler = adler32(adler, p, 0x40000000U);
+  return adler32(adler, p, len);
+}
+
+#ifdef CHECKSUM_X86_64
+
+__attribute__((target("ssse3")))
+static inline uint32_t adler_hsum(__m128i v) {
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(v);
+}
+
+__attribute__((target("ssse3")))
+static uLong adler_ssse3(uLong adler, const unsigned char *p, unsigned long long int len) {
+  uint32_t s1 = adler & 0xFFFF;
+  uint32_t s2 = adler >> 16;
+  const __m128i tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17);
+  const __m128i tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi16(1);
+  unsigned long long int blocks = len / 32;
+  len -= blocks * 32;
+  while (blocks) {
+    unsigned int n = ADLER_NMAX / 32;
+    if (n > blocks) n = blocks;
+    blocks -= n;
+    __m128i v_ps = _mm_set_epi32(0, 0, 0, s1 * n);
+    __m128i v_s2 = _mm_set_epi32(0, 0, 0, s2);
+    __m128i v_s1 = zero;
+    do {
+      __m128i b1 = _mm_loadu_si128((const __m128i*)(p));
+      __m128i b2 = _mm_loadu_si128((const __m128i*)(p + 16));
+      v_ps = _mm_add_epi32(v_ps, v_s1);
+      v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(b1, zero));
+      v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(b2, zero));
+      v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_maddubs_epi16(b1, tap1), ones));
+      v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_maddubs_epi16(b2, tap2), ones));
+      p += 32;
+    } while (--n);
+    v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+    s1 = (s1 + adler_hsum(v_s1)) % ADLER_BASE;
+    s2 = adler_hsum(v_s2) % ADLER_BASE;
+  }
+  return adler_zlib((s2 << 16) | s1, p, len);
+}
+
+__attribute__((target("avx2")))
+static uLong adler_avx2(uLong adler, const unsigned char *p, unsigned long long int len) {
+  uint32_t s1 = adler & 0xFFFF;
+  uint32_t s2 = adler >> 16;
+  const __m256i tap1 = _mm256_setr_epi8(64, 63, 62, 61, 60, 59, 58, 57, 56, 55, 54, 53, 52, 51, 50, 49,
+                                        48, 47, 46, 45, 44, 43, 42, 41, 40, 39, 38, 37, 36, 35, 34, 33);
+  const __m256i tap2 = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+                                        16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i ones = _mm256_set1_epi16(1);
+  unsigned long long int blocks = len / 64;
+  len -= blocks * 64;
+  while (blocks) {
+    unsigned int n = ADLER_NMAX / 64;
+    if (n > blocks) n = blocks;
+    blocks -= n;
+    __m256i v_ps = _mm256_setr_epi32(s1 * n, 0, 0, 0, 0, 0, 0, 0);
+    __m256i v_s2 = _mm256_setr_epi32(s2, 0, 0, 0, 0, 0, 0, 0);
+    __m256i v_s1 = zero;
+    do {
+      __m256i b1 = _mm256_loadu_si256((const __m256i*)(p));
+      __m256i b2 = _mm256_loadu_si256((const __m256i*)(p + 32));
+      v_ps = _mm256_add_epi32(v_ps, v_s1);
+      v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(b1, zero));
+      v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(b2, zero));
+      v_s2 = _mm256_add_epi32(v_s2, _mm256_madd_epi16(_mm256_maddubs_epi16(b1, tap1), ones));
+      v_s2 = _mm256_add_epi32(v_s2, _mm256_madd_epi16(_mm256_maddubs_epi16(b2, tap2), ones));
+      p += 64;
+    } while (--n);
+    v_s2 = _mm256_add_epi32(v_s2, _mm256_slli_epi32(v_ps, 6));
+    __m128i h1 = _mm_add_epi32(_mm256_castsi256_si128(v_s1), _mm256_extracti128_si256(v_s1, 1));
+    __m128i h2 = _mm_add_epi32(_mm256_castsi256_si128(v_s2), _mm256_extracti128_si256(v_s2, 1));
+    s1 = (s1 + adler_hsum(h1)) % ADLER_BASE;
+    s2 = adler_hsum(h2) % ADLER_BASE;
+  }
+  return adler_zlib((s2 << 16) | s1, p, len);
+}
+
+#endif // CHECKSUM_X86_64
+
+#if (OPENSSL_VERSION_NUMBER < 0x10100000L)
+
+static EVP_MD_CTX* EVP_MD_CTX_new(void) {
+  EVP_MD_CTX* ctx = (EVP_MD_CTX*)std::malloc(sizeof(EVP_MD_CTX));
+  if(ctx) {
+    EVP_MD_CTX_init(ctx);
+  }
+  return ctx;
+}
+
+static void EVP_MD_CTX_free(EVP_MD_CTX* ctx) {
+  if(ctx) {
+    EVP_MD_CTX_cleanup(ctx);
+    std::free(ctx);
+  }
+}
+#endif
+
 namespace Arc {
 
+  // Read by every checksum object when it starts, hence no lock.
+  static std::atomic<int> acceleration(-1);
+
+  static CheckSumAcceleration max_acceleration(void) {
+#ifdef CHECKSUM_X86_64
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3")) {
+      if (__builtin_cpu_supports("avx2")) return CheckSumAVX2;
+      return CheckSumSSE;
+    }
+#endif
+    return CheckSumPortable;
+  }
+
+  CheckSumAcceleration GetCheckSumAcceleration(void) {
+    int level = acceleration.load(std::memory_order_relaxed);
+    if (level < 0) {
+      // Detection gives same result in every thread
+      level = max_acceleration();
+      int unset = -1;
+      if (!acceleration.compare_exchange_strong(unset, level, std::memory_order_relaxed))
+        level = unset;
+    }
+    return (CheckSumAcceleration)level;
+  }
+
+  CheckSumAcceleration SetCheckSumAcceleration(CheckSumAcceleration level) {
+    CheckSumAcceleration max = max_acceleration();
+    if (level > max) level = max;
+    acceleration.store(level, std::memory_order_relaxed);
+    return level;
+  }
+
   CRC32Sum::CRC32Sum(void) {
     start();
   }
@@ -97,12 +354,24 @@ namespace Arc {
     r = 0;
     count = 0;
     computed = false;
+    accel = GetCheckSumAcceleration();
   }
 
   void CRC32Sum::add(void *buf, unsigned long long int len) {
-    for (unsigned long long int i = 0; i < len; i++) {
-      unsigned char c = (r >> 24);
-      r = ((r << 8) | ((unsigned char*)buf)[i]) ^ gtable[c];
+    const unsigned char *p = (const unsigned char*)buf;
+    switch (accel) {
+      case CheckSumBasic:
+        r = crc_bytewise(r, p, len);
+        break;
+#ifdef CHECKSUM_X86_64
+      case CheckSumSSE:
+      case CheckSumAVX2:
+        r = crc_pclmul(r, p, len);
+        break;
+#endif
+      default:
+        r = crc_slice8(r, p, len);
+        break;
     }
     count += len;
   }
@@ -113,11 +382,9 @@ namespace Arc {
     unsigned long long l = count;
     for (; l;) {
       unsigned char c = (l & 0xFF);
-      ((CheckSum*)this)->add(&c, 1);
+      r = crc_bytewise(r, &c, 1);
       l >>= 8;
     }
-    uint32_t u = 0;
-    ((CheckSum*)this)->add(&u, 4);
     r = ((~r) & 0xFFFFFFFF);
     computed = true;
   }
@@ -219,11 +486,15 @@ namespace Arc {
   };
 
 
-  MD5Sum::MD5Sum(void) {
+  MD5Sum::MD5Sum(void) : ctx(EVP_MD_CTX_new()), evp(false) {
     // for(u_int i = 1;i<=64;i++) T[i-1]=(uint32_t)(4294967296LL*fabs(sin(i)));
     start();
   }
 
+  MD5Sum::~MD5Sum(void) {
+    EVP_MD_CTX_free(ctx);
+  }
+
   void MD5Sum::start(void) {
     A = A_INIT;
     B = B_INIT;
@@ -233,9 +504,17 @@ namespace Arc {
     Xlen = 0;
     memset(X,0,sizeof(X));
     computed = false;
+    // MD5 may be unavailable in OpenSSL, e.g. in FIPS mode
+    evp = ctx && (GetCheckSumAcceleration() != CheckSumBasic) &&
+          (EVP_DigestInit_ex(ctx, EVP_md5(), NULL) == 1);
   }
 
   void MD5Sum::add(void *buf, unsigned long long int len) {
+    if (evp) {
+      EVP_DigestUpdate(ctx, buf, len);
+      count += len;
+      return;
+    }
     u_char *buf_ = (u_char*)buf;
     for (; len;) {
       for(;Xlen < 64;) { // 16 words = 64 bytes
@@ -351,6 +630,18 @@ namespace Arc {
 
   void MD5Sum::end(void) {
     if (computed) return;
+    if (evp) {
+      unsigned char md[EVP_MAX_MD_SIZE];
+      unsigned int md_len = 0;
+      if (EVP_DigestFinal_ex(ctx, md, &md_len) != 1 || md_len != 16) return;
+      A = (((uint32_t)md[0])<<0) | (((uint32_t)md[1])<<8) | (((uint32_t)md[2])<<16) | (((uint32_t)md[3])<<24);
+      B = (((uint32_t)md[4])<<0) | (((uint32_t)md[5])<<8) | (((uint32_t)md[6])<<16) | (((uint32_t)md[7])<<24);
+      C = (((uint32_t)md[8])<<0) | (((uint32_t)md[9])<<8) | (((uint32_t)md[10])<<16) | (((uint32_t)md[11])<<24);
+      D = (((uint32_t)md[12])<<0) | (((uint32_t)md[13])<<8) | (((uint32_t)md[14])<<16) | (((uint32_t)md[15])<<24);
+      evp = false;
+      computed = true;
+      return;
+    }
     // pad
     uint64_t l = 8 * count; // number of bits
     u_char c = 0x80;
@@ -402,50 +693,221 @@ namespace Arc {
     return;
   }
 
+  // --------------------------------------------------------------------------
+  // Adler-32 with vectorized implementations
+  // --------------------------------------------------------------------------
+
+  void Adler32Sum::add(void* buf, unsigned long long int len) {
+    const unsigned char *p = (const unsigned char*)buf;
+    switch (accel) {
+#ifdef CHECKSUM_X86_64
+      case CheckSumSSE:
+        adler = adler_ssse3(adler, p, len);
+        break;
+      case CheckSumAVX2:
+        adler = adler_avx2(adler, p, len);
+        break;
+#endif
+      default:
+        adler = adler_zlib(adler, p, len);
+        break;
+    }
+  }
+
+  // --------------------------------------------------------------------------
+  // SHA family is provided by OpenSSL
+  // --------------------------------------------------------------------------
+
+  SHASum::SHASum(unsigned int bits)
+    : ctx(EVP_MD_CTX_new()),
+      md(NULL),
+      bits(bits),
+      digest_len(0),
+      computed(false) {
+    if ((bits == 1) || (bits == 160)) {
+      this->bits = 1;
+      md = EVP_sha1();
+    } else if (bits == 256) {
+      md = EVP_sha256();
+    } else if (bits == 512) {
+      md = EVP_sha512();
+    }
+    start();
+  }
+
+  SHASum::~SHASum(void) {
+    EVP_MD_CTX_free(ctx);
+  }
+
+  void SHASum::start(void) {
+    computed = false;
+    digest_len = 0;
+    if (ctx && md) EVP_DigestInit_ex(ctx, md, NULL);
+  }
+
+  void SHASum::add(void *buf, unsigned long long int len) {
+    if (ctx && md) EVP_DigestUpdate(ctx, buf, len);
+  }
+
+  void SHASum::end(void) {
+    if (computed) return;
+    if (!ctx || !md) return;
+    unsigned char d[EVP_MAX_MD_SIZE];
+    unsigned int l = 0;
+    if (EVP_DigestFinal_ex(ctx, d, &l) != 1) return;
+    if (l > sizeof(digest)) return;
+    memcpy(digest, d, l);
+    digest_len = l;
+    computed = true;
+  }
+
+  int SHASum::print(char *buf, int len) const {
+    if (!computed) {
+      if (len > 0) buf[0] = 0;
+      return 0;
+    }
+    int l = snprintf(buf, len, "sha%u:", bits);
+    for (unsigned int n = 0; n < digest_len; ++n) {
+      if (l >= len) break;
+      l += snprintf(buf + l, len - l, "%02x", (unsigned int)digest[n]);
+    }
+    return l;
+  }
+
+  void SHASum::scan(const char *buf) {
+    computed = false;
+    digest_len = 0;
+    std::string prefix = "sha" + tostring(bits) + ":";
+    if (strncasecmp(prefix.c_str(), buf, prefix.length()) != 0) return;
+    buf += prefix.length();
+    unsigned int l = strlen(buf);
+    unsigned int expected = (md ? EVP_MD_size(md) : 0);
+    if ((expected == 0) || (l != expected * 2)) return;
+    for (unsigned int n = 0; n < expected; ++n) {
+      unsigned int v;
+      if (!isxdigit(buf[n*2]) || !isxdigit(buf[n*2+1])) return;
+      if (sscanf(buf + n*2, "%02x", &v) != 1) return;
+      digest[n] = v;
+    }
+    digest_len = expected;
+    computed = true;
+  }
+
   // --------------------------------------------------------------------------
   // This is a wrapper for any supported checksum
   // --------------------------------------------------------------------------
 
+  CheckSum* CheckSumAny::create(type tp) {
+    switch (tp) {
+      case cksum: return new CRC32Sum;
+      case md5: return new MD5Sum;
+      case adler32: return new Adler32Sum;
+      case sha1: return new SHASum(160);
+      case sha256: return new SHASum(256);
+      case sha512: return new SHASum(512);
+      default: break;
+    }
+    return NULL;
+  }
+
+  CheckSumAny::type CheckSumAny::name_type(const char *name) {
+    if (strncasecmp("cksum", name, 5) == 0) return cksum;
+    if (strncasecmp("md5", name, 3) == 0) return md5;
+    if (strncasecmp("adler32", name, 7) == 0) return adler32;
+    if (strncasecmp("sha1", name, 4) == 0) return sha1;
+    if (strncasecmp("sha256", name, 6) == 0) return sha256;
+    if (strncasecmp("sha512", name, 6) == 0) return sha512;
+    return none;
+  }
+
   CheckSumAny::CheckSumAny(const char *type)
     : cs(NULL),
       tp(CheckSumAny::none) {
     if (!type)
       return;
-    if (strncasecmp("cksum", type, 5) == 0) {
-      cs = new CRC32Sum;
-      tp = cksum;
-      return;
-    }
-    if (strncasecmp("md5", type, 3) == 0) {
-      cs = new MD5Sum;
-      tp = md5;
-      return;
+    cs = create(name_type(type));
+    if (cs)
+      tp = name_type(type);
+  }
+
+  CheckSumAny::CheckSumAny(type type)
+    : cs(create(type)),
+      tp(CheckSumAny::none) {
+    if (cs)
+      tp = type;
+  }
+
+  void CheckSumAny::clear_extra(void) {
+    for (std::list<std::pair<type, CheckSum*> >::iterator e = extra.begin();
+         e != extra.end(); ++e) {
+      delete e->second;
     }
-    if(strncasecmp("adler32",type,7) == 0) {
-      cs=new Adler32Sum;
-      tp=adler32;
-      return;
+    extra.clear();
+  }
+
+  void CheckSumAny::start(void) {
+    if (cs)
+      cs->start();
+    for (std::list<std::pair<type, CheckSum*> >::iterator e = extra.begin();
+         e != extra.end(); ++e) {
+      e->second->start();
     }
   }
 
-  CheckSumAny::CheckSumAny(type type) {
-    if (type == cksum) {
-      cs = new CRC32Sum;
-      tp = type;
+  void CheckSumAny::add(void *buf, unsigned long long int len) {
+    if (!cs)
       return;
-    }
-    if (type == md5) {
-      cs = new MD5Sum;
-      tp = type;
+    if (extra.empty()) {
+      cs->add(buf, len);
       return;
     }
-    if (type == adler32) {
-      cs = new Adler32Sum;
-      tp = type;
-      return;
+    // Feed all checksums with pieces small enough to stay in CPU cache
+    // so that data is fetched from memory only once.
+    const unsigned long long int piece = 65536;
+    for (unsigned long long int pos = 0; pos < len; pos += piece) {
+      unsigned long long int l = len - pos;
+      if (l > piece) l = piece;
+      void *p = ((char*)buf) + pos;
+      cs->add(p, l);
+      for (std::list<std::pair<type, CheckSum*> >::iterator e = extra.begin();
+           e != extra.end(); ++e) {
+        e->second->add(p, l);
+      }
+    }
+  }
+
+  void CheckSumAny::end(void) {
+    if (cs)
+      cs->end();
+    for (std::list<std::pair<type, CheckSum*> >::iterator e = extra.begin();
+         e != extra.end(); ++e) {
+      e->second->end();
     }
   }
 
+  bool CheckSumAny::AddType(type tp) {
+    if (!cs)
+      return false;
+    if (Get(tp))
+      return true;
+    CheckSum *c = create(tp);
+    if (!c)
+      return false;
+    extra.push_back(std::pair<type, CheckSum*>(tp, c));
+    return true;
+  }
+
+  const CheckSum* CheckSumAny::Get(type tp) const {
+    if (cs && (tp == this->tp))
+      return cs;
+    for (std::list<std::pair<type, CheckSum*> >::const_iterator e = extra.begin();
+         e != extra.end(); ++e) {
+      if (e->first == tp)
+        return e->second;
+    }
+    return NULL;
+  }
+
   CheckSumAny::type CheckSumAny::Type(const char *crc) {
     if (!crc)
       return none;
@@ -467,33 +929,28 @@ namespace Arc {
       return md5;
     if (((p - crc) == 7) && (strncasecmp(crc, "adler32", 7) == 0))
       return adler32;
+    if (((p - crc) == 4) && (strncasecmp(crc, "sha1", 4) == 0))
+      return sha1;
+    if (((p - crc) == 6) && (strncasecmp(crc, "sha256", 6) == 0))
+      return sha256;
+    if (((p - crc) == 6) && (strncasecmp(crc, "sha512", 6) == 0))
+      return sha512;
     if (((p - crc) == 9) && (strncasecmp(crc, "undefined", 9) == 0))
       return undefined;
     return unknown;
   }
 
   void CheckSumAny::operator=(const char *type) {
+    clear_extra();
     if (cs)
       delete cs;
     cs = NULL;
     tp = none;
     if (!type)
       return;
-    if (strncasecmp("cksum", type, 5) == 0) {
-      cs = new CRC32Sum;
-      tp = cksum;
-      return;
-    }
-    if (strncasecmp("md5", type, 3) == 0) {
-      cs = new MD5Sum;
-      tp = md5;
-      return;
-    }
-    if (strncasecmp("adler32", type, 7) == 0) {
-      cs = new Adler32Sum;
-      tp = adler32;
-      return;
-    }
+    cs = create(name_type(type));
+    if (cs)
+      tp = name_type(type);
   }
 
   bool CheckSumAny::operator==(const char *s) {
@@ -552,19 +1009,25 @@ namespace Arc {
 
     CheckSumAny csa(tp);
 
-    char buffer[1024];
+    const ssize_t buffer_size = 1048576;
+    char *buffer = new char[buffer_size];
     ssize_t l;
     for(;;) {
-      l = read(h, buffer, 1024);
-      if (l == -1) return "";
+      l = read(h, buffer, buffer_size);
+      if (l == -1) {
+        delete[] buffer;
+        close(h);
+        return "";
+      }
       if (l == 0) break;
       csa.add(buffer, l);
     }
+    delete[] buffer;
     close(h);
     csa.end();
 
-    char checksum[100];
-    csa.print(checksum, 100);
+    char checksum[MaxPrintLength];
+    csa.print(checksum, sizeof(checksum));
     std::string sChecksum(checksum);
     std::string::size_type pos = sChecksum.find(':');
     if (pos == std::string::npos) {
@@ -5,14 +5,50 @@
 
 #include <cstring>
 #include <cstdio>
+#include <list>
 #include <string>
 
 #include <inttypes.h>
 #include <sys/types.h>
 #include <zlib.h>
 
+struct evp_md_ctx_st;
+struct evp_md_st;
+
 namespace Arc {
 
+  /// Level of CPU specific optimization used for checksum computation.
+  /**
+   * All levels produce same results. The level mostly affects speed and is
+   * exposed for testing and benchmarking.
+   * @ingroup common
+   * \since Added in 6.9.0.
+   **/
+  typedef enum {
+    CheckSumBasic,     ///< Byte oriented CRC, zlib Adler-32, internal MD5
+    CheckSumPortable,  ///< Slicing-by-8 CRC, zlib Adler-32, OpenSSL digests
+    CheckSumSSE,       ///< PCLMULQDQ CRC, SSSE3 Adler-32, OpenSSL digests
+    CheckSumAVX2       ///< PCLMULQDQ CRC, AVX2 Adler-32, OpenSSL digests
+  } CheckSumAcceleration;
+
+  /// Returns level of optimization currently used by checksum classes.
+  /**
+   * Unless set by SetCheckSumAcceleration() the highest level supported
+   * by the CPU is detected on first call.
+   * \since Added in 6.9.0.
+   **/
+  CheckSumAcceleration GetCheckSumAcceleration(void);
+
+  /// Sets level of optimization used by checksum classes.
+  /**
+   * The level is lowered to the highest one supported by the CPU.
+   * It may be changed at any time, even while checksums are computed.
+   * Checksum objects keep the level they found when started.
+   * \return level actually set.
+   * \since Added in 6.9.0.
+   **/
+  CheckSumAcceleration SetCheckSumAcceleration(CheckSumAcceleration level);
+
   /// Interface for checksum manipulations.
   /** This class is an interface and is extended in the specialized classes
    * CRC32Sum, MD5Sum and Adler32Sum. The interface is among others used
@@ -29,6 +65,10 @@ namespace Arc {
    **/
   class CheckSum {
   public:
+    /// Size of buffer sufficient for output of print() for any checksum type
+    /** \since Added in 6.9.0. */
+    static const int MaxPrintLength = 256;
+
     /// Default constructor
     CheckSum(void) {}
     virtual ~CheckSum(void) {}
@@ -114,6 +154,7 @@ namespace Arc {
     uint32_t r;
     unsigned long long count;
     bool computed;
+    CheckSumAcceleration accel; // level used since start()
   public:
     CRC32Sum(void);
     virtual ~CRC32Sum(void) {}
@@ -141,13 +182,18 @@ namespace Arc {
   /**
    * This class is a specialized class of the CheckSum class. It provides an
    * implementation of the MD5 message-digest algorithm specified in RFC
-   * 1321.
+   * 1321. Computation is done by OpenSSL unless CheckSumBasic level is
+   * selected or OpenSSL refuses to provide MD5.
    * @ingroup common
    * @headerfile CheckSum.h arc/CheckSum.h
    **/
   class MD5Sum
     : public CheckSum {
   private:
+    MD5Sum(const MD5Sum&);
+    MD5Sum& operator=(const MD5Sum&);
+    evp_md_ctx_st *ctx;
+    bool evp;
     bool computed;
     uint32_t A;
     uint32_t B;
@@ -159,6 +205,7 @@ namespace Arc {
     // uint32_t T[64];
   public:
     MD5Sum(void);
+    virtual ~MD5Sum(void);
     virtual void start(void);
     virtual void add(void *buf, unsigned long long int len);
     virtual void end(void);
@@ -188,16 +235,16 @@ namespace Arc {
    private:
     uLong adler;
     bool computed;
+    CheckSumAcceleration accel; // level used since start()
    public:
     Adler32Sum(void) : computed(false) {
       start();
     }
     virtual void start(void) {
       adler = adler32(0L, Z_NULL, 0);
+      accel = GetCheckSumAcceleration();
     }
-    virtual void add(void* buf,unsigned long long int len) {
-      adler = adler32(adler, (const Bytef *)buf, len);
-    }
+    virtual void add(void* buf,unsigned long long int len);
     virtual void end(void) {
       computed = true;
     }
@@ -223,10 +270,52 @@ namespace Arc {
     }
   };
 
+  /// Implementation of SHA family checksums
+  /**
+   * This class is a specialized class of the CheckSum class. It provides
+   * SHA-1, SHA-256 and SHA-512 message digests computed by OpenSSL.
+   * @ingroup common
+   * @headerfile CheckSum.h arc/CheckSum.h
+   * \since Added in 6.9.0.
+   **/
+  class SHASum
+    : public CheckSum {
+  private:
+    SHASum(const SHASum&);
+    SHASum& operator=(const SHASum&);
+    evp_md_ctx_st *ctx;
+    const evp_md_st *md;
+    unsigned int bits;
+    unsigned char digest[64];
+    unsigned int digest_len;
+    bool computed;
+  public:
+    /// Creates object for digest of specified size in bits - 160 (SHA-1), 256 or 512.
+    SHASum(unsigned int bits = 256);
+    virtual ~SHASum(void);
+    virtual void start(void);
+    virtual void add(void *buf, unsigned long long int len);
+    virtual void end(void);
+    virtual void result(unsigned char*& res, unsigned int& len) const {
+      res = (unsigned char*)digest;
+      len = digest_len;
+    }
+    virtual int print(char *buf, int len) const;
+    virtual void scan(const char *buf);
+    virtual operator bool(void) const {
+      return computed;
+    }
+    virtual bool operator!(void) const {
+      return !computed;
+    }
+  };
+
   /// Wrapper for CheckSum class
   /**
    * To be used for manipulation of any supported checksum type in a
-   * transparent way.
+   * transparent way. Additional checksums of other types may be requested
+   * with AddType(). Those are computed in the same pass over the data and
+   * may be obtained with Get().
    * @ingroup common
    * @headerfile CheckSum.h arc/CheckSum.h
    **/
@@ -240,11 +329,20 @@ namespace Arc {
       undefined, ///< Undefined checksum
       cksum,     ///< CRC32 checksum
       md5,       ///< MD5 checksum
-      adler32    ///< ADLER32 checksum
+      adler32,   ///< ADLER32 checksum
+      sha1,      ///< SHA-1 checksum
+      sha256,    ///< SHA-256 checksum
+      sha512     ///< SHA-512 checksum
     } type;
   private:
+    CheckSumAny(const CheckSumAny&);
+    CheckSumAny& operator=(const CheckSumAny&);
     CheckSum *cs;
     type tp;
+    std::list<std::pair<type, CheckSum*> > extra;
+    static CheckSum* create(type tp);
+    static type name_type(const char *name);
+    void clear_extra(void);
   public:
     /// Construct a new CheckSumAny from the given CheckSum.
     CheckSumAny(CheckSum *c = NULL)
@@ -255,21 +353,13 @@ namespace Arc {
     /// Construct a new CheckSumAny using the given checksum type represented as a string.
     CheckSumAny(const char *type);
     virtual ~CheckSumAny(void) {
+      clear_extra();
       if (cs)
         delete cs;
     }
-    virtual void start(void) {
-      if (cs)
-        cs->start();
-    }
-    virtual void add(void *buf, unsigned long long int len) {
-      if (cs)
-        cs->add(buf, len);
-    }
-    virtual void end(void) {
-      if (cs)
-        cs->end();
-    }
+    virtual void start(void);
+    virtual void add(void *buf, unsigned long long int len);
+    virtual void end(void);
     virtual void result(unsigned char*& res, unsigned int& len) const {
       if (cs) {
         cs->result(res, len);
@@ -309,6 +399,22 @@ namespace Arc {
     bool operator==(const char *s);
     bool operator==(const CheckSumAny& ck);
 
+    /// Request additional checksum to be computed in same pass over data.
+    /**
+     * Must be called before data is added. Adding the main type or the
+     * same type twice has no effect.
+     * @return false if type is not supported.
+     * \since Added in 6.9.0.
+     **/
+    bool AddType(type tp);
+    /// Get object computing checksum of specified type.
+    /**
+     * Returns main checksum or one requested by AddType(), or NULL if
+     * checksum of specified type is not computed.
+     * \since Added in 6.9.0.
+     **/
+    const CheckSum* Get(type tp) const;
+
     /// Get checksum of a file
     /**
      * This method provides an easy way to get the checksum of a file, by only
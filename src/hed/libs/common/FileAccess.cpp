@@ -5,9 +5,13 @@
 #include <list>
 #include <iostream>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include <arc/Run.h>
 #include <arc/ArcLocation.h>
+#include <arc/StringConv.h>
 
 #include "file_access.h"
 
@@ -135,7 +139,7 @@ namespace Arc {
 
 #define NORETRYLOOP Glib::Mutex::Lock mlock(lock_); for(int n = 1; n && (file_access_?file_access_:(file_access_=acquire_executer(uid_,gid_))) ;--n)
 
-  FileAccess::FileAccess(void):file_access_(NULL),errno_(0),uid_(0),gid_(0) {
+  FileAccess::FileAccess(void):file_access_(NULL),errno_(0),file_handle_(-1),uid_(0),gid_(0) {
     file_access_ = acquire_executer(uid_,gid_);
   }
 
@@ -444,6 +448,7 @@ namespace Arc {
     if(!swrite_string(*file_access_,path)) ABORTALL;
     int res = -1;
     ENDHEADER(CMD_OPENFILE,0);
+    file_handle_ = res;
     return (res != -1);
     }
     errno_ = -1;
@@ -466,6 +471,7 @@ namespace Arc {
     if((sizeof(res)+sizeof(errno_)+sizeof(l)+l) != header.size) ABORTALL;
     path.assign(l,' ');
     if(!sread(*file_access_,(void*)path.c_str(),l)) ABORTALL;
+    file_handle_ = res;
     return (res != -1);
     }
     errno_ = -1;
@@ -473,6 +479,7 @@ namespace Arc {
   }
 
   bool FileAccess::fa_close(void) {
+    file_handle_ = -1;
     NORETRYLOOP {
     STARTHEADER(CMD_CLOSEFILE,0);
     int res = 0;
@@ -483,6 +490,31 @@ namespace Arc {
     return false;
   }
 
+  int FileAccess::fa_reopen(void) {
+    int h = -1;
+    {
+      Glib::Mutex::Lock mlock(lock_);
+      if((!file_access_) || (file_handle_ == -1)) return -1;
+      int pid = file_access_->Pid();
+      if(pid <= 0) return -1;
+      std::string path = "/proc/"+tostring(pid)+"/fd/"+tostring(file_handle_);
+      h = ::open(path.c_str(),O_RDONLY|O_NOCTTY|O_NONBLOCK);
+      if(h == -1) return -1;
+    };
+    struct stat st;
+    struct stat fst;
+    // Proxy answering after file was opened proves its pid was not reused
+    // and comparing inodes proves handle still refers to same file.
+    if((::fstat(h,&st) != 0) || !S_ISREG(st.st_mode) ||
+       !fa_fstat(fst) || (st.st_dev != fst.st_dev) || (st.st_ino != fst.st_ino)) {
+      ::close(h);
+      return -1;
+    };
+    // Regular files do not need non-blocking mode
+    ::fcntl(h,F_SETFL,::fcntl(h,F_GETFL) & ~O_NONBLOCK);
+    return h;
+  }
+
   off_t FileAccess::fa_lseek(off_t offset, int whence) {
     NORETRYLOOP {
     STARTHEADER(CMD_SEEKFILE,sizeof(offset)+sizeof(whence));
@@ -167,6 +167,17 @@ namespace Arc {
      * \since Renamed in 3.0.0 from mkstemp
      */
     bool fa_mkstemp(std::string& path, mode_t mode);
+    /// Open currently open file directly in this process for reading.
+    /**
+     * File is reopened through /proc entry of proxy process. That way
+     * permissions are checked by proxy and afterwards file content may be
+     * accessed without passing it through proxy, e.g. by sendfile().
+     * Only regular files are reopened.
+     * \return new handle which must be closed by caller or -1 if file
+     * can't be reopened.
+     * \since Added in 6.9.0.
+     */
+    int fa_reopen(void);
     /// Change current position in open file.
     /** 
      * \since Renamed in 3.0.0 from lseek
@@ -204,6 +215,7 @@ namespace Arc {
     Glib::Mutex lock_;
     Run* file_access_;
     int errno_;
+    int file_handle_;
     uid_t uid_;
     gid_t gid_;
   public:
@@ -6,6 +6,7 @@
 
 #include <sstream>
 #include <fstream>
+#include <atomic>
 
 #include <unistd.h>
 
@@ -26,6 +27,48 @@ namespace Arc {
   static std::list<LogFile*> allfiles;
   static Glib::Mutex allfilesmutex;
 
+  static const int threshold_levels_num = 6;
+  static const LogLevel threshold_levels[threshold_levels_num] = {
+    DEBUG, VERBOSE, INFO, WARNING, ERROR, FATAL
+  };
+
+  // Changed every time threshold of any logger context changes. It
+  // invalidates results cached by Logger::mayLog(). Counter is
+  // zero-initialized before any static Logger object is constructed.
+  static std::atomic<unsigned int> thresholds_generation(0);
+
+  // Number of existing contexts of one logger, including per-thread ones,
+  // having threshold in range starting at corresponding level and ending
+  // before next one. It lets Logger::mayLog() decide without locks. Object
+  // is shared by logger and its contexts and destroyed by last of them
+  // because per-thread contexts may outlive logger.
+  class LoggerThresholds {
+   public:
+    LoggerThresholds(void):refs(1),inherited(0),cached(0) {
+      for(int n = 0; n < threshold_levels_num; ++n) in_use[n] = 0;
+    }
+    void Acquire(void) { ++refs; }
+    void Release(void) { if(--refs == 0) delete this; }
+    void Account(LogLevel threshold, int change) {
+      if(threshold <= 0) {
+        // Threshold 0 means threshold of parent is used
+        inherited += change;
+      } else {
+        int n = threshold_levels_num-1;
+        while((n > 0) && (threshold < threshold_levels[n])) --n;
+        in_use[n] += change;
+      }
+      // Counters must be updated before cached results are invalidated
+      ++thresholds_generation;
+    }
+    std::atomic<int> refs;
+    std::atomic<int> inherited;
+    std::atomic<int> in_use[threshold_levels_num];
+    // Generation in upper half and lowest effective threshold in lower
+    // half, so that both are always read consistently.
+    std::atomic<unsigned long long int> cached;
+  };
+
   static std::string list_to_domain(const std::list<std::string>& subdomains) {
     std::string domain;
     for(std::list<std::string>::const_iterator subdomain = subdomains.begin();
@@ -373,6 +416,198 @@ namespace Arc {
     }
   }
 
+  // Bounded queue of messages with multiple producers and single consumer.
+  // Every slot has sequence number telling whether it is free for position
+  // being written or holds message for position being read.
+  class LogQueueStorage {
+  public:
+    class Slot {
+    public:
+      std::atomic<unsigned long long int> seq;
+      LogMessage* message;
+    };
+    LogQueueStorage(unsigned int size);
+    ~LogQueueStorage();
+    bool push(LogMessage* message);
+    LogMessage* pop();
+    bool empty() const;
+    unsigned int size;
+    Slot* slots;
+    std::atomic<unsigned long long int> head;
+    unsigned long long int tail;
+    std::atomic<unsigned long long int> queued;
+    std::atomic<unsigned long long int> written;
+    std::atomic<unsigned long long int> dropped;
+    std::atomic<bool> writer_sleeping;
+    std::atomic<int> producers_waiting;
+    bool exiting;
+    Glib::Mutex lock;
+    Glib::Cond writer_cond;
+    Glib::Cond producer_cond;
+    Glib::Thread* thread;
+  };
+
+  LogQueueStorage::LogQueueStorage(unsigned int size)
+    : size(size?size:1), slots(NULL), head(0), tail(0), queued(0), written(0), dropped(0),
+      writer_sleeping(false), producers_waiting(0), exiting(false), thread(NULL) {
+    slots = new Slot[this->size];
+    for(unsigned int n = 0; n < this->size; ++n) {
+      slots[n].seq = n;
+      slots[n].message = NULL;
+    }
+  }
+
+  LogQueueStorage::~LogQueueStorage() {
+    for(LogMessage* message = pop(); message; message = pop()) delete message;
+    delete[] slots;
+  }
+
+  bool LogQueueStorage::push(LogMessage* message) {
+    unsigned long long int pos = head.load(std::memory_order_relaxed);
+    for(;;) {
+      Slot& slot = slots[pos % size];
+      unsigned long long int seq = slot.seq.load(std::memory_order_acquire);
+      if(seq == pos) {
+        if(head.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) {
+          slot.message = message;
+          slot.seq.store(pos+1, std::memory_order_release);
+          return true;
+        }
+      } else if(seq < pos) {
+        // Slot still holds message from previous round - queue is full
+        return false;
+      } else {
+        pos = head.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  LogMessage* LogQueueStorage::pop() {
+    Slot& slot = slots[tail % size];
+    if(slot.seq.load(std::memory_order_acquire) != tail+1) return NULL;
+    LogMessage* message = slot.message;
+    slot.seq.store(tail+size, std::memory_order_release);
+    ++tail;
+    return message;
+  }
+
+  bool LogQueueStorage::empty() const {
+    return (slots[tail % size].seq.load(std::memory_order_acquire) != tail+1);
+  }
+
+  LogQueue::LogQueue(LogDestination& destination, unsigned int size, bool block)
+    : destination(destination),
+      storage(new LogQueueStorage(size)),
+      block(block) {
+    try {
+      storage->thread = Glib::Thread::create(sigc::mem_fun(*this, &LogQueue::writer), true);
+    } catch (Glib::Exception& e) {} catch (std::exception& e) {};
+  }
+
+  LogQueue::~LogQueue() {
+    if(storage->thread) {
+      {
+        Glib::Mutex::Lock lock(storage->lock);
+        storage->exiting = true;
+        storage->writer_cond.signal();
+      }
+      storage->thread->join();
+    }
+    delete storage;
+  }
+
+  void LogQueue::log(const LogMessage& message) {
+    if(!storage->thread) {
+      // Without writing thread behave like synchronous destination
+      destination.log(message);
+      return;
+    }
+    // Original message may refer to data owned by calling thread, so
+    // queued copy gets message already formatted.
+    std::ostringstream text;
+    EnvLockWrap(false); // Protecting getenv inside gettext()
+    text << message.message;
+    EnvLockUnwrap(false);
+    LogMessage* copy = new LogMessage(message.level, IString("%s", text.str()), message.identifier);
+    copy->time = message.time;
+    copy->domain = message.domain;
+    while(!storage->push(copy)) {
+      if(!block) {
+        ++(storage->dropped);
+        delete copy;
+        return;
+      }
+      Glib::Mutex::Lock lock(storage->lock);
+      ++(storage->producers_waiting);
+      Glib::TimeVal etime;
+      etime.assign_current_time();
+      etime.add_milliseconds(100);
+      storage->producer_cond.timed_wait(storage->lock, etime);
+      --(storage->producers_waiting);
+    }
+    ++(storage->queued);
+    // Pairs with fence in writer() so that either writer sees new message
+    // or this thread sees writer going to sleep.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(storage->writer_sleeping) {
+      Glib::Mutex::Lock lock(storage->lock);
+      storage->writer_cond.signal();
+    }
+  }
+
+  void LogQueue::flush() {
+    unsigned long long int queued = storage->queued;
+    while(storage->thread && (storage->written < queued)) {
+      Glib::Mutex::Lock lock(storage->lock);
+      storage->writer_cond.signal();
+      Glib::TimeVal etime;
+      etime.assign_current_time();
+      etime.add_milliseconds(10);
+      storage->producer_cond.timed_wait(storage->lock, etime);
+    }
+  }
+
+  unsigned long long int LogQueue::getDropped() const {
+    return storage->dropped;
+  }
+
+  void LogQueue::writer(void) {
+    unsigned long long int reported = 0;
+    for(;;) {
+      LogMessage* message = storage->pop();
+      if(message) {
+        destination.log(*message);
+        delete message;
+        ++(storage->written);
+        if(storage->producers_waiting > 0) {
+          Glib::Mutex::Lock lock(storage->lock);
+          storage->producer_cond.broadcast();
+        }
+        continue;
+      }
+      unsigned long long int dropped = storage->dropped;
+      if(dropped != reported) {
+        LogMessage report(WARNING, IString("%llu log messages were dropped because queue was full", dropped-reported));
+        report.setDomain("Arc.LogQueue");
+        destination.log(report);
+        reported = dropped;
+      }
+      Glib::Mutex::Lock lock(storage->lock);
+      if(storage->exiting) break;
+      // Wake up threads waiting in flush()
+      storage->producer_cond.broadcast();
+      storage->writer_sleeping = true;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if(storage->empty()) {
+        Glib::TimeVal etime;
+        etime.assign_current_time();
+        etime.add_milliseconds(1000);
+        storage->writer_cond.timed_wait(storage->lock, etime);
+      }
+      storage->writer_sleeping = false;
+    }
+  }
+
   class LoggerContextRef: public ThreadDataItem {
     friend class Logger;
     private:
@@ -414,11 +649,32 @@ namespace Arc {
     }
   }
 
+  LoggerContext::LoggerContext(LogLevel thr, LoggerThresholds* thrs):
+         usage_count(0),threshold(thr),thresholds(thrs) {
+    thresholds->Acquire();
+    thresholds->Account(threshold, 1);
+  }
+
+  LoggerContext::LoggerContext(const LoggerContext& ctx):
+         usage_count(0),destinations(ctx.destinations),threshold(ctx.threshold),
+         thresholds(ctx.thresholds) {
+    thresholds->Acquire();
+    thresholds->Account(threshold, 1);
+  }
+
   LoggerContext::~LoggerContext(void) {
+    thresholds->Account(threshold, -1);
+    thresholds->Release();
     mutex.trylock();
     mutex.unlock();
   }
 
+  void LoggerContext::setThreshold(LogLevel thr) {
+    thresholds->Account(thr, 1);
+    thresholds->Account(threshold, -1);
+    threshold = thr;
+  }
+
   Logger* Logger::rootLogger = NULL;
   std::map<std::string,LogLevel>* Logger::defaultThresholds = NULL;
   unsigned int Logger::rootLoggerMark = ~rootLoggerMagic;
@@ -436,11 +692,12 @@ namespace Arc {
                  const std::string& subdomain)
     : parent(&parent),
       domain(parent.getDomain() + "." + subdomain),
-      context((LogLevel)0) {
+      thresholds(new LoggerThresholds),
+      context((LogLevel)0, thresholds) {
     std::map<std::string,LogLevel>::const_iterator thr =
                                    defaultThresholds->find(domain);
     if(thr != defaultThresholds->end()) {
-      context.threshold = thr->second;
+      context.setThreshold(thr->second);
     }
   }
 
@@ -449,10 +706,13 @@ namespace Arc {
                  LogLevel threshold)
     : parent(&parent),
       domain(parent.getDomain() + "." + subdomain),
-      context(threshold) {
+      thresholds(new LoggerThresholds),
+      context(threshold, thresholds) {
   }
 
   Logger::~Logger() {
+    // Contexts release their own references
+    thresholds->Release();
   }
 
   void Logger::addDestination(LogDestination& destination) {
@@ -509,7 +769,7 @@ namespace Arc {
 
   void Logger::setThreshold(LogLevel threshold) {
     Glib::Mutex::Lock lock(mutex);
-    this->getContext().threshold = threshold;
+    this->getContext().setThreshold(threshold);
   }
 
   void Logger::setThresholdForDomain(LogLevel threshold,
@@ -555,7 +815,38 @@ namespace Arc {
     
   }
 
+  LogLevel Logger::lowestThreshold(void) const {
+    int lowest = -1;
+    for(const Logger* logger = this; logger; logger = logger->parent) {
+      const LoggerThresholds& thrs = *(logger->thresholds);
+      for(int n = 0; n < threshold_levels_num; ++n) {
+        if(thrs.in_use[n] > 0) {
+          if((lowest < 0) || (threshold_levels[n] < lowest)) lowest = threshold_levels[n];
+          break;
+        }
+      }
+      // Parent matters only if some context uses its threshold
+      if(thrs.inherited == 0) return (LogLevel)((lowest < 0) ? 0 : lowest);
+    }
+    // Context without threshold all the way up passes everything
+    return (LogLevel)0;
+  }
+
+  bool Logger::mayLog(LogLevel level) const {
+    // Generation is taken before counters are read. If they change
+    // meanwhile cached value is computed again on next call.
+    unsigned int generation = thresholds_generation.load();
+    unsigned long long int cached = thresholds->cached.load(std::memory_order_acquire);
+    if((unsigned int)(cached >> 32) != generation) {
+      cached = (((unsigned long long int)generation) << 32) |
+               (unsigned int)lowestThreshold();
+      thresholds->cached.store(cached, std::memory_order_release);
+    }
+    return (level >= (LogLevel)(cached & 0xffffffffULL));
+  }
+
   void Logger::msg(LogMessage message) {
+    if (!mayLog(message.getLevel())) return;
     message.setDomain(domain);
     if (message.getLevel() >= getThreshold()) {
       log(message);
@@ -565,7 +856,8 @@ namespace Arc {
   Logger::Logger()
     : parent(0),
       domain("Arc"),
-      context(DefaultLogLevel) {
+      thresholds(new LoggerThresholds),
+      context(DefaultLogLevel, thresholds) {
     // addDestination(cerr);
   }
 
@@ -192,6 +192,9 @@ namespace Arc {
      */
     friend class Logger;
 
+    /// LogQueue makes independent copies of messages.
+    friend class LogQueue;
+
   };
 
 
@@ -413,8 +416,60 @@ namespace Arc {
     bool reopen;
   };
 
+  class LogQueueStorage;
+
+  /// A class for writing log messages asynchronously.
+  /** This class passes log messages to another LogDestination from a
+     dedicated thread, so that threads producing messages are not delayed
+     by slow writing, e.g. to file on busy disk. Messages are put into
+     bounded queue without taking any locks. If queue is full messages are
+     either dropped or the producing thread waits till there is space,
+     depending on chosen policy. Number of dropped messages is counted and
+     reported to destination as a separate message. Messages are formatted
+     by destination, hence format and prefix set for LogQueue itself are
+     not used.
+     \since Added in 6.9.0.
+     \headerfile Logger.h arc/Logger.h
+   */
+  class LogQueue
+    : public LogDestination {
+  public:
+
+    /// Creates a LogQueue writing to another LogDestination.
+    /** @param destination The LogDestination to which to write LogMessages.
+       It must exist at least as long as this object.
+       @param size Maximal number of messages waiting to be written.
+       @param block If true thread logging into full queue waits,
+       otherwise the message is dropped.
+     */
+    LogQueue(LogDestination& destination, unsigned int size = 4096, bool block = false);
+
+    /// Writes all queued messages and stops writing thread.
+    ~LogQueue();
+
+    /// Puts a LogMessage into queue.
+    virtual void log(const LogMessage& message);
+
+    /// Waits till all messages queued so far are written.
+    void flush();
+
+    /// Returns number of messages dropped because queue was full.
+    unsigned long long int getDropped() const;
+
+  private:
+    LogQueue(void);
+    LogQueue(const LogQueue& unique);
+    void operator=(const LogQueue& unique);
+    void writer(void);
+    LogDestination& destination;
+    LogQueueStorage* storage;
+    bool block;
+  };
+
   class LoggerContextRef;
 
+  class LoggerThresholds;
+
   /** \cond Container for internal logger configuration.
      \headerfile Logger.h arc/Logger.h */
   class LoggerContext {
@@ -433,13 +488,18 @@ namespace Arc {
       /// The threshold of Logger.
       LogLevel threshold;
 
-      LoggerContext(LogLevel thr):usage_count(0),threshold(thr) { };
+      /// Thresholds of all contexts of same Logger.
+      LoggerThresholds* thresholds;
+
+      LoggerContext(LogLevel thr, LoggerThresholds* thrs);
 
-      LoggerContext(const LoggerContext& ctx):
-             usage_count(0),destinations(ctx.destinations),threshold(ctx.threshold) { };
+      LoggerContext(const LoggerContext& ctx);
 
       ~LoggerContext(void);
 
+      /// Changes threshold and accounts for it in Logger::mayLog().
+      void setThreshold(LogLevel thr);
+
       void Acquire(void);
 
       void Release(void);
@@ -616,30 +676,35 @@ namespace Arc {
        @param str The message text.
      */
     void msg(LogLevel level, const std::string& str) {
+      if (!mayLog(level)) return;
       msg(LogMessage(level, IString(str)));
     }
 
     template<class T0>
     void msg(LogLevel level, const std::string& str,
              const T0& t0) {
+      if (!mayLog(level)) return;
       msg(LogMessage(level, IString(str, t0)));
     }
 
     template<class T0, class T1>
     void msg(LogLevel level, const std::string& str,
              const T0& t0, const T1& t1) {
+      if (!mayLog(level)) return;
       msg(LogMessage(level, IString(str, t0, t1)));
     }
 
     template<class T0, class T1, class T2>
     void msg(LogLevel level, const std::string& str,
              const T0& t0, const T1& t1, const T2& t2) {
+      if (!mayLog(level)) return;
       msg(LogMessage(level, IString(str, t0, t1, t2)));
     }
 
     template<class T0, class T1, class T2, class T3>
     void msg(LogLevel level, const std::string& str,
              const T0& t0, const T1& t1, const T2& t2, const T3& t3) {
+      if (!mayLog(level)) return;
       msg(LogMessage(level, IString(str, t0, t1, t2, t3)));
     }
 
@@ -647,6 +712,7 @@ namespace Arc {
     void msg(LogLevel level, const std::string& str,
              const T0& t0, const T1& t1, const T2& t2, const T3& t3,
              const T4& t4) {
+      if (!mayLog(level)) return;
       msg(LogMessage(level, IString(str, t0, t1, t2, t3, t4)));
     }
 
@@ -655,6 +721,7 @@ namespace Arc {
     void msg(LogLevel level, const std::string& str,
              const T0& t0, const T1& t1, const T2& t2, const T3& t3,
              const T4& t4, const T5& t5) {
+      if (!mayLog(level)) return;
       msg(LogMessage(level, IString(str, t0, t1, t2, t3, t4, t5)));
     }
 
@@ -663,6 +730,7 @@ namespace Arc {
     void msg(LogLevel level, const std::string& str,
              const T0& t0, const T1& t1, const T2& t2, const T3& t3,
              const T4& t4, const T5& t5, const T6& t6) {
+      if (!mayLog(level)) return;
       msg(LogMessage(level, IString(str, t0, t1, t2, t3, t4, t5, t6)));
     }
 
@@ -671,6 +739,7 @@ namespace Arc {
     void msg(LogLevel level, const std::string& str,
              const T0& t0, const T1& t1, const T2& t2, const T3& t3,
              const T4& t4, const T5& t5, const T6& t6, const T7& t7) {
+      if (!mayLog(level)) return;
       msg(LogMessage(level, IString(str, t0, t1, t2, t3, t4, t5, t6, t7)));
     }
 
@@ -703,6 +772,18 @@ namespace Arc {
      */
     std::string getDomain();
 
+    /// Checks if message of specified level may pass threshold of this logger.
+    /** It is a quick check done without locking and before message is
+       formatted. It accounts for thresholds of all per-thread contexts of
+       this logger and of its parents, hence true does not mean message
+       will be logged. But false means it will not. Result is cached till
+       any threshold changes.
+     */
+    bool mayLog(LogLevel level) const;
+
+    /// Returns lowest threshold any context of this logger may have in effect.
+    LogLevel lowestThreshold(void) const;
+
     /// Forwards a log message.
     /** This method is called by the msg() method and by child
        Loggers. It filters messages based on their level and forwards
@@ -721,6 +802,9 @@ namespace Arc {
     /// Per-trhread storage id for context;
     std::string context_id;
 
+    /// Thresholds of contexts of this logger, used by mayLog().
+    LoggerThresholds* thresholds;
+
     LoggerContext context;
 
     LoggerContext& getContext(void);
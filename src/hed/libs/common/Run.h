@@ -64,6 +64,10 @@ namespace Arc {
     bool stdout_keep_;
     bool stderr_keep_;
     bool stdin_keep_;
+    // Files to attach to std* handles of process instead of pipes
+    std::string stdout_redirect_;
+    std::string stderr_redirect_;
+    std::string stdin_redirect_;
     // PID of child
     pid_t pid_;
     // Arguments to execute
@@ -126,6 +130,11 @@ namespace Arc {
     }
     /// Return true if execution is going on.
     bool Running(void);
+    /// Returns process id of started executable or -1 if not started.
+    /** \since Added in 6.9.0. */
+    int Pid(void) {
+      return pid_;
+    }
     /// Returns time when executable was started.
     Time RunTime(void) {
       return run_time_;
@@ -182,6 +191,21 @@ namespace Arc {
     void KeepStderr(bool keep = true);
     /// Keep stdin same as parent's if keep = true. No pipe will be created.
     void KeepStdin(bool keep = true);
+    /// Attach stdout of executable to file instead of pipe.
+    /** File is opened for appending after user identity of process is set
+        and is created if missing. If file can't be opened /dev/null is used
+        instead. Empty path cancels redirection.
+        \since Added in 6.9.0. */
+    void RedirectStdout(const std::string& path);
+    /// Attach stderr of executable to file instead of pipe.
+    /** Same as RedirectStdout() but for stderr.
+        \since Added in 6.9.0. */
+    void RedirectStderr(const std::string& path);
+    /// Attach stdin of executable to file instead of pipe.
+    /** File is opened for reading after user identity of process is set.
+        If file can't be opened /dev/null is used instead.
+        \since Added in 6.9.0. */
+    void RedirectStdin(const std::string& path);
     /// Closes pipe associated with stdout handle.
     void CloseStdout(void);
     /// Closes pipe associated with stderr handle.
@@ -189,6 +213,9 @@ namespace Arc {
     /// Closes pipe associated with stdin handle.
     void CloseStdin(void);
     /// Assign a function to be called just after process is forked but before execution starts.
+    /** Without initializer process is started in faster way which does not
+        copy memory of parent. If possible use AssignUserId(), AssignGroupId()
+        and Redirect* methods instead of initializer. */
     void AssignInitializer(void (*initializer_func)(void*), void *initializer_arg);
     /// Assign a function to be called just after execution ends. It is executed asynchronously.
     void AssignKicker(void (*kicker_func)(void*), void *kicker_arg);
@@ -13,6 +13,9 @@
 #include <sys/wait.h>
 #include <sys/time.h>
 #include <sys/resource.h>
+#ifdef HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
 #include <fcntl.h>
 #include <signal.h>
 #include <poll.h>
@@ -92,6 +95,19 @@ namespace Arc {
     void Run(void);
   };
 
+  // To leave clean environment reset all signals.
+  // Otherwise we may get some signals non-intentionally ignored.
+  static void reset_signals(void) {
+#ifdef SIGRTMIN
+    for(int n = SIGHUP; n < SIGRTMIN; ++n) {
+#else
+    // At least reset all signals whose numbers are well defined
+    for(int n = SIGHUP; n < SIGTERM; ++n) {
+#endif
+      signal(n,SIG_DFL);
+    }
+  }
+
   void RunInitializerArgument::Run(void) {
     // It would be nice to have function which removes all Glib::Mutex locks.
     // But so far we need to save ourselves only from Logger and SetEnv/GetEnv.
@@ -108,17 +124,8 @@ namespace Arc {
     };
     // set proper umask
     ::umask(0077);
-    // To leave clean environment reset all signals.
-    // Otherwise we may get some signals non-intentionally ignored.
     // Post-fork code takes care of open handles.
-#ifdef SIGRTMIN
-    for(int n = SIGHUP; n < SIGRTMIN; ++n) {
-#else
-    // At least reset all signals whose numbers are well defined
-    for(int n = SIGHUP; n < SIGTERM; ++n) {
-#endif
-      signal(n,SIG_DFL);
-    }
+    reset_signals();
     if (!func) return;
     // Run initializer requested by caller
     (*func)(arg);
@@ -475,6 +482,123 @@ namespace Arc {
     _exit(code);
   }
 
+  // Identity switching functions of C library synchronize change with all
+  // threads of process. Child started by vfork() shares memory with parent
+  // and such synchronization would affect threads of parent. So in that
+  // case system calls are made directly.
+  static int child_setgid(int gid) {
+#if defined(SYS_setgid32)
+    return ::syscall(SYS_setgid32, gid);
+#elif defined(SYS_setgid)
+    return ::syscall(SYS_setgid, gid);
+#else
+    return ::setgid(gid);
+#endif
+  }
+
+  static int child_setuid(int uid) {
+#if defined(SYS_setuid32)
+    return ::syscall(SYS_setuid32, uid);
+#elif defined(SYS_setuid)
+    return ::syscall(SYS_setuid, uid);
+#else
+    return ::setuid(uid);
+#endif
+  }
+
+  // Close all handles inherited from parent except std* ones.
+  static void close_inherited(unsigned int max_files) {
+#ifdef SYS_close_range
+    // Single system call instead of one per possible handle, which matters
+    // if limit of open files is high. Fails on kernels older than 5.9.
+    if(::syscall(SYS_close_range, 3, ~0U, 0) == 0) return;
+#endif
+    for(unsigned int i=3;i<max_files;i++) { close(i); };
+  }
+
+  static void redirect_child(int h, const char* path, int flags) {
+    if(!path) return;
+    int f = ::open(path, flags, S_IRUSR | S_IWUSR);
+    if(f == -1) f = ::open("/dev/null", flags & O_ACCMODE);
+    if(f == -1) exit_child(-1, "Failed to open redirection file\n");
+    if(f != h) {
+      if(dup2(f, h) != h) exit_child(-1, "Failed to redirect std handle\n");
+      close(f);
+    };
+  }
+
+  // Everything child process needs for starting executable. It is prepared
+  // in advance because child started by vfork() must not allocate memory
+  // or take any locks.
+  class RunChildSetup {
+  public:
+    int pipe_stdin[2];
+    int pipe_stdout[2];
+    int pipe_stderr[2];
+    const char* stdin_redirect;
+    const char* stdout_redirect;
+    const char* stderr_redirect;
+    const char* working_directory;
+    char * * argv;
+    char * * envp;
+    unsigned int max_files;
+    int user_id;
+    int group_id;
+    // Set if process is started by fork(). Otherwise identity is switched here.
+    RunInitializerArgument* arg;
+  };
+
+  static void run_child(const RunChildSetup& s) {
+    // child - set std* and do exec
+    if(s.pipe_stdin[0] != -1) {
+      close(s.pipe_stdin[1]);
+      if(dup2(s.pipe_stdin[0], 0) != 0) exit_child(-1, "Failed to setup stdin\n");
+      close(s.pipe_stdin[0]);
+    };
+    if(s.pipe_stdout[1] != -1) {
+      close(s.pipe_stdout[0]);
+      if(dup2(s.pipe_stdout[1], 1) != 1) exit_child(-1, "Failed to setup stdout\n");
+      close(s.pipe_stdout[1]);
+    };
+    if(s.pipe_stderr[1] != -1) {
+      close(s.pipe_stderr[0]);
+      if(dup2(s.pipe_stderr[1], 2) != 2) exit_child(-1, "Failed to setup stderr\n");
+      close(s.pipe_stderr[1]);
+    };
+    if(s.arg) {
+      s.arg->Run();
+    } else {
+      if(s.group_id > 0) (void)child_setgid(s.group_id);
+      if(s.user_id != 0) {
+        if(child_setuid(s.user_id) != 0) exit_child(-1, "Failed to switch user id\n");
+        // in case previous user was not allowed to switch group id
+        if(s.group_id > 0) (void)child_setgid(s.group_id);
+      };
+      ::umask(0077);
+      reset_signals();
+    };
+    // Files are opened with identity of process
+    redirect_child(0, s.stdin_redirect, O_RDONLY);
+    redirect_child(1, s.stdout_redirect, O_WRONLY | O_CREAT | O_APPEND);
+    redirect_child(2, s.stderr_redirect, O_WRONLY | O_CREAT | O_APPEND);
+    if(::chdir(s.working_directory) != 0) {
+      exit_child(-1, "Failed to change working directory\n");
+    }
+    close_inherited(s.max_files);
+    (void)::execve(s.argv[0], s.argv, s.envp);
+    exit_child(-1, "Failed to execute command\n");
+  }
+
+#ifdef HAVE_VFORK
+  // Kept separate so that nothing in caller's frame is modified by child.
+  // Must never be inlined, otherwise child would run in caller's frame.
+  static pid_t __attribute__((noinline)) spawn_child(const RunChildSetup& s) {
+    pid_t pid = ::vfork();
+    if(pid == 0) run_child(s);
+    return pid;
+  }
+#endif
+
   bool Run::Start(void) {
     if (started_) return false;
     if (argv_.size() < 1) return false;
@@ -492,12 +616,15 @@ namespace Arc {
       envp_tmp = GetEnv();
       remove_env(envp_tmp, envx_);
       add_env(envp_tmp, envp_);
+      bool stdin_pipe = !stdin_keep_ && stdin_redirect_.empty();
+      bool stdout_pipe = !stdout_keep_ && stdout_redirect_.empty();
+      bool stderr_pipe = !stderr_keep_ && stderr_redirect_.empty();
       int pipe_stdin[2] = { -1, -1 };
       int pipe_stdout[2] = { -1, -1 };
       int pipe_stderr[2] = { -1, -1 };
-      if((stdin_keep_  || (::pipe(pipe_stdin) == 0)) && 
-         (stdout_keep_ || (::pipe(pipe_stdout) == 0)) &&
-         (stderr_keep_ || (::pipe(pipe_stderr) == 0))) {
+      if((!stdin_pipe  || (::pipe(pipe_stdin) == 0)) && 
+         (!stdout_pipe || (::pipe(pipe_stdout) == 0)) &&
+         (!stderr_pipe || (::pipe(pipe_stderr) == 0))) {
 
         uint64_t max_files = RLIM_INFINITY;
         struct rlimit lim;
@@ -516,42 +643,46 @@ namespace Arc {
         };
         envp[n] = NULL;
 
+        RunChildSetup setup;
+        for(int i = 0; i < 2; ++i) {
+          setup.pipe_stdin[i] = pipe_stdin[i];
+          setup.pipe_stdout[i] = pipe_stdout[i];
+          setup.pipe_stderr[i] = pipe_stderr[i];
+        };
+        setup.stdin_redirect = stdin_redirect_.empty() ? NULL : stdin_redirect_.c_str();
+        setup.stdout_redirect = stdout_redirect_.empty() ? NULL : stdout_redirect_.c_str();
+        setup.stderr_redirect = stderr_redirect_.empty() ? NULL : stderr_redirect_.c_str();
+        setup.working_directory = working_directory.c_str();
+        setup.argv = argv;
+        setup.envp = envp;
+        setup.max_files = max_files;
+        setup.user_id = user_id_;
+        setup.group_id = group_id_;
+        setup.arg = arg.Ptr();
+
         // Stop acceptin signals temporarily to avoid signal handlers calling unsafe
         // functions inside child context.
         sigset_t newsig; sigfillset(&newsig);
         sigset_t oldsig; sigemptyset(&oldsig);
         bool oldsig_set = (pthread_sigmask(SIG_BLOCK,&newsig,&oldsig) == 0);
 
-        if (oldsig_set)
-          pid = ::fork();
-        if(pid == 0) {
-          // child - set std* and do exec
-          if(pipe_stdin[0] != -1) {
-            close(pipe_stdin[1]);
-            if(dup2(pipe_stdin[0], 0) != 0) exit_child(-1, "Failed to setup stdin\n");
-            close(pipe_stdin[0]);
-          };
-          if(pipe_stdout[1] != -1) {
-            close(pipe_stdout[0]);
-            if(dup2(pipe_stdout[1], 1) != 1) exit_child(-1, "Failed to setup stdout\n");
-            close(pipe_stdout[1]);
-          };
-          if(pipe_stderr[1] != -1) {
-            close(pipe_stderr[0]);
-            if(dup2(pipe_stderr[1], 2) != 2) exit_child(-1, "Failed to setup stderr\n");
-            close(pipe_stderr[1]);
+        if (oldsig_set) {
+#ifdef HAVE_VFORK
+          // Without initializer nothing has to run in child except system
+          // calls. Then vfork() is used which does not copy page tables of
+          // parent and hence time to start process does not grow with its
+          // memory size.
+          if(!initializer_func_) {
+            setup.arg = NULL;
+            pid = spawn_child(setup);
+          } else
+#endif
+          {
+            pid = ::fork();
+            if(pid == 0) run_child(setup);
           };
-          arg->Run();
-          if(::chdir(working_directory.c_str()) != 0) {
-            exit_child(-1, "Failed to change working directory\n");
-          }
-
-          // close all handles inherited from parent
-          for(unsigned int i=3;i<max_files;i++) { close(i); }; // skiping std* handles
-
-          (void)::execve(argv[0], argv, envp);
-          exit_child(-1, "Failed to execute command\n");
-        } else if(pid != -1) {
+        };
+        if(pid != -1) {
           // parent - close unneeded sides of pipes
           if(pipe_stdin[1] != -1) {
             close(pipe_stdin[0]); pipe_stdin[0] = -1;
@@ -583,13 +714,13 @@ namespace Arc {
         throw Glib::SpawnError(Glib::SpawnError::FORK, "Generic error");
       };
       pid_ = pid;
-      if (!stdin_keep_) {
+      if (stdin_pipe) {
         fcntl(stdin_, F_SETFL, fcntl(stdin_, F_GETFL) | O_NONBLOCK);
       };
-      if (!stdout_keep_) {
+      if (stdout_pipe) {
         fcntl(stdout_, F_SETFL, fcntl(stdout_, F_GETFL) | O_NONBLOCK);
       };
-      if (!stderr_keep_) {
+      if (stderr_pipe) {
         fcntl(stderr_, F_SETFL, fcntl(stderr_, F_GETFL) | O_NONBLOCK);
       };
       run_time_ = Time();
@@ -853,6 +984,18 @@ namespace Arc {
     if (!running_) stdin_keep_ = keep;
   }
 
+  void Run::RedirectStdout(const std::string& path) {
+    if (!running_) stdout_redirect_ = path;
+  }
+
+  void Run::RedirectStderr(const std::string& path) {
+    if (!running_) stderr_redirect_ = path;
+  }
+
+  void Run::RedirectStdin(const std::string& path) {
+    if (!running_) stdin_redirect_ = path;
+  }
+
   void Run::AssignInitializer(void (*initializer_func)(void *arg), void *initializer_arg) {
     if (!running_) {
       initializer_arg_ = initializer_arg;
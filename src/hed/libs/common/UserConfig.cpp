@@ -183,7 +183,7 @@ namespace Arc {
   }
 
   UserConfig::UserConfig(initializeCredentialsType initializeCredentials)
-    : timeout(0), keySize(0), ok(false), initializeCredentials(initializeCredentials) {
+    : timeout(0), parallelRequests(0), keySize(0), ok(false), initializeCredentials(initializeCredentials) {
     if (!InitializeCredentials(initializeCredentials)) {
       return;
     }
@@ -196,7 +196,7 @@ namespace Arc {
   UserConfig::UserConfig(const std::string& conffile,
                          initializeCredentialsType initializeCredentials,
                          bool loadSysConfig)
-    : timeout(0), keySize(0), ok(false), initializeCredentials(initializeCredentials)  {
+    : timeout(0), parallelRequests(0), keySize(0), ok(false), initializeCredentials(initializeCredentials)  {
     setDefaults();
     if (loadSysConfig) {
       if (Glib::file_test(SYSCONFIG(), Glib::FILE_TEST_IS_REGULAR)) {
@@ -242,7 +242,7 @@ namespace Arc {
 
   UserConfig::UserConfig(const std::string& conffile, const std::string& jfile,
                          initializeCredentialsType initializeCredentials, bool loadSysConfig)
-    : timeout(0), keySize(0), ok(false), initializeCredentials(initializeCredentials)  {
+    : timeout(0), parallelRequests(0), keySize(0), ok(false), initializeCredentials(initializeCredentials)  {
     // If job list file have been specified, try to initialize it, and
     // if it fails then this object is non-valid (ok = false).
     setDefaults();
@@ -330,6 +330,15 @@ namespace Arc {
     return false;
   }
 
+  bool UserConfig::ParallelRequests(int newParallelRequests) {
+    if (newParallelRequests > 0) {
+      parallelRequests = newParallelRequests;
+      return true;
+    }
+
+    return false;
+  }
+
   bool UserConfig::Verbosity(const std::string& newVerbosity) {
     LogLevel ll;
     if (istring_to_level(newVerbosity, ll)) {
@@ -716,6 +725,16 @@ namespace Arc {
               while (common["timeout"]) common["timeout"].Destroy();
             }
           }
+          if (common["parallelrequests"]) {
+            if (!stringto(common["parallelrequests"], parallelRequests))
+              logger.msg(WARNING, "The value of the parallelrequests attribute in the configuration file (%s) was only partially parsed", conffile);
+            if (parallelRequests <= 0) parallelRequests = DEFAULT_PARALLEL_REQUESTS;
+            common["parallelrequests"].Destroy();
+            if (common["parallelrequests"]) {
+              logger.msg(WARNING, "Multiple %s attributes in configuration file (%s)", "parallelrequests", conffile);
+              while (common["parallelrequests"]) common["parallelrequests"].Destroy();
+            }
+          }
           if (common["brokername"]) {
             broker = std::pair<std::string, std::string>(common["brokername"],
                                                          common["brokerarguments"] ? common["brokerarguments"] : "");
@@ -914,6 +933,8 @@ namespace Arc {
       file << "joblist = " << joblistfile << std::endl;
     if (timeout > 0)
       file << "timeout = " << timeout << std::endl;
+    if ((parallelRequests > 0) && (parallelRequests != DEFAULT_PARALLEL_REQUESTS))
+      file << "parallelrequests = " << parallelRequests << std::endl;
     if (!broker.first.empty()) {
       file << "brokername = " << broker.first << std::endl;
       if (!broker.second.empty())
@@ -1011,6 +1032,7 @@ namespace Arc {
 
   void UserConfig::setDefaults() {
     timeout = DEFAULT_TIMEOUT;
+    parallelRequests = DEFAULT_PARALLEL_REQUESTS;
     broker.first = DEFAULT_BROKER();
     broker.second = "";
   }
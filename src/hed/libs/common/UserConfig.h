@@ -136,6 +136,7 @@ namespace Arc {
    * - cacertificatesdirectory / CACertificatesDirectory(const std::string&)
    * - cacertificatepath / CACertificatePath(const std::string&)
    * - timeout / Timeout(int)
+   * - parallelrequests / ParallelRequests(int)
    * - joblist / JobListFile(const std::string&)
    * - joblisttype / JobListType(const std::string&)
    * - verbosity / Verbosity(const std::string&)
@@ -535,6 +536,34 @@ namespace Arc {
      **/
     int  Timeout() const { return timeout; }
 
+    /// Set number of services contacted in parallel
+    /**
+     * Operations on many jobs, like querying their states, are split by
+     * service and requests to different services may be processed
+     * concurrently. This setting limits the number of services which
+     * are contacted at the same time by single operation.
+     *
+     * If the passed integer is less than or equal to 0 then \c false is
+     * returned and the value is not changed, otherwise \c true is returned.
+     *
+     * The attribute associated with this setter method is 'parallelrequests'.
+     *
+     * @param newParallelRequests maximal number of concurrent requests.
+     * @return \c false in case \a newParallelRequests <= 0, otherwise \c true.
+     * @see ParallelRequests() const
+     * @see DEFAULT_PARALLEL_REQUESTS
+     * \since Added in 6.9.0.
+     **/
+    bool ParallelRequests(int newParallelRequests);
+    /// Get number of services contacted in parallel
+    /**
+     * @return maximal number of concurrent requests.
+     * @see ParallelRequests(int)
+     * @see DEFAULT_PARALLEL_REQUESTS
+     * \since Added in 6.9.0.
+     **/
+    int  ParallelRequests() const { return parallelRequests; }
+
     /// Set verbosity.
     /**
      * The verbosity will be set when invoking this method. If the
@@ -1286,6 +1315,14 @@ namespace Arc {
      **/
     static const int DEFAULT_TIMEOUT = 20;
 
+    /// Default number of services contacted in parallel
+    /**
+     * @see ParallelRequests(int)
+     * @see ParallelRequests() const
+     * \since Added in 6.9.0.
+     **/
+    static const int DEFAULT_PARALLEL_REQUESTS = 10;
+
     /// Default broker
     /**
      * The \a DEFAULT_BROKER specifies the name of the broker which
@@ -1314,6 +1351,7 @@ namespace Arc {
     std::string joblisttype;
 
     int timeout;
+    int parallelRequests;
 
     std::string verbosity;
 
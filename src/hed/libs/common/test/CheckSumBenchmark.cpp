@@ -0,0 +1,85 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+// Measures throughput of checksum implementations available on this CPU
+// over large buffers, and of computing several checksums in one pass
+// through CheckSumAny compared to separate passes.
+// Usage: CheckSumBenchmark [megabytes to process]
+
+#include <cstdlib>
+#include <iostream>
+
+#include <arc/CheckSum.h>
+#include <arc/DateTime.h>
+#include <arc/StringConv.h>
+
+static const unsigned int chunk_size = 1048576;
+
+static double rate(const Arc::Time& start, unsigned long long int bytes) {
+  Arc::Period p = Arc::Time() - start;
+  double seconds = (double)p.GetPeriod() + (double)p.GetPeriodNanoseconds() / 1000000000.0;
+  return (seconds > 0) ? (bytes / 1048576.0 / seconds) : 0;
+}
+
+// Data is taken from buffer bigger than CPU caches in chunks of the size
+// typically used by DataBuffer.
+static double run(Arc::CheckSum& sum, char* data, unsigned long long int size, unsigned long long int total) {
+  Arc::Time start;
+  sum.start();
+  for (unsigned long long int done = 0; done < total; done += chunk_size) {
+    sum.add(data + (done % size), chunk_size);
+  }
+  sum.end();
+  return rate(start, total);
+}
+
+int main(int argc, char **argv) {
+  unsigned long long int megabytes = 2048;
+  if (argc > 1 && !Arc::stringto(argv[1], megabytes)) {
+    std::cerr << "Usage: " << argv[0] << " [megabytes to process]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  unsigned long long int total = megabytes * chunk_size;
+  unsigned long long int size = 256ULL * chunk_size;
+  char* data = new char[size];
+  srand(1);
+  for (unsigned long long int n = 0; n < size; ++n) data[n] = (char)rand();
+
+  const Arc::CheckSumAcceleration levels[] = {
+    Arc::CheckSumBasic, Arc::CheckSumPortable, Arc::CheckSumSSE, Arc::CheckSumAVX2
+  };
+  const char* names[] = { "basic", "portable", "sse", "avx2" };
+  Arc::CheckSumAcceleration best = Arc::GetCheckSumAcceleration();
+  for (int l = 0; l < 4; ++l) {
+    if (levels[l] > best) break;
+    Arc::SetCheckSumAcceleration(levels[l]);
+    Arc::CRC32Sum crc;
+    Arc::Adler32Sum adler;
+    Arc::MD5Sum md5;
+    std::cout << "cksum " << names[l] << ": " << run(crc, data, size, total) << " MB/s" << std::endl;
+    std::cout << "adler32 " << names[l] << ": " << run(adler, data, size, total) << " MB/s" << std::endl;
+    std::cout << "md5 " << names[l] << ": " << run(md5, data, size, total) << " MB/s" << std::endl;
+  }
+  Arc::SetCheckSumAcceleration(best);
+  Arc::SHASum sha1(160);
+  Arc::SHASum sha256(256);
+  std::cout << "sha1: " << run(sha1, data, size, total) << " MB/s" << std::endl;
+  std::cout << "sha256: " << run(sha256, data, size, total) << " MB/s" << std::endl;
+
+  // adler32 + md5 + cksum separately and in one pass
+  Arc::CheckSumAny adler(Arc::CheckSumAny::adler32);
+  Arc::CheckSumAny md5(Arc::CheckSumAny::md5);
+  Arc::CheckSumAny crc(Arc::CheckSumAny::cksum);
+  Arc::Time start;
+  run(adler, data, size, total);
+  run(md5, data, size, total);
+  run(crc, data, size, total);
+  std::cout << "adler32, md5, cksum separately: " << rate(start, total) << " MB/s" << std::endl;
+  Arc::CheckSumAny multi(Arc::CheckSumAny::adler32);
+  multi.AddType(Arc::CheckSumAny::md5);
+  multi.AddType(Arc::CheckSumAny::cksum);
+  std::cout << "adler32, md5, cksum in one pass: " << run(multi, data, size, total) << " MB/s" << std::endl;
+  delete[] data;
+  return EXIT_SUCCESS;
+}
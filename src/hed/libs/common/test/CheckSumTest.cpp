@@ -4,7 +4,9 @@
 #endif
 
 
+#include <cstdlib>
 #include <fstream>
+#include <string>
 
 #include <cppunit/extensions/HelperMacros.h>
 
@@ -17,6 +19,9 @@ class CheckSumTest
   CPPUNIT_TEST(CRC32SumTest);
   CPPUNIT_TEST(MD5SumTest);
   CPPUNIT_TEST(Adler32SumTest);
+  CPPUNIT_TEST(SHASumTest);
+  CPPUNIT_TEST(AccelerationTest);
+  CPPUNIT_TEST(MultiSumTest);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -26,8 +31,24 @@ public:
   void CRC32SumTest();
   void MD5SumTest();
   void Adler32SumTest();
+  void SHASumTest();
+  void AccelerationTest();
+  void MultiSumTest();
 };
 
+static std::string compute(Arc::CheckSum& sum, const std::string& data, std::string::size_type piece) {
+  sum.start();
+  for (std::string::size_type p = 0; p < data.length(); p += piece) {
+    std::string::size_type l = data.length() - p;
+    if (l > piece) l = piece;
+    sum.add((void*)(data.c_str() + p), l);
+  }
+  sum.end();
+  char buf[256];
+  sum.print(buf, sizeof(buf));
+  return buf;
+}
+
 
 void CheckSumTest::setUp() {
   std::ofstream f1K("CheckSumTest.f1K.data", std::ios::out), f1M("CheckSumTest.f1M.data", std::ios::out);
@@ -77,4 +98,71 @@ void CheckSumTest::Adler32SumTest() {
   //CPPUNIT_ASSERT_EQUAL((std::string)"adler32:471b96e5", (std::string)buf);
 }
 
+void CheckSumTest::SHASumTest() {
+  CPPUNIT_ASSERT_EQUAL((std::string)"88eaec963a0368e8854562e824b7fe2fdd3db8d1", Arc::CheckSumAny::FileChecksum("CheckSumTest.f1K.data", Arc::CheckSumAny::sha1));
+  CPPUNIT_ASSERT_EQUAL(Arc::CheckSumAny::sha256, Arc::CheckSumAny::Type("sha256:00"));
+  char buf[256];
+  Arc::CheckSumAny ck(Arc::CheckSumAny::sha256);
+  ck.scan("sha256:cec1a43d57fc5824b11ba6f53b270b2ed35d1ba05236c1a8906d4c5561b2cc7a");
+  ck.print(buf, sizeof(buf));
+  CPPUNIT_ASSERT_EQUAL((std::string)"sha256:cec1a43d57fc5824b11ba6f53b270b2ed35d1ba05236c1a8906d4c5561b2cc7a", (std::string)buf);
+
+  // Longest digest must not be truncated anywhere on the way
+  CPPUNIT_ASSERT_EQUAL((std::string)"8b38d52d0ff170a4d1bab43ca708a29dc42e80bb09d13259bbe5e0dfe5ace2aea81b131de703ebf2d5bfee14f009f89854406c00ade771f2ac161b8ecfd7ab2c", Arc::CheckSumAny::FileChecksum("CheckSumTest.f1M.data", Arc::CheckSumAny::sha512));
+  char buf512[Arc::CheckSum::MaxPrintLength];
+  Arc::CheckSumAny ck512(Arc::CheckSumAny::sha512);
+  ck512.scan("sha512:d0cbb26dc647c0e29c72ab7695818a160820164609253563369b77e22419bb0eb95b8225a890186b54951124fa4dd8e663cc6d474fcad0ec336ffb9c38fbb729");
+  ck512.print(buf512, sizeof(buf512));
+  CPPUNIT_ASSERT_EQUAL((std::string)"sha512:d0cbb26dc647c0e29c72ab7695818a160820164609253563369b77e22419bb0eb95b8225a890186b54951124fa4dd8e663cc6d474fcad0ec336ffb9c38fbb729", (std::string)buf512);
+}
+
+void CheckSumTest::AccelerationTest() {
+  // All implementations must give same results for any split of data
+  std::string data;
+  data.resize(1000003);
+  srand(1);
+  for (std::string::size_type n = 0; n < data.length(); ++n) data[n] = (char)rand();
+  Arc::CheckSumAcceleration saved = Arc::GetCheckSumAcceleration();
+  const Arc::CheckSumAcceleration levels[] = { Arc::CheckSumBasic, Arc::CheckSumPortable, Arc::CheckSumSSE, Arc::CheckSumAVX2 };
+  const std::string::size_type pieces[] = { 1, 7, 63, 64, 4097, 1000003 };
+  std::string crc, adler, md5;
+  for (int l = 0; l < 4; ++l) {
+    if (Arc::SetCheckSumAcceleration(levels[l]) != levels[l]) continue;
+    for (int p = 0; p < 6; ++p) {
+      Arc::CRC32Sum c;
+      Arc::Adler32Sum a;
+      Arc::MD5Sum m;
+      std::string c_res = compute(c, data, pieces[p]);
+      std::string a_res = compute(a, data, pieces[p]);
+      std::string m_res = compute(m, data, pieces[p]);
+      if (crc.empty()) {
+        crc = c_res; adler = a_res; md5 = m_res;
+      }
+      CPPUNIT_ASSERT_EQUAL(crc, c_res);
+      CPPUNIT_ASSERT_EQUAL(adler, a_res);
+      CPPUNIT_ASSERT_EQUAL(md5, m_res);
+    }
+  }
+  Arc::SetCheckSumAcceleration(saved);
+}
+
+void CheckSumTest::MultiSumTest() {
+  std::string data(3000000, '0');
+  Arc::CheckSumAny ck(Arc::CheckSumAny::adler32);
+  CPPUNIT_ASSERT(ck.AddType(Arc::CheckSumAny::md5));
+  CPPUNIT_ASSERT(ck.AddType(Arc::CheckSumAny::cksum));
+  CPPUNIT_ASSERT(!ck.AddType(Arc::CheckSumAny::unknown));
+  CPPUNIT_ASSERT(!ck.Get(Arc::CheckSumAny::sha1));
+  std::string res = compute(ck, data, data.length());
+  Arc::Adler32Sum a;
+  Arc::MD5Sum m;
+  Arc::CRC32Sum c;
+  CPPUNIT_ASSERT_EQUAL(compute(a, data, 1000), res);
+  char buf[256];
+  ck.Get(Arc::CheckSumAny::md5)->print(buf, sizeof(buf));
+  CPPUNIT_ASSERT_EQUAL(compute(m, data, 1000), (std::string)buf);
+  ck.Get(Arc::CheckSumAny::cksum)->print(buf, sizeof(buf));
+  CPPUNIT_ASSERT_EQUAL(compute(c, data, 1000), (std::string)buf);
+}
+
 CPPUNIT_TEST_SUITE_REGISTRATION(CheckSumTest);
@@ -18,6 +18,8 @@ class LoggerTest
   CPPUNIT_TEST(TestLoggerVERBOSE);
   CPPUNIT_TEST(TestLoggerTHREAD);
   CPPUNIT_TEST(TestLoggerDEFAULT);
+  CPPUNIT_TEST(TestLoggerQUEUE);
+  CPPUNIT_TEST(TestLoggerINHERIT);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -28,6 +30,8 @@ public:
   void TestLoggerVERBOSE();
   void TestLoggerTHREAD();
   void TestLoggerDEFAULT();
+  void TestLoggerQUEUE();
+  void TestLoggerINHERIT();
 
 private:
   std::stringstream stream;
@@ -121,4 +125,46 @@ void LoggerTest::TestLoggerDEFAULT() {
   CPPUNIT_ASSERT_EQUAL(bad_level, default_level);
 }
 
+void LoggerTest::TestLoggerQUEUE() {
+  std::string res;
+  std::stringstream stream_queue;
+  Arc::LogStream output_queue(stream_queue);
+  Arc::LogQueue queue(output_queue, 16, true);
+  Arc::Logger::getRootLogger().removeDestinations();
+  Arc::Logger::getRootLogger().addDestination(queue);
+  for (int n = 0; n < 100; ++n) {
+    logger->msg(Arc::INFO, "Queued message %i", n);
+  }
+  logger->msg(Arc::INFO, "Last queued message");
+  queue.flush();
+  Arc::Logger::getRootLogger().removeDestinations();
+  res = stream_queue.str();
+  CPPUNIT_ASSERT(res.find("Queued message 99\n") != std::string::npos);
+  res = res.substr(res.rfind(']') + 2);
+  CPPUNIT_ASSERT_EQUAL(std::string("Last queued message\n"), res);
+  CPPUNIT_ASSERT_EQUAL(0ULL, queue.getDropped());
+  CPPUNIT_ASSERT(stream.str().empty());
+}
+
+void LoggerTest::TestLoggerINHERIT() {
+  std::string res;
+  Arc::Logger child(*logger, "Child");
+  // Lower threshold of unrelated logger has no effect
+  Arc::Logger other(Arc::Logger::getRootLogger(), "Other", Arc::DEBUG);
+  child.msg(Arc::VERBOSE, "This VERBOSE message should not be seen");
+  CPPUNIT_ASSERT(stream.str().empty());
+
+  // Change of parent's threshold is noticed by child
+  logger->setThreshold(Arc::VERBOSE);
+  child.msg(Arc::VERBOSE, "This VERBOSE message should now be seen");
+  res = stream.str();
+  res = res.substr(res.rfind(']') + 2);
+  CPPUNIT_ASSERT_EQUAL(std::string("This VERBOSE message should now be seen\n"), res);
+  stream.str("");
+
+  child.setThreshold(Arc::ERROR);
+  child.msg(Arc::WARNING, "This WARNING message should not be seen");
+  CPPUNIT_ASSERT(stream.str().empty());
+}
+
 CPPUNIT_TEST_SUITE_REGISTRATION(LoggerTest);
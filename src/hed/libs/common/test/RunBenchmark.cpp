@@ -0,0 +1,72 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+// Measures time needed to start short process through Arc::Run in a
+// process with big resident memory and high limit of open files, like
+// A-REX serving many jobs. Process started with initializer has to be
+// forked, while without initializer it can be started with vfork().
+// Usage: RunBenchmark [megabytes of memory [number of processes]]
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <sys/resource.h>
+
+#include <arc/DateTime.h>
+#include <arc/Run.h>
+#include <arc/StringConv.h>
+
+static double rate(const Arc::Time& start, unsigned int count) {
+  Arc::Period p = Arc::Time() - start;
+  double seconds = (double)p.GetPeriod() + (double)p.GetPeriodNanoseconds() / 1000000000.0;
+  return (count > 0) ? (seconds * 1000.0 / count) : 0;
+}
+
+static void initializer(void*) {
+}
+
+static double run(unsigned int count, bool with_initializer) {
+  Arc::Time start;
+  for (unsigned int n = 0; n < count; ++n) {
+    Arc::Run run("/bin/true");
+    run.KeepStdin(true);
+    run.KeepStdout(true);
+    run.KeepStderr(true);
+    if (with_initializer) run.AssignInitializer(&initializer, NULL);
+    if (!run.Start() || !run.Wait(60) || (run.Result() != 0)) {
+      std::cerr << "Failed to run /bin/true" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+  return rate(start, count);
+}
+
+int main(int argc, char **argv) {
+  unsigned long long int megabytes = 4096;
+  unsigned int count = 1000;
+  if ((argc > 1 && !Arc::stringto(argv[1], megabytes)) ||
+      (argc > 2 && !Arc::stringto(argv[2], count))) {
+    std::cerr << "Usage: " << argv[0] << " [megabytes of memory [number of processes]]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  struct rlimit lim;
+  if (getrlimit(RLIMIT_NOFILE, &lim) == 0) {
+    lim.rlim_cur = lim.rlim_max;
+    if (lim.rlim_cur == RLIM_INFINITY) lim.rlim_cur = 1048576;
+    (void)setrlimit(RLIMIT_NOFILE, &lim);
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0)
+      std::cout << "open files limit: " << lim.rlim_cur << std::endl;
+  }
+  // Memory is written to make it resident
+  unsigned long long int size = megabytes * 1048576ULL;
+  char* data = new char[size];
+  memset(data, 1, size);
+  std::cout << "resident memory: " << megabytes << " MB" << std::endl;
+
+  std::cout << "with initializer: " << run(count, true) << " ms per process" << std::endl;
+  std::cout << "without initializer: " << run(count, false) << " ms per process" << std::endl;
+  delete[] data;
+  return EXIT_SUCCESS;
+}
@@ -6,9 +6,11 @@
 
 #include <unistd.h>
 #include <string>
+#include <fstream>
 
 #include <cppunit/extensions/HelperMacros.h>
 
+#include <arc/FileUtils.h>
 #include <arc/Run.h>
 #include <arc/User.h>
 #include <arc/Utils.h>
@@ -19,6 +21,7 @@ class RunTest
   CPPUNIT_TEST_SUITE(RunTest);
   CPPUNIT_TEST(TestRun0);
   CPPUNIT_TEST(TestRun255);
+  CPPUNIT_TEST(TestRunRedirect);
   CPPUNIT_TEST(TestRunMany);
   CPPUNIT_TEST_SUITE_END();
 
@@ -27,6 +30,7 @@ public:
   void tearDown();
   void TestRun0();
   void TestRun255();
+  void TestRunRedirect();
   void TestRunMany();
 
 private:
@@ -77,6 +81,31 @@ void RunTest::TestRun255() {
   CPPUNIT_ASSERT_EQUAL(255, run.Result());
 }
 
+static std::string read_file(const std::string& path) {
+  std::ifstream f(path.c_str());
+  std::string content;
+  std::getline(f, content);
+  return content;
+}
+
+void RunTest::TestRunRedirect() {
+  std::string tmpdir;
+  CPPUNIT_ASSERT(Arc::TmpDirCreate(tmpdir));
+  // Output is appended to existing file
+  CPPUNIT_ASSERT(Arc::FileCreate(tmpdir + "/out", "OLD"));
+  Arc::Run run(srcdir + "/rcode 0");
+  run.RedirectStdin("/dev/null");
+  run.RedirectStdout(tmpdir + "/out");
+  run.RedirectStderr(tmpdir + "/err");
+  CPPUNIT_ASSERT((bool)run);
+  CPPUNIT_ASSERT(run.Start());
+  CPPUNIT_ASSERT(run.Wait(10));
+  CPPUNIT_ASSERT_EQUAL(0, run.Result());
+  CPPUNIT_ASSERT_EQUAL(std::string("OLDSTDOUT"), read_file(tmpdir + "/out"));
+  CPPUNIT_ASSERT_EQUAL(std::string("STDERR"), read_file(tmpdir + "/err"));
+  Arc::DirDelete(tmpdir);
+}
+
 class RunH {
  public:
   unsigned long long int cnt;
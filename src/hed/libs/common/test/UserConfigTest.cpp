@@ -331,6 +331,7 @@ void UserConfigTest::SaveToFileTest()
     "rejectmanagement = bad3.service.org\n"
     "rejectmanagement = bad4.service.org\n"
     "timeout = 50\n"
+    "parallelrequests = 20\n"
     "brokername = FastestQueue\n"
     "brokerarguments = arg\n"
     "vomsespath = /home/user/vomses\n"
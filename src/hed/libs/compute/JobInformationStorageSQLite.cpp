@@ -4,6 +4,11 @@
 #include <config.h>
 #endif
 
+#include <errno.h>
+#if HAVE_SYS_VFS_H
+#include <sys/vfs.h>
+#endif
+
 #include <arc/FileUtils.h>
 #include <arc/Logger.h>
 #include <arc/StringConv.h>
@@ -67,15 +72,26 @@ namespace Arc {
     val = Arc::Time(Arc::unescape_chars(str, sql_escape_char,sql_escape_type));
   }
 
-  int sqlite3_exec_nobusy(sqlite3* db, const char *sql, int (*callback)(void*,int,char**,char**), void *arg, char **errmsg) {
-    int err;
-    while((err = sqlite3_exec(db, sql, callback, arg, errmsg)) == SQLITE_BUSY) {
-      // Access to database is designed in such way that it should not block for long time.
-      // So it should be safe to simply wait for lock to be released without any timeout.
-      struct timespec delay = { 0, 10000000 }; // 0.01s - should be enough for most cases
-      (void)::nanosleep(&delay, NULL);
-    };
-    return err;
+  // Access to database is designed in such way that it should not block for long time.
+  // So it should be safe to simply wait for lock to be released without any timeout.
+  // Waiting is done by SQLite inside the blocked call instead of repeating whole
+  // command, hence partially executed commands are never repeated.
+  static int JobDBBusyHandler(void*, int count) {
+    (void)sqlite3_sleep((count < 10) ? (count + 1) : 10); // up to 0.01s
+    return 1;
+  }
+
+  inline static void sql_bind(sqlite3_stmt* stmt, int& idx, const std::string& str) {
+    (void)sqlite3_bind_text(stmt, ++idx, str.c_str(), str.length(), SQLITE_TRANSIENT);
+  }
+
+  inline static bool sql_column(sqlite3_stmt* stmt, int idx, std::string& str) {
+    // Databases of older versions have fewer columns
+    if(idx >= sqlite3_column_count(stmt)) return false;
+    const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, idx));
+    if(!text) return false;
+    str.assign(text, sqlite3_column_bytes(stmt, idx));
+    return true;
   }
 
   #define JOBS_COLUMNS_OLD \
@@ -100,28 +116,52 @@ namespace Arc {
             "workingareaerasetime, proxyexpirationtime, submissionhost, submissionclienttime, " \
             "othermessages, activityoldid"
 
- 
-  JobInformationStorageSQLite::JobDB::JobDB(const std::string& name, bool create): jobDB(NULL)
+  // Write-ahead log needs shared memory which does not work over network
+  // file systems. If file system can't be identified WAL is not used either.
+  static bool IsLocalFileSystem(const std::string& name) {
+#if HAVE_SYS_VFS_H
+    struct statfs stfs;
+    if (statfs(Glib::path_get_dirname(name).c_str(), &stfs) != 0) return false;
+    switch ((unsigned long)stfs.f_type) {
+      case 0x6969UL:     // NFS
+      case 0x517BUL:     // SMB
+      case 0xFF534D42UL: // CIFS
+      case 0xFE534D42UL: // SMB2
+      case 0x564CUL:     // NCP
+      case 0x5346414FUL: // AFS
+      case 0x6B414653UL: // kAFS
+      case 0x73757245UL: // CODA
+      case 0x01021997UL: // 9P
+      case 0x65735546UL: // FUSE (sshfs and alike)
+      case 0x00C36400UL: // CephFS
+      case 0x0BD00BD0UL: // Lustre
+      case 0x47504653UL: // GPFS
+        return false;
+      default:
+        break;
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  JobInformationStorageSQLite::JobDB::JobDB(const std::string& name, bool create): jobDB(NULL), allColumns(true)
   {
     int err;
     int flags = SQLITE_OPEN_READWRITE; // it will open read-only if access is protected
     if(create) flags |= SQLITE_OPEN_CREATE;
 
-    while((err = sqlite3_open_v2(name.c_str(), &jobDB, flags, NULL)) == SQLITE_BUSY) {
-      // In case something prevents database from open right now - retry
-      if(jobDB) (void)sqlite3_close(jobDB);
-      jobDB = NULL;
-      struct timespec delay = { 0, 10000000 }; // 0.01s - should be enough for most cases
-      (void)::nanosleep(&delay, NULL);
-    }
+    err = sqlite3_open_v2(name.c_str(), &jobDB, flags, NULL);
     if(err != SQLITE_OK) {
       handleError(NULL, err);
       tearDown();
       throw SQLiteException(IString("Unable to create data base (%s)", name).str(), err);
     }
+    (void)sqlite3_busy_handler(jobDB, &JobDBBusyHandler, NULL);
 
     if(create) {
-      err = sqlite3_exec_nobusy(jobDB, "CREATE TABLE IF NOT EXISTS jobs(" JOBS_COLUMNS ", UNIQUE(id))", NULL, NULL, NULL);   
+      err = sqlite3_exec(jobDB, "CREATE TABLE IF NOT EXISTS jobs(" JOBS_COLUMNS ", UNIQUE(id))", NULL, NULL, NULL);   
       if(err != SQLITE_OK) {
         handleError(NULL, err);
         tearDown();
@@ -130,25 +170,25 @@ namespace Arc {
       err = sqlite3_table_column_metadata(jobDB, NULL, "jobs", "activityoldid", NULL, NULL, NULL, NULL, NULL);
       if(err != SQLITE_OK) {
         // No latest column => recreate table
-        err = sqlite3_exec_nobusy(jobDB, "CREATE TABLE IF NOT EXISTS jobs_new(" JOBS_COLUMNS ", UNIQUE(id))", NULL, NULL, NULL);   
+        err = sqlite3_exec(jobDB, "CREATE TABLE IF NOT EXISTS jobs_new(" JOBS_COLUMNS ", UNIQUE(id))", NULL, NULL, NULL);   
         if(err != SQLITE_OK) {
           handleError(NULL, err);
           tearDown();
           throw SQLiteException(IString("Unable to create jobs_new table in data base (%s)", name).str(), err);
         }
-        err = sqlite3_exec_nobusy(jobDB, "INSERT INTO jobs_new (" JOBS_COLUMNS_OLD ") SELECT " JOBS_COLUMNS_OLD " FROM jobs", NULL, NULL, NULL);   
+        err = sqlite3_exec(jobDB, "INSERT INTO jobs_new (" JOBS_COLUMNS_OLD ") SELECT " JOBS_COLUMNS_OLD " FROM jobs", NULL, NULL, NULL);   
         if(err != SQLITE_OK) {
           handleError(NULL, err);
           tearDown();
           throw SQLiteException(IString("Unable to transfer from jobs to jobs_new in data base (%s)", name).str(), err);
         }
-        err = sqlite3_exec_nobusy(jobDB, "DROP TABLE jobs", NULL, NULL, NULL);   
+        err = sqlite3_exec(jobDB, "DROP TABLE jobs", NULL, NULL, NULL);   
         if(err != SQLITE_OK) {
           handleError(NULL, err);
           tearDown();
           throw SQLiteException(IString("Unable to drop jobs in data base (%s)", name).str(), err);
         }
-        err = sqlite3_exec_nobusy(jobDB, "ALTER TABLE jobs_new RENAME TO jobs", NULL, NULL, NULL);   
+        err = sqlite3_exec(jobDB, "ALTER TABLE jobs_new RENAME TO jobs", NULL, NULL, NULL);   
         if(err != SQLITE_OK) {
           handleError(NULL, err);
           tearDown();
@@ -156,7 +196,7 @@ namespace Arc {
         }
       }
 
-      err = sqlite3_exec_nobusy(jobDB,
+      err = sqlite3_exec(jobDB,
           "CREATE INDEX IF NOT EXISTS serviceinformationhost ON jobs(serviceinformationhost)",
            NULL, NULL, NULL);   
       if(err != SQLITE_OK) {
@@ -164,19 +204,51 @@ namespace Arc {
         tearDown();
         throw SQLiteException(IString("Unable to create index for jobs table in data base (%s)", name).str(), err);
       }
+      // Indices for selecting jobs by name and by endpoint. Id is indexed because it is unique.
+      err = sqlite3_exec(jobDB,
+          "CREATE INDEX IF NOT EXISTS name ON jobs(name)",
+           NULL, NULL, NULL);
+      if(err == SQLITE_OK) {
+        err = sqlite3_exec(jobDB,
+            "CREATE INDEX IF NOT EXISTS managementurl ON jobs(managementurl)",
+             NULL, NULL, NULL);
+      }
+      if(err != SQLITE_OK) {
+        handleError(NULL, err);
+        tearDown();
+        throw SQLiteException(IString("Unable to create index for jobs table in data base (%s)", name).str(), err);
+      }
+      // With write-ahead log readers are not blocked by writer. Mode is stored
+      // in database, so it is enough to set it when writing. On network file
+      // systems default mode is restored in case database was moved there.
+      // Failure is not critical - database works in previous mode then.
+      err = sqlite3_exec(jobDB, IsLocalFileSystem(name) ? "PRAGMA journal_mode=WAL" : "PRAGMA journal_mode=DELETE", NULL, NULL, NULL);
+      if(err != SQLITE_OK) {
+        handleError("Failed to set journal mode", err);
+      }
     } else {
       // SQLite opens database in lazy way. But we still want to know if it is good database.
-      err = sqlite3_exec_nobusy(jobDB, "PRAGMA schema_version;", NULL, NULL, NULL);
+      err = sqlite3_exec(jobDB, "PRAGMA schema_version;", NULL, NULL, NULL);
       if(err != SQLITE_OK) {
         handleError(NULL, err);
         tearDown();
         throw SQLiteException(IString("Failed checking database (%s)", name).str(), err);
       }
+      // Database written by older version is converted only when written next time.
+      // Till then only columns it has are read.
+      if(sqlite3_table_column_metadata(jobDB, NULL, "jobs", "activityoldid", NULL, NULL, NULL, NULL, NULL) != SQLITE_OK) {
+        allColumns = false;
+      }
       JobInformationStorageSQLite::logger.msg(DEBUG, "Job database connection established successfully (%s)", name);
     }
   }
 
   void JobInformationStorageSQLite::JobDB::tearDown() {
+    for (std::map<std::string, sqlite3_stmt*>::iterator it = statements.begin();
+         it != statements.end(); ++it) {
+      (void)sqlite3_finalize(it->second);
+    }
+    statements.clear();
     if (jobDB) {
       (void)sqlite3_close(jobDB);
       jobDB = NULL;
@@ -187,6 +259,51 @@ namespace Arc {
     tearDown();
   }
 
+  const char* JobInformationStorageSQLite::JobDB::columns() const {
+    return allColumns ? JOBS_COLUMNS : JOBS_COLUMNS_OLD;
+  }
+
+  sqlite3_stmt* JobInformationStorageSQLite::JobDB::statement(const std::string& sql) {
+    std::map<std::string, sqlite3_stmt*>::iterator it = statements.find(sql);
+    if (it != statements.end()) {
+      (void)sqlite3_reset(it->second);
+      (void)sqlite3_clear_bindings(it->second);
+      return it->second;
+    }
+    sqlite3_stmt* stmt = NULL;
+    int err = sqlite3_prepare_v2(jobDB, sql.c_str(), sql.length(), &stmt, NULL);
+    if (err != SQLITE_OK) {
+      handleError("Failed to prepare statement", err);
+      if (stmt) (void)sqlite3_finalize(stmt);
+      return NULL;
+    }
+    statements[sql] = stmt;
+    return stmt;
+  }
+
+  bool JobInformationStorageSQLite::JobDB::begin() {
+    int err = sqlite3_exec(jobDB, "BEGIN IMMEDIATE", NULL, NULL, NULL);
+    if (err != SQLITE_OK) {
+      handleError("Failed to start transaction", err);
+      return false;
+    }
+    return true;
+  }
+
+  bool JobInformationStorageSQLite::JobDB::commit() {
+    // Statements may still hold read locks
+    for (std::map<std::string, sqlite3_stmt*>::iterator it = statements.begin();
+         it != statements.end(); ++it) {
+      (void)sqlite3_reset(it->second);
+    }
+    int err = sqlite3_exec(jobDB, "COMMIT", NULL, NULL, NULL);
+    if (err != SQLITE_OK) {
+      handleError("Failed to commit transaction", err);
+      return false;
+    }
+    return true;
+  }
+
   void JobInformationStorageSQLite::JobDB::handleError(const char* errpfx, int err) {
 #ifdef HAVE_SQLITE3_ERRSTR
     std::string msg = sqlite3_errstr(err);
@@ -242,21 +359,152 @@ namespace Arc {
     isStorageExisting = isValid = true;
   }
 
-  struct ListJobsCallbackArg {
-    std::list<std::string>& ids;
-    ListJobsCallbackArg(std::list<std::string>& ids):ids(ids) { };
-  };
+  // Builds command for storing all columns of job with values passed as parameters
+  static std::string JobsWriteCommand(const std::string& command) {
+    std::string columns(JOBS_COLUMNS);
+    std::string sqlcmd = command + " INTO jobs(" + columns + ") VALUES (?";
+    for (std::string::size_type pos = columns.find(','); pos != std::string::npos; pos = columns.find(',', pos+1)) {
+      sqlcmd += ", ?";
+    }
+    return sqlcmd + ")";
+  }
 
-  static int ListJobsCallback(void* arg, int colnum, char** texts, char** names) {
-    ListJobsCallbackArg& carg = *reinterpret_cast<ListJobsCallbackArg*>(arg);
-    for(int n = 0; n < colnum; ++n) {
-      if(names[n] && texts[n]) {
-        if(strcmp(names[n], "id") == 0) {
-          carg.ids.push_back(texts[n]);
-        }
-      }
+  // Order of parameters must follow JOBS_COLUMNS
+  static void BindJob(sqlite3_stmt* stmt, const Job& job) {
+    int idx = 0;
+    sql_bind(stmt, idx, sql_escape(job.JobID));
+    sql_bind(stmt, idx, sql_escape(job.IDFromEndpoint));
+    sql_bind(stmt, idx, sql_escape(job.Name));
+    sql_bind(stmt, idx, sql_escape(job.JobStatusInterfaceName));
+    sql_bind(stmt, idx, sql_escape(job.JobStatusURL.fullstr()));
+    sql_bind(stmt, idx, sql_escape(job.JobManagementInterfaceName));
+    sql_bind(stmt, idx, sql_escape(job.JobManagementURL.fullstr()));
+    sql_bind(stmt, idx, sql_escape(job.ServiceInformationInterfaceName));
+    sql_bind(stmt, idx, sql_escape(job.ServiceInformationURL.fullstr()));
+    sql_bind(stmt, idx, sql_escape(job.ServiceInformationURL.Host()));
+    sql_bind(stmt, idx, sql_escape(job.SessionDir.fullstr()));
+    sql_bind(stmt, idx, sql_escape(job.StageInDir.fullstr()));
+    sql_bind(stmt, idx, sql_escape(job.StageOutDir.fullstr()));
+    sql_bind(stmt, idx, sql_escape(job.JobDescriptionDocument));
+    sql_bind(stmt, idx, sql_escape(tostring(job.LocalSubmissionTime.GetTime())));
+    sql_bind(stmt, idx, sql_escape(job.DelegationID));
+    // attributes available after code update
+    sql_bind(stmt, idx, sql_escape(job.Type));
+    sql_bind(stmt, idx, sql_escape(job.LocalIDFromManager));
+    sql_bind(stmt, idx, sql_escape(job.JobDescription));
+    sql_bind(stmt, idx, sql_escape(job.State.GetGeneralState()));
+    sql_bind(stmt, idx, sql_escape(job.RestartState.GetGeneralState()));
+    sql_bind(stmt, idx, sql_escape(job.ExitCode));
+    sql_bind(stmt, idx, sql_escape(job.ComputingManagerExitCode));
+    sql_bind(stmt, idx, sql_escape(job.Error));
+    sql_bind(stmt, idx, sql_escape(job.WaitingPosition));
+    sql_bind(stmt, idx, sql_escape(job.UserDomain));
+    sql_bind(stmt, idx, sql_escape(job.Owner));
+    sql_bind(stmt, idx, sql_escape(job.LocalOwner));
+    sql_bind(stmt, idx, sql_escape(job.RequestedTotalWallTime));
+    sql_bind(stmt, idx, sql_escape(job.RequestedTotalCPUTime));
+    sql_bind(stmt, idx, sql_escape(job.RequestedSlots));
+    sql_bind(stmt, idx, sql_escape(job.RequestedApplicationEnvironment));
+    sql_bind(stmt, idx, sql_escape(job.StdIn));
+    sql_bind(stmt, idx, sql_escape(job.StdOut));
+    sql_bind(stmt, idx, sql_escape(job.StdErr));
+    sql_bind(stmt, idx, sql_escape(job.LogDir));
+    sql_bind(stmt, idx, sql_escape(job.ExecutionNode));
+    sql_bind(stmt, idx, sql_escape(job.Queue));
+    sql_bind(stmt, idx, sql_escape(job.UsedTotalWallTime));
+    sql_bind(stmt, idx, sql_escape(job.UsedTotalCPUTime));
+    sql_bind(stmt, idx, sql_escape(job.UsedMainMemory));
+    sql_bind(stmt, idx, sql_escape(job.SubmissionTime));
+    sql_bind(stmt, idx, sql_escape(job.ComputingManagerSubmissionTime));
+    sql_bind(stmt, idx, sql_escape(job.StartTime));
+    sql_bind(stmt, idx, sql_escape(job.ComputingManagerEndTime));
+    sql_bind(stmt, idx, sql_escape(job.EndTime));
+    sql_bind(stmt, idx, sql_escape(job.WorkingAreaEraseTime));
+    sql_bind(stmt, idx, sql_escape(job.ProxyExpirationTime));
+    sql_bind(stmt, idx, sql_escape(job.SubmissionHost));
+    sql_bind(stmt, idx, sql_escape(job.SubmissionClientName));
+    sql_bind(stmt, idx, sql_escape(job.OtherMessages));
+    sql_bind(stmt, idx, sql_escape(job.ActivityOldID));
+  }
+
+  // Order of columns must follow JOBS_COLUMNS. Missing trailing columns are skipped.
+  static void ReadJob(sqlite3_stmt* stmt, Job& job) {
+    int idx = 0;
+    std::string text;
+    if(sql_column(stmt, idx++, text)) job.JobID = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.IDFromEndpoint = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.Name = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.JobStatusInterfaceName = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.JobStatusURL = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.JobManagementInterfaceName = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.JobManagementURL = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.ServiceInformationInterfaceName = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.ServiceInformationURL = sql_unescape(text);
+    ++idx; // serviceinformationhost is derived from serviceinformationurl
+    if(sql_column(stmt, idx++, text)) job.SessionDir = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.StageInDir = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.StageOutDir = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.JobDescriptionDocument = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.LocalSubmissionTime.SetTime(stringtoi(sql_unescape(text)));
+    if(sql_column(stmt, idx++, text)) job.DelegationID.push_back(sql_unescape(text));
+    // attributs available after code update
+    if(sql_column(stmt, idx++, text)) job.Type = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.LocalIDFromManager = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.JobDescription = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.State = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.RestartState = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) sql_unescape(text, job.ExitCode);
+    if(sql_column(stmt, idx++, text)) sql_unescape(text, job.ComputingManagerExitCode);
+    if(sql_column(stmt, idx++, text)) sql_unescape(text, job.Error);
+    if(sql_column(stmt, idx++, text)) sql_unescape(text, job.WaitingPosition);
+    if(sql_column(stmt, idx++, text)) job.UserDomain = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.Owner = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.LocalOwner = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) sql_unescape(text, job.RequestedTotalWallTime);
+    if(sql_column(stmt, idx++, text)) sql_unescape(text, job.RequestedTotalCPUTime);
+    if(sql_column(stmt, idx++, text)) sql_unescape(text, job.RequestedSlots);
+    if(sql_column(stmt, idx++, text)) sql_unescape(text, job.RequestedApplicationEnvironment);
+    if(sql_column(stmt, idx++, text)) job.StdIn = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.StdOut = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.StdErr = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.LogDir = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) sql_unescape(text, job.ExecutionNode);
+    if(sql_column(stmt, idx++, text)) job.Queue = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.UsedTotalWallTime = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.UsedTotalCPUTime = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) sql_unescape(text, job.UsedMainMemory);
+    if(sql_column(stmt, idx++, text)) sql_unescape(text, job.SubmissionTime);
+    if(sql_column(stmt, idx++, text)) sql_unescape(text, job.ComputingManagerSubmissionTime);
+    if(sql_column(stmt, idx++, text)) sql_unescape(text, job.StartTime);
+    if(sql_column(stmt, idx++, text)) sql_unescape(text, job.ComputingManagerEndTime);
+    if(sql_column(stmt, idx++, text)) sql_unescape(text, job.EndTime);
+    if(sql_column(stmt, idx++, text)) sql_unescape(text, job.WorkingAreaEraseTime);
+    if(sql_column(stmt, idx++, text)) sql_unescape(text, job.ProxyExpirationTime);
+    if(sql_column(stmt, idx++, text)) job.SubmissionHost = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) job.SubmissionClientName = sql_unescape(text);
+    if(sql_column(stmt, idx++, text)) sql_unescape(text, job.OtherMessages);
+    if(sql_column(stmt, idx++, text)) sql_unescape(text, job.ActivityOldID);
+  }
+
+  static bool MatchesEndpoints(const URL& url, const std::list<std::string>& endpoints) {
+    for (std::list<std::string>::const_iterator it = endpoints.begin();
+             it != endpoints.end(); ++it) {
+      if (url.StringMatches(*it)) return true;
     }
-    return 0;
+    return false;
+  }
+
+  // Collects row ids of jobs with column equal to specified value
+  static bool SelectRows(sqlite3_stmt* stmt, const std::string& value, std::set<sqlite3_int64>& rows) {
+    int idx = 0;
+    sql_bind(stmt, idx, sql_escape(value));
+    bool found = false;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      rows.insert(sqlite3_column_int64(stmt, 0));
+      found = true;
+    }
+    (void)sqlite3_reset(stmt);
+    return found;
   }
 
   bool JobInformationStorageSQLite::Write(const std::list<Job>& jobs, const std::set<std::string>& prunedServices, std::list<const Job*>& newJobs) {
@@ -265,109 +513,70 @@ namespace Arc {
     }
     if (jobs.empty()) return true;
     
+    std::list<const Job*>::size_type nNewJobs = newJobs.size();
     try {
       JobDB db(name, true);
+      // All changes are done in single transaction. That is much faster and
+      // if anything fails database is left unchanged.
+      if (!db.begin()) return false;
       // Identify jobs to remove
-      std::list<std::string> prunedIds;
-      ListJobsCallbackArg prunedArg(prunedIds);
-      for (std::set<std::string>::const_iterator itPruned = prunedServices.begin();
-           itPruned != prunedServices.end(); ++itPruned) {
-        std::string sqlcmd = "SELECT id FROM jobs WHERE (serviceinformationhost = '" + *itPruned + "')";
-        (void)sqlite3_exec_nobusy(db.handle(), sqlcmd.c_str(), &ListJobsCallback, &prunedArg, NULL);
+      std::set<std::string> writtenIds;
+      for (std::list<Job>::const_iterator it = jobs.begin(); it != jobs.end(); ++it) {
+        writtenIds.insert(it->JobID);
       }
-      // Filter out jobs to be modified
-      if(!jobs.empty()) {
-        for(std::list<std::string>::iterator itId = prunedIds.begin(); itId != prunedIds.end();) {
-          bool found = false;
-          for (std::list<Job>::const_iterator it = jobs.begin(); it != jobs.end(); ++it) {
-            if(it->JobID == *itId) {
-              found = true;
-              break;
+      std::list<std::string> prunedIds;
+      if (!prunedServices.empty()) {
+        sqlite3_stmt* stmt = db.statement("SELECT id FROM jobs WHERE (serviceinformationhost = ?)");
+        if (!stmt) return false;
+        for (std::set<std::string>::const_iterator itPruned = prunedServices.begin();
+             itPruned != prunedServices.end(); ++itPruned) {
+          int idx = 0;
+          sql_bind(stmt, idx, sql_escape(*itPruned));
+          std::string text;
+          while (sqlite3_step(stmt) == SQLITE_ROW) {
+            // Filter out jobs to be modified
+            if (sql_column(stmt, 0, text) && (writtenIds.find(sql_unescape(text)) == writtenIds.end())) {
+              prunedIds.push_back(text);
             }
           }
-          if(found) {
-            itId = prunedIds.erase(itId);
-          } else {
-            ++itId;
-          }
+          (void)sqlite3_reset(stmt);
         }
       }
       // Remove identified jobs
-      for(std::list<std::string>::iterator itId = prunedIds.begin(); itId != prunedIds.end(); ++itId) {
-        std::string sqlcmd = "DELETE FROM jobs WHERE (id = '" + *itId + "')";
-        (void)sqlite3_exec_nobusy(db.handle(), sqlcmd.c_str(), &ListJobsCallback, &prunedArg, NULL);
+      if (!prunedIds.empty()) {
+        sqlite3_stmt* stmt = db.statement("DELETE FROM jobs WHERE (id = ?)");
+        if (!stmt) return false;
+        for(std::list<std::string>::iterator itId = prunedIds.begin(); itId != prunedIds.end(); ++itId) {
+          int idx = 0;
+          sql_bind(stmt, idx, *itId);
+          (void)sqlite3_step(stmt);
+          (void)sqlite3_reset(stmt);
+        }
       }
       // Add new jobs
+      sqlite3_stmt* insertStmt = db.statement(JobsWriteCommand("INSERT OR IGNORE"));
+      sqlite3_stmt* replaceStmt = db.statement(JobsWriteCommand("REPLACE"));
+      if (!insertStmt || !replaceStmt) return false;
       for (std::list<Job>::const_iterator it = jobs.begin();
            it != jobs.end(); ++it) {
-        std::string sqlvalues = "jobs("
-          JOBS_COLUMNS
-          ") VALUES ('"+
-             sql_escape(it->JobID)+"', '"+
-             sql_escape(it->IDFromEndpoint)+"', '"+
-             sql_escape(it->Name)+"', '"+
-             sql_escape(it->JobStatusInterfaceName)+"', '"+
-             sql_escape(it->JobStatusURL.fullstr())+"', '"+
-             sql_escape(it->JobManagementInterfaceName)+"', '"+
-             sql_escape(it->JobManagementURL.fullstr())+"', '"+
-             sql_escape(it->ServiceInformationInterfaceName)+"', '"+
-             sql_escape(it->ServiceInformationURL.fullstr())+"', '"+
-             sql_escape(it->ServiceInformationURL.Host())+"', '"+
-             sql_escape(it->SessionDir.fullstr())+"', '"+
-             sql_escape(it->StageInDir.fullstr())+"', '"+
-             sql_escape(it->StageOutDir.fullstr())+"', '"+
-             sql_escape(it->JobDescriptionDocument)+"', '"+
-             sql_escape(tostring(it->LocalSubmissionTime.GetTime()))+"', '"+
-             sql_escape(it->DelegationID)+"', '"+
-             // attributes available after code update
-             sql_escape(it->Type)+"', '"+
-             sql_escape(it->LocalIDFromManager)+"', '"+
-             sql_escape(it->JobDescription)+"', '"+
-             sql_escape(it->State.GetGeneralState())+"', '"+
-             sql_escape(it->RestartState.GetGeneralState())+"', '"+
-             sql_escape(it->ExitCode)+"', '"+
-             sql_escape(it->ComputingManagerExitCode)+"', '"+
-             sql_escape(it->Error)+"', '"+
-             sql_escape(it->WaitingPosition)+"', '"+
-             sql_escape(it->UserDomain)+"', '"+
-             sql_escape(it->Owner)+"', '"+
-             sql_escape(it->LocalOwner)+"', '"+
-             sql_escape(it->RequestedTotalWallTime)+"', '"+
-             sql_escape(it->RequestedTotalCPUTime)+"', '"+
-             sql_escape(it->RequestedSlots)+"', '"+
-             sql_escape(it->RequestedApplicationEnvironment)+"', '"+
-             sql_escape(it->StdIn)+"', '"+
-             sql_escape(it->StdOut)+"', '"+
-             sql_escape(it->StdErr)+"', '"+
-             sql_escape(it->LogDir)+"', '"+
-             sql_escape(it->ExecutionNode)+"', '"+
-             sql_escape(it->Queue)+"', '"+
-             sql_escape(it->UsedTotalWallTime)+"', '"+
-             sql_escape(it->UsedTotalCPUTime)+"', '"+
-             sql_escape(it->UsedMainMemory)+"', '"+
-             sql_escape(it->SubmissionTime)+"', '"+
-             sql_escape(it->ComputingManagerSubmissionTime)+"', '"+
-             sql_escape(it->StartTime)+"', '"+
-             sql_escape(it->ComputingManagerEndTime)+"', '"+
-             sql_escape(it->EndTime)+"', '"+
-             sql_escape(it->WorkingAreaEraseTime)+"', '"+
-             sql_escape(it->ProxyExpirationTime)+"', '"+
-             sql_escape(it->SubmissionHost)+"', '"+
-             sql_escape(it->SubmissionClientName)+"', '"+
-             sql_escape(it->OtherMessages)+"', '"+
-             sql_escape(it->ActivityOldID)+"')";
         bool new_job = true;
-        int err = sqlite3_exec_nobusy(db.handle(), ("INSERT OR IGNORE INTO " + sqlvalues).c_str(), NULL, NULL, NULL);
-        if(err != SQLITE_OK) {
+        BindJob(insertStmt, *it);
+        int err = sqlite3_step(insertStmt);
+        (void)sqlite3_reset(insertStmt);
+        if(err != SQLITE_DONE) {
           logger.msg(VERBOSE, "Unable to write records into job database (%s): Id \"%s\"", name, it->JobID);
           logErrorMessage(err);
+          newJobs.resize(nNewJobs);
           return false;
         }
         if(sqlite3_changes(db.handle()) == 0) {
-          err = sqlite3_exec_nobusy(db.handle(), ("REPLACE INTO " + sqlvalues).c_str(), NULL, NULL, NULL);
-          if(err != SQLITE_OK) {
+          BindJob(replaceStmt, *it);
+          err = sqlite3_step(replaceStmt);
+          (void)sqlite3_reset(replaceStmt);
+          if(err != SQLITE_DONE) {
             logger.msg(VERBOSE, "Unable to write records into job database (%s): Id \"%s\"", name, it->JobID);
             logErrorMessage(err);
+            newJobs.resize(nNewJobs);
             return false;
           }
           new_job = false;
@@ -375,191 +584,23 @@ namespace Arc {
         if(sqlite3_changes(db.handle()) != 1) {
           logger.msg(VERBOSE, "Unable to write records into job database (%s): Id \"%s\"", name, it->JobID);
           logErrorMessage(err);
+          newJobs.resize(nNewJobs);
           return false;
         }
         if(new_job) newJobs.push_back(&(*it));
       }
+      if (!db.commit()) {
+        newJobs.resize(nNewJobs);
+        return false;
+      }
     } catch (const SQLiteException& e) {
+      newJobs.resize(nNewJobs);
       return false;
     }
 
     return true;
   }
 
-  struct ReadJobsCallbackArg {
-    std::list<Job>& jobs;
-    std::list<std::string>* jobIdentifiers;
-    const std::list<std::string>* endpoints;
-    const std::list<std::string>* rejectEndpoints;
-    std::list<std::string> jobIdentifiersMatched;
-    ReadJobsCallbackArg(std::list<Job>& jobs, 
-                        std::list<std::string>* jobIdentifiers,
-                        const std::list<std::string>* endpoints,
-                        const std::list<std::string>* rejectEndpoints):
-       jobs(jobs), jobIdentifiers(jobIdentifiers), endpoints(endpoints), rejectEndpoints(rejectEndpoints) {};
-  };
-
-  static int ReadJobsCallback(void* arg, int colnum, char** texts, char** names) {
-    ReadJobsCallbackArg& carg = *reinterpret_cast<ReadJobsCallbackArg*>(arg);
-    carg.jobs.push_back(Job());
-    bool accept = false;
-    bool drop = false;
-    for(int n = 0; n < colnum; ++n) {
-      if(names[n] && texts[n]) {
-        if(strcmp(names[n], "id") == 0) {
-          carg.jobs.back().JobID = sql_unescape(texts[n]);
-          if(carg.jobIdentifiers) {
-            for(std::list<std::string>::iterator it = carg.jobIdentifiers->begin();
-                           it != carg.jobIdentifiers->end(); ++it) {
-              if(*it == carg.jobs.back().JobID) {
-                accept = true;
-                carg.jobIdentifiersMatched.push_back(*it);
-                break;
-              }
-            }
-          } else {
-            accept = true;
-          }
-        } else if(strcmp(names[n], "idfromendpoint") == 0) {
-          carg.jobs.back().IDFromEndpoint = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "name") == 0) {
-          carg.jobs.back().Name = sql_unescape(texts[n]);
-          if(carg.jobIdentifiers) {
-            for(std::list<std::string>::iterator it = carg.jobIdentifiers->begin();
-                           it != carg.jobIdentifiers->end(); ++it) {
-              if(*it == carg.jobs.back().Name) {
-                accept = true;
-                carg.jobIdentifiersMatched.push_back(*it);
-                break;
-              }
-            }
-          } else {
-            accept = true;
-          }
-        } else if(strcmp(names[n], "statusinterface") == 0) {
-          carg.jobs.back().JobStatusInterfaceName = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "statusurl") == 0) {
-          carg.jobs.back().JobStatusURL = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "managementinterfacename") == 0) {
-          carg.jobs.back().JobManagementInterfaceName = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "managementurl") == 0) {
-          carg.jobs.back().JobManagementURL = sql_unescape(texts[n]);
-          if(carg.rejectEndpoints) {
-            for (std::list<std::string>::const_iterator it = carg.rejectEndpoints->begin();
-                     it != carg.rejectEndpoints->end(); ++it) {
-              if (carg.jobs.back().JobManagementURL.StringMatches(*it)) {
-                drop = true;
-                break;
-              }
-            }
-          }
-          if(carg.endpoints) {
-            for (std::list<std::string>::const_iterator it = carg.endpoints->begin();
-                     it != carg.endpoints->end(); ++it) {
-              if (carg.jobs.back().JobManagementURL.StringMatches(*it)) {
-                accept = true;
-                break;
-              }
-            }
-          }
-        } else if(strcmp(names[n], "serviceinformationinterfacename") == 0) {
-          carg.jobs.back().ServiceInformationInterfaceName = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "serviceinformationurl") == 0) {
-          carg.jobs.back().ServiceInformationURL = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "sessiondir") == 0) {
-          carg.jobs.back().SessionDir = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "stageindir") == 0) {
-          carg.jobs.back().StageInDir = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "stageoutdir") == 0) {
-          carg.jobs.back().StageOutDir = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "descriptiondocument") == 0) {
-          carg.jobs.back().JobDescriptionDocument = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "localsubmissiontime") == 0) {
-          carg.jobs.back().LocalSubmissionTime.SetTime(stringtoi(sql_unescape(texts[n])));
-        } else if(strcmp(names[n], "delegationid") == 0) {
-          carg.jobs.back().DelegationID.push_back(sql_unescape(texts[n]));
-        // attributs available after code update
-        } else if(strcmp(names[n], "type") == 0) {
-          carg.jobs.back().Type = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "localidfrommanager") == 0) {
-          carg.jobs.back().LocalIDFromManager = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "description") == 0) {
-          carg.jobs.back().JobDescription = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "state") == 0) {
-          carg.jobs.back().State = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "restartstate") == 0) {
-          carg.jobs.back().RestartState = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "exitcode") == 0) {
-          sql_unescape(texts[n], carg.jobs.back().ExitCode);
-        } else if(strcmp(names[n], "computingmanagerexitcode") == 0) {
-          sql_unescape(texts[n], carg.jobs.back().ComputingManagerExitCode);
-        } else if(strcmp(names[n], "error") == 0) {
-          sql_unescape(texts[n], carg.jobs.back().Error);
-        } else if(strcmp(names[n], "waitingposition") == 0) {
-          sql_unescape(texts[n], carg.jobs.back().WaitingPosition);
-        } else if(strcmp(names[n], "userdomain") == 0) {
-          carg.jobs.back().UserDomain = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "owner") == 0) {
-          carg.jobs.back().Owner = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "localowner") == 0) {
-          carg.jobs.back().LocalOwner = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "requestedtotalwallltime") == 0) {
-          sql_unescape(texts[n], carg.jobs.back().RequestedTotalWallTime);
-        } else if(strcmp(names[n], "requestedtotalcputime") == 0) {
-          sql_unescape(texts[n], carg.jobs.back().RequestedTotalCPUTime);
-        } else if(strcmp(names[n], "requestedslots") == 0) {
-          sql_unescape(texts[n], carg.jobs.back().RequestedSlots);
-        } else if(strcmp(names[n], "requestedapplicationenvironment") == 0) {
-          sql_unescape(texts[n], carg.jobs.back().RequestedApplicationEnvironment);
-        } else if(strcmp(names[n], "stdin") == 0) {
-          carg.jobs.back().StdIn = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "stdout") == 0) {
-          carg.jobs.back().StdOut = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "stderr") == 0) {
-          carg.jobs.back().StdErr = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "logdir") == 0) {
-          carg.jobs.back().LogDir = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "executionnode") == 0) {
-          sql_unescape(texts[n], carg.jobs.back().ExecutionNode);
-        } else if(strcmp(names[n], "queue") == 0) {
-          carg.jobs.back().Queue = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "usedtotalwallltime") == 0) {
-          carg.jobs.back().UsedTotalWallTime = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "usedtotalcputime") == 0) {
-          carg.jobs.back().UsedTotalCPUTime = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "usedmainmemory") == 0) {
-          sql_unescape(texts[n], carg.jobs.back().UsedMainMemory);
-        } else if(strcmp(names[n], "submissiontime") == 0) {
-          sql_unescape(texts[n], carg.jobs.back().SubmissionTime);
-        } else if(strcmp(names[n], "computingmanagersubmissiontime") == 0) {
-          sql_unescape(texts[n], carg.jobs.back().ComputingManagerSubmissionTime);
-        } else if(strcmp(names[n], "starttime") == 0) {
-          sql_unescape(texts[n], carg.jobs.back().StartTime);
-        } else if(strcmp(names[n], "computingmanagerendtime") == 0) {
-          sql_unescape(texts[n], carg.jobs.back().ComputingManagerEndTime);
-        } else if(strcmp(names[n], "endtime") == 0) {
-          sql_unescape(texts[n], carg.jobs.back().EndTime);
-        } else if(strcmp(names[n], "workingareaerasetime") == 0) {
-          sql_unescape(texts[n], carg.jobs.back().WorkingAreaEraseTime);
-        } else if(strcmp(names[n], "proxyexpirationtime") == 0) {
-          sql_unescape(texts[n], carg.jobs.back().ProxyExpirationTime);
-        } else if(strcmp(names[n], "submissionhost") == 0) {
-          carg.jobs.back().SubmissionHost = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "submissionclienttime") == 0) {
-          carg.jobs.back().SubmissionClientName = sql_unescape(texts[n]);
-        } else if(strcmp(names[n], "othermessages") == 0) {
-          sql_unescape(texts[n], carg.jobs.back().OtherMessages);
-        } else if(strcmp(names[n], "activityoldid") == 0) {
-          sql_unescape(texts[n], carg.jobs.back().ActivityOldID);
-        }
-      }
-    }
-    if(drop || !accept) {
-      carg.jobs.pop_back();
-    }
-    return 0;
-  }
-
   bool JobInformationStorageSQLite::ReadAll(std::list<Job>& jobs, const std::list<std::string>& rejectEndpoints) {
     if (!isValid) {
       return false;
@@ -568,10 +609,18 @@ namespace Arc {
 
     try {
       JobDB db(name);
-      std::string sqlcmd = "SELECT * FROM jobs";
-      ReadJobsCallbackArg carg(jobs, NULL, NULL, &rejectEndpoints);
-      int err = sqlite3_exec_nobusy(db.handle(), sqlcmd.c_str(), &ReadJobsCallback, &carg, NULL);
-      if(err != SQLITE_OK) {
+      sqlite3_stmt* stmt = db.statement(std::string("SELECT ") + db.columns() + " FROM jobs");
+      if (!stmt) return false;
+      int err;
+      while ((err = sqlite3_step(stmt)) == SQLITE_ROW) {
+        jobs.push_back(Job());
+        ReadJob(stmt, jobs.back());
+        if (MatchesEndpoints(jobs.back().JobManagementURL, rejectEndpoints)) {
+          jobs.pop_back();
+        }
+      }
+      (void)sqlite3_reset(stmt);
+      if(err != SQLITE_DONE) {
         // handle error ??
         return false;
       }
@@ -592,18 +641,51 @@ namespace Arc {
     
     try {
       JobDB db(name);
-      std::string sqlcmd = "SELECT * FROM jobs";
-      ReadJobsCallbackArg carg(jobs, &jobIdentifiers, &endpoints, &rejectEndpoints);
-      int err = sqlite3_exec_nobusy(db.handle(), sqlcmd.c_str(), &ReadJobsCallback, &carg, NULL);
-      if(err != SQLITE_OK) {
-        // handle error ??
-        return false;
+      // First only row ids of selected jobs are collected using indices.
+      // Set keeps them in order of storing and removes duplicates.
+      std::set<sqlite3_int64> rows;
+      if (!jobIdentifiers.empty()) {
+        sqlite3_stmt* idStmt = db.statement("SELECT rowid FROM jobs WHERE (id = ?)");
+        sqlite3_stmt* nameStmt = db.statement("SELECT rowid FROM jobs WHERE (name = ?)");
+        if (!idStmt || !nameStmt) return false;
+        for (std::list<std::string>::iterator itId = jobIdentifiers.begin();
+             itId != jobIdentifiers.end();) {
+          bool matched = SelectRows(idStmt, *itId, rows);
+          if (SelectRows(nameStmt, *itId, rows)) matched = true;
+          if (matched) {
+            itId = jobIdentifiers.erase(itId);
+          } else {
+            ++itId;
+          }
+        }
+      }
+      if (!endpoints.empty()) {
+        // Endpoints are matched by URL::StringMatches which can't be expressed
+        // in SQL. But scanning index of managementurl is cheap compared to
+        // reading whole records.
+        sqlite3_stmt* stmt = db.statement("SELECT rowid, managementurl FROM jobs");
+        if (!stmt) return false;
+        std::string text;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+          if (sql_column(stmt, 1, text) && MatchesEndpoints(URL(sql_unescape(text)), endpoints)) {
+            rows.insert(sqlite3_column_int64(stmt, 0));
+          }
+        }
+        (void)sqlite3_reset(stmt);
       }
-      carg.jobIdentifiersMatched.sort();
-      carg.jobIdentifiersMatched.unique();
-      for(std::list<std::string>::iterator itMatched = carg.jobIdentifiersMatched.begin();
-                        itMatched != carg.jobIdentifiersMatched.end(); ++itMatched) {
-        jobIdentifiers.remove(*itMatched);
+      if (rows.empty()) return true;
+      sqlite3_stmt* stmt = db.statement(std::string("SELECT ") + db.columns() + " FROM jobs WHERE (rowid = ?)");
+      if (!stmt) return false;
+      for (std::set<sqlite3_int64>::iterator itRow = rows.begin(); itRow != rows.end(); ++itRow) {
+        (void)sqlite3_bind_int64(stmt, 1, *itRow);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+          jobs.push_back(Job());
+          ReadJob(stmt, jobs.back());
+          if (MatchesEndpoints(jobs.back().JobManagementURL, rejectEndpoints)) {
+            jobs.pop_back();
+          }
+        }
+        (void)sqlite3_reset(stmt);
       }
     } catch (const SQLiteException& e) {
       return false;
@@ -617,6 +699,11 @@ namespace Arc {
       return false;
     }
 
+    // Files of write-ahead log and rollback journal are left if
+    // process accessing database was killed.
+    (void)remove((name + "-wal").c_str());
+    (void)remove((name + "-shm").c_str());
+    (void)remove((name + "-journal").c_str());
     if (remove(name.c_str()) != 0) {
       if (errno == ENOENT) return true; // No such file. DB already cleaned.
       logger.msg(VERBOSE, "Unable to truncate job database (%s)", name);
@@ -634,14 +721,22 @@ namespace Arc {
 
     try {
       JobDB db(name, true);
+      if (!db.begin()) return false;
+      sqlite3_stmt* stmt = db.statement("DELETE FROM jobs WHERE (id = ?)");
+      if (!stmt) return false;
       for (std::list<std::string>::const_iterator it = jobids.begin();
            it != jobids.end(); ++it) {
-        std::string sqlcmd = "DELETE FROM jobs WHERE (id = '"+sql_escape(*it)+"')";
-        int err = sqlite3_exec_nobusy(db.handle(), sqlcmd.c_str(), NULL, NULL, NULL); 
-        if(err != SQLITE_OK) {
-        } else if(sqlite3_changes(db.handle()) < 1) {
+        int idx = 0;
+        sql_bind(stmt, idx, sql_escape(*it));
+        int err = sqlite3_step(stmt);
+        (void)sqlite3_reset(stmt);
+        if(err != SQLITE_DONE) {
+          logger.msg(VERBOSE, "Unable to remove records from job database (%s): Id \"%s\"", name, *it);
+          logErrorMessage(err);
+          return false;
         }
       }
+      if (!db.commit()) return false;
     } catch (const SQLiteException& e) {
       return false;
     }
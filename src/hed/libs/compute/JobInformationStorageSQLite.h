@@ -3,6 +3,8 @@
 #ifndef __ARC_JOBINFORMATIONSTORAGESQLITE_H__
 #define __ARC_JOBINFORMATIONSTORAGESQLITE_H__
 
+#include <map>
+
 #include <sqlite3.h>
 
 #include "JobInformationStorage.h"
@@ -38,6 +40,22 @@ namespace Arc {
       
       sqlite3* handle() { return jobDB; }
 
+      /// Returns columns to be selected for reading jobs.
+      /** Database created by older version and opened for reading only
+          lacks columns added later. */
+      const char* columns() const;
+
+      /// Returns prepared statement for sql ready for binding parameters.
+      /** Statements are prepared once per connection and kept till
+          connection is closed. Returns NULL on failure. */
+      sqlite3_stmt* statement(const std::string& sql);
+
+      /// Starts transaction which takes write lock immediately
+      bool begin();
+
+      /// Commits transaction. If not called transaction is rolled back at close.
+      bool commit();
+
     private:
       void tearDown();
 
@@ -45,6 +63,10 @@ namespace Arc {
 
       sqlite3* jobDB;
 
+      bool allColumns;
+
+      std::map<std::string, sqlite3_stmt*> statements;
+
     };
     
     class SQLiteException {
@@ -4,6 +4,10 @@
 
 #include <iostream>
 
+#ifdef HAVE_SQLITE
+#include <sqlite3.h>
+#endif
+
 #include <cppunit/extensions/HelperMacros.h>
 
 #include <arc/DateTime.h>
@@ -28,6 +32,9 @@ class JobInformationStorageTest
   CPPUNIT_TEST_SUITE(JobInformationStorageTest);
   CPPUNIT_TEST(GeneralTest);
   CPPUNIT_TEST(ReadJobsTest);
+#ifdef HAVE_SQLITE
+  CPPUNIT_TEST(OldSQLiteTest);
+#endif
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -36,6 +43,9 @@ public:
   void tearDown() { Arc::DirDelete(tmpdir, true); }
   void GeneralTest();
   void ReadJobsTest();
+#ifdef HAVE_SQLITE
+  void OldSQLiteTest();
+#endif
   
 private:
   Arc::XMLNode xmlJob;
@@ -456,4 +466,67 @@ void JobInformationStorageTest::ReadJobsTest() {
   }
 }
 
+#ifdef HAVE_SQLITE
+// Database written by older version lacks columns added later. It must be
+// readable as is and converted when written.
+void JobInformationStorageTest::OldSQLiteTest() {
+  sqlite3* db = NULL;
+  CPPUNIT_ASSERT_EQUAL(SQLITE_OK, sqlite3_open(tmpfile.c_str(), &db));
+  CPPUNIT_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db,
+    "CREATE TABLE jobs(id, idfromendpoint, name, statusinterface, statusurl, "
+    "managementinterfacename, managementurl, "
+    "serviceinformationinterfacename, serviceinformationurl, serviceinformationhost, "
+    "sessiondir, stageindir, stageoutdir, "
+    "descriptiondocument, localsubmissiontime, delegationid, UNIQUE(id))", NULL, NULL, NULL));
+  CPPUNIT_ASSERT_EQUAL(SQLITE_OK, sqlite3_exec(db,
+    "INSERT INTO jobs(id, name, managementurl) VALUES "
+    "('https://ce1.grid.org/1234567890-foo-job-1', 'foo-job-1', 'https://ce1.grid.org')", NULL, NULL, NULL));
+  (void)sqlite3_close(db);
+
+  Arc::JobInformationStorage* jis = NULL;
+  for (int i = 0; Arc::JobInformationStorage::AVAILABLE_TYPES[i].name != NULL; ++i) {
+    if (std::string(Arc::JobInformationStorage::AVAILABLE_TYPES[i].name) == "SQLITE") {
+      jis = (Arc::JobInformationStorage::AVAILABLE_TYPES[i].instance)(tmpfile);
+    }
+  }
+  CPPUNIT_ASSERT(jis != NULL);
+  CPPUNIT_ASSERT(jis->IsValid());
+
+  std::list<Arc::Job> outJobs;
+  CPPUNIT_ASSERT(jis->ReadAll(outJobs));
+  CPPUNIT_ASSERT_EQUAL(1, (int)outJobs.size());
+  CPPUNIT_ASSERT_EQUAL((std::string)"foo-job-1", outJobs.front().Name);
+
+  std::list<std::string> jobIdentifiers;
+  jobIdentifiers.push_back("foo-job-1");
+  outJobs.clear();
+  CPPUNIT_ASSERT(jis->Read(outJobs, jobIdentifiers));
+  CPPUNIT_ASSERT_EQUAL(1, (int)outJobs.size());
+  CPPUNIT_ASSERT_EQUAL((std::string)"https://ce1.grid.org/1234567890-foo-job-1", outJobs.front().JobID);
+
+  std::list<Arc::Job> inJobs;
+  inJobs.push_back(Arc::Job());
+  inJobs.back().Name = "foo-job-2";
+  inJobs.back().JobID = "https://ce1.grid.org/1234567890-foo-job-2";
+  inJobs.back().JobManagementURL = Arc::URL("https://ce1.grid.org");
+  inJobs.back().ActivityOldID.push_back("old-id");
+  CPPUNIT_ASSERT(jis->Write(inJobs));
+
+  outJobs.clear();
+  CPPUNIT_ASSERT(jis->ReadAll(outJobs));
+  CPPUNIT_ASSERT_EQUAL(2, (int)outJobs.size());
+  CPPUNIT_ASSERT_EQUAL((std::string)"foo-job-1", outJobs.front().Name);
+  CPPUNIT_ASSERT_EQUAL((std::string)"foo-job-2", outJobs.back().Name);
+  CPPUNIT_ASSERT_EQUAL(1, (int)outJobs.back().ActivityOldID.size());
+  CPPUNIT_ASSERT_EQUAL((std::string)"old-id", outJobs.back().ActivityOldID.front());
+
+  // Clean removes database together with its journal files
+  CPPUNIT_ASSERT(jis->Clean());
+  CPPUNIT_ASSERT(!Glib::file_test(tmpfile, Glib::FILE_TEST_EXISTS));
+  CPPUNIT_ASSERT(!Glib::file_test(tmpfile + "-wal", Glib::FILE_TEST_EXISTS));
+  CPPUNIT_ASSERT(!Glib::file_test(tmpfile + "-shm", Glib::FILE_TEST_EXISTS));
+  delete jis;
+}
+#endif
+
 CPPUNIT_TEST_SUITE_REGISTRATION(JobInformationStorageTest);
@@ -16,6 +16,112 @@
 #ifdef DBJSTORE_ENABLED
 #include "JobInformationStorageBDB.h"
 #endif
+#ifdef HAVE_SQLITE
+#include "JobInformationStorageSQLite.h"
+#endif
+
+static Arc::JobInformationStorage* createStorage(const std::string& type, const std::string& filename) {
+  if (type == "XML") return new Arc::JobInformationStorageXML(filename);
+#ifdef DBJSTORE_ENABLED
+  if (type == "BDB") return new Arc::JobInformationStorageBDB(filename);
+#endif
+#ifdef HAVE_SQLITE
+  if (type == "SQLITE") return new Arc::JobInformationStorageSQLite(filename);
+#endif
+  return NULL;
+}
+
+static double seconds(const Arc::Period& p) {
+  return (double)p.GetPeriod() + (double)p.GetPeriodNanoseconds() / 1000000000.0;
+}
+
+static void benchmarkJob(Arc::Job& j, int n) {
+  // Jobs are spread over 10 services
+  const std::string host = "service" + Arc::tostring(n % 10) + ".test.nordugrid.org";
+  j.ServiceInformationInterfaceName = "org.nordugrid.test";
+  j.JobStatusInterfaceName = "org.nordugrid.test";
+  j.JobManagementInterfaceName = "org.nordugrid.test";
+  j.JobDescriptionDocument = "&( executable = \"/bin/echo\" )( arguments = \"Hello World\" )( stdout = \"std.out\" )( jobname = \"Hello World\" )";
+  j.Name = "Job " + Arc::tostring(n);
+  j.IDFromEndpoint = "job" + Arc::tostring(n);
+  j.JobID = "http://" + host + "/" + j.IDFromEndpoint;
+  j.ServiceInformationURL = Arc::URL("http://" + host + "/serviceinfo");
+  j.JobStatusURL = Arc::URL("http://" + host + "/jobstatus");
+  j.JobManagementURL = Arc::URL("http://" + host + "/jobmanagement");
+  j.StageInDir = Arc::URL("http://" + host + "/stagein/" + j.IDFromEndpoint);
+  j.StageOutDir = Arc::URL("http://" + host + "/stageout/" + j.IDFromEndpoint);
+  j.SessionDir = Arc::URL("http://" + host + "/session/" + j.IDFromEndpoint);
+  j.LocalSubmissionTime = Arc::Time();
+}
+
+// Performs same sequence of operations on every back-end and prints time
+// in seconds taken by each of them: writing all jobs in bunches, reading
+// all jobs, reading 1000 jobs by identifier, reading jobs of one service
+// (tenth of all) and removing 1000 jobs.
+static int benchmark(const std::list<std::string>& types, const std::string& filename, int nJobs, int bunchSize) {
+  if (nJobs <= 0 || bunchSize <= 0) {
+    std::cerr << "ERROR: Invalid number of jobs (nJobs = " << nJobs << ") or bunch size (bunchSize = " << bunchSize << ")" << std::endl;
+    return 1;
+  }
+  std::list<std::string> sample;
+  const int step = (nJobs > 1000) ? (nJobs / 1000) : 1;
+  for (int n = 0; n < nJobs; n += step) {
+    Arc::Job j;
+    benchmarkJob(j, n);
+    sample.push_back(j.JobID);
+  }
+  std::list<std::string> endpoints(1, "service0.test.nordugrid.org");
+
+  std::cout << "backend write readall read-ids read-endpoint remove" << std::endl;
+  for (std::list<std::string>::const_iterator itType = types.begin(); itType != types.end(); ++itType) {
+    const std::string storageFile = filename + "." + Arc::lower(*itType);
+    remove(storageFile.c_str());
+    Arc::JobInformationStorage* jis = createStorage(*itType, storageFile);
+    if (!jis || !jis->IsValid()) {
+      std::cerr << "ERROR: Unable to create " << *itType << " storage " << storageFile << std::endl;
+      delete jis;
+      return 1;
+    }
+    bool ok = true;
+    Arc::Period tWrite;
+    for (int m = 0; m < nJobs; m += bunchSize) {
+      std::list<Arc::Job> jobs;
+      for (int n = m; (n < m + bunchSize) && (n < nJobs); ++n) {
+        jobs.push_back(Arc::Job());
+        benchmarkJob(jobs.back(), n);
+      }
+      Arc::Time tBefore;
+      ok = jis->Write(jobs) && ok;
+      tWrite += Arc::Time()-tBefore;
+    }
+    std::list<Arc::Job> jobs;
+    Arc::Time tBefore;
+    ok = jis->ReadAll(jobs) && ok;
+    Arc::Period tReadAll = Arc::Time()-tBefore;
+    if ((int)jobs.size() != nJobs) ok = false;
+    std::list<std::string> identifiers(sample);
+    tBefore = Arc::Time();
+    ok = jis->Read(jobs, identifiers) && ok;
+    Arc::Period tReadIds = Arc::Time()-tBefore;
+    if (jobs.size() != sample.size()) ok = false;
+    identifiers.clear();
+    tBefore = Arc::Time();
+    ok = jis->Read(jobs, identifiers, endpoints) && ok;
+    Arc::Period tReadEndpoint = Arc::Time()-tBefore;
+    tBefore = Arc::Time();
+    ok = jis->Remove(sample) && ok;
+    Arc::Period tRemove = Arc::Time()-tBefore;
+    std::cout << *itType << " " << seconds(tWrite) << " " << seconds(tReadAll) << " "
+              << seconds(tReadIds) << " " << seconds(tReadEndpoint) << " " << seconds(tRemove) << std::endl;
+    (void)jis->Clean();
+    delete jis;
+    if (!ok) {
+      std::cerr << "ERROR: Operations on " << *itType << " storage did not give expected results" << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
 
 
 int main(int argc, char **argv) {
@@ -33,13 +139,13 @@ int main(int argc, char **argv) {
   options.AddOption('B', "bunchSize", "size of bunches of job objects to pass to JobInformationStorage object methods", "n", bunchSize);
 
   std::string action = "write";
-  options.AddOption('a', "action", "Action to perform: write, append, appendreturnnew, read, readall, remove", "action", action);
+  options.AddOption('a', "action", "Action to perform: write, append, appendreturnnew, read, readall, remove, benchmark", "action", action);
   
   std::string filename = "";
   options.AddOption('f', "filename", "", "", filename);
   
   std::string typeS = "";
-  options.AddOption('t', "type", "Type of storage back-end to use (BDB or XML)", "type", typeS);
+  options.AddOption('t', "type", "Type of storage back-end to use (BDB, SQLITE or XML). For benchmark all available are used if not specified.", "type", typeS);
   
   std::string hostname = "test.nordugrid.org";
   options.AddOption(0, "hostname", "", "", hostname);
@@ -70,6 +176,23 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  if (action == "benchmark") {
+    std::list<std::string> types;
+    if (!typeS.empty()) {
+      types.push_back(typeS);
+    }
+    else {
+      types.push_back("XML");
+#ifdef DBJSTORE_ENABLED
+      types.push_back("BDB");
+#endif
+#ifdef HAVE_SQLITE
+      types.push_back("SQLITE");
+#endif
+    }
+    return benchmark(types, filename, nJobs, bunchSize);
+  }
+
   Arc::JobInformationStorage** jisPointer = NULL;
   if      (typeS == "XML") {
     Arc::JobInformationStorageXML *jisXML = new Arc::JobInformationStorageXML(filename);
@@ -80,6 +203,12 @@ int main(int argc, char **argv) {
     Arc::JobInformationStorageBDB *jisDB4 = new Arc::JobInformationStorageBDB(filename);
     jisPointer = (Arc::JobInformationStorage**)&jisDB4;
   }
+#endif
+#ifdef HAVE_SQLITE
+  else if (typeS == "SQLITE") {
+    Arc::JobInformationStorageSQLite *jisSQLite = new Arc::JobInformationStorageSQLite(filename);
+    jisPointer = (Arc::JobInformationStorage**)&jisSQLite;
+  }
 #endif
   else {
     std::cerr << "ERROR: Unable to determine storage back-end to use." << std::endl;
@@ -3,7 +3,10 @@
 #endif
 
 #include <fstream>
+#include <map>
 #include <glibmm/fileutils.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include <arc/DateTime.h>
@@ -700,32 +703,102 @@ err:
     return(ok);
   }
 
-  static bool checkCert(STACK_OF(X509) *stack, const std::string& ca_cert_dir, const std::string& ca_cert_file) {
-    X509_STORE *ctx = NULL;
-    X509_LOOKUP *lookup = NULL;
-    int index = 0;
-
-    if(ca_cert_dir.empty() && ca_cert_file.empty()) {
-      CredentialLogger.msg(ERROR,"VOMS: CA directory or CA file must be provided");
-      return false;
-    }
+  // Identifies state of file or directory. Includes inode and sub-second
+  // part of modification time because file may be replaced or rewritten
+  // within same second. Empty for missing file.
+  static std::string file_stamp(const std::string& path) {
+    struct stat st;
+    if(path.empty() || (::stat(path.c_str(), &st) != 0)) return "";
+    return tostring(st.st_ino) + ":" + tostring(st.st_size) + ":" +
+           tostring(st.st_mtim.tv_sec) + "." + tostring(st.st_mtim.tv_nsec);
+  }
 
-    ctx = X509_STORE_new();
-    if (ctx) {
-      X509_STORE_set_verify_cb_func(ctx,cb);
+  // Trusted CA certificates used for verifying AC issuers. Store is made
+  // once for every combination of CA directory and file and shared by all
+  // verifications. CA certificates loaded by hash_dir lookup stay cached
+  // in it. Store is made anew when CA directory or file is modified.
+  class VOMSTrustStore {
+   public:
+    VOMSTrustStore(const std::string& ca_cert_dir, const std::string& ca_cert_file);
+    ~VOMSTrustStore(void);
+    X509_STORE* Get(void) const { return store_; };
+    bool Modified(void) const;
+    // Unique for every created store
+    unsigned long long Generation(void) const { return generation_; };
+   private:
+    VOMSTrustStore(const VOMSTrustStore&);
+    VOMSTrustStore& operator=(const VOMSTrustStore&);
+    X509_STORE* store_;
+    std::string ca_cert_dir_;
+    std::string ca_cert_file_;
+    std::string ca_cert_dir_stamp_;
+    std::string ca_cert_file_stamp_;
+    unsigned long long generation_;
+    static unsigned long long last_generation_;
+  };
+
+  unsigned long long VOMSTrustStore::last_generation_ = 0;
+
+  static Glib::Mutex trust_stores_lock;
+  static std::map<std::string, ThreadedPointer<VOMSTrustStore> > trust_stores;
+
+  VOMSTrustStore::VOMSTrustStore(const std::string& ca_cert_dir, const std::string& ca_cert_file):
+      store_(NULL), ca_cert_dir_(ca_cert_dir), ca_cert_file_(ca_cert_file),
+      ca_cert_dir_stamp_(file_stamp(ca_cert_dir)), ca_cert_file_stamp_(file_stamp(ca_cert_file)) {
+    // Called with trust_stores_lock held
+    generation_ = ++last_generation_;
+    X509_LOOKUP *lookup = NULL;
+    store_ = X509_STORE_new();
+    if (store_) {
+      X509_STORE_set_verify_cb_func(store_,cb);
 //#ifdef SIGPIPE
 //      signal(SIGPIPE,SIG_IGN);
 //#endif
 //      CRYPTO_malloc_init();
 
-      if (!(ca_cert_dir.empty()) && (lookup = X509_STORE_add_lookup(ctx,X509_LOOKUP_hash_dir()))) {
+      if (!(ca_cert_dir.empty()) && (lookup = X509_STORE_add_lookup(store_,X509_LOOKUP_hash_dir()))) {
         X509_LOOKUP_add_dir(lookup, ca_cert_dir.c_str(), X509_FILETYPE_PEM);
       }
-      if (!(ca_cert_file.empty()) && (lookup = X509_STORE_add_lookup(ctx, X509_LOOKUP_file()))) {
+      if (!(ca_cert_file.empty()) && (lookup = X509_STORE_add_lookup(store_, X509_LOOKUP_file()))) {
         X509_LOOKUP_load_file(lookup, ca_cert_file.c_str(), X509_FILETYPE_PEM);
       }
+    }
+  }
+
+  VOMSTrustStore::~VOMSTrustStore(void) {
+    if (store_) X509_STORE_free(store_);
+  }
+
+  bool VOMSTrustStore::Modified(void) const {
+    return (file_stamp(ca_cert_dir_) != ca_cert_dir_stamp_) ||
+           (file_stamp(ca_cert_file_) != ca_cert_file_stamp_);
+  }
+
+  static ThreadedPointer<VOMSTrustStore> getTrustStore(const std::string& ca_cert_dir, const std::string& ca_cert_file) {
+    Glib::Mutex::Lock lock(trust_stores_lock);
+    ThreadedPointer<VOMSTrustStore>& store = trust_stores[ca_cert_dir + "\n" + ca_cert_file];
+    if (!store || store->Modified()) {
+      store = new VOMSTrustStore(ca_cert_dir, ca_cert_file);
+    }
+    return store;
+  }
+
+  static bool checkCert(STACK_OF(X509) *stack, const std::string& ca_cert_dir, const std::string& ca_cert_file) {
+    int index = 0;
+
+    if(ca_cert_dir.empty() && ca_cert_file.empty()) {
+      CredentialLogger.msg(ERROR,"VOMS: CA directory or CA file must be provided");
+      return false;
+    }
+
+    ThreadedPointer<VOMSTrustStore> store = getTrustStore(ca_cert_dir, ca_cert_file);
+    X509_STORE *ctx = store->Get();
+    if (ctx) {
+      // Already verified certificates. Shared store must not be modified,
+      // hence they are passed as untrusted chain instead of being added to it.
+      STACK_OF(X509)* verified = sk_X509_new_null();
       //Check the AC issuer certificate's chain
-      for (int i = sk_X509_num(stack)-1; i >=0; i--) {
+      for (int i = sk_X509_num(stack)-1; (i >=0) && verified; i--) {
         X509_STORE_CTX *csc = X509_STORE_CTX_new();
         if (csc) {
           //Firstly, try to verify the certificate which is issues by CA;
@@ -743,19 +816,18 @@ err:
           //is signed by root CA is checked firstly; the voms server certificate
           //is checked lastly.
           //
-          if(X509_STORE_CTX_init(csc, ctx, sk_X509_value(stack, i), NULL)) {
+          if(X509_STORE_CTX_init(csc, ctx, sk_X509_value(stack, i), verified)) {
             index = X509_verify_cert(csc);
           }
           X509_STORE_CTX_free(csc);
           if(!index) break;
-          //If the 'i'th certificate is verified, then add it as trusted certificate,
-          //then 'i'th certificate will be used as 'trusted certificate' to check
+          //If the 'i'th certificate is verified, then use it to check
           //the 'i-1'th certificate
-          X509_STORE_add_cert(ctx,sk_X509_value(stack, i));
+          sk_X509_push(verified, sk_X509_value(stack, i));
         }
       }
+      if (verified) sk_X509_free(verified);
     }
-    if (ctx) X509_STORE_free(ctx);
 
     return (index != 0);
   }
@@ -882,15 +954,40 @@ err:
 
   }
   
+  // Content of *.lsc files, read again only if file is modified
+  class VOMSLSCFile {
+   public:
+    VOMSLSCFile(void):mtime(0),mtime_nsec(0),size(0) { };
+    time_t mtime;
+    long mtime_nsec;
+    off_t size;
+    std::vector<std::string> trust_dn;
+  };
+
+  static Glib::Mutex lsc_files_lock;
+  static std::map<std::string, VOMSLSCFile> lsc_files;
+
+  static std::string getLSCPath(const std::string& vomsdir, const std::string& voname, const std::string& hostname) {
+    return vomsdir + G_DIR_SEPARATOR_S + voname + G_DIR_SEPARATOR_S + hostname + ".lsc";
+  }
+
   /* Get the DNs chain from relative *.lsc file.
    * The location of .lsc file is path: $vomsdir/<VO>/<hostname>.lsc
    */
   static bool getLSC(const std::string& vomsdir, const std::string& voname, const std::string& hostname, std::vector<std::string>& vomscert_trust_dn) {
-    std::string lsc_loc = vomsdir + G_DIR_SEPARATOR_S + voname + G_DIR_SEPARATOR_S + hostname + ".lsc";
-    if (!Glib::file_test(lsc_loc, Glib::FILE_TEST_IS_REGULAR)) {
+    std::string lsc_loc = getLSCPath(vomsdir, voname, hostname);
+    struct stat st;
+    if ((::stat(lsc_loc.c_str(), &st) != 0) || !S_ISREG(st.st_mode)) {
       CredentialLogger.msg(INFO, "VOMS: The lsc file %s does not exist", lsc_loc);
       return false;
     }
+    Glib::Mutex::Lock lock(lsc_files_lock);
+    std::map<std::string, VOMSLSCFile>::iterator lsc = lsc_files.find(lsc_loc);
+    if ((lsc != lsc_files.end()) && (lsc->second.mtime == st.st_mtim.tv_sec) &&
+        (lsc->second.mtime_nsec == st.st_mtim.tv_nsec) && (lsc->second.size == st.st_size)) {
+      vomscert_trust_dn.insert(vomscert_trust_dn.end(), lsc->second.trust_dn.begin(), lsc->second.trust_dn.end());
+      return true;
+    }
     std::string trustdn_str;  
     std::ifstream in(lsc_loc.c_str(), std::ios::in);
     if (!in) {       
@@ -899,14 +996,42 @@ err:
     }
     std::getline<char>(in, trustdn_str, 0);
     in.close();
-    tokenize(trustdn_str, vomscert_trust_dn, "\n");
+    VOMSLSCFile& lsc_file = lsc_files[lsc_loc];
+    lsc_file.mtime = st.st_mtim.tv_sec;
+    lsc_file.mtime_nsec = st.st_mtim.tv_nsec;
+    lsc_file.size = st.st_size;
+    lsc_file.trust_dn.clear();
+    tokenize(trustdn_str, lsc_file.trust_dn, "\n");
+    vomscert_trust_dn.insert(vomscert_trust_dn.end(), lsc_file.trust_dn.begin(), lsc_file.trust_dn.end());
     return true;
   }
 
+  // State of *.lsc file of AC issuer and of VO directory holding it,
+  // including the case when they do not exist. Used to notice changes
+  // in vomsdir which may change result of AC verification.
+  class VOMSDirStamp {
+   public:
+    VOMSDirStamp(void) { };
+    VOMSDirStamp(const std::string& vomsdir, const std::string& voname, const std::string& hostname):
+      lsc_path_(getLSCPath(vomsdir, voname, hostname)), dir_path_(vomsdir + G_DIR_SEPARATOR_S + voname) {
+      lsc_stamp_ = file_stamp(lsc_path_);
+      dir_stamp_ = file_stamp(dir_path_);
+    };
+    bool Modified(void) const {
+      if (lsc_path_.empty()) return false;
+      return (file_stamp(lsc_path_) != lsc_stamp_) || (file_stamp(dir_path_) != dir_stamp_);
+    };
+   private:
+    std::string lsc_path_;
+    std::string dir_path_;
+    std::string lsc_stamp_;
+    std::string dir_stamp_;
+  };
+
   static bool checkSignature(AC* ac,
     const std::string vomsdir, const std::string& voname, const std::string& hostname, 
     const std::string& ca_cert_dir, const std::string& ca_cert_file, 
-    VOMSTrustList& vomscert_trust_dn, 
+    VOMSTrustList& vomscert_trust_dn, std::vector<std::string>& lsc_trust_dn,
     X509*& issuer_cert, unsigned int& status, bool verify) {
 
     bool res = true;
@@ -949,6 +1074,7 @@ err:
           }
           else { 
             vomscert_trust_dn.AddElement(voms_trustdn);
+            lsc_trust_dn = voms_trustdn;
             lsc_check = true;
             //lsc checking only happens if the VOMSTrustList argument is empty. 
           }
@@ -1537,7 +1663,8 @@ err:
   // Also always fills status with information about errors detected if any.
   static bool verifyVOMSAC(AC* ac,
         const std::string& ca_cert_dir, const std::string& ca_cert_file, const std::string vomsdir,
-        VOMSTrustList& vomscert_trust_dn,
+        VOMSTrustList& vomscert_trust_dn, std::vector<std::string>& lsc_trust_dn,
+        VOMSDirStamp& vomsdir_stamp,
         X509* holder, std::vector<std::string>& attr_output, 
         std::string& vo_name, std::string& ac_holder_name, std::string& ac_issuer_name, 
         Time& from, Time& till, unsigned int& status, bool verify) {
@@ -1593,6 +1720,8 @@ err:
       }
       voname = voname.substr(0, cpos);
       vo_name = voname;
+      // Taken before LSC file is read
+      vomsdir_stamp = VOMSDirStamp(vomsdir, voname, hostname);
     }
     else {
       // Must not happen. VOMS parsing error
@@ -1604,7 +1733,7 @@ err:
     X509* issuer = NULL;
 
     if(!checkSignature(ac, vomsdir, voname, hostname,
-                       ca_cert_dir, ca_cert_file, vomscert_trust_dn,
+                       ca_cert_dir, ca_cert_file, vomscert_trust_dn, lsc_trust_dn,
                        issuer, status, verify)) {
       CredentialLogger.msg(ERROR,"VOMS: can not verify the signature of the AC");
       res = false;
@@ -1620,6 +1749,123 @@ err:
     return res;
   }
 
+  // Results of successful verification of ACs. Same proxy is usually
+  // presented many times during its lifetime, so full verification of
+  // AC signature and of issuer chain is done once for every combination
+  // of AC, holder certificate and trust settings. Results are dropped when
+  // AC expires, when trust store is made anew, when LSC file of the AC or
+  // its VO directory in vomsdir changes and after fixed time.
+  static const time_t VOMS_AC_CACHE_LIFETIME = 10*60;
+  static const unsigned int VOMS_AC_CACHE_MAX_SIZE = 10000;
+
+  class VOMSACCacheEntry {
+   public:
+    VOMSACInfo info;
+    std::vector<std::string> lsc_trust_dn; // LSC content added to trust list during verification
+    VOMSDirStamp vomsdir_stamp;            // vomsdir files verification depended on
+    unsigned long long generation;        // generation of trust store used
+    time_t expires;
+  };
+
+  static Glib::Mutex ac_cache_lock;
+  static std::map<std::string, VOMSACCacheEntry> ac_cache;
+  static unsigned long long ac_cache_hits = 0;
+  static unsigned long long ac_cache_misses = 0;
+
+  static std::string getACCacheKey(AC* ac, X509* holder,
+        const std::string& ca_cert_dir, const std::string& ca_cert_file, const std::string& vomsdir,
+        const VOMSTrustList& vomscert_trust_dn) {
+    int len = i2d_AC(ac, NULL);
+    if (len <= 0) return "";
+    std::string der(len, '\0');
+    unsigned char* p = (unsigned char*)&der[0];
+    if (i2d_AC(ac, &p) != len) return "";
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int md_len = 0;
+    if (!EVP_Digest(der.c_str(), der.length(), md, &md_len, EVP_sha256(), NULL)) return "";
+    std::string key((char*)md, md_len);
+    if (!X509_digest(holder, EVP_sha256(), md, &md_len)) return "";
+    key.append((char*)md, md_len);
+    key.append(1, '\0').append(ca_cert_dir);
+    key.append(1, '\0').append(ca_cert_file);
+    key.append(1, '\0').append(vomsdir);
+    for (int n = 0; n < vomscert_trust_dn.SizeChains(); ++n) {
+      const VOMSTrustChain& chain = vomscert_trust_dn.GetChain(n);
+      key.append(1, '\0');
+      for (VOMSTrustChain::const_iterator dn = chain.begin(); dn != chain.end(); ++dn) {
+        key.append(1, '\n').append(*dn);
+      }
+    }
+    for (int n = 0; n < vomscert_trust_dn.SizeRegexs(); ++n) {
+      key.append(1, '\0').append(vomscert_trust_dn.GetRegex(n).getPattern());
+    }
+    return key;
+  }
+
+  static bool getCachedAC(const std::string& key, unsigned long long generation,
+        VOMSACInfo& info, VOMSTrustList& vomscert_trust_dn) {
+    Glib::Mutex::Lock lock(ac_cache_lock);
+    std::map<std::string, VOMSACCacheEntry>::iterator entry = ac_cache.find(key);
+    if (entry != ac_cache.end()) {
+      // Same tolerance as in checkACInfo
+      time_t now = time(NULL);
+      if ((entry->second.generation == generation) && (now < entry->second.expires) &&
+          (entry->second.info.from.GetTime() <= (now + 300)) &&
+          !entry->second.vomsdir_stamp.Modified()) {
+        info = entry->second.info;
+        // Repeat side effect of verification
+        if (!entry->second.lsc_trust_dn.empty() &&
+            (vomscert_trust_dn.SizeChains() == 0) && (vomscert_trust_dn.SizeRegexs() == 0)) {
+          vomscert_trust_dn.AddElement(entry->second.lsc_trust_dn);
+        }
+        ++ac_cache_hits;
+        CredentialLogger.msg(DEBUG, "VOMS: using cached result of AC verification for VO %s", info.voname);
+        return true;
+      }
+      ac_cache.erase(entry);
+    }
+    ++ac_cache_misses;
+    return false;
+  }
+
+  static void putCachedAC(const std::string& key, unsigned long long generation,
+        const VOMSACInfo& info, const std::vector<std::string>& lsc_trust_dn,
+        const VOMSDirStamp& vomsdir_stamp) {
+    if ((info.from.GetTime() == Time::UNDEFINED) || (info.till.GetTime() == Time::UNDEFINED)) return;
+    time_t now = time(NULL);
+    time_t expires = info.till.GetTime() + 300;
+    if (expires > (now + VOMS_AC_CACHE_LIFETIME)) expires = now + VOMS_AC_CACHE_LIFETIME;
+    if (expires <= now) return;
+    Glib::Mutex::Lock lock(ac_cache_lock);
+    if (ac_cache.size() >= VOMS_AC_CACHE_MAX_SIZE) {
+      for (std::map<std::string, VOMSACCacheEntry>::iterator entry = ac_cache.begin(); entry != ac_cache.end();) {
+        if (entry->second.expires <= now) {
+          ac_cache.erase(entry++);
+        } else {
+          ++entry;
+        }
+      }
+      if (ac_cache.size() >= VOMS_AC_CACHE_MAX_SIZE) ac_cache.clear();
+    }
+    VOMSACCacheEntry& entry = ac_cache[key];
+    entry.info = info;
+    entry.lsc_trust_dn = lsc_trust_dn;
+    entry.vomsdir_stamp = vomsdir_stamp;
+    entry.generation = generation;
+    entry.expires = expires;
+  }
+
+  void getVOMSACCacheStatistics(unsigned long long& hits, unsigned long long& misses) {
+    Glib::Mutex::Lock lock(ac_cache_lock);
+    hits = ac_cache_hits;
+    misses = ac_cache_misses;
+  }
+
+  void clearVOMSACCache(void) {
+    Glib::Mutex::Lock lock(ac_cache_lock);
+    ac_cache.clear();
+  }
+
   bool parseVOMSAC(X509* holder,
         const std::string& ca_cert_dir, const std::string& ca_cert_file, 
         const std::string& vomsdir, VOMSTrustList& vomscert_trust_dn,
@@ -1654,10 +1900,25 @@ err:
     for (int i = 0; i < num; i++) {
       AC *ac = (AC *)sk_AC_value(aclist->acs, i);
       VOMSACInfo ac_info;
-      bool r = verifyVOMSAC(ac, ca_cert_dir, ca_cert_file,
-          vomsdir.empty()?default_vomsdir:vomsdir, vomscert_trust_dn, 
-          holder, ac_info.attributes, ac_info.voname, ac_info.holder, ac_info.issuer, 
-          ac_info.from, ac_info.till, ac_info.status, verify);
+      bool r = false;
+      std::string cache_key;
+      unsigned long long generation = 0;
+      if(verify) {
+        generation = getTrustStore(ca_cert_dir, ca_cert_file)->Generation();
+        cache_key = getACCacheKey(ac, holder, ca_cert_dir, ca_cert_file,
+            vomsdir.empty()?default_vomsdir:vomsdir, vomscert_trust_dn);
+      }
+      if(!cache_key.empty() && getCachedAC(cache_key, generation, ac_info, vomscert_trust_dn)) {
+        r = true;
+      } else {
+        std::vector<std::string> lsc_trust_dn;
+        VOMSDirStamp vomsdir_stamp;
+        r = verifyVOMSAC(ac, ca_cert_dir, ca_cert_file,
+            vomsdir.empty()?default_vomsdir:vomsdir, vomscert_trust_dn, lsc_trust_dn, vomsdir_stamp,
+            holder, ac_info.attributes, ac_info.voname, ac_info.holder, ac_info.issuer, 
+            ac_info.from, ac_info.till, ac_info.status, verify);
+        if(r && !cache_key.empty()) putCachedAC(cache_key, generation, ac_info, lsc_trust_dn, vomsdir_stamp);
+      }
       if(!r) verified = false;
       if(r || reportall) {
         if(critical) ac_info.status |= VOMSACInfo::IsCritical;
@@ -273,6 +273,23 @@ namespace Arc {
                    std::vector<VOMSACInfo>& output,
                    bool verify = true, bool reportall = false); 
  
+  /**Get statistics of cache of verified ACs.
+   * Successfully verified ACs are remembered per holder certificate and
+   * trust settings by parseVOMSAC, so repeated verification of same
+   * proxy only needs a lookup. Cached results are used while AC is valid,
+   * at most for 10 minutes and only till CA directory or file changes
+   * or LSC file of AC issuer or its VO directory in vomsdir changes.
+   * @param hits  number of ACs for which cached result was used
+   * @param misses  number of ACs which were fully verified
+   * \since Added in 6.9.0.
+   */
+  void getVOMSACCacheStatistics(unsigned long long& hits, unsigned long long& misses);
+
+  /**Drop all cached results of AC verification.
+   * \since Added in 6.9.0.
+   */
+  void clearVOMSACCache(void);
+
   /**Decode the data which is encoded by voms server. Since voms code uses some specific
   * coding method (not base64 encoding), we simply copy the method from voms code to here*/
   char *VOMSDecode(const char *data, int size, int *j);
@@ -4,8 +4,13 @@
 
 #include <cppunit/extensions/HelperMacros.h>
 
+#include <fstream>
 #include <iostream>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <arc/FileUtils.h>
 #include <arc/Logger.h>
 #include <arc/credential/VOMSUtil.h>
 
@@ -14,22 +19,23 @@ class VOMSUtilTest
 
   CPPUNIT_TEST_SUITE(VOMSUtilTest);
   CPPUNIT_TEST(VOMSTrustListTest);
+  CPPUNIT_TEST(VOMSACCacheTest);
+  CPPUNIT_TEST(VOMSACCacheVOMSDirTest);
   CPPUNIT_TEST_SUITE_END();
 
 public:
   VOMSUtilTest() {}
-  void setUp() {}
-  void tearDown() {}
+  void setUp();
+  void tearDown();
   void VOMSTrustListTest();
-};
+  void VOMSACCacheTest();
+  void VOMSACCacheVOMSDirTest();
 
-void VOMSUtilTest::VOMSTrustListTest() {
-
-  std::vector<Arc::VOMSACInfo> output;
-  std::string emptystring = "";
-  Arc::VOMSTrustList emptylist;
+private:
+  std::string vomsdir;
+};
 
-  //  CPPUNIT_ASSERT_EQUAL(!parseVOMSAC(c, emptystring, emptystring, emptylist, output, false),false);
+void VOMSUtilTest::setUp() {
 
   // Create the AC on the VOMS side
 
@@ -108,6 +114,18 @@ void VOMSUtilTest::VOMSTrustListTest() {
   out_f.write(signing_cert_chain.c_str(), signing_cert_chain.size());
   out_f.close();
 
+  vomsdir.clear();
+  CPPUNIT_ASSERT(Arc::TmpDirCreate(vomsdir));
+}
+
+void VOMSUtilTest::tearDown() {
+  Arc::DirDelete(vomsdir);
+}
+
+void VOMSUtilTest::VOMSTrustListTest() {
+
+  std::string CAcert("ca_cert.pem");
+  std::string voms_proxy_file("voms_proxy.pem");
 
   std::vector<std::string> vomscert_trust_dn;
   vomscert_trust_dn.push_back("/O=Grid/OU=ARC/CN=localhost");
@@ -134,4 +152,122 @@ void VOMSUtilTest::VOMSTrustListTest() {
 
 }
 
+void VOMSUtilTest::VOMSACCacheTest() {
+
+  std::string CAcert("ca_cert.pem");
+  std::string voms_proxy_file("voms_proxy.pem");
+  Arc::Credential voms_proxy(voms_proxy_file, "", ".", CAcert);
+
+  std::vector<std::string> vomscert_trust_dn;
+  vomscert_trust_dn.push_back("^/O=Grid/OU=ARC");
+  Arc::VOMSTrustList trust_dn(vomscert_trust_dn);
+
+  Arc::clearVOMSACCache();
+  unsigned long long hits_before = 0;
+  unsigned long long misses_before = 0;
+  Arc::getVOMSACCacheStatistics(hits_before, misses_before);
+
+  // First verification is done fully and its result is cached
+  std::vector<Arc::VOMSACInfo> attributes1;
+  CPPUNIT_ASSERT(Arc::parseVOMSAC(voms_proxy, ".", CAcert, "", trust_dn, attributes1, true));
+  unsigned long long hits = 0;
+  unsigned long long misses = 0;
+  Arc::getVOMSACCacheStatistics(hits, misses);
+  CPPUNIT_ASSERT_EQUAL(hits_before, hits);
+  CPPUNIT_ASSERT_EQUAL(misses_before + 1, misses);
+
+  // Second verification uses cached result which must be same
+  std::vector<Arc::VOMSACInfo> attributes2;
+  CPPUNIT_ASSERT(Arc::parseVOMSAC(voms_proxy, ".", CAcert, "", trust_dn, attributes2, true));
+  Arc::getVOMSACCacheStatistics(hits, misses);
+  CPPUNIT_ASSERT_EQUAL(hits_before + 1, hits);
+  CPPUNIT_ASSERT_EQUAL(misses_before + 1, misses);
+  CPPUNIT_ASSERT_EQUAL(1, (int)attributes2.size());
+  CPPUNIT_ASSERT_EQUAL(attributes1[0].voname, attributes2[0].voname);
+  CPPUNIT_ASSERT_EQUAL(attributes1[0].status, attributes2[0].status);
+  CPPUNIT_ASSERT(attributes1[0].attributes == attributes2[0].attributes);
+
+  // Different trust settings do not use same result
+  std::vector<Arc::VOMSACInfo> attributes3;
+  Arc::VOMSTrustList untrusted_dn(std::vector<std::string>(1, "^/O=Untrusted"));
+  Arc::parseVOMSAC(voms_proxy, ".", CAcert, "", untrusted_dn, attributes3, true);
+  Arc::getVOMSACCacheStatistics(hits, misses);
+  CPPUNIT_ASSERT_EQUAL(hits_before + 1, hits);
+  CPPUNIT_ASSERT_EQUAL(misses_before + 2, misses);
+
+}
+
+// Rewrites file in place with explicit modification time, so that
+// change within same second is visible on any file system
+static bool RewriteFile(const std::string& filename, const std::string& content, long mtime_nsec) {
+  {
+    std::ofstream f(filename.c_str(), std::ios::out | std::ios::trunc);
+    if (!f) return false;
+    f << content;
+    if (!f) return false;
+  }
+  struct timespec times[2];
+  times[0].tv_sec = 1500000000;
+  times[0].tv_nsec = mtime_nsec;
+  times[1] = times[0];
+  return (::utimensat(AT_FDCWD, filename.c_str(), times, 0) == 0);
+}
+
+void VOMSUtilTest::VOMSACCacheVOMSDirTest() {
+
+  std::string CAcert("ca_cert.pem");
+  std::string voms_proxy_file("voms_proxy.pem");
+  Arc::Credential voms_proxy(voms_proxy_file, "", ".", CAcert);
+
+  // Trust is defined by LSC file of AC issuer because trust list is empty
+  std::string vodir = vomsdir + "/nordugrid";
+  std::string lsc_file = vodir + "/voms.nordugrid.org.lsc";
+  std::string lsc("/O=Grid/OU=ARC/CN=localhost\n/O=Grid/OU=ARC/CN=CA\n");
+  CPPUNIT_ASSERT(Arc::DirCreate(vodir, S_IRWXU));
+  CPPUNIT_ASSERT(RewriteFile(lsc_file, lsc, 100));
+
+  Arc::clearVOMSACCache();
+  unsigned long long hits_before = 0;
+  unsigned long long misses_before = 0;
+  Arc::getVOMSACCacheStatistics(hits_before, misses_before);
+  unsigned long long hits = 0;
+  unsigned long long misses = 0;
+
+  // Verification adds LSC content to trust list, so new list is used every time
+  std::vector<Arc::VOMSACInfo> attributes1;
+  Arc::VOMSTrustList trust_dn1;
+  CPPUNIT_ASSERT(Arc::parseVOMSAC(voms_proxy, ".", CAcert, vomsdir, trust_dn1, attributes1, true));
+  CPPUNIT_ASSERT_EQUAL(1, (int)attributes1.size());
+  std::vector<Arc::VOMSACInfo> attributes2;
+  Arc::VOMSTrustList trust_dn2;
+  CPPUNIT_ASSERT(Arc::parseVOMSAC(voms_proxy, ".", CAcert, vomsdir, trust_dn2, attributes2, true));
+  Arc::getVOMSACCacheStatistics(hits, misses);
+  CPPUNIT_ASSERT_EQUAL(hits_before + 1, hits);
+  CPPUNIT_ASSERT_EQUAL(misses_before + 1, misses);
+  // Side effect of verification is repeated for cached result
+  CPPUNIT_ASSERT_EQUAL(trust_dn1.SizeChains(), trust_dn2.SizeChains());
+  CPPUNIT_ASSERT_EQUAL(attributes1[0].status, attributes2[0].status);
+
+  // LSC file modified within same second and with same size
+  CPPUNIT_ASSERT(RewriteFile(lsc_file, lsc, 200));
+  std::vector<Arc::VOMSACInfo> attributes3;
+  Arc::VOMSTrustList trust_dn3;
+  CPPUNIT_ASSERT(Arc::parseVOMSAC(voms_proxy, ".", CAcert, vomsdir, trust_dn3, attributes3, true));
+  Arc::getVOMSACCacheStatistics(hits, misses);
+  CPPUNIT_ASSERT_EQUAL(hits_before + 1, hits);
+  CPPUNIT_ASSERT_EQUAL(misses_before + 2, misses);
+
+  // LSC file removed from VO directory
+  CPPUNIT_ASSERT(Arc::FileDelete(lsc_file));
+  std::vector<Arc::VOMSACInfo> attributes4;
+  Arc::VOMSTrustList trust_dn4;
+  Arc::parseVOMSAC(voms_proxy, ".", CAcert, vomsdir, trust_dn4, attributes4, true, true);
+  Arc::getVOMSACCacheStatistics(hits, misses);
+  CPPUNIT_ASSERT_EQUAL(hits_before + 1, hits);
+  CPPUNIT_ASSERT_EQUAL(misses_before + 3, misses);
+  CPPUNIT_ASSERT_EQUAL(1, (int)attributes4.size());
+  CPPUNIT_ASSERT(attributes4[0].status & Arc::VOMSACInfo::LSCFailed);
+
+}
+
 CPPUNIT_TEST_SUITE_REGISTRATION(VOMSUtilTest);
@@ -0,0 +1,55 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <cstdlib>
+#include <string>
+#include <iostream>
+#include <arc/DateTime.h>
+#include <arc/Logger.h>
+#include "VOMSUtil.h"
+#include "Credential.h"
+
+// Measures time needed to verify VOMS attributes of same proxy repeatedly,
+// like it happens when same client connects many times. Verification
+// results are cached after first verification.
+
+int main(int argc, char* argv[]) {
+  Arc::LogStream cdest(std::cerr);
+  Arc::Logger::getRootLogger().addDestination(cdest);
+  Arc::Logger::getRootLogger().setThreshold(Arc::WARNING);
+
+  if(argc < 4) {
+    std::cerr<<"Usage: "<<argv[0]<<" proxy ca_cert_dir vomsdir [iterations]"<<std::endl;
+    return 1;
+  }
+  std::string proxy_file(argv[1]);
+  std::string ca_cert_dir(argv[2]);
+  std::string vomsdir(argv[3]);
+  int iterations = 1000;
+  if(argc > 4) iterations = atoi(argv[4]);
+  if(iterations <= 0) iterations = 1;
+
+  Arc::Credential proxy(proxy_file, "", ca_cert_dir, "");
+
+  Arc::Time start;
+  for(int n = 0; n < iterations; ++n) {
+    // Trusted DNs are taken from *.lsc files in vomsdir
+    Arc::VOMSTrustList trust_dn;
+    std::vector<Arc::VOMSACInfo> attributes;
+    if(!Arc::parseVOMSAC(proxy, ca_cert_dir, "", vomsdir, trust_dn, attributes)) {
+      std::cerr<<"Failed to verify VOMS attributes"<<std::endl;
+      return 1;
+    }
+  }
+  Arc::Period period = Arc::Time() - start;
+  double seconds = period.GetPeriod() + period.GetPeriodNanoseconds() / 1000000000.0;
+
+  unsigned long long hits = 0;
+  unsigned long long misses = 0;
+  Arc::getVOMSACCacheStatistics(hits, misses);
+  std::cout<<"Verified "<<iterations<<" times in "<<seconds<<" s ("
+           <<(seconds * 1000.0 / iterations)<<" ms each)"<<std::endl;
+  std::cout<<"Cache hits: "<<hits<<", misses: "<<misses<<std::endl;
+  return 0;
+}
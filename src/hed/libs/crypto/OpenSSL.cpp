@@ -25,6 +25,10 @@ namespace Arc {
   static int ssl_locks_num = 0;
 #endif
   static std::map<std::string,int> app_data_indices;
+  static std::map<std::string,int> connection_data_indices;
+  static unsigned long long handshakes_full = 0;
+  static unsigned long long handshakes_resumed = 0;
+  static bool session_reuse = true;
 
   static Logger& logger(void) {
     static Logger* logger_ = new Logger(Logger::getRootLogger(), "OpenSSL");
@@ -185,5 +189,41 @@ namespace Arc {
     return i->second;
   }
 
+  int OpenSSLConnectionDataIndex(const std::string& id) {
+    Glib::Mutex::Lock flock(lock);
+    std::map<std::string,int>::iterator i = connection_data_indices.find(id);
+    if(i == connection_data_indices.end()) {
+      int n = SSL_get_ex_new_index(0,NULL,NULL,NULL,NULL);
+      connection_data_indices[id] = n;
+      return n;
+    }
+    return i->second;
+  }
+
+  void OpenSSLCountHandshake(bool resumed) {
+    Glib::Mutex::Lock flock(lock);
+    if(resumed) {
+      ++handshakes_resumed;
+    } else {
+      ++handshakes_full;
+    };
+  }
+
+  void OpenSSLHandshakeCounters(unsigned long long& full, unsigned long long& resumed) {
+    Glib::Mutex::Lock flock(lock);
+    full = handshakes_full;
+    resumed = handshakes_resumed;
+  }
+
+  void OpenSSLSessionReuse(bool enable) {
+    Glib::Mutex::Lock flock(lock);
+    session_reuse = enable;
+  }
+
+  bool OpenSSLSessionReuse(void) {
+    Glib::Mutex::Lock flock(lock);
+    return session_reuse;
+  }
+
 } // namespace Arc
 
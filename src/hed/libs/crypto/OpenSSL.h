@@ -23,6 +23,31 @@ namespace Arc {
 
   int OpenSSLAppDataIndex(const std::string& id);
 
+  /// Returns index for storing application data in SSL objects
+  /** Same index is returned for same id during whole lifetime of the
+     process even if module requesting it is reloaded.
+     \since Added in 6.9.0. */
+  int OpenSSLConnectionDataIndex(const std::string& id);
+
+  /// Registers completed TLS handshake
+  /** Used by code establishing TLS connections to keep process-wide
+     statistics. \since Added in 6.9.0. */
+  void OpenSSLCountHandshake(bool resumed);
+
+  /// Returns number of full and resumed TLS handshakes made by this process
+  /** \since Added in 6.9.0. */
+  void OpenSSLHandshakeCounters(unsigned long long& full, unsigned long long& resumed);
+
+  /// Enables or disables reuse of TLS contexts and sessions
+  /** Reuse is enabled by default. Disabling it makes every new connection
+     perform full handshake. Already cached sessions are not destroyed but
+     are not used while reuse is disabled. \since Added in 6.9.0. */
+  void OpenSSLSessionReuse(bool enable);
+
+  /// Returns true if TLS contexts and sessions may be reused
+  /** \since Added in 6.9.0. */
+  bool OpenSSLSessionReuse(void);
+
 } // namespace Arc
 
 #endif /* __ARC_OPENSSL_H__ */
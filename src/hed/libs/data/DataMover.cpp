@@ -1054,16 +1054,16 @@ namespace Arc {
         // compare to the original source (if available).
         std::string calc_csum;
         if (crc && buffer.checksum_valid()) {
-          char buf[100];
-          crc.print(buf,100);
+          char buf[CheckSum::MaxPrintLength];
+          crc.print(buf,sizeof(buf));
           calc_csum = buf;
         } else if(crc_source) {
-          char buf[100];
-          crc_source.print(buf,100);
+          char buf[CheckSum::MaxPrintLength];
+          crc_source.print(buf,sizeof(buf));
           calc_csum = buf;
         } else if(crc_dest) {
-          char buf[100];
-          crc_dest.print(buf,100);
+          char buf[CheckSum::MaxPrintLength];
+          crc_dest.print(buf,sizeof(buf));
           calc_csum = buf;
         }
         if (!calc_csum.empty()) {
@@ -47,6 +47,7 @@ namespace Arc {
     valid_url_options.insert("encryption");
     valid_url_options.insert("httpputpartial");
     valid_url_options.insert("httpgetpartial");
+    valid_url_options.insert("httpstreams");
     valid_url_options.insert("rucioaccount");
     valid_url_options.insert("failureallowed");
     valid_url_options.insert("relativeuri");
@@ -111,6 +112,14 @@ namespace Arc {
     return DataStatus::Success;
   }
 
+  DataStatus DataPoint::StartReadingVectored(DataRingBuffer& buffer) {
+    return DataStatus(DataStatus::UnimplementedError, EOPNOTSUPP);
+  }
+
+  DataStatus DataPoint::StartWritingVectored(DataRingBuffer& buffer, DataCallback *space_cb) {
+    return DataStatus(DataStatus::UnimplementedError, EOPNOTSUPP);
+  }
+
   DataStatus DataPoint::Transfer(const URL& otherendpoint, bool source, TransferCallback callback) {
     return DataStatus(DataStatus::UnimplementedError, EOPNOTSUPP);
   }
@@ -215,6 +224,10 @@ namespace Arc {
     return false;
   }
 
+  bool DataPoint::SupportsVectoredIO() const {
+    return false;
+  }
+
   void DataPoint::SetMeta(const DataPoint& p) {
     if (!CheckSize())
       SetSize(p.GetSize());
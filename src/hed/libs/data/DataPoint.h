@@ -79,6 +79,7 @@ namespace Arc {
 
   class Logger;
   class DataBuffer;
+  class DataRingBuffer;
   class DataCallback;
   class XMLNode;
   class CheckSum;
@@ -325,6 +326,32 @@ namespace Arc {
      */
     virtual DataStatus StopWriting() = 0;
 
+    /// Start reading data from URL into ring buffer using vectored I/O.
+    /**
+     * Works like StartReading() but data is passed sequentially through
+     * DataRingBuffer, which avoids locking between reading and writing
+     * threads. Checksum objects added to this DataPoint are computed by
+     * ring buffer. Reading must be stopped with StopReading(). Only
+     * plugins for which SupportsVectoredIO() returns true implement it.
+     * \param buffer operation will use this buffer to put information into.
+     * \return success if a thread was successfully started to start reading
+     * \since Added in 6.9.0.
+     */
+    virtual DataStatus StartReadingVectored(DataRingBuffer& buffer);
+
+    /// Start writing data to URL from ring buffer using vectored I/O.
+    /**
+     * Works like StartWriting() but data is taken sequentially from
+     * DataRingBuffer. Writing must be stopped with StopWriting().
+     * \param buffer operation will use this buffer to get information from.
+     * \param space_cb callback which is called if there is not
+     * enough space to store data.
+     * \return success if a thread was successfully started to start writing
+     * \since Added in 6.9.0.
+     */
+    virtual DataStatus StartWritingVectored(DataRingBuffer& buffer,
+                                            DataCallback *space_cb = NULL);
+
     /// Finish reading from the URL.
     /**
      * Must be called after transfer of physical file has completed if
@@ -663,6 +690,12 @@ namespace Arc {
     /// Returns true if DataPoint supports internal transfer
     virtual bool SupportsTransfer() const;
 
+    /// Returns true if DataPoint implements StartReadingVectored() and StartWritingVectored()
+    /**
+     * \since Added in 6.9.0.
+     */
+    virtual bool SupportsVectoredIO() const;
+
     /// Check if endpoint can have any use from meta information.
     virtual bool AcceptsMeta() const = 0;
 
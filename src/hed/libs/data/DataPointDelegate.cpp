@@ -314,8 +314,8 @@ namespace Arc {
     // checksum verification
     const CheckSum * calc_sum = buffer->checksum_object();
     if (data_status && !buffer->error() && calc_sum && *calc_sum && buffer->checksum_valid()) {
-      char buf[100];
-      calc_sum->print(buf,100);
+      char buf[CheckSum::MaxPrintLength];
+      calc_sum->print(buf,sizeof(buf));
       std::string csum(buf);
       if (csum.find(':') != std::string::npos && csum.substr(0, csum.find(':')) == DefaultCheckSum()) {
         logger.msg(VERBOSE, "StopWriting: Calculated checksum %s", csum);
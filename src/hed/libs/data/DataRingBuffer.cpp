@@ -0,0 +1,418 @@
+// -*- indent-tabs-mode: nil -*-
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <atomic>
+#include <cstdlib>
+#include <unistd.h>
+
+#include <arc/CheckSum.h>
+#include <arc/data/DataRingBuffer.h>
+
+namespace Arc {
+
+  /// Slot counters and flags are accessed by reading, writing and checksum
+  /// threads without lock. Each counter is modified by one thread only and
+  /// slot number is counter modulo slots_n.
+  class DataRingBuffer::ring_state {
+   public:
+    ring_state()
+      : filled(0),
+        written(0),
+        summed(0),
+        eof_pos(0),
+        eof_read_flag(false),
+        eof_write_flag(false),
+        error_read_flag(false),
+        error_write_flag(false),
+        error_transfer_flag(false),
+        checksum_done(false),
+        waiting(0),
+        summing(false),
+        exiting(false) {}
+    /// Slots filled by 'read' side.
+    std::atomic<unsigned long long int> filled;
+    /// Slots emptied by 'write' side.
+    std::atomic<unsigned long long int> written;
+    /// Slots processed by checksum thread.
+    std::atomic<unsigned long long int> summed;
+    std::atomic<unsigned long long int> eof_pos;
+    std::atomic<bool> eof_read_flag;
+    std::atomic<bool> eof_write_flag;
+    std::atomic<bool> error_read_flag;
+    std::atomic<bool> error_write_flag;
+    std::atomic<bool> error_transfer_flag;
+    std::atomic<bool> checksum_done;
+    /// Threads waiting on condition
+    std::atomic<int> waiting;
+    std::atomic<bool> summing;
+    std::atomic<bool> exiting;
+  };
+
+  DataRingBuffer::DataRingBuffer(unsigned int size, unsigned int slots_num)
+    : mem(NULL),
+      slots(NULL),
+      slot_size(0),
+      slots_n(0),
+      state(new ring_state),
+      taken_for_read(0),
+      taken_for_write(0) {
+    if ((size == 0) || (slots_num == 0)) return;
+    // Page aligned slots are suitable for any kind of I/O including O_DIRECT
+    long page = sysconf(_SC_PAGESIZE);
+    if (page <= 0) page = 4096;
+    unsigned long long int aligned = ((size + page - 1) / page) * page;
+    if (aligned > 0x80000000ULL) return;
+    void* p = NULL;
+    if (posix_memalign(&p, page, aligned * slots_num) != 0) return;
+    mem = (char*)p;
+    slots = new slot_desc[slots_num];
+    slot_size = aligned;
+    slots_n = slots_num;
+  }
+
+  DataRingBuffer::~DataRingBuffer() {
+    state->exiting = true;
+    lock.lock();
+    cond.broadcast();
+    lock.unlock();
+    checksum_thread.wait();
+    delete[] slots;
+    free(mem);
+    delete state;
+  }
+
+  int DataRingBuffer::add(CheckSum *cksum) {
+    if (!cksum) return -1;
+    if (state->filled.load() != 0) return -1; // too late
+    checksums.push_back(checksum_desc(cksum));
+    cksum->start();
+    if (!state->summing) {
+      state->summing = true;
+      if (!CreateThreadFunction(&checksum_thread_start, this, &checksum_thread)) {
+        state->summing = false;
+        checksums.pop_back();
+        return -1;
+      }
+    }
+    return checksums.size() - 1;
+  }
+
+  void DataRingBuffer::notify() {
+    // Pairs with fence in wait_change(). Without it the preceding store of
+    // counter or flag may become visible only after waiting is read, and
+    // both sides would miss each other.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (state->waiting.load(std::memory_order_relaxed) > 0) {
+      Glib::Mutex::Lock l(lock);
+      cond.broadcast();
+    }
+  }
+
+  bool DataRingBuffer::wait_change(bool (DataRingBuffer::*ready)() const) {
+    Glib::Mutex::Lock l(lock);
+    // Counter is increased before checking condition. Together with fence
+    // in notify() this ensures that either other side sees waiting thread
+    // or this thread sees new state.
+    ++state->waiting;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool res = true;
+    if (!(this->*ready)()) {
+      Glib::TimeVal etime;
+      etime.assign_current_time();
+      etime.add_milliseconds(1000);
+      res = cond.timed_wait(lock, etime);
+    }
+    --state->waiting;
+    return res;
+  }
+
+  unsigned long long int DataRingBuffer::released() const {
+    unsigned long long int w = state->written.load(std::memory_order_acquire);
+    if (!state->summing) return w;
+    unsigned long long int s = state->summed.load(std::memory_order_acquire);
+    return (s < w) ? s : w;
+  }
+
+  bool DataRingBuffer::have_free() const {
+    if (error() || state->eof_write_flag || state->exiting) return true;
+    return (state->filled.load(std::memory_order_relaxed) - released()) < slots_n;
+  }
+
+  bool DataRingBuffer::have_filled() const {
+    if (error() || state->eof_read_flag) return true;
+    return state->filled.load(std::memory_order_acquire) > state->written.load(std::memory_order_relaxed);
+  }
+
+  bool DataRingBuffer::have_unsummed() const {
+    if (error() || state->eof_read_flag || state->exiting) return true;
+    return state->filled.load(std::memory_order_acquire) > state->summed.load(std::memory_order_relaxed);
+  }
+
+  bool DataRingBuffer::is_finished() const {
+    return (state->eof_read_flag && state->eof_write_flag);
+  }
+
+  bool DataRingBuffer::is_summed() const {
+    return (!state->summing) || state->checksum_done;
+  }
+
+  unsigned int DataRingBuffer::for_read(struct iovec* iov, unsigned int max, bool wait) {
+    if (!mem || (max == 0)) return 0;
+    for (;;) {
+      if (error()) return 0;
+      if (state->eof_write_flag) return 0; // writing side quit, nobody will take data
+      unsigned long long int f = state->filled.load(std::memory_order_relaxed);
+      unsigned int avail = slots_n - (unsigned int)(f - released());
+      if (avail > 0) {
+        if (avail > max) avail = max;
+        for (unsigned int n = 0; n < avail; ++n) {
+          iov[n].iov_base = mem + (std::size_t)((f + n) % slots_n) * slot_size;
+          iov[n].iov_len = slot_size;
+        }
+        taken_for_read = avail;
+        return avail;
+      }
+      if (!wait) return 0;
+      wait_change(&DataRingBuffer::have_free);
+    }
+  }
+
+  bool DataRingBuffer::is_read(unsigned long long int length, unsigned long long int offset) {
+    if (taken_for_read == 0) return false;
+    if (length > (unsigned long long int)taken_for_read * slot_size) return false;
+    unsigned long long int f = state->filled.load(std::memory_order_relaxed);
+    unsigned int n = 0;
+    while (length > 0) {
+      slot_desc& slot = slots[(f + n) % slots_n];
+      slot.used = (length > slot_size) ? slot_size : (unsigned int)length;
+      slot.offset = offset;
+      offset += slot.used;
+      length -= slot.used;
+      ++n;
+    }
+    taken_for_read = 0;
+    if (n == 0) return true;
+    if (offset > state->eof_pos) state->eof_pos = offset;
+    state->filled.store(f + n, std::memory_order_release);
+    notify();
+    return true;
+  }
+
+  unsigned int DataRingBuffer::for_write(struct iovec* iov, unsigned int max,
+                                         unsigned long long int& offset, bool wait) {
+    if (!mem || (max == 0)) return 0;
+    for (;;) {
+      if (error()) return 0;
+      // Flag must be checked before counter because counter is final
+      // when flag is set.
+      bool eof = state->eof_read_flag;
+      unsigned long long int w = state->written.load(std::memory_order_relaxed);
+      unsigned long long int f = state->filled.load(std::memory_order_acquire);
+      if (f > w) {
+        unsigned int n = 0;
+        unsigned long long int next = slots[w % slots_n].offset;
+        offset = next;
+        while ((n < max) && ((w + n) < f)) {
+          const slot_desc& slot = slots[(w + n) % slots_n];
+          if (slot.offset != next) break; // writev needs contiguous data
+          iov[n].iov_base = mem + (std::size_t)((w + n) % slots_n) * slot_size;
+          iov[n].iov_len = slot.used;
+          next += slot.used;
+          ++n;
+        }
+        taken_for_write = n;
+        return n;
+      }
+      if (eof) return 0;
+      if (!wait) return 0;
+      if (!speed.transfer()) {
+        if (!(state->error_read_flag || state->error_write_flag)) state->error_transfer_flag = true;
+        notify();
+        return 0;
+      }
+      wait_change(&DataRingBuffer::have_filled);
+    }
+  }
+
+  bool DataRingBuffer::is_written(unsigned int n) {
+    if (n > taken_for_write) return false;
+    unsigned long long int w = state->written.load(std::memory_order_relaxed);
+    unsigned long long int bytes = 0;
+    for (unsigned int i = 0; i < n; ++i) bytes += slots[(w + i) % slots_n].used;
+    taken_for_write = 0;
+    if (n == 0) return true;
+    state->written.store(w + n, std::memory_order_release);
+    /* speed control */
+    if (!speed.transfer(bytes)) {
+      if (!(state->error_read_flag || state->error_write_flag) && !(state->eof_read_flag && state->eof_write_flag))
+        state->error_transfer_flag = true;
+    }
+    notify();
+    return true;
+  }
+
+  void DataRingBuffer::eof_read(bool v) {
+    state->eof_read_flag = v;
+    lock.lock();
+    cond.broadcast();
+    lock.unlock();
+  }
+
+  void DataRingBuffer::eof_write(bool v) {
+    state->eof_write_flag = v;
+    lock.lock();
+    cond.broadcast();
+    lock.unlock();
+  }
+
+  void DataRingBuffer::error_read(bool v) {
+    if (v) {
+      if (!(state->error_write_flag || state->error_transfer_flag)) state->error_read_flag = true;
+      state->eof_read_flag = true;
+    } else {
+      state->error_read_flag = false;
+    }
+    lock.lock();
+    cond.broadcast();
+    lock.unlock();
+  }
+
+  void DataRingBuffer::error_write(bool v) {
+    if (v) {
+      if (!(state->error_read_flag || state->error_transfer_flag)) state->error_write_flag = true;
+      state->eof_write_flag = true;
+    } else {
+      state->error_write_flag = false;
+    }
+    lock.lock();
+    cond.broadcast();
+    lock.unlock();
+  }
+
+  bool DataRingBuffer::eof_read() const {
+    return state->eof_read_flag;
+  }
+
+  bool DataRingBuffer::eof_write() const {
+    return state->eof_write_flag;
+  }
+
+  bool DataRingBuffer::error_read() const {
+    return state->error_read_flag;
+  }
+
+  bool DataRingBuffer::error_write() const {
+    return state->error_write_flag;
+  }
+
+  bool DataRingBuffer::error_transfer() const {
+    return state->error_transfer_flag;
+  }
+
+  bool DataRingBuffer::error() const {
+    return (state->error_read_flag || state->error_write_flag || state->error_transfer_flag);
+  }
+
+  unsigned long long int DataRingBuffer::eof_position() const {
+    return state->eof_pos;
+  }
+
+  void DataRingBuffer::wait_any() {
+    Glib::Mutex::Lock l(lock);
+    ++state->waiting;
+    Glib::TimeVal etime;
+    etime.assign_current_time();
+    etime.add_milliseconds(1000);
+    cond.timed_wait(lock, etime);
+    --state->waiting;
+  }
+
+  void DataRingBuffer::wait_eof() {
+    while (!is_finished()) wait_change(&DataRingBuffer::is_finished);
+  }
+
+  void DataRingBuffer::wait_checksum() {
+    while (!is_summed()) wait_change(&DataRingBuffer::is_summed);
+  }
+
+  void DataRingBuffer::checksum_thread_start(void* arg) {
+    ((DataRingBuffer*)arg)->checksum_loop();
+  }
+
+  void DataRingBuffer::checksum_loop() {
+    for (;;) {
+      if (state->exiting || error()) break;
+      bool eof = state->eof_read_flag;
+      unsigned long long int s = state->summed.load(std::memory_order_relaxed);
+      unsigned long long int f = state->filled.load(std::memory_order_acquire);
+      if (s < f) {
+        for (; s < f; ++s) {
+          const slot_desc& slot = slots[s % slots_n];
+          const char* data = mem + (std::size_t)(s % slots_n) * slot_size;
+          for (std::list<checksum_desc>::iterator itCheckSum = checksums.begin();
+               itCheckSum != checksums.end(); ++itCheckSum) {
+            if (!itCheckSum->ready) continue;
+            if (slot.offset != itCheckSum->offset) {
+              // Data is not sequential - checksum can't be computed
+              itCheckSum->ready = false;
+              continue;
+            }
+            itCheckSum->sum->add((void*)data, slot.used);
+            itCheckSum->offset += slot.used;
+          }
+          state->summed.store(s + 1, std::memory_order_release);
+          notify();
+        }
+        continue;
+      }
+      if (eof) {
+        for (std::list<checksum_desc>::iterator itCheckSum = checksums.begin();
+             itCheckSum != checksums.end(); ++itCheckSum) {
+          itCheckSum->sum->end();
+        }
+        break;
+      }
+      wait_change(&DataRingBuffer::have_unsummed);
+    }
+    state->checksum_done = true;
+    lock.lock();
+    cond.broadcast();
+    lock.unlock();
+  }
+
+  bool DataRingBuffer::checksum_valid() const {
+    if (checksums.empty() || !state->checksum_done) return false;
+    return (checksums.begin()->ready && (checksums.begin()->offset == state->eof_pos));
+  }
+
+  bool DataRingBuffer::checksum_valid(int index) const {
+    if ((index < 0) || !state->checksum_done) return false;
+    int i = 0;
+    for (std::list<checksum_desc>::const_iterator itCheckSum = checksums.begin();
+         itCheckSum != checksums.end(); ++itCheckSum) {
+      if (index == i) return (itCheckSum->ready && (itCheckSum->offset == state->eof_pos));
+      ++i;
+    }
+    return false;
+  }
+
+  const CheckSum* DataRingBuffer::checksum_object() const {
+    if (checksums.empty()) return NULL;
+    return checksums.begin()->sum;
+  }
+
+  const CheckSum* DataRingBuffer::checksum_object(int index) const {
+    if (index < 0) return NULL;
+    int i = 0;
+    for (std::list<checksum_desc>::const_iterator itCheckSum = checksums.begin();
+         itCheckSum != checksums.end(); ++itCheckSum) {
+      if (index == i) return itCheckSum->sum;
+      ++i;
+    }
+    return NULL;
+  }
+
+} // namespace Arc
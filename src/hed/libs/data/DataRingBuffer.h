@@ -0,0 +1,199 @@
+// -*- indent-tabs-mode: nil -*-
+
+#ifndef __ARC_DATARINGBUFFER_H__
+#define __ARC_DATARINGBUFFER_H__
+
+#include <list>
+
+#include <sys/uio.h>
+
+#include <arc/Thread.h>
+#include <arc/data/DataSpeed.h>
+
+namespace Arc {
+
+  class CheckSum;
+
+  /// Ring of buffers passing data from one reading thread to one writing thread.
+  /**
+   * This class is an alternative to DataBuffer for transfers where data is
+   * produced and consumed sequentially by exactly one thread on each side.
+   * Buffers (slots) are handed over through counters updated atomically,
+   * so no lock is taken as long as neither side has to wait. Slots are page aligned and
+   * several consecutive slots may be taken at once to be filled with readv()
+   * or emptied with writev().
+   *
+   * Checksums are computed by a separate thread which follows the reading
+   * side. Slot is reused only after it was both written and checksummed,
+   * hence checksum computation runs in parallel with writing.
+   *
+   * Data must be passed in order of increasing offset without gaps.
+   * \ingroup data
+   * \headerfile DataRingBuffer.h arc/data/DataRingBuffer.h
+   */
+  class DataRingBuffer {
+  public:
+    /// This object controls transfer speed
+    DataSpeed speed;
+    /// Construct a new DataRingBuffer object
+    /**
+     * \param size size of every slot in bytes, rounded up to memory page size.
+     * \param slots number of slots.
+     */
+    DataRingBuffer(unsigned int size = 4194304, unsigned int slots = 8);
+    /// Destructor. Waits for checksum thread to exit.
+    ~DataRingBuffer();
+    /// Returns true if DataRingBuffer object is initialized
+    operator bool() const {
+      return (mem != NULL);
+    }
+    /// Add a checksum object which will compute checksum of passed data.
+    /**
+     * Must be called before any data is passed through object.
+     * \param cksum object which will compute checksum. Should not be
+     * destroyed until DataRingBuffer itself.
+     * \return integer position in the list of checksum objects or -1
+     * if checksum can't be added anymore.
+     */
+    int add(CheckSum *cksum);
+    /// Request free slots for READING INTO them.
+    /**
+     * Fills iov with up to max consecutive free slots. Slots stay taken
+     * till is_read() is called. Calling this method again before is_read()
+     * returns the same slots.
+     * \param iov array of at least max elements
+     * \param max maximal number of slots to take
+     * \param wait if true and there are no free slots, method will wait
+     * for at least one.
+     * \return number of slots taken, 0 on error or if there are no free
+     * slots and wait is false.
+     */
+    unsigned int for_read(struct iovec* iov, unsigned int max, bool wait);
+    /// Informs object that data was read into slots taken by for_read().
+    /**
+     * Data is expected to fill taken slots sequentially, as done by readv().
+     * Slots which did not receive any data are released.
+     * \param length amount of data.
+     * \param offset offset of first byte in stream, file, etc.
+     * \return false if no slots were taken or length exceeds their size.
+     */
+    bool is_read(unsigned long long int length, unsigned long long int offset);
+    /// Request filled slots for WRITING FROM them.
+    /**
+     * Fills iov with up to max consecutive filled slots holding data
+     * contiguous in offset.
+     * \param iov array of at least max elements
+     * \param max maximal number of slots to take
+     * \param offset returns offset of first byte in returned slots
+     * \param wait if true and there are no filled slots, method will wait
+     * for at least one.
+     * \return number of slots taken, 0 on error, on end of data or if there
+     * are no filled slots and wait is false.
+     */
+    unsigned int for_write(struct iovec* iov, unsigned int max,
+                           unsigned long long int& offset, bool wait);
+    /// Informs object that data was written from slots taken by for_write().
+    /**
+     * \param n number of first taken slots which were written completely.
+     * Remaining taken slots are returned and offered again by for_write().
+     * \return false if less than n slots were taken.
+     */
+    bool is_written(unsigned int n);
+    /// Informs object if there will be no more data on 'read' side.
+    void eof_read(bool v);
+    /// Informs object if there will be no more data taken on 'write' side.
+    void eof_write(bool v);
+    /// Informs object if error occurred on 'read' side.
+    void error_read(bool v);
+    /// Informs object if error occurred on 'write' side.
+    void error_write(bool v);
+    /// Returns true if object was informed about end of transfer on 'read' side.
+    bool eof_read() const;
+    /// Returns true if object was informed about end of transfer on 'write' side.
+    bool eof_write() const;
+    /// Returns true if object was informed about error on 'read' side.
+    bool error_read() const;
+    /// Returns true if object was informed about error on 'write' side.
+    bool error_write() const;
+    /// Returns true if transfer was slower than limits set in speed object.
+    bool error_transfer() const;
+    /// Returns true if object was informed about error or internal error occurred.
+    bool error() const;
+    /// Wait (max 1 sec.) till any action happens in object.
+    void wait_any();
+    /// Wait until end of transfer or error happens on both sides.
+    void wait_eof();
+    /// Wait until checksum thread processed all data passed by 'read' side.
+    /**
+     * Returns immediately if no checksums are computed. Must be called after
+     * eof_read() or error to avoid waiting forever.
+     */
+    void wait_checksum();
+    /// Returns true if the specified checksum was successfully computed.
+    bool checksum_valid(int index) const;
+    /// Returns true if the first checksum was successfully computed.
+    bool checksum_valid() const;
+    /// Returns CheckSum object at specified index or NULL if index is not in list.
+    const CheckSum* checksum_object(int index) const;
+    /// Returns first checksum object in checksum list or NULL if list is empty.
+    const CheckSum* checksum_object() const;
+    /// Returns offset following last piece of data passed.
+    unsigned long long int eof_position() const;
+    /// Returns size of every slot.
+    unsigned int buffer_size() const { return slot_size; }
+    /// Returns number of slots.
+    unsigned int buffer_count() const { return slots_n; }
+
+  private:
+    /// internal struct to describe content of every slot
+    typedef struct {
+      unsigned int used;
+      unsigned long long int offset;
+    } slot_desc;
+    /// internal class with pointer to object to compute checksum
+    class checksum_desc {
+     public:
+      checksum_desc(CheckSum *sum)
+        : sum(sum),
+          offset(0),
+          ready(true) {}
+      CheckSum *sum;
+      unsigned long long int offset;
+      bool ready;
+    };
+    DataRingBuffer(const DataRingBuffer&);
+    DataRingBuffer& operator=(const DataRingBuffer&);
+    /// memory of all slots
+    char* mem;
+    slot_desc* slots;
+    unsigned int slot_size;
+    unsigned int slots_n;
+    /// internal class with slot counters and flags shared between threads
+    class ring_state;
+    ring_state* state;
+    /// Slots currently taken by each side
+    unsigned int taken_for_read;
+    unsigned int taken_for_write;
+    /// Lock and condition are only used for waiting
+    Glib::Mutex lock;
+    Glib::Cond cond;
+    std::list<checksum_desc> checksums;
+    SimpleCounter checksum_thread;
+    /// Wake up waiting threads if there are any
+    void notify();
+    /// Wait for change while predicate is false. Returns false on timeout.
+    bool wait_change(bool (DataRingBuffer::*ready)() const);
+    /// Slots which may be reused by 'read' side
+    unsigned long long int released() const;
+    bool have_free() const;
+    bool have_filled() const;
+    bool have_unsummed() const;
+    bool is_finished() const;
+    bool is_summed() const;
+    static void checksum_thread_start(void* arg);
+    void checksum_loop();
+  };
+
+} // namespace Arc
+
+#endif // __ARC_DATARINGBUFFER_H__
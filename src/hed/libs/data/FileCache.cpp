@@ -24,6 +24,7 @@
 #include <arc/Utils.h>
 
 #include "FileCache.h"
+#include "FileCacheIndex.h"
 
 namespace Arc {
 
@@ -208,9 +209,10 @@ namespace Arc {
       FileLock lock(filename, CACHE_LOCK_TIMEOUT);
       bool lock_removed = false;
       if (lock.acquire(lock_removed)) {
-        // if lock was invalid delete cache file
-        if (lock_removed && !FileDelete(filename.c_str()) && errno != ENOENT) {
-          logger.msg(ERROR, "Failed to delete stale cache file %s: %s", filename, StrError(errno));
+        // if lock was invalid delete cache file. It was not complete and
+        // hence was not added to index.
+        if (lock_removed) {
+          if (!FileDelete(filename.c_str()) && errno != ENOENT) logger.msg(ERROR, "Failed to delete stale cache file %s: %s", filename, StrError(errno));
         }
         if (!lock.release()) {
           logger.msg(WARNING, "Failed to release lock on file %s", filename);
@@ -243,9 +245,13 @@ namespace Arc {
       }
 
       // we have the lock, if there was a stale lock or the file was requested
-      // to be deleted, remove cache file
+      // to be deleted, remove cache file. Only complete file left by Stop()
+      // is registered in index.
       if (lock_removed || delete_first) {
-        if (!FileDelete(filename) && errno != ENOENT) {
+        if (FileDelete(filename)) {
+          if (!lock_removed) _indexRemove(url);
+        }
+        else if (errno != ENOENT) {
           logger.msg(ERROR, "Error removing cache file %s: %s", filename, StrError(errno));
           if (!lock.release())
             logger.msg(ERROR, "Failed to remove lock on %s. Some manual intervention may be required", filename);
@@ -271,10 +277,10 @@ namespace Arc {
     if (!(*this))
       return false;
 
+    std::string filename(File(url));
     // check if already unlocked in Link()
     if (_urls_unlocked.find(url) == _urls_unlocked.end()) {
 
-      std::string filename(File(url));
       // delete the lock
       FileLock lock(filename);
       if (!lock.release()) {
@@ -282,6 +288,9 @@ namespace Arc {
         return false;
       }
     }
+    // file was successfully downloaded by this process
+    struct stat fileStat;
+    if (FileStat(filename, &fileStat, true)) _indexAdd(url);
     return true;
   }
 
@@ -766,6 +775,20 @@ namespace Arc {
     return File(url) + CACHE_META_SUFFIX;
   }
 
+  void FileCache::_indexAdd(const std::string& url) {
+    std::string cache_path(_cache_map[url].cache_path);
+    if (!FileCacheIndex::Add(cache_path, FileCacheHash::getHash(url))) {
+      logger.msg(WARNING, "Failed to add %s to index of cache %s: %s", url, cache_path, StrError(errno));
+    }
+  }
+
+  void FileCache::_indexRemove(const std::string& url) {
+    std::string cache_path(_cache_map[url].cache_path);
+    if (!FileCacheIndex::Remove(cache_path, FileCacheHash::getHash(url))) {
+      logger.msg(WARNING, "Failed to remove %s from index of cache %s: %s", url, cache_path, StrError(errno));
+    }
+  }
+
   std::string FileCache::_getHash(const std::string& url) const {
     // get the hash of the url
     std::string hash = FileCacheHash::getHash(url);
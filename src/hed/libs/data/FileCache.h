@@ -116,6 +116,10 @@ namespace Arc {
     std::string _getMetaFileName(const std::string& url);
     /// Get the hashed path corresponding to the given url
     std::string _getHash(const std::string& url) const;
+    /// Register cached file of url in index of its cache, if there is one
+    void _indexAdd(const std::string& url);
+    /// Unregister cached file of url from index of its cache
+    void _indexRemove(const std::string& url);
     /// Choose a cache directory to use for this url, based on the free
     /// size of the cache directories. Returns the cache to use.
     struct CacheParameters _chooseCache(const std::string& url) const;
@@ -0,0 +1,287 @@
+// -*- indent-tabs-mode: nil -*-
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#include <arc/StringConv.h>
+
+#include "FileCacheIndex.h"
+
+namespace Arc {
+
+  const std::string FileCacheIndex::INDEX_FILE = "acix.index";
+  const std::string FileCacheIndex::REMOVED_FILE = "acix.removed";
+
+  static const char INDEX_MAGIC[8] = { 'A', 'C', 'I', 'X', 'I', 'D', 'X', '1' };
+  static const off_t INDEX_HEADER_SIZE = 32;
+  static const off_t INDEX_ENTRIES_OFFSET = 16;
+  static const unsigned char INDEX_COUNTER_MAX = 255;
+
+  // Unsigned integer of arbitrary length. ACIX hashes are computed by Python
+  // on unbounded integers, so intermediate values must not be truncated.
+  // Only operations needed by the hash functions are implemented.
+  class FileCacheIndexNumber {
+   public:
+    FileCacheIndexNumber(uint32_t value): limbs_(1, value) { }
+    uint32_t& Low(void) { return limbs_[0]; }
+    void ShiftLeft(unsigned int n) {
+      if (n == 0) return;
+      uint32_t carry = 0;
+      for (std::vector<uint32_t>::size_type i = 0; i < limbs_.size(); ++i) {
+        uint32_t limb = limbs_[i];
+        limbs_[i] = (limb << n) | carry;
+        carry = limb >> (32 - n);
+      }
+      if (carry) limbs_.push_back(carry);
+    }
+    FileCacheIndexNumber ShiftedRight(unsigned int n) const {
+      FileCacheIndexNumber result(0);
+      result.limbs_.resize(limbs_.size());
+      for (std::vector<uint32_t>::size_type i = 0; i < limbs_.size(); ++i) {
+        uint32_t limb = limbs_[i] >> n;
+        if ((n > 0) && (i + 1 < limbs_.size())) limb |= limbs_[i + 1] << (32 - n);
+        result.limbs_[i] = limb;
+      }
+      result.Trim();
+      return result;
+    }
+    void Xor(const FileCacheIndexNumber& other) {
+      if (other.limbs_.size() > limbs_.size()) limbs_.resize(other.limbs_.size(), 0);
+      for (std::vector<uint32_t>::size_type i = 0; i < other.limbs_.size(); ++i) limbs_[i] ^= other.limbs_[i];
+      Trim();
+    }
+    void Multiply(uint32_t value) {
+      uint64_t carry = 0;
+      for (std::vector<uint32_t>::size_type i = 0; i < limbs_.size(); ++i) {
+        uint64_t r = (uint64_t)limbs_[i] * value + carry;
+        limbs_[i] = (uint32_t)r;
+        carry = r >> 32;
+      }
+      if (carry) limbs_.push_back((uint32_t)carry);
+    }
+    void Add(uint32_t value) {
+      uint64_t carry = value;
+      for (std::vector<uint32_t>::size_type i = 0; (i < limbs_.size()) && carry; ++i) {
+        uint64_t r = (uint64_t)limbs_[i] + carry;
+        limbs_[i] = (uint32_t)r;
+        carry = r >> 32;
+      }
+      if (carry) limbs_.push_back((uint32_t)carry);
+    }
+    // Divisor must be smaller than 2^32
+    uint64_t Modulo(uint64_t divisor) const {
+      uint64_t r = 0;
+      for (std::vector<uint32_t>::size_type i = limbs_.size(); i > 0; --i) {
+        r = ((r << 32) | limbs_[i - 1]) % divisor;
+      }
+      return r;
+    }
+   private:
+    void Trim(void) {
+      while ((limbs_.size() > 1) && (limbs_.back() == 0)) limbs_.pop_back();
+    }
+    std::vector<uint32_t> limbs_;
+  };
+
+  // Hash functions below must produce same values as those in
+  // acix/core/hashes.py for the same key.
+
+  static uint64_t dek_hash(const std::string& key, uint64_t size) {
+    FileCacheIndexNumber hash((uint32_t)key.length());
+    for (std::string::size_type n = 0; n < key.length(); ++n) {
+      FileCacheIndexNumber right(hash.ShiftedRight(27));
+      hash.ShiftLeft(5);
+      hash.Xor(right);
+      hash.Low() ^= (unsigned char)key[n];
+    }
+    return hash.Modulo(size);
+  }
+
+  static uint64_t elf_hash(const std::string& key, uint64_t size) {
+    FileCacheIndexNumber hash(0);
+    for (std::string::size_type n = 0; n < key.length(); ++n) {
+      hash.ShiftLeft(4);
+      hash.Add((unsigned char)key[n]);
+      uint32_t x = hash.Low() & 0xF0000000;
+      if (x != 0) hash.Low() ^= (x >> 24);
+      hash.Low() &= ~x;
+    }
+    return hash.Modulo(size);
+  }
+
+  static uint64_t djb_hash(const std::string& key, uint64_t size) {
+    FileCacheIndexNumber hash(5381);
+    for (std::string::size_type n = 0; n < key.length(); ++n) {
+      // (hash << 5) + hash + k
+      hash.Multiply(33);
+      hash.Add((unsigned char)key[n]);
+    }
+    return hash.Modulo(size);
+  }
+
+  static uint64_t sdbm_hash(const std::string& key, uint64_t size) {
+    FileCacheIndexNumber hash(0);
+    for (std::string::size_type n = 0; n < key.length(); ++n) {
+      // k + (hash << 6) + (hash << 16) - hash
+      hash.Multiply(65599);
+      hash.Add((unsigned char)key[n]);
+    }
+    return hash.Modulo(size);
+  }
+
+  static uint64_t get_uint64(const unsigned char* buf) {
+    uint64_t v = 0;
+    for (int n = 7; n >= 0; --n) v = (v << 8) | buf[n];
+    return v;
+  }
+
+  static void put_uint64(unsigned char* buf, uint64_t v) {
+    for (int n = 0; n < 8; ++n) { buf[n] = (unsigned char)v; v >>= 8; }
+  }
+
+  static bool read_byte(int h, off_t offset, unsigned char& v) {
+    return (::pread(h, &v, 1, offset) == 1);
+  }
+
+  static bool write_byte(int h, off_t offset, unsigned char v) {
+    return (::pwrite(h, &v, 1, offset) == 1);
+  }
+
+  // Opens and locks index. Returns -1 on failure with errno set.
+  static int open_index(const std::string& cache_path, bool write, uint64_t& size, uint64_t& entries) {
+    std::string fname = cache_path + "/" + FileCacheIndex::INDEX_FILE;
+    int h = ::open(fname.c_str(), write ? O_RDWR : O_RDONLY);
+    if (h == -1) return -1;
+    while (::flock(h, write ? LOCK_EX : LOCK_SH) != 0) {
+      if (errno != EINTR) { int err = errno; ::close(h); errno = err; return -1; }
+    }
+    unsigned char header[INDEX_HEADER_SIZE];
+    if ((::pread(h, header, sizeof(header), 0) != (ssize_t)sizeof(header)) ||
+        (::memcmp(header, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0)) {
+      ::close(h); errno = EINVAL; return -1;
+    }
+    size = get_uint64(header + 8);
+    entries = get_uint64(header + INDEX_ENTRIES_OFFSET);
+    if ((size == 0) || (size % 8) || (size >= 0x100000000ULL)) {
+      ::close(h); errno = EINVAL; return -1;
+    }
+    return h;
+  }
+
+  static bool write_entries(int h, uint64_t entries) {
+    unsigned char buf[8];
+    put_uint64(buf, entries);
+    return (::pwrite(h, buf, sizeof(buf), INDEX_ENTRIES_OFFSET) == (ssize_t)sizeof(buf));
+  }
+
+  void FileCacheIndex::Positions(const std::string& hash, unsigned long long size, unsigned long long positions[4]) {
+    // Same order as DEFAULT_HASHES in acix/core/bloomfilter.py
+    positions[0] = dek_hash(hash, size);
+    positions[1] = elf_hash(hash, size);
+    positions[2] = djb_hash(hash, size);
+    positions[3] = sdbm_hash(hash, size);
+  }
+
+  bool FileCacheIndex::Create(const std::string& cache_path, unsigned long long size) {
+    if ((size == 0) || (size % 8) || (size >= 0x100000000ULL)) { errno = EINVAL; return false; }
+    std::string fname = cache_path + "/" + INDEX_FILE;
+    std::string tmpname = fname + "." + tostring(getpid());
+    int h = ::open(tmpname.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (h == -1) return false;
+    unsigned char header[INDEX_HEADER_SIZE];
+    ::memset(header, 0, sizeof(header));
+    ::memcpy(header, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    put_uint64(header + 8, size);
+    // Counters and bits are zeroes, sparse file is fine
+    bool r = (::pwrite(h, header, sizeof(header), 0) == (ssize_t)sizeof(header)) &&
+             (::ftruncate(h, INDEX_HEADER_SIZE + size + size / 8) == 0);
+    if (::close(h) != 0) r = false;
+    if (r && (::rename(tmpname.c_str(), fname.c_str()) == 0)) return true;
+    int err = errno;
+    ::unlink(tmpname.c_str());
+    errno = err;
+    return false;
+  }
+
+  bool FileCacheIndex::Add(const std::string& cache_path, const std::string& hash) {
+    uint64_t size = 0;
+    uint64_t entries = 0;
+    int h = open_index(cache_path, true, size, entries);
+    // Index is not maintained for this cache
+    if (h == -1) return (errno == ENOENT);
+    unsigned long long positions[4];
+    Positions(hash, size, positions);
+    bool r = true;
+    for (int n = 0; r && (n < 4); ++n) {
+      unsigned char counter = 0;
+      if (!read_byte(h, INDEX_HEADER_SIZE + positions[n], counter)) { r = false; break; }
+      if (counter == INDEX_COUNTER_MAX) continue;
+      if (counter == 0) {
+        unsigned char bits = 0;
+        off_t offset = INDEX_HEADER_SIZE + size + positions[n] / 8;
+        r = read_byte(h, offset, bits) &&
+            write_byte(h, offset, bits | (1 << (positions[n] % 8)));
+      }
+      if (r) r = write_byte(h, INDEX_HEADER_SIZE + positions[n], counter + 1);
+    }
+    if (r) r = write_entries(h, entries + 1);
+    ::close(h);
+    return r;
+  }
+
+  bool FileCacheIndex::Remove(const std::string& cache_path, const std::string& hash) {
+    uint64_t size = 0;
+    uint64_t entries = 0;
+    int h = open_index(cache_path, true, size, entries);
+    if (h == -1) return (errno == ENOENT);
+    unsigned long long positions[4];
+    Positions(hash, size, positions);
+    bool r = true;
+    for (int n = 0; r && (n < 4); ++n) {
+      unsigned char counter = 0;
+      if (!read_byte(h, INDEX_HEADER_SIZE + positions[n], counter)) { r = false; break; }
+      // Saturated counter lost track of number of files
+      if ((counter == 0) || (counter == INDEX_COUNTER_MAX)) continue;
+      --counter;
+      if (counter == 0) {
+        unsigned char bits = 0;
+        off_t offset = INDEX_HEADER_SIZE + size + positions[n] / 8;
+        r = read_byte(h, offset, bits) &&
+            write_byte(h, offset, bits & ~(1 << (positions[n] % 8)));
+      }
+      if (r) r = write_byte(h, INDEX_HEADER_SIZE + positions[n], counter);
+    }
+    if (r && (entries > 0)) r = write_entries(h, entries - 1);
+    ::close(h);
+    return r;
+  }
+
+  bool FileCacheIndex::Contains(const std::string& cache_path, const std::string& hash) {
+    uint64_t size = 0;
+    uint64_t entries = 0;
+    int h = open_index(cache_path, false, size, entries);
+    if (h == -1) return false;
+    unsigned long long positions[4];
+    Positions(hash, size, positions);
+    bool r = true;
+    for (int n = 0; r && (n < 4); ++n) {
+      unsigned char bits = 0;
+      r = read_byte(h, INDEX_HEADER_SIZE + size + positions[n] / 8, bits) &&
+          (bits & (1 << (positions[n] % 8)));
+    }
+    ::close(h);
+    return r;
+  }
+
+} // namespace Arc
@@ -0,0 +1,56 @@
+// -*- indent-tabs-mode: nil -*-
+
+#ifndef FILECACHEINDEX_H_
+#define FILECACHEINDEX_H_
+
+#include <string>
+
+namespace Arc {
+
+  /// Counting Bloom filter of files present in a cache directory.
+  /**
+   * The index is kept in file INDEX_FILE in the top level directory of cache
+   * and is what the ACIX scanner publishes instead of scanning the whole
+   * cache. It is created and seeded by the scanner with one full scan.
+   * FileCache updates it when files are added or removed, and cache-clean
+   * records removed files in REMOVED_FILE which is applied by the scanner.
+   * If there is no index in cache directory updates are silently skipped.
+   *
+   * File layout (all numbers little-endian):
+   *   8 bytes  - magic "ACIXIDX1"
+   *   8 bytes  - number of filter positions (size)
+   *   8 bytes  - number of files registered
+   *   8 bytes  - reserved
+   *   size bytes   - counters, saturated counters are never decremented
+   *   size/8 bytes - bits, set for every non-zero counter, lowest bit first
+   * The bits part is exactly the Bloom filter served by ACIX. Positions are
+   * calculated with the same hash functions (dek, elf, djb, sdbm) as used by
+   * ACIX from the hash of the URL without the directory separator. All
+   * modifications are made holding exclusive flock() on the file.
+   */
+  class FileCacheIndex {
+   public:
+    /// Name of index file in cache directory
+    static const std::string INDEX_FILE;
+    /// Name of file listing files removed outside of FileCache
+    static const std::string REMOVED_FILE;
+
+    /// Create empty index with given number of positions.
+    /**
+     * Existing index is replaced. Size must be multiple of 8 and smaller
+     * than 2^32. Normally index is created by ACIX scanner.
+     */
+    static bool Create(const std::string& cache_path, unsigned long long size);
+    /// Register file with given hash in index of cache.
+    static bool Add(const std::string& cache_path, const std::string& hash);
+    /// Unregister file with given hash from index of cache.
+    static bool Remove(const std::string& cache_path, const std::string& hash);
+    /// Check if file with given hash may be present according to index.
+    static bool Contains(const std::string& cache_path, const std::string& hash);
+    /// Calculate filter positions of hash. Exposed for testing.
+    static void Positions(const std::string& hash, unsigned long long size, unsigned long long positions[4]);
+  };
+
+} // namespace Arc
+
+#endif /*FILECACHEINDEX_H_*/
@@ -0,0 +1,198 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+// Measures throughput of passing data between reading and writing threads
+// through DataBuffer and DataRingBuffer, with and without checksum
+// computation, and of copying a local file with read/write or readv/writev.
+// Usage: DataBufferBenchmark [megabytes to pass] [directory for file copy]
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include <arc/CheckSum.h>
+#include <arc/DateTime.h>
+#include <arc/Logger.h>
+#include <arc/StringConv.h>
+#include <arc/Thread.h>
+#include <arc/data/DataBuffer.h>
+#include <arc/data/DataRingBuffer.h>
+
+static const unsigned int chunk_size = 1048576;
+static const unsigned int chunks = 8;
+
+static double rate(const Arc::Time& start, unsigned long long int bytes) {
+  Arc::Period p = Arc::Time() - start;
+  double seconds = (double)p.GetPeriod() + (double)p.GetPeriodNanoseconds() / 1000000000.0;
+  return (seconds > 0) ? (bytes / 1048576.0 / seconds) : 0;
+}
+
+// Producers pretend to read data from somewhere. Data is not touched
+// in order to measure hand-over cost only.
+
+struct buffer_arg {
+  Arc::DataBuffer* buffer;
+  unsigned long long int total;
+  int fd;
+};
+
+static void buffer_producer(void* arg) {
+  buffer_arg& a = *(buffer_arg*)arg;
+  unsigned long long int offset = 0;
+  while (offset < a.total) {
+    int h;
+    unsigned int l;
+    if (!a.buffer->for_read(h, l, true)) break;
+    if ((a.total - offset) < l) l = a.total - offset;
+    if (a.fd != -1) {
+      ssize_t ll = ::read(a.fd, (*a.buffer)[h], l);
+      if (ll <= 0) { a.buffer->is_read(h, 0, 0); break; }
+      l = ll;
+    }
+    a.buffer->is_read(h, l, offset);
+    offset += l;
+  }
+  a.buffer->eof_read(true);
+}
+
+struct ring_arg {
+  Arc::DataRingBuffer* ring;
+  unsigned long long int total;
+  unsigned int slots;
+  int fd;
+};
+
+static void ring_producer(void* arg) {
+  ring_arg& a = *(ring_arg*)arg;
+  struct iovec iov[chunks];
+  unsigned long long int offset = 0;
+  while (offset < a.total) {
+    unsigned int n = a.ring->for_read(iov, a.slots, true);
+    if (n == 0) break;
+    unsigned long long int l = 0;
+    for (unsigned int i = 0; i < n; ++i) l += iov[i].iov_len;
+    if ((a.total - offset) < l) l = a.total - offset;
+    if (a.fd != -1) {
+      ssize_t ll = ::readv(a.fd, iov, n);
+      if (ll <= 0) { a.ring->is_read(0, offset); break; }
+      l = ll;
+    }
+    a.ring->is_read(l, offset);
+    offset += l;
+  }
+  a.ring->eof_read(true);
+}
+
+static double run_buffer(unsigned long long int total, bool cksum, int in_fd, int out_fd) {
+  Arc::Adler32Sum sum;
+  Arc::DataBuffer buffer(chunk_size, chunks);
+  if (cksum) buffer.add(&sum);
+  Arc::SimpleCounter threads;
+  buffer_arg arg = { &buffer, total, in_fd };
+  Arc::Time start;
+  Arc::CreateThreadFunction(&buffer_producer, &arg, &threads);
+  for (;;) {
+    int h;
+    unsigned int l;
+    unsigned long long int p;
+    if (!buffer.for_write(h, l, p, true)) break;
+    if (out_fd != -1) {
+      if (::pwrite(out_fd, buffer[h], l, p) != (ssize_t)l) buffer.error_write(true);
+    }
+    buffer.is_written(h);
+  }
+  buffer.eof_write(true);
+  threads.wait();
+  return rate(start, buffer.eof_position());
+}
+
+static double run_ring(unsigned long long int total, bool cksum, unsigned int slots, int in_fd, int out_fd) {
+  Arc::Adler32Sum sum;
+  Arc::DataRingBuffer ring(chunk_size, chunks);
+  if (cksum) ring.add(&sum);
+  Arc::SimpleCounter threads;
+  ring_arg arg = { &ring, total, slots, in_fd };
+  Arc::Time start;
+  Arc::CreateThreadFunction(&ring_producer, &arg, &threads);
+  struct iovec iov[chunks];
+  for (;;) {
+    unsigned long long int p;
+    unsigned int n = ring.for_write(iov, slots, p, true);
+    if (n == 0) break;
+    if (out_fd != -1) {
+      ssize_t l = 0;
+      for (unsigned int i = 0; i < n; ++i) l += iov[i].iov_len;
+      if ((::lseek(out_fd, p, SEEK_SET) != (off_t)p) || (::writev(out_fd, iov, n) != l)) ring.error_write(true);
+    }
+    ring.is_written(n);
+  }
+  ring.eof_write(true);
+  threads.wait();
+  ring.wait_checksum();
+  return rate(start, ring.eof_position());
+}
+
+int main(int argc, char **argv) {
+  unsigned long long int megabytes = 4096;
+  std::string dir;
+  if (argc > 1 && !Arc::stringto(argv[1], megabytes)) {
+    std::cerr << "Usage: " << argv[0] << " [megabytes to pass] [directory for file copy]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (argc > 2) dir = argv[2];
+  Arc::LogStream logcerr(std::cerr);
+  Arc::Logger::getRootLogger().addDestination(logcerr);
+  Arc::Logger::getRootLogger().setThreshold(Arc::ERROR);
+
+  unsigned long long int total = megabytes * 1048576;
+  for (int cksum = 0; cksum < 2; ++cksum) {
+    std::string suffix = cksum ? ", adler32" : "";
+    std::cout << "DataBuffer" << suffix << ": "
+              << run_buffer(total, cksum, -1, -1) << " MB/s" << std::endl;
+    std::cout << "DataRingBuffer single slot" << suffix << ": "
+              << run_ring(total, cksum, 1, -1, -1) << " MB/s" << std::endl;
+    std::cout << "DataRingBuffer vectored" << suffix << ": "
+              << run_ring(total, cksum, chunks, -1, -1) << " MB/s" << std::endl;
+  }
+
+  if (dir.empty()) return EXIT_SUCCESS;
+
+  // Copy of local file. Source is created first and should stay in page cache.
+  std::string src = dir + "/DataBufferBenchmark.src";
+  std::string dst = dir + "/DataBufferBenchmark.dst";
+  int fd = ::open(src.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+  if (fd == -1) {
+    std::cerr << "Failed to create " << src << std::endl;
+    return EXIT_FAILURE;
+  }
+  char* data = new char[chunk_size];
+  std::memset(data, 0x5a, chunk_size);
+  for (unsigned long long int n = 0; n < megabytes; ++n) {
+    if (::write(fd, data, chunk_size) != (ssize_t)chunk_size) break;
+  }
+  delete[] data;
+  ::close(fd);
+  for (int mode = 0; mode < 2; ++mode) {
+    int in_fd = ::open(src.c_str(), O_RDONLY);
+    int out_fd = ::open(dst.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if ((in_fd == -1) || (out_fd == -1)) {
+      std::cerr << "Failed to open files in " << dir << std::endl;
+      return EXIT_FAILURE;
+    }
+    double r = mode ? run_ring(total, true, chunks, in_fd, out_fd)
+                    : run_buffer(total, true, in_fd, out_fd);
+    std::cout << (mode ? "File copy readv/writev through DataRingBuffer"
+                       : "File copy read/write through DataBuffer")
+              << ", adler32: " << r << " MB/s" << std::endl;
+    ::close(in_fd);
+    ::close(out_fd);
+  }
+  (void)::unlink(src.c_str());
+  (void)::unlink(dst.c_str());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,289 @@
+// -*- indent-tabs-mode: nil -*-
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include <arc/CheckSum.h>
+#include <arc/FileUtils.h>
+#include <arc/Thread.h>
+
+#include "../DataRingBuffer.h"
+
+class DataRingBufferTest
+  : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(DataRingBufferTest);
+  CPPUNIT_TEST(testOrdering);
+  CPPUNIT_TEST(testPartialWrite);
+  CPPUNIT_TEST(testReadError);
+  CPPUNIT_TEST(testWriteError);
+  CPPUNIT_TEST(testVectoredIO);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void testOrdering();
+  void testPartialWrite();
+  void testReadError();
+  void testWriteError();
+  void testVectoredIO();
+
+  void setUp();
+  void tearDown();
+
+private:
+  std::string tmpdir;
+};
+
+// Byte expected at given offset of test data
+static char pattern(unsigned long long int offset) {
+  return (char)((offset * 7 + offset / 251) & 0xff);
+}
+
+struct producer_arg {
+  Arc::DataRingBuffer* ring;
+  unsigned long long int size;
+  // file to read from with readv(), otherwise pattern is generated
+  int fd;
+  // length passed in every is_read() call if no file is used
+  unsigned int chunk;
+};
+
+static void producer(void* arg) {
+  producer_arg& a = *(producer_arg*)arg;
+  struct iovec iov[8];
+  unsigned long long int offset = 0;
+  while (offset < a.size) {
+    unsigned int n = a.ring->for_read(iov, 8, true);
+    if (n == 0) return;
+    unsigned long long int l = 0;
+    if (a.fd != -1) {
+      ssize_t r = ::readv(a.fd, iov, n);
+      if (r < 0) {
+        a.ring->is_read(0, offset);
+        a.ring->error_read(true);
+        return;
+      }
+      l = r;
+    } else {
+      // Fill slots only partially so that slots carry different amounts
+      l = a.chunk;
+      if (l > (unsigned long long int)n * iov[0].iov_len) l = (unsigned long long int)n * iov[0].iov_len;
+      if (l > a.size - offset) l = a.size - offset;
+      for (unsigned long long int i = 0; i < l; ++i) {
+        ((char*)(iov[i / iov[0].iov_len].iov_base))[i % iov[0].iov_len] = pattern(offset + i);
+      }
+    }
+    a.ring->is_read(l, offset);
+    if (l == 0) break;
+    offset += l;
+  }
+  a.ring->eof_read(true);
+}
+
+void DataRingBufferTest::setUp() {
+  tmpdir.clear();
+  CPPUNIT_ASSERT(Arc::TmpDirCreate(tmpdir));
+}
+
+void DataRingBufferTest::tearDown() {
+  Arc::DirDelete(tmpdir);
+}
+
+void DataRingBufferTest::testOrdering() {
+  Arc::DataRingBuffer ring(4096, 4);
+  CPPUNIT_ASSERT(ring);
+  Arc::CRC32Sum direct_sum;
+  Arc::CRC32Sum ring_sum;
+  CPPUNIT_ASSERT_EQUAL(0, ring.add(&ring_sum));
+  direct_sum.start();
+
+  producer_arg arg;
+  arg.ring = &ring;
+  arg.size = 1000000;
+  arg.fd = -1;
+  arg.chunk = 3000;
+  Arc::SimpleCounter threads;
+  CPPUNIT_ASSERT(Arc::CreateThreadFunction(&producer, &arg, &threads));
+
+  struct iovec iov[3];
+  unsigned long long int expected = 0;
+  bool correct = true;
+  for (;;) {
+    unsigned long long int offset = 0;
+    unsigned int n = ring.for_write(iov, 3, offset, true);
+    if (n == 0) break;
+    // Data comes in order and without gaps
+    if (offset != expected) correct = false;
+    for (unsigned int i = 0; i < n; ++i) {
+      for (unsigned int j = 0; j < iov[i].iov_len; ++j) {
+        if (((char*)iov[i].iov_base)[j] != pattern(expected + j)) correct = false;
+      }
+      direct_sum.add(iov[i].iov_base, iov[i].iov_len);
+      expected += iov[i].iov_len;
+    }
+    CPPUNIT_ASSERT(ring.is_written(n));
+  }
+  ring.eof_write(true);
+  threads.wait();
+  direct_sum.end();
+
+  CPPUNIT_ASSERT(correct);
+  CPPUNIT_ASSERT_EQUAL(arg.size, expected);
+  CPPUNIT_ASSERT(!ring.error());
+  CPPUNIT_ASSERT(ring.eof_read());
+  CPPUNIT_ASSERT_EQUAL(arg.size, ring.eof_position());
+
+  // Checksum computed by separate thread matches data passed
+  ring.wait_checksum();
+  CPPUNIT_ASSERT(ring.checksum_valid());
+  char direct_str[Arc::CheckSum::MaxPrintLength];
+  char ring_str[Arc::CheckSum::MaxPrintLength];
+  direct_sum.print(direct_str, sizeof(direct_str));
+  ring.checksum_object()->print(ring_str, sizeof(ring_str));
+  CPPUNIT_ASSERT_EQUAL(std::string(direct_str), std::string(ring_str));
+}
+
+void DataRingBufferTest::testPartialWrite() {
+  Arc::DataRingBuffer ring(4096, 4);
+  CPPUNIT_ASSERT(ring);
+  unsigned int slot = ring.buffer_size();
+
+  struct iovec iov[4];
+  CPPUNIT_ASSERT_EQUAL(4U, ring.for_read(iov, 4, false));
+  for (unsigned int i = 0; i < 4; ++i) memset(iov[i].iov_base, '0' + i, slot);
+  // Last slot is left empty and is released
+  CPPUNIT_ASSERT(ring.is_read(3 * slot, 0));
+  // Slots must be taken before passing data
+  CPPUNIT_ASSERT(!ring.is_read(slot, 3 * slot));
+
+  unsigned long long int offset = 1;
+  CPPUNIT_ASSERT_EQUAL(3U, ring.for_write(iov, 4, offset, false));
+  CPPUNIT_ASSERT_EQUAL(0ULL, offset);
+  // Only first slot was written, rest is offered again
+  CPPUNIT_ASSERT(!ring.is_written(4));
+  CPPUNIT_ASSERT_EQUAL(3U, ring.for_write(iov, 4, offset, false));
+  CPPUNIT_ASSERT(ring.is_written(1));
+  CPPUNIT_ASSERT_EQUAL(2U, ring.for_write(iov, 4, offset, false));
+  CPPUNIT_ASSERT_EQUAL((unsigned long long int)slot, offset);
+  CPPUNIT_ASSERT_EQUAL('1', ((char*)iov[0].iov_base)[0]);
+  CPPUNIT_ASSERT_EQUAL('2', ((char*)iov[1].iov_base)[0]);
+  CPPUNIT_ASSERT(ring.is_written(2));
+
+  // Nothing left and no end of data yet
+  CPPUNIT_ASSERT_EQUAL(0U, ring.for_write(iov, 4, offset, false));
+  CPPUNIT_ASSERT(!ring.eof_read());
+  ring.eof_read(true);
+  CPPUNIT_ASSERT_EQUAL(0U, ring.for_write(iov, 4, offset, true));
+  ring.eof_write(true);
+  ring.wait_eof();
+  CPPUNIT_ASSERT(!ring.error());
+}
+
+void DataRingBufferTest::testReadError() {
+  Arc::DataRingBuffer ring(4096, 2);
+  CPPUNIT_ASSERT(ring);
+  struct iovec iov[2];
+  CPPUNIT_ASSERT_EQUAL(2U, ring.for_read(iov, 2, false));
+  CPPUNIT_ASSERT(ring.is_read(100, 0));
+
+  ring.error_read(true);
+  CPPUNIT_ASSERT(ring.error());
+  CPPUNIT_ASSERT(ring.error_read());
+  CPPUNIT_ASSERT(!ring.error_write());
+  // Error on reading side ends its data
+  CPPUNIT_ASSERT(ring.eof_read());
+  // Writing side gets no more data, even already passed, and does not wait
+  unsigned long long int offset = 0;
+  CPPUNIT_ASSERT_EQUAL(0U, ring.for_write(iov, 2, offset, true));
+  // Later error on other side is not recorded as its own
+  ring.error_write(true);
+  CPPUNIT_ASSERT(!ring.error_write());
+  CPPUNIT_ASSERT(ring.eof_write());
+  ring.wait_eof();
+}
+
+void DataRingBufferTest::testWriteError() {
+  Arc::DataRingBuffer ring(4096, 2);
+  CPPUNIT_ASSERT(ring);
+  Arc::CRC32Sum sum;
+  CPPUNIT_ASSERT_EQUAL(0, ring.add(&sum));
+  struct iovec iov[2];
+  CPPUNIT_ASSERT_EQUAL(2U, ring.for_read(iov, 2, false));
+  CPPUNIT_ASSERT(ring.is_read(2 * ring.buffer_size(), 0));
+  // Ring is full
+  CPPUNIT_ASSERT_EQUAL(0U, ring.for_read(iov, 2, false));
+
+  ring.error_write(true);
+  CPPUNIT_ASSERT(ring.error());
+  CPPUNIT_ASSERT(ring.error_write());
+  CPPUNIT_ASSERT(ring.eof_write());
+  // Reading side waiting for free slot is released
+  CPPUNIT_ASSERT_EQUAL(0U, ring.for_read(iov, 2, true));
+  ring.eof_read(true);
+  ring.wait_eof();
+  // Checksum thread stops too
+  ring.wait_checksum();
+}
+
+void DataRingBufferTest::testVectoredIO() {
+  // Size not aligned to slots
+  const unsigned long long int size = 5 * 4096 * 3 + 1234;
+  std::string data;
+  for (unsigned long long int n = 0; n < size; ++n) data += pattern(n);
+  std::string source = tmpdir + "/source";
+  std::string dest = tmpdir + "/dest";
+  CPPUNIT_ASSERT(Arc::FileCreate(source, data));
+
+  Arc::DataRingBuffer ring(4096, 5);
+  CPPUNIT_ASSERT(ring);
+  producer_arg arg;
+  arg.ring = &ring;
+  arg.size = size;
+  arg.fd = ::open(source.c_str(), O_RDONLY);
+  arg.chunk = 0;
+  CPPUNIT_ASSERT(arg.fd != -1);
+  int dest_fd = ::open(dest.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+  CPPUNIT_ASSERT(dest_fd != -1);
+
+  Arc::SimpleCounter threads;
+  CPPUNIT_ASSERT(Arc::CreateThreadFunction(&producer, &arg, &threads));
+  struct iovec iov[5];
+  bool written = true;
+  for (;;) {
+    unsigned long long int offset = 0;
+    unsigned int n = ring.for_write(iov, 5, offset, true);
+    if (n == 0) break;
+    ssize_t expected = 0;
+    for (unsigned int i = 0; i < n; ++i) expected += iov[i].iov_len;
+    if (::pwritev(dest_fd, iov, n, offset) != expected) {
+      written = false;
+      ring.is_written(0);
+      ring.error_write(true);
+      break;
+    }
+    ring.is_written(n);
+  }
+  ring.eof_write(true);
+  threads.wait();
+  ::close(arg.fd);
+  ::close(dest_fd);
+
+  CPPUNIT_ASSERT(written);
+  CPPUNIT_ASSERT(!ring.error());
+  CPPUNIT_ASSERT_EQUAL(size, ring.eof_position());
+  std::string copy;
+  CPPUNIT_ASSERT(Arc::FileRead(dest, copy));
+  CPPUNIT_ASSERT_EQUAL(data.size(), copy.size());
+  CPPUNIT_ASSERT(data == copy);
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DataRingBufferTest);
@@ -20,6 +20,7 @@
 #include <arc/FileAccess.h>
 
 #include "../FileCache.h"
+#include "../FileCacheIndex.h"
 
 class FileCacheTest
   : public CppUnit::TestFixture {
@@ -39,6 +40,7 @@ class FileCacheTest
   CPPUNIT_TEST(testConstructor);
   CPPUNIT_TEST(testBadConstructor);
   CPPUNIT_TEST(testInternal);
+  CPPUNIT_TEST(testIndex);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -60,6 +62,7 @@ public:
   void testConstructor();
   void testBadConstructor();
   void testInternal();
+  void testIndex();
 
 private:
   std::string _testroot;
@@ -947,6 +950,69 @@ void FileCacheTest::testInternal() {
   CPPUNIT_ASSERT(stat(testfile.c_str(), &fileStat) != 0);
 }
 
+void FileCacheTest::testIndex() {
+
+  // positions must be same as calculated by ACIX bloom filter for this key
+  unsigned long long positions[4];
+  Arc::FileCacheIndex::Positions("0a1b2c3d4e5f60718293a4b5c6d7e8f901234567", 95872, positions);
+  CPPUNIT_ASSERT_EQUAL(94116ULL, positions[0]);
+  CPPUNIT_ASSERT_EQUAL(84967ULL, positions[1]);
+  CPPUNIT_ASSERT_EQUAL(22309ULL, positions[2]);
+  CPPUNIT_ASSERT_EQUAL(41476ULL, positions[3]);
+
+  // without index updates are skipped
+  std::string hash(Arc::FileCacheHash::getHash(_url));
+  CPPUNIT_ASSERT(Arc::FileCacheIndex::Add(_cache_dir, hash));
+  CPPUNIT_ASSERT(!Arc::FileCacheIndex::Contains(_cache_dir, hash));
+
+  CPPUNIT_ASSERT(Arc::DirCreate(_cache_dir, 0700, true));
+  CPPUNIT_ASSERT(Arc::FileCacheIndex::Create(_cache_dir, 95872));
+  CPPUNIT_ASSERT(!Arc::FileCacheIndex::Contains(_cache_dir, hash));
+
+  // downloaded file is registered
+  bool available = false;
+  bool is_locked = false;
+  CPPUNIT_ASSERT(_fc1->Start(_url, available, is_locked));
+  CPPUNIT_ASSERT(!available);
+  std::string cache_file(_fc1->File(_url));
+  CPPUNIT_ASSERT(_createFile(cache_file));
+  CPPUNIT_ASSERT(_fc1->Stop(_url));
+  CPPUNIT_ASSERT(Arc::FileCacheIndex::Contains(_cache_dir, hash));
+
+  // deleted file is unregistered
+  CPPUNIT_ASSERT(_fc1->Start(_url, available, is_locked, true));
+  CPPUNIT_ASSERT(!available);
+  CPPUNIT_ASSERT(!Arc::FileCacheIndex::Contains(_cache_dir, hash));
+
+  // failed download is not registered
+  CPPUNIT_ASSERT(_fc1->StopAndDelete(_url));
+  CPPUNIT_ASSERT(!Arc::FileCacheIndex::Contains(_cache_dir, hash));
+
+  // partial file left with stale lock was never registered, so removing it
+  // must not decrement counters shared with other files
+  CPPUNIT_ASSERT(Arc::FileCacheIndex::Add(_cache_dir, hash));
+  CPPUNIT_ASSERT(_fc1->Start(_url, available, is_locked));
+  CPPUNIT_ASSERT(_createFile(cache_file));
+  struct utimbuf times;
+  times.actime = 1;
+  times.modtime = 1;
+  CPPUNIT_ASSERT_EQUAL(0, utime(std::string(cache_file + ".lock").c_str(), &times));
+  CPPUNIT_ASSERT(_fc1->Start(_url, available, is_locked));
+  CPPUNIT_ASSERT(!available);
+  CPPUNIT_ASSERT(Arc::FileCacheIndex::Contains(_cache_dir, hash));
+  CPPUNIT_ASSERT(_fc1->StopAndDelete(_url));
+  CPPUNIT_ASSERT(Arc::FileCacheIndex::Remove(_cache_dir, hash));
+  CPPUNIT_ASSERT(!Arc::FileCacheIndex::Contains(_cache_dir, hash));
+
+  // counters keep files sharing positions
+  CPPUNIT_ASSERT(Arc::FileCacheIndex::Add(_cache_dir, hash));
+  CPPUNIT_ASSERT(Arc::FileCacheIndex::Add(_cache_dir, hash));
+  CPPUNIT_ASSERT(Arc::FileCacheIndex::Remove(_cache_dir, hash));
+  CPPUNIT_ASSERT(Arc::FileCacheIndex::Contains(_cache_dir, hash));
+  CPPUNIT_ASSERT(Arc::FileCacheIndex::Remove(_cache_dir, hash));
+  CPPUNIT_ASSERT(!Arc::FileCacheIndex::Contains(_cache_dir, hash));
+}
+
 bool FileCacheTest::_createFile(std::string filename, std::string text) {
 
   if (Arc::FileCreate(filename, text))
@@ -91,6 +91,11 @@ class PayloadStream: virtual public PayloadStreamInterface {
   virtual Size_t Pos(void) const { return 0; };
   virtual Size_t Size(void) const { return 0; };
   virtual Size_t Limit(void) const { return 0; };
+  /** Returns handle used for operations. It is meant for destinations
+    which can transfer data directly from handle, like by using sendfile().
+    Position of handle must be kept consistent with Pos().
+    \since Added in 6.9.0. */
+  int GetHandle(void) const { return handle_; };
 };
 }
 #endif /* __ARC_PAYLOADSTREAM_H__ */
@@ -980,7 +980,14 @@ bool PayloadHTTPOut::FlushHeader(PayloadStreamInterface& stream) {
 bool PayloadHTTPOut::FlushBody(PayloadStreamInterface& stream) {
     // TODO: process 100 request/response
     if((length_ > 0) || (use_chunked_transfer_)) {
-      if(sbody_) {
+      if(sbody_ && !use_chunked_transfer_) {
+        // Size is known - destination may pass data without copying,
+        // like socket sending regular file with sendfile().
+        if(!stream.Put(*sbody_,length_)) {
+          error_ = IString("Failed to write body to output stream").str();
+          return false;
+        };
+      } else if(sbody_) {
         // stream to stream transfer
         // TODO: choose optimal buffer size
         // TODO: parallel read and write for better performance
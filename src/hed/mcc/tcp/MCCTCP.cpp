@@ -13,6 +13,9 @@
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <netdb.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 #define ErrNo errno
 
 #include <arc/message/PayloadStream.h>
@@ -67,7 +70,7 @@ namespace ArcMCCTCP {
 using namespace Arc;
 
 
-MCC_TCP_Service::MCC_TCP_Service(Config *cfg, PluginArgument* parg):MCC_TCP(cfg,parg),valid_(false),max_executers_(-1),max_executers_drop_(false) {
+MCC_TCP_Service::MCC_TCP_Service(Config *cfg, PluginArgument* parg):MCC_TCP(cfg,parg),valid_(false),max_executers_(-1),max_executers_drop_(false),workers_(0),epoll_handle_(-1),threads_(0),stopping_(false),busy_(0) {
     for(int i = 0;;++i) {
         struct addrinfo hint;
         struct addrinfo *info = NULL;
@@ -208,6 +211,51 @@ MCC_TCP_Service::MCC_TCP_Service(Config *cfg, PluginArgument* parg):MCC_TCP(cfg,
         logger.msg(INFO, "Setting connections limit to %i, connections over limit will be %s",max_executers_,max_executers_drop_?istring("dropped"):istring("put on hold"));
       };
     };
+    if((*cfg)["Mode"]) {
+      std::string v = (*cfg)["Mode"];
+      if(v == "epoll") {
+#ifdef HAVE_SYS_EPOLL_H
+        workers_ = 16;
+        std::string w = (*cfg)["Mode"].Attribute("workers");
+        if(!w.empty()) workers_ = atoi(w.c_str());
+        if(workers_ <= 0) {
+          logger.msg(ERROR, "Number of workers must be positive");
+          for(std::list<mcc_tcp_handle_t>::iterator i = handles_.begin();i!=handles_.end();i=handles_.erase(i)) ::close(i->handle);
+          return;
+        };
+        epoll_handle_ = epoll_create(1024);
+        if(epoll_handle_ == -1) {
+          logger.msg(WARNING, "Failed to create event loop, using thread per connection: %s", StrError(errno));
+          workers_ = 0;
+        };
+#else
+        logger.msg(WARNING, "Event based connection handling is not supported on this platform, using thread per connection");
+#endif
+      } else if(v != "thread") {
+        logger.msg(ERROR, "Mode element can't be recognized: %s", v);
+        for(std::list<mcc_tcp_handle_t>::iterator i = handles_.begin();i!=handles_.end();i=handles_.erase(i)) ::close(i->handle);
+        return;
+      };
+    };
+    if(workers_ > 0) {
+      lock_.lock();
+      if(CreateThreadFunction(&events,this)) ++threads_;
+      for(int n = 0; n < workers_; ++n) {
+        if(CreateThreadFunction(&worker,this)) ++threads_;
+      };
+      if(threads_ < 2) {
+        // Need at least event loop and one worker
+        logger.msg(ERROR, "Failed to start threads for event based connection handling");
+        // Started threads are waited for in destructor
+        stopping_ = true;
+        ready_cond_.broadcast();
+        lock_.unlock();
+        for(std::list<mcc_tcp_handle_t>::iterator i = handles_.begin();i!=handles_.end();i=handles_.erase(i)) ::close(i->handle);
+        return;
+      };
+      logger.msg(INFO, "Using event based connection handling with %i workers", threads_-1);
+      lock_.unlock();
+    };
     if(!CreateThreadFunction(&listener,this)) {
         logger.msg(ERROR, "Failed to start thread for listening");
         for(std::list<mcc_tcp_handle_t>::iterator i = handles_.begin();i!=handles_.end();i=handles_.erase(i)) ::close(i->handle);
@@ -227,6 +275,13 @@ MCC_TCP_Service::~MCC_TCP_Service(void) {
     if(!valid_) {
         for(std::list<mcc_tcp_handle_t>::iterator i = handles_.begin();i!=handles_.end();i=handles_.erase(i)) { };
     };
+    // Wake up event loop and workers. Connections being processed
+    // are shut down to make workers leave them quickly.
+    stopping_ = true;
+    ready_cond_.broadcast();
+    for(std::set<mcc_tcp_conn_t*>::iterator c = connections_.begin();c != connections_.end();++c) {
+        if(!((*c)->parked)) ::shutdown((*c)->handle,2);
+    };
     // Wait for threads to exit
     while(executers_.size() > 0) {
         lock_.unlock(); sleep(1); lock_.lock();
@@ -234,6 +289,11 @@ MCC_TCP_Service::~MCC_TCP_Service(void) {
     while(handles_.size() > 0) {
         lock_.unlock(); sleep(1); lock_.lock();
     };
+    while(threads_ > 0) {
+        lock_.unlock(); sleep(1); lock_.lock();
+    };
+    while(connections_.size() > 0) close_connection(*(connections_.begin()));
+    if(epoll_handle_ != -1) ::close(epoll_handle_);
     lock_.unlock();
 }
 
@@ -296,8 +356,9 @@ void MCC_TCP_Service::listener(void* arg) {
                     it.lock_.lock();
                     bool rejected = false;
                     bool first_time = true;
+                    // In event mode only connections being processed are counted
                     while((it.max_executers_ > 0) &&
-                          (it.executers_.size() >= (size_t) it.max_executers_)) {
+                          ((it.executers_.size() + (size_t)it.busy_) >= (size_t) it.max_executers_)) {
                         if(it.max_executers_drop_) {
                             logger.msg(WARNING, "Too many connections - dropping new one");
                             ::shutdown(h,2);
@@ -315,7 +376,11 @@ void MCC_TCP_Service::listener(void* arg) {
                         };
                     };
                     if(!rejected) {
-                      mcc_tcp_exec_t t(&it,h,i->timeout,i->no_delay);
+                      if(it.workers_ > 0) {
+                        it.add_connection(h,i->timeout,i->no_delay);
+                      } else {
+                        mcc_tcp_exec_t t(&it,h,i->timeout,i->no_delay);
+                      };
                     };
                 };
             };
@@ -471,96 +536,95 @@ static bool get_host_port(struct sockaddr_storage *addr, std::string &host, std:
     return true;
 }
 
-void MCC_TCP_Service::executer(void* arg) {
-    MCC_TCP_Service& it = *(((mcc_tcp_exec_t*)arg)->obj);
-    int s = ((mcc_tcp_exec_t*)arg)->handle;
-    int no_delay = ((mcc_tcp_exec_t*)arg)->no_delay;
-    int timeout = ((mcc_tcp_exec_t*)arg)->timeout;
-    std::string host_attr,port_attr;
-    std::string remotehost_attr,remoteport_attr;
-    std::string endpoint_attr;
+MCC_TCP_Service::mcc_tcp_conn_t::mcc_tcp_conn_t(int h,int t,bool nd):handle(h),stream(h,t,logger),parked(false),last_active(time(NULL)) {
     // Extract useful attributes
-    {
-        struct sockaddr_storage addr;
-        socklen_t addrlen;
-        addrlen=sizeof(addr);
-        if(getsockname(s, (struct sockaddr*)(&addr), &addrlen) == 0) {
-            if (get_host_port(&addr, host_attr, port_attr) == true) {
-                endpoint_attr = "://"+host_attr+":"+port_attr;
-            }
-        }
-        if(getpeername(s, (struct sockaddr*)&addr, &addrlen) == 0) {
-            get_host_port(&addr, remotehost_attr, remoteport_attr);
+    struct sockaddr_storage addr;
+    socklen_t addrlen;
+    addrlen=sizeof(addr);
+    if(getsockname(h, (struct sockaddr*)(&addr), &addrlen) == 0) {
+        if (get_host_port(&addr, host_attr, port_attr) == true) {
+            endpoint_attr = "://"+host_attr+":"+port_attr;
         }
-        // SESSIONID
-    };
+    }
+    if(getpeername(h, (struct sockaddr*)&addr, &addrlen) == 0) {
+        get_host_port(&addr, remotehost_attr, remoteport_attr);
+    }
+    // SESSIONID
+    stream.NoDelay(nd);
+}
 
-    // Creating stream payload
-    PayloadTCPSocket stream(s, timeout, logger);
-    stream.NoDelay(no_delay);
-    MessageContext context;
-    MessageAuthContext auth_context;
-    for(;;) {
-        // TODO: Check state of socket here and leave immediately if not connected anymore.
-        // Preparing Message objects for chain
-        MessageAttributes attributes_in;
-        MessageAttributes attributes_out;
-        MessageAuth auth_in;
-        MessageAuth auth_out;
-        Message nextinmsg;
-        Message nextoutmsg;
-        nextinmsg.Payload(&stream);
-        nextinmsg.Attributes(&attributes_in);
-        nextinmsg.Attributes()->set("TCP:HOST",host_attr);
-        nextinmsg.Attributes()->set("TCP:PORT",port_attr);
-        nextinmsg.Attributes()->set("TCP:REMOTEHOST",remotehost_attr);
-        nextinmsg.Attributes()->set("TCP:REMOTEPORT",remoteport_attr);
-        nextinmsg.Attributes()->set("TCP:ENDPOINT",endpoint_attr);
-        nextinmsg.Attributes()->set("ENDPOINT",endpoint_attr);
-        nextinmsg.Context(&context);
-        nextinmsg.Auth(&auth_in);
-        TCPSecAttr* tattr = new TCPSecAttr(remotehost_attr, remoteport_attr, host_attr, port_attr);
-        nextinmsg.Auth()->set("TCP",tattr);
-        nextinmsg.AuthContext(&auth_context);
-        nextoutmsg.Attributes(&attributes_out);
-        nextoutmsg.Context(&context);
-        nextoutmsg.Auth(&auth_out);
-        nextoutmsg.AuthContext(&auth_context);
-        if(!it.ProcessSecHandlers(nextinmsg,"incoming")) break;
-        // Call next MCC
-        MCCInterface* next = it.Next();
-        if(!next) break;
-        logger.msg(VERBOSE, "next chain element called");
-        MCC_Status ret = next->process(nextinmsg,nextoutmsg);
-        if(!it.ProcessSecHandlers(nextoutmsg,"outgoing")) {
-          if(nextoutmsg.Payload()) delete nextoutmsg.Payload();
-          break;
-        };
-        // If nextoutmsg contains some useful payload send it here.
-        // So far only buffer payload is supported
-        // Extracting payload
-        if(nextoutmsg.Payload()) {
-            PayloadRawInterface* outpayload = NULL;
-            try {
-                outpayload = dynamic_cast<PayloadRawInterface*>(nextoutmsg.Payload());
-            } catch(std::exception& e) { };
-            if(!outpayload) {
-                logger.msg(WARNING, "Only Raw Buffer payload is supported for output");
-            } else {
-                // Sending payload
-                for(int n=0;;++n) {
-                    char* buf = outpayload->Buffer(n);
-                    if(!buf) break;
-                    int bufsize = outpayload->BufferSize(n);
-                    if(!(stream.Put(buf,bufsize))) {
-                        logger.msg(ERROR, "Failed to send content of buffer");
-                        break;
-                    };
+bool MCC_TCP_Service::process_request(mcc_tcp_conn_t& conn) {
+    // TODO: Check state of socket here and leave immediately if not connected anymore.
+    // Preparing Message objects for chain
+    MessageAttributes attributes_in;
+    MessageAttributes attributes_out;
+    MessageAuth auth_in;
+    MessageAuth auth_out;
+    Message nextinmsg;
+    Message nextoutmsg;
+    nextinmsg.Payload(&conn.stream);
+    nextinmsg.Attributes(&attributes_in);
+    nextinmsg.Attributes()->set("TCP:HOST",conn.host_attr);
+    nextinmsg.Attributes()->set("TCP:PORT",conn.port_attr);
+    nextinmsg.Attributes()->set("TCP:REMOTEHOST",conn.remotehost_attr);
+    nextinmsg.Attributes()->set("TCP:REMOTEPORT",conn.remoteport_attr);
+    nextinmsg.Attributes()->set("TCP:ENDPOINT",conn.endpoint_attr);
+    nextinmsg.Attributes()->set("ENDPOINT",conn.endpoint_attr);
+    nextinmsg.Context(&conn.context);
+    nextinmsg.Auth(&auth_in);
+    TCPSecAttr* tattr = new TCPSecAttr(conn.remotehost_attr, conn.remoteport_attr, conn.host_attr, conn.port_attr);
+    nextinmsg.Auth()->set("TCP",tattr);
+    nextinmsg.AuthContext(&conn.auth_context);
+    nextoutmsg.Attributes(&attributes_out);
+    nextoutmsg.Context(&conn.context);
+    nextoutmsg.Auth(&auth_out);
+    nextoutmsg.AuthContext(&conn.auth_context);
+    if(!ProcessSecHandlers(nextinmsg,"incoming")) return false;
+    // Call next MCC
+    MCCInterface* next = Next();
+    if(!next) return false;
+    logger.msg(VERBOSE, "next chain element called");
+    MCC_Status ret = next->process(nextinmsg,nextoutmsg);
+    if(!ProcessSecHandlers(nextoutmsg,"outgoing")) {
+      if(nextoutmsg.Payload()) delete nextoutmsg.Payload();
+      return false;
+    };
+    // If nextoutmsg contains some useful payload send it here.
+    // So far only buffer payload is supported
+    // Extracting payload
+    if(nextoutmsg.Payload()) {
+        PayloadRawInterface* outpayload = NULL;
+        try {
+            outpayload = dynamic_cast<PayloadRawInterface*>(nextoutmsg.Payload());
+        } catch(std::exception& e) { };
+        if(!outpayload) {
+            logger.msg(WARNING, "Only Raw Buffer payload is supported for output");
+        } else {
+            // Sending payload
+            for(int n=0;;++n) {
+                char* buf = outpayload->Buffer(n);
+                if(!buf) break;
+                int bufsize = outpayload->BufferSize(n);
+                if(!(conn.stream.Put(buf,bufsize))) {
+                    logger.msg(ERROR, "Failed to send content of buffer");
+                    break;
                 };
             };
-            delete nextoutmsg.Payload();
         };
-        if(!ret) break;
+        delete nextoutmsg.Payload();
+    };
+    if(!ret) return false;
+    return true;
+}
+
+void MCC_TCP_Service::executer(void* arg) {
+    MCC_TCP_Service& it = *(((mcc_tcp_exec_t*)arg)->obj);
+    int s = ((mcc_tcp_exec_t*)arg)->handle;
+    int no_delay = ((mcc_tcp_exec_t*)arg)->no_delay;
+    int timeout = ((mcc_tcp_exec_t*)arg)->timeout;
+    {
+        mcc_tcp_conn_t conn(s, timeout, no_delay);
+        while(it.process_request(conn)) { };
     };
     it.lock_.lock();
     for(std::list<mcc_tcp_exec_t>::iterator e = it.executers_.begin();e != it.executers_.end();++e) {
@@ -579,6 +643,147 @@ void MCC_TCP_Service::executer(void* arg) {
     return;
 }
 
+bool MCC_TCP_Service::add_connection(int h, int timeout, bool no_delay) {
+#ifdef HAVE_SYS_EPOLL_H
+    // list is locked externally
+    mcc_tcp_conn_t* conn = new mcc_tcp_conn_t(h, timeout, no_delay);
+    conn->parked = true;
+    connections_.insert(conn);
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.ptr = conn;
+    if(epoll_ctl(epoll_handle_, EPOLL_CTL_ADD, h, &ev) != 0) {
+        logger.msg(ERROR, "Failed to add connection to event loop: %s", StrError(errno));
+        close_connection(conn);
+        return false;
+    };
+    return true;
+#else
+    ::shutdown(h,2);
+    ::close(h);
+    return false;
+#endif
+}
+
+void MCC_TCP_Service::close_connection(mcc_tcp_conn_t* conn) {
+    // list is locked externally
+#ifdef HAVE_SYS_EPOLL_H
+    if(epoll_handle_ != -1) epoll_ctl(epoll_handle_, EPOLL_CTL_DEL, conn->handle, NULL);
+#endif
+    connections_.erase(conn);
+    if(!conn->parked) --busy_;
+    int s = conn->handle;
+    delete conn;
+    ::shutdown(s,2);
+    ::close(s);
+    cond_.signal();
+}
+
+bool MCC_TCP_Service::close_idle_connection(void) {
+    // list is locked externally
+    mcc_tcp_conn_t* idle = NULL;
+    for(std::set<mcc_tcp_conn_t*>::iterator c = connections_.begin();c != connections_.end();++c) {
+        if(!(*c)->parked) continue;
+        if(!idle || ((*c)->last_active < idle->last_active)) idle = *c;
+    };
+    if(!idle) return false;
+    logger.msg(VERBOSE, "Too many idle connections - closing oldest one");
+    close_connection(idle);
+    return true;
+}
+
+void MCC_TCP_Service::events(void* arg) {
+    MCC_TCP_Service& it = *((MCC_TCP_Service*)arg);
+#ifdef HAVE_SYS_EPOLL_H
+    const int max_events = 64;
+    struct epoll_event events[max_events];
+    time_t last_check = time(NULL);
+    for(;;) {
+        int n = epoll_wait(it.epoll_handle_, events, max_events, 1000);
+        if((n < 0) && (ErrNo != EINTR)) {
+            logger.msg(ERROR, "Failed while waiting for connection events");
+            sleep(1);
+        };
+        it.lock_.lock();
+        if(it.stopping_) break;
+        // Pass connections with pending requests to workers
+        for(int i = 0; i < n; ++i) {
+            mcc_tcp_conn_t* conn = (mcc_tcp_conn_t*)(events[i].data.ptr);
+            conn->parked = false;
+            ++(it.busy_);
+            it.ready_.push_back(conn);
+            it.ready_cond_.signal();
+        };
+        // Drop connections which stayed idle for too long
+        time_t now = time(NULL);
+        if(now != last_check) {
+            last_check = now;
+            for(std::set<mcc_tcp_conn_t*>::iterator c = it.connections_.begin();c != it.connections_.end();) {
+                mcc_tcp_conn_t* conn = *c;
+                ++c;
+                if(conn->parked && ((now - conn->last_active) > conn->stream.Timeout())) {
+                    logger.msg(VERBOSE, "Closing idle connection");
+                    it.close_connection(conn);
+                };
+            };
+        };
+        // Idle connections are not counted against limit but are limited to
+        // same number. Done here because event for connection may be already
+        // fetched by epoll_wait() but not yet processed.
+        if(it.max_executers_ > 0) {
+            while((it.connections_.size() - (size_t)it.busy_) > (size_t) it.max_executers_) {
+                if(!it.close_idle_connection()) break;
+            };
+        };
+        it.lock_.unlock();
+    };
+    --(it.threads_);
+    it.lock_.unlock();
+#endif
+}
+
+void MCC_TCP_Service::worker(void* arg) {
+    MCC_TCP_Service& it = *((MCC_TCP_Service*)arg);
+#ifdef HAVE_SYS_EPOLL_H
+    it.lock_.lock();
+    for(;;) {
+        while(it.ready_.empty() && !it.stopping_) it.ready_cond_.wait(it.lock_);
+        if(it.stopping_) break;
+        mcc_tcp_conn_t* conn = it.ready_.front();
+        it.ready_.pop_front();
+        it.lock_.unlock();
+        bool keep = it.process_request(*conn);
+        it.lock_.lock();
+        if(it.stopping_) {
+            // Connections are closed by destructor
+            break;
+        };
+        if(keep) {
+            // Return connection to event loop till next request comes
+            conn->parked = true;
+            --(it.busy_);
+            it.cond_.signal(); // connections waiting for limit may proceed
+            conn->last_active = time(NULL);
+            struct epoll_event ev;
+            memset(&ev, 0, sizeof(ev));
+            ev.events = EPOLLIN | EPOLLONESHOT;
+            ev.data.ptr = conn;
+            if(epoll_ctl(it.epoll_handle_, EPOLL_CTL_MOD, conn->handle, &ev) != 0) {
+                logger.msg(ERROR, "Failed to return connection to event loop: %s", StrError(errno));
+                keep = false;
+            };
+        };
+        if(!keep) {
+            logger.msg(VERBOSE, "TCP connection is closed");
+            it.close_connection(conn);
+        };
+    };
+    --(it.threads_);
+    it.lock_.unlock();
+#endif
+}
+
 MCC_Status MCC_TCP_Service::process(Message&,Message&) {
   // Service is not really processing messages because there
   // are no lower lelel MCCs in chain.
@@ -657,8 +862,7 @@ MCC_Status MCC_TCP_Client::process(Message& inmsg,Message& outmsg) {
             };
         };
     } else {
-        int size = -1;
-        if(!sinpayload->Get(*s_,size)) {
+        if(!s_->Put(*sinpayload,-1)) {
         // Currently false may also mean that stream finihsed. 
         // Hence it can't be used to indicate real failure.
         //    logger.msg(INFO, "Failed to transfer content of stream");
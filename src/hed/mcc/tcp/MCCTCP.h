@@ -1,6 +1,9 @@
 #ifndef __ARC_MCCTCP_H__
 #define __ARC_MCCTCP_H__
 
+#include <list>
+#include <set>
+
 #include <arc/message/MCC.h>
 #include <arc/message/PayloadStream.h>
 #include "PayloadTCPSocket.h"
@@ -38,6 +41,14 @@ using namespace Arc;
    TCP:REMOTEPORT - TCP port from which connection is accepted
    TCP:ENDPOINT - URL-like representation of remote connection - ://HOST:PORT
    ENDPOINT - global attribute equal to TCP:ENDPOINT
+  If Mode element is set to "epoll" connections are instead parked in an
+ event loop while idle and only those with pending request are passed
+ to fixed size pool of worker threads. Then Limit applies to connections
+ with request being processed. Idle connections are limited to the same
+ number by closing those staying idle for longest time. Each worker processes one request
+ and returns connection back to event loop. That relies on MCCs up in
+ chain not keeping already read data of next request buffered, which
+ holds for clients waiting for response before sending next request.
 */
 class MCC_TCP_Service: public MCC_TCP
 {
@@ -60,6 +71,22 @@ class MCC_TCP_Service: public MCC_TCP
                 mcc_tcp_handle_t(int h, int t, bool nd = false):handle(h),no_delay(nd),timeout(t) { };
                 operator int(void) { return handle; };
         };
+        /** State of accepted connection preserved between requests */
+        class mcc_tcp_conn_t {
+            public:
+                int handle;
+                PayloadTCPSocket stream;
+                MessageContext context;
+                MessageAuthContext auth_context;
+                std::string host_attr;
+                std::string port_attr;
+                std::string remotehost_attr;
+                std::string remoteport_attr;
+                std::string endpoint_attr;
+                bool parked; /** waiting in event loop for next request */
+                time_t last_active;
+                mcc_tcp_conn_t(int h, int t, bool nd = false);
+        };
         bool valid_;
         std::list<mcc_tcp_handle_t> handles_; /** listening sockets */
         std::list<mcc_tcp_exec_t> executers_; /** active connections and associated threads */
@@ -68,8 +95,27 @@ class MCC_TCP_Service: public MCC_TCP
         /* pthread_t listen_th_; ** thread listening for incoming connections */
         Glib::Mutex lock_; /** lock for safe operations in internal lists */
         Glib::Cond cond_;
+        int workers_; /** number of worker threads in event mode, 0 for thread per connection */
+        int epoll_handle_; /** event loop handle in event mode */
+        std::set<mcc_tcp_conn_t*> connections_; /** all connections in event mode */
+        std::list<mcc_tcp_conn_t*> ready_; /** connections with pending request in event mode */
+        Glib::Cond ready_cond_;
+        int threads_; /** running event loop and worker threads */
+        bool stopping_;
+        int busy_; /** connections with request being processed in event mode */
         static void listener(void *); /** executing function for listening thread */
         static void executer(void *); /** executing function for connection thread */
+        static void events(void *); /** executing function for event loop thread */
+        static void worker(void *); /** executing function for worker thread */
+        /** Processes one request on connection. Returns false if connection must be closed. */
+        bool process_request(mcc_tcp_conn_t& conn);
+        /** Registers accepted connection in event loop. List must be locked. */
+        bool add_connection(int h, int timeout, bool no_delay);
+        /** Removes connection from event loop and closes it. List must be locked. */
+        void close_connection(mcc_tcp_conn_t* conn);
+        /** Closes connection which stays idle for longest time. List must be locked.
+            Only called by event loop thread. Returns false if there are no idle connections. */
+        bool close_idle_connection(void);
     public:
         MCC_TCP_Service(Config *cfg, PluginArgument* parg);
         virtual ~MCC_TCP_Service(void);
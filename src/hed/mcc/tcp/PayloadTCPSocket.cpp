@@ -14,6 +14,9 @@
 #include <sys/poll.h>
 #include <netinet/tcp.h>
 #include <fcntl.h>
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
 
 #include <glibmm.h>
 
@@ -233,6 +236,49 @@ bool PayloadTCPSocket::Put(const char* buf,Size_t size) {
   return true;
 }
 
+bool PayloadTCPSocket::Put(PayloadStreamInterface& source,Size_t size) {
+#ifdef HAVE_SYS_SENDFILE_H
+  if(handle_ == -1) return false;
+  PayloadStream* fsource = dynamic_cast<PayloadStream*>(&source);
+  int h = fsource ? fsource->GetHandle() : -1;
+  struct stat st;
+  if((h != -1) && (::fstat(h,&st) == 0) && S_ISREG(st.st_mode)) {
+    off_t pos = ::lseek(h,0,SEEK_CUR);
+    Size_t limit = source.Limit();
+    if((limit <= 0) || (limit > st.st_size)) limit = st.st_size;
+    if((pos != (off_t)(-1)) && (pos <= limit)) {
+      if((size == -1) || (size > (limit-pos))) size = limit-pos;
+      time_t start = time(NULL);
+      bool first = true;
+      for(;size;) {
+        unsigned int events = POLLOUT | POLLERR;
+        int to = timeout_-(unsigned int)(time(NULL)-start);
+        if(to < 0) to = 0;
+        if(spoll(handle_,to,events) != 1) return false;
+        if(!(events & POLLOUT)) return false;
+        // Limit amount sent at once to keep timeout meaningful
+        size_t chunk = (size > (4*1024*1024)) ? (4*1024*1024) : size;
+        // File position is advanced by sendfile
+        ssize_t l = ::sendfile(handle_,h,NULL,chunk);
+        if(l == -1) {
+          if(errno == EINTR) continue;
+          // File system or socket not supporting sendfile
+          if(first && ((errno == EINVAL) || (errno == ENOSYS))) break;
+          return false;
+        };
+        if(l == 0) return false; // file got truncated
+        size -= l;
+        first = false;
+        // Timeout limits inactivity, not time needed for whole file
+        start = time(NULL);
+      };
+      if(!size) return true;
+    };
+  };
+#endif
+  return PayloadStreamInterface::Put(source,size);
+}
+
 void PayloadTCPSocket::NoDelay(bool val) {
   if(handle_ == -1) return;
   int flag = val?1:0;
@@ -43,6 +43,9 @@ class PayloadTCPSocket: public PayloadStreamInterface {
   virtual bool Put(const char* buf,Size_t size);
   virtual bool Put(const std::string& buf) { return Put(buf.c_str(),buf.length()); };
   virtual bool Put(const char* buf) { return Put(buf,buf?strlen(buf):0); };
+  /** Sends content of source. If source is a regular file it is passed
+    to socket directly by the kernel without copying through user space. */
+  virtual bool Put(PayloadStreamInterface& source,Size_t size);
   virtual operator bool(void) { return (handle_ != -1); };
   virtual bool operator!(void) { return (handle_ == -1); };
   virtual int Timeout(void) const { return timeout_; };
@@ -0,0 +1,174 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+// Measures throughput and CPU time spent by sending thread when content
+// of a local file is sent to TCP socket by copying it through user space
+// and by passing file directly to socket with sendfile().
+// Usage: PayloadTCPSocketBenchmark [megabytes in file] [directory for file]
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <arc/DateTime.h>
+#include <arc/Logger.h>
+#include <arc/StringConv.h>
+#include <arc/Thread.h>
+
+#include "../PayloadTCPSocket.h"
+
+static const unsigned int chunk_size = 1048576;
+static const int passes = 4;
+
+#ifndef RUSAGE_THREAD
+#define RUSAGE_THREAD RUSAGE_SELF
+#endif
+
+static double cpu_time(void) {
+  struct rusage ru;
+  if (::getrusage(RUSAGE_THREAD, &ru) != 0) return 0;
+  return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec +
+         (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000000.0;
+}
+
+static double seconds(const Arc::Time& start) {
+  Arc::Period p = Arc::Time() - start;
+  return (double)p.GetPeriod() + (double)p.GetPeriodNanoseconds() / 1000000000.0;
+}
+
+// Plain file read sequentially from current position. Unlike
+// Arc::PayloadStream it does not check for EOF on every read.
+class FileSource: public Arc::PayloadStream {
+ public:
+  FileSource(int h): Arc::PayloadStream(h) { seekable_ = false; }
+  virtual Size_t Size(void) const {
+    struct stat st;
+    if (::fstat(handle_, &st) != 0) return 0;
+    return st.st_size;
+  }
+  virtual Size_t Limit(void) const { return Size(); }
+};
+
+// Receiving side just counts bytes.
+struct drain_arg {
+  int s;
+  Glib::Mutex lock;
+  unsigned long long int received;
+};
+
+static void drain(void* arg) {
+  drain_arg& a = *(drain_arg*)arg;
+  char* buf = new char[chunk_size];
+  for (;;) {
+    ssize_t l = ::recv(a.s, buf, chunk_size, 0);
+    if (l <= 0) break;
+    Glib::Mutex::Lock lock(a.lock);
+    a.received += l;
+  }
+  delete[] buf;
+}
+
+static void wait_received(drain_arg& a, unsigned long long int expected) {
+  for (;;) {
+    {
+      Glib::Mutex::Lock lock(a.lock);
+      if (a.received >= expected) return;
+    }
+    ::usleep(1000);
+  }
+}
+
+int main(int argc, char **argv) {
+  unsigned long long int megabytes = 1024;
+  std::string dir = ".";
+  if (argc > 1 && !Arc::stringto(argv[1], megabytes)) {
+    std::cerr << "Usage: " << argv[0] << " [megabytes in file] [directory for file]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (argc > 2) dir = argv[2];
+  Arc::LogStream logcerr(std::cerr);
+  Arc::Logger::getRootLogger().addDestination(logcerr);
+  Arc::Logger::getRootLogger().setThreshold(Arc::ERROR);
+
+  // Source is created first and should stay in page cache
+  std::string fname = dir + "/PayloadTCPSocketBenchmark.src";
+  int fd = ::open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+  if (fd == -1) {
+    std::cerr << "Failed to create " << fname << std::endl;
+    return EXIT_FAILURE;
+  }
+  char* data = new char[chunk_size];
+  std::memset(data, 0x5a, chunk_size);
+  for (unsigned long long int n = 0; n < megabytes; ++n) {
+    if (::write(fd, data, chunk_size) != (ssize_t)chunk_size) break;
+  }
+  delete[] data;
+  ::close(fd);
+  unsigned long long int size = megabytes * chunk_size;
+
+  // Loopback connection
+  int ls = ::socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addrlen = sizeof(addr);
+  int cs = ::socket(AF_INET, SOCK_STREAM, 0);
+  if ((::bind(ls, (struct sockaddr*)&addr, sizeof(addr)) != 0) || (::listen(ls, 1) != 0) ||
+      (::getsockname(ls, (struct sockaddr*)&addr, &addrlen) != 0) ||
+      (::connect(cs, (struct sockaddr*)&addr, sizeof(addr)) != 0)) {
+    std::cerr << "Failed to establish loopback connection" << std::endl;
+    ::unlink(fname.c_str());
+    return EXIT_FAILURE;
+  }
+  drain_arg darg;
+  darg.s = ::accept(ls, NULL, NULL);
+  darg.received = 0;
+  Arc::SimpleCounter threads;
+  Arc::CreateThreadFunction(&drain, &darg, &threads);
+
+  ArcMCCTCP::PayloadTCPSocket sock(cs, 60, Arc::Logger::getRootLogger());
+  unsigned long long int expected = 0;
+  const char* names[] = { "read/send", "sendfile" };
+  for (int mode = 0; mode < 2; ++mode) {
+    double cpu = 0;
+    double wall = 0;
+    for (int pass = 0; pass < passes; ++pass) {
+      int h = ::open(fname.c_str(), O_RDONLY);
+      FileSource source(h);
+      double cpu_start = cpu_time();
+      Arc::Time start;
+      bool r = mode ? sock.Put(source, size)
+                    : sock.Arc::PayloadStreamInterface::Put(source, size);
+      cpu += cpu_time() - cpu_start;
+      expected += size;
+      wait_received(darg, expected);
+      wall += seconds(start);
+      ::close(h);
+      if (!r) {
+        std::cerr << "Failed to send file" << std::endl;
+        ::unlink(fname.c_str());
+        return EXIT_FAILURE;
+      }
+    }
+    double gigabytes = (double)size * passes / (1024.0 * chunk_size);
+    std::cout << names[mode] << ": " << (wall > 0 ? gigabytes * 1024 / wall : 0) << " MB/s, "
+              << cpu / gigabytes << " CPU seconds per GB" << std::endl;
+  }
+  ::shutdown(cs, SHUT_RDWR);
+  threads.wait();
+  ::close(cs);
+  ::close(darg.s);
+  ::close(ls);
+  ::unlink(fname.c_str());
+  return EXIT_SUCCESS;
+}
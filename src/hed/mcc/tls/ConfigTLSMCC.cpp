@@ -5,6 +5,7 @@
 #include <glibmm/miscutils.h>
 #include <openssl/err.h>
 
+#include <arc/StringConv.h>
 #include <arc/credential/Credential.h>
 
 #include "PayloadTLSStream.h"
@@ -56,6 +57,7 @@ ConfigTLSMCC::ConfigTLSMCC(XMLNode cfg,bool client) {
     // Client is using safest setup by default
     cipher_list_ = "TLSv1:SSLv3:!eNULL:!aNULL";
     hostname_ = (std::string)(cfg["Hostname"]);
+    endpoint_ = (std::string)(cfg["Endpoint"]);
     XMLNode protocol_node = cfg["Protocol"];
     while((bool)protocol_node) {
       std::string protocol = (std::string)protocol_node;
@@ -229,6 +231,26 @@ bool ConfigTLSMCC::Set(SSL_CTX* sslctx) {
   return true;
 }
 
+std::string ConfigTLSMCC::ContextKey(void) const {
+  // GSI modes implement their own framing on top of TLS and are
+  // never shared.
+  if(globus_gsi_ || globusio_gsi_) return "";
+  // Every option which affects either context itself or verification
+  // of peer must be part of key.
+  std::string key = tostring((int)handshake_);
+  key += "\n" + tostring(globus_policy_) + "\n" + tostring(client_authn_);
+  key += "\n" + ca_file_ + "\n" + ca_dir_;
+  key += "\n" + cert_file_ + "\n" + key_file_ + "\n" + proxy_file_;
+  key += "\n" + cipher_list_ + "\n" + protocols_;
+  key += "\n" + credential_;
+  key += "\n" + voms_dir_ + "\n" + tostring((int)voms_processing_);
+  key += "\n" + tostring(vomscert_trust_dn_.size());
+  for(std::vector<std::string>::const_iterator dn = vomscert_trust_dn_.begin();
+                         dn != vomscert_trust_dn_.end(); ++dn) key += "\n" + *dn;
+  key += "\n" + hostname_;
+  return key;
+}
+
 std::string ConfigTLSMCC::HandleError(int code) {
   std::string errstr;
   unsigned long e = (code==SSL_ERROR_NONE)?ERR_get_error():code;
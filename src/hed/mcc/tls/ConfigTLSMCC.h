@@ -44,6 +44,7 @@ class ConfigTLSMCC {
   std::vector<std::string> vomscert_trust_dn_;
   std::string cipher_list_;
   std::string hostname_;
+  std::string endpoint_;
   std::string protocols_;
   std::string protocol_;
   std::string failure_;
@@ -74,6 +75,10 @@ class ConfigTLSMCC {
   bool IfFailOnVOMSParsing(void) const { return (voms_processing_ == noerrors_voms) || (voms_processing_ == strict_voms); };
   bool IfFailOnVOMSInvalid(void) const { return (voms_processing_ == noerrors_voms); };
   const std::string& Hostname() const { return hostname_; };
+  /// Identifies server client connects to. Used for resuming TLS sessions.
+  const std::string& Endpoint() const { return endpoint_; };
+  /// Returns string identifying client SSL_CTX produced by Set() or empty string if context can't be shared
+  std::string ContextKey(void) const;
   const std::string& Failure(void) { return failure_; };
   static std::string HandleError(int code = SSL_ERROR_NONE);
   static void ClearError(void);
@@ -0,0 +1,189 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <map>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <glibmm/thread.h>
+
+#include <arc/StringConv.h>
+#include <arc/crypto/OpenSSL.h>
+
+#include "ContextCacheTLSMCC.h"
+
+namespace ArcMCCTLS {
+
+#if (OPENSSL_VERSION_NUMBER < 0x10100000L)
+static int SSL_CTX_up_ref(SSL_CTX *ctx) {
+  return (CRYPTO_add(&(ctx->references),1,CRYPTO_LOCK_SSL_CTX) > 1) ? 1 : 0;
+}
+#endif
+
+// Context is recreated at least that often (seconds) to pick up
+// updated CRLs and CA certificates.
+#define CONTEXT_MAX_AGE (600)
+// Limits for amount of cached objects
+#define CONTEXT_MAX_NUM (32)
+#define SESSION_MAX_NUM (256)
+
+class ContextCacheEntry {
+ public:
+  SSL_CTX* ctx;
+  time_t created;
+  std::string stamp;
+  std::map<std::string,SSL_SESSION*> sessions;
+  ContextCacheEntry(void):ctx(NULL),created(0) { };
+  void Clear(void) {
+    for(std::map<std::string,SSL_SESSION*>::iterator s = sessions.begin(); s != sessions.end(); ++s) {
+      SSL_SESSION_free(s->second);
+    };
+    sessions.clear();
+    if(ctx) SSL_CTX_free(ctx);
+    ctx = NULL;
+  };
+};
+
+class ContextCache {
+ public:
+  Glib::Mutex lock;
+  std::map<std::string,ContextCacheEntry> contexts;
+};
+
+// Cache is never destroyed because at exit OpenSSL may be already
+// cleaned up before static objects.
+static ContextCache& cache(void) {
+  static ContextCache* cache_ = new ContextCache;
+  return *cache_;
+}
+
+static std::string file_stamp(const std::string& path) {
+  if(path.empty()) return "-";
+  struct stat st;
+  if(::stat(path.c_str(),&st) != 0) return "?";
+  // File may be replaced or rewritten within same second
+  return Arc::tostring(st.st_ino) + ":" + Arc::tostring(st.st_size) + ":" +
+         Arc::tostring(st.st_mtim.tv_sec) + "." + Arc::tostring(st.st_mtim.tv_nsec);
+}
+
+// Files used to create context. If any of them changes context is recreated.
+static std::string config_stamp(const ConfigTLSMCC& config) {
+  return file_stamp(config.CertFile()) + " " + file_stamp(config.KeyFile()) + " " +
+         file_stamp(config.CAFile()) + " " + file_stamp(config.CADir());
+}
+
+static bool session_expired(SSL_SESSION* session) {
+  return (time(NULL) >= (SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session)));
+}
+
+SSL_CTX* ContextCacheTLSMCC::Get(const ConfigTLSMCC& config) {
+  if(!Arc::OpenSSLSessionReuse()) return NULL;
+  std::string key = config.ContextKey();
+  if(key.empty()) return NULL;
+  std::string stamp = config_stamp(config);
+  ContextCache& c = cache();
+  Glib::Mutex::Lock lock(c.lock);
+  std::map<std::string,ContextCacheEntry>::iterator entry = c.contexts.find(key);
+  if(entry == c.contexts.end()) return NULL;
+  if((entry->second.stamp != stamp) || ((time(NULL) - entry->second.created) > CONTEXT_MAX_AGE)) {
+    entry->second.Clear();
+    c.contexts.erase(entry);
+    return NULL;
+  };
+  SSL_CTX_up_ref(entry->second.ctx);
+  return entry->second.ctx;
+}
+
+void ContextCacheTLSMCC::Put(const ConfigTLSMCC& config, SSL_CTX* ctx) {
+  if(!ctx) return;
+  if(!Arc::OpenSSLSessionReuse()) return;
+  std::string key = config.ContextKey();
+  if(key.empty()) return;
+  std::string stamp = config_stamp(config);
+  ContextCache& c = cache();
+  Glib::Mutex::Lock lock(c.lock);
+  std::map<std::string,ContextCacheEntry>::iterator entry = c.contexts.find(key);
+  if(entry != c.contexts.end()) {
+    // Other connection with same configuration was faster
+    entry->second.Clear();
+    c.contexts.erase(entry);
+  };
+  if(c.contexts.size() >= CONTEXT_MAX_NUM) {
+    std::map<std::string,ContextCacheEntry>::iterator oldest = c.contexts.begin();
+    for(entry = c.contexts.begin(); entry != c.contexts.end(); ++entry) {
+      if(entry->second.created < oldest->second.created) oldest = entry;
+    };
+    oldest->second.Clear();
+    c.contexts.erase(oldest);
+  };
+  ContextCacheEntry& new_entry = c.contexts[key];
+  SSL_CTX_up_ref(ctx);
+  new_entry.ctx = ctx;
+  new_entry.created = time(NULL);
+  new_entry.stamp = stamp;
+}
+
+bool ContextCacheTLSMCC::ApplySession(const ConfigTLSMCC& config, SSL* ssl) {
+  if(config.Endpoint().empty()) return false;
+  if(!Arc::OpenSSLSessionReuse()) return false;
+  std::string key = config.ContextKey();
+  if(key.empty()) return false;
+  ContextCache& c = cache();
+  Glib::Mutex::Lock lock(c.lock);
+  std::map<std::string,ContextCacheEntry>::iterator entry = c.contexts.find(key);
+  if(entry == c.contexts.end()) return false;
+  std::map<std::string,SSL_SESSION*>::iterator session = entry->second.sessions.find(config.Endpoint());
+  if(session == entry->second.sessions.end()) return false;
+  if(session_expired(session->second)) {
+    SSL_SESSION_free(session->second);
+    entry->second.sessions.erase(session);
+    return false;
+  };
+  return (SSL_set_session(ssl,session->second) == 1);
+}
+
+bool ContextCacheTLSMCC::StoreSession(const ConfigTLSMCC& config, SSL_SESSION* session) {
+  if(config.Endpoint().empty()) return false;
+  std::string key = config.ContextKey();
+  if(key.empty()) return false;
+  ContextCache& c = cache();
+  Glib::Mutex::Lock lock(c.lock);
+  std::map<std::string,ContextCacheEntry>::iterator entry = c.contexts.find(key);
+  if(entry == c.contexts.end()) return false;
+  std::map<std::string,SSL_SESSION*>& sessions = entry->second.sessions;
+  std::map<std::string,SSL_SESSION*>::iterator old = sessions.find(config.Endpoint());
+  if(old != sessions.end()) {
+    SSL_SESSION_free(old->second);
+    old->second = session;
+    return true;
+  };
+  if(sessions.size() >= SESSION_MAX_NUM) {
+    std::map<std::string,SSL_SESSION*>::iterator oldest = sessions.begin();
+    for(old = sessions.begin(); old != sessions.end(); ++old) {
+      if(SSL_SESSION_get_time(old->second) < SSL_SESSION_get_time(oldest->second)) oldest = old;
+    };
+    SSL_SESSION_free(oldest->second);
+    sessions.erase(oldest);
+  };
+  sessions[config.Endpoint()] = session;
+  return true;
+}
+
+void ContextCacheTLSMCC::DropSession(const ConfigTLSMCC& config) {
+  if(config.Endpoint().empty()) return;
+  std::string key = config.ContextKey();
+  if(key.empty()) return;
+  ContextCache& c = cache();
+  Glib::Mutex::Lock lock(c.lock);
+  std::map<std::string,ContextCacheEntry>::iterator entry = c.contexts.find(key);
+  if(entry == c.contexts.end()) return;
+  std::map<std::string,SSL_SESSION*>::iterator session = entry->second.sessions.find(config.Endpoint());
+  if(session == entry->second.sessions.end()) return;
+  SSL_SESSION_free(session->second);
+  entry->second.sessions.erase(session);
+}
+
+} // namespace ArcMCCTLS
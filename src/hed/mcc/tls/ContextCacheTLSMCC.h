@@ -0,0 +1,36 @@
+#ifndef __ARC_CONTEXTCACHETLSMCC_H__
+#define __ARC_CONTEXTCACHETLSMCC_H__
+
+#include <string>
+
+#include <openssl/ssl.h>
+
+#include "ConfigTLSMCC.h"
+
+namespace ArcMCCTLS {
+
+/// Process-wide cache of client SSL contexts and TLS sessions.
+/** Creating SSL_CTX means loading credentials and CA certificates
+  from files and full handshake means verifying whole peer chain.
+  Contexts are shared by connections with same configuration and
+  sessions are kept per configuration and server endpoint for
+  resuming. Cached context is dropped when it gets too old or
+  files it was created from are modified. That also drops all
+  sessions made with its configuration. */
+class ContextCacheTLSMCC {
+ public:
+  /// Returns new reference to cached context or NULL if there is none usable
+  static SSL_CTX* Get(const ConfigTLSMCC& config);
+  /// Adds context to cache. Cache obtains its own reference.
+  static void Put(const ConfigTLSMCC& config, SSL_CTX* ctx);
+  /// Assigns cached session to SSL object. Returns false if there is none.
+  static bool ApplySession(const ConfigTLSMCC& config, SSL* ssl);
+  /// Stores session for endpoint of configuration. Cache takes over reference.
+  static bool StoreSession(const ConfigTLSMCC& config, SSL_SESSION* session);
+  /// Forgets session for endpoint of configuration.
+  static void DropSession(const ConfigTLSMCC& config);
+};
+
+} // namespace ArcMCCTLS
+
+#endif /* __ARC_CONTEXTCACHETLSMCC_H__ */
@@ -6,6 +6,7 @@
 
 #include "GlobusSigningPolicy.h"
 
+#include "ContextCacheTLSMCC.h"
 #include "PayloadTLSMCC.h"
 #include <openssl/err.h>
 #include <glibmm/miscutils.h>
@@ -148,39 +149,47 @@ static int no_passphrase_callback(char*, int, int, void*) {
    return -1;
 }
 
+// Called by OpenSSL when client obtains session which can be resumed.
+// With TLSv1.3 that happens after handshake when session ticket arrives.
+static int new_session_callback(SSL* ssl, SSL_SESSION* session) {
+   PayloadTLSMCC* it = PayloadTLSMCC::RetrieveInstance(ssl);
+   if(it == NULL) return 0;
+   // Returning 1 passes reference to session to cache
+   return ContextCacheTLSMCC::StoreSession(it->Config(), session) ? 1 : 0;
+}
+
+// Instance is attached to SSL object because SSL context
+// may be shared by many connections.
 bool PayloadTLSMCC::StoreInstance(void) {
    if(ex_data_index_ == -1) {
       // In case of race condition we will have 2 indices assigned - harmless?
-      ex_data_index_=OpenSSLAppDataIndex(ex_data_id);
+      ex_data_index_=OpenSSLConnectionDataIndex(ex_data_id);
    };
    if(ex_data_index_ == -1) {
       logger_.msg(WARNING,"Failed to store application data");
       return false;
    };
-   if(!sslctx_) return false;
-   SSL_CTX_set_ex_data(sslctx_,ex_data_index_,this);
+   if(!ssl_) return false;
+   SSL_set_ex_data(ssl_,ex_data_index_,this);
    return true;
 }
 
 bool PayloadTLSMCC::ClearInstance(void) {
-  if((ex_data_index_ != -1) && sslctx_) {
-    SSL_CTX_set_ex_data(sslctx_,ex_data_index_,NULL);
+  if((ex_data_index_ != -1) && ssl_) {
+    SSL_set_ex_data(ssl_,ex_data_index_,NULL);
     return true;
   };
   return false;
 }
 
+PayloadTLSMCC* PayloadTLSMCC::RetrieveInstance(SSL* ssl) {
+  if((ex_data_index_ == -1) || (ssl == NULL)) return NULL;
+  return (PayloadTLSMCC*)SSL_get_ex_data(ssl,ex_data_index_);
+}
+
 PayloadTLSMCC* PayloadTLSMCC::RetrieveInstance(X509_STORE_CTX* container) {
-  PayloadTLSMCC* it = NULL;
-  if(ex_data_index_ != -1) {
-    SSL* ssl = (SSL*)X509_STORE_CTX_get_ex_data(container,SSL_get_ex_data_X509_STORE_CTX_idx());
-    if(ssl != NULL) {
-      SSL_CTX* ssl_ctx = SSL_get_SSL_CTX(ssl);
-      if(ssl_ctx != NULL) {
-        it = (PayloadTLSMCC*)SSL_CTX_get_ex_data(ssl_ctx,ex_data_index_);
-      }
-    };
-  };
+  SSL* ssl = (SSL*)X509_STORE_CTX_get_ex_data(container,SSL_get_ex_data_X509_STORE_CTX_idx());
+  PayloadTLSMCC* it = RetrieveInstance(ssl);
   if(it == NULL) {
     Logger::getRootLogger().msg(WARNING,"Failed to retrieve application data from OpenSSL");
   };
@@ -189,17 +198,27 @@ PayloadTLSMCC* PayloadTLSMCC::RetrieveInstance(X509_STORE_CTX* container) {
 
 
 PayloadTLSMCC::PayloadTLSMCC(MCCInterface* mcc, const ConfigTLSMCC& cfg, Logger& logger):
-    PayloadTLSStream(logger),sslctx_(NULL),bio_(NULL),config_(cfg),flags_(0) {
+    PayloadTLSStream(logger),sslctx_(NULL),shared_ctx_(false),bio_(NULL),config_(cfg),flags_(0) {
    // Client mode
    int err = SSL_ERROR_NONE;
    char gsi_cmd[1] = { '0' };
    master_=true;
+   // Contexts and sessions are reused unless disabled or not possible
+   // for this kind of connection
+   bool reuse = OpenSSLSessionReuse() && !config_.ContextKey().empty();
    // Creating BIO for communication through stream which it will
    // extract from provided MCC
    BIO* bio = (bio_ = config_.GlobusIOGSI()?BIO_new_GSIMCC(mcc):BIO_new_MCC(mcc));
    // Initialize the SSL Context object
    long ctx_options = 0;
 
+   if(reuse) {
+     sslctx_ = ContextCacheTLSMCC::Get(config_);
+     if(sslctx_) {
+       shared_ctx_ = true;
+       goto connect;
+     };
+   };
    if(cfg.IfSSLv3Handshake()) {
 #if defined HAVE_SSLV3_METHOD
      sslctx_=SSL_CTX_new(SSLv3_client_method());
@@ -258,7 +277,13 @@ PayloadTLSMCC::PayloadTLSMCC(MCCInterface* mcc, const ConfigTLSMCC& cfg, Logger&
       goto error;
    };
    SSL_CTX_set_mode(sslctx_,SSL_MODE_ENABLE_PARTIAL_WRITE);
-   SSL_CTX_set_session_cache_mode(sslctx_,SSL_SESS_CACHE_OFF);
+   if(reuse) {
+     // Sessions are kept in ContextCacheTLSMCC per server endpoint
+     SSL_CTX_set_session_cache_mode(sslctx_,SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+     SSL_CTX_sess_set_new_cb(sslctx_,&new_session_callback);
+   } else {
+     SSL_CTX_set_session_cache_mode(sslctx_,SSL_SESS_CACHE_OFF);
+   };
    if(!config_.Set(sslctx_)) {
       SetFailure(config_.Failure());
       goto error;
@@ -272,23 +297,28 @@ PayloadTLSMCC::PayloadTLSMCC(MCCInterface* mcc, const ConfigTLSMCC& cfg, Logger&
    } else {
       X509_VERIFY_PARAM_set_flags(SSL_CTX_get0_param(sslctx_),X509_V_FLAG_CRL_CHECK | X509_V_FLAG_ALLOW_PROXY_CERTS);
    };
-   StoreInstance();
-#ifdef SSL_OP_NO_TICKET
-   ctx_options |= SSL_OP_SINGLE_DH_USE | SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3 | SSL_OP_ALL | SSL_OP_NO_TICKET;
-#else
    ctx_options |= SSL_OP_SINGLE_DH_USE | SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3 | SSL_OP_ALL;
+#ifdef SSL_OP_NO_TICKET
+   // Session tickets are only useful if session is going to be resumed
+   if(!reuse) ctx_options |= SSL_OP_NO_TICKET;
 #endif
    SSL_CTX_set_options(sslctx_, ctx_options);
 
    SSL_CTX_set_default_passwd_cb(sslctx_, no_passphrase_callback);
+   if(reuse) {
+     ContextCacheTLSMCC::Put(config_, sslctx_);
+     shared_ctx_ = true;
+   };
    /* Get DN from certificate, and put it into message's attribute */
 
+connect:
    // Creating SSL object for handling connection
    ssl_ = SSL_new(sslctx_);
    if (ssl_ == NULL){
       logger.msg(ERROR, "Can not create the SSL object");
       goto error;
    };
+   StoreInstance();
    //for(int n = 0;;++n) {
    //  const char * s = SSL_get_cipher_list(ssl_,n);
    //  if(!s) break;
@@ -299,10 +329,13 @@ PayloadTLSMCC::PayloadTLSMCC(MCCInterface* mcc, const ConfigTLSMCC& cfg, Logger&
          logger.msg(WARNING, "Faile to assign hostname extension");
       };
    };
+   if(reuse) ContextCacheTLSMCC::ApplySession(config_, ssl_);
    SSL_set_bio(ssl_,bio,bio); bio=NULL;
    //SSL_set_connect_state(ssl_);
    if((err=SSL_connect(ssl_)) != 1) {
       err = SSL_get_error(ssl_,err);
+      // Do not try same session again
+      if(reuse) ContextCacheTLSMCC::DropSession(config_);
       /* TODO: Print nice message when server side certificate has
        *       expired. Still to investigate if this case is only when
        *       server side certificate has expired.
@@ -313,6 +346,14 @@ PayloadTLSMCC::PayloadTLSMCC(MCCInterface* mcc, const ConfigTLSMCC& cfg, Logger&
       logger.msg(VERBOSE, "Failed to establish SSL connection");
       goto error;
    };
+   // Resumed session skips verification of peer chain. Chain and
+   // result of verification are taken from session.
+   if(SSL_session_reused(ssl_)) {
+      logger.msg(VERBOSE, "Resumed SSL session");
+      OpenSSLCountHandshake(true);
+   } else {
+      OpenSSLCountHandshake(false);
+   };
    logger.msg(VERBOSE, "Using cipher: %s",SSL_get_cipher_name(ssl_));
    // if(SSL_in_init(ssl_)){
    //handle error
@@ -330,7 +371,7 @@ error:
 }
 
 PayloadTLSMCC::PayloadTLSMCC(PayloadStreamInterface* stream, const ConfigTLSMCC& cfg, Logger& logger):
-    PayloadTLSStream(logger),sslctx_(NULL),config_(cfg),flags_(0) {
+    PayloadTLSStream(logger),sslctx_(NULL),shared_ctx_(false),config_(cfg),flags_(0) {
    // Server mode
    int err = SSL_ERROR_NONE;
    master_=true;
@@ -379,7 +420,6 @@ PayloadTLSMCC::PayloadTLSMCC(PayloadStreamInterface* stream, const ConfigTLSMCC&
       X509_VERIFY_PARAM_set_flags(SSL_CTX_get0_param(sslctx_),X509_V_FLAG_CRL_CHECK | X509_V_FLAG_ALLOW_PROXY_CERTS);
    };
 
-   StoreInstance();
    ctx_options |= SSL_OP_SINGLE_DH_USE | SSL_OP_NO_SSLv2 | SSL_OP_NO_SSLv3 | SSL_OP_ALL;
    SSL_CTX_set_options(sslctx_, ctx_options);
    SSL_CTX_set_default_passwd_cb(sslctx_, no_passphrase_callback);
@@ -390,6 +430,7 @@ PayloadTLSMCC::PayloadTLSMCC(PayloadStreamInterface* stream, const ConfigTLSMCC&
       logger.msg(ERROR, "Can not create the SSL object");
       goto error;
    };
+   StoreInstance();
    //for(int n = 0;;++n) {
    //  const char * s = SSL_get_cipher_list(ssl_,n);
    //  if(!s) break;
@@ -402,6 +443,7 @@ PayloadTLSMCC::PayloadTLSMCC(PayloadStreamInterface* stream, const ConfigTLSMCC&
       logger.msg(ERROR, "Failed to accept SSL connection");
       goto error;
    };
+   OpenSSLCountHandshake(SSL_session_reused(ssl_));
    logger.msg(VERBOSE, "Using cipher: %s",SSL_get_cipher_name(ssl_));
    //handle error
    // if(SSL_in_init(ssl_)){
@@ -420,6 +462,7 @@ PayloadTLSMCC::PayloadTLSMCC(PayloadTLSMCC& stream):
     PayloadTLSStream(stream), config_(stream.config_), flags_(0) {
    master_=false;
    sslctx_=stream.sslctx_;
+   shared_ctx_=stream.shared_ctx_;
    ssl_=stream.ssl_;
    bio_=stream.bio_;
 }
@@ -463,7 +506,8 @@ PayloadTLSMCC::~PayloadTLSMCC(void) {
     ssl_ = NULL;
   }
   if(sslctx_) {
-    SSL_CTX_set_verify(sslctx_,SSL_VERIFY_NONE,NULL);
+    // Shared context is still used by other connections
+    if(!shared_ctx_) SSL_CTX_set_verify(sslctx_,SSL_VERIFY_NONE,NULL);
     SSL_CTX_free(sslctx_);
     sslctx_ = NULL;
   }
@@ -23,6 +23,8 @@ class PayloadTLSMCC: public PayloadTLSStream {
   bool master_;
   /** SSL context */
   SSL_CTX* sslctx_;
+  /** SSL context is shared with other connections through cache */
+  bool shared_ctx_;
   BIO* bio_;
   static int ex_data_index_;
   //PayloadTLSMCC(PayloadTLSMCC& stream);
@@ -47,6 +49,7 @@ class PayloadTLSMCC: public PayloadTLSStream {
   virtual ~PayloadTLSMCC(void);
   const ConfigTLSMCC& Config(void) { return config_; };
   static PayloadTLSMCC* RetrieveInstance(X509_STORE_CTX* container);
+  static PayloadTLSMCC* RetrieveInstance(SSL* ssl);
   unsigned long Flags(void) { return flags_; };
   void Flags(unsigned long flags) { flags_=flags; };
   void SetFailure(const std::string& err);
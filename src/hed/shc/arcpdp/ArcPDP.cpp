@@ -5,6 +5,10 @@
 #include <iostream>
 #include <fstream>
 
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <arc/XMLNode.h>
 #include <arc/Thread.h>
 #include <arc/ArcConfig.h>
@@ -40,28 +44,164 @@ Plugin* ArcPDP::get_arc_pdp(PluginArgument* arg) {
     return new ArcPDP((Arc::Config*)(*pdparg),arg);
 }
 
-// This class is used to store Evaluator per connection
-class ArcPDPContext:public Arc::MessageContextElement {
- friend class ArcPDP;
- private:
-  Evaluator* eval;
+// Policy file and its state at time it was read
+class ArcPDPPolicyFile {
+ public:
+  ArcPDPPolicyFile(const std::string& p):path(p),exists(false),mtime(0),mtime_nsec(0),size(0),ino(0) { };
+  std::string path;
+  bool exists;
+  time_t mtime;
+  long mtime_nsec; // file may be rewritten within same second
+  off_t size;
+  ino_t ino;
+  void Stat(void) {
+    struct stat st;
+    exists = (::stat(path.c_str(),&st) == 0);
+    mtime = exists?st.st_mtim.tv_sec:0;
+    mtime_nsec = exists?st.st_mtim.tv_nsec:0;
+    size = exists?st.st_size:0;
+    ino = exists?st.st_ino:0;
+  };
+  bool Changed(void) const {
+    ArcPDPPolicyFile current(path);
+    current.Stat();
+    return (current.exists != exists) || (current.mtime != mtime) ||
+           (current.mtime_nsec != mtime_nsec) ||
+           (current.size != size) || (current.ino != ino);
+  };
+};
+
+// Policy documents parsed once and kept in memory. Object is never
+// modified after being made. If any of files changes new object
+// replaces it while evaluations already started keep using old one.
+class ArcPDPPolicies {
  public:
-  ArcPDPContext(Evaluator* e);
-  ArcPDPContext(void);
-  virtual ~ArcPDPContext(void);
+  Arc::XMLNodeContainer documents;
+  std::list<ArcPDPPolicyFile> files;
 };
 
-ArcPDPContext::~ArcPDPContext(void) {
-  if(eval) delete eval;
+// Evaluator can't be used concurrently because policies store results
+// of evaluation in themselves. Hence every evaluation takes Evaluator
+// from pool and returns it when done. Evaluators are made out of
+// documents in memory and are reused till documents change.
+class ArcPDPPolicySet {
+ public:
+  ArcPDPPolicySet(const std::list<std::string>& locations, Arc::XMLNodeContainer& policies, const std::string& combining_alg);
+  ~ArcPDPPolicySet(void);
+  Evaluator* Acquire(Arc::ThreadedPointer<ArcPDPPolicies>& policies);
+  void Release(Evaluator* eval, const Arc::ThreadedPointer<ArcPDPPolicies>& policies);
+ private:
+  static const unsigned int max_idle_evaluators = 50;
+  bool Changed(void) const;
+  void Load(void);
+  Evaluator* Make(ArcPDPPolicies& policies) const;
+  Glib::Mutex lock_;
+  std::list<std::string> locations_;
+  Arc::XMLNodeContainer inline_policies_;
+  std::string combining_alg_;
+  Arc::ThreadedPointer<ArcPDPPolicies> policies_;
+  std::list<Evaluator*> evaluators_;
+};
+
+ArcPDPPolicySet::ArcPDPPolicySet(const std::list<std::string>& locations, Arc::XMLNodeContainer& policies, const std::string& combining_alg):
+    locations_(locations),combining_alg_(combining_alg) {
+  for(int n = 0;n<policies.Size();++n) inline_policies_.AddNew(policies[n]);
+}
+
+ArcPDPPolicySet::~ArcPDPPolicySet(void) {
+  for(std::list<Evaluator*>::iterator e = evaluators_.begin(); e != evaluators_.end(); ++e) delete *e;
 }
 
-ArcPDPContext::ArcPDPContext(Evaluator* e):eval(e) {
+bool ArcPDPPolicySet::Changed(void) const {
+  if(!policies_) return true;
+  for(std::list<ArcPDPPolicyFile>::const_iterator f = policies_->files.begin(); f != policies_->files.end(); ++f) {
+    if(f->Changed()) return true;
+  }
+  return false;
 }
 
-ArcPDPContext::ArcPDPContext(void):eval(NULL) {
+void ArcPDPPolicySet::Load(void) {
+  ArcPDPPolicies* policies = new ArcPDPPolicies;
+  for(std::list<std::string>::const_iterator it = locations_.begin(); it!= locations_.end(); it++) {
+    ArcPDPPolicyFile file(*it);
+    // Stat before reading so that modification during reading is noticed next time
+    file.Stat();
+    policies->files.push_back(file);
+    XMLNode document;
+    if(!document.ReadFromFile(*it)) {
+      ArcPDP::logger.msg(ERROR, "Failed to read policy from %s", *it);
+      continue;
+    }
+    policies->documents.AddNew(document);
+  }
+  for(int n = 0;n<inline_policies_.Size();++n) policies->documents.AddNew(inline_policies_[n]);
+  policies_ = policies;
+  // Evaluators made out of old documents are not needed anymore
+  for(std::list<Evaluator*>::iterator e = evaluators_.begin(); e != evaluators_.end(); ++e) delete *e;
+  evaluators_.clear();
+}
+
+Evaluator* ArcPDPPolicySet::Make(ArcPDPPolicies& policies) const {
   std::string evaluator = "arc.evaluator"; 
   EvaluatorLoader eval_loader;
-  eval = eval_loader.getEvaluator(evaluator);
+  Evaluator* eval = eval_loader.getEvaluator(evaluator);
+  if(!eval) return NULL;
+  for(int n = 0;n<policies.documents.Size();++n) {
+    eval->addPolicy(Source(policies.documents[n]));
+  }
+  if(!combining_alg_.empty()) {
+    if(combining_alg_ == "EvaluatorFailsOnDeny") {
+      eval->setCombiningAlg(EvaluatorFailsOnDeny);
+    } else if(combining_alg_ == "EvaluatorStopsOnDeny") {
+      eval->setCombiningAlg(EvaluatorStopsOnDeny);
+    } else if(combining_alg_ == "EvaluatorStopsOnPermit") {
+      eval->setCombiningAlg(EvaluatorStopsOnPermit);
+    } else if(combining_alg_ == "EvaluatorStopsNever") {
+      eval->setCombiningAlg(EvaluatorStopsNever);
+    } else {
+      AlgFactory* factory = eval->getAlgFactory();
+      if(!factory) {
+        ArcPDP::logger.msg(WARNING, "Evaluator does not support loadable Combining Algorithms");
+      } else {
+        CombiningAlg* algorithm = factory->createAlg(combining_alg_);
+        if(!algorithm) {
+          ArcPDP::logger.msg(ERROR, "Evaluator does not support specified Combining Algorithm - %s",combining_alg_);
+        } else {
+          eval->setCombiningAlg(algorithm);
+        };
+      };
+    };
+  };
+  return eval;
+}
+
+Evaluator* ArcPDPPolicySet::Acquire(Arc::ThreadedPointer<ArcPDPPolicies>& policies) {
+  {
+    Glib::Mutex::Lock lock(lock_);
+    if(Changed()) Load();
+    policies = policies_;
+    if(!evaluators_.empty()) {
+      Evaluator* eval = evaluators_.front();
+      evaluators_.pop_front();
+      return eval;
+    };
+  };
+  // Documents are not modified hence new Evaluator can be made without lock
+  Evaluator* eval = Make(*policies);
+  if(!eval) ArcPDP::logger.msg(ERROR, "Can not dynamically produce Evaluator");
+  return eval;
+}
+
+void ArcPDPPolicySet::Release(Evaluator* eval, const Arc::ThreadedPointer<ArcPDPPolicies>& policies) {
+  if(!eval) return;
+  {
+    Glib::Mutex::Lock lock(lock_);
+    if((policies == policies_) && (evaluators_.size() < max_idle_evaluators)) {
+      evaluators_.push_back(eval);
+      return;
+    };
+  };
+  delete eval;
 }
 
 ArcPDP::ArcPDP(Config* cfg,Arc::PluginArgument* parg):PDP(cfg,parg) /*, eval(NULL)*/ {
@@ -82,6 +222,7 @@ ArcPDP::ArcPDP(Config* cfg,Arc::PluginArgument* parg):PDP(cfg,parg) /*, eval(NUL
   XMLNode policy = (*cfg)["Policy"];
   for(;(bool)policy;++policy) policies.AddNew(policy);
   policy_combining_alg = (std::string)((*cfg)["PolicyCombiningAlg"]);
+  policyset = new ArcPDPPolicySet(policy_locations, policies, policy_combining_alg);
 }
 
 PDPStatus ArcPDP::isPermitted(Message *msg) const {
@@ -97,68 +238,6 @@ PDPStatus ArcPDP::isPermitted(Message *msg) const {
     </RequestItem>
   </Request>
   */
-  Evaluator* eval = NULL;
-
-  std::string ctxid = "arcsec.arcpdp";
-  try {
-    Arc::MessageContextElement* mctx = (*(msg->Context()))[ctxid];
-    if(mctx) {
-      ArcPDPContext* pdpctx = dynamic_cast<ArcPDPContext*>(mctx);
-      if(pdpctx) {
-        eval=pdpctx->eval;
-      }
-      else { logger.msg(INFO, "Can not find ArcPDPContext"); }
-    };
-  } catch(std::exception& e) { };
-  if(!eval) {
-    ArcPDPContext* pdpctx = new ArcPDPContext();
-    if(pdpctx) {
-      eval=pdpctx->eval;
-      if(eval) {
-        //for(Arc::AttributeIterator it = (msg->Attributes())->getAll("PDP:POLICYLOCATION"); it.hasMore(); it++) {
-        //  eval->addPolicy(SourceFile(*it));
-        //}
-        for(std::list<std::string>::const_iterator it = policy_locations.begin(); it!= policy_locations.end(); it++) {
-          eval->addPolicy(SourceFile(*it));
-        }
-        for(int n = 0;n<policies.Size();++n) {
-          eval->addPolicy(Source(const_cast<Arc::XMLNodeContainer&>(policies)[n]));
-        }
-        if(!policy_combining_alg.empty()) {
-          if(policy_combining_alg == "EvaluatorFailsOnDeny") {
-            eval->setCombiningAlg(EvaluatorFailsOnDeny);
-          } else if(policy_combining_alg == "EvaluatorStopsOnDeny") {
-            eval->setCombiningAlg(EvaluatorStopsOnDeny);
-          } else if(policy_combining_alg == "EvaluatorStopsOnPermit") {
-            eval->setCombiningAlg(EvaluatorStopsOnPermit);
-          } else if(policy_combining_alg == "EvaluatorStopsNever") {
-            eval->setCombiningAlg(EvaluatorStopsNever);
-          } else {
-            AlgFactory* factory = eval->getAlgFactory();
-            if(!factory) {
-              logger.msg(WARNING, "Evaluator does not support loadable Combining Algorithms");
-            } else {
-              CombiningAlg* algorithm = factory->createAlg(policy_combining_alg);
-              if(!algorithm) {
-                logger.msg(ERROR, "Evaluator does not support specified Combining Algorithm - %s",policy_combining_alg);
-              } else {
-                eval->setCombiningAlg(algorithm);
-              };
-            };
-          };
-        };
-        msg->Context()->Add(ctxid, pdpctx);
-      } else {
-        delete pdpctx;
-      }
-    }
-    if(!eval) logger.msg(ERROR, "Can not dynamically produce Evaluator");
-  }
-  if(!eval) {
-    logger.msg(ERROR,"Evaluator for ArcPDP was not loaded"); 
-    return false;
-  };
-
   MessageAuth* mauth = msg->Auth()->Filter(select_attrs,reject_attrs);
   MessageAuth* cauth = msg->AuthContext()->Filter(select_attrs,reject_attrs);
   if((!mauth) && (!cauth)) {
@@ -193,9 +272,18 @@ PDPStatus ArcPDP::isPermitted(Message *msg) const {
     return false;
   };
 
+  //Evaluator is taken from pool shared by all requests
+  Arc::ThreadedPointer<ArcPDPPolicies> evalpolicies;
+  Evaluator* eval = policyset->Acquire(evalpolicies);
+  if(!eval) {
+    logger.msg(ERROR,"Evaluator for ArcPDP was not loaded"); 
+    return false;
+  };
+
   //Call the evaluation functionality inside Evaluator
   Response *resp = eval->evaluate(requestxml);
   if(!resp) {
+    policyset->Release(eval, evalpolicies);
     logger.msg(ERROR, "Not authorized by arc.pdp - failed to get response from Evaluator");
     return false;
   };
@@ -246,11 +334,13 @@ PDPStatus ArcPDP::isPermitted(Message *msg) const {
   else logger.msg(INFO, "Not authorized by arc.pdp - some of the RequestItem elements do not satisfy Policy");
   
   if(resp) delete resp;
+  policyset->Release(eval, evalpolicies);
     
   return result;
 }
 
 ArcPDP::~ArcPDP(){
+  delete policyset;
   //if(eval)
   //  delete eval;
   //eval = NULL;
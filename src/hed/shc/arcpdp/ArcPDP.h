@@ -10,8 +10,11 @@
 
 namespace ArcSec {
 
+class ArcPDPPolicySet;
+
 ///ArcPDP - PDP which can handle the Arc specific request and policy schema
 class ArcPDP : public PDP {
+ friend class ArcPDPPolicySet;
  public:
   static Arc::Plugin* get_arc_pdp(Arc::PluginArgument* arg);
   ArcPDP(Arc::Config* cfg, Arc::PluginArgument* parg);
@@ -27,6 +30,8 @@ class ArcPDP : public PDP {
   std::list<std::string> policy_locations;
   Arc::XMLNodeContainer policies;
   std::string policy_combining_alg;
+  // Policies and Evaluators shared by all requests
+  ArcPDPPolicySet* policyset;
  protected:
   static Arc::Logger logger;
 };
@@ -6,9 +6,12 @@
 #include <fstream>
 #include <iostream>
 #include <list>
+#include <typeinfo>
 
 #include <arc/security/ArcPDP/attr/AttributeValue.h>
 #include <arc/security/ArcPDP/attr/BooleanAttribute.h>
+#include <arc/security/ArcPDP/attr/StringAttribute.h>
+#include <arc/security/ArcPDP/attr/X500NameAttribute.h>
 #include <arc/security/ArcPDP/fn/EqualFunction.h>
 #include <arc/security/ArcPDP/fn/MatchFunction.h>
 #include <arc/security/ArcPDP/fn/InRangeFunction.h>
@@ -182,6 +185,11 @@ ArcRule::ArcRule(const XMLNode node, EvaluatorContext* ctx) : Policy(node,NULL)
   if(type.empty()) type=DEFAULT_ATTRIBUTE_TYPE;
   getItemlist(nd, conditions, "Condition", type, funcname);
 
+  makeIndex(subjects, subjects_index);
+  makeIndex(resources, resources_index);
+  makeIndex(actions, actions_index);
+  makeIndex(conditions, conditions_index);
+
   //Set the initial value for id matching 
   sub_idmatched = ID_NO_MATCH;
   res_idmatched = ID_NO_MATCH;
@@ -190,11 +198,72 @@ ArcRule::ArcRule(const XMLNode node, EvaluatorContext* ctx) : Policy(node,NULL)
  
 }
 
-static ArcSec::MatchResult itemMatch(ArcSec::OrList items, std::list<ArcSec::RequestAttribute*> req, Id_MatchResult& idmatched){
+// Keys of index are made of type, id and value. Types are distinguished
+// same way as their equal() methods do it.
+static std::string indexKey(char type, const std::string& id, const std::string& value) {
+  std::string key(1, type);
+  key.append(id);
+  key.append(1, '\0');
+  key.append(value);
+  return key;
+}
+
+void ArcRule::makeIndex(const OrList& items, MatchIndex& index) {
+  index.usable = false;
+  index.values.clear();
+  index.ids.clear();
+  for(OrList::const_iterator orit = items.begin(); orit != items.end(); ++orit) {
+    if(orit->size() != 1) return;
+    const Match& match = orit->front();
+    if(!match.first || !match.second) return;
+    if(typeid(*(match.second)) != typeid(EqualFunction)) return;
+    if(typeid(*(match.first)) == typeid(StringAttribute)) {
+      StringAttribute* value = dynamic_cast<StringAttribute*>(match.first);
+      index.values.insert(indexKey('s', value->getId(), value->getValue()));
+    } else if(typeid(*(match.first)) == typeid(X500NameAttribute)) {
+      X500NameAttribute* value = dynamic_cast<X500NameAttribute*>(match.first);
+      index.values.insert(indexKey('x', value->getId(), value->getValue()));
+    } else {
+      return;
+    }
+    index.ids.insert(match.first->getId());
+  }
+  index.usable = true;
+}
+
+// Same as itemMatch() below for items represented by index
+static ArcSec::MatchResult indexMatch(const MatchIndex& index, const std::list<ArcSec::RequestAttribute*>& req, Id_MatchResult& idmatched){
+  bool indeterminate = true;
+  idmatched = ID_NO_MATCH;
+  for(std::list<ArcSec::RequestAttribute*>::const_iterator reqit = req.begin(); reqit != req.end(); ++reqit){
+    AttributeValue* value = (*reqit)->getAttributeValue();
+    if(!value) continue;
+    StringAttribute* svalue = dynamic_cast<StringAttribute*>(value);
+    if(svalue && (index.values.find(indexKey('s', svalue->getId(), svalue->getValue())) != index.values.end())) {
+      idmatched = ID_MATCH;
+      return MATCH;
+    }
+    X500NameAttribute* xvalue = dynamic_cast<X500NameAttribute*>(value);
+    if(xvalue && (index.values.find(indexKey('x', xvalue->getId(), xvalue->getValue())) != index.values.end())) {
+      idmatched = ID_MATCH;
+      return MATCH;
+    }
+    if(index.ids.find(value->getId()) != index.ids.end()) {
+      idmatched = ID_MATCH;
+      indeterminate = false;
+    }
+  }
+  if(indeterminate) return INDETERMINATE;
+  return NO_MATCH;
+}
+
+static ArcSec::MatchResult itemMatch(const ArcSec::OrList& items, const MatchIndex& index, const std::list<ArcSec::RequestAttribute*>& req, Id_MatchResult& idmatched){
+
+  if(index.usable) return indexMatch(index, req, idmatched);
 
-  ArcSec::OrList::iterator orit;
-  ArcSec::AndList::iterator andit;
-  std::list<ArcSec::RequestAttribute*>::iterator reqit;
+  ArcSec::OrList::const_iterator orit;
+  ArcSec::AndList::const_iterator andit;
+  std::list<ArcSec::RequestAttribute*>::const_iterator reqit;
 
   bool indeterminate = true;
 
@@ -269,10 +338,10 @@ MatchResult ArcRule::match(EvaluationCtx* eval_ctx){
   ctx_idmatched = ID_NO_MATCH;
 
   MatchResult sub_matched, res_matched, act_matched, ctx_matched;
-  sub_matched = itemMatch(subjects, evaltuple->sub, sub_idmatched);
-  res_matched = itemMatch(resources, evaltuple->res, res_idmatched);
-  act_matched = itemMatch(actions, evaltuple->act, act_idmatched);
-  ctx_matched = itemMatch(conditions, evaltuple->ctx, ctx_idmatched);
+  sub_matched = itemMatch(subjects, subjects_index, evaltuple->sub, sub_idmatched);
+  res_matched = itemMatch(resources, resources_index, evaltuple->res, res_idmatched);
+  act_matched = itemMatch(actions, actions_index, evaltuple->act, act_idmatched);
+  ctx_matched = itemMatch(conditions, conditions_index, evaltuple->ctx, ctx_idmatched);
 
   if(
       ( subjects.empty() || sub_matched==MATCH) &&
@@ -3,6 +3,7 @@
 
 #include <arc/XMLNode.h>
 #include <list>
+#include <set>
 
 #include <arc/security/ArcPDP/policy/Policy.h>
 #include <arc/security/ArcPDP/fn/Function.h>
@@ -64,6 +65,20 @@ enum Id_MatchResult {
   ID_NO_MATCH = 2
 };
 
+///Index of <Subjects> (or other type) made only of single <Subject>s compared
+///by "Equal" function to string or X500Name values. For such lists matching
+///gives same result as comparing request to every <Subject> one by one, but
+///rules listing thousands of subjects do not need to be scanned.
+class MatchIndex {
+public:
+  MatchIndex(void):usable(false) { };
+  bool usable;
+  ///Type, id and value of every item
+  std::set<std::string> values;
+  ///Id of every item
+  std::set<std::string> ids;
+};
+
 ///ArcRule class to parse Arc specific <Rule> node
 class ArcRule : public Policy {
 public:
@@ -95,6 +110,9 @@ private:
   void getItemlist(Arc::XMLNode& nd, OrList& items, const std::string& itemtype, const std::string& type_attr, 
     const std::string& function_attr);
 
+  /**Build index of items if all of them can be compared by value*/
+  static void makeIndex(const OrList& items, MatchIndex& index);
+
 private:
   std::string effect;
   std::string id;
@@ -106,6 +124,11 @@ private:
   OrList actions;
   OrList conditions;
 
+  MatchIndex subjects_index;
+  MatchIndex resources_index;
+  MatchIndex actions_index;
+  MatchIndex conditions_index;
+
   AttributeFactory* attrfactory;
   FnFactory* fnfactory;
 
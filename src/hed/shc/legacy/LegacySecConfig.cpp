@@ -0,0 +1,114 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <fstream>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ConfigParser.h"
+
+#include "LegacySecConfig.h"
+
+namespace ArcSHCLegacy {
+
+class LegacySecConfigCP: public ConfigParser {
+ public:
+  LegacySecConfigCP(LegacySecConfig& config, Arc::Logger& logger):
+    ConfigParser(config.filename_,logger),config_(config) {
+  };
+
+  virtual ~LegacySecConfigCP(void) {
+  };
+
+ protected:
+  virtual bool BlockStart(const std::string& id, const std::string& name) {
+    if(id == "authgroup") {
+      config_.blocks_.push_back(LegacySecConfig::Block(true,name));
+    } else if(id == "userlist") {
+      config_.blocks_.push_back(LegacySecConfig::Block(false,name));
+    };
+    return true;
+  };
+
+  virtual bool BlockEnd(const std::string& id, const std::string& name) {
+    return true;
+  };
+
+  virtual bool ConfigLine(const std::string& id, const std::string& name, const std::string& cmd, const std::string& line) {
+    if(id == "authgroup") {
+      if(cmd == "name") {
+        config_.blocks_.back().lines.push_back(LegacySecConfig::Line(line));
+      } else {
+        config_.blocks_.back().lines.push_back(LegacySecConfig::Line(AuthRule(cmd + " " + line)));
+      };
+    } else if(id == "userlist") {
+      if(cmd == "outfile") {
+        if(!line.empty()) {
+          // Because file=filename looks exactly like 
+          // matching rule it can be evaluated same way
+          config_.blocks_.back().lines.push_back(LegacySecConfig::Line(AuthRule("file " + line)));
+        };
+      } else if(cmd == "name") {
+        config_.blocks_.back().lines.push_back(LegacySecConfig::Line(line));
+      };
+    };
+    return true;
+  };
+
+ private:
+  LegacySecConfig& config_;
+};
+
+LegacySecConfig::LegacySecConfig(const std::string& filename, Arc::Logger& logger):
+    filename_(filename),mtime_(0),mtime_nsec_(0),size_(0),ino_(0),valid_(false) {
+  struct stat st;
+  if(::stat(filename_.c_str(),&st) == 0) {
+    mtime_ = st.st_mtim.tv_sec;
+    mtime_nsec_ = st.st_mtim.tv_nsec;
+    size_ = st.st_size;
+    ino_ = st.st_ino;
+  };
+  LegacySecConfigCP parser(*this,logger);
+  if(!parser) return;
+  if(!parser.Parse()) return;
+  valid_ = true;
+}
+
+bool LegacySecConfig::Modified(void) const {
+  struct stat st;
+  if(::stat(filename_.c_str(),&st) != 0) return true;
+  return (st.st_mtim.tv_sec != mtime_) || (st.st_mtim.tv_nsec != mtime_nsec_) ||
+         (st.st_size != size_) || (st.st_ino != ino_);
+}
+
+void LegacySecConfig::Evaluate(AuthUser& auth) const {
+  for(std::list<Block>::const_iterator block = blocks_.begin(); block != blocks_.end(); ++block) {
+    // First matching rule decides, but name may be defined anywhere before it
+    AuthResult match = AAA_NO_MATCH;
+    std::string name;
+    for(std::list<Line>::const_iterator line = block->lines.begin(); line != block->lines.end(); ++line) {
+      if(match != AAA_NO_MATCH) break;
+      if(line->is_name) {
+        name = line->name;
+      } else {
+        match = auth.evaluate(line->rule);
+        // Only positive match counts for user list
+        if(!block->is_group && (match != AAA_POSITIVE_MATCH)) match = AAA_NO_MATCH;
+      };
+    };
+    if(name.empty()) name = block->name;
+    if((match == AAA_POSITIVE_MATCH) && !name.empty()) {
+      if(block->is_group) {
+        auth.add_group(name);
+      } else {
+        auth.add_vo(name);
+      };
+    };
+  };
+}
+
+} // namespace ArcSHCLegacy
+
@@ -0,0 +1,54 @@
+#include <string>
+#include <list>
+
+#include <sys/types.h>
+
+#include <arc/Logger.h>
+
+#include "auth.h"
+
+namespace ArcSHCLegacy {
+
+/**
+ Authorization groups and user lists defined in configuration file.
+ File is parsed once and rules are kept precompiled, so evaluation for
+ every new connection needs neither reading nor parsing of configuration.
+*/
+class LegacySecConfig {
+ friend class LegacySecConfigCP;
+ public:
+  LegacySecConfig(const std::string& filename, Arc::Logger& logger);
+  ~LegacySecConfig(void) { };
+  operator bool(void) const { return valid_; };
+  bool operator!(void) const { return !valid_; };
+  // Check if file was modified since it was parsed
+  bool Modified(void) const;
+  // Assign user to groups and user lists it matches
+  void Evaluate(AuthUser& auth) const;
+ private:
+  class Line {
+   public:
+    Line(const std::string& value):is_name(true),name(value),rule("") { };
+    Line(const AuthRule& value):is_name(false),rule(value) { };
+    bool is_name;  // this line defines name instead of rule
+    std::string name;
+    AuthRule rule;
+  };
+  class Block {
+   public:
+    Block(bool group,const std::string& value):is_group(group),name(value) { };
+    bool is_group; // authgroup or userlist
+    std::string name;
+    std::list<Line> lines;
+  };
+  std::list<Block> blocks_;
+  std::string filename_;
+  time_t mtime_;
+  long mtime_nsec_; // file may be rewritten within same second
+  off_t size_;
+  ino_t ino_;
+  bool valid_;
+};
+
+} // namespace ArcSHCLegacy
+
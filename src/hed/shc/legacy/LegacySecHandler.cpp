@@ -6,8 +6,7 @@
 #include <arc/Utils.h>
 
 #include "LegacySecAttr.h"
-#include "auth.h"
-#include "ConfigParser.h"
+#include "LegacySecConfig.h"
 
 #include "LegacySecHandler.h"
 
@@ -44,74 +43,21 @@ LegacySecHandler::LegacySecHandler(Arc::Config *cfg,Arc::ChainContext* ctx,Arc::
 LegacySecHandler::~LegacySecHandler(void) {
 }
 
-class LegacySHCP: public ConfigParser {
- public:
-  LegacySHCP(const std::string& filename, Arc::Logger& logger, AuthUser& auth/*, LegacySecAttr& sattr*/):
-    ConfigParser(filename,logger),auth_(auth)/*,sattr_(sattr)*/,group_match_(0),vo_match_(false) {
-  };
-
-  virtual ~LegacySHCP(void) {
-  };
-
- protected:
-  virtual bool BlockStart(const std::string& id, const std::string& name) {
-    group_match_ = AAA_NO_MATCH;
-    group_name_ = "";
-    vo_match_ = false;
-    vo_name_ = "";
-    return true;
-  };
-
-  virtual bool BlockEnd(const std::string& id, const std::string& name) {
-    if(id == "authgroup") {
-      if(group_name_.empty()) group_name_ = name;
-      if((group_match_ == AAA_POSITIVE_MATCH) && !group_name_.empty()) {
-        auth_.add_group(group_name_);
-      };
-    } else if(id == "userlist") {
-      if(vo_name_.empty()) vo_name_ = name;
-      if(vo_match_ && !vo_name_.empty()) {
-        auth_.add_vo(vo_name_);
-      };
-    };
-    return true;
-  };
-
-  virtual bool ConfigLine(const std::string& id, const std::string& name, const std::string& cmd, const std::string& line) {
-    if(id == "authgroup") {
-      if(group_match_ == AAA_NO_MATCH) {
-        if(cmd == "name") {
-          group_name_ = line;
-        } else {
-          group_match_ = auth_.evaluate((cmd + " " + line).c_str());
-        };
-      };
-    } else if(id == "userlist") {
-      if(!vo_match_) {
-        if(cmd == "outfile") {
-          if(!line.empty()) {
-            // Because file=filename looks exactly like 
-            // matching rule evaluate() can be used
-            int r = auth_.evaluate((std::string("file ") + line).c_str());
-            vo_match_ = (r == AAA_POSITIVE_MATCH);
-          };
-        } else if(cmd == "name") {
-          vo_name_ = line;
-        };
-      };
+bool LegacySecHandler::GetConfigs(std::list<Arc::ThreadedPointer<LegacySecConfig> >& configs) const {
+  Glib::Mutex::Lock lock(configs_lock_);
+  for(std::list<std::string>::const_iterator conf_file = conf_files_.begin();
+                             conf_file != conf_files_.end();++conf_file) {
+    Arc::ThreadedPointer<LegacySecConfig>& config = configs_[*conf_file];
+    if(!config || config->Modified()) {
+      Arc::ThreadedPointer<LegacySecConfig> new_config(new LegacySecConfig(*conf_file,logger));
+      // Failed configuration is not stored so it is parsed again next time
+      if(!(*new_config)) return false;
+      config = new_config;
     };
-    return true;
+    configs.push_back(config);
   };
-
- private:
-  AuthUser& auth_;
-  /* LegacySecAttr& sattr_; */
-  int group_match_;
-  std::string group_name_;
-  bool vo_match_;
-  std::string vo_name_;
-};
-
+  return true;
+}
 
 ArcSec::SecHandlerStatus LegacySecHandler::Handle(Arc::Message* msg) const {
   if(conf_files_.size() <= 0) {
@@ -126,13 +72,13 @@ ArcSec::SecHandlerStatus LegacySecHandler::Handle(Arc::Message* msg) const {
       return true;
     };
   };
+  std::list<Arc::ThreadedPointer<LegacySecConfig> > configs;
+  if(!GetConfigs(configs)) return false;
   AuthUser auth(*msg);
   Arc::AutoPointer<LegacySecAttr> sattr(new LegacySecAttr(logger));
-  for(std::list<std::string>::const_iterator conf_file = conf_files_.begin();
-                             conf_file != conf_files_.end();++conf_file) {
-    LegacySHCP parser(*conf_file,logger,auth /*,*sattr*/);
-    if(!parser) return false;
-    if(!parser.Parse()) return false;
+  for(std::list<Arc::ThreadedPointer<LegacySecConfig> >::iterator config = configs.begin();
+                             config != configs.end();++config) {
+    (*config)->Evaluate(auth);
   };
   // Pass all matched groups and VOs to LegacySecAttr
   {
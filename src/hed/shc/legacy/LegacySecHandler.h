@@ -4,12 +4,17 @@
 
 #include <string.h>
 
+#include <map>
+
 #include <arc/ArcConfig.h>
+#include <arc/Thread.h>
 #include <arc/message/Message.h>
 #include <arc/message/SecHandler.h>
 
 namespace ArcSHCLegacy {
 
+class LegacySecConfig;
+
 /**
  Processes configuration and evaluates groups to which requestor belongs.
  Obtained result is stored in message context as LegacySecAttr security 
@@ -19,6 +24,10 @@ class LegacySecHandler : public ArcSec::SecHandler {
  private:
   std::list<std::string> conf_files_;
   std::string attrname_;
+  // Parsed configuration files, reparsed when modified
+  mutable Glib::Mutex configs_lock_;
+  mutable std::map<std::string,Arc::ThreadedPointer<LegacySecConfig> > configs_;
+  bool GetConfigs(std::list<Arc::ThreadedPointer<LegacySecConfig> >& configs) const;
  public:
   LegacySecHandler(Arc::Config *cfg, Arc::ChainContext* ctx, Arc::PluginArgument* parg);
   virtual ~LegacySecHandler(void);
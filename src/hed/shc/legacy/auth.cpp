@@ -77,17 +77,45 @@ AuthResult AuthUser::match_vo(const char* line) {
 }
 
 AuthUser::source_t AuthUser::sources[] = {
-  { "all", &AuthUser::match_all },
-  { "authgroup", &AuthUser::match_group },
-  { "subject", &AuthUser::match_subject },
-  { "file", &AuthUser::match_file },
-  { "voms", &AuthUser::match_voms },
-  { "authtokens", &AuthUser::match_otokens },
-  { "userlist", &AuthUser::match_vo },
-  { "plugin", &AuthUser::match_plugin },
-  { NULL, NULL }
+  { "all", &AuthUser::match_all, NULL, NULL },
+  { "authgroup", &AuthUser::match_group, NULL, NULL },
+  { "subject", NULL, &AuthUser::compile_subject, &AuthUser::match_subject },
+  { "file", NULL, &AuthUser::compile_subject, &AuthUser::match_file },
+  { "voms", NULL, &AuthUser::compile_voms, &AuthUser::match_voms },
+  { "authtokens", NULL, &AuthUser::compile_otokens, &AuthUser::match_otokens },
+  { "userlist", &AuthUser::match_vo, NULL, NULL },
+  { "plugin", &AuthUser::match_plugin, NULL, NULL },
+  { NULL, NULL, NULL, NULL }
 };
 
+AuthRule::AuthRule(const std::string& rule):
+    empty_(false), invert_(false), no_match_(false), source_(-1), args_valid_(false) {
+  const char* line = rule.c_str();
+  const char* command = "subject";
+  size_t command_len = 7;
+  for(;*line;line++) if(!isspace(*line)) break;
+  if((*line == 0) || (*line == '#')) { empty_=true; return; };
+  if(*line == '-') { line++; invert_=true; }
+  else if(*line == '+') { line++; };
+  if(*line == '!') { no_match_=true; line++; };
+  if((*line != '/') && (*line != '"')) {
+    command=line; 
+    for(;*line;line++) if(isspace(*line)) break;
+    command_len=line-command;
+    for(;*line;line++) if(!isspace(*line)) break;
+  };
+  for(int n = 0;AuthUser::sources[n].cmd;++n) {
+    const AuthUser::source_t& s = AuthUser::sources[n];
+    if((strncmp(s.cmd,command,command_len) == 0) && 
+       (strlen(s.cmd) == command_len)) {
+      source_ = n;
+      arg_ = line;
+      if(s.compile) args_valid_ = (*(s.compile))(line,args_);
+      break;
+    };
+  };
+}
+
 AuthUser::AuthUser(const AuthUser& a):message_(a.message_) {
   subject_ = a.subject_;
   voms_data_ = a.voms_data_;
@@ -234,48 +262,34 @@ AuthUser::~AuthUser(void) {
 }
 
 AuthResult AuthUser::evaluate(const char* line) {
-  bool invert = false;
-  bool no_match = false;
-  const char* command = "subject";
-  size_t command_len = 7;
   // There can be rules not based on subject
   // if(subject_.empty()) return AAA_NO_MATCH; // ??
   if(!line) return AAA_NO_MATCH;
-  for(;*line;line++) if(!isspace(*line)) break;
-  if(*line == 0) return AAA_NO_MATCH;
-  if(*line == '#') return AAA_NO_MATCH;
-  if(*line == '-') { line++; invert=true; }
-  else if(*line == '+') { line++; };
-  if(*line == '!') { no_match=true; line++; };
-  if((*line != '/') && (*line != '"')) {
-    command=line; 
-    for(;*line;line++) if(isspace(*line)) break;
-    command_len=line-command;
-    for(;*line;line++) if(!isspace(*line)) break;
+  return evaluate(AuthRule(line));
+}
+
+AuthResult AuthUser::evaluate(const AuthRule& rule) {
+  if(rule.empty_) return AAA_NO_MATCH;
+  if(rule.source_ < 0) return AAA_FAILURE;
+  const source_t& s = sources[rule.source_];
+  AuthResult res = s.rule_func ? (this->*(s.rule_func))(rule)
+                               : (this->*(s.func))(rule.arg_.c_str());
+  if(res == AAA_FAILURE) return res;
+  if(rule.no_match_) {
+    if(res==AAA_NO_MATCH) { res=AAA_POSITIVE_MATCH; }
+    else { res=AAA_NO_MATCH; };
   };
-  for(source_t* s = sources;s->cmd;s++) {
-    if((strncmp(s->cmd,command,command_len) == 0) && 
-       (strlen(s->cmd) == command_len)) {
-      AuthResult res=(this->*(s->func))(line);
-      if(res == AAA_FAILURE) return res;
-      if(no_match) {
-        if(res==AAA_NO_MATCH) { res=AAA_POSITIVE_MATCH; }
-        else { res=AAA_NO_MATCH; };
-      };
-      if(invert) {
-        switch(res) {
-          case AAA_POSITIVE_MATCH: res = AAA_NEGATIVE_MATCH; break;
-          case AAA_NEGATIVE_MATCH: res = AAA_POSITIVE_MATCH; break;
-          case AAA_NO_MATCH:
-          case AAA_FAILURE:
-          default:
-            break;
-        };
-      };
-      return res;
+  if(rule.invert_) {
+    switch(res) {
+      case AAA_POSITIVE_MATCH: res = AAA_NEGATIVE_MATCH; break;
+      case AAA_NEGATIVE_MATCH: res = AAA_POSITIVE_MATCH; break;
+      case AAA_NO_MATCH:
+      case AAA_FAILURE:
+      default:
+        break;
     };
   };
-  return AAA_FAILURE; 
+  return res;
 }
 
 const std::list<std::string>& AuthUser::VOs(void) {
@@ -18,6 +18,23 @@ enum AuthResult {
 };
 
 class AuthVO;
+class AuthUser;
+
+/** Matching rule split into elements in advance. Used for rules which
+    are evaluated repeatedly so that evaluation needs no parsing. */
+class AuthRule {
+ friend class AuthUser;
+ public:
+  AuthRule(const std::string& line);
+ private:
+  bool empty_;     // empty line or comment - never matches
+  bool invert_;    // '-' prefix
+  bool no_match_;  // '!' prefix
+  int source_;     // index in AuthUser::sources, negative for unknown rule
+  std::string arg_;                // argument of rule as written
+  std::vector<std::string> args_;  // argument split by source specific compile method
+  bool args_valid_;                // if argument was split successfully
+};
 
 /** VOMS FQAN split into elements */
 struct voms_fqan_t {
@@ -43,11 +60,16 @@ struct otokens_t {
 };
 
 class AuthUser {
+ friend class AuthRule;
  private:
   typedef AuthResult (AuthUser:: * match_func_t)(const char* line);
+  typedef AuthResult (AuthUser:: * match_rule_func_t)(const AuthRule& rule);
+  typedef bool (* compile_func_t)(const char* line, std::vector<std::string>& args);
   typedef struct {
     const char* cmd;
-    match_func_t func;
+    match_func_t func;           // matching of rule argument as written
+    compile_func_t compile;      // splitting of argument in AuthRule, optional
+    match_rule_func_t rule_func; // matching of split argument, used with compile
   } source_t;
   class group_t {
    public:
@@ -79,14 +101,17 @@ class AuthUser {
   static source_t sources[]; // Supported evaluation sources
   AuthResult match_all(const char* line);
   AuthResult match_group(const char* line);
-  AuthResult match_subject(const char* line);
-  AuthResult match_file(const char* line);
+  AuthResult match_subject(const AuthRule& rule);
+  AuthResult match_file(const AuthRule& rule);
   AuthResult match_ldap(const char* line);
-  AuthResult match_voms(const char* line);
-  AuthResult match_otokens(const char* line);
+  AuthResult match_voms(const AuthRule& rule);
+  AuthResult match_otokens(const AuthRule& rule);
   AuthResult match_vo(const char* line);
   AuthResult match_lcas(const char *);
   AuthResult match_plugin(const char* line);
+  static bool compile_subject(const char* line, std::vector<std::string>& args);
+  static bool compile_voms(const char* line, std::vector<std::string>& args);
+  static bool compile_otokens(const char* line, std::vector<std::string>& args);
 
   const group_t* find_group(const char* grp) const {
     if(grp == NULL) return NULL;
@@ -125,6 +150,7 @@ class AuthUser {
   //void set(const char* s,STACK_OF(X509)* cred,const char* hostname = NULL);
   // Evaluate authentication rules
   AuthResult evaluate(const char* line);
+  AuthResult evaluate(const AuthRule& rule);
   const char* subject(void) const { return subject_.c_str(); };
   const char* proxy(void) const {
     (const_cast<AuthUser*>(this))->store_credentials();
@@ -5,9 +5,16 @@
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <set>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <arc/StringConv.h>
 #include <arc/Logger.h>
+#include <arc/Thread.h>
 
 #include "auth.h"
 
@@ -15,13 +22,25 @@ namespace ArcSHCLegacy {
 
 static Arc::Logger logger(Arc::Logger::getRootLogger(),"AuthUser");
 
-AuthResult AuthUser::match_file(const char* line) {
-  std::string token = Arc::trim(line);
-  std::ifstream f(token.c_str());
-  if(!f.is_open()) {
-    logger.msg(Arc::ERROR, "Failed to read file %s", token);
-    return AAA_FAILURE;
-  };
+// Subjects listed in files used in file= rules. Every file is read
+// once and read again only if it is modified. Such files may contain
+// many subjects and are evaluated for every new connection.
+class AuthSubjectsFile {
+ public:
+  AuthSubjectsFile(void):mtime(0),mtime_nsec(0),size(0),ino(0) { };
+  time_t mtime;
+  long mtime_nsec; // sub-second part, list may be replaced quickly
+  off_t size;
+  ino_t ino;
+  std::set<std::string> subjects;
+};
+
+static Glib::Mutex subjects_files_lock;
+static std::map<std::string,AuthSubjectsFile> subjects_files;
+
+static bool read_subjects(const std::string& filename, std::set<std::string>& subjects) {
+  std::ifstream f(filename.c_str());
+  if(!f.is_open()) return false;
   for(;f.good();) {
     std::string buf;
     getline(f,buf);
@@ -36,12 +55,40 @@ AuthResult AuthUser::match_file(const char* line) {
     std::string subj;
     p = Arc::get_token(subj,buf,p," ","\"","\"");
     if(subj.empty()) continue; // can't match empty subject - it is dangerous
-    if(subject_ != subj) continue;
-    f.close();
-    return AAA_POSITIVE_MATCH;
+    subjects.insert(subj);
   };
   f.close();
-  return AAA_NO_MATCH;
+  return true;
+}
+
+AuthResult AuthUser::match_file(const AuthRule& rule) {
+  const std::string& filename = rule.args_[0];
+  struct stat st;
+  if(::stat(filename.c_str(),&st) != 0) {
+    logger.msg(Arc::ERROR, "Failed to read file %s", filename);
+    return AAA_FAILURE;
+  };
+  Glib::Mutex::Lock lock(subjects_files_lock);
+  std::map<std::string,AuthSubjectsFile>::iterator file = subjects_files.find(filename);
+  if((file == subjects_files.end()) ||
+     (file->second.mtime != st.st_mtim.tv_sec) || (file->second.mtime_nsec != st.st_mtim.tv_nsec) ||
+     (file->second.size != st.st_size) || (file->second.ino != st.st_ino)) {
+    std::set<std::string> subjects;
+    if(!read_subjects(filename,subjects)) {
+      logger.msg(Arc::ERROR, "Failed to read file %s", filename);
+      if(file != subjects_files.end()) subjects_files.erase(file);
+      return AAA_FAILURE;
+    };
+    AuthSubjectsFile& entry = subjects_files[filename];
+    entry.mtime = st.st_mtim.tv_sec;
+    entry.mtime_nsec = st.st_mtim.tv_nsec;
+    entry.size = st.st_size;
+    entry.ino = st.st_ino;
+    entry.subjects.swap(subjects);
+    file = subjects_files.find(filename);
+  };
+  if(file->second.subjects.find(subject_) == file->second.subjects.end()) return AAA_NO_MATCH;
+  return AAA_POSITIVE_MATCH;
 }
 
 } // namespace ArcSHCLegacy
@@ -15,10 +15,8 @@ namespace ArcSHCLegacy {
 
 static Arc::Logger logger(Arc::Logger::getRootLogger(),"AuthUserOTokens");
 
-AuthResult AuthUser::match_otokens(const char* line) {
-  // No need to process anything if no OTokens is present
-  if(otokens_data_.empty()) return AAA_NO_MATCH;
-  // parse line
+bool AuthUser::compile_otokens(const char* line, std::vector<std::string>& args) {
+  // authtokens = subject issuer audience scope group
   std::string subject("");
   std::string issuer("");
   std::string audience("");
@@ -28,28 +26,46 @@ AuthResult AuthUser::match_otokens(const char* line) {
   n=Arc::get_token(subject,line,n," ","\"","\"");
   if((n == std::string::npos) && (subject.empty())) {
     logger.msg(Arc::ERROR, "Missing subject in configuration");
-    return AAA_FAILURE;
+    return false;
   };
   n=Arc::get_token(issuer,line,n," ","\"","\"");
   if((n == std::string::npos) && (issuer.empty())) {
     logger.msg(Arc::ERROR, "Missing issuer in configuration");
-    return AAA_FAILURE;
+    return false;
   };
   n=Arc::get_token(audience,line,n," ","\"","\"");
   if((n == std::string::npos) && (audience.empty())) {
     logger.msg(Arc::ERROR, "Missing audience in configuration");
-    return AAA_FAILURE;
+    return false;
   };
   n=Arc::get_token(scope,line,n," ","\"","\"");
   if((n == std::string::npos) && (scope.empty())) {
     logger.msg(Arc::ERROR, "Missing scope in configuration");
-    return AAA_FAILURE;
+    return false;
   };
   n=Arc::get_token(group,line,n," ","\"","\"");
   if((n == std::string::npos) && (group.empty())) {
     logger.msg(Arc::ERROR, "Missing group in configuration");
-    return AAA_FAILURE;
+    return false;
   };
+  args.push_back(subject);
+  args.push_back(issuer);
+  args.push_back(audience);
+  args.push_back(scope);
+  args.push_back(group);
+  return true;
+}
+
+AuthResult AuthUser::match_otokens(const AuthRule& rule) {
+  // No need to process anything if no OTokens is present
+  if(otokens_data_.empty()) return AAA_NO_MATCH;
+  // Problem with rule was reported while compiling it
+  if(!rule.args_valid_) return AAA_FAILURE;
+  const std::string& subject = rule.args_[0];
+  const std::string& issuer = rule.args_[1];
+  const std::string& audience = rule.args_[2];
+  const std::string& scope = rule.args_[3];
+  const std::string& group = rule.args_[4];
   logger.msg(Arc::VERBOSE, "Rule: subject: %s", subject);
   logger.msg(Arc::VERBOSE, "Rule: issuer: %s", issuer);
   logger.msg(Arc::VERBOSE, "Rule: audience: %s", audience);
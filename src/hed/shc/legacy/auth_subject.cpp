@@ -10,8 +10,14 @@
 
 namespace ArcSHCLegacy {
 
-AuthResult AuthUser::match_subject(const char* line) {
-  std::string subj = Arc::trim(line);
+bool AuthUser::compile_subject(const char* line, std::vector<std::string>& args) {
+  // Same for subject and file name
+  args.push_back(Arc::trim(line));
+  return true;
+}
+
+AuthResult AuthUser::match_subject(const AuthRule& rule) {
+  const std::string& subj = rule.args_[0];
   if(subj.empty()) return AAA_NO_MATCH; // can't match empty subject - it is dangerous
   if(subject_ == subj) return AAA_POSITIVE_MATCH;
   return AAA_NO_MATCH;
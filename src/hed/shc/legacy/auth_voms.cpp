@@ -24,13 +24,8 @@ static bool match_value(const std::string& value, const std::vector<std::string>
   return false;
 }
 
-AuthResult AuthUser::match_voms(const char* line) {
+bool AuthUser::compile_voms(const char* line, std::vector<std::string>& args) {
   // voms = vo group role capabilities
-
-  // No need to process anything if no VOMS extensions are present
-  if(voms_data_.empty()) return AAA_NO_MATCH;
-
-  // parse line
   std::string vo("");
   std::string group("");
   std::string role("");
@@ -40,28 +35,45 @@ AuthResult AuthUser::match_voms(const char* line) {
   n=Arc::get_token(vo,line,n," ");
   if((n == std::string::npos) && (vo.empty())) {
     logger.msg(Arc::ERROR, "Missing VO in configuration");
-    return AAA_FAILURE;
+    return false;
   };
   n=Arc::get_token(group,line,n," ");
   if((n == std::string::npos) && (group.empty())) {
     logger.msg(Arc::ERROR, "Missing group in configuration");
-    return AAA_FAILURE;
+    return false;
   };
   n=Arc::get_token(role,line,n," ");
   if((n == std::string::npos) && (role.empty())) {
     logger.msg(Arc::ERROR, "Missing role in configuration");
-    return AAA_FAILURE;
+    return false;
   };
   n=Arc::get_token(capabilities,line,n," ");
   if((n == std::string::npos) && (capabilities.empty())) {
     logger.msg(Arc::ERROR, "Missing capabilities in configuration");
-    return AAA_FAILURE;
+    return false;
   };
   n=Arc::get_token(auto_c,line,n," ");
   if(!auto_c.empty()) {
     logger.msg(Arc::ERROR, "Too many arguments in configuration");
-    return AAA_FAILURE;
+    return false;
   };
+  args.push_back(vo);
+  args.push_back(group);
+  args.push_back(role);
+  args.push_back(capabilities);
+  return true;
+}
+
+AuthResult AuthUser::match_voms(const AuthRule& rule) {
+  // No need to process anything if no VOMS extensions are present
+  if(voms_data_.empty()) return AAA_NO_MATCH;
+
+  // Problem with rule was reported while compiling it
+  if(!rule.args_valid_) return AAA_FAILURE;
+  const std::string& vo = rule.args_[0];
+  const std::string& group = rule.args_[1];
+  const std::string& role = rule.args_[2];
+  const std::string& capabilities = rule.args_[3];
   logger.msg(Arc::VERBOSE, "Rule: vo: %s", vo);
   logger.msg(Arc::VERBOSE, "Rule: group: %s", group);
   logger.msg(Arc::VERBOSE, "Rule: role: %s", role);
@@ -0,0 +1,236 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <fstream>
+#include <map>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <arc/FileUtils.h>
+#include <arc/message/Message.h>
+#include <arc/message/SecAttr.h>
+
+#include "../LegacySecConfig.h"
+
+using namespace ArcSHCLegacy;
+
+static Arc::Logger logger(Arc::Logger::getRootLogger(), "LegacySecConfigTest");
+
+static const std::string user_subject("/O=Grid/O=Test/CN=Test User");
+
+// Attributes of TLS connection as collected by MCC
+class TestSecAttr: public Arc::SecAttr {
+ public:
+  TestSecAttr(const std::string& subject) { attrs_["IDENTITY"].push_back(subject); };
+  virtual ~TestSecAttr(void) { };
+  virtual operator bool(void) const { return true; };
+  virtual std::string get(const std::string& id) const {
+    std::map<std::string, std::list<std::string> >::const_iterator attr = attrs_.find(id);
+    if ((attr == attrs_.end()) || attr->second.empty()) return "";
+    return attr->second.front();
+  };
+  virtual std::list<std::string> getAll(const std::string& id) const {
+    std::map<std::string, std::list<std::string> >::const_iterator attr = attrs_.find(id);
+    if (attr == attrs_.end()) return std::list<std::string>();
+    return attr->second;
+  };
+  void add(const std::string& id, const std::string& value) { attrs_[id].push_back(value); };
+ private:
+  std::map<std::string, std::list<std::string> > attrs_;
+};
+
+class LegacySecConfigTest
+  : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(LegacySecConfigTest);
+  CPPUNIT_TEST(TestRuleParsing);
+  CPPUNIT_TEST(TestFirstMatch);
+  CPPUNIT_TEST(TestConfigModified);
+  CPPUNIT_TEST(TestSubjectsFileReload);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void TestRuleParsing();
+  void TestFirstMatch();
+  void TestConfigModified();
+  void TestSubjectsFileReload();
+
+  void setUp();
+  void tearDown();
+
+private:
+  std::string tmpdir;
+  Arc::Message msg;
+};
+
+// Rewrites file in place, so that only its content and modification
+// time change. Modification time is set explicitly to make changes
+// within same second visible regardless of file system timestamps.
+static bool RewriteFile(const std::string& filename, const std::string& content, long mtime_nsec) {
+  {
+    std::ofstream f(filename.c_str(), std::ios::out | std::ios::trunc);
+    if (!f) return false;
+    f << content;
+    if (!f) return false;
+  }
+  struct timespec times[2];
+  times[0].tv_sec = 1500000000;
+  times[0].tv_nsec = mtime_nsec;
+  times[1] = times[0];
+  return (::utimensat(AT_FDCWD, filename.c_str(), times, 0) == 0);
+}
+
+void LegacySecConfigTest::setUp() {
+  tmpdir.clear();
+  CPPUNIT_ASSERT(Arc::TmpDirCreate(tmpdir));
+  TestSecAttr* tls = new TestSecAttr(user_subject);
+  tls->add("VOMS", "/VO=testvo/Group=testvo/Role=tester");
+  msg.Auth()->set("TLS", tls);
+}
+
+void LegacySecConfigTest::tearDown() {
+  Arc::DirDelete(tmpdir);
+}
+
+void LegacySecConfigTest::TestRuleParsing() {
+  AuthUser auth(msg);
+  CPPUNIT_ASSERT_EQUAL(user_subject, std::string(auth.subject()));
+
+  // Source is subject when rule starts with subject itself
+  CPPUNIT_ASSERT_EQUAL(AAA_POSITIVE_MATCH, auth.evaluate(AuthRule("subject " + user_subject)));
+  CPPUNIT_ASSERT_EQUAL(AAA_POSITIVE_MATCH, auth.evaluate(AuthRule(user_subject)));
+  CPPUNIT_ASSERT_EQUAL(AAA_POSITIVE_MATCH, auth.evaluate(AuthRule("  +subject  " + user_subject + "  ")));
+  CPPUNIT_ASSERT_EQUAL(AAA_NO_MATCH, auth.evaluate(AuthRule("subject /O=Grid/O=Test/CN=Other User")));
+
+  // '-' inverts result and '!' matches when rule does not
+  CPPUNIT_ASSERT_EQUAL(AAA_NEGATIVE_MATCH, auth.evaluate(AuthRule("-subject " + user_subject)));
+  CPPUNIT_ASSERT_EQUAL(AAA_POSITIVE_MATCH, auth.evaluate(AuthRule("!subject /O=Grid/O=Test/CN=Other User")));
+  CPPUNIT_ASSERT_EQUAL(AAA_NO_MATCH, auth.evaluate(AuthRule("!subject " + user_subject)));
+  CPPUNIT_ASSERT_EQUAL(AAA_NEGATIVE_MATCH, auth.evaluate(AuthRule("-!subject /O=Grid/O=Test/CN=Other User")));
+
+  // Empty lines and comments never match
+  CPPUNIT_ASSERT_EQUAL(AAA_NO_MATCH, auth.evaluate(AuthRule("")));
+  CPPUNIT_ASSERT_EQUAL(AAA_NO_MATCH, auth.evaluate(AuthRule("   # all yes")));
+
+  // Unknown source and invalid arguments are failures
+  CPPUNIT_ASSERT_EQUAL(AAA_FAILURE, auth.evaluate(AuthRule("nosuchsource yes")));
+  CPPUNIT_ASSERT_EQUAL(AAA_FAILURE, auth.evaluate(AuthRule("voms testvo")));
+  CPPUNIT_ASSERT_EQUAL(AAA_FAILURE, auth.evaluate(AuthRule("all maybe")));
+
+  // Arguments split in advance
+  CPPUNIT_ASSERT_EQUAL(AAA_POSITIVE_MATCH, auth.evaluate(AuthRule("voms testvo /testvo tester *")));
+  CPPUNIT_ASSERT_EQUAL(AAA_NO_MATCH, auth.evaluate(AuthRule("voms othervo * * *")));
+
+  // Compiled rule gives same result as rule evaluated from text
+  CPPUNIT_ASSERT_EQUAL(auth.evaluate("-!subject /O=Grid/O=Test/CN=Other User"),
+                       auth.evaluate(AuthRule("-!subject /O=Grid/O=Test/CN=Other User")));
+  CPPUNIT_ASSERT_EQUAL(auth.evaluate("voms testvo"), auth.evaluate(AuthRule("voms testvo")));
+}
+
+void LegacySecConfigTest::TestFirstMatch() {
+  std::string subjects = tmpdir + "/subjects";
+  CPPUNIT_ASSERT(Arc::FileCreate(subjects, "\"" + user_subject + "\"\n"));
+  std::string conffile = tmpdir + "/arc.conf";
+  std::string conf =
+    "[authgroup:denied]\n"
+    "-subject = " + user_subject + "\n"
+    "all = yes\n"
+    "[authgroup:allowed]\n"
+    "subject = /O=Grid/O=Test/CN=Other User\n"
+    "subject = " + user_subject + "\n"
+    "-all = yes\n"
+    "[authgroup:unmatched]\n"
+    "subject = /O=Grid/O=Test/CN=Other User\n"
+    "[authgroup:nested]\n"
+    "authgroup = denied allowed\n"
+    "[authgroup:renamed]\n"
+    "name = realname\n"
+    "all = yes\n"
+    "[userlist:listed]\n"
+    "outfile = " + subjects + "\n"
+    "[userlist:unlisted]\n"
+    "outfile = " + tmpdir + "/nosuchfile\n";
+  CPPUNIT_ASSERT(Arc::FileCreate(conffile, conf));
+
+  LegacySecConfig config(conffile, logger);
+  CPPUNIT_ASSERT(config);
+  AuthUser auth(msg);
+  config.Evaluate(auth);
+
+  // Negative match stops evaluation of block
+  CPPUNIT_ASSERT(!auth.check_group("denied"));
+  CPPUNIT_ASSERT(auth.check_group("allowed"));
+  CPPUNIT_ASSERT(!auth.check_group("unmatched"));
+  // Groups assigned by preceding blocks are visible to following ones
+  CPPUNIT_ASSERT(auth.check_group("nested"));
+  CPPUNIT_ASSERT(auth.check_group("realname"));
+  CPPUNIT_ASSERT(!auth.check_group("renamed"));
+
+  CPPUNIT_ASSERT(auth.check_vo("listed"));
+  CPPUNIT_ASSERT(!auth.check_vo("unlisted"));
+
+  // Configuration is reused unchanged for next connection
+  AuthUser again(msg);
+  config.Evaluate(again);
+  std::list<std::string> groups;
+  std::list<std::string> groups_again;
+  auth.get_groups(groups);
+  again.get_groups(groups_again);
+  CPPUNIT_ASSERT(groups == groups_again);
+}
+
+void LegacySecConfigTest::TestConfigModified() {
+  std::string conffile = tmpdir + "/arc.conf";
+  CPPUNIT_ASSERT(RewriteFile(conffile, "[authgroup:one]\nall = yes\n", 100));
+  LegacySecConfig config(conffile, logger);
+  CPPUNIT_ASSERT(config);
+  CPPUNIT_ASSERT(!config.Modified());
+
+  // Same size, same inode and same second
+  CPPUNIT_ASSERT(RewriteFile(conffile, "[authgroup:two]\nall = yes\n", 200));
+  CPPUNIT_ASSERT(config.Modified());
+
+  LegacySecConfig reloaded(conffile, logger);
+  CPPUNIT_ASSERT(reloaded);
+  CPPUNIT_ASSERT(!reloaded.Modified());
+  AuthUser auth(msg);
+  reloaded.Evaluate(auth);
+  CPPUNIT_ASSERT(!auth.check_group("one"));
+  CPPUNIT_ASSERT(auth.check_group("two"));
+
+  CPPUNIT_ASSERT(Arc::FileDelete(conffile));
+  CPPUNIT_ASSERT(reloaded.Modified());
+  LegacySecConfig missing(conffile, logger);
+  CPPUNIT_ASSERT(!missing);
+}
+
+void LegacySecConfigTest::TestSubjectsFileReload() {
+  std::string subjects = tmpdir + "/subjects";
+  std::string other_subject("/O=Grid/O=Test/CN=Else User");
+  CPPUNIT_ASSERT_EQUAL(user_subject.length(), other_subject.length());
+  AuthRule rule("file " + subjects);
+  AuthUser auth(msg);
+
+  CPPUNIT_ASSERT_EQUAL(AAA_FAILURE, auth.evaluate(rule));
+
+  CPPUNIT_ASSERT(RewriteFile(subjects, "\"" + other_subject + "\"\n", 100));
+  CPPUNIT_ASSERT_EQUAL(AAA_NO_MATCH, auth.evaluate(rule));
+
+  // Cached list must be replaced even if only sub-second part of
+  // modification time differs
+  CPPUNIT_ASSERT(RewriteFile(subjects, "\"" + user_subject + "\"\n", 200));
+  CPPUNIT_ASSERT_EQUAL(AAA_POSITIVE_MATCH, auth.evaluate(rule));
+
+  CPPUNIT_ASSERT(RewriteFile(subjects, "# " + other_subject + "\n", 300));
+  CPPUNIT_ASSERT_EQUAL(AAA_NO_MATCH, auth.evaluate(rule));
+
+  // Removed file is not served from cache
+  CPPUNIT_ASSERT(Arc::FileDelete(subjects));
+  CPPUNIT_ASSERT_EQUAL(AAA_FAILURE, auth.evaluate(rule));
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(LegacySecConfigTest);
@@ -0,0 +1,140 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <arc/security/ArcPDP/Evaluator.h>
+#include <arc/security/ArcPDP/EvaluatorLoader.h>
+#include <arc/security/ArcPDP/Response.h>
+#include <arc/DateTime.h>
+#include <arc/FileUtils.h>
+#include <arc/Logger.h>
+#include <arc/StringConv.h>
+#include <arc/XMLNode.h>
+
+// Measures time needed to authorize requests against large ARC policy.
+// Policy has many rules with one subject each and one rule listing all
+// subjects. First policy is parsed for every request, like ArcPDP used
+// to do for every new connection. Then same Evaluator is reused, like
+// ArcPDP does now with Evaluators made from already parsed policies.
+
+static void report(const std::string& title, const Arc::Time& start, int count) {
+  Arc::Period period = Arc::Time() - start;
+  double seconds = period.GetPeriod() + period.GetPeriodNanoseconds() / 1000000000.0;
+  std::cout<<title<<": "<<seconds<<" s ("<<(seconds * 1000.0 / count)<<" ms each)"<<std::endl;
+}
+
+static std::string subject(int n) {
+  return "/O=Grid/OU=Benchmark/CN=User " + Arc::tostring(n);
+}
+
+static bool permitted(ArcSec::Evaluator* eval, Arc::XMLNode& request) {
+  ArcSec::Response* resp = eval->evaluate(ArcSec::Source(request));
+  if(!resp) return false;
+  bool result = false;
+  ArcSec::ResponseList rlist = resp->getResponseItems();
+  for(int i = 0; i < rlist.size(); i++) {
+    if(rlist[i]->res == ArcSec::DECISION_DENY) { result = false; break; }
+    if(rlist[i]->res == ArcSec::DECISION_PERMIT) result = true;
+  }
+  delete resp;
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  Arc::LogStream cdest(std::cerr);
+  Arc::Logger::getRootLogger().addDestination(cdest);
+  Arc::Logger::getRootLogger().setThreshold(Arc::WARNING);
+
+  int rules = 1000;
+  int iterations = 100;
+  if(argc > 1) rules = atoi(argv[1]);
+  if(argc > 2) iterations = atoi(argv[2]);
+  if(rules <= 0) rules = 1;
+  if(iterations <= 0) iterations = 1;
+
+  Arc::NS ns("policy", "http://www.nordugrid.org/schemas/policy-arc");
+  Arc::XMLNode policy(ns, "policy:Policy");
+  policy.NewAttribute("PolicyId") = "benchmark";
+  policy.NewAttribute("CombiningAlg") = "Deny-Overrides";
+  for(int n = 0; n < rules; ++n) {
+    Arc::XMLNode rule = policy.NewChild("policy:Rule");
+    rule.NewAttribute("RuleId") = "rule" + Arc::tostring(n);
+    rule.NewAttribute("Effect") = "Permit";
+    rule.NewChild("policy:Subjects").NewChild("policy:Subject") = subject(n);
+    rule.NewChild("policy:Actions").NewChild("policy:Action") = "read";
+  }
+  Arc::XMLNode rule = policy.NewChild("policy:Rule");
+  rule.NewAttribute("RuleId") = "all";
+  rule.NewAttribute("Effect") = "Permit";
+  Arc::XMLNode subjects = rule.NewChild("policy:Subjects");
+  for(int n = 0; n < rules; ++n) subjects.NewChild("policy:Subject") = subject(n);
+  rule.NewChild("policy:Actions").NewChild("policy:Action") = "list";
+
+  std::string policy_str;
+  policy.GetXML(policy_str);
+  std::string policy_file;
+  if(!Arc::TmpFileCreate(policy_file, policy_str)) {
+    std::cerr<<"Failed to write policy file"<<std::endl;
+    return 1;
+  }
+
+  Arc::XMLNode request("\
+     <ra:Request xmlns:ra=\"http://www.nordugrid.org/schemas/request-arc\">\
+      <ra:RequestItem>\
+       <ra:Subject>\
+        <ra:Attribute ra:Type='string'>" + subject(rules - 1) + "</ra:Attribute>\
+       </ra:Subject>\
+       <ra:Action ra:Type='string'>read</ra:Action>\
+      </ra:RequestItem>\
+      <ra:RequestItem>\
+       <ra:Subject>\
+        <ra:Attribute ra:Type='string'>" + subject(rules - 1) + "</ra:Attribute>\
+       </ra:Subject>\
+       <ra:Action ra:Type='string'>list</ra:Action>\
+      </ra:RequestItem>\
+     </ra:Request>");
+
+  ArcSec::EvaluatorLoader eval_loader;
+  int result = 0;
+
+  Arc::Time start;
+  for(int n = 0; n < iterations; ++n) {
+    ArcSec::Evaluator* eval = eval_loader.getEvaluator(std::string("arc.evaluator"));
+    if(!eval) {
+      std::cerr<<"Can not dynamically produce Evaluator"<<std::endl;
+      result = 1;
+      break;
+    }
+    eval->addPolicy(ArcSec::SourceFile(policy_file));
+    bool allowed = permitted(eval, request);
+    delete eval;
+    if(!allowed) {
+      std::cerr<<"Request was not permitted"<<std::endl;
+      result = 1;
+      break;
+    }
+  }
+  if(result == 0) report("Parsing policy for every request", start, iterations);
+
+  ArcSec::Evaluator* eval = (result == 0) ? eval_loader.getEvaluator(std::string("arc.evaluator")) : NULL;
+  if(eval) {
+    eval->addPolicy(ArcSec::SourceFile(policy_file));
+    start = Arc::Time();
+    for(int n = 0; n < iterations; ++n) {
+      if(!permitted(eval, request)) {
+        std::cerr<<"Request was not permitted"<<std::endl;
+        result = 1;
+        break;
+      }
+    }
+    if(result == 0) report("Reusing Evaluator", start, iterations);
+    delete eval;
+  }
+
+  Arc::FileDelete(policy_file);
+  return result;
+}
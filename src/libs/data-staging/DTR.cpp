@@ -2,6 +2,8 @@
 #include <config.h>
 #endif
 
+#include <algorithm>
+
 #include <utime.h>
 
 #include <arc/FileLock.h>
@@ -12,6 +14,7 @@
 #include "Processor.h"
 #include "DataDelivery.h"
 #include "Scheduler.h"
+#include "DTRList.h"
 
 #include "DTR.h"
 
@@ -72,7 +75,8 @@ namespace DataStaging {
        use_host_cert_for_remote_delivery(false),
        current_owner(GENERATOR),
        log_destinations(logs),
-       perf_record(perf_log)
+       perf_record(perf_log),
+       registry(NULL)
   {
     logger = new Arc::Logger(Arc::Logger::getRootLogger(), logname.c_str());
     logger->addDestinations(get_log_destinations());
@@ -214,6 +218,7 @@ namespace DataStaging {
     status = stat;
     lock.unlock();
     mark_modification();
+    notify_registry();
   }
   
   DTRStatus DTR::get_status() {
@@ -280,6 +285,7 @@ namespace DataStaging {
     Arc::Time t;
     t = t + process_time;
     next_process_time.SetTime(t.GetTime(), t.GetTimeNanoseconds());
+    notify_registry();
   }
 
   bool DTR::bulk_possible() {
@@ -314,6 +320,7 @@ namespace DataStaging {
     dtr->lock.lock();
     dtr->current_owner = new_owner;
     dtr->lock.unlock();
+    dtr->notify_registry();
 
     std::list<DTRCallback*> callbacks = dtr->get_callbacks(dtr->proc_callback,dtr->current_owner);
     if (callbacks.empty())
@@ -351,19 +358,28 @@ namespace DataStaging {
     return true;
   }
   
+  void DTR::notify_registry() {
+    // Must be called without holding lock since DTRList takes its own
+    // lock first and then reads DTR properties
+    lock.lock();
+    DTRList* list = registry;
+    lock.unlock();
+    if (list) list->update_dtr(this);
+  }
+
   bool DTR::is_destined_for_pre_processor() const {
-  	return (status == DTRStatus::PRE_CLEAN || status == DTRStatus::CHECK_CACHE ||
-  	   status == DTRStatus::RESOLVE || status == DTRStatus::QUERY_REPLICA ||
-  	   status == DTRStatus::STAGE_PREPARE);
+    return (std::find(DTRStatus::PreProcessorStates.begin(), DTRStatus::PreProcessorStates.end(),
+                      status.GetStatus()) != DTRStatus::PreProcessorStates.end());
   }
   
   bool DTR::is_destined_for_post_processor() const {
-  	return (status == DTRStatus::RELEASE_REQUEST || status == DTRStatus::REGISTER_REPLICA ||
-  	   status == DTRStatus::PROCESS_CACHE);
+    return (std::find(DTRStatus::PostProcessorStates.begin(), DTRStatus::PostProcessorStates.end(),
+                      status.GetStatus()) != DTRStatus::PostProcessorStates.end());
   }
   
   bool DTR::is_destined_for_delivery() const {
-  	return (status == DTRStatus::TRANSFER);
+    return (std::find(DTRStatus::DeliveryStates.begin(), DTRStatus::DeliveryStates.end(),
+                      status.GetStatus()) != DTRStatus::DeliveryStates.end());
   }
   
   bool DTR::came_from_pre_processor() const {
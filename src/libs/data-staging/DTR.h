@@ -54,6 +54,7 @@ namespace DataStaging {
 namespace DataStaging {
 
   class DTR;
+  class DTRList;
 
   /// Provides automatic memory management of DTRs and thread-safe destruction.
   /** \ingroup datastaging */
@@ -110,9 +111,16 @@ namespace DataStaging {
     unsigned long long int min_current_bandwidth;
     /// The time in seconds over which to average the calculation of min_current_bandwidth.
     unsigned int averaging_time;
+    /// Use DataRingBuffer and vectored I/O if both ends support it.
+    /**
+     * Only applies to transfers done by local delivery.
+     * \since Added in 6.9.0.
+     */
+    bool vectored_io;
     /// Constructor. Initialises all values to zero.
     TransferParameters() : min_average_bandwidth(0), max_inactivity_time(0),
-                           min_current_bandwidth(0), averaging_time(0) {};
+                           min_current_bandwidth(0), averaging_time(0),
+                           vectored_io(false) {};
   };
 
   /// The configured cache directories
@@ -377,6 +385,14 @@ namespace DataStaging {
     /// Lock to avoid collisions while changing DTR properties
     Arc::SimpleCondition lock;
 
+    /// DTRList in which this DTR is registered, if any.
+    /** It is notified of changes in status, owner and processing time so
+     * that it can keep its indexes in sync. Protected by lock. */
+    DTRList* registry;
+
+    /// Notify the registry (if any) that indexed properties changed.
+    void notify_registry();
+
     /** Possible fields  (types, names and so on are subject to change) **
 
     /// DTRs that are grouped must have the same number here
@@ -400,6 +416,8 @@ namespace DataStaging {
     DTR(const DTR& dtr);
     DTR();
 
+    friend class DTRList;
+
 
   public:
 
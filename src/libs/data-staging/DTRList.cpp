@@ -9,50 +9,140 @@
 
 namespace DataStaging {
   
+  DTRList::DTRList(): NextSeq(0) {}
+
+  DTRList::~DTRList() {
+    // Detach remaining DTRs so they do not notify a destroyed list
+    Lock.lock();
+    for (std::map<DTR*, DTRIndexEntry>::iterator it = DTRs.begin(); it != DTRs.end(); ++it) {
+      it->first->lock.lock();
+      it->first->registry = NULL;
+      it->first->lock.unlock();
+    }
+    Lock.unlock();
+  }
+
+  void DTRList::unindex(DTRIndexEntry& entry) {
+    StatusIndex[entry.status].erase(entry.seq);
+    OwnerIndex[entry.owner].erase(entry.seq);
+    if (entry.pending) {
+      PendingQueue.erase(std::make_pair(entry.process_time, entry.seq));
+      entry.pending = false;
+    }
+  }
+
+  void DTRList::index(DTRIndexEntry& entry) {
+    // Take a consistent snapshot of the indexed properties
+    DTR* dtr = entry.dtr.Ptr();
+    dtr->lock.lock();
+    entry.status = dtr->status.GetStatus();
+    entry.owner = dtr->current_owner;
+    entry.process_time = dtr->next_process_time;
+    entry.pending = dtr->came_from_pre_processor() || dtr->came_from_post_processor() ||
+                    dtr->came_from_delivery() || dtr->came_from_generator();
+    dtr->lock.unlock();
+
+    StatusIndex[entry.status][entry.seq] = &entry;
+    OwnerIndex[entry.owner][entry.seq] = &entry;
+    if (entry.pending) PendingQueue.insert(std::make_pair(entry.process_time, entry.seq));
+  }
+
+  void DTRList::collect_statuses(const std::vector<DTRStatus::DTRStatusType>& Statuses,
+                                 std::list<DTR_ptr>& FilteredList) {
+    // Merge buckets so that result keeps the order in which DTRs were added
+    DTRIndexBucket merged;
+    for (std::vector<DTRStatus::DTRStatusType>::const_iterator i = Statuses.begin(); i != Statuses.end(); ++i) {
+      std::map<DTRStatus::DTRStatusType, DTRIndexBucket>::iterator bucket = StatusIndex.find(*i);
+      if (bucket == StatusIndex.end()) continue;
+      merged.insert(bucket->second.begin(), bucket->second.end());
+    }
+    for (DTRIndexBucket::iterator it = merged.begin(); it != merged.end(); ++it)
+      FilteredList.push_back(it->second->dtr);
+  }
+
   bool DTRList::add_dtr(DTR_ptr DTRToAdd) {
-  	Lock.lock();
-  	DTRs.push_back(DTRToAdd);
-  	Lock.unlock();
-  	
-  	// Added successfully
-  	return true;
+    DTR* dtr = DTRToAdd.Ptr();
+    Lock.lock();
+    std::map<DTR*, DTRIndexEntry>::iterator it = DTRs.find(dtr);
+    if (it != DTRs.end()) {
+      // Already in the list, just refresh the indexes
+      unindex(it->second);
+      index(it->second);
+      Lock.unlock();
+      return true;
+    }
+    DTRIndexEntry& entry = DTRs[dtr];
+    entry.dtr = DTRToAdd;
+    entry.seq = NextSeq++;
+    entry.pending = false;
+    dtr->lock.lock();
+    dtr->registry = this;
+    dtr->lock.unlock();
+    AllDTRs[entry.seq] = &entry;
+    JobIndex[dtr->get_parent_job_id()][entry.seq] = &entry;
+    index(entry);
+    Lock.unlock();
+
+    // Added successfully
+    return true;
   }
   
   bool DTRList::delete_dtr(DTR_ptr DTRToDelete) {
-  	
-  	Lock.lock();
-  	DTRs.remove(DTRToDelete);
-  	Lock.unlock();
-  	
-  	// Deleted successfully
-  	return true;
+    DTR* dtr = DTRToDelete.Ptr();
+    Lock.lock();
+    std::map<DTR*, DTRIndexEntry>::iterator it = DTRs.find(dtr);
+    if (it != DTRs.end()) {
+      dtr->lock.lock();
+      dtr->registry = NULL;
+      dtr->lock.unlock();
+      DTRIndexEntry& entry = it->second;
+      unindex(entry);
+      AllDTRs.erase(entry.seq);
+      std::map<std::string, DTRIndexBucket>::iterator job = JobIndex.find(dtr->get_parent_job_id());
+      if (job != JobIndex.end()) {
+        job->second.erase(entry.seq);
+        if (job->second.empty()) JobIndex.erase(job);
+      }
+      DTRs.erase(it);
+    }
+    Lock.unlock();
+
+    // Deleted successfully
+    return true;
+  }
+
+  void DTRList::update_dtr(DTR* DTRToUpdate) {
+    Lock.lock();
+    std::map<DTR*, DTRIndexEntry>::iterator it = DTRs.find(DTRToUpdate);
+    if (it != DTRs.end()) {
+      unindex(it->second);
+      index(it->second);
+    }
+    Lock.unlock();
   }
   
   bool DTRList::filter_dtrs_by_owner(StagingProcesses OwnerToFilter, std::list<DTR_ptr>& FilteredList){
-  	std::list<DTR_ptr>::iterator it;
-     
     Lock.lock();
-  	for(it = DTRs.begin();it != DTRs.end(); ++it)
-  	  if((*it)->get_owner() == OwnerToFilter)
-  	    FilteredList.push_back(*it);
+    std::map<StagingProcesses, DTRIndexBucket>::iterator bucket = OwnerIndex.find(OwnerToFilter);
+    if (bucket != OwnerIndex.end()) {
+      for (DTRIndexBucket::iterator it = bucket->second.begin(); it != bucket->second.end(); ++it)
+        FilteredList.push_back(it->second->dtr);
+    }
     Lock.unlock();
 
-  	// Filtered successfully
-  	return true;
+    // Filtered successfully
+    return true;
   }
   
   int DTRList::number_of_dtrs_by_owner(StagingProcesses OwnerToFilter){
-  	std::list<DTR_ptr>::iterator it;
     int counter = 0;
-    
+
     Lock.lock();
-  	for(it = DTRs.begin();it != DTRs.end(); ++it)
-  	  if((*it)->get_owner() == OwnerToFilter)
-  	    counter++;
+    std::map<StagingProcesses, DTRIndexBucket>::iterator bucket = OwnerIndex.find(OwnerToFilter);
+    if (bucket != OwnerIndex.end()) counter = bucket->second.size();
     Lock.unlock();
 
-  	// Filtered successfully
-  	return counter;
+    return counter;
   }
   
   bool DTRList::filter_dtrs_by_status(DTRStatus::DTRStatusType StatusToFilter, std::list<DTR_ptr>& FilteredList){
@@ -62,17 +152,8 @@ namespace DataStaging {
 
   bool DTRList::filter_dtrs_by_statuses(const std::vector<DTRStatus::DTRStatusType>& StatusesToFilter,
                                         std::list<DTR_ptr>& FilteredList){
-    std::list<DTR_ptr>::iterator it;
-
     Lock.lock();
-    for(it = DTRs.begin();it != DTRs.end(); ++it) {
-      for (std::vector<DTRStatus::DTRStatusType>::const_iterator i = StatusesToFilter.begin(); i != StatusesToFilter.end(); ++i) {
-        if((*it)->get_status().GetStatus() == *i) {
-          FilteredList.push_back(*it);
-          break;
-        }
-      }
-    }
+    collect_statuses(StatusesToFilter, FilteredList);
     Lock.unlock();
 
     // Filtered successfully
@@ -81,16 +162,13 @@ namespace DataStaging {
 
   bool DTRList::filter_dtrs_by_statuses(const std::vector<DTRStatus::DTRStatusType>& StatusesToFilter,
                                         std::map<DTRStatus::DTRStatusType, std::list<DTR_ptr> >& FilteredList) {
-    std::list<DTR_ptr>::iterator it;
-
     Lock.lock();
-    for(it = DTRs.begin();it != DTRs.end(); ++it) {
-      for (std::vector<DTRStatus::DTRStatusType>::const_iterator i = StatusesToFilter.begin(); i != StatusesToFilter.end(); ++i) {
-        if((*it)->get_status().GetStatus() == *i) {
-          FilteredList[*i].push_back(*it);
-          break;
-        }
-      }
+    for (std::vector<DTRStatus::DTRStatusType>::const_iterator i = StatusesToFilter.begin(); i != StatusesToFilter.end(); ++i) {
+      std::map<DTRStatus::DTRStatusType, DTRIndexBucket>::iterator bucket = StatusIndex.find(*i);
+      if (bucket == StatusIndex.end()) continue;
+      std::list<DTR_ptr>& filtered = FilteredList[*i];
+      for (DTRIndexBucket::iterator it = bucket->second.begin(); it != bucket->second.end(); ++it)
+        filtered.push_back(it->second->dtr);
     }
     Lock.unlock();
 
@@ -99,62 +177,50 @@ namespace DataStaging {
   }
 
   bool DTRList::filter_dtrs_by_next_receiver(StagingProcesses NextReceiver, std::list<DTR_ptr>& FilteredList) {
-  	std::list<DTR_ptr>::iterator it;
-  	
-  	switch(NextReceiver){
-  	  case PRE_PROCESSOR: {
-        Lock.lock();
-        for(it = DTRs.begin();it != DTRs.end(); ++it)
-  	      if((*it)->is_destined_for_pre_processor())
-  	        FilteredList.push_back(*it);
-  	    Lock.unlock();
-  	    return true;  	  	
-  	  }
-  	  case POST_PROCESSOR: {
-  	  	Lock.lock();
-  	  	for(it = DTRs.begin();it != DTRs.end(); ++it)
-  	      if((*it)->is_destined_for_post_processor())
-  	        FilteredList.push_back(*it);
-  	    Lock.unlock();
-  	    return true;
-  	  }
-  	  case DELIVERY: {
-  	  	Lock.lock();
-  	  	for(it = DTRs.begin();it != DTRs.end(); ++it)
-  	      if((*it)->is_destined_for_delivery())
-  	        FilteredList.push_back(*it);
-  	    Lock.unlock();
-  	    return true;
-  	  }
-  	  default: // A strange receiver requested
-  	    return false;
-  	}
+    const std::vector<DTRStatus::DTRStatusType>* statuses = NULL;
+
+    switch(NextReceiver){
+      case PRE_PROCESSOR:
+        statuses = &DTRStatus::PreProcessorStates;
+        break;
+      case POST_PROCESSOR:
+        statuses = &DTRStatus::PostProcessorStates;
+        break;
+      case DELIVERY:
+        statuses = &DTRStatus::DeliveryStates;
+        break;
+      default: // A strange receiver requested
+        return false;
+    }
+
+    Lock.lock();
+    collect_statuses(*statuses, FilteredList);
+    Lock.unlock();
+    return true;
   }
   
   bool DTRList::filter_pending_dtrs(std::list<DTR_ptr>& FilteredList){
-  	std::list<DTR_ptr>::iterator it;
-  	Arc::Time now;
-  	
-  	Lock.lock(); 	
-  	for(it = DTRs.begin();it != DTRs.end(); ++it){
-  	  if( ((*it)->came_from_pre_processor() || (*it)->came_from_post_processor() ||
-  	       (*it)->came_from_delivery() || (*it)->came_from_generator()) &&
-  	      ((*it)->get_process_time() <= now) )
-  	    FilteredList.push_back(*it);
-  	}  	    
-  	Lock.unlock();
-  	
-  	// Filtered successfully
-  	return true;
+    Arc::Time now;
+
+    Lock.lock();
+    // Queue is ordered by processing time so stop at the first one in the future
+    for (std::set<std::pair<Arc::Time, unsigned long long int> >::iterator it = PendingQueue.begin();
+         it != PendingQueue.end() && it->first <= now; ++it) {
+      FilteredList.push_back(AllDTRs[it->second]->dtr);
+    }
+    Lock.unlock();
+
+    // Filtered successfully
+    return true;
   }
   
   bool DTRList::filter_dtrs_by_job(const std::string& jobid, std::list<DTR_ptr>& FilteredList) {
-    std::list<DTR_ptr>::iterator it;
-
     Lock.lock();
-    for(it = DTRs.begin();it != DTRs.end(); ++it)
-      if((*it)->get_parent_job_id() == jobid)
-        FilteredList.push_back(*it);
+    std::map<std::string, DTRIndexBucket>::iterator bucket = JobIndex.find(jobid);
+    if (bucket != JobIndex.end()) {
+      for (DTRIndexBucket::iterator it = bucket->second.begin(); it != bucket->second.end(); ++it)
+        FilteredList.push_back(it->second->dtr);
+    }
     Lock.unlock();
 
     // Filtered successfully
@@ -179,12 +245,11 @@ namespace DataStaging {
       }
     }
 
-    std::list<DTR_ptr>::iterator it;
-
     Lock.lock();
-    for(it = DTRs.begin();it != DTRs.end(); ++it) {
-      if(new_prio.find((*it)->get_id()) != new_prio.end()) {
-        (*it)->set_priority(new_prio[(*it)->get_id()]);
+    for (DTRIndexBucket::iterator it = AllDTRs.begin(); it != AllDTRs.end(); ++it) {
+      const DTR_ptr& dtr = it->second->dtr;
+      if(new_prio.find(dtr->get_id()) != new_prio.end()) {
+        dtr->set_priority(new_prio[dtr->get_id()]);
       }
     }
     Lock.unlock();
@@ -210,12 +275,13 @@ namespace DataStaging {
     // If already caching, find the DTR and increase its priority if necessary
     if (caching && i->second < DTRToCheck->get_priority()) {
       Lock.lock();
-      for(std::list<DTR_ptr>::iterator it = DTRs.begin();it != DTRs.end(); ++it) {
-        if ((*it)->get_source_str() == DTRToCheck->get_source_str() &&
-            ((*it)->get_status() != DTRStatus::CACHE_WAIT && (*it)->get_status() != DTRStatus::CHECK_CACHE)) {
-          (*it)->get_logger()->msg(Arc::INFO, "Boosting priority from %i to %i due to incoming higher priority DTR",
-                                   (*it)->get_priority(), DTRToCheck->get_priority());
-          (*it)->set_priority(DTRToCheck->get_priority());
+      for (DTRIndexBucket::iterator dit = AllDTRs.begin(); dit != AllDTRs.end(); ++dit) {
+        const DTR_ptr& it = dit->second->dtr;
+        if (it->get_source_str() == DTRToCheck->get_source_str() &&
+            (it->get_status() != DTRStatus::CACHE_WAIT && it->get_status() != DTRStatus::CHECK_CACHE)) {
+          it->get_logger()->msg(Arc::INFO, "Boosting priority from %i to %i due to incoming higher priority DTR",
+                                it->get_priority(), DTRToCheck->get_priority());
+          it->set_priority(DTRToCheck->get_priority());
           CachingSources[DTRToCheck->get_source_str()] = DTRToCheck->get_priority();
         }
       }
@@ -241,18 +307,10 @@ namespace DataStaging {
 
   std::list<std::string> DTRList::all_jobs() {
     std::list<std::string> alljobs;
-    std::list<DTR_ptr>::iterator it;
 
     Lock.lock();
-    for(it = DTRs.begin();it != DTRs.end(); ++it) {
-      std::list<std::string>::iterator i = alljobs.begin();
-      for (; i != alljobs.end(); ++i) {
-        if (*i == (*it)->get_parent_job_id())
-          break;
-      }
-      if (i == alljobs.end())
-        alljobs.push_back((*it)->get_parent_job_id());
-    }
+    for (std::map<std::string, DTRIndexBucket>::iterator it = JobIndex.begin(); it != JobIndex.end(); ++it)
+      alljobs.push_back(it->first);
     Lock.unlock();
 
     return alljobs;
@@ -262,15 +320,16 @@ namespace DataStaging {
     // only files supported for now - simply overwrite path
     std::string data;
     Lock.lock();
-    for(std::list<DTR_ptr>::iterator it = DTRs.begin();it != DTRs.end(); ++it) {
-      data += (*it)->get_id() + " " +
-              (*it)->get_status().str() + " " +
-              Arc::tostring((*it)->get_priority()) + " " +
-              (*it)->get_transfer_share();
+    for (DTRIndexBucket::iterator dit = AllDTRs.begin(); dit != AllDTRs.end(); ++dit) {
+      const DTR_ptr& it = dit->second->dtr;
+      data += it->get_id() + " " +
+              it->get_status().str() + " " +
+              Arc::tostring(it->get_priority()) + " " +
+              it->get_transfer_share();
       // add destination for recovery after crash
-      if ((*it)->get_status() == DTRStatus::TRANSFERRING || (*it)->get_status() == DTRStatus::TRANSFER) {
-        data += " " + (*it)->get_destination()->CurrentLocation().fullstr();
-        data += " " + (*it)->get_delivery_endpoint().Host();
+      if (it->get_status() == DTRStatus::TRANSFERRING || it->get_status() == DTRStatus::TRANSFER) {
+        data += " " + it->get_destination()->CurrentLocation().fullstr();
+        data += " " + it->get_delivery_endpoint().Host();
       }
       data += "\n";
     }
@@ -1,6 +1,9 @@
 #ifndef DTRLIST_H_
 #define DTRLIST_H_
 
+#include <set>
+
+#include <arc/DateTime.h>
 #include <arc/Thread.h>
 
 #include "DTR.h"
@@ -10,7 +13,10 @@ namespace DataStaging {
   /// Global list of all active DTRs in the system.
   /**
    * This class contains several methods for filtering the list by owner, state
-   * etc.
+   * etc. Secondary indexes by status, owner, job and next processing time are
+   * kept so that each filter call costs O(result) rather than O(all DTRs).
+   * DTRs in the list notify it through DTR::notify_registry() whenever their
+   * status, owner or processing time changes so the indexes stay in sync.
    * \ingroup datastaging
    * \headerfile DTRList.h arc/data-staging/DTRList.h
    */
@@ -18,9 +24,46 @@ namespace DataStaging {
 
     private:
 
-      /// Internal list of DTRs
-      std::list<DTR_ptr> DTRs;
-  
+      /// Indexed state of one DTR in the list
+      struct DTRIndexEntry {
+        /// The DTR itself
+        DTR_ptr dtr;
+        /// Insertion sequence number, used to keep insertion order in indexes
+        unsigned long long int seq;
+        /// Status under which the DTR is currently indexed
+        DTRStatus::DTRStatusType status;
+        /// Owner under which the DTR is currently indexed
+        StagingProcesses owner;
+        /// Processing time under which the DTR is in the pending queue
+        Arc::Time process_time;
+        /// Whether the DTR is in the pending queue
+        bool pending;
+      };
+
+      /// Set of DTRs ordered by insertion sequence number
+      typedef std::map<unsigned long long int, DTRIndexEntry*> DTRIndexBucket;
+
+      /// Internal list of DTRs, keyed by DTR object
+      std::map<DTR*, DTRIndexEntry> DTRs;
+
+      /// All DTRs in order of insertion
+      DTRIndexBucket AllDTRs;
+
+      /// DTRs bucketed by status
+      std::map<DTRStatus::DTRStatusType, DTRIndexBucket> StatusIndex;
+
+      /// DTRs bucketed by owner
+      std::map<StagingProcesses, DTRIndexBucket> OwnerIndex;
+
+      /// DTRs bucketed by parent job ID
+      std::map<std::string, DTRIndexBucket> JobIndex;
+
+      /// DTRs waiting for a reaction from the scheduler, ordered by processing time
+      std::set<std::pair<Arc::Time, unsigned long long int> > PendingQueue;
+
+      /// Counter for assigning insertion sequence numbers
+      unsigned long long int NextSeq;
+
       /// Lock to protect list during modification
       Arc::SimpleCondition Lock;
 
@@ -34,14 +77,35 @@ namespace DataStaging {
       /// Lock to protect caching sources set during modification
       Arc::SimpleCondition CachingLock;
 
+      /// Remove entry from status, owner and pending indexes. Lock must be held.
+      void unindex(DTRIndexEntry& entry);
+
+      /// Put entry into status, owner and pending indexes. Lock must be held.
+      void index(DTRIndexEntry& entry);
+
+      /// Merge the given status buckets into FilteredList in insertion order. Lock must be held.
+      void collect_statuses(const std::vector<DTRStatus::DTRStatusType>& Statuses,
+                            std::list<DTR_ptr>& FilteredList);
+
     public:
 
+      DTRList();
+
+      ~DTRList();
+
       /// Put a new DTR into the list.
       bool add_dtr(DTR_ptr DTRToAdd);
 
       /// Remove a DTR from the list.
       bool delete_dtr(DTR_ptr DTRToDelete);
 
+      /// Re-index a DTR after a change in its status, owner or processing time.
+      /**
+       * Called by DTR itself, so it should not normally be necessary to call
+       * it directly. DTRs which are not in the list are ignored.
+       */
+      void update_dtr(DTR* DTRToUpdate);
+
       /// Filter the queue to select DTRs owned by a specified process.
       /**
        * @param OwnerToFilter The owner to filter on
@@ -41,6 +41,25 @@ namespace DataStaging {
       DTRStatus::TRANSFERRING_CANCEL,
   };
 
+  // to do states by process which handles them
+  static const DTRStatus::DTRStatusType pre_processor_states[] = {
+      DTRStatus::PRE_CLEAN,
+      DTRStatus::CHECK_CACHE,
+      DTRStatus::RESOLVE,
+      DTRStatus::QUERY_REPLICA,
+      DTRStatus::STAGE_PREPARE
+  };
+
+  static const DTRStatus::DTRStatusType post_processor_states[] = {
+      DTRStatus::RELEASE_REQUEST,
+      DTRStatus::REGISTER_REPLICA,
+      DTRStatus::PROCESS_CACHE
+  };
+
+  static const DTRStatus::DTRStatusType delivery_states[] = {
+      DTRStatus::TRANSFER
+  };
+
 
   const std::vector<DTRStatus::DTRStatusType> DTRStatus::ToProcessStates(to_process_states,
       to_process_states + sizeof to_process_states / sizeof to_process_states[0]);
@@ -51,6 +70,15 @@ namespace DataStaging {
   const std::vector<DTRStatus::DTRStatusType> DTRStatus::StagedStates(staged_states,
       staged_states + sizeof staged_states / sizeof staged_states[0]);
 
+  const std::vector<DTRStatus::DTRStatusType> DTRStatus::PreProcessorStates(pre_processor_states,
+      pre_processor_states + sizeof pre_processor_states / sizeof pre_processor_states[0]);
+
+  const std::vector<DTRStatus::DTRStatusType> DTRStatus::PostProcessorStates(post_processor_states,
+      post_processor_states + sizeof post_processor_states / sizeof post_processor_states[0]);
+
+  const std::vector<DTRStatus::DTRStatusType> DTRStatus::DeliveryStates(delivery_states,
+      delivery_states + sizeof delivery_states / sizeof delivery_states[0]);
+
   static const std::string status_string[DTRStatus::NULL_STATE + 1] = {
     "NEW",
     "CHECK_CACHE",
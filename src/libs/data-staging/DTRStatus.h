@@ -191,6 +191,14 @@ namespace DataStaging {
     /// Vector of states where a DTR is staged - used to limit the number of staged files
     static const std::vector<DTRStatus::DTRStatusType> StagedStates;
 
+    // Together the following three vectors make up ToProcessStates
+    /// Vector of states in which a DTR is to be sent to pre-processor
+    static const std::vector<DTRStatus::DTRStatusType> PreProcessorStates;
+    /// Vector of states in which a DTR is to be sent to post-processor
+    static const std::vector<DTRStatus::DTRStatusType> PostProcessorStates;
+    /// Vector of states in which a DTR is to be sent to delivery
+    static const std::vector<DTRStatus::DTRStatusType> DeliveryStates;
+
   private:
   
     /// status code
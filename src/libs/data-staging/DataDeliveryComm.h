@@ -54,7 +54,7 @@ namespace DataStaging {
       unsigned long long int offset;     ///< Last position to which file has no missing pieces
       unsigned long long int size;       ///< File size as obtained by protocol
       unsigned int speed;                ///< Current transfer speed in bytes/sec during last ~minute
-      char checksum[128];                ///< Calculated checksum
+      char checksum[256];                ///< Calculated checksum
       unsigned long long int transfer_time; ///< Time in ns to complete transfer (0 if not completed)
     };
     #pragma pack()
@@ -35,8 +35,147 @@ namespace DataStaging {
     return proxy_new_path;
   }
 
+  // Transfers performed by one process before it is replaced
+  static const unsigned int worker_max_transfers = 100;
+  // Time in seconds for which idle process is kept for reuse
+  static const int worker_idle_time = 300;
+  // Maximal number of idle processes kept
+  static const unsigned int worker_max_idle = 50;
+
+  // DataStagingDelivery process performing transfers one after another.
+  // Plugins and connections loaded by process are reused, so process is
+  // only given transfers with same user and credentials it was started for.
+  class DataDeliveryWorker {
+   public:
+    DataDeliveryWorker(const std::string& key, int uid, int gid);
+    ~DataDeliveryWorker();
+    /// Returns true if process is running
+    bool Running();
+    /// Pass transfer request to process
+    bool Request(const std::string& request);
+    /// Process
+    Arc::Run* run;
+    /// User and credentials used by process
+    std::string key;
+    /// Number of transfers requested from process
+    unsigned int transfers;
+    /// Time process finished last transfer
+    Arc::Time last_used;
+  };
+
+  DataDeliveryWorker::DataDeliveryWorker(const std::string& key, int uid, int gid)
+    : run(NULL), key(key), transfers(0) {
+    std::list<std::string> args;
+    args.push_back(Arc::ArcLocation::GetLibDir()+G_DIR_SEPARATOR_S+"DataStagingDelivery");
+    args.push_back("--worker");
+    args.push_back("--maxtransfers");
+    args.push_back(Arc::tostring(worker_max_transfers));
+    // process exits by itself if forgotten
+    args.push_back("--idletime");
+    args.push_back(Arc::tostring(worker_idle_time*2));
+    run = new Arc::Run(args);
+    // Set up pipes
+    run->KeepStdout(false);
+    run->KeepStderr(false);
+    run->KeepStdin(false);
+    run->AssignUserId(uid);
+    run->AssignGroupId(gid);
+    if(!run->Start()) {
+      delete run;
+      run = NULL;
+    }
+  }
+
+  DataDeliveryWorker::~DataDeliveryWorker() {
+    if(run) {
+      run->Kill(10); // Give it a chance
+      delete run;    // And then kill for sure
+    }
+  }
+
+  bool DataDeliveryWorker::Running() {
+    return (run && run->Running());
+  }
+
+  bool DataDeliveryWorker::Request(const std::string& request) {
+    if(!Running()) return false;
+    std::string::size_type pos = 0;
+    while(pos < request.length()) {
+      int l = run->WriteStdin(10000, request.c_str()+pos, request.length()-pos);
+      if(l <= 0) return false;
+      pos += l;
+    }
+    ++transfers;
+    return true;
+  }
+
+  static Glib::Mutex workers_lock;
+  static std::list<DataDeliveryWorker*> idle_workers;
+
+  // Take idle process with given key from pool
+  static DataDeliveryWorker* get_worker(const std::string& key) {
+    DataDeliveryWorker* worker = NULL;
+    std::list<DataDeliveryWorker*> expired;
+    {
+      Glib::Mutex::Lock lock(workers_lock);
+      Arc::Time limit(Arc::Time()-Arc::Period(worker_idle_time));
+      for(std::list<DataDeliveryWorker*>::iterator w = idle_workers.begin(); w != idle_workers.end();) {
+        if(((*w)->last_used < limit) || !(*w)->Running()) {
+          expired.push_back(*w);
+          w = idle_workers.erase(w);
+        } else if(!worker && ((*w)->key == key)) {
+          worker = *w;
+          w = idle_workers.erase(w);
+        } else {
+          ++w;
+        }
+      }
+    }
+    // Killing takes time so do it without lock
+    for(std::list<DataDeliveryWorker*>::iterator w = expired.begin(); w != expired.end(); ++w) delete *w;
+    return worker;
+  }
+
+  // Return process which finished transfer to pool
+  static void put_worker(DataDeliveryWorker* worker) {
+    if((worker->transfers >= worker_max_transfers) || !worker->Running()) {
+      delete worker;
+      return;
+    }
+    worker->last_used = Arc::Time();
+    DataDeliveryWorker* extra = NULL;
+    {
+      Glib::Mutex::Lock lock(workers_lock);
+      idle_workers.push_front(worker);
+      if(idle_workers.size() > worker_max_idle) {
+        extra = idle_workers.back();
+        idle_workers.pop_back();
+      }
+    }
+    delete extra;
+  }
+
+  // Pass log messages written by process to logger
+  static void read_log(Arc::Run& run, Arc::Logger& logger) {
+    // TODO: direct redirect
+    for(;;) {
+      char buf[1024+1];
+      int l = run.ReadStderr(0,buf,sizeof(buf)-1);
+      if(l <= 0) break;
+      buf[l] = 0;
+      char* start = buf;
+      for(;*start;) {
+        char* end = strchr(start,'\n');
+        if(end) *end = 0;
+        logger.msg(Arc::INFO, "DataDelivery: %s", start);
+        if(!end) break;
+        start = end + 1;
+      }
+    }
+  }
+
   DataDeliveryLocalComm::DataDeliveryLocalComm(DTR_ptr dtr, const TransferParameters& params)
-    : DataDeliveryComm(dtr, params),child_(NULL),last_comm(Arc::Time()) {
+    : DataDeliveryComm(dtr, params),child_(NULL),finished_(false),last_comm(Arc::Time()) {
     if(!dtr->get_source()) return;
     if(!dtr->get_destination()) return;
     {
@@ -47,8 +186,6 @@ namespace DataStaging {
       status_pos_ = 0;
       // Generate options for child
       std::list<std::string> args;
-      std::string execpath = Arc::ArcLocation::GetLibDir()+G_DIR_SEPARATOR_S+"DataStagingDelivery";
-      args.push_back(execpath);
 
       // check for alternative source or destination eg cache, mapped URL, TURL
       std::string surl;
@@ -84,13 +221,14 @@ namespace DataStaging {
       args.push_back("--durl");
       args.push_back(durl);
       // Check if credentials are needed for source/dest
+      std::string credential;
       Arc::DataHandle surl_h(surl, dtr->get_usercfg());
       Arc::DataHandle durl_h(durl, dtr->get_usercfg());
       if (!dtr->get_usercfg().CredentialString().empty() &&
           surl_h && !surl_h->RequiresCredentialsInFile() &&
           durl_h && !durl_h->RequiresCredentialsInFile()) {
         // If file-based credentials are not required then send through stdin
-        stdin_ = dtr->get_usercfg().CredentialString();
+        credential = dtr->get_usercfg().CredentialString();
       } else {
         // If child is going to be run under different user ID
         // we must ensure it will be able to read credentials.
@@ -121,6 +259,10 @@ namespace DataStaging {
       args.push_back("minavgspeed="+Arc::tostring(transfer_params.min_average_bandwidth));
       args.push_back("--topt");
       args.push_back("maxinacttime="+Arc::tostring(transfer_params.max_inactivity_time));
+      if (transfer_params.vectored_io) {
+        args.push_back("--topt");
+        args.push_back("vectoredio=1");
+      }
 
       if (dtr->get_source()->CheckSize()) {
         args.push_back("--size");
@@ -151,36 +293,55 @@ namespace DataStaging {
         args.push_back("--cstype");
         args.push_back(dtr->get_destination()->DefaultCheckSum());
       }
-      child_ = new Arc::Run(args);
-      // Set up pipes
-      child_->KeepStdout(false);
-      child_->KeepStderr(false);
-      child_->KeepStdin(false);
-      child_->AssignUserId(child_uid);
-      child_->AssignGroupId(child_gid);
-      child_->AssignStdin(stdin_);
-      // Start child
+      // Request is passed through stdin as NUL terminated options
+      // followed by empty string and credentials
+      std::string request;
       std::string cmd;
       for(std::list<std::string>::iterator arg = args.begin();arg!=args.end();++arg) {
+        request += *arg;
+        request += '\0';
         cmd += *arg;
         cmd += " ";
       }
-      logger_->msg(Arc::DEBUG, "Running command: %s", cmd);
-      if(!child_->Start()) {
+      request += '\0';
+      request += credential;
+      request += '\0';
+      logger_->msg(Arc::DEBUG, "Requesting transfer from DataStagingDelivery: %s", cmd);
+      // Reuse process started for same user and credentials if possible
+      std::string key(Arc::tostring(child_uid)+":"+Arc::tostring(child_gid)+"\n"+
+                      dtr->get_usercfg().ProxyPath()+"\n"+credential);
+      child_ = get_worker(key);
+      if(child_ && !child_->Request(request)) {
         delete child_;
         child_=NULL;
-        return;
+      }
+      if(!child_) {
+        child_ = new DataDeliveryWorker(key, child_uid, child_gid);
+        if(!child_->Request(request)) {
+          delete child_;
+          child_=NULL;
+          return;
+        }
       }
     }
     handler_->Add(this);
   }
 
   DataDeliveryLocalComm::~DataDeliveryLocalComm(void) {
+    DataDeliveryWorker* child = NULL;
+    bool finished = false;
     {
       Glib::Mutex::Lock lock(lock_);
-      if(child_) {
-        child_->Kill(10); // Give it a chance
-        delete child_; child_=NULL;  // And then kill for sure
+      child = child_; child_=NULL;
+      finished = finished_;
+    }
+    if(child) {
+      if(finished) {
+        // Process is ready for next transfer
+        put_worker(child);
+      } else {
+        // Transfer is not finished - process is killed
+        delete child;
       }
     }
     if(!tmp_proxy_.empty()) Arc::FileDelete(tmp_proxy_);
@@ -189,36 +350,22 @@ namespace DataStaging {
 
   void DataDeliveryLocalComm::PullStatus(void) {
     Glib::Mutex::Lock lock(lock_);
-    if(!child_) return;
+    if(!child_ || finished_) return;
     for(;;) {
       if(status_pos_ < sizeof(status_buf_)) {
-        int l;
-        // TODO: direct redirect
-        for(;;) {
-          char buf[1024+1];
-          l = child_->ReadStderr(0,buf,sizeof(buf)-1);
-          if(l <= 0) break;
-          buf[l] = 0;
-          char* start = buf;
-          for(;*start;) {
-            char* end = strchr(start,'\n');
-            if(end) *end = 0;
-            logger_->msg(Arc::INFO, "DataDelivery: %s", start);
-            if(!end) break;
-            start = end + 1;
-          }
-        }
-        l = child_->ReadStdout(0,((char*)&status_buf_)+status_pos_,sizeof(status_buf_)-status_pos_);
+        read_log(*(child_->run), *logger_);
+        int l = child_->run->ReadStdout(0,((char*)&status_buf_)+status_pos_,sizeof(status_buf_)-status_pos_);
         if(l == -1) { // child error or closed comm
-          if(child_->Running()) {
+          if(child_->run->Running()) {
             status_.commstatus = CommClosed;
           } else {
             status_.commstatus = CommExited;
-            if(child_->Result() != 0) {
-              logger_->msg(Arc::ERROR, "DataStagingDelivery exited with code %i", child_->Result());
+            if(child_->run->Result() != 0) {
+              logger_->msg(Arc::ERROR, "DataStagingDelivery exited with code %i", child_->run->Result());
               status_.commstatus = CommFailed;
             }
           }
+          finished_ = true;
           delete child_; child_=NULL; return;
         }
         if(l == 0) break;
@@ -229,13 +376,24 @@ namespace DataStaging {
         status_buf_.error_desc[sizeof(status_buf_.error_desc)-1] = 0;
         status_=status_buf_;
         status_pos_-=sizeof(status_buf_);
+        if((status_.commstatus == CommExited) || (status_.commstatus == CommFailed)) {
+          // Transfer finished and process is ready for next one
+          read_log(*(child_->run), *logger_);
+          if(status_.commstatus == CommFailed) {
+            logger_->msg(Arc::ERROR, "DataStagingDelivery failed to perform transfer");
+          }
+          // Process is kept till this object is destroyed so that
+          // finished transfer is not taken for lost process
+          finished_ = true;
+          return;
+        }
       }
     }
     // check for stuck child process (no report through comm channel)
     Arc::Period t = Arc::Time() - last_comm;
     if (transfer_params.max_inactivity_time > 0 && t >= transfer_params.max_inactivity_time*2) {
       logger_->msg(Arc::ERROR, "Transfer killed after %i seconds without communication", t.GetPeriod());
-      child_->Kill(1);
+      child_->run->Kill(1);
       delete child_;
       child_ = NULL;
     }
@@ -7,8 +7,14 @@
 
 namespace DataStaging {
 
+  class DataDeliveryWorker;
+
   /// This class starts, monitors and controls a local Delivery process.
   /**
+   * Delivery processes are kept running after a transfer and are reused for
+   * further transfers run under the same user with the same credentials.
+   * Every process performs one transfer at a time and is restarted after a
+   * fixed number of transfers. Cancelling a transfer kills its process.
    * \ingroup datastaging
    * \headerfile DataDeliveryLocalComm.h arc/data-staging/DataDeliveryLocalComm.h
    */
@@ -26,16 +32,18 @@ namespace DataStaging {
     /// Returns "/" since local Delivery can access everywhere
     static bool CheckComm(DTR_ptr dtr, std::vector<std::string>& allowed_dirs, std::string& load_avg);
 
-    /// Returns true if child process exists
-    virtual operator bool() const { return (child_ != NULL); };
-    /// Returns true if child process does not exist
-    virtual bool operator!() const { return (child_ == NULL); };
+    /// Returns true if child process exists or transfer has finished
+    virtual operator bool() const { return (child_ != NULL) || finished_; };
+    /// Returns true if child process does not exist and transfer did not finish
+    virtual bool operator!() const { return (child_ == NULL) && !finished_; };
 
   private:
-    /// Child process
-    Arc::Run* child_;
-    /// Stdin of child, used to pass credentials
-    std::string stdin_;
+    /// Child process performing transfer
+    DataDeliveryWorker* child_;
+    /// Final status was received from child or child exited. Process
+    /// which reported end of transfer is kept till this object is
+    /// destroyed and then is returned for reuse.
+    bool finished_;
     /// Temporary credentails location
     std::string tmp_proxy_;
     /// Time last communication was received from child
@@ -9,13 +9,340 @@
 
 namespace DataStaging {
 
+  /// Obtains status of all transfers on one service made with same credentials.
+  /**
+   * A dedicated thread sends one query for all transfers and asks the
+   * service to wait until one of them finishes and to report only changes.
+   * Services not supporting it answer at once and may not report all
+   * transfers in one response, so then every transfer is queried separately.
+   * In both cases queries are not sent more often than once a second.
+   *
+   * Every channel has its own thread and a waiting request on the service.
+   * To bound them, when max_channels_ channels are running transfers
+   * with other credentials get a private channel without thread which is
+   * polled by the comm itself.
+   */
+  class DataDeliveryStatusChannel {
+   public:
+    /// State of transfer as seen by channel
+    enum QueryState {
+      QueryPending, ///< Nothing new since last call to Get()
+      QueryUpdated, ///< New result was obtained
+      QueryFailed   ///< Communication with service failed
+    };
+
+    /// Get channel for given key, starting it if necessary, and add transfer to it
+    static DataDeliveryStatusChannel* Attach(const std::string& key, const Arc::MCCConfig& cfg,
+                                             const Arc::URL& endpoint, int timeout, const std::string& id);
+    /// Remove transfer from channel. Channel stops when it has no transfers.
+    static void Detach(DataDeliveryStatusChannel* channel, const std::string& id);
+
+    /// Get latest Result element for transfer or error description
+    QueryState Get(const std::string& id, std::string& result);
+    /// Query status if channel has no thread of its own
+    void Poll();
+
+   private:
+    class Item {
+     public:
+      Item(void): bytes(0), fresh(false), finished(false), failed(false) {};
+      /// Latest Result element
+      std::string result;
+      /// Bytes transferred according to latest result
+      unsigned long long int bytes;
+      /// Result was not yet passed to comm
+      bool fresh;
+      /// Transfer reached final state and needs no more queries
+      bool finished;
+      /// Communication failed, result contains error description
+      bool failed;
+    };
+
+    DataDeliveryStatusChannel(const std::string& key, const Arc::MCCConfig& cfg,
+                              const Arc::URL& endpoint, int timeout, bool threaded);
+    ~DataDeliveryStatusChannel();
+    DataDeliveryStatusChannel(const DataDeliveryStatusChannel&);
+    DataDeliveryStatusChannel& operator=(const DataDeliveryStatusChannel&);
+
+    static void func(void* arg);
+    /// Query status of transfers. Returns false if connection must be reset.
+    bool Query(Arc::ClientSOAP& client);
+    /// Send one query for given transfers
+    bool QueryItems(Arc::ClientSOAP& client, const std::list<std::string>& ids);
+    /// Count failed query and mark transfers as failed if no retries are left
+    void Retry(const std::string& err);
+    /// Mark all active transfers as failed
+    void Fail(const std::string& err);
+
+    std::string key_;
+    Arc::MCCConfig cfg_;
+    Arc::URL endpoint_;
+    int timeout_;
+    /// Channel is served by own thread, otherwise by Poll()
+    bool threaded_;
+    /// Connection to service, reset after communication failure
+    Arc::ClientSOAP* client_;
+    /// Time of last query sent by Poll()
+    Arc::Time last_query_;
+    /// Time in seconds service is asked to wait for changes
+    int wait_time_;
+    /// False if service is found to not support bulk queries
+    bool bulk_;
+    /// Retries allowed after failing to query transfer status, so that a
+    /// transfer is not lost due to temporary communication problem. If a
+    /// transfer fails to start it is handled by the normal DTR retries.
+    int query_retries_;
+    std::map<std::string, Item> items_;
+    Glib::Mutex lock_;
+
+    static std::map<std::string, DataDeliveryStatusChannel*> channels_;
+    static Glib::Mutex channels_lock_;
+    /// Maximum number of channels with own thread
+    static const unsigned int max_channels_ = 50;
+    static Arc::Logger logger;
+  };
+
+  std::map<std::string, DataDeliveryStatusChannel*> DataDeliveryStatusChannel::channels_;
+  Glib::Mutex DataDeliveryStatusChannel::channels_lock_;
+  Arc::Logger DataDeliveryStatusChannel::logger(Arc::Logger::getRootLogger(), "DataStaging.DataDeliveryStatusChannel");
+
+  DataDeliveryStatusChannel::DataDeliveryStatusChannel(const std::string& key, const Arc::MCCConfig& cfg,
+                                                       const Arc::URL& endpoint, int timeout, bool threaded)
+    : key_(key),
+      cfg_(cfg),
+      endpoint_(endpoint),
+      timeout_(timeout),
+      threaded_(threaded),
+      client_(NULL),
+      last_query_(0),
+      wait_time_(5),
+      bulk_(true),
+      query_retries_(20) {
+    // response must come before connection times out
+    if (wait_time_ > timeout_/2) wait_time_ = timeout_/2;
+    // Poll() is called from comm handler which must not be blocked
+    if (!threaded_) wait_time_ = 0;
+  }
+
+  DataDeliveryStatusChannel::~DataDeliveryStatusChannel() {
+    delete client_;
+  }
+
+  DataDeliveryStatusChannel* DataDeliveryStatusChannel::Attach(const std::string& key, const Arc::MCCConfig& cfg,
+                                                               const Arc::URL& endpoint, int timeout, const std::string& id) {
+    Glib::Mutex::Lock lock(channels_lock_);
+    std::map<std::string, DataDeliveryStatusChannel*>::iterator c = channels_.find(key);
+    if (c != channels_.end()) {
+      Glib::Mutex::Lock channel_lock(c->second->lock_);
+      c->second->items_[id] = Item();
+      return c->second;
+    }
+    if (channels_.size() >= max_channels_) {
+      logger.msg(Arc::VERBOSE, "Too many status channels, state of %s at %s will be queried separately",
+                 id, endpoint.str());
+      DataDeliveryStatusChannel* channel = new DataDeliveryStatusChannel(key, cfg, endpoint, timeout, false);
+      channel->items_[id] = Item();
+      return channel;
+    }
+    DataDeliveryStatusChannel* channel = new DataDeliveryStatusChannel(key, cfg, endpoint, timeout, true);
+    // thread deletes channel when it has no more transfers, so add one first
+    channel->items_[id] = Item();
+    if (!Arc::CreateThreadFunction(&func, channel)) {
+      delete channel;
+      return NULL;
+    }
+    channels_[key] = channel;
+    return channel;
+  }
+
+  void DataDeliveryStatusChannel::Detach(DataDeliveryStatusChannel* channel, const std::string& id) {
+    if (!channel->threaded_) {
+      // private channel of one transfer
+      delete channel;
+      return;
+    }
+    Glib::Mutex::Lock lock(channels_lock_);
+    Glib::Mutex::Lock channel_lock(channel->lock_);
+    channel->items_.erase(id);
+    if (channel->items_.empty()) channels_.erase(channel->key_);
+  }
+
+  DataDeliveryStatusChannel::QueryState DataDeliveryStatusChannel::Get(const std::string& id, std::string& result) {
+    Glib::Mutex::Lock lock(lock_);
+    std::map<std::string, Item>::iterator i = items_.find(id);
+    if (i == items_.end()) return QueryPending;
+    if (i->second.failed) {
+      result = i->second.result;
+      return QueryFailed;
+    }
+    if (!i->second.fresh) return QueryPending;
+    i->second.fresh = false;
+    result = i->second.result;
+    return QueryUpdated;
+  }
+
+  void DataDeliveryStatusChannel::Poll() {
+    if (threaded_) return;
+    Arc::Time now;
+    if (now - last_query_ < Arc::Period(1)) return;
+    last_query_ = now;
+    if (!client_) client_ = new Arc::ClientSOAP(cfg_, endpoint_, timeout_);
+    if (!Query(*client_)) {
+      // A reconnect may be needed after losing connection
+      delete client_;
+      client_ = NULL;
+    }
+  }
+
+  void DataDeliveryStatusChannel::func(void* arg) {
+    DataDeliveryStatusChannel* channel = (DataDeliveryStatusChannel*)arg;
+    for (;;) {
+      {
+        // Detach() removes channel from list together with last transfer
+        Glib::Mutex::Lock lock(channel->lock_);
+        if (channel->items_.empty()) break;
+      }
+      Arc::Time start;
+      if (!channel->client_) channel->client_ = new Arc::ClientSOAP(channel->cfg_, channel->endpoint_, channel->timeout_);
+      if (!channel->Query(*channel->client_)) {
+        // A reconnect may be needed after losing connection
+        delete channel->client_;
+        channel->client_ = NULL;
+      }
+      Arc::Period period(Arc::Time() - start);
+      if (period.GetPeriod() < 1) Glib::usleep(1000000 - period.GetPeriodNanoseconds()/1000);
+    }
+    delete channel;
+  }
+
+  bool DataDeliveryStatusChannel::Query(Arc::ClientSOAP& client) {
+    std::list<std::string> ids;
+    {
+      Glib::Mutex::Lock lock(lock_);
+      for (std::map<std::string, Item>::iterator i = items_.begin(); i != items_.end(); ++i) {
+        if (!i->second.finished && !i->second.failed) ids.push_back(i->first);
+      }
+    }
+    if (ids.empty()) return true;
+    if (bulk_) return QueryItems(client, ids);
+    for (std::list<std::string>::iterator id = ids.begin(); id != ids.end(); ++id) {
+      if (!QueryItems(client, std::list<std::string>(1, *id))) return false;
+    }
+    return true;
+  }
+
+  bool DataDeliveryStatusChannel::QueryItems(Arc::ClientSOAP& client, const std::list<std::string>& ids) {
+    Arc::NS ns;
+    Arc::PayloadSOAP request(ns);
+    Arc::XMLNode query = request.NewChild("DataDeliveryQuery");
+    {
+      Glib::Mutex::Lock lock(lock_);
+      for (std::list<std::string>::const_iterator id = ids.begin(); id != ids.end(); ++id) {
+        std::map<std::string, Item>::iterator i = items_.find(*id);
+        if (i == items_.end()) continue;
+        Arc::XMLNode dtrnode = query.NewChild("DTR");
+        dtrnode.NewChild("ID") = *id;
+        // Service skips transfer if nothing changed since this result
+        if (!i->second.result.empty()) dtrnode.NewChild("BytesTransferred") = Arc::tostring(i->second.bytes);
+      }
+    }
+    if (!query["DTR"]) return true;
+    if (bulk_ && wait_time_ > 0) query.NewChild("WaitTime") = Arc::tostring(wait_time_);
+    query.NewChild("ChangesOnly") = "true";
+
+    std::string xml;
+    request.GetXML(xml, true);
+    logger.msg(Arc::DEBUG, "Request:\n%s", xml);
+
+    Arc::PayloadSOAP *response = NULL;
+
+    Arc::MCC_Status status = client.process(&request, &response);
+
+    if (!status) {
+      if (response)
+        delete response;
+      Retry((std::string)status);
+      return false;
+    }
+
+    if (!response) {
+      Retry("No SOAP response from delivery service");
+      return false;
+    }
+    if (response->IsFault()) {
+      Arc::SOAPFault& fault = *response->Fault();
+      std::string err("SOAP fault: %s", fault.Code());
+      for (int n = 0;;++n) {
+        if (fault.Reason(n).empty()) break;
+        err += ": " + fault.Reason(n);
+      }
+      delete response;
+      Retry("Failed to query state: " + err);
+      return false;
+    }
+
+    response->GetXML(xml, true);
+    logger.msg(Arc::DEBUG, "Response:\n%s", xml);
+
+    Arc::XMLNode results = (*response)["DataDeliveryQueryResponse"]["DataDeliveryQueryResult"];
+    if (!results) {
+      delete response;
+      Fail("Bad format in XML response: " + xml);
+      return false;
+    }
+    // Services not knowing about waiting stop at first transfer which is
+    // still running, so transfers have to be queried one by one
+    if (bulk_ && !(*response)["DataDeliveryQueryResponse"]["WaitTime"]) {
+      logger.msg(Arc::VERBOSE, "Delivery service at %s does not support bulk queries", endpoint_.str());
+      bulk_ = false;
+    }
+
+    Glib::Mutex::Lock lock(lock_);
+    query_retries_ = 20;
+    for (Arc::XMLNode resultnode = results["Result"]; resultnode; ++resultnode) {
+      std::map<std::string, Item>::iterator i = items_.find((std::string)resultnode["ID"]);
+      if (i == items_.end()) continue;
+      resultnode.GetXML(i->second.result);
+      if (resultnode["BytesTransferred"]) Arc::stringto((std::string)resultnode["BytesTransferred"], i->second.bytes);
+      i->second.fresh = true;
+      if ((std::string)resultnode["ResultCode"] != "TRANSFERRING") i->second.finished = true;
+    }
+    delete response;
+    return true;
+  }
+
+  void DataDeliveryStatusChannel::Retry(const std::string& err) {
+    bool retry = false;
+    {
+      Glib::Mutex::Lock lock(lock_);
+      retry = (--query_retries_ > 0);
+    }
+    if (!retry) {
+      Fail(err);
+      return;
+    }
+    // Just return without changing status
+    logger.msg(Arc::WARNING, "Failed to query state of transfers at %s, will retry: %s", endpoint_.str(), err);
+  }
+
+  void DataDeliveryStatusChannel::Fail(const std::string& err) {
+    logger.msg(Arc::ERROR, "Failed to query state of transfers at %s: %s", endpoint_.str(), err);
+    Glib::Mutex::Lock lock(lock_);
+    for (std::map<std::string, Item>::iterator i = items_.begin(); i != items_.end(); ++i) {
+      if (i->second.finished) continue;
+      i->second.failed = true;
+      i->second.result = err;
+    }
+    query_retries_ = 20;
+  }
+
   Arc::Logger DataDeliveryRemoteComm::logger(Arc::Logger::getRootLogger(), "DataStaging.DataDeliveryRemoteComm");
 
   DataDeliveryRemoteComm::DataDeliveryRemoteComm(DTR_ptr dtr, const TransferParameters& params)
     : DataDeliveryComm(dtr, params),
       client(NULL),
       dtr_full_id(dtr->get_id()),
-      query_retries(20),
+      channel(NULL),
       endpoint(dtr->get_delivery_endpoint()),
       timeout(dtr->get_usercfg().Timeout()),
       valid(false) {
@@ -54,13 +381,17 @@ namespace DataStaging {
       caching = true;
     }
 
+    // Transfers using same credentials share status queries
+    std::string channel_key(endpoint.str());
     if (dtr->host_cert_for_remote_delivery()) {
       Arc::initializeCredentialsType cred_type(Arc::initializeCredentialsType::TryCredentials);
       Arc::UserConfig host_cfg(cred_type);
       host_cfg.ProxyPath(""); // to force using cert/key files instead of non-existent proxy
       host_cfg.ApplyToConfig(cfg);
     } else {
-      dtr->get_usercfg().ApplyToConfig(cfg);
+      const Arc::UserConfig& usercfg = dtr->get_usercfg();
+      usercfg.ApplyToConfig(cfg);
+      channel_key += "\n" + usercfg.ProxyPath() + "\n" + usercfg.CertificatePath() + "\n" + usercfg.CredentialString();
     }
 
     // connect to service and make a new transfer request
@@ -148,6 +479,13 @@ namespace DataStaging {
     logger_->msg(Arc::INFO, "Started remote Delivery at %s", endpoint.str());
 
     delete response;
+
+    channel = DataDeliveryStatusChannel::Attach(channel_key, cfg, endpoint, timeout, dtr_full_id);
+    if (!channel) {
+      logger_->msg(Arc::ERROR, "Failed to start querying state of transfer at %s", endpoint.str());
+      CancelDTR();
+      return;
+    }
     valid = true;
     handler_->Add(this);
   }
@@ -157,6 +495,7 @@ namespace DataStaging {
     if (valid) CancelDTR();
     if (handler_) handler_->Remove(this);
     Glib::Mutex::Lock lock(lock_);
+    if (channel) DataDeliveryStatusChannel::Detach(channel, dtr_full_id);
     delete client;
   }
 
@@ -219,85 +558,36 @@ namespace DataStaging {
   }
 
   void DataDeliveryRemoteComm::PullStatus() {
-    // send query request to service and fill status_
+    // take status obtained by channel and fill status_
     Glib::Mutex::Lock lock(lock_);
-    if (!client) return;
-
-    // check time since last query - check every second for the first 20s and
-    // after every 5s
-    // TODO be more intelligent, using transfer rate and file size
-    if (Arc::Time() - start_ < 20 && Arc::Time() - Arc::Time(status_.timestamp) < 1) return;
-    if (Arc::Time() - start_ > 20 && Arc::Time() - Arc::Time(status_.timestamp) < 5) return;
-
-    Arc::NS ns;
-    Arc::PayloadSOAP request(ns);
-    Arc::XMLNode dtrnode = request.NewChild("DataDeliveryQuery").NewChild("DTR");
+    if (!channel || !valid) return;
 
-    dtrnode.NewChild("ID") = dtr_full_id;
+    channel->Poll();
+    std::string result;
+    DataDeliveryStatusChannel::QueryState state = channel->Get(dtr_full_id, result);
 
-    std::string xml;
-    request.GetXML(xml, true);
-    logger_->msg(Arc::DEBUG, "Request:\n%s", xml);
+    if (state == DataDeliveryStatusChannel::QueryPending) return;
 
-    Arc::PayloadSOAP *response = NULL;
-
-    Arc::MCC_Status status = client->process(&request, &response);
-
-    if (!status) {
-      logger_->msg(Arc::ERROR, "%s", (std::string)status);
-      status_.commstatus = CommFailed;
-      if (response)
-        delete response;
-      valid = false;
-      return;
-    }
-
-    if (!response) {
-      if (--query_retries > 0) {
-        HandleQueryFault("No SOAP response from delivery service");
-        return;
-      }
-      logger_->msg(Arc::ERROR, "No SOAP response from delivery service");
+    if (state == DataDeliveryStatusChannel::QueryFailed) {
+      logger_->msg(Arc::ERROR, "Failed to query state: %s", result);
       status_.commstatus = CommFailed;
+      strncpy(status_.error_desc, "Error in connection with delivery service", sizeof(status_.error_desc));
       valid = false;
       return;
     }
 
-    response->GetXML(xml, true);
-    logger_->msg(Arc::DEBUG, "Response:\n%s", xml);
+    logger_->msg(Arc::DEBUG, "Result:\n%s", result);
 
-    if (response->IsFault()) {
-      Arc::SOAPFault& fault = *response->Fault();
-      std::string err("SOAP fault: %s", fault.Code());
-      for (int n = 0;;++n) {
-        if (fault.Reason(n).empty()) break;
-        err += ": " + fault.Reason(n);
-      }
-      delete response;
-      if (--query_retries > 0) {
-        HandleQueryFault("Failed to query state: " + err);
-        return;
-      }
-      logger_->msg(Arc::ERROR, "Failed to query state: %s", err);
-      status_.commstatus = CommFailed;
-      strncpy(status_.error_desc, "SOAP error in connection with delivery service", sizeof(status_.error_desc));
-      valid = false;
-      return;
-    }
-
-    Arc::XMLNode resultnode = (*response)["DataDeliveryQueryResponse"]["DataDeliveryQueryResult"]["Result"][0];
+    Arc::XMLNode resultnode(result);
     if (!resultnode || !resultnode["ResultCode"]) {
-      logger_->msg(Arc::ERROR, "Bad format in XML response: %s", xml);
-      delete response;
+      logger_->msg(Arc::ERROR, "Bad format in XML response: %s", result);
       status_.commstatus = CommFailed;
       valid = false;
       return;
     }
 
     // Fill status fields with results from service
-    FillStatus(resultnode[0]);
-
-    delete response;
+    FillStatus(resultnode);
   }
 
   bool DataDeliveryRemoteComm::CheckComm(DTR_ptr dtr, std::vector<std::string>& allowed_dirs, std::string& load_avg) {
@@ -463,6 +753,7 @@ namespace DataStaging {
     datanode = node["CheckSum"];
     if (datanode) {
       strncpy(status_.checksum, ((std::string)datanode).c_str(), sizeof(status_.checksum));
+      status_.checksum[sizeof(status_.checksum)-1] = '\0';
     }
     // if terminal state, write log
     if (status_.commstatus != CommNoError) {
@@ -513,13 +804,4 @@ namespace DataStaging {
     return true;
   }
 
-  void DataDeliveryRemoteComm::HandleQueryFault(const std::string& err) {
-    // Just return without changing status
-    logger_->msg(Arc::WARNING, err);
-    status_.timestamp = time(NULL);
-    // A reconnect may be needed after losing connection
-    delete client;
-    client = new Arc::ClientSOAP(cfg, endpoint, timeout);
-  }
-
 } // namespace DataStaging
@@ -9,8 +9,15 @@
 
 namespace DataStaging {
 
+  class DataDeliveryStatusChannel;
+
   /// This class contacts a remote service to make a Delivery request.
   /**
+   * Status of all transfers on the same service which use the same
+   * credentials is obtained by a shared channel, which queries all of them
+   * in one request and waits on the service for changes. The number of
+   * shared channels is limited, beyond it each transfer is queried
+   * separately from PullStatus().
    * \ingroup datastaging
    * \headerfile DataDeliveryRemoteComm.h arc/data-staging/DataDeliveryRemoteComm.h
    */
@@ -37,10 +44,8 @@ namespace DataStaging {
     Arc::ClientSOAP* client;
     /// Full DTR ID
     std::string dtr_full_id;
-    /// Retries allowed after failing to query transfer status, so that a
-    /// transfer is not lost due to temporary communication problem. If a
-    /// transfer fails to start it is handled by the normal DTR retries.
-    int query_retries;
+    /// Channel providing status of transfers on service
+    DataDeliveryStatusChannel* channel;
     /// MCC configuration for connecting to service
     Arc::MCCConfig cfg;
     /// Endpoint of remote delivery service
@@ -63,9 +68,6 @@ namespace DataStaging {
     /// Set up delegation so the credentials can be used by the service
     bool SetupDelegation(Arc::XMLNode& op, const Arc::UserConfig& usercfg);
 
-    /// Handle a fault during query of service. Attempts to reconnect
-    void HandleQueryFault(const std::string& err="");
-
   };
 
 } // namespace DataStaging
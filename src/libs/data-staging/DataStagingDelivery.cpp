@@ -3,9 +3,13 @@
 #endif
 
 #include <iostream>
+#include <list>
+#include <map>
+#include <errno.h>
 #include <string.h>
 #include <signal.h>
 #include <unistd.h>
+#include <poll.h>
 
 #include <arc/OptionParser.h>
 #include <arc/StringConv.h>
@@ -13,6 +17,7 @@
 #include <arc/Utils.h>
 #include <arc/data/DataHandle.h>
 #include <arc/data/DataBuffer.h>
+#include <arc/data/DataRingBuffer.h>
 
 #include "DataDeliveryComm.h"
 
@@ -28,6 +33,29 @@ static void sig_shutdown(int)
     delivery_shutdown = true;
 }
 
+// Last reported status. Reset before every transfer.
+static DataStaging::DataDeliveryComm::Status status;
+static unsigned int status_pos = 0;
+static bool status_changed = true;
+
+static void WriteStatus(void) {
+  for(;;) {
+    ssize_t l = ::write(STDOUT_FILENO,((char*)&status)+status_pos,sizeof(status)-status_pos);
+    if(l == -1) { // error, parent exited?
+      break;
+    } else if(l == 0) { // will happen if stdout is non-blocking
+      break;
+    } else {
+      status_pos+=l;
+    };
+    if(status_pos >= sizeof(status)) {
+      status_pos=0;
+      status_changed=false;
+      break;
+    };
+  };
+}
+
 static void ReportStatus(DataStaging::DTRStatus::DTRStatusType st,
                          DataStaging::DTRErrorStatus::DTRErrorStatusType err,
                          DataStaging::DTRErrorStatus::DTRErrorLocation err_loc,
@@ -36,9 +64,6 @@ static void ReportStatus(DataStaging::DTRStatus::DTRStatusType st,
                          unsigned long long int size,
                          Arc::Time transfer_start_time,
                          const std::string& checksum = "") {
-  static DataStaging::DataDeliveryComm::Status status;
-  static unsigned int status_pos = 0;
-  static bool status_changed = true;
 
   unsigned long long int transfer_time = 0;
   if (transfer_start_time != Arc::Time(0)) {
@@ -63,23 +88,19 @@ static void ReportStatus(DataStaging::DTRStatus::DTRStatusType st,
   if(status_pos == 0) {
     status_changed=true;
   };
-  if(status_changed) {
-    for(;;) {
-      ssize_t l = ::write(STDOUT_FILENO,((char*)&status)+status_pos,sizeof(status)-status_pos);
-      if(l == -1) { // error, parent exited?
-        break;
-      } else if(l == 0) { // will happen if stdout is non-blocking
-        break;
-      } else {
-        status_pos+=l;
-      };
-      if(status_pos >= sizeof(status)) {
-        status_pos=0;
-        status_changed=false;
-        break;
-      };
-    };
-  };
+  if(status_changed) WriteStatus();
+}
+
+// In worker mode tells parent that transfer is finished. Last status is
+// sent again with communication state set to what parent would detect
+// from exit code of process.
+static void ReportFinished(bool success) {
+  // complete status which may be partially written
+  if(status_pos != 0) WriteStatus();
+  status.commstatus = success ? DataStaging::DataDeliveryComm::CommExited
+                              : DataStaging::DataDeliveryComm::CommFailed;
+  status_pos = 0;
+  WriteStatus();
 }
 
 static unsigned long long int transfer_bytes = 0;
@@ -106,27 +127,10 @@ static unsigned long long int GetFileSize(const DataPoint& source, const DataPoi
   return 0;
 }
 
-int main(int argc,char* argv[]) {
-
-  // log to stderr
-  Arc::Logger::getRootLogger().setThreshold(Arc::VERBOSE); //TODO: configurable
-  Arc::LogStream logcerr(std::cerr);
-  logcerr.setFormat(Arc::EmptyFormat);
-  Arc::Logger::getRootLogger().addDestination(logcerr);
-
-  // Collecting parameters
-  // --surl: source URL 
-  // --durl: destination URL
-  // --sopt: any URL option, credential - path to file storing credentials
-  // --dopt: any URL option, credential - path to file storing credentials
-  // --topt: minspeed, minspeedtime, minavgspeed, maxinacttime, avgtime
-  // --size: total size of data to be transferred
-  // --cstype: checksum type to calculate
-  // --csvalue: checksum value of source file to validate against
-  // surl, durl, cstype and csvalue may be given only once
-  // sopt, dopt, topt may be given multiple times
-  // type of credentials is detected automatically, so far only 
-  // X.509 proxies or key+certificate are accepted
+// Parameters of single transfer. Given on command line or, in worker
+// mode, read from stdin.
+class TransferRequest {
+ public:
   std::string source_str;
   std::string dest_str;
   std::list<std::string> source_opts;
@@ -135,22 +139,131 @@ int main(int argc,char* argv[]) {
   std::string size;
   std::string checksum_type;
   std::string checksum_value;
+};
+
+// Variables set for 3rd party tools during transfer. Values they had
+// at start are restored before every transfer so that credentials of one
+// transfer are not used by next one in worker mode.
+static const char* const x509_vars[] = {
+  "X509_USER_PROXY", "X509_CERT_DIR", "X509_USER_CERT", "X509_USER_KEY", NULL
+};
+static std::map<std::string, std::string> x509_env;
+
+static DataStatus StartReading(DataPoint& source, DataBuffer& buffer) {
+  return source.StartReading(buffer);
+}
+
+static DataStatus StartReading(DataPoint& source, DataRingBuffer& buffer) {
+  return source.StartReadingVectored(buffer);
+}
+
+static DataStatus StartWriting(DataPoint& dest, DataBuffer& buffer) {
+  return dest.StartWriting(buffer);
+}
+
+static DataStatus StartWriting(DataPoint& dest, DataRingBuffer& buffer) {
+  return dest.StartWritingVectored(buffer);
+}
+
+// Runs transfer through buffer and reports progress till it ends.
+// Returns false if transfer could not be started. That is already
+// reported then.
+template<class Buffer>
+static bool RunTransfer(DataPoint& source, DataPoint& dest, Buffer& buffer,
+                        const URL& source_url, const URL& dest_url,
+                        DataStatus& source_st, DataStatus& dest_st, bool& eof_reached) {
+  // Initiating transfer
+  source_st = StartReading(source, buffer);
+  if(!source_st) {
+    ReportStatus(DataStaging::DTRStatus::TRANSFERRED,
+                 (source_url.Protocol()!="file") ?
+                  (source_st.Retryable() ? DataStaging::DTRErrorStatus::TEMPORARY_REMOTE_ERROR :
+                                           DataStaging::DTRErrorStatus::PERMANENT_REMOTE_ERROR) :
+                  DataStaging::DTRErrorStatus::LOCAL_FILE_ERROR,
+                 DataStaging::DTRErrorStatus::ERROR_SOURCE,
+                 std::string("Failed reading from source: ")+source.CurrentLocation().str()+
+                  " : "+std::string(source_st),
+                 0,0,0);
+    // Make sure nothing started by failed attempt keeps using buffer
+    source.StopReading();
+    return false;
+  };
+  dest_st = StartWriting(dest, buffer);
+  if(!dest_st) {
+    ReportStatus(DataStaging::DTRStatus::TRANSFERRED,
+                 (dest_url.Protocol() != "file") ?
+                  (dest_st.Retryable() ? DataStaging::DTRErrorStatus::TEMPORARY_REMOTE_ERROR :
+                                         DataStaging::DTRErrorStatus::PERMANENT_REMOTE_ERROR) :
+                  DataStaging::DTRErrorStatus::LOCAL_FILE_ERROR,
+                 DataStaging::DTRErrorStatus::ERROR_DESTINATION,
+                 std::string("Failed writing to destination: ")+dest.CurrentLocation().str()+
+                  " : "+std::string(dest_st),
+                 0,0,0);
+    // Reading threads use buffer and handles which are destroyed on
+    // return, so they must be stopped before process takes next transfer
+    source.StopReading();
+    return false;
+  }
+  // While transfer is running in another threads
+  // here we periodically report status to parent
+  for(;!buffer.error() && !delivery_shutdown;) {
+    if(buffer.eof_read() && buffer.eof_write()) {
+      eof_reached = true; break;
+    };
+    ReportStatus(DataStaging::DTRStatus::TRANSFERRING,
+                 DataStaging::DTRErrorStatus::NONE_ERROR,
+                 DataStaging::DTRErrorStatus::NO_ERROR_LOCATION,
+                 "",
+                 buffer.speed.transferred_size(),
+                 GetFileSize(source,dest),0);
+    buffer.wait_any();
+  };
+  dest_st = dest.StopWriting();
+  source_st = source.StopReading();
+  return true;
+}
+
+static void SaveEnv(void) {
+  for(int n = 0; x509_vars[n]; ++n) {
+    bool found = false;
+    std::string value = GetEnv(x509_vars[n], found);
+    if(found) x509_env[x509_vars[n]] = value;
+  };
+}
+
+static void RestoreEnv(void) {
+  for(int n = 0; x509_vars[n]; ++n) {
+    std::map<std::string, std::string>::iterator v = x509_env.find(x509_vars[n]);
+    if(v != x509_env.end()) {
+      SetEnv(v->first, v->second);
+    } else {
+      UnsetEnv(x509_vars[n]);
+    };
+  };
+}
+
+static int Transfer(const TransferRequest& request, const std::string& proxy_cred) {
+
+  const std::string& source_str = request.source_str;
+  const std::string& dest_str = request.dest_str;
+  const std::list<std::string>& source_opts = request.source_opts;
+  const std::list<std::string>& dest_opts = request.dest_opts;
+  const std::list<std::string>& transfer_opts = request.transfer_opts;
+  const std::string& size = request.size;
+  const std::string& checksum_type = request.checksum_type;
+  const std::string& checksum_value = request.checksum_value;
   std::string source_cred_path;
   std::string dest_cred_path;
   std::string source_ca_path;
   std::string dest_ca_path;
-  OptionParser opt;
-  opt.AddOption(0,"surl","","source URL",source_str);
-  opt.AddOption(0,"durl","","destination URL",dest_str);
-  opt.AddOption(0,"sopt","","source options",source_opts);
-  opt.AddOption(0,"dopt","","destination options",dest_opts);
-  opt.AddOption(0,"topt","","transfer options",transfer_opts);
-  opt.AddOption(0,"size","","total size",size);
-  opt.AddOption(0,"cstype","","checksum type",checksum_type);
-  opt.AddOption(0,"csvalue","","checksum value",checksum_value);
-  if(opt.Parse(argc,argv).size() != 0) {
-    logger.msg(ERROR, "Unexpected arguments"); return -1;
-  };
+
+  // Start with clean state
+  memset(&status, 0, sizeof(status));
+  status_pos = 0;
+  status_changed = true;
+  transfer_bytes = 0;
+  start_time = Arc::Time();
+
   if(source_str.empty()) {
     logger.msg(ERROR, "Source URL missing"); return -1;
   };
@@ -165,7 +278,7 @@ int main(int argc,char* argv[]) {
   if(!dest_url) {
     logger.msg(ERROR, "Destination URL not valid: %s", dest_str); return -1;
   };
-  for(std::list<std::string>::iterator o = source_opts.begin();
+  for(std::list<std::string>::const_iterator o = source_opts.begin();
                            o != source_opts.end();++o) {
     std::string::size_type p = o->find('=');
     if(p == std::string::npos) {
@@ -181,7 +294,7 @@ int main(int argc,char* argv[]) {
       };
     };
   };
-  for(std::list<std::string>::iterator o = dest_opts.begin();
+  for(std::list<std::string>::const_iterator o = dest_opts.begin();
                            o != dest_opts.end();++o) {
     std::string::size_type p = o->find('=');
     if(p == std::string::npos) {
@@ -202,7 +315,8 @@ int main(int argc,char* argv[]) {
   buffer.speed.verbose(true);
   unsigned long long int minspeed = 0;
   time_t minspeedtime = 0;
-  for(std::list<std::string>::iterator o = transfer_opts.begin();
+  bool vectored_io = false;
+  for(std::list<std::string>::const_iterator o = transfer_opts.begin();
                            o != transfer_opts.end();++o) {
     std::string::size_type p = o->find('=');
     if(p != std::string::npos) {
@@ -219,9 +333,11 @@ int main(int argc,char* argv[]) {
           buffer.speed.set_max_inactivity_time(value);
         } else if(name == "avgtime") {
           buffer.speed.set_base(value);
+        } else if(name == "vectoredio") {
+          vectored_io = (value != 0);
         } else {
           logger.msg(ERROR, "Unknown transfer option: %s", name);
-          _exit(-1);
+          return -1;
         }
       };
     };
@@ -232,10 +348,11 @@ int main(int argc,char* argv[]) {
   CheckSumAny crc;
   CheckSumAny crc_source;
   CheckSumAny crc_dest;
-
-  // Read credential from stdin if available
-  std::string proxy_cred;
-  std::getline(std::cin, proxy_cred, '\0');
+  // Ring computes checksum in own thread, so it is also destroyed after
+  // DataHandles and before checksum objects. Memory is only allocated if
+  // vectored I/O is requested.
+  DataRingBuffer ring(vectored_io ? 4194304 : 0);
+  bool use_ring = false;
 
   initializeCredentialsType source_cred(initializeCredentialsType::SkipCredentials);
   UserConfig source_cfg(source_cred);
@@ -246,12 +363,11 @@ int main(int argc,char* argv[]) {
   DataHandle source(source_url, source_cfg);
   if(!source) {
     logger.msg(ERROR, "Source URL not supported: %s", source_url.str());
-    _exit(-1);
-    //return -1;
+    return -1;
   };
   if (source->RequiresCredentialsInFile() && source_cred_path.empty()) {
     logger.msg(ERROR, "No credentials supplied");
-    _exit(-1);
+    return -1;
   }
 
   source->SetSecure(false);
@@ -265,17 +381,17 @@ int main(int argc,char* argv[]) {
   DataHandle dest(dest_url,dest_cfg);
   if(!dest) {
     logger.msg(ERROR, "Destination URL not supported: %s", dest_url.str());
-    _exit(-1);
-    //return -1;
+    return -1;
   };
   if (dest->RequiresCredentialsInFile() && dest_cred_path.empty()) {
     logger.msg(ERROR, "No credentials supplied");
-    _exit(-1);
+    return -1;
   }
   dest->SetSecure(false);
   dest->Passive(true);
 
   // set X509* for 3rd party tools which need it (eg GFAL)
+  RestoreEnv();
   if (!source_cfg.ProxyPath().empty()) {
     SetEnv("X509_USER_PROXY", source_cfg.ProxyPath());
     if (!source_cfg.CACertificatesDirectory().empty()) SetEnv("X509_CERT_DIR", source_cfg.CACertificatesDirectory());
@@ -384,51 +500,19 @@ int main(int argc,char* argv[]) {
     }
   }
   if (try_another_transfer) {
-    // Initiating transfer
-    source_st = source->StartReading(buffer);
-    if(!source_st) {
-      ReportStatus(DataStaging::DTRStatus::TRANSFERRED,
-                   (source_url.Protocol()!="file") ?
-                    (source_st.Retryable() ? DataStaging::DTRErrorStatus::TEMPORARY_REMOTE_ERROR :
-                                             DataStaging::DTRErrorStatus::PERMANENT_REMOTE_ERROR) :
-                    DataStaging::DTRErrorStatus::LOCAL_FILE_ERROR,
-                   DataStaging::DTRErrorStatus::ERROR_SOURCE,
-                   std::string("Failed reading from source: ")+source->CurrentLocation().str()+
-                    " : "+std::string(source_st),
-                   0,0,0);
-      _exit(-1);
-      //return -1;
-    };
-    dest_st = dest->StartWriting(buffer);
-    if(!dest_st) {
-      ReportStatus(DataStaging::DTRStatus::TRANSFERRED,
-                   (dest_url.Protocol() != "file") ?
-                    (dest_st.Retryable() ? DataStaging::DTRErrorStatus::TEMPORARY_REMOTE_ERROR :
-                                           DataStaging::DTRErrorStatus::PERMANENT_REMOTE_ERROR) :
-                    DataStaging::DTRErrorStatus::LOCAL_FILE_ERROR,
-                   DataStaging::DTRErrorStatus::ERROR_DESTINATION,
-                   std::string("Failed writing to destination: ")+dest->CurrentLocation().str()+
-                    " : "+std::string(dest_st),
-                   0,0,0);
-      _exit(-1);
-      //return -1;
+    if (ring && source->SupportsVectoredIO() && dest->SupportsVectoredIO()) {
+      logger.msg(INFO, "Using vectored I/O for transfer");
+      use_ring = true;
+      ring.speed = buffer.speed;
+      if (crc) ring.add(&crc);
+      if (!RunTransfer(*source, *dest, ring, source_url, dest_url, source_st, dest_st, eof_reached)) return -1;
+      // Rest of processing looks at usual buffer only
+      buffer.speed = ring.speed;
+      if (ring.error_read()) buffer.error_read(true);
+      if (ring.error_write()) buffer.error_write(true);
+    } else {
+      if (!RunTransfer(*source, *dest, buffer, source_url, dest_url, source_st, dest_st, eof_reached)) return -1;
     }
-    // While transfer is running in another threads
-    // here we periodically report status to parent
-    for(;!buffer.error() && !delivery_shutdown;) {
-      if(buffer.eof_read() && buffer.eof_write()) {
-        eof_reached = true; break;
-      };
-      ReportStatus(DataStaging::DTRStatus::TRANSFERRING,
-                   DataStaging::DTRErrorStatus::NONE_ERROR,
-                   DataStaging::DTRErrorStatus::NO_ERROR_LOCATION,
-                   "",
-                   buffer.speed.transferred_size(),
-                   GetFileSize(*source,*dest),0);
-      buffer.wait_any();
-    };
-    dest_st = dest->StopWriting();
-    source_st = source->StopReading();
   }
   if (delivery_shutdown) {
     ReportStatus(DataStaging::DTRStatus::TRANSFERRED,
@@ -437,6 +521,7 @@ int main(int argc,char* argv[]) {
                  "DataStagingProcess process killed",
                  buffer.speed.transferred_size(),
                  GetFileSize(*source,*dest),0);
+    // Process is asked to stop - no need to wait for transfer threads
     dest->StopWriting();
     _exit(-1);
   }
@@ -513,17 +598,17 @@ int main(int argc,char* argv[]) {
     };
   };
 
-  if (crc && buffer.checksum_valid()) {
-    char buf[100];
-    crc.print(buf,100);
+  if (crc && (use_ring ? ring.checksum_valid() : buffer.checksum_valid())) {
+    char buf[CheckSum::MaxPrintLength];
+    crc.print(buf,sizeof(buf));
     calc_csum = buf;
   } else if(crc_source) {
-    char buf[100];
-    crc_source.print(buf,100);
+    char buf[CheckSum::MaxPrintLength];
+    crc_source.print(buf,sizeof(buf));
     calc_csum = buf;
   } else if(crc_dest) {
-    char buf[100];
-    crc_dest.print(buf,100);
+    char buf[CheckSum::MaxPrintLength];
+    crc_dest.print(buf,sizeof(buf));
     calc_csum = buf;
   }
   if (!reported && !calc_csum.empty() && crc.Type() != CheckSumAny::none) {
@@ -567,7 +652,142 @@ int main(int argc,char* argv[]) {
                  start_time,
                  calc_csum);
   };
-  _exit(eof_reached?0:1);
-  //return eof_reached?0:1;
+  return eof_reached?0:1;
+}
+
+
+// Data read from stdin in worker mode but not processed yet
+static std::string request_buf;
+
+// Reads next NUL terminated string from stdin. Fails if stdin is closed,
+// process is asked to stop or nothing comes in idle_time seconds (0 means
+// wait forever).
+static bool ReadString(std::string& str, int idle_time) {
+  for(;;) {
+    std::string::size_type p = request_buf.find('\0');
+    if(p != std::string::npos) {
+      str = request_buf.substr(0, p);
+      request_buf.erase(0, p+1);
+      return true;
+    };
+    if(delivery_shutdown) return false;
+    struct pollfd fd;
+    fd.fd = STDIN_FILENO; fd.events = POLLIN; fd.revents = 0;
+    int r = ::poll(&fd, 1, (idle_time > 0) ? (idle_time * 1000) : -1);
+    if(r == 0) return false;
+    if(r < 0) {
+      if(errno == EINTR) continue;
+      return false;
+    };
+    char buf[4096];
+    ssize_t l = ::read(STDIN_FILENO, buf, sizeof(buf));
+    if(l < 0) {
+      if(errno == EINTR) continue;
+      return false;
+    };
+    if(l == 0) return false;
+    request_buf.append(buf, l);
+  };
+}
+
+// Request is made of pairs of option name and value, same as on command
+// line, followed by empty string and credentials. All strings are NUL
+// terminated.
+static bool ReadRequest(TransferRequest& request, std::string& proxy_cred, int idle_time) {
+  for(;;) {
+    std::string name;
+    if(!ReadString(name, idle_time)) return false;
+    if(name.empty()) break;
+    std::string value;
+    if(!ReadString(value, idle_time)) return false;
+    if(name == "--surl") {
+      request.source_str = value;
+    } else if(name == "--durl") {
+      request.dest_str = value;
+    } else if(name == "--sopt") {
+      request.source_opts.push_back(value);
+    } else if(name == "--dopt") {
+      request.dest_opts.push_back(value);
+    } else if(name == "--topt") {
+      request.transfer_opts.push_back(value);
+    } else if(name == "--size") {
+      request.size = value;
+    } else if(name == "--cstype") {
+      request.checksum_type = value;
+    } else if(name == "--csvalue") {
+      request.checksum_value = value;
+    } else {
+      logger.msg(ERROR, "Unexpected option in request: %s", name);
+      return false;
+    };
+  };
+  return ReadString(proxy_cred, idle_time);
 }
 
+int main(int argc,char* argv[]) {
+
+  // log to stderr
+  Arc::Logger::getRootLogger().setThreshold(Arc::VERBOSE); //TODO: configurable
+  Arc::LogStream logcerr(std::cerr);
+  logcerr.setFormat(Arc::EmptyFormat);
+  Arc::Logger::getRootLogger().addDestination(logcerr);
+
+  // Collecting parameters
+  // --surl: source URL 
+  // --durl: destination URL
+  // --sopt: any URL option, credential - path to file storing credentials
+  // --dopt: any URL option, credential - path to file storing credentials
+  // --topt: minspeed, minspeedtime, minavgspeed, maxinacttime, avgtime, vectoredio
+  // --size: total size of data to be transferred
+  // --cstype: checksum type to calculate
+  // --csvalue: checksum value of source file to validate against
+  // surl, durl, cstype and csvalue may be given only once
+  // sopt, dopt, topt may be given multiple times
+  // type of credentials is detected automatically, so far only 
+  // X.509 proxies or key+certificate are accepted
+  // --worker: instead of single transfer given by options above perform
+  //   transfers requested through stdin one after another
+  // --maxtransfers: number of transfers after which worker exits
+  // --idletime: seconds worker waits for next request before exiting
+  TransferRequest request;
+  bool worker = false;
+  int max_transfers = 0;
+  int idle_time = 0;
+  OptionParser opt;
+  opt.AddOption(0,"surl","","source URL",request.source_str);
+  opt.AddOption(0,"durl","","destination URL",request.dest_str);
+  opt.AddOption(0,"sopt","","source options",request.source_opts);
+  opt.AddOption(0,"dopt","","destination options",request.dest_opts);
+  opt.AddOption(0,"topt","","transfer options",request.transfer_opts);
+  opt.AddOption(0,"size","","total size",request.size);
+  opt.AddOption(0,"cstype","","checksum type",request.checksum_type);
+  opt.AddOption(0,"csvalue","","checksum value",request.checksum_value);
+  opt.AddOption(0,"worker","",worker);
+  opt.AddOption(0,"maxtransfers","","maximal number of transfers",max_transfers);
+  opt.AddOption(0,"idletime","","maximal idle time",idle_time);
+  if(opt.Parse(argc,argv).size() != 0) {
+    logger.msg(ERROR, "Unexpected arguments"); return -1;
+  };
+
+  SaveEnv();
+
+  if(worker) {
+    // Plugins and connections stay loaded between transfers. Process is
+    // restarted after few transfers to limit effect of leaks.
+    for(int n = 0; (max_transfers <= 0) || (n < max_transfers); ++n) {
+      TransferRequest worker_request;
+      std::string proxy_cred;
+      if(!ReadRequest(worker_request, proxy_cred, idle_time)) break;
+      int result = Transfer(worker_request, proxy_cred);
+      ReportFinished(result == 0);
+    };
+    _exit(0);
+  };
+
+  // Read credential from stdin if available
+  std::string proxy_cred;
+  std::getline(std::cin, proxy_cred, '\0');
+
+  _exit(Transfer(request, proxy_cred));
+  //return Transfer(request, proxy_cred);
+}
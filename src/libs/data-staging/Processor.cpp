@@ -2,6 +2,7 @@
 #include <config.h>
 #endif
 
+#include <arc/FileUtils.h>
 #include <arc/Thread.h>
 #include <arc/StringConv.h>
 #include <arc/data/DataHandle.h>
@@ -16,6 +17,16 @@ namespace DataStaging {
 
   std::string Processor::hostname;
 
+  // Same limit as used by Scheduler for bulk requests
+  const unsigned int Processor::max_bulk = 100;
+
+  const unsigned int Processor::default_threads = 20;
+
+  const char* const Processor::stage_names[Processor::STAGE_NUM] = {
+    "CHECK_CACHE", "RESOLVE", "QUERY_REPLICA", "PRE_CLEAN", "STAGE_PREPARE",
+    "RELEASE_REQUEST", "REGISTER_REPLICA", "PROCESS_CACHE"
+  };
+
   /** Set up logging. Should be called at the start of each thread method. */
   void setUpLogger(DTR_ptr request) {
     // Move DTR destinations from DTR logger to Root logger to catch all messages.
@@ -27,7 +38,7 @@ namespace DataStaging {
     request->get_logger()->removeDestinations();
   }
 
-  Processor::Processor() {
+  Processor::Processor(): threads(default_threads), started(false), exiting(false) {
     // Get hostname, needed to exclude ACIX replicas on localhost
     char hostn[256];
     if (gethostname(hostn, sizeof(hostn)) == 0){
@@ -756,16 +767,24 @@ namespace DataStaging {
 
   void Processor::receiveDTR(DTR_ptr request) {
 
-    BulkThreadArgument* bulk_arg = NULL;
-    ThreadArgument* arg = NULL;
+    start();
+
+    // Bulk capability must be checked before state is changed
+    bool mergeable = false;
+    if ((request->get_status() == DTRStatus::RESOLVE ||
+         request->get_status() == DTRStatus::QUERY_REPLICA) &&
+        request->bulk_possible()) mergeable = true;
+
+    std::list<DTR_ptr> dtrs;
+    bool bulk = false;
 
     // first deal with bulk
     if (request->get_bulk_end()) { // end of bulk
       request->get_logger()->msg(Arc::VERBOSE, "Adding to bulk request");
       request->set_bulk_end(false);
       bulk_list.push_back(request);
-      bulk_arg = new BulkThreadArgument(this, bulk_list);
-      bulk_list.clear();
+      dtrs.swap(bulk_list);
+      bulk = true;
     }
     else if (request->get_bulk_start() || !bulk_list.empty()) { // filling bulk list
       request->get_logger()->msg(Arc::VERBOSE, "Adding to bulk request");
@@ -773,56 +792,55 @@ namespace DataStaging {
       if (request->get_bulk_start()) request->set_bulk_start(false);
     }
     else { // non-bulk request
-      arg = new ThreadArgument(this, request);
+      dtrs.push_back(request);
     }
 
     // switch through the expected DTR states
+    Stage stage = STAGE_NUM;
     switch (request->get_status().GetStatus()) {
 
       // pre-processor states
 
       case DTRStatus::CHECK_CACHE: {
         request->set_status(DTRStatus::CHECKING_CACHE);
-        Arc::CreateThreadFunction(&DTRCheckCache, (void*)arg, &thread_count);
+        stage = STAGE_CHECK_CACHE;
       }; break;
 
       case DTRStatus::RESOLVE: {
         request->set_status(DTRStatus::RESOLVING);
-        if (bulk_arg) Arc::CreateThreadFunction(&DTRBulkResolve, (void*)bulk_arg, &thread_count);
-        else if (arg) Arc::CreateThreadFunction(&DTRResolve, (void*)arg, &thread_count);
+        stage = STAGE_RESOLVE;
       }; break;
 
       case DTRStatus::QUERY_REPLICA: {
         request->set_status(DTRStatus::QUERYING_REPLICA);
-        if (bulk_arg) Arc::CreateThreadFunction(&DTRBulkQueryReplica, (void*)bulk_arg, &thread_count);
-        else if (arg) Arc::CreateThreadFunction(&DTRQueryReplica, (void*)arg, &thread_count);
+        stage = STAGE_QUERY_REPLICA;
       }; break;
 
       case DTRStatus::PRE_CLEAN: {
         request->set_status(DTRStatus::PRE_CLEANING);
-        Arc::CreateThreadFunction(&DTRPreClean, (void*)arg, &thread_count);
+        stage = STAGE_PRE_CLEAN;
       }; break;
 
       case DTRStatus::STAGE_PREPARE: {
         request->set_status(DTRStatus::STAGING_PREPARING);
-        Arc::CreateThreadFunction(&DTRStagePrepare, (void*)arg, &thread_count);
+        stage = STAGE_STAGE_PREPARE;
       }; break;
 
       // post-processor states
 
       case DTRStatus::RELEASE_REQUEST: {
         request->set_status(DTRStatus::RELEASING_REQUEST);
-        Arc::CreateThreadFunction(&DTRReleaseRequest, (void*)arg, &thread_count);
+        stage = STAGE_RELEASE_REQUEST;
       }; break;
 
       case DTRStatus::REGISTER_REPLICA: {
         request->set_status(DTRStatus::REGISTERING_REPLICA);
-        Arc::CreateThreadFunction(&DTRRegisterReplica, (void*)arg, &thread_count);
+        stage = STAGE_REGISTER_REPLICA;
       }; break;
 
       case DTRStatus::PROCESS_CACHE: {
         request->set_status(DTRStatus::PROCESSING_CACHE);
-        Arc::CreateThreadFunction(&DTRProcessCache, (void*)arg, &thread_count);
+        stage = STAGE_PROCESS_CACHE;
       }; break;
 
       default: {
@@ -831,18 +849,207 @@ namespace DataStaging {
                               DTRErrorStatus::ERROR_UNKNOWN,
                               "Received a DTR in an unexpected state ("+request->get_status().str()+") in processor");
         DTR::push(request, SCHEDULER);
-        if (arg) delete arg;
-        if (bulk_arg) delete bulk_arg;
+        return;
       }; break;
     }
+
+    // Only resolving and querying replicas can be done in bulk
+    if (stage != STAGE_RESOLVE && stage != STAGE_QUERY_REPLICA) {
+      bulk = false;
+      mergeable = false;
+    }
+    if (!dtrs.empty()) enqueue(stage, dtrs, bulk, mergeable);
+  }
+
+  bool Processor::can_merge(const WorkItem& item, const DTR_ptr& dtr) {
+    // Same conditions as used by Scheduler when forming bulk requests
+    const DTR_ptr& first = item.dtrs.front();
+    return (item.dtrs.size() < max_bulk &&
+            first->get_parent_job_id() == dtr->get_parent_job_id() &&
+            first->get_source()->GetURL().Protocol() == dtr->get_source()->GetURL().Protocol() &&
+            first->get_source()->GetURL().Host() == dtr->get_source()->GetURL().Host() &&
+            first->get_source()->CurrentLocation().Protocol() == dtr->get_source()->CurrentLocation().Protocol() &&
+            first->get_source()->CurrentLocation().Host() == dtr->get_source()->CurrentLocation().Host() &&
+            // Mix of LFNs and GUIDs can't be used when querying a catalog like LFC
+            first->get_source()->GetURL().MetaDataOption("guid").length() == dtr->get_source()->GetURL().MetaDataOption("guid").length());
+  }
+
+  void Processor::enqueue(Stage stage, const std::list<DTR_ptr>& dtrs, bool bulk, bool mergeable) {
+    Glib::Mutex::Lock lock(queue_lock);
+    StageQueue& queue = queues[stage];
+    if (mergeable && dtrs.size() == 1) {
+      // DTRs which came separately while others of same job are still
+      // waiting are joined into one bulk request
+      for (std::list<WorkItem>::iterator item = queue.items.begin(); item != queue.items.end(); ++item) {
+        if (item->mergeable && can_merge(*item, dtrs.front())) {
+          dtrs.front()->get_logger()->msg(Arc::VERBOSE, "Adding to bulk request");
+          item->dtrs.push_back(dtrs.front());
+          item->bulk = true;
+          ++(queue.merged);
+          return;
+        }
+      }
+    }
+    queue.items.push_back(WorkItem());
+    WorkItem& item = queue.items.back();
+    item.dtrs = dtrs;
+    item.bulk = bulk;
+    item.mergeable = mergeable;
+    queue_cond.signal();
+  }
+
+  bool Processor::get_work(int home, Stage& stage, WorkItem& item) {
+    Glib::Mutex::Lock lock(queue_lock);
+    for (;;) {
+      int selected = -1;
+      if (!queues[home].items.empty()) {
+        selected = home;
+      } else {
+        // Help with the longest queue
+        std::list<WorkItem>::size_type longest = 0;
+        for (int n = 0; n < STAGE_NUM; ++n) {
+          std::list<WorkItem>::size_type size = queues[n].items.size();
+          if (size > longest) {
+            longest = size;
+            selected = n;
+          }
+        }
+      }
+      if (selected != -1) {
+        StageQueue& queue = queues[selected];
+        stage = (Stage)selected;
+        item = queue.items.front();
+        queue.items.pop_front();
+        queue.wait.add(Arc::Time() - item.queued);
+        queue.running += item.dtrs.size();
+        return true;
+      }
+      if (exiting) return false;
+      queue_cond.wait(queue_lock);
+    }
+  }
+
+  void Processor::process(Stage stage, WorkItem& item) {
+    Arc::Time start;
+    unsigned int num = item.dtrs.size();
+    if (item.bulk && num > 1) {
+      BulkThreadArgument* arg = new BulkThreadArgument(this, item.dtrs);
+      if (stage == STAGE_RESOLVE) DTRBulkResolve(arg);
+      else DTRBulkQueryReplica(arg);
+    } else {
+      ThreadArgument* arg = new ThreadArgument(this, item.dtrs.front());
+      switch (stage) {
+        case STAGE_CHECK_CACHE: DTRCheckCache(arg); break;
+        case STAGE_RESOLVE: DTRResolve(arg); break;
+        case STAGE_QUERY_REPLICA: DTRQueryReplica(arg); break;
+        case STAGE_PRE_CLEAN: DTRPreClean(arg); break;
+        case STAGE_STAGE_PREPARE: DTRStagePrepare(arg); break;
+        case STAGE_RELEASE_REQUEST: DTRReleaseRequest(arg); break;
+        case STAGE_REGISTER_REPLICA: DTRRegisterReplica(arg); break;
+        case STAGE_PROCESS_CACHE: DTRProcessCache(arg); break;
+        default: delete arg; break;
+      }
+    }
+    item.dtrs.clear();
+    Glib::Mutex::Lock lock(queue_lock);
+    StageQueue& queue = queues[stage];
+    queue.run.add(Arc::Time() - start);
+    queue.running -= num;
+    queue.done += num;
+  }
+
+  void Processor::worker_thread(void* arg) {
+    WorkerArgument* warg = (WorkerArgument*)arg;
+    Processor* proc = warg->proc;
+    int home = warg->home;
+    delete warg;
+
+    // Messages are logged only to per-DTR destinations, same as in Scheduler
+    Arc::Logger::getRootLogger().setThreadContext();
+    Arc::Logger::getRootLogger().removeDestinations();
+    Arc::Logger::getRootLogger().setThreshold(DTR::LOG_LEVEL);
+
+    Stage stage;
+    WorkItem item;
+    while (proc->get_work(home, stage, item)) {
+      proc->process(stage, item);
+      // Destinations of processed DTRs may go away together with DTR
+      Arc::Logger::getRootLogger().removeDestinations();
+    }
+  }
+
+  void Processor::SetThreads(unsigned int num) {
+    Glib::Mutex::Lock lock(queue_lock);
+    if (!started && num > 0) threads = num;
   }
 
   void Processor::start(void) {
+    Glib::Mutex::Lock lock(queue_lock);
+    if (started) return;
+    started = true;
+    exiting = false;
+    if (threads < STAGE_NUM) threads = STAGE_NUM;
+    for (unsigned int n = 0; n < threads; ++n) {
+      WorkerArgument* arg = new WorkerArgument(this, n % STAGE_NUM);
+      if (!Arc::CreateThreadFunction(&worker_thread, arg, &thread_count)) delete arg;
+    }
   }
 
   void Processor::stop(void) {
-    // threads are short lived so wait for them to complete rather than interrupting
+    {
+      Glib::Mutex::Lock lock(queue_lock);
+      if (!started) return;
+      exiting = true;
+      queue_cond.broadcast();
+    }
+    // operations are short lived so wait for them to complete rather than interrupting
     thread_count.wait(60*1000);
+    Glib::Mutex::Lock lock(queue_lock);
+    started = false;
+  }
+
+  void Processor::dumpState(const std::string& path) {
+    // only files supported for now - simply overwrite path
+    std::string data;
+    queue_lock.lock();
+    for (int n = 0; n < STAGE_NUM; ++n) {
+      const StageQueue& queue = queues[n];
+      unsigned int queued = 0;
+      for (std::list<WorkItem>::const_iterator item = queue.items.begin(); item != queue.items.end(); ++item) {
+        queued += item->dtrs.size();
+      }
+      data += std::string(stage_names[n]) +
+              " queued=" + Arc::tostring(queued) +
+              " running=" + Arc::tostring(queue.running) +
+              " done=" + Arc::tostring(queue.done) +
+              " merged=" + Arc::tostring(queue.merged) +
+              " wait=" + queue.wait.str() +
+              " run=" + queue.run.str() + "\n";
+    }
+    queue_lock.unlock();
+
+    Arc::FileCreate(path, data);
+  }
+
+  void Processor::Histogram::add(const Arc::Period& duration) {
+    double seconds = (double)duration.GetPeriod() + (double)duration.GetPeriodNanoseconds() / 1000000000.0;
+    total += seconds;
+    double limit = 0.001;
+    unsigned int n = 0;
+    for (; n < buckets-1; ++n, limit *= 10) {
+      if (seconds <= limit) break;
+    }
+    ++counts[n];
+  }
+
+  std::string Processor::Histogram::str(void) const {
+    // Counts in buckets up to 1ms, 10ms, ... 1000s and above, followed by total time
+    std::string s;
+    for (unsigned int n = 0; n < buckets; ++n) {
+      s += Arc::tostring(counts[n]) + ",";
+    }
+    s += Arc::tostring(total);
+    return s;
   }
 
 } // namespace DataStaging
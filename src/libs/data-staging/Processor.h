@@ -1,7 +1,11 @@
 #ifndef PROCESSOR_H_
 #define PROCESSOR_H_
 
+#include <vector>
+
+#include <arc/DateTime.h>
 #include <arc/Logger.h>
+#include <arc/Thread.h>
 
 #include "DTR.h"
 
@@ -10,8 +14,13 @@ namespace DataStaging {
   /// The Processor performs pre- and post-transfer operations.
   /**
    * The Processor takes care of everything that should happen before
-   * and after a transfer takes place. Calling receiveDTR() spawns a
-   * thread to perform the required operation depending on the DTR state.
+   * and after a transfer takes place. Calling receiveDTR() queues the DTR
+   * for the operation required by its state. Operations are performed by a
+   * fixed pool of worker threads. There is a separate queue for every kind
+   * of operation. Each worker prefers its own queue and takes work from the
+   * longest other queue when its own is empty. DTRs of the same job which
+   * are waiting in the queue for resolving or querying replicas are merged
+   * into bulk requests if their source supports it.
    * \ingroup datastaging
    * \headerfile Processor.h arc/data-staging/Processor.h
    */
@@ -40,9 +49,78 @@ namespace DataStaging {
       BulkThreadArgument(Processor* proc_, const std::list<DTR_ptr>& dtrs_):proc(proc_),dtrs(dtrs_) { };
     };
 
+    /// Kinds of operations, each having its own queue
+    enum Stage {
+      STAGE_CHECK_CACHE,
+      STAGE_RESOLVE,
+      STAGE_QUERY_REPLICA,
+      STAGE_PRE_CLEAN,
+      STAGE_STAGE_PREPARE,
+      STAGE_RELEASE_REQUEST,
+      STAGE_REGISTER_REPLICA,
+      STAGE_PROCESS_CACHE,
+      STAGE_NUM
+    };
+
+    /// Distribution of durations in logarithmic buckets from 1ms to 1000s
+    class Histogram {
+     public:
+      static const unsigned int buckets = 8;
+      unsigned long long int counts[buckets];
+      double total;
+      Histogram(void):total(0) { for (unsigned int n = 0; n < buckets; ++n) counts[n] = 0; };
+      void add(const Arc::Period& duration);
+      std::string str(void) const;
+    };
+
+    /// One or more DTRs queued for the same operation
+    class WorkItem {
+     public:
+      std::list<DTR_ptr> dtrs;
+      /// Use bulk operation
+      bool bulk;
+      /// More DTRs may be merged into this item
+      bool mergeable;
+      Arc::Time queued;
+      WorkItem(void):bulk(false),mergeable(false) { };
+    };
+
+    /// Queue and statistics for one kind of operation
+    class StageQueue {
+     public:
+      std::list<WorkItem> items;
+      unsigned int running;
+      unsigned long long int done;
+      unsigned long long int merged;
+      Histogram wait;
+      Histogram run;
+      StageQueue(void):running(0),done(0),merged(0) { };
+    };
+
+    /// Class used to pass information to worker thread
+    class WorkerArgument {
+     public:
+      Processor* proc;
+      int home;
+      WorkerArgument(Processor* proc_, int home_):proc(proc_),home(home_) { };
+    };
+
     /// Counter of active threads
     Arc::SimpleCounter thread_count;
 
+    /// Number of worker threads
+    unsigned int threads;
+    /// Whether workers are started
+    bool started;
+    /// Tells workers to exit when queues are empty
+    bool exiting;
+    /// Lock protecting queues
+    Glib::Mutex queue_lock;
+    /// Signals workers about new items in queues
+    Glib::Cond queue_cond;
+    /// Queues for every kind of operation
+    StageQueue queues[STAGE_NUM];
+
     /// List of DTRs to be processed in bulk. Filled between receiveDTR
     /// receiving a DTR with bulk_start on and receiving one with bulk_end on.
     /// It is up to the caller to make sure that all the requests are suitable
@@ -52,6 +130,24 @@ namespace DataStaging {
     /// Our hostname
     static std::string hostname;
 
+    /// Maximal number of DTRs merged into one bulk request
+    static const unsigned int max_bulk;
+    /// Number of worker threads used if not set explicitly
+    static const unsigned int default_threads;
+    /// Names of stages used in statistics
+    static const char* const stage_names[STAGE_NUM];
+
+    /// Put DTRs into queue of given stage, merging with queued ones if possible
+    void enqueue(Stage stage, const std::list<DTR_ptr>& dtrs, bool bulk, bool mergeable);
+    /// Check if DTR may be processed in same bulk request as first DTR of item
+    static bool can_merge(const WorkItem& item, const DTR_ptr& dtr);
+    /// Wait for work and take it from queue. Returns false if worker should exit.
+    bool get_work(int home, Stage& stage, WorkItem& item);
+    /// Perform operation on DTRs of item
+    void process(Stage stage, WorkItem& item);
+    /// Main loop of worker thread
+    static void worker_thread(void* arg);
+
     /* Thread methods which deal with each state */
     /// Check the cache to see if the file already exists
     static void DTRCheckCache(void* arg);
@@ -81,18 +177,26 @@ namespace DataStaging {
     /// Destructor waits for all active threads to stop.
     ~Processor() { stop(); };
 
+    /// Set number of worker threads.
+    /**
+     * Only effective when called before start(). Number of threads is never
+     * less than number of kinds of operations so that each of them has a
+     * thread which prefers it.
+     */
+    void SetThreads(unsigned int num);
+
     /// Start Processor.
     /**
-     * This method actually does nothing. It is here only to make all classes
-     * of data staging to look alike. But it is better to call it before
-     * starting to use object because it may do something in the future.
+     * Starts worker threads. If it is not called workers are started when
+     * first DTR is received.
      */
     void start(void);
 
     /// Stop Processor.
     /**
-     * This method sends waits for all started threads to end and exits. Since
-     * threads are short-lived it is better to wait rather than interrupt them.
+     * This method waits for queued DTRs to be processed and for all worker
+     * threads to exit. Since operations are short-lived it is better to wait
+     * rather than interrupt them.
      */
     void stop(void);
 
@@ -100,11 +204,19 @@ namespace DataStaging {
     /**
      * The DTR is sent to the Processor through this method when some
      * long-latency processing is to be performed, eg contacting a
-     * remote service. The Processor spawns a thread to do the processing,
-     * and then returns. The thread pushes the DTR back to the scheduler when
-     * it is finished.
+     * remote service. The Processor queues the DTR for one of its worker
+     * threads and returns. The worker pushes the DTR back to the scheduler
+     * when it is finished.
      */
     virtual void receiveDTR(DTR_ptr dtr);
+
+    /// Write statistics of operations to file.
+    /**
+     * For every kind of operation number of queued, running and finished
+     * DTRs is written together with histograms of time spent waiting in
+     * queue and time spent processing.
+     */
+    void dumpState(const std::string& path);
   };
 
 
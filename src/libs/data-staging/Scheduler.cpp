@@ -35,6 +35,7 @@ namespace DataStaging {
     PostProcessorSlots = 20;
     EmergencySlots = 2;
     StagedPreparedSlots = 200;
+    ProcessorThreads = 0;
   }
 
   void Scheduler::SetSlots(int pre_processor, int post_processor, int delivery, int emergency, int staged_prepared) {
@@ -47,6 +48,11 @@ namespace DataStaging {
     }
   }
 
+  void Scheduler::SetProcessorThreads(int threads) {
+    if (scheduler_state == INITIATED && threads > 0)
+      ProcessorThreads = threads;
+  }
+
   void Scheduler::AddURLMapping(const Arc::URL& template_url, const Arc::URL& replacement_url, const Arc::URL& access_url) {
     if (scheduler_state == INITIATED)
       url_map.add(template_url,replacement_url,access_url);
@@ -100,6 +106,8 @@ namespace DataStaging {
     scheduler_state = RUNNING;
     state_lock.unlock();
 
+    processor.SetThreads(ProcessorThreads ? ProcessorThreads :
+                         PreProcessorSlots + PostProcessorSlots + 2*EmergencySlots);
     processor.start();
     delivery.start();
     // if no delivery services set, then use local
@@ -1328,6 +1336,7 @@ namespace DataStaging {
     while (sched->scheduler_state == RUNNING && !sched->dumplocation.empty()) {
       // every second, dump state
       sched->DtrList.dumpState(sched->dumplocation);
+      sched->processor.dumpState(sched->dumplocation + ".processor");
       // Performance metric - total number of DTRs in the system
       timespec dummy;
       sched->job_perf_log.Log("DTR_total", Arc::tostring(sched->DtrList.size()), dummy, dummy);
@@ -1372,6 +1381,8 @@ namespace DataStaging {
     logger.msg(Arc::INFO, "  Post-processor slots: %u", PostProcessorSlots);
     logger.msg(Arc::INFO, "  Emergency slots: %u", EmergencySlots);
     logger.msg(Arc::INFO, "  Prepared slots: %u", StagedPreparedSlots);
+    logger.msg(Arc::INFO, "  Processor threads: %u", ProcessorThreads ? ProcessorThreads :
+               PreProcessorSlots + PostProcessorSlots + 2*EmergencySlots);
     logger.msg(Arc::INFO, "  Shares configuration:\n%s", transferSharesConf.conf());
     for (std::vector<Arc::URL>::iterator i = configured_delivery_services.begin();
          i != configured_delivery_services.end(); ++i) {
@@ -1413,7 +1424,10 @@ namespace DataStaging {
     }
     // make sure final state is dumped before exit
     dump_signal.signal();
-    if (!dumplocation.empty()) DtrList.dumpState(dumplocation);
+    if (!dumplocation.empty()) {
+      DtrList.dumpState(dumplocation);
+      processor.dumpState(dumplocation + ".processor");
+    }
 
     log_to_root_logger(Arc::INFO, "Scheduler loop exited");
     run_signal.signal();
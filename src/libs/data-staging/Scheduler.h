@@ -77,6 +77,8 @@ class Scheduler: public DTRCallback {
     unsigned int EmergencySlots;
     /// Limit on number of staged-prepared files, per share
     unsigned int StagedPreparedSlots;
+    /// Number of threads in processor, 0 means enough for all processor slots
+    unsigned int ProcessorThreads;
 
     /// Where to dump DTR state. Currently only a path to a file is supported.
     std::string dumplocation;
@@ -238,6 +240,13 @@ class Scheduler: public DTRCallback {
     void SetSlots(int pre_processor = 0, int post_processor = 0,
                   int delivery = 0, int emergency = 0, int staged_prepared = 0);
 
+    /// Set number of threads performing pre- and post-processing.
+    /**
+     * By default there are as many threads as pre- and post-processor
+     * slots including emergency ones.
+     */
+    void SetProcessorThreads(int threads);
+
     /// Add URL mapping entry. See Arc::URLMap.
     void AddURLMapping(const Arc::URL& template_url, const Arc::URL& replacement_url,
                        const Arc::URL& access_url = Arc::URL());
@@ -269,6 +278,10 @@ class Scheduler: public DTRCallback {
     void SetRemoteSizeLimit(unsigned long long int limit);
 
     /// Set location for periodic dump of DTR state (only file paths currently supported)
+    /**
+     * Statistics of processor operations are dumped to the same path with
+     * ".processor" appended.
+     */
     void SetDumpLocation(const std::string& location);
 
     /// Set JobPerfLog object for performance metrics logging
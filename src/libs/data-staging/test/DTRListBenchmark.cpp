@@ -0,0 +1,111 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+// Measures the cost of DTRList filter calls as the number of DTRs grows.
+// Usage: DTRListBenchmark [max number of DTRs]
+
+#include <cstdlib>
+#include <iostream>
+
+#include <arc/DateTime.h>
+#include <arc/Logger.h>
+#include <arc/StringConv.h>
+#include <arc/User.h>
+#include <arc/UserConfig.h>
+
+#include "../DTRList.h"
+
+using namespace DataStaging;
+
+static double elapsed_us(const Arc::Time& start, int loops) {
+  Arc::Period p = Arc::Time() - start;
+  return ((double)p.GetPeriod() * 1000000.0 + (double)p.GetPeriodNanoseconds() / 1000.0) / loops;
+}
+
+static void run(unsigned int ndtrs, const Arc::UserConfig& cfg, const std::list<DTRLogDestination>& logs) {
+
+  const int loops = 100;
+  DTRList dtrlist;
+  std::list<DTR_ptr> dtrs;
+
+  // Spread DTRs over jobs and states so that each filter returns a
+  // small fixed-size fraction of the list
+  for (unsigned int n = 0; n < ndtrs; ++n) {
+    std::string jobid("job" + Arc::tostring(n/100));
+    DTR_ptr dtr(new DTR("mock://mocksrc/" + Arc::tostring(n), "mock://mockdest/" + Arc::tostring(n),
+                        cfg, jobid, Arc::User().get_uid(), logs, "DTRListBenchmark"));
+    dtrlist.add_dtr(dtr);
+    switch (n % 4) {
+      case 0: dtr->set_status(DTRStatus::NEW); break;
+      case 1: dtr->set_status(DTRStatus::TRANSFERRING); DTR::push(dtr, DELIVERY); break;
+      case 2: dtr->set_status(DTRStatus::CHECK_CACHE); break;
+      default: dtr->set_status(DTRStatus::STAGING_PREPARING); DTR::push(dtr, PRE_PROCESSOR); break;
+    }
+    dtrs.push_back(dtr);
+  }
+
+  std::list<DTR_ptr> filtered;
+  Arc::Time start;
+  for (int i = 0; i < loops; ++i) {
+    filtered.clear();
+    dtrlist.filter_dtrs_by_status(DTRStatus::CHECK_CACHE, filtered);
+  }
+  double status_us = elapsed_us(start, loops);
+
+  start = Arc::Time();
+  for (int i = 0; i < loops; ++i) {
+    filtered.clear();
+    dtrlist.filter_dtrs_by_owner(DELIVERY, filtered);
+  }
+  double owner_us = elapsed_us(start, loops);
+
+  start = Arc::Time();
+  for (int i = 0; i < loops; ++i) {
+    filtered.clear();
+    dtrlist.filter_pending_dtrs(filtered);
+  }
+  double pending_us = elapsed_us(start, loops);
+
+  start = Arc::Time();
+  for (int i = 0; i < loops; ++i) {
+    filtered.clear();
+    dtrlist.filter_dtrs_by_job("job0", filtered);
+  }
+  double job_us = elapsed_us(start, loops);
+
+  start = Arc::Time();
+  for (std::list<DTR_ptr>::iterator dtr = dtrs.begin(); dtr != dtrs.end(); ++dtr) {
+    (*dtr)->set_status(DTRStatus::TRANSFERRED);
+  }
+  double update_us = elapsed_us(start, ndtrs);
+
+  std::cout << ndtrs << " DTRs: status " << status_us << " us, owner " << owner_us
+            << " us, pending " << pending_us << " us, job " << job_us
+            << " us, status change " << update_us << " us" << std::endl;
+
+  for (std::list<DTR_ptr>::iterator dtr = dtrs.begin(); dtr != dtrs.end(); ++dtr) {
+    dtrlist.delete_dtr(*dtr);
+  }
+}
+
+int main(int argc, char **argv) {
+
+  unsigned int maxdtrs = 50000;
+  if (argc > 1 && !Arc::stringto(argv[1], maxdtrs)) {
+    std::cerr << "Usage: " << argv[0] << " [max number of DTRs]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  Arc::Logger::getRootLogger().setThreshold(Arc::ERROR);
+  Arc::UserConfig cfg;
+  std::list<DTRLogDestination> logs;
+
+  // Time per call should stay roughly proportional to the result size, so
+  // should grow linearly with the number of DTRs and not faster
+  for (unsigned int ndtrs = 1000; ndtrs <= maxdtrs; ndtrs *= 10) {
+    run(ndtrs, cfg, logs);
+    if (ndtrs < maxdtrs && ndtrs * 10 > maxdtrs) run(maxdtrs, cfg, logs);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,273 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <arc/StringConv.h>
+#include <arc/User.h>
+
+#include "../DTRList.h"
+
+using namespace DataStaging;
+
+class DTRListTest
+  : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(DTRListTest);
+  CPPUNIT_TEST(TestIndexes);
+  CPPUNIT_TEST(TestDeleteAndAdd);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void TestIndexes();
+  void TestDeleteAndAdd();
+
+  void setUp();
+  void tearDown();
+
+private:
+  DTR_ptr NewDTR(const std::string& jobid);
+  void CheckIndexes(DTRList& dtrlist, const std::list<DTR_ptr>& listed);
+  unsigned int Random(unsigned int max);
+
+  std::list<DTRLogDestination> logs;
+  Arc::UserConfig cfg;
+  int count;
+  unsigned int seed;
+};
+
+// Statuses which DTRs are moved through, covering all virtual queues
+static const DTRStatus::DTRStatusType statuses[] = {
+  DTRStatus::NEW, DTRStatus::CHECK_CACHE, DTRStatus::CACHE_CHECKED,
+  DTRStatus::RESOLVE, DTRStatus::RESOLVED, DTRStatus::TRANSFER,
+  DTRStatus::TRANSFERRING, DTRStatus::TRANSFERRED, DTRStatus::PROCESS_CACHE,
+  DTRStatus::CACHE_PROCESSED, DTRStatus::RELEASE_REQUEST, DTRStatus::DONE
+};
+static const unsigned int num_statuses = sizeof(statuses) / sizeof(statuses[0]);
+
+static const StagingProcesses owners[] = {
+  GENERATOR, SCHEDULER, PRE_PROCESSOR, DELIVERY, POST_PROCESSOR
+};
+static const unsigned int num_owners = sizeof(owners) / sizeof(owners[0]);
+
+void DTRListTest::setUp() {
+  logs.clear();
+  count = 0;
+  seed = 12345;
+}
+
+void DTRListTest::tearDown() {
+}
+
+DTR_ptr DTRListTest::NewDTR(const std::string& jobid) {
+  ++count;
+  DTR_ptr dtr(new DTR("mock://mocksrc/" + Arc::tostring(count), "mock://mockdest/" + Arc::tostring(count),
+                      cfg, jobid, Arc::User().get_uid(), logs, "DTRListTest"));
+  CPPUNIT_ASSERT(*dtr);
+  return dtr;
+}
+
+// Same sequence on every run so that failures can be reproduced
+unsigned int DTRListTest::Random(unsigned int max) {
+  seed = seed * 1103515245 + 12345;
+  return (seed / 65536) % max;
+}
+
+static std::vector<DTR*> Pointers(const std::list<DTR_ptr>& dtrs) {
+  std::vector<DTR*> pointers;
+  for (std::list<DTR_ptr>::const_iterator dtr = dtrs.begin(); dtr != dtrs.end(); ++dtr)
+    pointers.push_back(dtr->Ptr());
+  return pointers;
+}
+
+// Compares every query answered from indexes with linear scan of DTRs
+// which are in the list, kept in order in which they were added.
+void DTRListTest::CheckIndexes(DTRList& dtrlist, const std::list<DTR_ptr>& listed) {
+  CPPUNIT_ASSERT_EQUAL((unsigned int)listed.size(), dtrlist.size());
+  CPPUNIT_ASSERT_EQUAL(listed.empty(), dtrlist.empty());
+
+  for (unsigned int s = 0; s < num_statuses; ++s) {
+    std::list<DTR_ptr> expected;
+    for (std::list<DTR_ptr>::const_iterator dtr = listed.begin(); dtr != listed.end(); ++dtr) {
+      if ((*dtr)->get_status() == statuses[s]) expected.push_back(*dtr);
+    }
+    std::list<DTR_ptr> filtered;
+    CPPUNIT_ASSERT(dtrlist.filter_dtrs_by_status(statuses[s], filtered));
+    CPPUNIT_ASSERT(Pointers(expected) == Pointers(filtered));
+  }
+
+  // Several statuses at once keep order of adding
+  std::vector<DTRStatus::DTRStatusType> some_statuses;
+  some_statuses.push_back(DTRStatus::TRANSFERRED);
+  some_statuses.push_back(DTRStatus::NEW);
+  some_statuses.push_back(DTRStatus::CACHE_CHECKED);
+  std::list<DTR_ptr> expected;
+  std::map<DTRStatus::DTRStatusType, std::list<DTR_ptr> > expected_map;
+  for (std::list<DTR_ptr>::const_iterator dtr = listed.begin(); dtr != listed.end(); ++dtr) {
+    DTRStatus::DTRStatusType status = (*dtr)->get_status().GetStatus();
+    if (std::find(some_statuses.begin(), some_statuses.end(), status) != some_statuses.end()) {
+      expected.push_back(*dtr);
+      expected_map[status].push_back(*dtr);
+    }
+  }
+  std::list<DTR_ptr> filtered;
+  CPPUNIT_ASSERT(dtrlist.filter_dtrs_by_statuses(some_statuses, filtered));
+  CPPUNIT_ASSERT(Pointers(expected) == Pointers(filtered));
+  std::map<DTRStatus::DTRStatusType, std::list<DTR_ptr> > filtered_map;
+  CPPUNIT_ASSERT(dtrlist.filter_dtrs_by_statuses(some_statuses, filtered_map));
+  for (std::vector<DTRStatus::DTRStatusType>::iterator s = some_statuses.begin(); s != some_statuses.end(); ++s) {
+    CPPUNIT_ASSERT(Pointers(expected_map[*s]) == Pointers(filtered_map[*s]));
+  }
+
+  for (unsigned int o = 0; o < num_owners; ++o) {
+    std::list<DTR_ptr> expected;
+    for (std::list<DTR_ptr>::const_iterator dtr = listed.begin(); dtr != listed.end(); ++dtr) {
+      if ((*dtr)->get_owner() == owners[o]) expected.push_back(*dtr);
+    }
+    std::list<DTR_ptr> filtered;
+    CPPUNIT_ASSERT(dtrlist.filter_dtrs_by_owner(owners[o], filtered));
+    CPPUNIT_ASSERT(Pointers(expected) == Pointers(filtered));
+    CPPUNIT_ASSERT_EQUAL((int)expected.size(), dtrlist.number_of_dtrs_by_owner(owners[o]));
+  }
+
+  std::list<DTR_ptr> expected_pre, expected_post, expected_delivery;
+  for (std::list<DTR_ptr>::const_iterator dtr = listed.begin(); dtr != listed.end(); ++dtr) {
+    if ((*dtr)->is_destined_for_pre_processor()) expected_pre.push_back(*dtr);
+    if ((*dtr)->is_destined_for_post_processor()) expected_post.push_back(*dtr);
+    if ((*dtr)->is_destined_for_delivery()) expected_delivery.push_back(*dtr);
+  }
+  std::list<DTR_ptr> filtered_pre, filtered_post, filtered_delivery;
+  CPPUNIT_ASSERT(dtrlist.filter_dtrs_by_next_receiver(PRE_PROCESSOR, filtered_pre));
+  CPPUNIT_ASSERT(dtrlist.filter_dtrs_by_next_receiver(POST_PROCESSOR, filtered_post));
+  CPPUNIT_ASSERT(dtrlist.filter_dtrs_by_next_receiver(DELIVERY, filtered_delivery));
+  CPPUNIT_ASSERT(Pointers(expected_pre) == Pointers(filtered_pre));
+  CPPUNIT_ASSERT(Pointers(expected_post) == Pointers(filtered_post));
+  CPPUNIT_ASSERT(Pointers(expected_delivery) == Pointers(filtered_delivery));
+
+  // Pending DTRs come ordered by processing time, so only content is compared.
+  // Processing times are either in the past or far in the future.
+  Arc::Time now;
+  std::vector<DTR*> expected_pending;
+  for (std::list<DTR_ptr>::const_iterator dtr = listed.begin(); dtr != listed.end(); ++dtr) {
+    if (((*dtr)->came_from_pre_processor() || (*dtr)->came_from_post_processor() ||
+         (*dtr)->came_from_delivery() || (*dtr)->came_from_generator()) &&
+        ((*dtr)->get_process_time() <= now)) expected_pending.push_back(dtr->Ptr());
+  }
+  std::list<DTR_ptr> filtered_pending;
+  CPPUNIT_ASSERT(dtrlist.filter_pending_dtrs(filtered_pending));
+  std::vector<DTR*> pending = Pointers(filtered_pending);
+  std::sort(expected_pending.begin(), expected_pending.end());
+  std::sort(pending.begin(), pending.end());
+  CPPUNIT_ASSERT(expected_pending == pending);
+
+  std::list<std::string> expected_jobs;
+  for (std::list<DTR_ptr>::const_iterator dtr = listed.begin(); dtr != listed.end(); ++dtr) {
+    if (std::find(expected_jobs.begin(), expected_jobs.end(), (*dtr)->get_parent_job_id()) == expected_jobs.end())
+      expected_jobs.push_back((*dtr)->get_parent_job_id());
+  }
+  expected_jobs.sort();
+  std::list<std::string> jobs = dtrlist.all_jobs();
+  jobs.sort();
+  CPPUNIT_ASSERT(expected_jobs == jobs);
+  for (std::list<std::string>::iterator job = expected_jobs.begin(); job != expected_jobs.end(); ++job) {
+    std::list<DTR_ptr> expected;
+    for (std::list<DTR_ptr>::const_iterator dtr = listed.begin(); dtr != listed.end(); ++dtr) {
+      if ((*dtr)->get_parent_job_id() == *job) expected.push_back(*dtr);
+    }
+    std::list<DTR_ptr> filtered;
+    CPPUNIT_ASSERT(dtrlist.filter_dtrs_by_job(*job, filtered));
+    CPPUNIT_ASSERT(Pointers(expected) == Pointers(filtered));
+  }
+}
+
+void DTRListTest::TestIndexes() {
+  // DTRs must outlive the list
+  std::vector<DTR_ptr> dtrs;
+  DTRList dtrlist;
+  std::list<DTR_ptr> listed;
+
+  for (int n = 0; n < 100; ++n) {
+    DTR_ptr dtr = NewDTR("job" + Arc::tostring(n % 7));
+    dtrs.push_back(dtr);
+    CPPUNIT_ASSERT(dtrlist.add_dtr(dtr));
+    listed.push_back(dtr);
+  }
+  CheckIndexes(dtrlist, listed);
+
+  // Adding same DTR again does not duplicate it
+  CPPUNIT_ASSERT(dtrlist.add_dtr(dtrs[0]));
+  CheckIndexes(dtrlist, listed);
+
+  for (int step = 0; step < 2000; ++step) {
+    DTR_ptr dtr = dtrs[Random(dtrs.size())];
+    switch (Random(3)) {
+      case 0:
+        dtr->set_status(statuses[Random(num_statuses)]);
+        break;
+      case 1:
+        DTR::push(dtr, owners[Random(num_owners)]);
+        break;
+      default:
+        dtr->set_process_time(Random(2) ? Arc::Period(-60) : Arc::Period(3600));
+        break;
+    }
+    if (step % 100 == 0) CheckIndexes(dtrlist, listed);
+  }
+  CheckIndexes(dtrlist, listed);
+}
+
+void DTRListTest::TestDeleteAndAdd() {
+  std::vector<DTR_ptr> dtrs;
+  DTRList dtrlist;
+  std::list<DTR_ptr> listed;
+
+  for (int n = 0; n < 50; ++n) {
+    DTR_ptr dtr = NewDTR("job" + Arc::tostring(n % 5));
+    dtrs.push_back(dtr);
+    CPPUNIT_ASSERT(dtrlist.add_dtr(dtr));
+    listed.push_back(dtr);
+  }
+
+  for (int step = 0; step < 1000; ++step) {
+    DTR_ptr dtr = dtrs[Random(dtrs.size())];
+    std::list<DTR_ptr>::iterator pos = listed.begin();
+    for (; pos != listed.end(); ++pos) if (pos->Ptr() == dtr.Ptr()) break;
+    switch (Random(4)) {
+      case 0:
+        // Deleting DTR which is not in the list is harmless
+        CPPUNIT_ASSERT(dtrlist.delete_dtr(dtr));
+        if (pos != listed.end()) listed.erase(pos);
+        break;
+      case 1:
+        // Added again DTR goes to the end
+        CPPUNIT_ASSERT(dtrlist.add_dtr(dtr));
+        if (pos == listed.end()) listed.push_back(dtr);
+        break;
+      case 2:
+        dtr->set_status(statuses[Random(num_statuses)]);
+        break;
+      default:
+        DTR::push(dtr, owners[Random(num_owners)]);
+        break;
+    }
+    if (step % 50 == 0) CheckIndexes(dtrlist, listed);
+  }
+  CheckIndexes(dtrlist, listed);
+
+  // Changes of deleted DTRs do not reach the list
+  for (std::vector<DTR_ptr>::iterator dtr = dtrs.begin(); dtr != dtrs.end(); ++dtr) {
+    CPPUNIT_ASSERT(dtrlist.delete_dtr(*dtr));
+    (*dtr)->set_status(DTRStatus::TRANSFER);
+  }
+  listed.clear();
+  CheckIndexes(dtrlist, listed);
+  std::list<DTR_ptr> filtered;
+  CPPUNIT_ASSERT(dtrlist.filter_dtrs_by_status(DTRStatus::TRANSFER, filtered));
+  CPPUNIT_ASSERT(filtered.empty());
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DTRListTest);
@@ -8,11 +8,13 @@
 
 #include <arc/ArcLocation.h>
 #include <arc/FileUtils.h>
+#include <arc/Run.h>
 #include <arc/UserConfig.h>
 
 #include "../DTRStatus.h"
 #include "../DTR.h"
 #include "../DataDelivery.h"
+#include "../DataDeliveryComm.h"
 
 using namespace DataStaging;
 
@@ -23,12 +25,18 @@ class DeliveryTest
   CPPUNIT_TEST(TestDeliverySimple);
   CPPUNIT_TEST(TestDeliveryFailure);
   CPPUNIT_TEST(TestDeliveryUnsupported);
+  CPPUNIT_TEST(TestDeliveryReuse);
+  CPPUNIT_TEST(TestDeliveryWorker);
+  CPPUNIT_TEST(TestDeliveryWorkerBadRequest);
   CPPUNIT_TEST_SUITE_END();
 
 public:
   void TestDeliverySimple();
   void TestDeliveryFailure();
   void TestDeliveryUnsupported();
+  void TestDeliveryReuse();
+  void TestDeliveryWorker();
+  void TestDeliveryWorkerBadRequest();
   void setUp();
   void tearDown();
 
@@ -146,4 +154,162 @@ void DeliveryTest::TestDeliveryUnsupported() {
   CPPUNIT_ASSERT_EQUAL(DataStaging::DTRErrorStatus::INTERNAL_LOGIC_ERROR, dtr->get_error_status().GetErrorStatus());
 }
 
+// Waits till DTR leaves delivery and returns its final status
+static DataStaging::DTRStatus::DTRStatusType WaitDTR(DataStaging::DTR_ptr dtr, int limit) {
+  for(int cnt=0;;++cnt) {
+    DataStaging::DTRStatus status = dtr->get_status();
+    if((status != DataStaging::DTRStatus::TRANSFERRING) &&
+       (status != DataStaging::DTRStatus::NULL_STATE)) return status.GetStatus();
+    if(cnt >= limit) return status.GetStatus();
+    Glib::usleep(100000);
+  }
+}
+
+void DeliveryTest::TestDeliveryReuse() {
+
+  // Same user and credentials - transfers are passed to same
+  // delivery process one after another, including after failure.
+  DataStaging::DataDelivery delivery;
+  delivery.start();
+  for(int n = 0; n < 4; ++n) {
+    std::string proto((n == 1) ? "fail" : "mock");
+    std::string source(proto+"://mocksrc/"+Arc::tostring(n));
+    std::string destination(proto+"://mockdest/"+Arc::tostring(n));
+    std::string jobid("1234");
+    DataStaging::DTR_ptr dtr(new DataStaging::DTR(source,destination,cfg,jobid,Arc::User().get_uid(),logs,log_name));
+    CPPUNIT_ASSERT(*dtr);
+    delivery.receiveDTR(dtr);
+    CPPUNIT_ASSERT_EQUAL(DataStaging::DTRStatus::TRANSFERRED, WaitDTR(dtr, 300));
+    if(n == 1) {
+      CPPUNIT_ASSERT_EQUAL(DataStaging::DTRErrorStatus::TEMPORARY_REMOTE_ERROR, dtr->get_error_status().GetErrorStatus());
+    } else {
+      CPPUNIT_ASSERT_EQUAL_MESSAGE(dtr->get_error_status().GetDesc(), DataStaging::DTRErrorStatus::NONE_ERROR, dtr->get_error_status().GetErrorStatus());
+    }
+  }
+
+  // Several transfers at once need several processes
+  std::list<DataStaging::DTR_ptr> dtrs;
+  for(int n = 0; n < 3; ++n) {
+    std::string source("mock://mocksrc/"+Arc::tostring(n));
+    std::string destination("mock://mockdest/"+Arc::tostring(n));
+    std::string jobid("1234");
+    DataStaging::DTR_ptr dtr(new DataStaging::DTR(source,destination,cfg,jobid,Arc::User().get_uid(),logs,log_name));
+    CPPUNIT_ASSERT(*dtr);
+    delivery.receiveDTR(dtr);
+    dtrs.push_back(dtr);
+  }
+  for(std::list<DataStaging::DTR_ptr>::iterator dtr = dtrs.begin(); dtr != dtrs.end(); ++dtr) {
+    CPPUNIT_ASSERT_EQUAL(DataStaging::DTRStatus::TRANSFERRED, WaitDTR(*dtr, 300));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE((*dtr)->get_error_status().GetDesc(), DataStaging::DTRErrorStatus::NONE_ERROR, (*dtr)->get_error_status().GetErrorStatus());
+  }
+}
+
+// Reads statuses reported by worker till end of transfer is reported
+static bool ReadFinalStatus(Arc::Run& run, DataStaging::DataDeliveryComm::Status& status) {
+  for(;;) {
+    unsigned int pos = 0;
+    while(pos < sizeof(status)) {
+      int l = run.ReadStdout(30000, ((char*)&status)+pos, sizeof(status)-pos);
+      if(l <= 0) return false;
+      pos += l;
+    }
+    if((status.commstatus == DataStaging::DataDeliveryComm::CommExited) ||
+       (status.commstatus == DataStaging::DataDeliveryComm::CommFailed)) return true;
+  }
+}
+
+static bool WriteRequest(Arc::Run& run, const std::list<std::string>& args, const std::string& credential) {
+  std::string request;
+  for(std::list<std::string>::const_iterator arg = args.begin(); arg != args.end(); ++arg) {
+    request += *arg;
+    request += '\0';
+  }
+  request += '\0';
+  request += credential;
+  request += '\0';
+  std::string::size_type pos = 0;
+  while(pos < request.length()) {
+    int l = run.WriteStdin(10000, request.c_str()+pos, request.length()-pos);
+    if(l <= 0) return false;
+    pos += l;
+  }
+  return true;
+}
+
+void DeliveryTest::TestDeliveryWorker() {
+
+  std::list<std::string> worker_args;
+  worker_args.push_back("../DataStagingDelivery");
+  worker_args.push_back("--worker");
+  worker_args.push_back("--maxtransfers");
+  worker_args.push_back("3");
+  Arc::Run run(worker_args);
+  run.KeepStdout(false);
+  run.KeepStderr(true);
+  run.KeepStdin(false);
+  CPPUNIT_ASSERT(run.Start());
+
+  DataStaging::DataDeliveryComm::Status status;
+
+  // Successful transfer
+  std::list<std::string> args;
+  args.push_back("--surl"); args.push_back("mock://mocksrc/1");
+  args.push_back("--durl"); args.push_back("mock://mockdest/1");
+  args.push_back("--topt"); args.push_back("minspeed=0");
+  CPPUNIT_ASSERT(WriteRequest(run, args, ""));
+  CPPUNIT_ASSERT(ReadFinalStatus(run, status));
+  CPPUNIT_ASSERT_EQUAL(DataStaging::DataDeliveryComm::CommExited, status.commstatus);
+  CPPUNIT_ASSERT_EQUAL(DataStaging::DTRStatus::TRANSFERRED, status.status);
+  CPPUNIT_ASSERT_EQUAL(DataStaging::DTRErrorStatus::NONE_ERROR, status.error);
+
+  // Failed transfer is reported and process takes next request
+  args.clear();
+  args.push_back("--surl"); args.push_back("fail://mocksrc/1");
+  args.push_back("--durl"); args.push_back("fail://mockdest/1");
+  CPPUNIT_ASSERT(WriteRequest(run, args, ""));
+  CPPUNIT_ASSERT(ReadFinalStatus(run, status));
+  CPPUNIT_ASSERT_EQUAL(DataStaging::DataDeliveryComm::CommFailed, status.commstatus);
+  CPPUNIT_ASSERT_EQUAL(DataStaging::DTRErrorStatus::TEMPORARY_REMOTE_ERROR, status.error);
+
+  // Request split into small pieces is assembled
+  args.clear();
+  args.push_back("--surl"); args.push_back("mock://mocksrc/2");
+  args.push_back("--durl"); args.push_back("mock://mockdest/2");
+  std::string request;
+  for(std::list<std::string>::iterator arg = args.begin(); arg != args.end(); ++arg) {
+    request += *arg; request += '\0';
+  }
+  request += '\0'; request += '\0';
+  for(std::string::size_type pos = 0; pos < request.length(); ++pos) {
+    CPPUNIT_ASSERT_EQUAL(1, run.WriteStdin(10000, request.c_str()+pos, 1));
+  }
+  CPPUNIT_ASSERT(ReadFinalStatus(run, status));
+  CPPUNIT_ASSERT_EQUAL(DataStaging::DataDeliveryComm::CommExited, status.commstatus);
+
+  // Process exits after maximal number of transfers
+  CPPUNIT_ASSERT(run.Wait(30));
+  CPPUNIT_ASSERT_EQUAL(0, run.Result());
+}
+
+void DeliveryTest::TestDeliveryWorkerBadRequest() {
+
+  std::list<std::string> worker_args;
+  worker_args.push_back("../DataStagingDelivery");
+  worker_args.push_back("--worker");
+  Arc::Run run(worker_args);
+  run.KeepStdout(false);
+  run.KeepStderr(true);
+  run.KeepStdin(false);
+  CPPUNIT_ASSERT(run.Start());
+
+  // Unknown option makes process exit without transfer
+  std::list<std::string> args;
+  args.push_back("--surl"); args.push_back("mock://mocksrc/1");
+  args.push_back("--unknown"); args.push_back("value");
+  CPPUNIT_ASSERT(WriteRequest(run, args, ""));
+  CPPUNIT_ASSERT(run.Wait(30));
+  char c;
+  CPPUNIT_ASSERT(run.ReadStdout(1000, &c, 1) <= 0);
+}
+
 CPPUNIT_TEST_SUITE_REGISTRATION(DeliveryTest);
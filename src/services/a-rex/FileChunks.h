@@ -1,3 +1,6 @@
+#ifndef __ARC_AREX_FILECHUNKS_H__
+#define __ARC_AREX_FILECHUNKS_H__
+
 #include <string>
 #include <map>
 
@@ -90,3 +93,4 @@ class FileChunksRef {
 
 } // namespace ARex
 
+#endif // __ARC_AREX_FILECHUNKS_H__
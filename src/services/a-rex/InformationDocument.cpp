@@ -0,0 +1,55 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "InformationDocument.h"
+
+namespace ARex {
+
+static const char creation_attr[] = " CreationTime=\"";
+static const char validity_attr[] = " Validity=\"";
+
+static bool AttributeAt(const char* doc, std::string::size_type size, std::string::size_type pos,
+                        const char* attr, std::string::size_type attr_len) {
+  return ((size - pos) >= attr_len) && (::memcmp(doc + pos, attr, attr_len) == 0);
+}
+
+bool InformationChanged(const char* old_doc, std::string::size_type old_size, time_t old_time,
+                        const char* new_doc, std::string::size_type new_size, time_t now) {
+  const std::string::size_type creation_len = sizeof(creation_attr) - 1;
+  const std::string::size_type validity_len = sizeof(validity_attr) - 1;
+  long validity = -1;
+  std::string::size_type o = 0;
+  std::string::size_type n = 0;
+  while((o < old_size) && (n < new_size)) {
+    if(old_doc[o] != new_doc[n]) return true;
+    if(old_doc[o] == ' ') {
+      if(AttributeAt(old_doc, old_size, o, creation_attr, creation_len) &&
+         AttributeAt(new_doc, new_size, n, creation_attr, creation_len)) {
+        // Values may differ even in length. Closing quotes are compared next.
+        o += creation_len;
+        n += creation_len;
+        while((o < old_size) && (old_doc[o] != '"')) ++o;
+        while((n < new_size) && (new_doc[n] != '"')) ++n;
+        continue;
+      };
+      if(AttributeAt(old_doc, old_size, o, validity_attr, validity_len)) {
+        // Value itself is compared as usual
+        long value = 0;
+        std::string::size_type p = o + validity_len;
+        for(; (p < old_size) && (old_doc[p] >= '0') && (old_doc[p] <= '9'); ++p) {
+          value = value*10 + (old_doc[p] - '0');
+        };
+        if((p > (o + validity_len)) && ((validity < 0) || (value < validity))) validity = value;
+      };
+    };
+    ++o; ++n;
+  };
+  if((o != old_size) || (n != new_size)) return true;
+  if((validity >= 0) && ((now - old_time) >= (validity / 2))) return true;
+  return false;
+}
+
+} // namespace ARex
@@ -0,0 +1,21 @@
+#ifndef __ARC_AREX_INFORMATIONDOCUMENT_H__
+#define __ARC_AREX_INFORMATIONDOCUMENT_H__
+
+#include <string>
+
+#include <time.h>
+
+namespace ARex {
+
+/// Checks if document produced by information provider differs from published one.
+/** CreationTime attributes are set to time of every run of provider and
+  hence are not compared. But document is still reported as changed once
+  published one gets older than half of smallest Validity found in it.
+  Otherwise published information would expire while being up to date.
+  Documents are compared as text without parsing them. */
+bool InformationChanged(const char* old_doc, std::string::size_type old_size, time_t old_time,
+                        const char* new_doc, std::string::size_type new_size, time_t now);
+
+} // namespace ARex
+
+#endif // __ARC_AREX_INFORMATIONDOCUMENT_H__
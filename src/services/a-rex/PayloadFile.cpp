@@ -242,6 +242,23 @@ Arc::MessagePayload* newFileRead(int h,Arc::PayloadRawInterface::Size_t start,Ar
 }
 
 Arc::MessagePayload* newFileRead(Arc::FileAccess* h,Arc::PayloadRawInterface::Size_t start,Arc::PayloadRawInterface::Size_t end) {
+  // If possible serve file directly instead of passing it through proxy.
+  // That also allows sending it with sendfile() later.
+  int fh = h->fa_reopen();
+  if(fh != -1) {
+    struct stat st;
+    if(::fstat(fh,&st) != 0) {
+      // newFileRead() does not take handle it can't stat
+      ::close(fh);
+    } else {
+      // On failure handle is closed by newFileRead()
+      Arc::MessagePayload* f = newFileRead(fh,start,end);
+      if(f) {
+        h->fa_close(); Arc::FileAccess::Release(h);
+        return f;
+      };
+    };
+  };
   PayloadFAFile* f = new PayloadFAFile(h,start,end);
   return f;
 }
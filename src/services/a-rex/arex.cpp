@@ -29,6 +29,8 @@
 #include "grid-manager/run/RunPlugin.h"
 #include "grid-manager/jobs/ContinuationPlugins.h"
 #include "grid-manager/files/ControlFileHandling.h"
+#include "grid-manager/files/JobStateIndex.h"
+#include "grid-manager/files/JobStateJournal.h"
 #include "arex.h"
 
 namespace ARex {
@@ -1057,7 +1059,7 @@ ARexService::ARexService(Arc::Config *cfg,Arc::PluginArgument *parg):Arc::Servic
               infoprovider_wakeup_period_(0),
               all_jobs_count_(0),
               gm_(NULL),
-              rest_(cfg, parg, config_, delegation_stores_, all_jobs_count_) {
+              rest_(cfg, parg, config_, delegation_stores_, all_jobs_count_, infodoc_) {
   valid = false;
   config_.SetJobLog(new JobLog());
   config_.SetJobsMetrics(new JobsMetrics());
@@ -1065,6 +1067,7 @@ ARexService::ARexService(Arc::Config *cfg,Arc::PluginArgument *parg):Arc::Servic
   config_.SetSpaceMetrics(new SpaceMetrics());
   config_.SetJobPerfLog(new Arc::JobPerfLog());
   config_.SetContPlugins(new ContinuationPlugins());
+  config_.SetJobStateIndex(new JobStateIndex());
   // logger_.addDestination(logcerr);
   // Obtain information from configuration
 
@@ -1149,6 +1152,15 @@ ARexService::ARexService(Arc::Config *cfg,Arc::PluginArgument *parg):Arc::Servic
   };
   datalimit_.MaxConsumers(valuei);
 
+  // Journal is only consistent if all state changes are made by this process
+  if (gmrun_.empty() || gmrun_ == "internal") {
+    JobStateJournal* journal = new JobStateJournal(config_.ControlDir());
+    if (!journal->Open()) {
+      logger_.msg(Arc::WARNING, "Failed to open job state journal in %s - jobs will be scanned at next start", config_.ControlDir());
+    }
+    config_.SetJobStateJournal(journal);
+  }
+
   // If WS interface is enabled and multiple log files are configured then here
   // the log splits between WS interface operations and GM job processing.
   // Start separate thread to start GM and info collector threads so they can
@@ -1182,6 +1194,8 @@ ARexService::~ARexService(void) {
   delete config_.GetJobsMetrics();
   delete config_.GetHeartBeatMetrics();
   delete config_.GetSpaceMetrics();
+  delete config_.GetJobStateIndex();
+  delete config_.GetJobStateJournal();
 }
 
 } // namespace ARex
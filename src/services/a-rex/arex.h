@@ -1,6 +1,8 @@
 #ifndef __ARC_AREX_H__
 #define __ARC_AREX_H__
 
+#include <map>
+
 #include <arc/message/PayloadRaw.h>
 #include <arc/delegation/DelegationInterface.h>
 #include <arc/infosys/InformationInterface.h>
@@ -35,19 +37,51 @@ class CountedResource {
   void Release(void);
 };
 
+/// Version of informational document which is never modified once published.
+/** Readers keep a reference while using it and new documents replace it
+  as a whole, hence readers need no locking. Derived representations of
+  document are made on demand and kept together with it. */
+class InformationSnapshot {
+ friend class OptimizedInformationContainer;
+ private:
+  Glib::Mutex lock_;
+  int refs_;
+  int handle_;
+  Arc::XMLNode doc_;
+  std::map<int,std::string> rendered_;
+  InformationSnapshot(int handle, Arc::XMLNode& doc);
+  InformationSnapshot(const InformationSnapshot&);
+  ~InformationSnapshot(void);
+ public:
+  /// Returns new handle of file with document as produced by information provider
+  int Open(void) const;
+  /// Parsed document. It must not be modified.
+  Arc::XMLNode Document(void) const { return doc_; }
+  /// Returns document converted by renderer. Conversion is done once per format.
+  const std::string& Rendered(int format, void (*renderer)(Arc::XMLNode xml, int format, std::string& output));
+  void Acquire(void);
+  void Release(void);
+};
+
 class OptimizedInformationContainer: public Arc::InformationContainer {
  private:
   bool parse_xml_;
   std::string filename_;
-  int handle_;
-  Arc::XMLNode doc_;
+  InformationSnapshot* snapshot_;
   Glib::Mutex olock_;
  public:
   OptimizedInformationContainer(bool parse_xml = true);
   ~OptimizedInformationContainer(void);
   int OpenDocument(void);
+  /// Returns current document or NULL. Must be released with InformationSnapshot::Release().
+  InformationSnapshot* AcquireSnapshot(void);
   void AssignFile(const std::string& filename);
   void Assign(const std::string& xml,const std::string filename = "");
+  /// Publishes document stored in file tmpfilename and opened as handle.
+  /** File is renamed to filename. Handle and parsed doc are taken over by container. */
+  bool Assign(int handle,const std::string& tmpfilename,const std::string& filename,Arc::XMLNode& doc);
+  /// Creates temporary file for document to be published with Assign().
+  static int CreateDocument(const std::string& filename,std::string& tmpfilename);
 };
 
 #define AREXOP(NAME) Arc::MCC_Status NAME(ARexGMConfig& config,Arc::XMLNode in,Arc::XMLNode out)
@@ -45,6 +45,16 @@ namespace ARex {
          * write record about job state change to accounting log 
          **/
         virtual bool addJobEvent(aar_jobevent_t& events, const std::string& jobid) = 0;
+        /// Start group of write operations
+        /**
+         * Records written after this call and up to commitBatch() may be
+         * stored in the database as single transaction.
+         * Default implementation does not support grouping.
+         * @return true if grouping was started
+         **/
+        virtual bool beginBatch(void) { return false; }
+        /// Store all records written since beginBatch()
+        virtual bool commitBatch(void) { return true; }
     protected:
         const std::string name;
         bool isValid;
@@ -3,15 +3,25 @@
 #endif
 
 #include <unistd.h>
+#include <list>
+#include <map>
+#include <arc/DateTime.h>
+#include <arc/Logger.h>
 #include <arc/Utils.h>
 
 #include "AccountingDBAsync.h"
 
 namespace ARex {
+  static Arc::Logger logger(Arc::Logger::getRootLogger(), "AccountingDBAsync");
+
   class AccountingDBThread: public Arc::Thread {
    friend class AccountingDBAsync;
    public:
     static const std::size_t MaxQueueDepth = 10000;
+    // Maximal number of events stored in one transaction
+    static const std::size_t MaxBatchSize = 1000;
+    // Maximal time (ms) events may wait in open transaction
+    static const int FlushInterval = 1000;
 
     static AccountingDBThread& Instance();
     bool Push(AccountingDBAsync::Event* event);
@@ -20,6 +30,13 @@ namespace ARex {
     AccountingDBThread();
     virtual ~AccountingDBThread();
     void thread();
+    // Events stored in open transaction of every database. They are kept
+    // till transaction is committed to be able to store them again if
+    // commit fails.
+    typedef std::map< AccountingDB*,std::list<AccountingDBAsync::Event*> > Batches;
+
+    bool process(AccountingDB& db, AccountingDBAsync::Event& event);
+    void commit(Batches& batched);
 
     Arc::SimpleCondition lock_;
     AccountingDBThread* instance_;
@@ -57,37 +74,93 @@ namespace ARex {
     return true;
   }
 
+  bool AccountingDBThread::process(AccountingDB& db, AccountingDBAsync::Event& event) {
+    AccountingDBAsync::EventCreateAAR* eventCreateAAR = dynamic_cast<AccountingDBAsync::EventCreateAAR*>(&event);
+    if(eventCreateAAR) {
+      return db.createAAR(eventCreateAAR->aar);
+    };
+    AccountingDBAsync::EventUpdateAAR* eventUpdateAAR = dynamic_cast<AccountingDBAsync::EventUpdateAAR*>(&event);
+    if(eventUpdateAAR) {
+      return db.updateAAR(eventUpdateAAR->aar);
+    };
+    AccountingDBAsync::EventAddJobEvent* eventAddJobEvent = dynamic_cast<AccountingDBAsync::EventAddJobEvent*>(&event);
+    if(eventAddJobEvent) {
+      return db.addJobEvent(eventAddJobEvent->events, eventAddJobEvent->jobid);
+    };
+    return false;
+  }
+
+  void AccountingDBThread::commit(Batches& batched) {
+    for(Batches::iterator db = batched.begin(); db != batched.end(); ++db) {
+      std::list<AccountingDBAsync::Event*>& events = db->second;
+      if(!db->first->commitBatch()) {
+        // Transaction is rolled back. Store events one by one so that only
+        // those which can't be stored at all are lost.
+        logger.msg(Arc::WARNING, "Storing %u accounting events separately after failed transaction",
+                   (unsigned int)events.size());
+        for(std::list<AccountingDBAsync::Event*>::iterator event = events.begin(); event != events.end(); ++event) {
+          if(!process(*(db->first), **event))
+            logger.msg(Arc::ERROR, "Failed to store accounting event for database %s", (*event)->name);
+        };
+      };
+      while(!events.empty()) { delete events.front(); events.pop_front(); };
+    };
+    batched.clear();
+  }
+
   void AccountingDBThread::thread() {
+    // Events are stored in transactions spanning many events. Transaction is
+    // committed when queue is drained and no new events arrive within
+    // FlushInterval since its start, or when it holds MaxBatchSize events.
+    Batches batched;
+    std::size_t batchSize = 0;
+    Arc::Time batchStart;
     while(true) {
       Arc::AutoLock<Arc::SimpleCondition> lock(lock_);
       if(queue_.empty()) {
-        lock_.wait_nonblock();
-        if(queue_.empty()) continue;
+        if(batched.empty()) {
+          lock_.wait_nonblock();
+          continue;
+        };
+        Arc::Period age = Arc::Time() - batchStart;
+        int left = FlushInterval - (int)(age.GetPeriod()*1000 + age.GetPeriodNanoseconds()/1000000);
+        if(left > 0) {
+          lock.unlock();
+          (void)lock_.wait(left);
+          continue;
+        };
+        lock.unlock();
+        commit(batched);
+        batchSize = 0;
+        continue;
       }
       Arc::AutoPointer<AccountingDBAsync::Event> event(queue_.front());
       queue_.pop_front();
       AccountingDBAsync::EventQuit* eventQuit = dynamic_cast<AccountingDBAsync::EventQuit*>(event.Ptr());
-      if(eventQuit) break;
+      if(eventQuit) {
+        lock.unlock();
+        commit(batched);
+        break;
+      };
       std::map< std::string,Arc::AutoPointer<AccountingDB> >::iterator db = dbs_.find(event->name);
       if(db == dbs_.end()) continue; // not expected
       lock.unlock(); // no need to keep lock anymore - db and event are picked up
 
-      AccountingDBAsync::EventCreateAAR* eventCreateAAR = dynamic_cast<AccountingDBAsync::EventCreateAAR*>(event.Ptr());
-      if(eventCreateAAR) {
-        db->second->createAAR(eventCreateAAR->aar);
-        continue;
-      };
-      AccountingDBAsync::EventUpdateAAR* eventUpdateAAR = dynamic_cast<AccountingDBAsync::EventUpdateAAR*>(event.Ptr());
-      if(eventUpdateAAR) {
-        db->second->updateAAR(eventUpdateAAR->aar);
-        continue;
+      Batches::iterator batch = batched.find(db->second.Ptr());
+      if(batch == batched.end()) {
+        if(db->second->beginBatch()) {
+          if(batched.empty()) batchStart = Arc::Time();
+          batch = batched.insert(std::make_pair(db->second.Ptr(), std::list<AccountingDBAsync::Event*>())).first;
+        };
       };
-      AccountingDBAsync::EventAddJobEvent* eventAddJobEvent = dynamic_cast<AccountingDBAsync::EventAddJobEvent*>(event.Ptr());
-      if(eventAddJobEvent) {
-        db->second->addJobEvent(eventAddJobEvent->events, eventAddJobEvent->jobid);
-        continue;
+      (void)process(*(db->second), *event);
+      if(batch != batched.end()) batch->second.push_back(event.Release());
+      if(++batchSize >= MaxBatchSize) {
+        commit(batched);
+        batchSize = 0;
       };
     };
+    exited_ = true;
   }
 
 
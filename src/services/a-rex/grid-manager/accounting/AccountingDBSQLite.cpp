@@ -28,6 +28,43 @@ namespace ARex {
         return err;
     }
 
+    sqlite3_stmt* AccountingDBSQLite::SQLiteDB::prepare(const std::string& sql) {
+        if (!aDB) return NULL;
+        std::map<std::string, sqlite3_stmt*>::iterator it = statements.find(sql);
+        if (it != statements.end()) return it->second;
+        sqlite3_stmt* stmt = NULL;
+        int err;
+        while((err = sqlite3_prepare_v2(aDB, sql.c_str(), sql.length()+1, &stmt, NULL)) == SQLITE_BUSY) {
+            struct timespec delay = { 0, 10000000 }; // 0.01s - should be enough for most cases
+            (void)::nanosleep(&delay, NULL);
+        };
+        if (err != SQLITE_OK) {
+            logError("Failed to prepare SQL statement", err, Arc::ERROR);
+            AccountingDBSQLite::logger.msg(Arc::DEBUG, "SQL statement used: %s", sql);
+            if (stmt) (void)sqlite3_finalize(stmt);
+            return NULL;
+        }
+        statements[sql] = stmt;
+        return stmt;
+    }
+
+    int AccountingDBSQLite::SQLiteDB::step(sqlite3_stmt* stmt) {
+        int err;
+        while((err = sqlite3_step(stmt)) == SQLITE_BUSY) {
+            // Same as in exec() - lock is expected to be released soon
+            struct timespec delay = { 0, 10000000 }; // 0.01s - should be enough for most cases
+            (void)::nanosleep(&delay, NULL);
+        };
+        // Keep statement positioned on the row till caller processes it
+        if (err != SQLITE_ROW) reset(stmt);
+        return err;
+    }
+
+    void AccountingDBSQLite::SQLiteDB::reset(sqlite3_stmt* stmt) {
+        (void)sqlite3_reset(stmt);
+        (void)sqlite3_clear_bindings(stmt);
+    }
+
     AccountingDBSQLite::SQLiteDB::SQLiteDB(const std::string& name, bool create): aDB(NULL) {
         if (aDB != NULL) return; // already open
 
@@ -84,6 +121,10 @@ namespace ARex {
     }
 
     void AccountingDBSQLite::SQLiteDB::closeDB(void) {
+        for (std::map<std::string, sqlite3_stmt*>::iterator it = statements.begin(); it != statements.end(); ++it) {
+            (void)sqlite3_finalize(it->second);
+        }
+        statements.clear();
         if (aDB) {
             (void)sqlite3_close(aDB); // TODO: handle errors?
             aDB = NULL;
@@ -94,7 +135,8 @@ namespace ARex {
         closeDB();
     }
 
-    AccountingDBSQLite::AccountingDBSQLite(const std::string& name) : AccountingDB(name), db(NULL) {
+    AccountingDBSQLite::AccountingDBSQLite(const std::string& name, bool wal) :
+        AccountingDB(name), db(NULL), wal(wal), inbatch(false) {
         isValid = false;
         // check database file exists
         if (!Glib::file_test(name, Glib::FILE_TEST_EXISTS)) {
@@ -119,6 +161,7 @@ namespace ARex {
                 closeSQLiteDB();
                 return;
             }
+            setJournalMode();
             isValid = true;
             return;
         } else if (!Glib::file_test(name, Glib::FILE_TEST_IS_REGULAR)) {
@@ -133,9 +176,22 @@ namespace ARex {
             return;
         }
         // TODO: implement schema version checking and possible updates
+        Glib::Mutex::Lock lock(lock_);
+        setJournalMode();
         isValid = true;
     }
 
+    void AccountingDBSQLite::setJournalMode(void) {
+        // Journal mode is stored in the database file, so it is always set
+        // explicitly to follow the configuration
+        const char* sql = wal ? "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;"
+                              : "PRAGMA journal_mode=DELETE;";
+        int err = db->exec(sql, NULL, NULL, NULL);
+        if (err != SQLITE_OK) {
+            db->logError("Failed to set accounting database journal mode", err, Arc::WARNING);
+        }
+    }
+
     // init DB connection for multiple usages
     void AccountingDBSQLite::initSQLiteDB(void) {
         // already initialized
@@ -156,21 +212,28 @@ namespace ARex {
         closeSQLiteDB();
     }
 
-    // perform insert query and return
+    void AccountingDBSQLite::SQLBind(sqlite3_stmt* stmt, int idx, const std::string& value) {
+        if (stmt) (void)sqlite3_bind_text(stmt, idx, value.c_str(), value.length(), SQLITE_TRANSIENT);
+    }
+
+    void AccountingDBSQLite::SQLBind(sqlite3_stmt* stmt, int idx, sqlite3_int64 value) {
+        if (stmt) (void)sqlite3_bind_int64(stmt, idx, value);
+    }
+
+    // perform prepared insert query and return
     //  0 - failure
     //  id - autoincrement id of the inserted raw
-    unsigned int AccountingDBSQLite::GeneralSQLInsert(const std::string& sql) {
-        if (!isValid) return 0;
-        initSQLiteDB();
-        Glib::Mutex::Lock lock(lock_);
-        int err;
-        err = db->exec(sql.c_str(), NULL, NULL, NULL);
-        if (err != SQLITE_OK) {
+    unsigned int AccountingDBSQLite::GeneralSQLInsert(sqlite3_stmt* stmt) {
+        if (!isValid || !stmt) return 0;
+        int err = db->step(stmt);
+        if (err != SQLITE_DONE) {
+            if (err == SQLITE_ROW) db->reset(stmt);
             if (err == SQLITE_CONSTRAINT) {
                 db->logError("It seams record exists already", err, Arc::ERROR);
             } else {
                 db->logError("Failed to insert data into database", err, Arc::ERROR);
             }
+            logger.msg(Arc::DEBUG, "SQL statement used: %s", sqlite3_sql(stmt));
             return 0;
         }
         if(db->changes() < 1) {
@@ -180,18 +243,72 @@ namespace ARex {
         return (unsigned int) newid;
     }
 
-    // perform update query
-    bool AccountingDBSQLite::GeneralSQLUpdate(const std::string& sql) {
+    // perform prepared update query
+    bool AccountingDBSQLite::GeneralSQLUpdate(sqlite3_stmt* stmt) {
+        if (!isValid || !stmt) return false;
+        int err = db->step(stmt);
+        if (err != SQLITE_DONE) {
+            if (err == SQLITE_ROW) db->reset(stmt);
+            db->logError("Failed to update data in the database", err, Arc::ERROR);
+            logger.msg(Arc::DEBUG, "SQL statement used: %s", sqlite3_sql(stmt));
+            return false;
+        }
+        if(db->changes() < 1) {
+            return false;
+        }
+        return true;
+    }
+
+    bool AccountingDBSQLite::beginGroup(void) {
+        int err = db->exec("SAVEPOINT AccountingGroup", NULL, NULL, NULL);
+        if (err != SQLITE_OK) {
+            db->logError("Failed to start accounting database savepoint", err, Arc::ERROR);
+            return false;
+        }
+        return true;
+    }
+
+    bool AccountingDBSQLite::endGroup(bool success) {
+        if (!success) (void)db->exec("ROLLBACK TO AccountingGroup", NULL, NULL, NULL);
+        int err = db->exec("RELEASE AccountingGroup", NULL, NULL, NULL);
+        if (err != SQLITE_OK) {
+            db->logError("Failed to release accounting database savepoint", err, Arc::ERROR);
+            return false;
+        }
+        return success;
+    }
+
+    bool AccountingDBSQLite::beginBatch(void) {
         if (!isValid) return false;
         initSQLiteDB();
         Glib::Mutex::Lock lock(lock_);
-        int err;
-        err = db->exec(sql.c_str(), NULL, NULL, NULL);
-        if (err != SQLITE_OK ) {
-            db->logError("Failed to update data in the database", err, Arc::ERROR);
+        if (inbatch) return true;
+        // Take write lock immediately to avoid deadlock while upgrading it
+        // in the middle of transaction
+        int err = db->exec("BEGIN IMMEDIATE TRANSACTION", NULL, NULL, NULL);
+        if (err != SQLITE_OK) {
+            db->logError("Failed to start accounting database transaction", err, Arc::ERROR);
             return false;
         }
-        if(db->changes() < 1) {
+        inbatch = true;
+        return true;
+    }
+
+    bool AccountingDBSQLite::commitBatch(void) {
+        if (!isValid) return false;
+        Glib::Mutex::Lock lock(lock_);
+        if (!inbatch) return true;
+        inbatch = false;
+        int err = db->exec("COMMIT TRANSACTION", NULL, NULL, NULL);
+        if (err != SQLITE_OK) {
+            db->logError("Failed to commit accounting database transaction", err, Arc::ERROR);
+            (void)db->exec("ROLLBACK TRANSACTION", NULL, NULL, NULL);
+            // cached IDs may refer to records which were not stored
+            db_queue.clear();
+            db_users.clear();
+            db_wlcgvos.clear();
+            db_status.clear();
+            db_endpoints.clear();
             return false;
         }
         return true;
@@ -246,8 +363,9 @@ namespace ARex {
             return it->second;
         } else {
             // if not found - create the new record in the database
-            std::string sql = "INSERT INTO " + sql_escape(table) + " (Name) VALUES ('" + sql_escape(iname) + "')";
-            unsigned int newid = GeneralSQLInsert(sql);
+            sqlite3_stmt* stmt = db->prepare("INSERT INTO " + sql_escape(table) + " (Name) VALUES (?)");
+            SQLBind(stmt, 1, sql_escape(iname));
+            unsigned int newid = GeneralSQLInsert(stmt);
             if ( newid ) {
                 name_id_map->insert(std::pair <std::string, unsigned int>(iname, newid));
                 return newid;
@@ -322,8 +440,10 @@ namespace ARex {
             return it->second;
         } else {
             // if not found - create the new record in the database
-            std::string sql = "INSERT INTO Endpoints (Interface, URL) VALUES ('" + sql_escape(endpoint.interface) + "', '" + sql_escape(endpoint.url) +"')";
-            unsigned int newid = GeneralSQLInsert(sql);
+            sqlite3_stmt* stmt = db->prepare("INSERT INTO Endpoints (Interface, URL) VALUES (?, ?)");
+            SQLBind(stmt, 1, sql_escape(endpoint.interface));
+            SQLBind(stmt, 2, sql_escape(endpoint.url));
+            unsigned int newid = GeneralSQLInsert(stmt);
             if ( newid ) {
                 db_endpoints.insert(std::pair <aar_endpoint_t, unsigned int>(endpoint, newid));
                 return newid;
@@ -334,26 +454,20 @@ namespace ARex {
         return 0;
     }
     
-    // callback to get id from database table
-    static int ReadIdCallback(void* arg, int colnum, char** texts, char** names) {
-        unsigned int* dbid = static_cast<unsigned int*>(arg);
-        for (int n = 0; n < colnum; ++n) {
-            if (names[n] && texts[n]) {
-                int id;
-                sql_unescape(texts[n], id);
-                *dbid = id;
-            }
-        }
-        return 0;
-    }
-
     // AAR processing
     unsigned int AccountingDBSQLite::getAARDBId(const AAR& aar) {
         if (!isValid) return 0;
         initSQLiteDB();
+        sqlite3_stmt* stmt = db->prepare("SELECT RecordID FROM AAR WHERE JobID = ?");
+        if (!stmt) return 0;
+        SQLBind(stmt, 1, sql_escape(aar.jobid));
         unsigned int dbid = 0;
-        std::string sql = "SELECT RecordID FROM AAR WHERE JobID = '" + sql_escape(aar.jobid) + "'";
-        if (db->exec(sql.c_str(), &ReadIdCallback, &dbid, NULL) != SQLITE_OK ) {
+        int err = db->step(stmt);
+        if (err == SQLITE_ROW) {
+            dbid = (unsigned int) sqlite3_column_int64(stmt, 0);
+            db->reset(stmt);
+        } else if (err != SQLITE_DONE) {
+            db->logError(NULL, err, Arc::DEBUG);
             logger.msg(Arc::ERROR, "Failed to query AAR database ID for job %s", aar.jobid);
             return 0;
         }
@@ -369,6 +483,7 @@ namespace ARex {
     bool AccountingDBSQLite::createAAR(AAR& aar) {
         if (!isValid) return false;
         initSQLiteDB();
+        Glib::Mutex::Lock lock(lock_);
         // get the corresponding IDs in connected tables
         unsigned int endpointid = getDBEndpointId(aar.endpoint);
         if (!endpointid) return false;
@@ -380,37 +495,36 @@ namespace ARex {
         if (!wlcgvoid) return false;
         unsigned int statusid = getDBStatusId(aar.status);
         if (!statusid) return false;
-        // construct insert statement
-        std::string sql = "INSERT INTO AAR ("
+        // prepare insert statement
+        sqlite3_stmt* stmt = db->prepare("INSERT INTO AAR ("
             "JobID, LocalJobID, EndpointID, QueueID, UserID, VOID, StatusID, ExitCode, "
             "SubmitTime, EndTime, NodeCount, CPUCount, UsedMemory, UsedVirtMem, UsedWalltime, "
             "UsedCPUUserTime, UsedCPUKernelTime, UsedScratch, StageInVolume, StageOutVolume ) "
-            "VALUES ('" +
-                sql_escape(aar.jobid) + "', '" +
-                sql_escape(aar.localid) + "', " +
-                sql_escape(endpointid) + ", " + 
-                sql_escape(queueid) + ", " + 
-                sql_escape(userid) + ", " + 
-                sql_escape(wlcgvoid) + ", " + 
-                sql_escape(statusid) + ", " +
-                sql_escape(aar.exitcode) + ", " +
-                sql_escape(aar.submittime.GetTime()) + ", " + 
-                sql_escape(aar.endtime.GetTime()) + ", " +
-                sql_escape(aar.nodecount) + ", " + 
-                sql_escape(aar.cpucount) + ", " + 
-                sql_escape(aar.usedmemory) + ", " + 
-                sql_escape(aar.usedvirtmemory) + ", " +
-                sql_escape(aar.usedwalltime) + ", " + 
-                sql_escape(aar.usedcpuusertime) + ", " + 
-                sql_escape(aar.usedcpukerneltime) + ", " +
-                sql_escape(aar.usedscratch) + ", " + 
-                sql_escape(aar.stageinvolume) + ", " + 
-                sql_escape(aar.stageoutvolume) +
-            ")";
-        unsigned int recordid = GeneralSQLInsert(sql);
+            "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+        if (!stmt) return false;
+        SQLBind(stmt, 1, sql_escape(aar.jobid));
+        SQLBind(stmt, 2, sql_escape(aar.localid));
+        SQLBind(stmt, 3, (sqlite3_int64) endpointid);
+        SQLBind(stmt, 4, (sqlite3_int64) queueid);
+        SQLBind(stmt, 5, (sqlite3_int64) userid);
+        SQLBind(stmt, 6, (sqlite3_int64) wlcgvoid);
+        SQLBind(stmt, 7, (sqlite3_int64) statusid);
+        SQLBind(stmt, 8, (sqlite3_int64) aar.exitcode);
+        SQLBind(stmt, 9, (sqlite3_int64) aar.submittime.GetTime());
+        SQLBind(stmt, 10, (sqlite3_int64) aar.endtime.GetTime());
+        SQLBind(stmt, 11, (sqlite3_int64) aar.nodecount);
+        SQLBind(stmt, 12, (sqlite3_int64) aar.cpucount);
+        SQLBind(stmt, 13, (sqlite3_int64) aar.usedmemory);
+        SQLBind(stmt, 14, (sqlite3_int64) aar.usedvirtmemory);
+        SQLBind(stmt, 15, (sqlite3_int64) aar.usedwalltime);
+        SQLBind(stmt, 16, (sqlite3_int64) aar.usedcpuusertime);
+        SQLBind(stmt, 17, (sqlite3_int64) aar.usedcpukerneltime);
+        SQLBind(stmt, 18, (sqlite3_int64) aar.usedscratch);
+        SQLBind(stmt, 19, (sqlite3_int64) aar.stageinvolume);
+        SQLBind(stmt, 20, (sqlite3_int64) aar.stageoutvolume);
+        unsigned int recordid = GeneralSQLInsert(stmt);
         if (!recordid) {
             logger.msg(Arc::ERROR, "Failed to insert AAR into the database for job %s", aar.jobid);
-            logger.msg(Arc::DEBUG, "SQL statement used: %s", sql);
             return false;
         }
         // insert authtoken attributes
@@ -427,6 +541,7 @@ namespace ARex {
     bool AccountingDBSQLite::updateAAR(AAR& aar) {
         if (!isValid) return false;
         initSQLiteDB();
+        Glib::Mutex::Lock lock(lock_);
         // get AAR ID in the database
         unsigned int recordid = getAARDBId(aar);
         if (!recordid) {
@@ -436,28 +551,32 @@ namespace ARex {
         // get the corresponding IDs in connected tables
         unsigned int statusid = getDBStatusId(aar.status);
         
-        // construct update statement 
+        // prepare update statement 
         // NOTE: it only make sense update the dynamic information not available on submission time
-        std::string sql = "UPDATE AAR SET "
-            "LocalJobID = '" + sql_escape(aar.localid) + "', " +
-            "StatusID = " + sql_escape(statusid) + ", " +
-            "ExitCode = " + sql_escape(aar.exitcode) + ", " +
-            "EndTime = " + sql_escape(aar.endtime.GetTime()) + ", " +
-            "NodeCount = " + sql_escape(aar.nodecount) + ", " + 
-            "CPUCount = " + sql_escape(aar.cpucount) + ", " + 
-            "UsedMemory = " + sql_escape(aar.usedmemory) + ", " + 
-            "UsedVirtMem = " + sql_escape(aar.usedvirtmemory) + ", " +
-            "UsedWalltime = " + sql_escape(aar.usedwalltime) + ", " + 
-            "UsedCPUUserTime = " + sql_escape(aar.usedcpuusertime) + ", " + 
-            "UsedCPUKernelTime = " + sql_escape(aar.usedcpukerneltime) + ", " +
-            "UsedScratch = " + sql_escape(aar.usedscratch) + ", " + 
-            "StageInVolume = " + sql_escape(aar.stageinvolume) + ", " + 
-            "StageOutVolume = " + sql_escape(aar.stageoutvolume) + " " +
-            "WHERE RecordId = " + sql_escape(recordid);
+        sqlite3_stmt* stmt = db->prepare("UPDATE AAR SET "
+            "LocalJobID = ?, StatusID = ?, ExitCode = ?, EndTime = ?, NodeCount = ?, CPUCount = ?, "
+            "UsedMemory = ?, UsedVirtMem = ?, UsedWalltime = ?, UsedCPUUserTime = ?, UsedCPUKernelTime = ?, "
+            "UsedScratch = ?, StageInVolume = ?, StageOutVolume = ? "
+            "WHERE RecordId = ?");
+        if (!stmt) return false;
+        SQLBind(stmt, 1, sql_escape(aar.localid));
+        SQLBind(stmt, 2, (sqlite3_int64) statusid);
+        SQLBind(stmt, 3, (sqlite3_int64) aar.exitcode);
+        SQLBind(stmt, 4, (sqlite3_int64) aar.endtime.GetTime());
+        SQLBind(stmt, 5, (sqlite3_int64) aar.nodecount);
+        SQLBind(stmt, 6, (sqlite3_int64) aar.cpucount);
+        SQLBind(stmt, 7, (sqlite3_int64) aar.usedmemory);
+        SQLBind(stmt, 8, (sqlite3_int64) aar.usedvirtmemory);
+        SQLBind(stmt, 9, (sqlite3_int64) aar.usedwalltime);
+        SQLBind(stmt, 10, (sqlite3_int64) aar.usedcpuusertime);
+        SQLBind(stmt, 11, (sqlite3_int64) aar.usedcpukerneltime);
+        SQLBind(stmt, 12, (sqlite3_int64) aar.usedscratch);
+        SQLBind(stmt, 13, (sqlite3_int64) aar.stageinvolume);
+        SQLBind(stmt, 14, (sqlite3_int64) aar.stageoutvolume);
+        SQLBind(stmt, 15, (sqlite3_int64) recordid);
         // run update
-        if (!GeneralSQLUpdate(sql)) {
+        if (!GeneralSQLUpdate(stmt)) {
             logger.msg(Arc::ERROR, "Failed to update AAR in the database for job %s", aar.jobid);
-            logger.msg(Arc::DEBUG, "SQL statement used: %s", sql);
             return false;
         }
         // write RTE info
@@ -481,98 +600,91 @@ namespace ARex {
 
     bool AccountingDBSQLite::writeRTEs(std::list <std::string>& rtes, unsigned int recordid) {
         if (rtes.empty()) return true;
-        std::string sql = "BEGIN TRANSACTION; ";
-        std::string sql_base = "INSERT INTO RunTimeEnvironments (RecordID, RTEName) VALUES ";
-        for (std::list<std::string>::iterator it=rtes.begin(); it != rtes.end(); ++it) {
-            sql += sql_base + "(" + sql_escape(recordid) + ", '" + sql_escape(*it) + "'); ";
-        }
-        sql += "COMMIT;";
-        if(!GeneralSQLInsert(sql)) {
-            logger.msg(Arc::DEBUG, "SQL statement used: %s", sql);
-            return false;
+        sqlite3_stmt* stmt = db->prepare("INSERT INTO RunTimeEnvironments (RecordID, RTEName) VALUES (?, ?)");
+        if (!stmt || !beginGroup()) return false;
+        bool r = true;
+        for (std::list<std::string>::iterator it=rtes.begin(); r && (it != rtes.end()); ++it) {
+            SQLBind(stmt, 1, (sqlite3_int64) recordid);
+            SQLBind(stmt, 2, sql_escape(*it));
+            if (!GeneralSQLInsert(stmt)) r = false;
         }
-        return true;
+        return endGroup(r);
     }
 
     bool AccountingDBSQLite::writeAuthTokenAttrs(std::list <aar_authtoken_t>& attrs, unsigned int recordid) {
         if (attrs.empty()) return true;
-        std::string sql = "BEGIN TRANSACTION; ";
-        std::string sql_base = "INSERT INTO AuthTokenAttributes (RecordID, AttrKey, AttrValue) VALUES ";
-        for (std::list <aar_authtoken_t>::iterator it=attrs.begin(); it!=attrs.end(); ++it) {
-            sql += sql_base + "(" + sql_escape(recordid) + ", '" + sql_escape(it->first) + "', '" +
-                   sql_escape(it->second) + "'); ";
-        }
-        sql += "COMMIT;";
-        if(!GeneralSQLInsert(sql)) {
-            logger.msg(Arc::DEBUG, "SQL statement used: %s", sql);
-            return false;
+        sqlite3_stmt* stmt = db->prepare("INSERT INTO AuthTokenAttributes (RecordID, AttrKey, AttrValue) VALUES (?, ?, ?)");
+        if (!stmt || !beginGroup()) return false;
+        bool r = true;
+        for (std::list <aar_authtoken_t>::iterator it=attrs.begin(); r && (it!=attrs.end()); ++it) {
+            SQLBind(stmt, 1, (sqlite3_int64) recordid);
+            SQLBind(stmt, 2, sql_escape(it->first));
+            SQLBind(stmt, 3, sql_escape(it->second));
+            if (!GeneralSQLInsert(stmt)) r = false;
         }
-        return true;
+        return endGroup(r);
     }
 
     bool AccountingDBSQLite::writeExtraInfo(std::map <std::string, std::string>& info, unsigned int recordid) {
         if (info.empty()) return true;
-        std::string sql = "BEGIN TRANSACTION; ";
-        std::string sql_base = "INSERT INTO JobExtraInfo (RecordID, InfoKey, InfoValue) VALUES ";
-        for (std::map<std::string,std::string>::iterator it=info.begin(); it!=info.end(); ++it) {
-            sql += sql_base + "(" + sql_escape(recordid) + ", '" + sql_escape(it->first) + "', '" +
-                   sql_escape(it->second) + "'); ";
-        }
-        sql += "COMMIT;";
-        if(!GeneralSQLInsert(sql)) {
-            logger.msg(Arc::DEBUG, "SQL statement used: %s", sql);
-            return false;
+        sqlite3_stmt* stmt = db->prepare("INSERT INTO JobExtraInfo (RecordID, InfoKey, InfoValue) VALUES (?, ?, ?)");
+        if (!stmt || !beginGroup()) return false;
+        bool r = true;
+        for (std::map<std::string,std::string>::iterator it=info.begin(); r && (it!=info.end()); ++it) {
+            SQLBind(stmt, 1, (sqlite3_int64) recordid);
+            SQLBind(stmt, 2, sql_escape(it->first));
+            SQLBind(stmt, 3, sql_escape(it->second));
+            if (!GeneralSQLInsert(stmt)) r = false;
         }
-        return true;
+        return endGroup(r);
     }
 
     bool AccountingDBSQLite::writeDTRs(std::list <aar_data_transfer_t>& dtrs, unsigned int recordid) {
         if (dtrs.empty()) return true;
-        std::string sql = "BEGIN TRANSACTION; ";
-        std::string sql_base = "INSERT INTO DataTransfers "
-            "(RecordID, URL, FileSize, TransferStart, TransferEnd, TransferType) VALUES ";
-        for (std::list<aar_data_transfer_t>::iterator it=dtrs.begin(); it != dtrs.end(); ++it) {
-            sql += sql_base + "( " + sql_escape(recordid) + ", '" + 
-                   sql_escape(it->url) + "', " +
-                   sql_escape(it->size) + ", " + 
-                   sql_escape(it->transferstart.GetTime()) + ", " + 
-                   sql_escape(it->transferend.GetTime()) + ", " + 
-                   sql_escape(static_cast<int>(it->type)) + "); ";
-        }
-        sql += "COMMIT;";
-        if(!GeneralSQLInsert(sql)) {
-            logger.msg(Arc::DEBUG, "SQL statement used: %s", sql);
-            return false;
-        }
-        return true;
+        sqlite3_stmt* stmt = db->prepare("INSERT INTO DataTransfers "
+            "(RecordID, URL, FileSize, TransferStart, TransferEnd, TransferType) VALUES (?, ?, ?, ?, ?, ?)");
+        if (!stmt || !beginGroup()) return false;
+        bool r = true;
+        for (std::list<aar_data_transfer_t>::iterator it=dtrs.begin(); r && (it != dtrs.end()); ++it) {
+            SQLBind(stmt, 1, (sqlite3_int64) recordid);
+            SQLBind(stmt, 2, sql_escape(it->url));
+            SQLBind(stmt, 3, (sqlite3_int64) it->size);
+            SQLBind(stmt, 4, (sqlite3_int64) it->transferstart.GetTime());
+            SQLBind(stmt, 5, (sqlite3_int64) it->transferend.GetTime());
+            SQLBind(stmt, 6, (sqlite3_int64) it->type);
+            if (!GeneralSQLInsert(stmt)) r = false;
+        }
+        return endGroup(r);
     }
 
     bool AccountingDBSQLite::writeEvents(std::list <aar_jobevent_t>& events, unsigned int recordid) {
         if (events.empty()) return true;
-        std::string sql = "BEGIN TRANSACTION; ";
-        std::string sql_base = "INSERT INTO JobEvents (RecordID, EventKey, EventTime) VALUES ";
-        for (std::list<aar_jobevent_t>::iterator it=events.begin(); it != events.end(); ++it) {
-            sql += sql_base + "( " + sql_escape(recordid) + ", '" + sql_escape(it->first) + "', '" +
-                   sql_escape(it->second) + "'); ";
-        }
-        sql += "COMMIT;";
-        if(!GeneralSQLInsert(sql)) {
-            logger.msg(Arc::DEBUG, "SQL statement used: %s", sql);
-            return false;
+        sqlite3_stmt* stmt = db->prepare("INSERT INTO JobEvents (RecordID, EventKey, EventTime) VALUES (?, ?, ?)");
+        if (!stmt || !beginGroup()) return false;
+        bool r = true;
+        for (std::list<aar_jobevent_t>::iterator it=events.begin(); r && (it != events.end()); ++it) {
+            SQLBind(stmt, 1, (sqlite3_int64) recordid);
+            SQLBind(stmt, 2, sql_escape(it->first));
+            SQLBind(stmt, 3, sql_escape(it->second));
+            if (!GeneralSQLInsert(stmt)) r = false;
         }
-        return true;
+        return endGroup(r);
     }
 
     bool AccountingDBSQLite::addJobEvent(aar_jobevent_t& event, const std::string& jobid) {
+        if (!isValid) return false;
+        initSQLiteDB();
+        Glib::Mutex::Lock lock(lock_);
         unsigned int recordid = getAARDBId(jobid);
         if (!recordid) {
             logger.msg(Arc::ERROR, "Unable to add event: cannot find AAR for job %s in accounting database.", jobid);
             return false;
         }
-        std::string sql = "INSERT INTO JobEvents (RecordID, EventKey, EventTime) VALUES (" +
-            sql_escape(recordid) + ", '" + sql_escape(event.first) + "', '" + sql_escape(event.second) + "')";
-        if(!GeneralSQLInsert(sql)) {
-            logger.msg(Arc::DEBUG, "SQL statement used: %s", sql);
+        sqlite3_stmt* stmt = db->prepare("INSERT INTO JobEvents (RecordID, EventKey, EventTime) VALUES (?, ?, ?)");
+        SQLBind(stmt, 1, (sqlite3_int64) recordid);
+        SQLBind(stmt, 2, sql_escape(event.first));
+        SQLBind(stmt, 3, sql_escape(event.second));
+        if(!GeneralSQLInsert(stmt)) {
             return false;
         }
         return true;
@@ -16,7 +16,13 @@ namespace ARex {
     /// Class implementing A-REX accounting records (AAR) storing in SQLite
     class AccountingDBSQLite : public AccountingDB {
       public:
-        AccountingDBSQLite(const std::string& name);
+        /// Open (and create if needed) accounting database
+        /**
+         * If wal is true database is switched to write-ahead log journal
+         * mode which lets readers work concurrently with writer and
+         * needs less synchronous disk writes.
+         **/
+        AccountingDBSQLite(const std::string& name, bool wal = false);
         ~AccountingDBSQLite();
         /// Create new AAR in the database (ACCEPTED)
         bool createAAR(AAR& aar);
@@ -24,8 +30,14 @@ namespace ARex {
         bool updateAAR(AAR& aar);
         /// Add job event record to AAR (any other state changes)
         bool addJobEvent(aar_jobevent_t& events, const std::string& jobid);
+        /// Start transaction grouping following write operations
+        bool beginBatch(void);
+        /// Commit transaction started by beginBatch()
+        bool commitBatch(void);
       private:
         static Arc::Logger logger;
+        // Protects connection, cached statements and maps below. Acquired by
+        // public methods, private helpers expect it to be held by caller.
         Glib::Mutex lock_;
         // General Name-ID tables
         name_id_map_t db_queue;
@@ -43,21 +55,49 @@ namespace ARex {
             int changes(void) { return sqlite3_changes(aDB); }
             sqlite3_int64 insertID(void) { return sqlite3_last_insert_rowid(aDB); }
             int exec(const char *sql, int (*callback)(void*,int,char**,char**), void *arg, char **errmsg);
+            /// Get prepared statement for sql, statements are cached for connection lifetime
+            sqlite3_stmt* prepare(const std::string& sql);
+            /// Execute prepared statement one step
+            /**
+             * Statement is reset unless SQLITE_ROW is returned. In that case
+             * caller must reset() it after fetching columns.
+             **/
+            int step(sqlite3_stmt* stmt);
+            /// Reset prepared statement and its bindings for next use
+            void reset(sqlite3_stmt* stmt);
             void logError(const char* errpfx, int err, Arc::LogLevel level = Arc::DEBUG);
         private:
             sqlite3* aDB;
+            std::map<std::string, sqlite3_stmt*> statements;
             void closeDB();
         };
 
         SQLiteDB* db;
+        /// Database file uses write-ahead log
+        bool wal;
+        /// Transaction started by beginBatch() is active
+        bool inbatch;
         /// Initialize and close connection to SQLite database
         void initSQLiteDB(void);
         void closeSQLiteDB(void);
 
-        /// General helper to execute INSERT statement and return the autoincrement ID
-        unsigned int GeneralSQLInsert(const std::string& sql);
-        /// General helper to execute UPDATE statement
-        bool GeneralSQLUpdate(const std::string& sql);
+        /// Set journal mode of the opened database
+        void setJournalMode(void);
+
+        /// General helper to execute prepared INSERT statement and return the autoincrement ID
+        unsigned int GeneralSQLInsert(sqlite3_stmt* stmt);
+        /// General helper to execute prepared UPDATE statement
+        bool GeneralSQLUpdate(sqlite3_stmt* stmt);
+        /// Helpers to bind values to prepared statement parameters
+        static void SQLBind(sqlite3_stmt* stmt, int idx, const std::string& value);
+        static void SQLBind(sqlite3_stmt* stmt, int idx, sqlite3_int64 value);
+        /// Start and finish group of inserts which must be stored together
+        /**
+         * Savepoints are used so groups may be nested inside transaction
+         * started by beginBatch().
+         **/
+        bool beginGroup(void);
+        bool endGroup(bool success);
 
         /// General helper that return accounting database ID for requested iname 
         /** 
@@ -0,0 +1,120 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+// Measures accounting database write throughput with and without grouping
+// records into transactions and with WAL journal enabled.
+// Usage: test_adb_perf [number of jobs] [database directory]
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include <arc/DateTime.h>
+#include <arc/StringConv.h>
+
+#include "AccountingDBSQLite.h"
+#include "AAR.h"
+
+static void fill_aar(ARex::AAR& aar, unsigned int n) {
+    aar.jobid = "perf" + Arc::tostring(n) + "upha6lOqABFKDmABFKDmpjJKDmABFKDmQs7RCo";
+    aar.endpoint = { "org.nordugrid.arcrest", "https://arc.example.org:443/arex" };
+    aar.queue = "grid" + Arc::tostring(n % 4);
+    aar.userdn = "/DC=org/DC=example/CN=User " + Arc::tostring(n % 50);
+    aar.wlcgvo = "vo" + Arc::tostring(n % 5);
+    aar.status = "in-progress";
+    aar.submittime = Arc::Time();
+    aar.authtokenattrs.push_back(ARex::aar_authtoken_t("vomsfqan", "/vo" + Arc::tostring(n % 5)));
+    aar.jobevents.push_back(ARex::aar_jobevent_t("ACCEPTED", Arc::Time()));
+}
+
+static void finish_aar(ARex::AAR& aar) {
+    aar.jobevents.clear();
+    aar.jobevents.push_back(ARex::aar_jobevent_t("FINISHED", Arc::Time()));
+    aar.localid = "2805309";
+    aar.endtime = Arc::Time();
+    aar.status = "completed";
+    aar.exitcode = 0;
+    aar.nodecount = 1;
+    aar.cpucount = 4;
+    aar.usedmemory = 584;
+    aar.usedvirtmemory = 678;
+    aar.usedwalltime = 100;
+    aar.usedcpuusertime = 90;
+    aar.usedcpukerneltime = 1;
+    aar.usedscratch = 0;
+    aar.stageinvolume = 57;
+    aar.stageoutvolume = 0;
+    aar.rtes.push_back("ENV/PROXY");
+    aar.transfers.push_back({"https://data.example.org/input", 57, Arc::Time(), Arc::Time(), ARex::dtr_input});
+    aar.extrainfo.insert(std::pair <std::string, std::string>("jobname", "perf"));
+    aar.extrainfo.insert(std::pair <std::string, std::string>("lrms", "fork"));
+}
+
+// Writes full life cycle of njobs jobs and returns number of records per second.
+// If batch is not 0 records are committed in groups of that size.
+static double run(const std::string& path, unsigned int njobs, unsigned int batch, bool wal) {
+    (void)::remove(path.c_str());
+    (void)::remove((path + "-wal").c_str());
+    (void)::remove((path + "-shm").c_str());
+    ARex::AccountingDBSQLite adb(path, wal);
+    if (!adb.IsValid()) return -1;
+
+    unsigned int records = 0;
+    Arc::Time start;
+    if (batch) adb.beginBatch();
+    for (unsigned int n = 0; n < njobs; ++n) {
+        ARex::AAR aar;
+        fill_aar(aar, n);
+        adb.createAAR(aar);
+        const char* states[] = { "PREPARING", "SUBMIT", "INLRMS", "FINISHING" };
+        for (int s = 0; s < 4; ++s) {
+            ARex::aar_jobevent_t event(states[s], Arc::Time());
+            adb.addJobEvent(event, aar.jobid);
+        }
+        finish_aar(aar);
+        adb.updateAAR(aar);
+        records += 6;
+        if (batch && ((n + 1) % batch == 0)) {
+            adb.commitBatch();
+            adb.beginBatch();
+        }
+    }
+    if (batch) adb.commitBatch();
+    Arc::Period p = Arc::Time() - start;
+    double seconds = (double)p.GetPeriod() + (double)p.GetPeriodNanoseconds() / 1000000000.0;
+    return seconds > 0 ? records / seconds : 0;
+}
+
+int main(int argc, char **argv) {
+    unsigned int njobs = 1000;
+    std::string dir = "/tmp";
+    if (argc > 1 && !Arc::stringto(argv[1], njobs)) {
+        std::cerr << "Usage: " << argv[0] << " [number of jobs] [database directory]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (argc > 2) dir = argv[2];
+    Arc::LogStream logcerr(std::cerr);
+    Arc::Logger::getRootLogger().addDestination(logcerr);
+    Arc::Logger::getRootLogger().setThreshold(Arc::ERROR);
+
+    std::string path = dir + "/adb_perf.sqlite";
+    const unsigned int batches[] = { 0, 10, 100 };
+    for (int wal = 0; wal < 2; ++wal) {
+        for (int b = 0; b < 3; ++b) {
+            double rate = run(path, njobs, batches[b], wal);
+            if (rate < 0) {
+                std::cerr << "Database connection was not successfull" << std::endl;
+                return EXIT_FAILURE;
+            }
+            std::cout << njobs << " jobs, " << (wal ? "WAL" : "rollback journal") << ", "
+                      << (batches[b] ? Arc::tostring(batches[b]) + " jobs per transaction"
+                                     : std::string("transaction per record"))
+                      << ": " << rate << " records/s" << std::endl;
+        }
+    }
+    (void)::remove(path.c_str());
+    (void)::remove((path + "-wal").c_str());
+    (void)::remove((path + "-shm").c_str());
+    return EXIT_SUCCESS;
+}
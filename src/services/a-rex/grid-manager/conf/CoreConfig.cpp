@@ -176,6 +176,9 @@ bool CoreConfig::ParseConfINI(GMConfig& config, Arc::ConfigFile& cfile) {
           if (!default_benchmark.empty()) {
             config.default_benchmark = default_benchmark;
           }
+        }
+        else if (command == "lrmshelper") {
+          config.lrms_helper = rest;
         };
       };
       continue;
@@ -244,6 +247,24 @@ bool CoreConfig::ParseConfINI(GMConfig& config, Arc::ConfigFile& cfile) {
             logger.msg(Arc::ERROR,"Wrong number in wakeupperiod: %s",wakeup_s); return false;
           }
         }
+        else if (command == "infoproviders_incremental") {
+          std::string s = Arc::ConfigIni::NextArg(rest);
+          if (s == "yes") {
+            config.info_incremental = true;
+          }
+          else if (s == "no") {
+            config.info_incremental = false;
+          }
+          else {
+            logger.msg(Arc::ERROR, "Wrong option in infoproviders_incremental"); return false;
+          }
+        }
+        else if (command == "jobthreads") {
+          std::string threads_s = Arc::ConfigIni::NextArg(rest);
+          if (!Arc::stringto(threads_s, config.job_threads) || (config.job_threads < 1)) {
+            logger.msg(Arc::ERROR,"Wrong number in jobthreads: %s",threads_s); return false;
+          }
+        }
         else if (command == "mail") { // internal address from which to send mail
           config.support_email_address = rest;
           if (config.support_email_address.empty()) {
@@ -353,6 +374,11 @@ bool CoreConfig::ParseConfINI(GMConfig& config, Arc::ConfigFile& cfile) {
             config.job_log->SetOutput(fname.c_str());
           }
         }
+        else if (command == "accounting_db_wal") {
+          bool wal = false;
+          if (!CheckYesNoCommand(wal, command, rest)) return false;
+          if (config.job_log) config.job_log->SetAccountingDBWAL(wal);
+        }
         else if (command == "delegationdb") {
           std::string s = Arc::ConfigIni::NextArg(rest);
           if (s == "bdb") {
@@ -80,6 +80,8 @@ void GMConfig::SetDefaults() {
   job_perf_log = NULL;
   cont_plugins = NULL;
   delegations = NULL;
+  job_state_index = NULL;
+  job_state_journal = NULL;
 
   share_uid = 0;
   keep_finished = DEFAULT_KEEP_FINISHED;
@@ -89,6 +91,8 @@ void GMConfig::SetDefaults() {
   reruns = DEFAULT_JOB_RERUNS;
   maxjobdesc = DEFAULT_MAX_JOB_DESC;
   wakeup_period = DEFAULT_WAKE_UP;
+  info_incremental = true;
+  job_threads = 1;
   allow_new = true;
 
   max_jobs_running = -1;
@@ -20,6 +20,8 @@ class SpaceMetrics;
 class ContinuationPlugins;
 class RunPlugin;
 class DelegationStores;
+class JobStateIndex;
+class JobStateJournal;
 
 /// Configuration information related to the grid manager part of A-REX.
 /**
@@ -150,6 +152,10 @@ public:
   void SetContPlugins(ContinuationPlugins* plugins) { cont_plugins = plugins; }
   /// Set DelegationStores object
   void SetDelegations(ARex::DelegationStores* stores) { delegations = stores; }
+  /// Set JobStateIndex object
+  void SetJobStateIndex(JobStateIndex* index) { job_state_index = index; }
+  /// Set JobStateJournal object
+  void SetJobStateJournal(JobStateJournal* journal) { job_state_journal = journal; }
   /// JobLog object
   JobLog* GetJobLog() const { return job_log; }
   /// JobsMetrics object
@@ -164,6 +170,10 @@ public:
   ContinuationPlugins* GetContPlugins() const { return cont_plugins; }
   /// DelegationsStores object
   ARex::DelegationStores* GetDelegations() const { return delegations; }
+  /// JobStateIndex object
+  JobStateIndex* GetJobStateIndex() const { return job_state_index; }
+  /// JobStateJournal object
+  JobStateJournal* GetJobStateJournal() const { return job_state_journal; }
 
   /// Control directory
   const std::string & ControlDir() const { return control_dir; }
@@ -201,6 +211,8 @@ public:
   const std::string & DefaultQueue() const { return default_queue; }
   /// Default benchmark
   const std::string & DefaultBenchmark() const { return default_benchmark; }
+  /// Command of persistent LRMS helper process, empty if per-job scripts are used
+  const std::string & LRMSHelperCommand() const { return lrms_helper; }
   /// All configured queues
   const std::list<std::string>& Queues() const { return queues; }
 
@@ -230,6 +242,12 @@ public:
   /// Maxmimum time for A-REX to wait between job processing loops
   unsigned int WakeupPeriod() const { return wakeup_period; }
 
+  /// If output of information provider is streamed and published only when changed
+  bool InfoIncremental() const { return info_incremental; }
+
+  /// Number of job processing threads, jobs are distributed among them by id
+  int JobThreads() const { return job_threads; }
+
   const std::list<std::string> & Helpers() const { return helpers; }
 
   /// Max jobs being processed (from PREPARING to FINISHING)
@@ -284,6 +302,10 @@ private:
   /// Delegated credentials stored by A-REX
   // TODO: this should go away after proper locking in DelegationStore is implemented
   ARex::DelegationStores* delegations;
+  /// In-memory index of jobs states
+  JobStateIndex* job_state_index;
+  /// Persistent journal of jobs states
+  JobStateJournal* job_state_journal;
 
   /// Certificates directory
   std::string cert_dir;
@@ -313,6 +335,8 @@ private:
   std::string default_queue;
   /// Default benchmark to store in AAR
   std::string default_benchmark;
+  /// Persistent process handling submission and cancellation of jobs
+  std::string lrms_helper;
   /// All configured queues
   std::list<std::string> queues;
   /// User running A-REX
@@ -335,6 +359,10 @@ private:
   bool allow_new;
   /// Maximum time for A-REX to wait between each loop processing jobs
   unsigned int wakeup_period;
+  /// Read information provider output incrementally and skip unchanged documents
+  bool info_incremental;
+  /// Number of threads processing jobs, 1 means processing in main loop
+  int job_threads;
   /// Groups allowed to submit while job submission is disabled
   std::list<std::string> allow_submit;
   /// List of associated external processes
@@ -15,6 +15,7 @@ StagingConfig::StagingConfig(const GMConfig& config):
   max_processor(10),
   max_emergency(1),
   max_prepared(200),
+  processor_threads(0),
   min_speed(0),
   min_speed_time(300),
   min_average_speed(0),
@@ -22,6 +23,7 @@ StagingConfig::StagingConfig(const GMConfig& config):
   max_retries(10),
   passive(true),
   httpgetpartial(false),
+  vectored_io(false),
   remote_size_limit(0),
   use_host_cert_for_remote_delivery(false),
   log_level(Arc::Logger::getRootLogger().getThreshold()),
@@ -96,6 +98,12 @@ bool StagingConfig::readStagingConf(Arc::ConfigFile& cfile) {
         return false;
       }
     }
+    else if (command == "processorthreads") {
+      if (!paramToInt(Arc::ConfigIni::NextArg(rest), processor_threads) || processor_threads < 0) {
+        logger.msg(Arc::ERROR, "Bad number in processorthreads");
+        return false;
+      }
+    }
     else if (command == "maxtransfertries") {
       if (!paramToInt(Arc::ConfigIni::NextArg(rest), max_retries)) {
         logger.msg(Arc::ERROR, "Bad number in maxtransfertries");
@@ -154,6 +162,11 @@ bool StagingConfig::readStagingConf(Arc::ConfigFile& cfile) {
       if (partial == "yes") httpgetpartial = true;
       else httpgetpartial = false;
     }
+    else if (command == "vectoredio") {
+      std::string vectored = Arc::ConfigIni::NextArg(rest);
+      if (vectored == "yes") vectored_io = true;
+      else vectored_io = false;
+    }
     else if (command == "preferredpattern") {
       preferred_pattern = rest;
     }
@@ -28,6 +28,7 @@ public:
   int get_max_processor() const { return max_processor; };
   int get_max_emergency() const { return max_emergency; };
   int get_max_prepared() const { return max_prepared; };
+  int get_processor_threads() const { return processor_threads; };
   unsigned long long int get_min_speed() const { return min_speed; };
   time_t get_min_speed_time() const { return min_speed_time; };
   unsigned long long int get_min_average_speed() const { return min_average_speed; };
@@ -35,6 +36,7 @@ public:
   int get_max_retries() const { return max_retries; };
   bool get_passive() const { return passive; };
   bool get_httpgetpartial() const { return httpgetpartial; };
+  bool get_vectored_io() const { return vectored_io; };
   std::string get_preferred_pattern() const { return preferred_pattern; };
   std::vector<Arc::URL> get_delivery_services() const { return delivery_services; };
   unsigned long long int get_remote_size_limit() const { return remote_size_limit; };
@@ -55,6 +57,8 @@ private:
   int max_emergency;
   /// Number of files per share to keep prepared
   int max_prepared;
+  /// Number of threads doing pre- and post-processing, 0 for default
+  int processor_threads;
 
   /// Minimum speed for transfer over min_speed_time seconds
   unsigned long long int min_speed;
@@ -70,6 +74,8 @@ private:
   bool passive;
   /// Whether to use partial HTTP GET transfers
   bool httpgetpartial;
+  /// Whether to use ring buffer with vectored I/O for local transfers
+  bool vectored_io;
   /// Pattern for choosing preferred replicas
   std::string preferred_pattern;
 
@@ -4,9 +4,12 @@
 
 #include <iostream>
 #include <string>
+#include <cstdlib>
+#include <cstring>
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <limits.h>
@@ -24,6 +27,64 @@ namespace ARex {
 static Glib::Mutex local_lock;
 static Arc::Logger& logger = Arc::Logger::getRootLogger();
 
+// Files smaller than that are read instead of being mapped
+static std::string::size_type const buffer_map_min = 64*1024;
+
+ControlFileBuffer::ControlFileBuffer(int h):data_(NULL),size_(0),pos_(0),mapped_(false),valid_(false) {
+  struct stat st;
+  if(::fstat(h,&st) != 0) return;
+  if(st.st_size >= (off_t)buffer_map_min) {
+    void* addr = ::mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,h,0);
+    if(addr != MAP_FAILED) {
+      data_ = (char*)addr; size_ = st.st_size; mapped_ = true; valid_ = true;
+      return;
+    };
+  };
+  // File may grow while being read, hence read till EOF
+  std::string::size_type capacity = st.st_size + 1;
+  data_ = (char*)::malloc(capacity);
+  if(!data_) return;
+  for(;;) {
+    if(size_ >= capacity) {
+      char* data = (char*)::realloc(data_,capacity*2);
+      if(!data) return;
+      data_ = data; capacity *= 2;
+    };
+    ssize_t l = ::read(h,data_+size_,capacity-size_);
+    if(l < 0) {
+      if(errno == EINTR) continue;
+      return;
+    };
+    if(l == 0) break; // EOF
+    size_ += l;
+  };
+  valid_ = true;
+}
+
+ControlFileBuffer::~ControlFileBuffer(void) {
+  if(!data_) return;
+  if(mapped_) {
+    ::munmap(data_,size_);
+  } else {
+    ::free(data_);
+  };
+}
+
+bool ControlFileBuffer::line(const char*& str,std::string::size_type& len) {
+  if(!valid_) return false;
+  if(pos_ >= size_) return false;
+  str = data_ + pos_;
+  const char* eol = (const char*)::memchr(str,'\n',size_-pos_);
+  if(eol) {
+    len = eol - str;
+    pos_ += len + 1;
+  } else {
+    len = size_ - pos_;
+    pos_ = size_;
+  };
+  return true;
+}
+
 class KeyValueFile {
  public:
   enum OpenMode {
@@ -38,15 +99,12 @@ class KeyValueFile {
   bool Read(std::string& name, std::string& value);
  private:
   int handle_;
-  char* read_buf_;
-  int read_buf_pos_;
-  int read_buf_avail_;
-  static int const read_buf_size_ = 256; // normally should fit full line
-  static int const data_max_ = 1024*1024; // sanity protection
+  ControlFileBuffer* read_buf_;
+  static std::string::size_type const data_max_ = 1024*1024; // sanity protection
 };
 
 KeyValueFile::KeyValueFile(std::string const& fname, OpenMode mode):
-          handle_(-1),read_buf_(NULL),read_buf_pos_(0),read_buf_avail_(0) {
+          handle_(-1),read_buf_(NULL) {
   if(mode == Create) {
     handle_ = ::open(fname.c_str(),O_WRONLY | O_CREAT, S_IRUSR | S_IWUSR);
     if(handle_==-1) return;
@@ -73,8 +131,9 @@ KeyValueFile::KeyValueFile(std::string const& fname, OpenMode mode):
       close(handle_); handle_ = -1; // failure
       return;
     };
-    read_buf_ = new char[read_buf_size_];
-    if(!read_buf_) {
+    // Whole file is read at once while being locked
+    read_buf_ = new ControlFileBuffer(handle_);
+    if(!*read_buf_) {
       close(handle_); handle_ = -1;
       return;
     };
@@ -83,7 +142,7 @@ KeyValueFile::KeyValueFile(std::string const& fname, OpenMode mode):
 
 KeyValueFile::~KeyValueFile(void) {
   if(handle_ != -1) ::close(handle_);
-  if(read_buf_) delete[] read_buf_;
+  if(read_buf_) delete read_buf_;
 }
 
 static inline bool write_str(int f,const char* buf, std::string::size_type len) {
@@ -116,69 +175,104 @@ bool KeyValueFile::Read(std::string& name, std::string& value) {
   if(!read_buf_) return false;
   name.clear();
   value.clear();
-  char c;
-  bool key_done = false;
-  for(;;) {
-    if(read_buf_pos_ >= read_buf_avail_) {
-      read_buf_pos_ = 0;
-      read_buf_avail_ = 0;
-      ssize_t l = ::read(handle_, read_buf_, read_buf_size_);
-      if(l < 0) {
-        if(errno == EINTR) continue;
-        return false;
-      };
-      if(l == 0) break; // EOF - not error
-      read_buf_avail_ = l;
-    };
-    c = read_buf_[read_buf_pos_++];
-    if(c == '\n') break; // EOL
-    if(!key_done) {
-      if(c == '=') {
-        key_done = true;
-      } else {
-        name += c;
-        if(name.length() > data_max_) return false;
-      };
-    } else {
-      value += c;
-      if(value.length() > data_max_) return false; 
-    };
+  const char* str;
+  std::string::size_type len;
+  if(!read_buf_->line(str,len)) return true; // EOF - not error
+  const char* sep = (const char*)::memchr(str,'=',len);
+  if(!sep) {
+    if(len > data_max_) return false;
+    name.assign(str,len);
+    return true;
   };
+  std::string::size_type name_len = sep - str;
+  if(name_len > data_max_) return false;
+  if((len - name_len - 1) > data_max_) return false;
+  name.assign(str,name_len);
+  value.assign(sep+1,len-name_len-1);
   return true;
 }
 
-std::ostream &operator<< (std::ostream &o,const FileData &fd) {
+static inline void append_escaped(std::string& str,const std::string& value) {
   // TODO: switch to HEX encoding and drop dependency on ConfigIni in major release
-  std::string escaped_pfn(Arc::escape_chars(fd.pfn, " \\\r\n", '\\', false));
-  if(!escaped_pfn.empty()) {
-    o.write(escaped_pfn.c_str(), escaped_pfn.size());
-    std::string escaped_lfn(Arc::escape_chars(fd.lfn, " \\\r\n", '\\', false));
-    if(!escaped_lfn.empty()) {
-      o.put(' ');
-      o.write(escaped_lfn.c_str(), escaped_lfn.size());
-      std::string escaped_cred(Arc::escape_chars(fd.cred, " \\\r\n", '\\', false));
-      if(!escaped_cred.empty()) {
-        o.put(' ');
-        o.write(escaped_cred.c_str(), escaped_cred.size());
-      };
-    };
+  if(value.find_first_of(" \\\r\n") == std::string::npos) {
+    str += value;
+  } else {
+    str += Arc::escape_chars(value, " \\\r\n", '\\', false);
   };
+}
+
+void FileData::append(std::string& str) const {
+  if(pfn.empty()) return;
+  append_escaped(str, pfn);
+  if(lfn.empty()) return;
+  str += ' ';
+  append_escaped(str, lfn);
+  if(cred.empty()) return;
+  str += ' ';
+  append_escaped(str, cred);
+}
+
+std::ostream &operator<< (std::ostream &o,const FileData &fd) {
+  std::string buf;
+  fd.append(buf);
+  o.write(buf.c_str(), buf.size());
   return o;
 }
 
+// Same as Arc::extract_escaped_token but without modifying input
+static inline std::string::size_type extract_token(const char*& str, const char* end, const char*& token) {
+  token = str;
+  while((str < end) && (*str == ' ')) ++str;
+  while(str < end) {
+    if(*str == '\\') {
+      // skip escaped char, protect against escape at eol
+      str = ((end - str) > 2) ? (str + 2) : end;
+      continue;
+    };
+    if(*str == ' ') break;
+    ++str;
+  };
+  std::string::size_type len = str - token;
+  if(str < end) ++str; // skip separator
+  return len;
+}
+
+static inline void assign_unescaped(std::string& value, const char* str, std::string::size_type len) {
+  if(::memchr(str, '\\', len) == NULL) {
+    value.assign(str, len);
+  } else {
+    value = Arc::unescape_chars(std::string(str, len), '\\');
+  };
+}
+
+static inline bool is_trimmed(char c) {
+  return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n');
+}
+
+bool FileData::parse(const char* str,std::string::size_type len) {
+  pfn.resize(0); lfn.resize(0); cred.resize(0);
+  while((len > 0) && is_trimmed(*str)) { ++str; --len; };
+  while((len > 0) && is_trimmed(str[len-1])) --len;
+  const char* pos = str;
+  const char* end = str + len;
+  const char* token;
+  std::string::size_type token_len;
+  token_len = extract_token(pos, end, token); assign_unescaped(pfn, token, token_len);
+  token_len = extract_token(pos, end, token); assign_unescaped(lfn, token, token_len);
+  token_len = extract_token(pos, end, token); assign_unescaped(cred, token, token_len);
+  if((pfn.length() == 0) && (lfn.length() == 0)) return false; /* empty st */
+  if(!Arc::CanonicalDir(pfn,true,true)) {
+    logger.msg(Arc::ERROR,"Wrong directory in %s",std::string(str,len));
+    pfn.resize(0); lfn.resize(0);
+    return false;
+  };
+  return true;
+}
+
 std::istream &operator>> (std::istream &i,FileData &fd) {
   std::string buf;
   std::getline(i,buf);
-  Arc::trim(buf," \t\r\n");
-  fd.pfn.resize(0); fd.lfn.resize(0); fd.cred.resize(0);
-  fd.pfn  = Arc::unescape_chars(Arc::extract_escaped_token(buf, ' ', '\\'), '\\');
-  fd.lfn  = Arc::unescape_chars(Arc::extract_escaped_token(buf, ' ', '\\'), '\\');
-  fd.cred = Arc::unescape_chars(Arc::extract_escaped_token(buf, ' ', '\\'), '\\');
-  if((fd.pfn.length() == 0) && (fd.lfn.length() == 0)) return i; /* empty st */
-  if(!Arc::CanonicalDir(fd.pfn,true,true)) {
-    logger.msg(Arc::ERROR,"Wrong directory in %s",buf);
-    fd.pfn.resize(0); fd.lfn.resize(0);
-  };
+  fd.parse(buf.c_str(), buf.length());
   return i;
 }
 
@@ -34,10 +34,39 @@ class FileData {
   bool operator== (const char* name);
   bool operator== (const FileData& data);
   bool has_lfn(void);
+  /* Parses single line of *.input or *.output file. Returns false for
+     empty or invalid line. */
+  bool parse(const char* str,std::string::size_type len);
+  /* Appends content in format of *.input or *.output file, without EOL. */
+  void append(std::string& str) const;
 };
 std::istream &operator>> (std::istream &i,FileData &fd);
 std::ostream &operator<< (std::ostream &o,const FileData &fd);
 
+/*
+  Whole content of control file kept in memory for parsing. Large files
+  are memory mapped, small ones are read at once. Lines are returned as
+  pointers into buffer so no copy is made till value is extracted.
+*/
+class ControlFileBuffer {
+ public:
+  /* Reads content of already opened file h. */
+  ControlFileBuffer(int h);
+  ~ControlFileBuffer(void);
+  operator bool(void) const { return valid_; };
+  bool operator!(void) const { return !valid_; };
+  /* Provides next line without EOL. Returns false at end of content. */
+  bool line(const char*& str,std::string::size_type& len);
+ private:
+  ControlFileBuffer(const ControlFileBuffer&);
+  ControlFileBuffer& operator=(const ControlFileBuffer&);
+  char* data_;
+  std::string::size_type size_;
+  std::string::size_type pos_;
+  bool mapped_;
+  bool valid_;
+};
+
 class Exec: public std::list<std::string> {
  public:
   Exec(void):successcode(0) {};
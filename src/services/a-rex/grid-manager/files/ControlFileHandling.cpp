@@ -3,8 +3,10 @@
 #endif
 
 #include <sstream>
+#include <map>
 #include <fcntl.h>
 #include <errno.h>
+#include <sys/stat.h>
 
 #include <arc/FileAccess.h>
 #include <arc/FileUtils.h>
@@ -15,6 +17,8 @@
 #include "../jobs/GMJob.h"
 
 #include "ControlFileHandling.h"
+#include "JobStateIndex.h"
+#include "JobStateJournal.h"
 
 namespace ARex {
 
@@ -53,6 +57,118 @@ static bool job_state_write_file(const std::string &fname,job_state_t state,bool
 static bool job_mark_put(Arc::FileAccess& fa, const std::string &fname);
 static bool job_mark_remove(Arc::FileAccess& fa,const std::string &fname);
 
+// Parsed content of *.input, *.output and *.output_status files. These
+// are read on every state transition and may have thousands of lines.
+// Entry is used while file keeps same inode, size and modification time
+// including its sub-second part. Files written by this process are also
+// dropped explicitly because file system may not keep sub-second time.
+class XputCache {
+ public:
+  XputCache(void):records_(0) { };
+  bool Get(const std::string& fname,const struct stat& st,std::list<FileData>& files);
+  void Put(const std::string& fname,const struct stat& st,const std::list<FileData>& files);
+  void Drop(const std::string& fname);
+ private:
+  struct Entry {
+    ino_t ino;
+    off_t size;
+    time_t mtime;
+    long mtime_nsec;
+    std::list<FileData> files;
+  };
+  // Smaller files are cheaper to parse than to keep
+  static std::list<FileData>::size_type const records_min_ = 100;
+  static unsigned long long const records_max_ = 200000;
+  Glib::Mutex lock_;
+  std::map<std::string,Entry> entries_;
+  std::list<std::string> order_;
+  unsigned long long records_;
+};
+
+bool XputCache::Get(const std::string& fname,const struct stat& st,std::list<FileData>& files) {
+  Glib::Mutex::Lock lock(lock_);
+  std::map<std::string,Entry>::iterator entry = entries_.find(fname);
+  if(entry == entries_.end()) return false;
+  if((entry->second.ino != st.st_ino) || (entry->second.size != st.st_size) ||
+     (entry->second.mtime != st.st_mtim.tv_sec) ||
+     (entry->second.mtime_nsec != st.st_mtim.tv_nsec)) return false;
+  files.insert(files.end(),entry->second.files.begin(),entry->second.files.end());
+  return true;
+}
+
+void XputCache::Put(const std::string& fname,const struct stat& st,const std::list<FileData>& files) {
+  if(files.size() < records_min_) return;
+  Glib::Mutex::Lock lock(lock_);
+  std::map<std::string,Entry>::iterator entry = entries_.find(fname);
+  if(entry == entries_.end()) {
+    entry = entries_.insert(std::pair<std::string,Entry>(fname,Entry())).first;
+    order_.push_back(fname);
+  } else {
+    records_ -= entry->second.files.size();
+  };
+  entry->second.ino = st.st_ino;
+  entry->second.size = st.st_size;
+  entry->second.mtime = st.st_mtim.tv_sec;
+  entry->second.mtime_nsec = st.st_mtim.tv_nsec;
+  entry->second.files = files;
+  records_ += files.size();
+  // Oldest entries are removed first
+  while((records_ > records_max_) && !order_.empty()) {
+    std::map<std::string,Entry>::iterator old = entries_.find(order_.front());
+    if(old != entries_.end()) {
+      records_ -= old->second.files.size();
+      entries_.erase(old);
+    };
+    order_.pop_front();
+  };
+}
+
+void XputCache::Drop(const std::string& fname) {
+  Glib::Mutex::Lock lock(lock_);
+  std::map<std::string,Entry>::iterator entry = entries_.find(fname);
+  if(entry == entries_.end()) return;
+  records_ -= entry->second.files.size();
+  entries_.erase(entry);
+  order_.remove(fname);
+}
+
+static XputCache xput_cache;
+
+static bool write_all(int h,const char* buf,std::string::size_type len) {
+  while(len > 0) {
+    ssize_t l = ::write(h,buf,len);
+    if(l < 0) {
+      if(errno == EINTR) continue;
+      return false;
+    };
+    buf += l; len -= l;
+  };
+  return true;
+}
+
+// Appends line to status file. Whole line is written at once, so it is
+// not mixed with lines appended concurrently. Owner and permissions are
+// only set when file is created.
+static bool job_status_file_add(const std::string &fname,const GMJob &job,const std::string &line) {
+  bool created = false;
+  int h = ::open(fname.c_str(),O_WRONLY | O_APPEND);
+  if((h == -1) && (errno == ENOENT)) {
+    h = ::open(fname.c_str(),O_WRONLY | O_APPEND | O_CREAT | O_EXCL,S_IRUSR | S_IWUSR);
+    if(h != -1) {
+      created = true;
+    } else if(errno == EEXIST) {
+      h = ::open(fname.c_str(),O_WRONLY | O_APPEND);
+    };
+  };
+  if(h == -1) return false;
+  bool r = write_all(h,line.c_str(),line.length());
+  ::close(h);
+  xput_cache.Drop(fname);
+  if(!r) return false;
+  if(!created) return true;
+  return fix_file_owner(fname,job) && fix_file_permissions(fname);
+}
+
 
 bool fix_file_permissions(const std::string &fname,bool executable) {
   mode_t mode = S_IRUSR | S_IWUSR;
@@ -198,12 +314,16 @@ bool job_clean_mark_remove(const JobId &id,const GMConfig &config) {
 bool job_failed_mark_put(const GMJob &job,const GMConfig &config,const std::string &content) {
   std::string fname = config.ControlDir() + "/job." + job.get_id() + sfx_failed;
   if(job_mark_size(fname) > 0) return true;
-  return job_mark_write(fname,content) && fix_file_owner(fname,job) && fix_file_permissions(fname,job,config);
+  if(!job_mark_write(fname,content)) return false;
+  if(config.GetJobStateIndex()) config.GetJobStateIndex()->SetFailed(job.get_id(),true);
+  return fix_file_owner(fname,job) && fix_file_permissions(fname,job,config);
 }
 
 bool job_failed_mark_add(const GMJob &job,const GMConfig &config,const std::string &content) {
   std::string fname = config.ControlDir() + "/job." + job.get_id() + sfx_failed;
-  return job_mark_add(fname,content) && fix_file_owner(fname,job) && fix_file_permissions(fname,job,config);
+  if(!job_mark_add(fname,content)) return false;
+  if(config.GetJobStateIndex()) config.GetJobStateIndex()->SetFailed(job.get_id(),true);
+  return fix_file_owner(fname,job) && fix_file_permissions(fname,job,config);
 }
 
 bool job_failed_mark_check(const JobId &id,const GMConfig &config) {
@@ -213,6 +333,7 @@ bool job_failed_mark_check(const JobId &id,const GMConfig &config) {
 
 bool job_failed_mark_remove(const JobId &id,const GMConfig &config) {
   std::string fname = config.ControlDir() + "/job." + id + sfx_failed;
+  if(config.GetJobStateIndex()) config.GetJobStateIndex()->SetFailed(id,false);
   return job_mark_remove(fname);
 }
 
@@ -417,6 +538,16 @@ job_state_t job_state_read_file(const JobId &id,const GMConfig &config,bool& pen
   return job_state_read_file(fname,pending);
 }
 
+job_state_t job_state_read_journal(const JobId &id,const GMConfig &config,bool &pending) {
+  JobStateJournal* journal = config.GetJobStateJournal();
+  JobStateJournal::Record record;
+  if(journal && journal->Get(id,record)) {
+    pending = record.pending;
+    return record.state;
+  }
+  return job_state_read_file(id,config,pending);
+}
+
 bool job_state_write_file(const GMJob &job,const GMConfig &config,job_state_t state,bool pending) {
   std::string fname;
   if(state == JOB_STATE_ACCEPTED) { 
@@ -438,7 +569,18 @@ bool job_state_write_file(const GMJob &job,const GMConfig &config,job_state_t st
     fname = config.ControlDir() + "/job." + job.get_id() + sfx_status; remove(fname.c_str());
     fname = config.ControlDir() + "/" + subdir_cur + "/job." + job.get_id() + sfx_status;
   };
-  return job_state_write_file(fname,state,pending) && fix_file_owner(fname,job) && fix_file_permissions(fname,job,config);
+  if(!job_state_write_file(fname,state,pending)) return false;
+  if(config.GetJobStateIndex()) config.GetJobStateIndex()->SetState(job.get_id(),state,pending);
+  if(!fix_file_owner(fname,job)) return false;
+  if(config.GetJobStateJournal()) {
+    // Record owner which file got above
+    if(getuid() == 0) {
+      config.GetJobStateJournal()->Write(job.get_id(),state,pending,job.get_user().get_uid(),job.get_user().get_gid());
+    } else {
+      config.GetJobStateJournal()->Write(job.get_id(),state,pending,getuid(),getgid());
+    };
+  };
+  return fix_file_permissions(fname,job,config);
 }
 
 static job_state_t job_state_read_file(const std::string &fname,bool &pending) {
@@ -513,7 +655,10 @@ bool job_xml_write_file(const JobId &id,const GMConfig &config,const std::string
 
 bool job_local_write_file(const GMJob &job,const GMConfig &config,const JobLocalDescription &job_desc) {
   std::string fname = config.ControlDir() + "/job." + job.get_id() + sfx_local;
-  return job_local_write_file(fname,job_desc) && fix_file_owner(fname,job) && fix_file_permissions(fname,job,config);
+  if(!job_local_write_file(fname,job_desc)) return false;
+  if(config.GetJobStateIndex())
+    config.GetJobStateIndex()->SetLocal(job.get_id(),job_desc.DN,job_desc.sessiondir,job_desc.failedstate,job_desc.failedcause);
+  return fix_file_owner(fname,job) && fix_file_permissions(fname,job,config);
 }
 
 bool job_local_write_file(const std::string &fname,const JobLocalDescription &job_desc) {
@@ -578,17 +723,9 @@ bool job_input_status_add_file(const GMJob &job,const GMConfig &config,const std
     if (i == 0) return false;
     sleep(1);
   }
-  std::string data;
-  if (!Arc::FileRead(fname, data) && errno != ENOENT) {
-    lock.release();
-    return false;
-  }
-  std::ostringstream line;
-  line<<file<<"\n";
-  data += line.str();
-  bool r = Arc::FileCreate(fname, data);
+  bool r = job_status_file_add(fname,job,file+"\n");
   lock.release();
-  return r && fix_file_owner(fname,job) && fix_file_permissions(fname);
+  return r;
 }
 
 bool job_input_status_read_file(const JobId &id,const GMConfig &config,std::list<std::string>& files) {
@@ -617,12 +754,10 @@ bool job_output_read_file(const JobId &id,const GMConfig &config,std::list<FileD
 bool job_output_status_add_file(const GMJob &job,const GMConfig &config,const FileData& file) {
   // Not using lock here because concurrent read/write is not expected
   std::string fname = config.ControlDir() + "/job." + job.get_id() + sfx_outputstatus;
-  std::string data;
-  if (!Arc::FileRead(fname, data) && errno != ENOENT) return false;
-  std::ostringstream line;
-  line<<file<<"\n";
-  data += line.str();
-  return Arc::FileCreate(fname, data) && fix_file_owner(fname,job) && fix_file_permissions(fname);
+  std::string line;
+  file.append(line);
+  line += "\n";
+  return job_status_file_add(fname,job,line);
 }
 
 bool job_output_status_write_file(const GMJob &job,const GMConfig &config,std::list<FileData> &files) {
@@ -638,43 +773,63 @@ bool job_output_status_read_file(const JobId &id,const GMConfig &config,std::lis
 /* common functions */
 
 bool job_Xput_write_file(const std::string &fname,std::list<FileData> &files,job_output_mode mode, uid_t uid, gid_t gid) {
-  std::ostringstream s;
+  std::string data;
   for(FileData::iterator i=files.begin();i!=files.end(); ++i) { 
     if(mode == job_output_all) {
-      s << (*i) << std::endl;
+      i->append(data); data += '\n';
     } else if(mode == job_output_success) {
       if(i->ifsuccess) {
-        s << (*i) << std::endl;
+        i->append(data); data += '\n';
       } else {
         // This case is handled at higher level
       };
     } else if(mode == job_output_cancel) {
       if(i->ifcancel) {
-        s << (*i) << std::endl;
+        i->append(data); data += '\n';
       } else {
         // This case is handled at higher level
       };
     } else if(mode == job_output_failure) {
       if(i->iffailure) {
-        s << (*i) << std::endl;
+        i->append(data); data += '\n';
       } else {
         // This case is handled at higher level
       };
     };
   };
-  if (!Arc::FileCreate(fname, s.str(), uid, gid)) return false;
+  xput_cache.Drop(fname);
+  if (!Arc::FileCreate(fname, data, uid, gid)) return false;
   return true;
 }
 
 bool job_Xput_read_file(const std::string &fname,std::list<FileData> &files, uid_t uid, gid_t gid) {
-  std::list<std::string> file_content;
-  if (!Arc::FileRead(fname, file_content, uid, gid)) return false;
-  for(std::list<std::string>::iterator i = file_content.begin(); i != file_content.end(); ++i) {
-    FileData fd;
-    std::istringstream s(*i);
-    s >> fd;
-    if(!fd.pfn.empty()) files.push_back(fd);
+  if((uid && (uid != getuid())) || (gid && (gid != getgid()))) {
+    // File is accessed on behalf of user, content is not cached
+    std::list<std::string> file_content;
+    if (!Arc::FileRead(fname, file_content, uid, gid)) return false;
+    for(std::list<std::string>::iterator i = file_content.begin(); i != file_content.end(); ++i) {
+      FileData fd;
+      if(fd.parse(i->c_str(), i->length())) files.push_back(fd);
+    };
+    return true;
+  };
+  int h = ::open(fname.c_str(),O_RDONLY);
+  if(h == -1) return false;
+  struct stat st;
+  if(::fstat(h,&st) != 0) { ::close(h); return false; };
+  if(xput_cache.Get(fname,st,files)) { ::close(h); return true; };
+  ControlFileBuffer buf(h);
+  ::close(h);
+  if(!buf) return false;
+  std::list<FileData> parsed;
+  FileData fd;
+  const char* str;
+  std::string::size_type len;
+  while(buf.line(str,len)) {
+    if(fd.parse(str,len)) parsed.push_back(fd);
   };
+  xput_cache.Put(fname,st,parsed);
+  files.splice(files.end(),parsed);
   return true;
 }
 
@@ -727,6 +882,7 @@ bool job_clean_deleted(const GMJob &job,const GMConfig &config,std::list<std::st
   } else {
     Arc::DirDelete(session);
   }
+  if(config.GetJobStateIndex()) config.GetJobStateIndex()->SetSession(id,false);
   // remove cache per-job links, in case this failed earlier
   for (std::list<std::string>::iterator i = cache_per_job_dirs.begin(); i != cache_per_job_dirs.end(); i++) {
     Arc::DirDelete((*i) + "/" + id);
@@ -751,6 +907,8 @@ bool job_clean_final(const GMJob &job,const GMConfig &config) {
   fname = config.ControlDir()+"/"+subdir_rew+"/job."+id+sfx_status; remove(fname.c_str());
   fname = config.ControlDir()+"/job."+id+sfx_desc; remove(fname.c_str());
   fname = config.ControlDir()+"/job."+id+sfx_xml; remove(fname.c_str());
+  if(config.GetJobStateIndex()) config.GetJobStateIndex()->Remove(id);
+  if(config.GetJobStateJournal()) config.GetJobStateJournal()->Remove(id);
   return true;
 }
 
@@ -131,6 +131,9 @@ time_t job_state_time(const JobId &id,const GMConfig &config);
 job_state_t job_state_read_file(const JobId &id,const GMConfig &config);
 job_state_t job_state_read_file(const JobId &id,const GMConfig &config,bool &pending);
 bool job_state_write_file(const GMJob &job,const GMConfig &config,job_state_t state,bool pending);
+// Get state of the job from journal of states if journal knows the job.
+// Otherwise read it from status file.
+job_state_t job_state_read_journal(const JobId &id,const GMConfig &config,bool &pending);
 
 // Get modification time of file used to store description of the job.
 time_t job_description_time(const JobId &id,const GMConfig &config);
@@ -0,0 +1,220 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <sys/stat.h>
+
+#include "../conf/GMConfig.h"
+#include "ControlFileHandling.h"
+#include "ControlFileContent.h"
+
+#include "JobStateIndex.h"
+
+namespace ARex {
+
+static bool SessionDirExists(const std::string& sessiondir) {
+  if(sessiondir.empty()) return false;
+  struct stat st;
+  return (::stat(sessiondir.c_str(),&st) == 0);
+}
+
+JobStateIndex::JobStateIndex(void):complete_(false),populating_(false),generation_(0),last_modified_(time(NULL)),
+                                    populated_generation_(0),populated_time_(last_modified_) {
+}
+
+void JobStateIndex::touch(Entry& entry) {
+  entry.modified = time(NULL);
+  last_modified_ = entry.modified;
+  ++generation_;
+  // Entry without local description does not belong to any owner yet
+  if(!entry.dn.empty()) owners_[entry.dn] = std::make_pair(generation_, last_modified_);
+}
+
+void JobStateIndex::touch(const std::string& dn) {
+  last_modified_ = time(NULL);
+  ++generation_;
+  owners_[dn] = std::make_pair(generation_, last_modified_);
+}
+
+void JobStateIndex::SetState(const JobId& id, job_state_t state, bool pending) {
+  Glib::Mutex::Lock lock(lock_);
+  Entry& entry = jobs_[id];
+  entry.state = state;
+  entry.pending = pending;
+  entry.state_known = true;
+  touch(entry);
+}
+
+void JobStateIndex::SetLocal(const JobId& id, const std::string& dn, const std::string& sessiondir,
+                             const std::string& failed_state, const std::string& failed_cause) {
+  bool check_session = true;
+  {
+    Glib::Mutex::Lock lock(lock_);
+    std::map<JobId,Entry>::iterator it = jobs_.find(id);
+    if((it != jobs_.end()) && it->second.local_known && (it->second.sessiondir == sessiondir)) check_session = false;
+  };
+  // Session directory is checked once per job and without holding lock
+  bool session_exists = check_session && SessionDirExists(sessiondir);
+  Glib::Mutex::Lock lock(lock_);
+  Entry& entry = jobs_[id];
+  if(entry.local_known && (entry.dn != dn)) {
+    // Job disappears from listing of previous owner
+    std::map<std::string, std::set<JobId> >::iterator owner = owner_jobs_.find(entry.dn);
+    if(owner != owner_jobs_.end()) {
+      owner->second.erase(id);
+      if(owner->second.empty()) owner_jobs_.erase(owner);
+    };
+    touch(entry.dn);
+  };
+  if(!entry.local_known || (entry.sessiondir != sessiondir)) entry.session_exists = session_exists;
+  entry.dn = dn;
+  entry.sessiondir = sessiondir;
+  entry.failed_state = failed_state;
+  entry.failed_cause = failed_cause;
+  entry.local_known = true;
+  owner_jobs_[dn].insert(id);
+  touch(entry);
+}
+
+void JobStateIndex::SetFailed(const JobId& id, bool failed) {
+  Glib::Mutex::Lock lock(lock_);
+  std::map<JobId,Entry>::iterator it = jobs_.find(id);
+  // Failed mark alone does not tell owner of job
+  if(it == jobs_.end()) return;
+  if(it->second.failed == failed) return;
+  it->second.failed = failed;
+  touch(it->second);
+}
+
+void JobStateIndex::SetSession(const JobId& id, bool exists) {
+  Glib::Mutex::Lock lock(lock_);
+  std::map<JobId,Entry>::iterator it = jobs_.find(id);
+  if(it == jobs_.end()) return;
+  if(it->second.session_exists == exists) return;
+  it->second.session_exists = exists;
+  touch(it->second);
+}
+
+void JobStateIndex::Remove(const JobId& id) {
+  Glib::Mutex::Lock lock(lock_);
+  if(populating_) removed_.insert(id);
+  std::map<JobId,Entry>::iterator it = jobs_.find(id);
+  if(it == jobs_.end()) return;
+  std::string dn = it->second.dn;
+  if(it->second.local_known) {
+    std::map<std::string, std::set<JobId> >::iterator owner = owner_jobs_.find(dn);
+    if(owner != owner_jobs_.end()) {
+      owner->second.erase(id);
+      if(owner->second.empty()) owner_jobs_.erase(owner);
+    };
+  };
+  jobs_.erase(it);
+  if(!dn.empty()) touch(dn);
+}
+
+void JobStateIndex::Populate(const GMConfig& config, const std::list<JobId>& ids) {
+  {
+    Glib::Mutex::Lock lock(lock_);
+    if(complete_ || populating_) return;
+    populating_ = true;
+  };
+  for(std::list<JobId>::const_iterator id = ids.begin(); id != ids.end(); ++id) {
+    // Read files without holding lock
+    Entry entry;
+    entry.state = job_state_read_file(*id, config, entry.pending);
+    entry.state_known = true;
+    JobLocalDescription local;
+    if(job_local_read_file(*id, config, local)) {
+      entry.dn = local.DN;
+      entry.sessiondir = local.sessiondir;
+      entry.failed_state = local.failedstate;
+      entry.failed_cause = local.failedcause;
+      entry.local_known = true;
+      entry.session_exists = SessionDirExists(entry.sessiondir);
+    };
+    entry.failed = job_failed_mark_check(*id, config);
+    entry.modified = job_state_time(*id, config);
+    Glib::Mutex::Lock lock(lock_);
+    // Information reported while populating is more recent
+    if(removed_.find(*id) != removed_.end()) continue;
+    std::map<JobId,Entry>::iterator it = jobs_.find(*id);
+    if(it == jobs_.end()) {
+      jobs_[*id] = entry;
+      if(entry.local_known) owner_jobs_[entry.dn].insert(*id);
+      continue;
+    };
+    if(!(it->second.state_known)) {
+      it->second.state = entry.state;
+      it->second.pending = entry.pending;
+      it->second.state_known = true;
+    };
+    if(!(it->second.local_known) && entry.local_known) {
+      it->second.dn = entry.dn;
+      it->second.sessiondir = entry.sessiondir;
+      it->second.failed_state = entry.failed_state;
+      it->second.failed_cause = entry.failed_cause;
+      it->second.session_exists = entry.session_exists;
+      it->second.local_known = true;
+      owner_jobs_[entry.dn].insert(*id);
+    };
+  };
+  Glib::Mutex::Lock lock(lock_);
+  removed_.clear();
+  populating_ = false;
+  complete_ = true;
+  last_modified_ = time(NULL);
+  ++generation_;
+  // Listings of all owners become available
+  populated_generation_ = generation_;
+  populated_time_ = last_modified_;
+}
+
+bool JobStateIndex::Complete(void) {
+  Glib::Mutex::Lock lock(lock_);
+  return complete_;
+}
+
+bool JobStateIndex::Get(const JobId& id, Entry& entry) {
+  Glib::Mutex::Lock lock(lock_);
+  std::map<JobId,Entry>::iterator it = jobs_.find(id);
+  if(it == jobs_.end()) return false;
+  entry = it->second;
+  return true;
+}
+
+void JobStateIndex::Jobs(const std::string& dn, std::list<std::pair<JobId,Entry> >& jobs) {
+  Glib::Mutex::Lock lock(lock_);
+  std::map<std::string, std::set<JobId> >::iterator owner = owner_jobs_.find(dn);
+  if(owner == owner_jobs_.end()) return;
+  for(std::set<JobId>::iterator id = owner->second.begin(); id != owner->second.end(); ++id) {
+    std::map<JobId,Entry>::iterator it = jobs_.find(*id);
+    if((it == jobs_.end()) || !(it->second.state_known)) continue;
+    jobs.push_back(*it);
+  };
+}
+
+unsigned long long int JobStateIndex::Generation(void) {
+  Glib::Mutex::Lock lock(lock_);
+  return generation_;
+}
+
+time_t JobStateIndex::LastModified(void) {
+  Glib::Mutex::Lock lock(lock_);
+  return last_modified_;
+}
+
+unsigned long long int JobStateIndex::Generation(const std::string& dn) {
+  Glib::Mutex::Lock lock(lock_);
+  std::map<std::string, std::pair<unsigned long long int, time_t> >::iterator it = owners_.find(dn);
+  if((it == owners_.end()) || (it->second.first < populated_generation_)) return populated_generation_;
+  return it->second.first;
+}
+
+time_t JobStateIndex::LastModified(const std::string& dn) {
+  Glib::Mutex::Lock lock(lock_);
+  std::map<std::string, std::pair<unsigned long long int, time_t> >::iterator it = owners_.find(dn);
+  if((it == owners_.end()) || (it->second.second < populated_time_)) return populated_time_;
+  return it->second.second;
+}
+
+} // namespace ARex
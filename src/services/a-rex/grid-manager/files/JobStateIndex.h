@@ -0,0 +1,114 @@
+#ifndef GRID_MANAGER_JOB_STATE_INDEX_H
+#define GRID_MANAGER_JOB_STATE_INDEX_H
+
+#include <string>
+#include <list>
+#include <map>
+#include <set>
+#include <ctime>
+
+#include <glibmm/thread.h>
+
+#include "../jobs/GMJob.h"
+
+namespace ARex {
+
+class GMConfig;
+
+/// In-memory index of essential state of all jobs in control directory.
+/**
+ * Index is fed by functions writing control files (status, local, failed
+ * mark, final cleaning) so it reflects changes made by A-REX itself. It is
+ * populated once from control directory on first use. It allows job
+ * listings and state queries to be answered without reading control files
+ * or checking session directories for every job. Every change increments generation counter. Generation
+ * and time of last change are also kept per owner of jobs, so they can be
+ * used as validators of listings of jobs of one owner.
+ */
+class JobStateIndex {
+ public:
+  /// Essential information about one job
+  class Entry {
+   public:
+    std::string dn;
+    std::string sessiondir;
+    job_state_t state;
+    bool pending;
+    bool failed;
+    std::string failed_state;
+    std::string failed_cause;
+    time_t modified;
+    /// True if dn, sessiondir and failed_* are known (content of .local was seen)
+    bool local_known;
+    /// True if state is known (content of .status was seen)
+    bool state_known;
+    /// True if session directory exists
+    bool session_exists;
+    Entry(void):state(JOB_STATE_UNDEFINED),pending(false),failed(false),modified(0),local_known(false),state_known(false),session_exists(false) {};
+  };
+
+  JobStateIndex(void);
+
+  /// Record new state of job
+  void SetState(const JobId& id, job_state_t state, bool pending);
+  /// Record owner, session directory and failure information of job from its local description
+  void SetLocal(const JobId& id, const std::string& dn, const std::string& sessiondir,
+                const std::string& failed_state, const std::string& failed_cause);
+  /// Record presence or absence of failed mark.
+  /** Jobs not in index yet are ignored. */
+  void SetFailed(const JobId& id, bool failed);
+  /// Record creation or removal of session directory of job
+  void SetSession(const JobId& id, bool exists);
+  /// Remove job from index
+  void Remove(const JobId& id);
+
+  /// Fill index from control files of specified jobs unless already done.
+  /** Jobs changed while populating keep state reported through other
+    methods. If index is being populated by another thread returns
+    immediately. */
+  void Populate(const GMConfig& config, const std::list<JobId>& ids);
+  /// Returns true if index holds all jobs in control directory
+  bool Complete(void);
+
+  /// Get information about single job. Returns false if job is not in index.
+  bool Get(const JobId& id, Entry& entry);
+  /// Get all jobs owned by specified identity
+  void Jobs(const std::string& dn, std::list<std::pair<JobId,Entry> >& jobs);
+
+  /// Counter incremented on every change in index
+  unsigned long long int Generation(void);
+  /// Time of last change in index
+  time_t LastModified(void);
+  /// Generation of last change affecting jobs of specified owner
+  /** Values for different owners are taken from same counter, hence
+    they never decrease and change whenever any job of owner changes. */
+  unsigned long long int Generation(const std::string& dn);
+  /// Time of last change affecting jobs of specified owner
+  time_t LastModified(const std::string& dn);
+
+ private:
+  Glib::Mutex lock_;
+  std::map<JobId,Entry> jobs_;
+  /// Jobs removed while index was being populated
+  std::set<JobId> removed_;
+  bool complete_;
+  bool populating_;
+  unsigned long long int generation_;
+  time_t last_modified_;
+  /// Generation and time when index was completely populated
+  unsigned long long int populated_generation_;
+  time_t populated_time_;
+  /// Generation and time of last change per owner
+  std::map<std::string, std::pair<unsigned long long int, time_t> > owners_;
+  /// Jobs with known local description per owner
+  std::map<std::string, std::set<JobId> > owner_jobs_;
+
+  /// Mark change of index. Lock must be held.
+  void touch(Entry& entry);
+  /// Mark change of jobs of owner. Lock must be held.
+  void touch(const std::string& dn);
+};
+
+} // namespace ARex
+
+#endif // GRID_MANAGER_JOB_STATE_INDEX_H
@@ -0,0 +1,275 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <glibmm.h>
+
+#include <arc/Logger.h>
+#include <arc/StringConv.h>
+
+#include "ControlFileHandling.h"
+
+#include "JobStateJournal.h"
+
+namespace ARex {
+
+static Arc::Logger& logger = Arc::Logger::getRootLogger();
+
+const char* const JobStateJournal::file_name = "gm-jobstates";
+
+static const char* const journal_header = "# A-REX job states journal 1";
+
+// Rewrite journal when it holds that many obsolete records and more
+// than twice as many as valid ones.
+static const unsigned int compact_threshold = 10000;
+
+JobStateJournal::JobStateJournal(const std::string& control_dir):
+    control_dir_(control_dir),path_(control_dir+"/"+file_name),fd_(-1),obsolete_(0) {
+}
+
+JobStateJournal::~JobStateJournal(void) {
+  if(fd_ != -1) ::close(fd_);
+}
+
+std::string JobStateJournal::format(const JobId& id, const Record& record) {
+  std::string line = id;
+  line += " ";
+  line += GMJob::get_state_name(record.state);
+  line += record.pending ? " P " : " - ";
+  line += Arc::tostring(record.uid) + " " + Arc::tostring(record.gid) + " " + Arc::tostring(record.modified);
+  line += "\n";
+  return line;
+}
+
+bool JobStateJournal::parse(const std::string& line, JobId& id, Record& record, bool& removed) {
+  std::vector<std::string> tokens;
+  Arc::tokenize(line, tokens, " ");
+  if(tokens.size() == 2) {
+    if(tokens[1] != "-") return false;
+    id = tokens[0];
+    removed = true;
+    return true;
+  };
+  if(tokens.size() != 6) return false;
+  id = tokens[0];
+  removed = false;
+  record.state = GMJob::get_state(tokens[1].c_str());
+  if(record.state == JOB_STATE_UNDEFINED) return false;
+  if(tokens[2] == "P") record.pending = true;
+  else if(tokens[2] == "-") record.pending = false;
+  else return false;
+  if(!Arc::stringto(tokens[3], record.uid)) return false;
+  if(!Arc::stringto(tokens[4], record.gid)) return false;
+  if(!Arc::stringto(tokens[5], record.modified)) return false;
+  return true;
+}
+
+bool JobStateJournal::state_in_subdir(job_state_t state, const std::string& subdir) {
+  if(subdir.empty()) return true; // status files left by old versions
+  if(subdir == subdir_new) return (state == JOB_STATE_ACCEPTED);
+  if(subdir == subdir_old) return (state == JOB_STATE_FINISHED) || (state == JOB_STATE_DELETED);
+  if((subdir == subdir_cur) || (subdir == subdir_rew))
+    return (state != JOB_STATE_ACCEPTED) && (state != JOB_STATE_FINISHED) && (state != JOB_STATE_DELETED);
+  return false;
+}
+
+bool JobStateJournal::load(void) {
+  jobs_.clear();
+  obsolete_ = 0;
+  if(::access(path_.c_str(), F_OK) != 0) {
+    logger.msg(Arc::INFO, "Job state journal %s does not exist yet - jobs will be scanned", path_);
+    return true;
+  };
+  std::ifstream f(path_.c_str());
+  if(!f.is_open()) return false;
+  std::string line;
+  if(!std::getline(f, line) || (line != journal_header)) return false;
+  unsigned int lines = 0;
+  while(std::getline(f, line)) {
+    // Last line may be incomplete if A-REX was killed while writing it
+    if(f.eof()) break;
+    JobId id;
+    Record record;
+    bool removed = false;
+    if(!parse(line, id, record, removed)) {
+      logger.msg(Arc::WARNING, "Job state journal %s has unrecognized record at line %u", path_, lines+2);
+      return false;
+    };
+    ++lines;
+    if(removed) {
+      jobs_.erase(id);
+    } else {
+      jobs_[id] = record;
+    };
+  };
+  obsolete_ = lines - jobs_.size();
+  return true;
+}
+
+void JobStateJournal::check(void) {
+  // Only names of status files are collected here. That is cheap compared
+  // to checking every file.
+  std::map<JobId,std::string> found;
+  const char* subdirs[] = { "", subdir_new, subdir_cur, subdir_rew, subdir_old, NULL };
+  for(int n = 0; subdirs[n]; ++n) {
+    std::string dname = control_dir_;
+    if(subdirs[n][0]) dname += std::string("/") + subdirs[n];
+    try {
+      Glib::Dir dir(dname);
+      for(;;) {
+        std::string file = dir.read_name();
+        if(file.empty()) break;
+        int l = file.length();
+        if(l>(4+7) && file.substr(0,4) == "job." && file.substr(l-7) == ".status") {
+          found.insert(std::make_pair(file.substr(4,l-7-4), std::string(subdirs[n])));
+        };
+      };
+    } catch(Glib::FileError& e) {
+      // Missing subdirectory means there are no jobs in it
+    };
+  };
+  unsigned int dropped = 0;
+  for(std::map<JobId,Record>::iterator job = jobs_.begin(); job != jobs_.end();) {
+    std::map<JobId,std::string>::iterator f = found.find(job->first);
+    if((f == found.end()) || !state_in_subdir(job->second.state, f->second)) {
+      logger.msg(Arc::DEBUG, "%s: job state journal does not match control directory", job->first);
+      jobs_.erase(job++);
+      ++dropped;
+      continue;
+    };
+    ++job;
+  };
+  unsigned int missing = found.size() - jobs_.size();
+  logger.msg(Arc::INFO, "Job state journal has %u jobs, %u inconsistent records dropped, %u jobs will be scanned",
+             (unsigned int)jobs_.size(), dropped, missing);
+}
+
+bool JobStateJournal::compact(void) {
+  std::string tmp_path = path_ + ".new";
+  int h = ::open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+  if(h == -1) {
+    logger.msg(Arc::ERROR, "Failed to create job state journal %s", tmp_path);
+    return false;
+  };
+  std::string data = std::string(journal_header) + "\n";
+  for(std::map<JobId,Record>::iterator job = jobs_.begin(); job != jobs_.end(); ++job) {
+    data += format(job->first, job->second);
+  };
+  std::string::size_type pos = 0;
+  while(pos < data.length()) {
+    ssize_t l = ::write(h, data.c_str() + pos, data.length() - pos);
+    if(l == -1) {
+      if(errno == EINTR) continue;
+      break;
+    };
+    pos += l;
+  };
+  bool written = (pos == data.length()) && (::fsync(h) == 0);
+  if((::close(h) != 0) || !written || (::rename(tmp_path.c_str(), path_.c_str()) != 0)) {
+    logger.msg(Arc::ERROR, "Failed to write job state journal %s", tmp_path);
+    (void)::unlink(tmp_path.c_str());
+    return false;
+  };
+  if(fd_ != -1) ::close(fd_);
+  fd_ = ::open(path_.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+  obsolete_ = 0;
+  return (fd_ != -1);
+}
+
+void JobStateJournal::append(const std::string& line) {
+  if(fd_ == -1) return;
+  for(;;) {
+    // Records are small and written at once so they are never interleaved
+    ssize_t l = ::write(fd_, line.c_str(), line.length());
+    if((l == -1) && (errno == EINTR)) continue;
+    if(l == (ssize_t)line.length()) break;
+    // Journal missing records is worse than no journal at all
+    logger.msg(Arc::ERROR, "Failed to write job state journal %s - disabling it", path_);
+    ::close(fd_);
+    fd_ = -1;
+    (void)::unlink(path_.c_str());
+    return;
+  };
+  if((obsolete_ > compact_threshold) && (obsolete_ > 2*jobs_.size())) {
+    if(!compact()) {
+      if(fd_ != -1) ::close(fd_);
+      fd_ = -1;
+      (void)::unlink(path_.c_str());
+    };
+  };
+}
+
+bool JobStateJournal::Open(void) {
+  Glib::Mutex::Lock lock(lock_);
+  if(!load()) {
+    logger.msg(Arc::WARNING, "Job state journal %s can't be used - jobs will be scanned", path_);
+    jobs_.clear();
+  };
+  check();
+  return compact();
+}
+
+void JobStateJournal::Write(const JobId& id, job_state_t state, bool pending, uid_t uid, gid_t gid) {
+  Glib::Mutex::Lock lock(lock_);
+  Record record;
+  record.state = state;
+  record.pending = pending;
+  record.uid = uid;
+  record.gid = gid;
+  record.modified = time(NULL);
+  std::pair<std::map<JobId,Record>::iterator,bool> r = jobs_.insert(std::make_pair(id,record));
+  if(!r.second) {
+    r.first->second = record;
+    ++obsolete_;
+  };
+  append(format(id, record));
+}
+
+void JobStateJournal::Remove(const JobId& id) {
+  Glib::Mutex::Lock lock(lock_);
+  if(jobs_.erase(id) == 0) return;
+  obsolete_ += 2;
+  append(id + " -\n");
+}
+
+bool JobStateJournal::Get(const JobId& id, Record& record) {
+  Glib::Mutex::Lock lock(lock_);
+  std::map<JobId,Record>::iterator job = jobs_.find(id);
+  if(job == jobs_.end()) return false;
+  record = job->second;
+  return true;
+}
+
+bool JobStateJournal::Get(const std::string& dir, const JobId& id, uid_t& uid, gid_t& gid, time_t& t) {
+  std::string subdir;
+  if(dir != control_dir_) {
+    if((dir.length() <= control_dir_.length()) ||
+       (dir.compare(0, control_dir_.length(), control_dir_) != 0) ||
+       (dir[control_dir_.length()] != '/')) return false;
+    subdir = dir.substr(control_dir_.length()+1);
+  };
+  Record record;
+  if(!Get(id, record)) return false;
+  if(!state_in_subdir(record.state, subdir)) return false;
+  /* superuser can't run jobs */
+  if(record.uid == 0) return false;
+  /* accept any file if superuser */
+  if((getuid() != 0) && (record.uid != getuid())) return false;
+  uid = record.uid; gid = record.gid; t = record.modified;
+  return true;
+}
+
+unsigned int JobStateJournal::Size(void) {
+  Glib::Mutex::Lock lock(lock_);
+  return jobs_.size();
+}
+
+} // namespace ARex
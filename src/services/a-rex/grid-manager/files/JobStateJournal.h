@@ -0,0 +1,94 @@
+#ifndef GRID_MANAGER_JOB_STATE_JOURNAL_H
+#define GRID_MANAGER_JOB_STATE_JOURNAL_H
+
+#include <string>
+#include <map>
+#include <ctime>
+
+#include <sys/types.h>
+
+#include <glibmm/thread.h>
+
+#include "../jobs/GMJob.h"
+
+namespace ARex {
+
+/// Persistent journal of job states kept in control directory.
+/**
+ * Every change of job state written to status file is also appended to
+ * journal together with owner of status file and time of change. Removal
+ * of job is recorded too. At startup journal is read and checked against
+ * names of status files in control directory, so that jobs can be picked
+ * up without stat() and reading status file of every job - owner and
+ * time are taken from journal while scanning and state when job is picked
+ * up (see job_state_read_journal()). Entries which
+ * do not match location of status file are dropped and such jobs are
+ * handled by scanning their files as before. Journal is rewritten
+ * without obsolete records at startup and whenever it grows too much.
+ */
+class JobStateJournal {
+ public:
+  /// Journaled information about one job
+  class Record {
+   public:
+    job_state_t state;
+    bool pending;
+    uid_t uid;
+    gid_t gid;
+    time_t modified;
+    Record(void):state(JOB_STATE_UNDEFINED),pending(false),uid(0),gid(0),modified(0) {};
+  };
+
+  JobStateJournal(const std::string& control_dir);
+  ~JobStateJournal(void);
+
+  /// Read journal, check it against control directory and rewrite it.
+  /** Returns false if journal can't be written. Unreadable or corrupted
+    journal is discarded and rebuilt from following state changes. */
+  bool Open(void);
+  /// Returns true if journal is open for writing
+  operator bool(void) { return (fd_ != -1); };
+
+  /// Record new state of job
+  void Write(const JobId& id, job_state_t state, bool pending, uid_t uid, gid_t gid);
+  /// Record removal of job
+  void Remove(const JobId& id);
+
+  /// Get information about job
+  bool Get(const JobId& id, Record& record);
+  /// Get owner and modification time of job's status file residing in dir.
+  /** Returns false if job is unknown or its journaled state does not
+    match directory. Rules applied to owner are same as in check_file_owner(). */
+  bool Get(const std::string& dir, const JobId& id, uid_t& uid, gid_t& gid, time_t& t);
+  /// Number of jobs in journal
+  unsigned int Size(void);
+
+  /// Name of journal file in control directory
+  static const char* const file_name;
+
+ private:
+  std::string control_dir_;
+  std::string path_;
+  int fd_;
+  Glib::Mutex lock_;
+  std::map<JobId,Record> jobs_;
+  /// Number of records in file which are superseded by later ones
+  unsigned int obsolete_;
+
+  /// Load records from file
+  bool load(void);
+  /// Drop records not matching location of status files
+  void check(void);
+  /// Write all current records into new file and replace journal with it. Lock must be held.
+  bool compact(void);
+  /// Append line to journal. Lock must be held.
+  void append(const std::string& line);
+  static std::string format(const JobId& id, const Record& record);
+  static bool parse(const std::string& line, JobId& id, Record& record, bool& removed);
+  /// Check if state may be stored in subdirectory (empty for control directory itself)
+  static bool state_in_subdir(job_state_t state, const std::string& subdir);
+};
+
+} // namespace ARex
+
+#endif // GRID_MANAGER_JOB_STATE_JOURNAL_H
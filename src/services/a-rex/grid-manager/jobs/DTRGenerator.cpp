@@ -191,6 +191,7 @@ DTRGenerator::DTRGenerator(const GMConfig& config, JobsList& jobs) :
                       staging_conf.max_delivery,
                       staging_conf.max_emergency,
                       staging_conf.max_prepared);
+  scheduler->SetProcessorThreads(staging_conf.processor_threads);
 
   // Transfer shares
   DataStaging::TransferSharesConf share_conf(staging_conf.share_type,
@@ -203,6 +204,7 @@ DTRGenerator::DTRGenerator(const GMConfig& config, JobsList& jobs) :
   transfer_limits.averaging_time = staging_conf.min_speed_time;
   transfer_limits.min_average_bandwidth = staging_conf.min_average_speed;
   transfer_limits.max_inactivity_time = staging_conf.max_inactivity_time;
+  transfer_limits.vectored_io = staging_conf.vectored_io;
   scheduler->SetTransferParameters(transfer_limits);
 
   // URL mappings
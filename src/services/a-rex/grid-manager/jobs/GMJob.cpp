@@ -66,6 +66,8 @@ void GMJob::set_share(std::string share) {
 GMJob::GMJob(void) {
   job_state=JOB_STATE_UNDEFINED;
   job_pending=false;
+  job_dn_counted=false;
+  job_running_reserved=false;
   keep_finished=-1;
   keep_deleted=-1;
   child=NULL;
@@ -78,6 +80,8 @@ GMJob::GMJob(void) {
 GMJob::GMJob(const JobId &id,const Arc::User& u,const std::string &dir,job_state_t state) {
   job_state=state;
   job_pending=false;
+  job_dn_counted=false;
+  job_running_reserved=false;
   job_id=id;
   session_dir=dir;
   keep_finished=-1;
@@ -51,6 +51,11 @@ class GMJob {
   // Flag to indicate job stays at this stage due to limits imposed.
   // Such jobs are not counted in counters
   bool job_pending; 
+  // Job is accounted in per-DN counter of JobsList
+  bool job_dn_counted;
+  // Place under limit of running jobs is reserved for job till its
+  // new state is accounted in JobsList
+  bool job_running_reserved;
   // Job identifier
   JobId job_id;
   // Directory to run job in
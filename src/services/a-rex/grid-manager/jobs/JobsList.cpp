@@ -10,7 +10,9 @@
 #include <arc/credential/VOMSUtil.h>
 
 #include "../files/ControlFileHandling.h"
+#include "../files/JobStateJournal.h"
 #include "../run/RunParallel.h"
+#include "../run/LRMSHelper.h"
 #include "../mail/send_mail.h"
 #include "../log/JobLog.h"
 #include "../log/JobsMetrics.h"
@@ -67,48 +69,114 @@ void JobsList::ExternalHelpers::thread(void) {
 }
 
 
+JobsList::JobsShard::JobsShard(JobsList& list):
+    jobs_list(list), jobs_processing(ProcessingQueuePriority, "processing"), stop_request(false) {
+}
+
+JobsList::JobsShard::~JobsShard(void) {
+  Stop();
+}
+
+bool JobsList::JobsShard::Start(void) {
+  stop_request = false;
+  return Arc::CreateThreadFunction(&thread, this, &threads);
+}
+
+void JobsList::JobsShard::Stop(void) {
+  stop_request = true;
+  cond.signal();
+  threads.wait();
+}
+
+void JobsList::JobsShard::Kick(void) {
+  cond.signal();
+}
+
+void JobsList::JobsShard::thread(void* arg) {
+  JobsShard& it = *reinterpret_cast<JobsShard*>(arg);
+  while(!it.stop_request) {
+    it.jobs_list.ActJobsProcessing(it);
+    it.cond.wait();
+  };
+}
+
+
 JobsList::JobsList(const GMConfig& gmconfig) :
     valid(false),
-    jobs_processing(ProcessingQueuePriority, "processing"),
     jobs_attention(AttentionQueuePriority, "attention"),
     jobs_polling(0, "polling"),
     jobs_wait_for_running(WaitQueuePriority, "wait for running"),
     config(gmconfig), staging_config(gmconfig),
     dtr_generator(config, *this),
-    job_desc_handler(config), jobs_pending(0),
-    helpers(config.Helpers(), *this) {
+    job_desc_handler(config), jobs_pending(0), jobs_running_reserved(0),
+    helpers(config.Helpers(), *this),
+    lrms_helper(NULL) {
 
   job_slow_polling_last = time(NULL);
   job_slow_polling_dir = NULL;
 
   for(int n = 0;n<JOB_STATE_NUM;n++) jobs_num[n]=0;
   jobs_scripts = 0;
-  jobs.clear();
+  int shards_num = config.JobThreads();
+  if(shards_num < 1) shards_num = 1;
+  for(int n = 0;n<shards_num;n++) shards.push_back(new JobsShard(*this));
 
   if(!dtr_generator) {
     logger.msg(Arc::ERROR, "Failed to start data staging threads");
     return;
   };
 
+  if(shards.size() > 1) {
+    for(std::vector<JobsShard*>::iterator shard = shards.begin(); shard != shards.end(); ++shard) {
+      if(!(*shard)->Start()) {
+        logger.msg(Arc::ERROR, "Failed to start job processing threads");
+        return;
+      };
+    };
+    logger.msg(Arc::INFO, "Jobs are processed by %u threads", shards.size());
+  };
+
   helpers.start();
 
+  if(!config.LRMSHelperCommand().empty()) lrms_helper = new LRMSHelper(config, *this);
+
   valid = true;
 }
 
 JobsList::~JobsList(void) {
+  // Threads must not touch jobs while those are being destroyed
+  for(std::vector<JobsShard*>::iterator shard = shards.begin(); shard != shards.end(); ++shard) {
+    (*shard)->Stop();
+  };
+  for(std::vector<JobsShard*>::iterator shard = shards.begin(); shard != shards.end(); ++shard) {
+    delete *shard;
+  };
+  if(lrms_helper) delete lrms_helper;
+}
+
+JobsList::JobsShard& JobsList::Shard(const JobId& id) const {
+  if(shards.size() == 1) return *(shards.front());
+  // Simple string hash. Job ids are random enough.
+  unsigned int hash = 0;
+  for(std::string::size_type n = 0; n < id.length(); ++n) {
+    hash = hash * 31 + (unsigned char)(id[n]);
+  };
+  return *(shards[hash % shards.size()]);
 }
 
 GMJobRef JobsList::FindJob(const JobId &id) {
-  Glib::RecMutex::Lock lock(jobs_lock);
-  std::map<JobId,GMJobRef>::iterator ji = jobs.find(id);
-  if(ji == jobs.end()) return GMJobRef();
+  JobsShard& shard = Shard(id);
+  Glib::Mutex::Lock lock(shard.jobs_lock);
+  std::map<JobId,GMJobRef>::iterator ji = shard.jobs.find(id);
+  if(ji == shard.jobs.end()) return GMJobRef();
   return ji->second;
 }
 
 bool JobsList::HasJob(const JobId &id) const {
-  Glib::RecMutex::Lock lock(jobs_lock);
-  std::map<JobId,GMJobRef>::const_iterator ji = jobs.find(id);
-  return (ji != jobs.end());
+  JobsShard& shard = Shard(id);
+  Glib::Mutex::Lock lock(shard.jobs_lock);
+  std::map<JobId,GMJobRef>::const_iterator ji = shard.jobs.find(id);
+  return (ji != shard.jobs.end());
 }
 
 void JobsList::UpdateJobCredentials(GMJobRef i) {
@@ -190,22 +258,24 @@ bool JobsList::AddJob(const JobId &id,uid_t uid,gid_t gid,job_state_t state,cons
       logger.msg(Arc::ERROR, "%s: Failed reading .local and changing state, job and "
                              "A-REX may be left in an inconsistent state", id);
     }
-    Glib::RecMutex::Lock lock(jobs_lock);
-    if(jobs.find(id) != jobs.end()) {
+    JobsShard& shard = Shard(id);
+    Glib::Mutex::Lock lock(shard.jobs_lock);
+    if(shard.jobs.find(id) != shard.jobs.end()) {
       logger.msg(Arc::ERROR, "%s: unexpected failed job add request: %s", i->job_id, reason?reason:"");
     } else {
-      jobs[id] = i;
+      shard.jobs[id] = i;
       RequestReprocess(i); // To make job being properly thrown from system
     }
     return false;
   }
   i->session_dir = i->local->sessiondir;
   if (i->session_dir.empty()) i->session_dir = config.SessionRoot(id)+'/'+id;
-  Glib::RecMutex::Lock lock(jobs_lock);
-  if(jobs.find(id) != jobs.end()) {
+  JobsShard& shard = Shard(id);
+  Glib::Mutex::Lock lock(shard.jobs_lock);
+  if(shard.jobs.find(id) != shard.jobs.end()) {
     logger.msg(Arc::ERROR, "%s: unexpected job add request: %s", i->job_id, reason?reason:"");
   } else {
-    jobs[id] = i;
+    shard.jobs[id] = i;
     RequestAttention(i);
   }
   return true;
@@ -223,14 +293,34 @@ int JobsList::AcceptedJobs() const {
 bool JobsList::RunningJobsLimitReached() const {
   if(config.MaxRunning()==-1) return false;
   int num = jobs_num[JOB_STATE_SUBMITTING] +
-            jobs_num[JOB_STATE_INLRMS];
+            jobs_num[JOB_STATE_INLRMS] +
+            jobs_running_reserved;
   return num >= config.MaxRunning();
 }
 
+bool JobsList::ReserveRunningJob(GMJobRef i) {
+  // Check and reservation are done at once, otherwise several processing
+  // threads could pass limit simultaneously. Reservation is kept till new
+  // state of job is accounted in NextJob() or DropJob().
+  Glib::Mutex::Lock lock(jobs_running_lock);
+  if(RunningJobsLimitReached()) return false;
+  ++jobs_running_reserved;
+  i->job_running_reserved = true;
+  return true;
+}
+
+void JobsList::ReleaseRunningJob(GMJobRef i) {
+  if(!i->job_running_reserved) return;
+  i->job_running_reserved = false;
+  --jobs_running_reserved;
+}
+
 void JobsList::PrepareToDestroy(void) {
-  Glib::RecMutex::Lock lock(jobs_lock);
-  for(std::map<JobId,GMJobRef>::iterator i=jobs.begin();i!=jobs.end();++i) {
-    i->second->PrepareToDestroy();
+  for(std::vector<JobsShard*>::iterator shard = shards.begin(); shard != shards.end(); ++shard) {
+    Glib::Mutex::Lock lock((*shard)->jobs_lock);
+    for(std::map<JobId,GMJobRef>::iterator i=(*shard)->jobs.begin();i!=(*shard)->jobs.end();++i) {
+      i->second->PrepareToDestroy();
+    }
   }
 }
 
@@ -336,19 +426,29 @@ bool JobsList::RequestSlowPolling(GMJobRef i) {
 
 bool JobsList::RequestReprocess(GMJobRef i) {
   if(i) {
-    jobs_processing.Unpop(i);
+    Shard(i->job_id).jobs_processing.Unpop(i);
     return true;
   };
   return false;
 }
 
-bool JobsList::ActJobsProcessing(void) {
+void JobsList::ActJobsProcessing(JobsShard& shard) {
   while(true) {
-    GMJobRef i = jobs_processing.Pop();
+    GMJobRef i = shard.jobs_processing.Pop();
     if(!i) break;
     logger.msg(Arc::DEBUG, "%s: job being processed", i->job_id);
     ActJob(i);
   };
+}
+
+bool JobsList::ActJobsProcessing(void) {
+  if(shards.size() == 1) {
+    ActJobsProcessing(*(shards.front()));
+  } else {
+    for(std::vector<JobsShard*>::iterator shard = shards.begin(); shard != shards.end(); ++shard) {
+      if(!(*shard)->jobs_processing.IsEmpty()) (*shard)->Kick();
+    };
+  };
   // Check limit on number of running jobs and activate some of them if possible
   if(!RunningJobsLimitReached()) {
     GMJobRef i = jobs_wait_for_running.Pop();
@@ -362,7 +462,7 @@ bool JobsList::ActJobsAttention(void) {
     while(true) {
       GMJobRef i = jobs_attention.Pop();
       if(!i) break;
-      jobs_processing.Push(i);
+      Shard(i->job_id).jobs_processing.Push(i);
     };
   };
   ActJobsProcessing();
@@ -374,13 +474,13 @@ bool JobsList::ActJobsPolling(void) {
     while(true) {
       GMJobRef i = jobs_polling.Pop();
       if(!i) break;
-      jobs_processing.Push(i);
+      Shard(i->job_id).jobs_processing.Push(i);
     };
   };
   ActJobsProcessing();
   // debug info on jobs per DN
   {
-    Glib::RecMutex::Lock lock(jobs_lock);
+    Glib::Mutex::Lock lock(jobs_dn_lock);
     logger.msg(Arc::VERBOSE, "Current jobs in system (PREPARING to FINISHING) per-DN (%i entries)", jobs_dn.size());
     for (std::map<std::string, ZeroUInt>::iterator it = jobs_dn.begin(); it != jobs_dn.end(); ++it)
       logger.msg(Arc::VERBOSE, "%s: %i", it->first, (unsigned int)(it->second));
@@ -467,6 +567,7 @@ void JobsList::CleanChildProcess(GMJobRef i) {
     delete i->child; i->child=NULL;
     if((i->job_state == JOB_STATE_SUBMITTING) || (i->job_state == JOB_STATE_CANCELING)) --jobs_scripts;
   }
+  if(lrms_helper) lrms_helper->Forget(i->job_id);
 }
 
 bool JobsList::state_submitting_success(GMJobRef i,bool &state_changed,std::string local_id) {
@@ -498,8 +599,47 @@ bool JobsList::state_submitting_success(GMJobRef i,bool &state_changed,std::stri
 
 bool JobsList::state_submitting(GMJobRef i,bool &state_changed) {
   if(i->child == NULL) {
+    if(lrms_helper) {
+      // check if job was passed to LRMS helper
+      int result = -1;
+      std::string local_id;
+      Arc::Time started;
+      Arc::Time finished;
+      LRMSHelper::RequestState request_state =
+          lrms_helper->Check(LRMSHelper::Submit,i->job_id,result,local_id,started,finished);
+      if(request_state == LRMSHelper::Pending) {
+        // same protection as for lost child
+        if((Arc::Time() - started) > Arc::Period(CHILD_RUN_TIME_SUSPICIOUS)) {
+          local_id=job_desc_handler.get_local_id(i->job_id);
+          if(!local_id.empty()) {
+            logger.msg(Arc::ERROR,"%s: Job submission to LRMS takes too long, but ID is already obtained. Pretending submission is done.",i->job_id);
+            return state_submitting_success(i,state_changed,local_id);
+          }
+        }
+        if((Arc::Time() - started) > Arc::Period(CHILD_RUN_TIME_TOO_LONG)) {
+          CleanChildProcess(i);
+          logger.msg(Arc::ERROR,"%s: Job submission to LRMS takes too long. Failing.",i->job_id);
+          JobFailStateRemember(i,JOB_STATE_SUBMITTING);
+          i->AddFailure("Job submission to LRMS failed");
+          return false;
+        }
+        return true;
+      }
+      if(request_state == LRMSHelper::Done) {
+        logger.msg(Arc::INFO,"%s: state SUBMIT: LRMS helper finished with code %i",i->job_id,result);
+        if(result != 0) {
+          logger.msg(Arc::ERROR,"%s: Job submission to LRMS failed",i->job_id);
+          JobFailStateRemember(i,JOB_STATE_SUBMITTING);
+          CleanChildProcess(i);
+          i->AddFailure("Job submission to LRMS failed");
+          return false;
+        }
+        return state_submitting_success(i,state_changed,local_id);
+      }
+    }
     // no child was running yet, or recovering from fault
-    if((config.MaxScripts()!=-1) && (jobs_scripts>=config.MaxScripts())) {
+    // LRMS helper is not limited by number of scripts
+    if((!lrms_helper) && (config.MaxScripts()!=-1) && (jobs_scripts>=config.MaxScripts())) {
       //logger.msg(Arc::WARNING,"%s: Too many LRMS scripts running - limit is %u",
       //                     i->job_id,config.MaxScripts());
       // returning true but not advancing to next state should cause retry
@@ -530,12 +670,20 @@ bool JobsList::state_submitting(GMJobRef i,bool &state_changed) {
     // precreate file to store diagnostics from lrms
     job_diagnostics_mark_put(*i,config);
     job_lrmsoutput_mark_put(*i,config);
+    std::string grami = config.ControlDir()+"/job."+(*i).job_id+".grami";
+    job_errors_mark_put(*i,config);
+    if(lrms_helper) {
+      if(lrms_helper->Request(LRMSHelper::Submit,*i,grami)) {
+        logger.msg(Arc::INFO,"%s: state SUBMIT: passed to LRMS helper",i->job_id);
+        return true;
+      }
+      // helper is not available - use script within limits
+      if((config.MaxScripts()!=-1) && (jobs_scripts>=config.MaxScripts())) return true;
+    }
     // submit job to LRMS using submit-X-job
     std::string cmd = Arc::ArcLocation::GetDataDir()+"/submit-"+job_desc->lrms+"-job";
     logger.msg(Arc::INFO,"%s: state SUBMIT: starting child: %s",i->job_id,cmd);
-    std::string grami = config.ControlDir()+"/job."+(*i).job_id+".grami";
     cmd += " --config " + config.ConfigFile() + " " + grami;
-    job_errors_mark_put(*i,config);
     if(!RunParallel::run(config,*i,*this,cmd,&(i->child))) {
       i->AddFailure("Failed initiating job submission to LRMS");
       logger.msg(Arc::ERROR,"%s: Failed running submission process",i->job_id);
@@ -594,8 +742,17 @@ bool JobsList::state_canceling_success(GMJobRef i,bool &state_changed) {
   // job diagnostics collection done in background (scan-*-job script)
   if(!job_lrms_mark_check(i->job_id,config)) {
     // job diag not yet collected - come later
-    if((i->child->ExitTime() != Arc::Time::UNDEFINED) &&
-       ((Arc::Time() - i->child->ExitTime()) > Arc::Period(Arc::Time::HOUR))) {
+    Arc::Time exit_time(Arc::Time::UNDEFINED);
+    if(i->child) {
+      exit_time = i->child->ExitTime();
+    } else if(lrms_helper) {
+      int result = -1;
+      std::string local_id;
+      Arc::Time started;
+      lrms_helper->Check(LRMSHelper::Cancel,i->job_id,result,local_id,started,exit_time);
+    }
+    if((exit_time != Arc::Time::UNDEFINED) &&
+       ((Arc::Time() - exit_time) > Arc::Period(Arc::Time::HOUR))) {
       // it takes too long
       logger.msg(Arc::ERROR,"%s: state CANCELING: timeout waiting for cancellation",i->job_id);
       CleanChildProcess(i);
@@ -614,8 +771,41 @@ bool JobsList::state_canceling_success(GMJobRef i,bool &state_changed) {
 
 bool JobsList::state_canceling(GMJobRef i,bool &state_changed) {
   if(i->child == NULL) {
+    if(lrms_helper) {
+      // check if job was passed to LRMS helper
+      int result = -1;
+      std::string local_id;
+      Arc::Time started;
+      Arc::Time finished;
+      LRMSHelper::RequestState request_state =
+          lrms_helper->Check(LRMSHelper::Cancel,i->job_id,result,local_id,started,finished);
+      if(request_state == LRMSHelper::Pending) {
+        // same protection as for lost child
+        if((Arc::Time() - started) > Arc::Period(CHILD_RUN_TIME_SUSPICIOUS)) {
+          if(job_lrms_mark_check(i->job_id,config)) {
+            logger.msg(Arc::ERROR,"%s: Job cancellation takes too long, but diagnostic collection seems to be done. Pretending cancellation succeeded.",i->job_id);
+            return state_canceling_success(i,state_changed);
+          }
+        }
+        if((Arc::Time() - started) > Arc::Period(CHILD_RUN_TIME_TOO_LONG)) {
+          logger.msg(Arc::ERROR,"%s: Job cancellation takes too long. Failing.",i->job_id);
+          CleanChildProcess(i);
+          return false;
+        }
+        return true;
+      }
+      if(request_state == LRMSHelper::Done) {
+        if(result != 0) {
+          logger.msg(Arc::ERROR,"%s: Failed to cancel running job",i->job_id);
+          CleanChildProcess(i);
+          return false;
+        }
+        return state_canceling_success(i,state_changed);
+      }
+    }
     // no child was running yet, or recovering from fault
-    if((config.MaxScripts()!=-1) && (jobs_scripts>=config.MaxScripts())) {
+    // LRMS helper is not limited by number of scripts
+    if((!lrms_helper) && (config.MaxScripts()!=-1) && (jobs_scripts>=config.MaxScripts())) {
       //logger.msg(Arc::WARNING,"%s: Too many LRMS scripts running - limit is %u",
       //                     i->job_id,config.MaxScripts());
       // returning true but not advancing to next state should cause retry
@@ -638,8 +828,16 @@ bool JobsList::state_canceling(GMJobRef i,bool &state_changed) {
       return true;
     }
     std::string grami = config.ControlDir()+"/job."+(*i).job_id+".grami";
-    cmd += " --config " + config.ConfigFile() + " " + grami;
     job_errors_mark_put(*i,config);
+    if(lrms_helper) {
+      if(lrms_helper->Request(LRMSHelper::Cancel,*i,grami)) {
+        logger.msg(Arc::INFO,"%s: state CANCELING: passed to LRMS helper",i->job_id);
+        return true;
+      }
+      // helper is not available - use script within limits
+      if((config.MaxScripts()!=-1) && (jobs_scripts>=config.MaxScripts())) return true;
+    }
+    cmd += " --config " + config.ConfigFile() + " " + grami;
     if(!RunParallel::run(config,*i,*this,cmd,&(i->child))) {
       logger.msg(Arc::ERROR,"%s: Failed running cancellation process",i->job_id);
       return false;
@@ -873,7 +1071,8 @@ JobsList::ActJobResult JobsList::ActJobUndefined(GMJobRef i) {
   // under the limit of maximum jobs allowed in the system
   if((AcceptedJobs() < config.MaxJobs()) || (config.MaxJobs() == -1)) {
     bool new_pending = false;
-    job_state_t new_state=job_state_read_file(i->job_id,config,new_pending);
+    // Journal verified against control directory at startup saves reading status file
+    job_state_t new_state=job_state_read_journal(i->job_id,config,new_pending);
     if(new_state == JOB_STATE_UNDEFINED) { // something failed
       logger.msg(Arc::ERROR,"%s: Reading status of new job failed",i->job_id);
       i->AddFailure("Failed reading status of the job");
@@ -970,11 +1169,26 @@ JobsList::ActJobResult JobsList::ActJobAccepted(GMJobRef i) {
   // TODO: do it in ActJobUndefined. Otherwise one DN can block others if total limit is reached.
 
 
+  // check for user specified time
+  if(i->local->processtime != -1 && (i->local->processtime) > time(NULL)) {
+    logger.msg(Arc::INFO,"%s: State: ACCEPTED: has process time %s",i->job_id.c_str(),
+        i->local->processtime.str(Arc::UserTime));
+    // No events for start times yet. Do polling.
+    RequestPolling(i);
+    return JobSuccess;
+  }
   if (config.MaxPerDN() > 0) {
     bool limited = false;
     {
-      Glib::RecMutex::Lock lock(jobs_lock);
-      limited = (jobs_dn[i->local->DN] >= config.MaxPerDN());
+      // Job is accounted together with check, otherwise several processing
+      // threads could pass limit simultaneously.
+      Glib::Mutex::Lock lock(jobs_dn_lock);
+      ZeroUInt& dn_jobs = jobs_dn[i->local->DN];
+      limited = (dn_jobs >= config.MaxPerDN());
+      if (!limited) {
+        ++dn_jobs;
+        i->job_dn_counted = true;
+      }
     }
     if (limited) {
       SetJobPending(i,"Jobs per DN limit is reached");
@@ -983,14 +1197,6 @@ JobsList::ActJobResult JobsList::ActJobAccepted(GMJobRef i) {
       return JobSuccess;
     }
   }
-  // check for user specified time
-  if(i->local->processtime != -1 && (i->local->processtime) > time(NULL)) {
-    logger.msg(Arc::INFO,"%s: State: ACCEPTED: has process time %s",i->job_id.c_str(),
-        i->local->processtime.str(Arc::UserTime));
-    // No events for start times yet. Do polling.
-    RequestPolling(i);
-    return JobSuccess;
-  }
   logger.msg(Arc::INFO,"%s: State: ACCEPTED: moving to PREPARING",i->job_id);
   SetJobState(i, JOB_STATE_PREPARING, "Starting job processing");
   i->Start();
@@ -1042,7 +1248,7 @@ JobsList::ActJobResult JobsList::ActJobPreparing(GMJobRef i) {
         // RequestPolling(i);
       } else if(i->local->exec.size() > 0 && !i->local->exec.front().empty()) {
         // Job has executable
-        if(!RunningJobsLimitReached()) {
+        if(ReserveRunningJob(i)) {
           // And limit of running jobs is not reached
           SetJobState(i, JOB_STATE_SUBMITTING, "Pre-staging finished, passing job to LRMS");
           RequestReprocess(i); // act on new state immediately
@@ -1363,17 +1569,18 @@ bool JobsList::CheckJobContinuePlugins(GMJobRef i) {
 
 bool JobsList::NextJob(GMJobRef i, job_state_t old_state, bool old_pending) {
   bool at_limit = RunningJobsLimitReached();
-  // update counters
-  if(!old_pending) {
-    jobs_num[old_state]--;
-  } else {
-    jobs_pending--;
-  }
+  // update counters, new state first so that limits are never undercounted
   if(!i->job_pending) {
     jobs_num[i->job_state]++;
   } else {
     jobs_pending++;
   }
+  if(!old_pending) {
+    jobs_num[old_state]--;
+  } else {
+    jobs_pending--;
+  }
+  ReleaseRunningJob(i);
   if(at_limit && !RunningJobsLimitReached()) {
     // Report about change in conditions
     //RequestAttention();
@@ -1389,13 +1596,15 @@ bool JobsList::DropJob(GMJobRef& i, job_state_t old_state, bool old_pending) {
   } else {
     jobs_pending--;
   }
+  ReleaseRunningJob(i);
   if(at_limit && !RunningJobsLimitReached()) {
     // Report about change in conditions
     RequestAttention(); // TODO: Check if really needed
   };
   {
-    Glib::RecMutex::Lock lock(jobs_lock);
-    jobs.erase(i->job_id);
+    JobsShard& shard = Shard(i->job_id);
+    Glib::Mutex::Lock lock(shard.jobs_lock);
+    shard.jobs.erase(i->job_id);
   };
   i.Destroy();
   return true;
@@ -1501,24 +1710,22 @@ bool JobsList::ActJob(GMJobRef& i) {
     if(job_result != JobFailed) send_mail(*i,config);
 
     // Manage per-DN counter
-    // Any job state change goes through here
-    if(!IS_ACTIVE_STATE(old_state)) {
-      if(IS_ACTIVE_STATE(i->job_state)) {
-        if(i->GetLocalDescription(config)) {
+    // Any job state change goes through here. Job leaving ACCEPTED may
+    // be already accounted while checking per-DN limit.
+    bool active = IS_ACTIVE_STATE(i->job_state);
+    if(active != i->job_dn_counted) {
+      if(i->GetLocalDescription(config)) {
+        Glib::Mutex::Lock lock(jobs_dn_lock);
+        if(active) {
           // add to DN map
           if (i->local->DN.empty()) {
              logger.msg(Arc::WARNING, "Failed to get DN information from .local file for job %s", i->job_id);
           }
-          Glib::RecMutex::Lock lock(jobs_lock);
           ++(jobs_dn[i->local->DN]);
-        };
-      };
-    } else if(IS_ACTIVE_STATE(old_state)) {
-      if(!IS_ACTIVE_STATE(i->job_state)) {
-        if(i->GetLocalDescription(config)) {
-          Glib::RecMutex::Lock lock(jobs_lock);
+        } else {
           if (--(jobs_dn[i->local->DN]) == 0) jobs_dn.erase(i->local->DN);
         };
+        i->job_dn_counted = active;
       };
     };
   } else if(old_pending != i->job_pending) {
@@ -1620,7 +1827,9 @@ bool JobsList::RestartJobs(const std::string& cdir,const std::string& odir) {
         time_t t;
         std::string fname=cdir+'/'+file.c_str();
         std::string oname=odir+'/'+file.c_str();
-        if(check_file_owner(fname,uid,gid,t)) {
+        JobStateJournal* journal = config.GetJobStateJournal();
+        if((journal && journal->Get(cdir,file.substr(4,l-7-4),uid,gid,t)) ||
+           check_file_owner(fname,uid,gid,t)) {
           if(::rename(fname.c_str(),oname.c_str()) != 0) {
             logger.msg(Arc::ERROR,"Failed to move file %s to %s",fname,oname);
             res=false;
@@ -1671,12 +1880,12 @@ bool JobsList::ScanJobDescs(const std::string& cdir,std::list<JobFDesc>& ids) co
   };
 
   Arc::JobPerfRecord perfrecord(*config.GetJobPerfLog(), "*");
-  bool result = ScanAllJobs(cdir, ids, JobFilterSkipExisting(*this));
+  bool result = ScanAllJobs(cdir, ids, JobFilterSkipExisting(*this), config.GetJobStateJournal());
   perfrecord.End("SCAN-JOBS");
   return result;
 }
 
-bool JobsList::ScanAllJobs(const std::string& cdir,std::list<JobFDesc>& ids, JobFilter const& filter) {
+bool JobsList::ScanAllJobs(const std::string& cdir,std::list<JobFDesc>& ids, JobFilter const& filter, JobStateJournal* journal) {
   try {
     Glib::Dir dir(cdir);
     for(;;) {
@@ -1691,7 +1900,9 @@ bool JobsList::ScanAllJobs(const std::string& cdir,std::list<JobFDesc>& ids, Job
           uid_t uid;
           gid_t gid;
           time_t t;
-          if(check_file_owner(fname,uid,gid,t)) {
+          // Journal saves stat() of every file if it knows the job
+          if((journal && journal->Get(cdir,id.id,uid,gid,t)) ||
+             check_file_owner(fname,uid,gid,t)) {
             // add it to the list
             id.uid=uid; id.gid=gid; id.t=t;
             ids.push_back(id);
@@ -1765,7 +1976,8 @@ bool JobsList::ScanOldJob(const JobId& id) {
   std::string cdir=config.ControlDir();
   std::string ndir=cdir+"/"+subdir_old;
   if(!ScanJobDesc(ndir,fid)) return false;
-  job_state_t st = job_state_read_file(id,config);
+  bool pending = false;
+  job_state_t st = job_state_read_journal(id,config,pending);
   if(st == JOB_STATE_FINISHED || st == JOB_STATE_DELETED) {
     return AddJob(fid.id,fid.uid,fid.gid,st,"scan for specific old job");
   };
@@ -1860,7 +2072,7 @@ bool JobsList::GetAllJobs(const GMConfig& config, std::list<GMJobRef>& alljobs)
     std::string cdir=config.ControlDir();
     std::list<JobFDesc> ids;
     std::string odir=cdir+(*subdir);
-    if(!ScanAllJobs(odir,ids,JobFilterNoSkip())) return false;
+    if(!ScanAllJobs(odir,ids,JobFilterNoSkip(),config.GetJobStateJournal())) return false;
     // sorting by date
     ids.sort();
     for(std::list<JobFDesc>::iterator id=ids.begin();id!=ids.end();++id) {
@@ -1894,7 +2106,7 @@ bool JobsList::GetAllJobIds(const GMConfig& config, std::list<JobId>& alljobs) {
     std::string cdir=config.ControlDir();
     std::list<JobFDesc> ids;
     std::string odir=cdir+(*subdir);
-    if(!ScanAllJobs(odir,ids,JobFilterNoSkip())) return false;
+    if(!ScanAllJobs(odir,ids,JobFilterNoSkip(),config.GetJobStateJournal())) return false;
     // sorting by date
     ids.sort();
     for(std::list<JobFDesc>::iterator id=ids.begin();id!=ids.end();++id) {
@@ -1951,7 +2163,7 @@ int JobsList::CountAllJobs(const GMConfig& config) {
     std::string cdir=config.ControlDir();
     std::list<JobFDesc> ids;
     std::string odir=cdir+(*subdir);
-    if(ScanAllJobs(odir,ids,JobFilterNoSkip())) {
+    if(ScanAllJobs(odir,ids,JobFilterNoSkip(),config.GetJobStateJournal())) {
       count += ids.size();
     };
   };
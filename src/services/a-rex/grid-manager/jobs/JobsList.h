@@ -2,7 +2,9 @@
 #define GRID_MANAGER_STATES_H
 
 #include <sys/types.h>
+#include <atomic>
 #include <list>
+#include <vector>
 #include <glib.h>
 
 #include <arc/Thread.h>
@@ -17,6 +19,8 @@ namespace ARex {
 
 class JobFDesc;
 class GMConfig;
+class JobStateJournal;
+class LRMSHelper;
 
 /// ZeroUInt is a wrapper around unsigned int. It provides a consistent default
 /// value, as int type variables have no predefined value assigned upon
@@ -46,14 +50,40 @@ class JobsList {
  private:
   bool valid;
 
-  // List of jobs currently tracked in memory conveniently indexed by identifier.
-  // TODO: It would be nice to remove it and use status files distribution among
-  // subfolders in controldir.
-  std::map<JobId,GMJobRef> jobs;         
+  // Part of jobs currently tracked in memory. Jobs are distributed among shards
+  // by their identifiers. Every shard has own lock and own processing queue.
+  // If there is more than one shard every shard also has own thread which
+  // processes jobs from its queue. Hence job is never processed by two threads
+  // simultaneously.
+  class JobsShard {
+   public:
+    JobsShard(JobsList& list);
+    ~JobsShard(void);
+    // Start processing thread
+    bool Start(void);
+    // Ask processing thread to exit and wait for it
+    void Stop(void);
+    // Wake up processing thread
+    void Kick(void);
+    JobsList& jobs_list;
+    // Jobs conveniently indexed by identifier.
+    // TODO: It would be nice to remove it and use status files distribution among
+    // subfolders in controldir.
+    std::map<JobId,GMJobRef> jobs;
+    mutable Glib::Mutex jobs_lock;
+    GMJobQueue jobs_processing; // List of jobs currently scheduled for processing
+   private:
+    Arc::SimpleCondition cond;
+    Arc::SimpleCounter threads;
+    std::atomic<bool> stop_request;
+    static void thread(void* arg);
+  };
 
-  mutable Glib::RecMutex jobs_lock;
+  // Shards of jobs list. There is at least one.
+  std::vector<JobsShard*> shards;
 
-  GMJobQueue jobs_processing;   // List of jobs currently scheduled for processing
+  // Shard to which job with specified id belongs
+  JobsShard& Shard(const JobId& id) const;
 
   GMJobQueue jobs_attention;    // List of jobs which need attention
   Arc::SimpleCondition jobs_attention_cond;
@@ -76,12 +106,17 @@ class JobsList {
   // Job description handler
   JobDescriptionHandler job_desc_handler;
   // number of jobs for every state
-  int jobs_num[JOB_STATE_NUM];
-  int jobs_scripts;
+  std::atomic<int> jobs_num[JOB_STATE_NUM];
+  std::atomic<int> jobs_scripts;
   // map of number of active jobs for each DN
   std::map<std::string, ZeroUInt> jobs_dn;
+  Glib::Mutex jobs_dn_lock;
   // number of jobs currently in pending state
-  int jobs_pending;
+  std::atomic<int> jobs_pending;
+  // number of jobs allowed to start running but not yet accounted in jobs_num
+  std::atomic<int> jobs_running_reserved;
+  // serializes checking and reserving against limit of running jobs
+  Glib::Mutex jobs_running_lock;
 
   // Add job into list. It is supposed to be called only for jobs which are not in main list.
   bool AddJob(const JobId &id,uid_t uid,gid_t gid,job_state_t state,const char* reason = NULL);
@@ -150,6 +185,11 @@ class JobsList {
   // Helper method for ActJob. Finishes processing of job, removes it from list.
   bool DropJob(GMJobRef& i, job_state_t old_state, bool old_pending);
 
+  // Reserve place for job under limit of running jobs. Returns false if limit is reached.
+  bool ReserveRunningJob(GMJobRef i);
+  // Release place reserved by ReserveRunningJob()
+  void ReleaseRunningJob(GMJobRef i);
+
   enum ActJobResult {
     JobSuccess,
     JobFailed,
@@ -190,9 +230,13 @@ class JobsList {
   // Returns false if job is not allowed to continue.
   bool CheckJobContinuePlugins(GMJobRef i);
 
-  // Call ActJob for all jobs in processing queue
+  // Call ActJob for all jobs in processing queue or wake up processing
+  // threads if those are used
   bool ActJobsProcessing(void);
 
+  // Call ActJob for all jobs in processing queue of shard
+  void ActJobsProcessing(JobsShard& shard);
+
   // Inform this instance that job with specified id needs immediate re-processing
   bool RequestReprocess(GMJobRef i);
 
@@ -260,6 +304,9 @@ class JobsList {
   /// Associated external processes
   ExternalHelpers helpers;
 
+  /// Persistent process for submitting and cancelling jobs, NULL if scripts are used
+  LRMSHelper* lrms_helper;
+
   // Return iterator to object matching given id or null if not found
   GMJobRef FindJob(const JobId &id);
 
@@ -342,7 +389,8 @@ class JobsList {
   // Look for all jobs residing in specified control directories.
   // Fils ids with information about those jobs.
   // Uses filter to skip jobs which do not fit filter requirments.
-  static bool ScanAllJobs(const std::string& cdir,std::list<JobFDesc>& ids, JobFilter const& filter);
+  // If journal is given it is used instead of checking status files of known jobs.
+  static bool ScanAllJobs(const std::string& cdir,std::list<JobFDesc>& ids, JobFilter const& filter, JobStateJournal* journal = NULL);
   
 
   // Collect all jobs in all states and return references to their descriptions in alljobs.
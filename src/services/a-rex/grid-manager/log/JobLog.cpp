@@ -29,7 +29,7 @@ namespace ARex {
 
 static Arc::Logger& logger = Arc::Logger::getRootLogger();
 
-JobLog::JobLog(void):filename(""),reporter_proc(NULL),reporter_last_run(0),reporter_period(3600) {
+JobLog::JobLog(void):filename(""),reporter_proc(NULL),reporter_last_run(0),reporter_period(3600),accounting_db_wal(false) {
 }
 
 void JobLog::SetOutput(const char* fname) {
@@ -165,13 +165,17 @@ static AccountingDB* AccountingDBCtor(std::string const & name) {
   return new AccountingDBSQLite(name);
 }
 
+static AccountingDB* AccountingDBWALCtor(std::string const & name) {
+  return new AccountingDBSQLite(name, true);
+}
+
 bool JobLog::WriteJobRecord(GMJob &job, const GMConfig& config) {
   bool r = true;
   timespec tstart;
   clock_gettime(CLOCK_MONOTONIC, &tstart);
   // Create accounting DB connection
   std::string accounting_db_path = config.ControlDir() + G_DIR_SEPARATOR_S + ACCOUNTING_SUBDIR + G_DIR_SEPARATOR_S + ACCOUNTING_DB_FILE;
-  AccountingDBAsync adb(accounting_db_path, &AccountingDBCtor);
+  AccountingDBAsync adb(accounting_db_path, accounting_db_wal ? &AccountingDBWALCtor : &AccountingDBCtor);
   if (!adb.IsValid()) {
     logger.msg(Arc::ERROR,": Failure creating accounting database connection");
     r = false;
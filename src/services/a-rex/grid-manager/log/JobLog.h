@@ -29,6 +29,7 @@ class JobLog {
   Arc::Run *reporter_proc;
   time_t reporter_last_run;
   int reporter_period;
+  bool accounting_db_wal;
 
   bool open_stream(std::ofstream &o);
   static void initializer(void* arg);
@@ -58,6 +59,8 @@ class JobLog {
   void SetCredentials(std::string const &key_path,std::string const &certificate_path,std::string const &ca_certificates_dir);
   /* Set accounting options (e.g. batch size for SGAS LUTS) */
   void SetOptions(std::string const &options) { report_config.push_back(std::string("accounting_options=")+options); }
+  /* Use write-ahead log journal for accounting database */
+  void SetAccountingDBWAL(bool wal) { accounting_db_wal = wal; }
 };
 
 } // namespace ARex
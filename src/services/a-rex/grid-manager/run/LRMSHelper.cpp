@@ -0,0 +1,225 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <vector>
+
+#include <arc/Logger.h>
+#include <arc/StringConv.h>
+
+#include "../conf/GMConfig.h"
+#include "../jobs/JobsList.h"
+#include "LRMSHelper.h"
+
+namespace ARex {
+
+static Arc::Logger& logger = Arc::Logger::getRootLogger();
+
+// Do not restart failing helper more often than that (seconds)
+#define HELPER_RESTART_PERIOD (60)
+// Time to wait for helper to accept request or to exit (seconds)
+#define HELPER_IO_TIMEOUT (10)
+
+void LRMSHelper::Output::Append(char const* data, unsigned int size) {
+  buffer_.append(data, size);
+  for(;;) {
+    std::string::size_type p = buffer_.find('\n');
+    if(p == std::string::npos) break;
+    std::string line = buffer_.substr(0, p);
+    buffer_.erase(0, p+1);
+    helper_.reply(line);
+  };
+}
+
+void LRMSHelper::Output::Remove(unsigned int size) {
+  buffer_.erase(0, size);
+}
+
+char const* LRMSHelper::Output::Get() const {
+  return buffer_.c_str();
+}
+
+unsigned int LRMSHelper::Output::Size() const {
+  return buffer_.length();
+}
+
+LRMSHelper::LRMSHelper(const GMConfig& config, JobsList& list):
+    config_(config), list_(list), output_(*this), proc_(NULL), exited_(false),
+    last_start_(Arc::Time::UNDEFINED) {
+}
+
+LRMSHelper::~LRMSHelper(void) {
+  Glib::Mutex::Lock wlock(write_lock_);
+  stop();
+}
+
+bool LRMSHelper::start(void) {
+  if(proc_) {
+    {
+      Glib::Mutex::Lock lock(lock_);
+      if(!exited_) return true;
+    };
+    // Process is gone - its exit was already handled by kicker
+    delete proc_; proc_ = NULL;
+  };
+  if((last_start_ != Arc::Time::UNDEFINED) &&
+     ((Arc::Time() - last_start_) < Arc::Period(HELPER_RESTART_PERIOD))) return false;
+  last_start_ = Arc::Time();
+  std::string cmd = config_.LRMSHelperCommand() + " --config " + config_.ConfigFile();
+  logger.msg(Arc::INFO, "Starting LRMS helper: %s", cmd);
+  Arc::Run* re = new Arc::Run(cmd);
+  if(!(*re)) {
+    delete re;
+    logger.msg(Arc::ERROR, "Failure creating slot for LRMS helper");
+    return false;
+  };
+  re->KeepStdin(false);
+  re->KeepStdout(false);
+  re->KeepStderr(true);
+  re->AssignStdout(output_);
+  re->AssignKicker(&kicker, this);
+  {
+    Glib::Mutex::Lock lock(lock_);
+    exited_ = false;
+  };
+  if(!re->Start()) {
+    delete re;
+    logger.msg(Arc::ERROR, "Failure starting LRMS helper");
+    return false;
+  };
+  proc_ = re;
+  return true;
+}
+
+void LRMSHelper::stop(bool wait) {
+  if(!proc_) return;
+  // Helper is expected to exit when its input is closed
+  proc_->CloseStdin();
+  if(!wait || !proc_->Wait(HELPER_IO_TIMEOUT)) proc_->Kill(1);
+  delete proc_; proc_ = NULL;
+}
+
+bool LRMSHelper::Request(Operation op, const GMJob& job, const std::string& grami) {
+  Glib::Mutex::Lock wlock(write_lock_);
+  if(!start()) return false;
+  {
+    Glib::Mutex::Lock lock(lock_);
+    requests_.erase(job.get_id());
+    requests_.insert(std::make_pair(job.get_id(), RequestInfo(op)));
+  };
+  std::string line = (op == Submit) ? "SUBMIT " : "CANCEL ";
+  line += job.get_id() + " " + Arc::tostring(job.get_user().get_uid()) + " " +
+          Arc::tostring(job.get_user().get_gid()) + " " + grami + "\n";
+  std::string::size_type pos = 0;
+  while(pos < line.length()) {
+    int l = proc_->WriteStdin(HELPER_IO_TIMEOUT*1000, line.c_str()+pos, line.length()-pos);
+    if(l <= 0) break;
+    pos += l;
+  };
+  if(pos < line.length()) {
+    logger.msg(Arc::ERROR, "%s: Failed passing request to LRMS helper", job.get_id());
+    {
+      Glib::Mutex::Lock lock(lock_);
+      requests_.erase(job.get_id());
+    };
+    // Helper which does not accept requests is of no use. Partially written
+    // request also makes stream unusable.
+    stop();
+    exited();
+    return false;
+  };
+  return true;
+}
+
+LRMSHelper::RequestState LRMSHelper::Check(Operation op, const JobId& id, int& result, std::string& local_id,
+                                           Arc::Time& started, Arc::Time& finished) {
+  Glib::Mutex::Lock lock(lock_);
+  std::map<JobId,RequestInfo>::iterator r = requests_.find(id);
+  if((r == requests_.end()) || (r->second.op != op)) return Unknown;
+  started = r->second.started;
+  if(!r->second.done) return Pending;
+  result = r->second.result;
+  local_id = r->second.local_id;
+  finished = r->second.finished;
+  return Done;
+}
+
+void LRMSHelper::Forget(const JobId& id) {
+  {
+    Glib::Mutex::Lock lock(lock_);
+    std::map<JobId,RequestInfo>::iterator r = requests_.find(id);
+    if(r == requests_.end()) return;
+    bool pending = !r->second.done;
+    requests_.erase(r);
+    if(!pending) return;
+  };
+  // Helper would still process abandoned request and job could end up in
+  // LRMS while being handled otherwise. Same as with timed out script the
+  // only way to prevent that is to kill helper. Its other pending requests
+  // are retried when its exit is noticed.
+  logger.msg(Arc::WARNING, "%s: Abandoning request to LRMS helper - stopping helper", id);
+  Glib::Mutex::Lock wlock(write_lock_);
+  stop(false);
+  exited();
+}
+
+void LRMSHelper::reply(const std::string& line) {
+  std::vector<std::string> tokens;
+  Arc::tokenize(line, tokens, " ");
+  int result = -1;
+  Operation op = Submit;
+  if((tokens.size() < 3) || (tokens.size() > 4) ||
+     ((tokens[1] != "SUBMIT") && (tokens[1] != "CANCEL")) ||
+     !Arc::stringto(tokens[2], result)) {
+    logger.msg(Arc::ERROR, "Unrecognized reply from LRMS helper: %s", line);
+    return;
+  };
+  if(tokens[1] == "CANCEL") op = Cancel;
+  {
+    Glib::Mutex::Lock lock(lock_);
+    std::map<JobId,RequestInfo>::iterator r = requests_.find(tokens[0]);
+    if((r == requests_.end()) || (r->second.op != op) || r->second.done) {
+      logger.msg(Arc::WARNING, "%s: Unexpected reply from LRMS helper: %s", tokens[0], line);
+      return;
+    };
+    r->second.done = true;
+    r->second.result = result;
+    if(tokens.size() > 3) r->second.local_id = tokens[3];
+    r->second.finished = Arc::Time();
+  };
+  logger.msg(Arc::DEBUG, "%s: LRMS helper finished request with code %i", tokens[0], result);
+  list_.RequestAttention(tokens[0]);
+}
+
+void LRMSHelper::exited(void) {
+  std::list<JobId> lost;
+  bool noticed = false;
+  {
+    Glib::Mutex::Lock lock(lock_);
+    noticed = exited_;
+    exited_ = true;
+    for(std::map<JobId,RequestInfo>::iterator r = requests_.begin(); r != requests_.end();) {
+      if(!r->second.done) {
+        lost.push_back(r->first);
+        requests_.erase(r++);
+        continue;
+      };
+      ++r;
+    };
+  };
+  // Stopped helper may be reported again by kicker
+  if(noticed && lost.empty()) return;
+  logger.msg(Arc::WARNING, "LRMS helper exited, %u pending requests will be retried",
+             (unsigned int)lost.size());
+  // Jobs will check for LRMS id obtained before helper exited and
+  // otherwise resubmit or cancel using helper or scripts.
+  for(std::list<JobId>::iterator id = lost.begin(); id != lost.end(); ++id) {
+    list_.RequestAttention(*id);
+  };
+}
+
+void LRMSHelper::kicker(void* arg) {
+  reinterpret_cast<LRMSHelper*>(arg)->exited();
+}
+
+} // namespace ARex
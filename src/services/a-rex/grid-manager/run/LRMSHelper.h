@@ -0,0 +1,118 @@
+#ifndef GRID_MANAGER_LRMS_HELPER_H
+#define GRID_MANAGER_LRMS_HELPER_H
+
+#include <string>
+#include <map>
+#include <list>
+
+#include <glibmm/thread.h>
+
+#include <arc/DateTime.h>
+#include <arc/Run.h>
+
+#include "../jobs/GMJob.h"
+
+namespace ARex {
+
+class GMConfig;
+class JobsList;
+
+/// Persistent process submitting and cancelling jobs in LRMS.
+/**
+ * Instead of running submit-*-job and cancel-*-job for every job, requests
+ * are written to standard input of single long-living helper process, one
+ * per line:
+ *   SUBMIT <job id> <uid> <gid> <grami file>
+ *   CANCEL <job id> <uid> <gid> <grami file>
+ * Helper may process requests in any order and combine several of them into
+ * one call to LRMS. For every request it writes one line to standard output:
+ *   <job id> SUBMIT <code> [<LRMS job id>]
+ *   <job id> CANCEL <code>
+ * Code has same meaning as exit code of corresponding script. If LRMS job id
+ * is missing it is taken from grami file same way as after submit-*-job.
+ * Helper is started with same arguments as scripts except grami file. When
+ * helper is not available jobs are handled by scripts.
+ */
+class LRMSHelper {
+ public:
+  enum Operation {
+    Submit,
+    Cancel
+  };
+  enum RequestState {
+    /// No request for job
+    Unknown,
+    /// Request is being processed by helper
+    Pending,
+    /// Helper reported result
+    Done
+  };
+
+  LRMSHelper(const GMConfig& config, JobsList& list);
+  ~LRMSHelper(void);
+
+  /// Pass request to helper. Returns false if helper is not usable and job must be processed by script.
+  bool Request(Operation op, const GMJob& job, const std::string& grami);
+  /// Check request for job. Result is kept till Forget() is called.
+  RequestState Check(Operation op, const JobId& id, int& result, std::string& local_id,
+                     Arc::Time& started, Arc::Time& finished);
+  /// Discard request for job.
+  /** If helper did not report result yet it is killed, so that abandoned
+    request is not processed behind A-REX's back. */
+  void Forget(const JobId& id);
+
+ private:
+  /// Collects standard output of helper and passes complete lines for processing
+  class Output: public Arc::Run::Data {
+   public:
+    Output(LRMSHelper& helper):helper_(helper) { };
+    virtual ~Output(void) { };
+    virtual void Append(char const* data, unsigned int size);
+    virtual void Remove(unsigned int size);
+    virtual char const* Get() const;
+    virtual unsigned int Size() const;
+   private:
+    LRMSHelper& helper_;
+    std::string buffer_;
+  };
+
+  class RequestInfo {
+   public:
+    Operation op;
+    bool done;
+    int result;
+    std::string local_id;
+    Arc::Time started;
+    Arc::Time finished;
+    RequestInfo(Operation o):op(o),done(false),result(-1),finished(Arc::Time::UNDEFINED) { };
+  };
+
+  const GMConfig& config_;
+  JobsList& list_;
+  Output output_;
+  Arc::Run* proc_;
+  /// Helper process exited and requests sent to it are lost
+  bool exited_;
+  Arc::Time last_start_;
+  std::map<JobId,RequestInfo> requests_;
+  /// Protects requests_ and exited_
+  Glib::Mutex lock_;
+  /// Serializes writing to helper and its restarts
+  Glib::Mutex write_lock_;
+
+  /// Start helper if it is not running. Write lock must be held.
+  bool start(void);
+  /// Stop helper. Write lock must be held.
+  /** If wait is true helper is given time to finish requests it already has. */
+  void stop(bool wait = true);
+  /// Process reply line from helper
+  void reply(const std::string& line);
+  /// Drop requests not completed by exited or stopped helper and wake up their jobs
+  void exited(void);
+  /// Called when helper exits
+  static void kicker(void* arg);
+};
+
+} // namespace ARex
+
+#endif // GRID_MANAGER_LRMS_HELPER_H
@@ -111,7 +111,14 @@ bool RunParallel::run(const GMConfig& config, const Arc::User& user,
     logger.msg(Arc::ERROR,"%s: Failure creating data storage for child process",procid?procid:"");
     return false;
   };
-  re->AssignInitializer(&initializer,rp);
+  if(cred) {
+    re->AssignInitializer(&initializer,rp);
+  } else {
+    // Nothing to do in child, so process can be started without initializer
+    re->RedirectStdin("/dev/null");
+    re->RedirectStdout("/dev/null");
+    re->RedirectStderr((errlog && errlog[0])?errlog:"/dev/null");
+  };
   if(su) {
     // change user
     re->AssignUserId(user.get_uid());
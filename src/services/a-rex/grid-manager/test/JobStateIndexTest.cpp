@@ -0,0 +1,221 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <list>
+#include <string>
+
+#include <sys/stat.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <arc/FileUtils.h>
+#include <arc/StringConv.h>
+#include <arc/User.h>
+
+#include "../conf/GMConfig.h"
+#include "../jobs/GMJob.h"
+#include "../files/ControlFileContent.h"
+#include "../files/ControlFileHandling.h"
+#include "../files/JobStateIndex.h"
+
+using namespace ARex;
+
+class JobStateIndexTest
+  : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(JobStateIndexTest);
+  CPPUNIT_TEST(TestRecord);
+  CPPUNIT_TEST(TestOwnerGeneration);
+  CPPUNIT_TEST(TestChangeOwner);
+  CPPUNIT_TEST(TestPopulate);
+  CPPUNIT_TEST(TestSession);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp();
+  void tearDown();
+  void TestRecord();
+  void TestOwnerGeneration();
+  void TestChangeOwner();
+  void TestPopulate();
+  void TestSession();
+
+private:
+  std::string controldir;
+};
+
+static const std::string owner1("/O=Grid/CN=Owner 1");
+static const std::string owner2("/O=Grid/CN=Owner 2");
+
+void JobStateIndexTest::setUp() {
+  CPPUNIT_ASSERT(Arc::TmpDirCreate(controldir));
+  CPPUNIT_ASSERT(Arc::DirCreate(controldir + "/accepting", S_IRWXU));
+  CPPUNIT_ASSERT(Arc::DirCreate(controldir + "/processing", S_IRWXU));
+  CPPUNIT_ASSERT(Arc::DirCreate(controldir + "/finished", S_IRWXU));
+  CPPUNIT_ASSERT(Arc::DirCreate(controldir + "/restarting", S_IRWXU));
+}
+
+void JobStateIndexTest::tearDown() {
+  Arc::DirDelete(controldir);
+}
+
+void JobStateIndexTest::TestRecord() {
+  JobStateIndex index;
+  JobStateIndex::Entry entry;
+  CPPUNIT_ASSERT(!index.Get("job1", entry));
+
+  index.SetState("job1", JOB_STATE_ACCEPTED, false);
+  CPPUNIT_ASSERT(index.Get("job1", entry));
+  CPPUNIT_ASSERT(entry.state_known);
+  CPPUNIT_ASSERT(!entry.local_known);
+  CPPUNIT_ASSERT_EQUAL(JOB_STATE_ACCEPTED, entry.state);
+
+  index.SetLocal("job1", owner1, "/session/job1", "", "");
+  index.SetState("job1", JOB_STATE_INLRMS, true);
+  index.SetFailed("job1", true);
+  CPPUNIT_ASSERT(index.Get("job1", entry));
+  CPPUNIT_ASSERT(entry.local_known);
+  CPPUNIT_ASSERT_EQUAL(owner1, entry.dn);
+  CPPUNIT_ASSERT_EQUAL(std::string("/session/job1"), entry.sessiondir);
+  CPPUNIT_ASSERT_EQUAL(JOB_STATE_INLRMS, entry.state);
+  CPPUNIT_ASSERT(entry.pending);
+  CPPUNIT_ASSERT(entry.failed);
+
+  index.SetLocal("job2", owner2, "/session/job2", "", "");
+  std::list<std::pair<JobId,JobStateIndex::Entry> > jobs;
+  index.Jobs(owner1, jobs);
+  CPPUNIT_ASSERT_EQUAL(1, (int)jobs.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("job1"), jobs.front().first);
+
+  index.Remove("job1");
+  CPPUNIT_ASSERT(!index.Get("job1", entry));
+  jobs.clear();
+  index.Jobs(owner1, jobs);
+  CPPUNIT_ASSERT(jobs.empty());
+}
+
+void JobStateIndexTest::TestOwnerGeneration() {
+  JobStateIndex index;
+  index.SetLocal("job1", owner1, "/session/job1", "", "");
+  index.SetLocal("job2", owner2, "/session/job2", "", "");
+  unsigned long long int gen1 = index.Generation(owner1);
+  unsigned long long int gen2 = index.Generation(owner2);
+  CPPUNIT_ASSERT(gen1 != gen2);
+
+  // Changes of jobs of one owner do not affect generation of another
+  index.SetState("job2", JOB_STATE_PREPARING, false);
+  index.SetFailed("job2", true);
+  CPPUNIT_ASSERT_EQUAL(gen1, index.Generation(owner1));
+  CPPUNIT_ASSERT(index.Generation(owner2) > gen2);
+  CPPUNIT_ASSERT_EQUAL(index.Generation(), index.Generation(owner2));
+
+  gen2 = index.Generation(owner2);
+  index.SetState("job1", JOB_STATE_PREPARING, false);
+  CPPUNIT_ASSERT(index.Generation(owner1) > gen1);
+  CPPUNIT_ASSERT_EQUAL(gen2, index.Generation(owner2));
+
+  // Removing job changes generation of its owner
+  gen1 = index.Generation(owner1);
+  index.Remove("job1");
+  CPPUNIT_ASSERT(index.Generation(owner1) > gen1);
+  CPPUNIT_ASSERT_EQUAL(gen2, index.Generation(owner2));
+  // Failed mark of unknown job does not create entry
+  unsigned long long int gen = index.Generation();
+  index.SetFailed("job1", true);
+  JobStateIndex::Entry entry;
+  CPPUNIT_ASSERT(!index.Get("job1", entry));
+  CPPUNIT_ASSERT_EQUAL(gen, index.Generation());
+  // Removing unknown job changes nothing
+  gen1 = index.Generation(owner1);
+  index.Remove("job1");
+  CPPUNIT_ASSERT_EQUAL(gen1, index.Generation(owner1));
+}
+
+void JobStateIndexTest::TestChangeOwner() {
+  JobStateIndex index;
+  index.SetLocal("job1", owner1, "/session/job1", "", "");
+  unsigned long long int gen1 = index.Generation(owner1);
+  // Job disappears from listing of previous owner
+  index.SetLocal("job1", owner2, "/session/job1", "", "");
+  CPPUNIT_ASSERT(index.Generation(owner1) > gen1);
+  std::list<std::pair<JobId,JobStateIndex::Entry> > jobs;
+  index.Jobs(owner1, jobs);
+  CPPUNIT_ASSERT(jobs.empty());
+  index.Jobs(owner2, jobs);
+  CPPUNIT_ASSERT_EQUAL(1, (int)jobs.size());
+}
+
+void JobStateIndexTest::TestPopulate() {
+  GMConfig config;
+  config.SetControlDir(controldir);
+  std::list<JobId> ids;
+  for(int n = 1; n <= 3; ++n) {
+    std::string id = "job" + Arc::tostring(n);
+    GMJob job(id, Arc::User(), controldir + "/" + id);
+    JobLocalDescription local;
+    local.DN = (n == 3) ? owner2 : owner1;
+    local.sessiondir = controldir + "/" + id;
+    CPPUNIT_ASSERT(job_local_write_file(job, config, local));
+    CPPUNIT_ASSERT(job_state_write_file(job, config, (n == 1) ? JOB_STATE_FINISHED : JOB_STATE_INLRMS, false));
+    ids.push_back(id);
+  }
+
+  JobStateIndex index;
+  // Changes reported while populating are more recent than control files
+  index.SetState("job2", JOB_STATE_FINISHING, false);
+  CPPUNIT_ASSERT(!index.Complete());
+  index.Populate(config, ids);
+  CPPUNIT_ASSERT(index.Complete());
+
+  JobStateIndex::Entry entry;
+  CPPUNIT_ASSERT(index.Get("job1", entry));
+  CPPUNIT_ASSERT_EQUAL(JOB_STATE_FINISHED, entry.state);
+  CPPUNIT_ASSERT_EQUAL(owner1, entry.dn);
+  CPPUNIT_ASSERT_EQUAL(controldir + "/job1", entry.sessiondir);
+  CPPUNIT_ASSERT(!entry.session_exists);
+  CPPUNIT_ASSERT(index.Get("job2", entry));
+  CPPUNIT_ASSERT_EQUAL(JOB_STATE_FINISHING, entry.state);
+  CPPUNIT_ASSERT_EQUAL(owner1, entry.dn);
+
+  std::list<std::pair<JobId,JobStateIndex::Entry> > jobs;
+  index.Jobs(owner1, jobs);
+  CPPUNIT_ASSERT_EQUAL(2, (int)jobs.size());
+  jobs.clear();
+  index.Jobs(owner2, jobs);
+  CPPUNIT_ASSERT_EQUAL(1, (int)jobs.size());
+
+  // Owners not seen before population get generation of population
+  CPPUNIT_ASSERT_EQUAL(index.Generation(), index.Generation(owner1));
+  CPPUNIT_ASSERT_EQUAL(index.Generation(), index.Generation(owner2));
+  CPPUNIT_ASSERT_EQUAL(index.Generation(), index.Generation("/O=Grid/CN=Nobody"));
+}
+
+void JobStateIndexTest::TestSession() {
+  JobStateIndex index;
+  std::string sessiondir = controldir + "/job1";
+  // Session directory is created after local description is written
+  index.SetLocal("job1", owner1, sessiondir, "", "");
+  JobStateIndex::Entry entry;
+  CPPUNIT_ASSERT(index.Get("job1", entry));
+  CPPUNIT_ASSERT(!entry.session_exists);
+  CPPUNIT_ASSERT(Arc::DirCreate(sessiondir, S_IRWXU));
+  unsigned long long int gen1 = index.Generation(owner1);
+  index.SetSession("job1", true);
+  CPPUNIT_ASSERT(index.Get("job1", entry));
+  CPPUNIT_ASSERT(entry.session_exists);
+  CPPUNIT_ASSERT(index.Generation(owner1) > gen1);
+
+  // Existing session directory is found when job is first seen
+  index.SetLocal("job2", owner1, sessiondir, "", "");
+  CPPUNIT_ASSERT(index.Get("job2", entry));
+  CPPUNIT_ASSERT(entry.session_exists);
+
+  // Rewriting local description keeps recorded state
+  index.SetSession("job1", false);
+  index.SetLocal("job1", owner1, sessiondir, "", "");
+  CPPUNIT_ASSERT(index.Get("job1", entry));
+  CPPUNIT_ASSERT(!entry.session_exists);
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(JobStateIndexTest);
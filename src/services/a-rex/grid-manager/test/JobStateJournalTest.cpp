@@ -0,0 +1,223 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <fstream>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <arc/FileUtils.h>
+#include <arc/StringConv.h>
+#include <arc/User.h>
+
+#include "../conf/GMConfig.h"
+#include "../jobs/GMJob.h"
+#include "../files/ControlFileHandling.h"
+#include "../files/JobStateJournal.h"
+
+using namespace ARex;
+
+class JobStateJournalTest
+  : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(JobStateJournalTest);
+  CPPUNIT_TEST(TestReplay);
+  CPPUNIT_TEST(TestCheck);
+  CPPUNIT_TEST(TestCorrupted);
+  CPPUNIT_TEST(TestCompaction);
+  CPPUNIT_TEST(TestReadState);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp();
+  void tearDown();
+  void TestReplay();
+  void TestCheck();
+  void TestCorrupted();
+  void TestCompaction();
+  void TestReadState();
+
+private:
+  std::string controldir;
+  std::string journal;
+  void WriteStatus(const std::string& subdir, const std::string& id, const std::string& state);
+  unsigned int JournalLines();
+};
+
+void JobStateJournalTest::setUp() {
+  CPPUNIT_ASSERT(Arc::TmpDirCreate(controldir));
+  CPPUNIT_ASSERT(Arc::DirCreate(controldir + "/accepting", S_IRWXU));
+  CPPUNIT_ASSERT(Arc::DirCreate(controldir + "/processing", S_IRWXU));
+  CPPUNIT_ASSERT(Arc::DirCreate(controldir + "/finished", S_IRWXU));
+  CPPUNIT_ASSERT(Arc::DirCreate(controldir + "/restarting", S_IRWXU));
+  journal = controldir + "/" + JobStateJournal::file_name;
+}
+
+void JobStateJournalTest::tearDown() {
+  Arc::DirDelete(controldir);
+}
+
+void JobStateJournalTest::WriteStatus(const std::string& subdir, const std::string& id, const std::string& state) {
+  CPPUNIT_ASSERT(Arc::FileCreate(controldir + "/" + subdir + "/job." + id + ".status", state + "\n"));
+}
+
+unsigned int JobStateJournalTest::JournalLines() {
+  std::ifstream f(journal.c_str());
+  unsigned int lines = 0;
+  std::string line;
+  while(std::getline(f, line)) ++lines;
+  return lines;
+}
+
+void JobStateJournalTest::TestReplay() {
+  {
+    JobStateJournal j(controldir);
+    CPPUNIT_ASSERT(j.Open());
+    CPPUNIT_ASSERT_EQUAL(0U, j.Size());
+    j.Write("job1", JOB_STATE_ACCEPTED, false, 1000, 1000);
+    j.Write("job1", JOB_STATE_INLRMS, true, 1000, 1000);
+    j.Write("job2", JOB_STATE_FINISHED, false, 1001, 1002);
+    j.Write("job3", JOB_STATE_PREPARING, false, 1000, 1000);
+    j.Remove("job3");
+  }
+  WriteStatus("processing", "job1", "INLRMS");
+  WriteStatus("finished", "job2", "FINISHED");
+
+  JobStateJournal j(controldir);
+  CPPUNIT_ASSERT(j.Open());
+  CPPUNIT_ASSERT_EQUAL(2U, j.Size());
+  JobStateJournal::Record record;
+  CPPUNIT_ASSERT(j.Get("job1", record));
+  CPPUNIT_ASSERT_EQUAL(JOB_STATE_INLRMS, record.state);
+  CPPUNIT_ASSERT(record.pending);
+  CPPUNIT_ASSERT(j.Get("job2", record));
+  CPPUNIT_ASSERT_EQUAL(JOB_STATE_FINISHED, record.state);
+  CPPUNIT_ASSERT(!record.pending);
+  CPPUNIT_ASSERT_EQUAL((uid_t)1001, record.uid);
+  CPPUNIT_ASSERT_EQUAL((gid_t)1002, record.gid);
+  CPPUNIT_ASSERT(!j.Get("job3", record));
+  // Journal is rewritten without obsolete records when opened
+  CPPUNIT_ASSERT_EQUAL(3U, JournalLines());
+}
+
+void JobStateJournalTest::TestCheck() {
+  {
+    JobStateJournal j(controldir);
+    CPPUNIT_ASSERT(j.Open());
+    j.Write("job1", JOB_STATE_INLRMS, false, 1000, 1000);
+    j.Write("job2", JOB_STATE_INLRMS, false, 1000, 1000);
+    j.Write("job3", JOB_STATE_INLRMS, false, 1000, 1000);
+  }
+  // Status file of job1 is where journal expects it, job2 was moved
+  // to finished behind journal's back and job3 has no status file.
+  WriteStatus("processing", "job1", "INLRMS");
+  WriteStatus("finished", "job2", "FINISHED");
+
+  JobStateJournal j(controldir);
+  CPPUNIT_ASSERT(j.Open());
+  JobStateJournal::Record record;
+  CPPUNIT_ASSERT(j.Get("job1", record));
+  CPPUNIT_ASSERT(!j.Get("job2", record));
+  CPPUNIT_ASSERT(!j.Get("job3", record));
+
+  uid_t uid;
+  gid_t gid;
+  time_t t;
+  if(getuid() == 0) {
+    CPPUNIT_ASSERT(j.Get(controldir + "/processing", "job1", uid, gid, t));
+    CPPUNIT_ASSERT_EQUAL((uid_t)1000, uid);
+  }
+  // State does not belong to that subdirectory
+  CPPUNIT_ASSERT(!j.Get(controldir + "/accepting", "job1", uid, gid, t));
+}
+
+void JobStateJournalTest::TestCorrupted() {
+  {
+    JobStateJournal j(controldir);
+    CPPUNIT_ASSERT(j.Open());
+    j.Write("job1", JOB_STATE_INLRMS, false, 1000, 1000);
+  }
+  WriteStatus("processing", "job1", "INLRMS");
+  WriteStatus("processing", "job2", "INLRMS");
+  {
+    // Incomplete last line left by killed process is ignored
+    std::ofstream f(journal.c_str(), std::ios::app);
+    f << "job2 INLRMS - 1000";
+  }
+  {
+    JobStateJournal j(controldir);
+    CPPUNIT_ASSERT(j.Open());
+    JobStateJournal::Record record;
+    CPPUNIT_ASSERT(j.Get("job1", record));
+    CPPUNIT_ASSERT(!j.Get("job2", record));
+  }
+  {
+    // Garbage makes whole journal unusable
+    std::ofstream f(journal.c_str(), std::ios::app);
+    f << "garbage\n";
+  }
+  JobStateJournal j(controldir);
+  CPPUNIT_ASSERT(j.Open());
+  CPPUNIT_ASSERT_EQUAL(0U, j.Size());
+  CPPUNIT_ASSERT_EQUAL(1U, JournalLines());
+}
+
+void JobStateJournalTest::TestCompaction() {
+  JobStateJournal j(controldir);
+  CPPUNIT_ASSERT(j.Open());
+  j.Write("job1", JOB_STATE_INLRMS, false, 1000, 1000);
+  // Obsolete records are dropped once there are many of them
+  for(int n = 0; n < 10010; ++n) {
+    j.Write("job2", (n % 2) ? JOB_STATE_INLRMS : JOB_STATE_SUBMITTING, false, 1000, 1000);
+  }
+  CPPUNIT_ASSERT(j);
+  CPPUNIT_ASSERT(JournalLines() < 100);
+  JobStateJournal::Record record;
+  CPPUNIT_ASSERT(j.Get("job2", record));
+  CPPUNIT_ASSERT_EQUAL(JOB_STATE_INLRMS, record.state);
+
+  // Compacted journal is replayed correctly
+  WriteStatus("processing", "job1", "INLRMS");
+  WriteStatus("processing", "job2", "INLRMS");
+  JobStateJournal j2(controldir);
+  CPPUNIT_ASSERT(j2.Open());
+  CPPUNIT_ASSERT_EQUAL(2U, j2.Size());
+  CPPUNIT_ASSERT(j2.Get("job2", record));
+  CPPUNIT_ASSERT_EQUAL(JOB_STATE_INLRMS, record.state);
+}
+
+void JobStateJournalTest::TestReadState() {
+  GMConfig config;
+  config.SetControlDir(controldir);
+  GMJob job1("job1", Arc::User(), controldir + "/job1");
+  GMJob job2("job2", Arc::User(), controldir + "/job2");
+  {
+    JobStateJournal j(controldir);
+    CPPUNIT_ASSERT(j.Open());
+    config.SetJobStateJournal(&j);
+    CPPUNIT_ASSERT(job_state_write_file(job1, config, JOB_STATE_INLRMS, true));
+    config.SetJobStateJournal(NULL);
+  }
+  CPPUNIT_ASSERT(job_state_write_file(job2, config, JOB_STATE_PREPARING, false));
+
+  JobStateJournal j(controldir);
+  CPPUNIT_ASSERT(j.Open());
+  config.SetJobStateJournal(&j);
+  // State of journaled job comes from journal. Status file is changed here
+  // without journal knowing to make sure it is not read.
+  WriteStatus("processing", "job1", "FINISHING");
+  bool pending = false;
+  CPPUNIT_ASSERT_EQUAL(JOB_STATE_INLRMS, job_state_read_journal("job1", config, pending));
+  CPPUNIT_ASSERT(pending);
+  // Unknown job is read from status file
+  pending = true;
+  CPPUNIT_ASSERT_EQUAL(JOB_STATE_PREPARING, job_state_read_journal("job2", config, pending));
+  CPPUNIT_ASSERT(!pending);
+  config.SetJobStateJournal(NULL);
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(JobStateJournalTest);
@@ -0,0 +1,151 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <fstream>
+#include <string>
+
+#include <unistd.h>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <arc/FileUtils.h>
+#include <arc/JobPerfLog.h>
+#include <arc/User.h>
+#include <arc/Utils.h>
+
+#include "../conf/GMConfig.h"
+#include "../jobs/GMJob.h"
+#include "../jobs/JobsList.h"
+#include "../log/JobLog.h"
+#include "../run/LRMSHelper.h"
+
+using namespace ARex;
+
+// Requests are passed to mock-lrms-helper.sh which replies after
+// MOCK_LRMS_HELPER_DELAY seconds.
+
+class LRMSHelperTest
+  : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(LRMSHelperTest);
+  CPPUNIT_TEST(TestSubmit);
+  CPPUNIT_TEST(TestAbandon);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp();
+  void tearDown();
+  void TestSubmit();
+  void TestAbandon();
+
+private:
+  std::string controldir;
+  GMConfig* config;
+  JobLog* joblog;
+  Arc::JobPerfLog* perflog;
+  JobsList* jobs;
+  std::string Grami(const JobId& id);
+  bool HasLRMSId(const JobId& id);
+};
+
+void LRMSHelperTest::setUp() {
+  CPPUNIT_ASSERT(Arc::TmpDirCreate(controldir));
+  std::string conf = controldir + "/arc.conf";
+  CPPUNIT_ASSERT(Arc::FileCreate(conf,
+      "[lrms]\n"
+      "lrms=fork\n"
+      "lrmshelper=/bin/bash " MOCK_LRMS_HELPER "\n"
+      "[arex]\n"
+      "controldir=" + controldir + "\n"));
+  Arc::SetEnv("MOCK_LRMS_HELPER_DELAY", "2");
+  config = new GMConfig(conf);
+  CPPUNIT_ASSERT(config->Load());
+  CPPUNIT_ASSERT(!config->LRMSHelperCommand().empty());
+  joblog = new JobLog;
+  perflog = new Arc::JobPerfLog;
+  config->SetJobLog(joblog);
+  config->SetJobPerfLog(perflog);
+  jobs = new JobsList(*config);
+}
+
+void LRMSHelperTest::tearDown() {
+  delete jobs;
+  delete perflog;
+  delete joblog;
+  delete config;
+  Arc::UnsetEnv("MOCK_LRMS_HELPER_DELAY");
+  Arc::DirDelete(controldir);
+}
+
+std::string LRMSHelperTest::Grami(const JobId& id) {
+  std::string grami = controldir + "/job." + id + ".grami";
+  CPPUNIT_ASSERT(Arc::FileCreate(grami, "joboption_directory=" + controldir + "\n"));
+  return grami;
+}
+
+bool LRMSHelperTest::HasLRMSId(const JobId& id) {
+  std::ifstream f((controldir + "/job." + id + ".grami").c_str());
+  std::string line;
+  while(std::getline(f, line)) {
+    if(line.compare(0, 16, "joboption_jobid=") == 0) return true;
+  }
+  return false;
+}
+
+void LRMSHelperTest::TestSubmit() {
+  LRMSHelper helper(*config, *jobs);
+  GMJob job("job1", Arc::User());
+  CPPUNIT_ASSERT(helper.Request(LRMSHelper::Submit, job, Grami("job1")));
+
+  int result = -1;
+  std::string local_id;
+  Arc::Time started;
+  Arc::Time finished;
+  LRMSHelper::RequestState state = LRMSHelper::Unknown;
+  for(int n = 0; n < 200; ++n) {
+    state = helper.Check(LRMSHelper::Submit, "job1", result, local_id, started, finished);
+    if(state != LRMSHelper::Pending) break;
+    usleep(100000);
+  }
+  CPPUNIT_ASSERT_EQUAL(LRMSHelper::Done, state);
+  CPPUNIT_ASSERT_EQUAL(0, result);
+  CPPUNIT_ASSERT_EQUAL(std::string("mock-1"), local_id);
+  CPPUNIT_ASSERT(HasLRMSId("job1"));
+  // Result is kept till forgotten
+  CPPUNIT_ASSERT_EQUAL(LRMSHelper::Done,
+      helper.Check(LRMSHelper::Submit, "job1", result, local_id, started, finished));
+  helper.Forget("job1");
+  CPPUNIT_ASSERT_EQUAL(LRMSHelper::Unknown,
+      helper.Check(LRMSHelper::Submit, "job1", result, local_id, started, finished));
+}
+
+void LRMSHelperTest::TestAbandon() {
+  LRMSHelper helper(*config, *jobs);
+  GMJob job1("job1", Arc::User());
+  GMJob job2("job2", Arc::User());
+  CPPUNIT_ASSERT(helper.Request(LRMSHelper::Submit, job1, Grami("job1")));
+  CPPUNIT_ASSERT(helper.Request(LRMSHelper::Submit, job2, Grami("job2")));
+
+  int result = -1;
+  std::string local_id;
+  Arc::Time started;
+  Arc::Time finished;
+  CPPUNIT_ASSERT_EQUAL(LRMSHelper::Pending,
+      helper.Check(LRMSHelper::Submit, "job1", result, local_id, started, finished));
+  // Submission times out - job is going to be failed by A-REX, so helper
+  // must not submit it anymore.
+  helper.Forget("job1");
+  sleep(4);
+  CPPUNIT_ASSERT(!HasLRMSId("job1"));
+  CPPUNIT_ASSERT_EQUAL(LRMSHelper::Unknown,
+      helper.Check(LRMSHelper::Submit, "job1", result, local_id, started, finished));
+  // Other request sent to stopped helper is dropped to be retried
+  CPPUNIT_ASSERT(!HasLRMSId("job2"));
+  CPPUNIT_ASSERT_EQUAL(LRMSHelper::Unknown,
+      helper.Check(LRMSHelper::Submit, "job2", result, local_id, started, finished));
+  // Helper is not restarted immediately - scripts are used meanwhile
+  CPPUNIT_ASSERT(!helper.Request(LRMSHelper::Submit, job2, Grami("job2")));
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(LRMSHelperTest);
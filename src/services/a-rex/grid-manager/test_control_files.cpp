@@ -0,0 +1,143 @@
+// -*- indent-tabs-mode: nil -*-
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+// Benchmark of control files handling for job with many input and output
+// files. Writes *.input, *.output and *.local files of single job into
+// given directory, reads them repeatedly same way as A-REX does on every
+// state transition and appends every file to *.output_status as data
+// staging does. Time needed for every step is reported.
+
+#include <iostream>
+#include <string>
+
+#include <arc/DateTime.h>
+#include <arc/GUID.h>
+#include <arc/Logger.h>
+#include <arc/OptionParser.h>
+#include <arc/IString.h>
+#include <arc/StringConv.h>
+#include <arc/User.h>
+
+#include "conf/GMConfig.h"
+#include "jobs/GMJob.h"
+#include "files/ControlFileContent.h"
+#include "files/ControlFileHandling.h"
+
+static Arc::Logger logger(Arc::Logger::getRootLogger(), "test_control_files");
+
+static void report(const std::string& title, const Arc::Time& start, int count) {
+  Arc::Period period = Arc::Time() - start;
+  double seconds = period.GetPeriod() + period.GetPeriodNanoseconds() / 1000000000.0;
+  std::cout << title << ": " << seconds << " s";
+  if (count > 1) std::cout << " (" << (seconds * 1000.0 / count) << " ms each)";
+  std::cout << std::endl;
+}
+
+int main(int argc, char **argv) {
+
+  Arc::LogStream logcerr(std::cerr);
+  Arc::Logger::getRootLogger().addDestination(logcerr);
+  Arc::Logger::getRootLogger().setThreshold(Arc::WARNING);
+
+  Arc::OptionParser options("",
+                            istring("Tool for measuring performance of control files handling."));
+
+  std::string controlDir;
+  options.AddOption('c', "control",
+                    istring("Directory to write control files to"),
+                    istring("path"), controlDir);
+
+  int filesNum = 10000;
+  options.AddOption('n', "files",
+                    istring("Number of input and output files of job"),
+                    istring("number"), filesNum);
+
+  int readsNum = 100;
+  options.AddOption('r', "reads",
+                    istring("Number of times every file is read"),
+                    istring("number"), readsNum);
+
+  options.Parse(argc, argv);
+
+  if (controlDir.empty()) {
+    logger.msg(Arc::ERROR, "Control directory must be specified");
+    return 1;
+  }
+
+  ARex::GMConfig config;
+  config.SetControlDir(controlDir);
+  std::string id;
+  Arc::GUID(id);
+  ARex::GMJob job(id, Arc::User(), controlDir + "/" + id, ARex::JOB_STATE_ACCEPTED);
+
+  ARex::JobLocalDescription local;
+  local.DN = "/CN=Benchmark";
+  local.sessiondir = job.SessionDir();
+  for (int n = 0; n < filesNum; ++n) {
+    std::string name = "/dir " + Arc::tostring(n) + "/file" + Arc::tostring(n);
+    local.inputdata.push_back(ARex::FileData(name, "https://host.org/data/file" + Arc::tostring(n)));
+    local.outputdata.push_back(ARex::FileData(name + ".out", "https://host.org/data/file" + Arc::tostring(n) + ".out"));
+  }
+
+  Arc::Time start;
+  if (!ARex::job_input_write_file(job, config, local.inputdata) ||
+      !ARex::job_output_write_file(job, config, local.outputdata) ||
+      !ARex::job_local_write_file(job, config, local)) {
+    logger.msg(Arc::ERROR, "Failed to write control files");
+    return 1;
+  }
+  report("Writing input, output and local files", start, 1);
+
+  start = Arc::Time();
+  for (int n = 0; n < readsNum; ++n) {
+    std::list<ARex::FileData> files;
+    if (!ARex::job_input_read_file(id, config, files) || (files.size() != (unsigned int)filesNum)) {
+      logger.msg(Arc::ERROR, "Failed to read input file");
+      return 1;
+    }
+  }
+  report("Reading input file", start, readsNum);
+
+  start = Arc::Time();
+  for (int n = 0; n < readsNum; ++n) {
+    std::list<ARex::FileData> files;
+    if (!ARex::job_output_read_file(id, config, files) || (files.size() != (unsigned int)filesNum)) {
+      logger.msg(Arc::ERROR, "Failed to read output file");
+      return 1;
+    }
+  }
+  report("Reading output file", start, readsNum);
+
+  start = Arc::Time();
+  for (int n = 0; n < readsNum; ++n) {
+    ARex::JobLocalDescription read_local;
+    if (!ARex::job_local_read_file(id, config, read_local)) {
+      logger.msg(Arc::ERROR, "Failed to read local file");
+      return 1;
+    }
+  }
+  report("Reading local file", start, readsNum);
+
+  start = Arc::Time();
+  for (std::list<ARex::FileData>::iterator f = local.outputdata.begin(); f != local.outputdata.end(); ++f) {
+    if (!ARex::job_output_status_add_file(job, config, *f)) {
+      logger.msg(Arc::ERROR, "Failed to add to output status file");
+      return 1;
+    }
+  }
+  report("Adding to output status file", start, filesNum);
+
+  start = Arc::Time();
+  std::list<ARex::FileData> files;
+  if (!ARex::job_output_status_read_file(id, config, files) || (files.size() != (unsigned int)filesNum)) {
+    logger.msg(Arc::ERROR, "Failed to read output status file");
+    return 1;
+  }
+  report("Reading output status file", start, 1);
+
+  ARex::job_clean_final(job, config);
+  return 0;
+}
@@ -0,0 +1,202 @@
+// -*- indent-tabs-mode: nil -*-
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+// Synthetic load test for job processing. Creates requested number of
+// trivial jobs in control directory and drives them through all states
+// till FINISHED using same calls as main loop of A-REX does. Time needed
+// to process all jobs is reported. Configuration must define controldir
+// and sessiondir pointing to scratch space and should use mock LRMS helper
+// (src/services/a-rex/lrms/test/mock-lrms-helper.sh) with environment
+// variable MOCK_LRMS_HELPER_DONE=yes, so jobs finish immediately after
+// being submitted. Compare processing time for different values of
+// jobthreads option in [arex] block.
+
+#include <iostream>
+
+#include <unistd.h>
+
+#include <glibmm/fileutils.h>
+
+#include <arc/DateTime.h>
+#include <arc/GUID.h>
+#include <arc/JobPerfLog.h>
+#include <arc/Logger.h>
+#include <arc/OptionParser.h>
+#include <arc/IString.h>
+#include <arc/Thread.h>
+#include <arc/compute/JobDescription.h>
+
+#include "conf/GMConfig.h"
+#include "jobs/GMJob.h"
+#include "jobs/JobsList.h"
+#include "jobs/JobDescriptionHandler.h"
+#include "files/ControlFileContent.h"
+#include "files/ControlFileHandling.h"
+#include "log/JobLog.h"
+
+static Arc::Logger logger(Arc::Logger::getRootLogger(), "test_jobs_load");
+
+static const char* job_description = "&(executable=/bin/true)(jobname=load)";
+
+static bool create_job(const ARex::GMConfig& config, const ARex::JobDescriptionHandler& handler) {
+  std::string id;
+  Arc::GUID(id);
+  ARex::JobLocalDescription local;
+  local.sessiondir = config.SessionRoot(id) + "/" + id;
+  local.DN = "/CN=Load Test";
+  ARex::GMJob job(id, Arc::User(), local.sessiondir, ARex::JOB_STATE_ACCEPTED);
+  if(!job_description_write_file(job, config, job_description)) return false;
+  Arc::JobDescription desc;
+  if(handler.parse_job_req(id, local, desc) != ARex::JobReqSuccess) return false;
+  if(!job_local_write_file(job, config, local)) return false;
+  if(!handler.write_grami(desc, job, NULL)) return false;
+  if(!config.CreateSessionDirectory(job.SessionDir(), job.get_user())) return false;
+  return job_state_write_file(job, config, ARex::JOB_STATE_ACCEPTED, false);
+}
+
+static unsigned int count_finished(const ARex::GMConfig& config) {
+  unsigned int count = 0;
+  try {
+    Glib::Dir dir(config.ControlDir() + "/finished");
+    for(;;) {
+      std::string file = dir.read_name();
+      if(file.empty()) break;
+      if((file.length() > 11) && (file.substr(0, 4) == "job.") &&
+         (file.substr(file.length() - 7) == ".status")) ++count;
+    };
+  } catch(Glib::FileError& e) {
+  };
+  return count;
+}
+
+class Kicker {
+ public:
+  Kicker(ARex::JobsList& jobs):jobs_(jobs), stop_(false) { };
+  void Stop(void) {
+    stop_ = true;
+    counter_.wait();
+  };
+  bool Start(void) {
+    return Arc::CreateThreadFunction(&kick, this, &counter_);
+  };
+ private:
+  // Replaces communication interface of A-REX which wakes up main loop
+  static void kick(void* arg) {
+    Kicker& it = *reinterpret_cast<Kicker*>(arg);
+    while(!it.stop_) {
+      sleep(1);
+      it.jobs_.RequestAttention();
+    };
+  };
+  ARex::JobsList& jobs_;
+  bool stop_;
+  Arc::SimpleCounter counter_;
+};
+
+int main(int argc, char **argv) {
+
+  Arc::LogStream logcerr(std::cerr);
+  Arc::Logger::getRootLogger().addDestination(logcerr);
+  Arc::Logger::getRootLogger().setThreshold(Arc::WARNING);
+
+  Arc::OptionParser options("",
+                            istring("Tool for measuring throughput of job processing."));
+
+  std::string confFileName;
+  options.AddOption('z', "conf",
+                    istring("Configuration file to load"),
+                    istring("arc.conf"), confFileName);
+
+  int jobsNum = 100000;
+  options.AddOption('n', "jobs",
+                    istring("Number of jobs to process"),
+                    istring("number"), jobsNum);
+
+  int timeLimit = 3600;
+  options.AddOption('t', "timeout",
+                    istring("Maximal time to wait for jobs to finish"),
+                    istring("seconds"), timeLimit);
+
+  std::string debug;
+  options.AddOption('d', "debug",
+                    istring("FATAL, ERROR, WARNING, INFO, VERBOSE or DEBUG"),
+                    istring("debuglevel"), debug);
+
+  options.Parse(argc, argv);
+
+  if (!debug.empty()) Arc::Logger::getRootLogger().setThreshold(Arc::string_to_level(debug));
+
+  ARex::GMConfig config(confFileName);
+  if (!config.Load()) {
+    logger.msg(Arc::ERROR, "Unable to load ARC configuration file.");
+    return 1;
+  }
+  config.SetShareID(Arc::User());
+  if (!config.CreateControlDirectory()) {
+    logger.msg(Arc::ERROR, "Failed to create control directory %s", config.ControlDir());
+    return 1;
+  }
+  ARex::JobLog joblog;
+  Arc::JobPerfLog perflog;
+  config.SetJobLog(&joblog);
+  config.SetJobPerfLog(&perflog);
+
+  ARex::JobDescriptionHandler handler(config);
+  Arc::Time start;
+  for (int n = 0; n < jobsNum; ++n) {
+    if (!create_job(config, handler)) {
+      logger.msg(Arc::ERROR, "Failed to create job");
+      return 1;
+    }
+  }
+  std::cout << jobsNum << " jobs created in " << (Arc::Time() - start).GetPeriod() << " s" << std::endl;
+
+  unsigned int finished_before = count_finished(config);
+  ARex::JobsList jobs(config);
+  if (!jobs) {
+    logger.msg(Arc::ERROR, "Failed to activate Jobs Processing object");
+    return 1;
+  }
+  Kicker kicker(jobs);
+  if (!kicker.Start()) {
+    logger.msg(Arc::ERROR, "Failed to start new thread");
+    return 1;
+  }
+
+  // Same sequence as in main loop of A-REX but polling every second
+  start = Arc::Time();
+  time_t poll_time = time(NULL);
+  unsigned int finished = 0;
+  bool timedout = false;
+  while (true) {
+    jobs.ActJobsAttention();
+    if (((int)(time(NULL) - poll_time)) >= 0) {
+      poll_time = time(NULL) + 1;
+      jobs.ScanNewMarks();
+      jobs.ScanNewJobs();
+      jobs.ActJobsPolling();
+      finished = count_finished(config) - finished_before;
+      if (finished >= (unsigned int)jobsNum) break;
+      if ((Arc::Time() - start).GetPeriod() > timeLimit) {
+        timedout = true;
+        break;
+      }
+    }
+    jobs.WaitAttention();
+  }
+  Arc::Period processing = Arc::Time() - start;
+  kicker.Stop();
+  jobs.PrepareToDestroy();
+
+  std::cout << finished << " jobs processed in " << processing.GetPeriod() << " s";
+  if (processing.GetPeriod() > 0) std::cout << " (" << (finished / processing.GetPeriod()) << " jobs/s)";
+  std::cout << std::endl;
+  if (timedout) {
+    logger.msg(Arc::ERROR, "Not all jobs finished in time");
+    return 1;
+  }
+  return 0;
+}
@@ -4,6 +4,8 @@
 
 #include <sstream>
 #include <fstream>
+#include <vector>
+#include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -22,13 +24,92 @@
 #include "grid-manager/files/ControlFileHandling.h"
 #include "job.h"
 #include "arex.h"
+#include "InformationDocument.h"
 
 namespace ARex {
 
+// Writes whole buffer to file. Returns false on failure.
+static bool WriteAll(int h, const char* buf, std::string::size_type size) {
+  for(std::string::size_type p = 0; p < size;) {
+    ssize_t l = ::write(h, buf+p, size-p);
+    if(l == -1) {
+      if(errno == EINTR) continue;
+      return false;
+    };
+    p += l;
+  };
+  return true;
+}
+
+// Reads output of information provider into temporary file while it is
+// being produced, so there is no need to keep it in memory. Then it is
+// compared to currently published document without parsing either of them
+// to find out whether anything changed. Returns handle of file or -1.
+static int ReadInformation(Arc::Run& run, OptimizedInformationContainer& infodoc, const std::string& filename,
+                           std::string& tmpfilename, bool& changed, off_t& size) {
+  changed = true;
+  size = 0;
+  int h = OptimizedInformationContainer::CreateDocument(filename, tmpfilename);
+  bool failed = (h == -1);
+  std::vector<char> buf(65536);
+  for(;;) {
+    int l = run.ReadStdout(-1, &buf[0], buf.size());
+    if(l <= 0) break;
+    size += l;
+    // Output is read till end even after failure to let provider finish
+    if(!failed) failed = !WriteAll(h, &buf[0], l);
+  };
+  if(failed) {
+    if(h != -1) {
+      Arc::Logger::getRootLogger().msg(Arc::ERROR,"OptimizedInformationContainer failed to store XML document to temporary file");
+      ::unlink(tmpfilename.c_str());
+      ::close(h);
+    };
+    return -1;
+  };
+  if(size <= 0) return h;
+  // Both documents are mapped for comparison
+  int old_h = infodoc.OpenDocument();
+  if(old_h == -1) return h;
+  struct stat st;
+  if((::fstat(old_h,&st) == 0) && (st.st_size > 0)) {
+    void* old_addr = ::mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,old_h,0);
+    if(old_addr != MAP_FAILED) {
+      void* addr = ::mmap(NULL,size,PROT_READ,MAP_PRIVATE,h,0);
+      if(addr != MAP_FAILED) {
+        changed = InformationChanged((const char*)old_addr, st.st_size, st.st_mtime,
+                                     (const char*)addr, size, ::time(NULL));
+        ::munmap(addr, size);
+      };
+      ::munmap(old_addr, st.st_size);
+    };
+  };
+  ::close(old_h);
+  return h;
+}
+
+// Parses document stored in file without making intermediate copy of it.
+static bool ParseInformation(int h, Arc::XMLNode& doc) {
+  struct stat st;
+  if((::fstat(h,&st) != 0) || (st.st_size <= 0)) return false;
+  void* addr = ::mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,h,0);
+  if(addr == MAP_FAILED) return false;
+  Arc::XMLNode newdoc((const char*)addr, st.st_size);
+  ::munmap(addr, st.st_size);
+  if(!newdoc) return false;
+  newdoc.Swap(doc);
+  return true;
+}
+
 void ARexService::InformationCollector(void) {
   thread_count_.RegisterThread();
   for(;;) {
     // Run information provider
+    std::string filename = config_.ControlDir()+G_DIR_SEPARATOR_S+"info.xml";
+    std::string tmpfilename;
+    int h = -1;
+    bool changed = true;
+    off_t size = 0;
     std::string xml_str;
     int r = -1;
     {
@@ -38,13 +119,17 @@ void ARexService::InformationCollector(void) {
       std::string stderr_str;
       Arc::Run run(cmd);
       run.AssignStdin(stdin_str);
-      run.AssignStdout(xml_str);
+      // In incremental mode stdout stays pipe which is read while provider runs
+      if(!config_.InfoIncremental()) run.AssignStdout(xml_str);
       run.AssignStderr(stderr_str);
       logger_.msg(Arc::DEBUG,"Resource information provider: %s",cmd);
       if(!run.Start()) {
         // Failed to fork proces
         logger_.msg(Arc::DEBUG,"Resource information provider failed to start");
       } else {
+        if(config_.InfoIncremental()) {
+          h = ReadInformation(run, infodoc_, filename, tmpfilename, changed, size);
+        };
         if(!run.Wait()) {
           logger_.msg(Arc::DEBUG,"Resource information provider failed to run");
         } else {
@@ -57,26 +142,50 @@ void ARexService::InformationCollector(void) {
         };
       };
     };
+    if((r == 0) && !config_.InfoIncremental()) {
+      logger_.msg(Arc::VERBOSE,"Obtained XML: %s",xml_str.substr(0,100));
+      size = xml_str.length();
+      if(!xml_str.empty()) {
+        h = OptimizedInformationContainer::CreateDocument(filename, tmpfilename);
+        if((h != -1) && !WriteAll(h, xml_str.c_str(), xml_str.length())) {
+          logger_.msg(Arc::ERROR,"OptimizedInformationContainer failed to store XML document to temporary file");
+          ::unlink(tmpfilename.c_str());
+          ::close(h);
+          h = -1;
+        };
+      };
+      xml_str.clear();
+    };
     if (r!=0) {
       logger_.msg(Arc::WARNING,"No new informational document assigned");
+    } else if(size == 0) {
+      logger_.msg(Arc::ERROR,"Informational document is empty");
+    } else if(h == -1) {
+      logger_.msg(Arc::WARNING,"No new informational document assigned");
+    } else if(!changed) {
+      logger_.msg(Arc::DEBUG,"Informational document did not change");
     } else {
-      logger_.msg(Arc::VERBOSE,"Obtained XML: %s",xml_str.substr(0,100));
       // Following code is suboptimal. Most of it should go away
       // and functionality to be moved to information providers.
-      if(!xml_str.empty()) {
-        // Currently glue states are lost. Counter of all jobs is lost too.
-        infodoc_.Assign(xml_str,config_.ControlDir()+G_DIR_SEPARATOR_S+"info.xml");
-        Arc::XMLNode root = infodoc_.Acquire();
+      Arc::XMLNode root;
+      if(!ParseInformation(h, root)) {
+        logger_.msg(Arc::ERROR,"OptimizedInformationContainer failed to parse XML");
+      } else {
+        // Currently glue states are lost. Counter of all jobs is only read.
+        // It is not glue2 info, but it is kept because document is served
+        // to clients exactly as produced by information provider.
         Arc::XMLNode all_jobs_count = root["Domains"]["AdminDomain"]["Services"]["ComputingService"]["AllJobs"];
         if((bool)all_jobs_count) {
           Arc::stringto((std::string)all_jobs_count,all_jobs_count_);
-          all_jobs_count.Destroy(); // is not glue2 info
         };
-        infodoc_.Release();
-      } else {
-        logger_.msg(Arc::ERROR,"Informational document is empty");
+        infodoc_.Assign(h,tmpfilename,filename,root);
+        h = -1;
       };
     };
+    if(h != -1) {
+      ::unlink(tmpfilename.c_str());
+      ::close(h);
+    };
     if(thread_count_.WaitOrCancel(infoprovider_wakeup_period_*100)) break;
   };
   thread_count_.UnregisterThread();
@@ -243,44 +352,83 @@ class PrefixedFilePayload: public Arc::PayloadRawInterface {
   virtual bool Truncate(Size_t /* size */) { return false; };
 };
 
+InformationSnapshot::InformationSnapshot(int handle, Arc::XMLNode& doc):refs_(1),handle_(handle) {
+  doc_.Swap(doc);
+}
+
+InformationSnapshot::~InformationSnapshot(void) {
+  if(handle_ != -1) ::close(handle_);
+}
+
+int InformationSnapshot::Open(void) const {
+  if(handle_ == -1) return -1;
+  return ::dup(handle_);
+}
+
+const std::string& InformationSnapshot::Rendered(int format, void (*renderer)(Arc::XMLNode xml, int format, std::string& output)) {
+  Glib::Mutex::Lock lock(lock_);
+  std::map<int,std::string>::iterator r = rendered_.find(format);
+  if(r == rendered_.end()) {
+    r = rendered_.insert(std::pair<int,std::string>(format,std::string())).first;
+    (*renderer)(doc_,format,r->second);
+  };
+  return r->second;
+}
+
+void InformationSnapshot::Acquire(void) {
+  Glib::Mutex::Lock lock(lock_);
+  ++refs_;
+}
+
+void InformationSnapshot::Release(void) {
+  lock_.lock();
+  bool last = (--refs_ <= 0);
+  lock_.unlock();
+  if(last) delete this;
+}
+
 OptimizedInformationContainer::OptimizedInformationContainer(bool parse_xml) {
-  handle_=-1;
+  snapshot_=NULL;
   parse_xml_=parse_xml;
 }
 
 OptimizedInformationContainer::~OptimizedInformationContainer(void) {
-  if(handle_ != -1) ::close(handle_);
+  if(snapshot_) snapshot_->Release();
   if(!filename_.empty()) ::unlink(filename_.c_str());
 }
 
 int OptimizedInformationContainer::OpenDocument(void) {
   int h = -1;
   olock_.lock();
-  if(handle_ != -1) h = ::dup(handle_);
+  if(snapshot_) h = snapshot_->Open();
   olock_.unlock();
   return h;
 }
 
+InformationSnapshot* OptimizedInformationContainer::AcquireSnapshot(void) {
+  Glib::Mutex::Lock lock(olock_);
+  if(snapshot_) snapshot_->Acquire();
+  return snapshot_;
+}
+
 void OptimizedInformationContainer::AssignFile(const std::string& filename) {
+  int h = -1;
+  Arc::XMLNode doc;
+  if(!filename.empty()) {
+    h = ::open(filename.c_str(),O_RDONLY);
+    if(parse_xml_) doc.ReadFromFile(filename);
+  };
   olock_.lock();
-  if(!filename_.empty()) ::unlink(filename_.c_str());
-  if(handle_ != -1) ::close(handle_);
+  if(!filename_.empty()) if(filename_ != filename) ::unlink(filename_.c_str());
   filename_ = filename;
-  handle_ = -1;
-  if(!filename_.empty()) {
-    handle_ = ::open(filename_.c_str(),O_RDONLY);
-    if(parse_xml_) {
-      lock_.lock();
-      doc_.ReadFromFile(filename_);
-      lock_.unlock();
-      Arc::InformationContainer::Assign(doc_,false);
-    };
-  };
+  InformationSnapshot* old = snapshot_;
+  snapshot_ = (h != -1) ? new InformationSnapshot(h,doc) : NULL;
+  if(parse_xml_) Arc::InformationContainer::Assign(snapshot_?snapshot_->doc_:Arc::XMLNode(),false);
   olock_.unlock();
+  if(old) old->Release();
 }
 
-void OptimizedInformationContainer::Assign(const std::string& xml, const std::string filename) {
-  std::string tmpfilename;
+int OptimizedInformationContainer::CreateDocument(const std::string& filename, std::string& tmpfilename) {
   int h = -1;
   if(filename.empty()) {
     h = Glib::file_open_tmp(tmpfilename);
@@ -291,10 +439,17 @@ void OptimizedInformationContainer::Assign(const std::string& xml, const std::st
   };
   if(h == -1) {
     Arc::Logger::getRootLogger().msg(Arc::ERROR,"OptimizedInformationContainer failed to create temporary file");
-    return;
+    return -1;
   };
   Arc::Logger::getRootLogger().msg(Arc::VERBOSE,"OptimizedInformationContainer created temporary file: %s",tmpfilename);
-  for(std::string::size_type p = 0;p<xml.length();++p) {
+  return h;
+}
+
+void OptimizedInformationContainer::Assign(const std::string& xml, const std::string filename) {
+  std::string tmpfilename;
+  int h = CreateDocument(filename, tmpfilename);
+  if(h == -1) return;
+  for(std::string::size_type p = 0;p<xml.length();) {
     ssize_t l = ::write(h,xml.c_str()+p,xml.length()-p);
     if(l == -1) {
       ::unlink(tmpfilename.c_str());
@@ -305,11 +460,15 @@ void OptimizedInformationContainer::Assign(const std::string& xml, const std::st
     p+=l;
   };
   Arc::XMLNode newxml(parse_xml_?xml:std::string());
-  if(parse_xml_ && !newxml) {
+  Assign(h,tmpfilename,filename,newxml);
+}
+
+bool OptimizedInformationContainer::Assign(int h, const std::string& tmpfilename, const std::string& filename, Arc::XMLNode& doc) {
+  if(parse_xml_ && !doc) {
     ::unlink(tmpfilename.c_str());
     ::close(h);
     Arc::Logger::getRootLogger().msg(Arc::ERROR,"OptimizedInformationContainer failed to parse XML");
-    return;
+    return false;
   };
   // Here we have XML stored in file and optionally parsed
   // Attach to new file
@@ -319,23 +478,27 @@ void OptimizedInformationContainer::Assign(const std::string& xml, const std::st
     filename_ = tmpfilename;
   } else {
     if(::rename(tmpfilename.c_str(), filename.c_str()) != 0) {
+      olock_.unlock();
+      ::unlink(tmpfilename.c_str());
+      ::close(h);
       Arc::Logger::getRootLogger().msg(Arc::ERROR,"OptimizedInformationContainer failed to rename temprary file");
-      return;
+      return false;
     };
     // Do not delete old file if same name requested - it is removed by rename()
     if(!filename_.empty()) if(filename_ != filename) ::unlink(filename_.c_str());
     filename_ = filename;
-  };   
-  if(handle_ != -1) ::close(handle_);
-  handle_ = h;
+  };
+  // Readers of old document keep it till they release it
+  InformationSnapshot* old = snapshot_;
+  Arc::XMLNode empty;
+  snapshot_ = new InformationSnapshot(h,parse_xml_?doc:empty);
   if(parse_xml_) {
     // Assign parsed xml
-    lock_.lock();
-    doc_.Swap(newxml);
-    lock_.unlock();
-    Arc::InformationContainer::Assign(doc_,false);
+    Arc::InformationContainer::Assign(snapshot_->doc_,false);
   };
   olock_.unlock();
+  if(old) old->Release();
+  return true;
 }
 
 #define ESINFOFAULT(MSG) { \
@@ -365,38 +528,12 @@ void OptimizedInformationContainer::Assign(const std::string& xml, const std::st
 // AccessControlFault
 // InternalBaseFault
 Arc::MCC_Status ARexService::ESGetResourceInfo(ARexGMConfig& config,Arc::XMLNode in,Arc::XMLNode out) {
-  // WARNING. Suboptimal temporary solution.
-  int h = infodoc_.OpenDocument();
-  if(h == -1) ESINFOFAULT("Failed to open resource information file");
-  ::lseek(h,0,SEEK_SET);
-  struct stat st;
-  if((::fstat(h,&st) != 0) || (st.st_size == 0)) {
-    ::close(h);
-    ESINFOFAULT("Failed to stat resource information file");
-  };
-  char* buf = (char*)::malloc(st.st_size+1);
-  if(!buf) {
-    ::close(h);
-    ESINFOFAULT("Failed to allocate memory for resource information");
-  };
-  off_t p = 0;
-  for(;p<st.st_size;) {
-    ssize_t l = ::read(h,buf+p,st.st_size-p);
-    if(l == 0) break;
-    if(l == -1) {
-      if(errno != EAGAIN) {
-        ::free(buf);
-        ::close(h);
-        ESINFOFAULT("Failed to read resource information file");
-      };
-    };
-    p+=l;
-  };
-  buf[p] = 0;
-  ::close(h);
-  Arc::XMLNode doc(buf);
-  ::free(buf); buf=NULL;
+  // Published document is never modified, so it is used directly
+  InformationSnapshot* snapshot = infodoc_.AcquireSnapshot();
+  if(!snapshot) ESINFOFAULT("Resource information is not available");
+  Arc::XMLNode doc = snapshot->Document();
   if(!doc) {
+    snapshot->Release();
     ESINFOFAULT("Failed to parse resource information document");
   };
   //Arc::NS glueNS("glue","http://schemas.ogf.org/glue/2009/03/spec_2.0_r1");
@@ -423,6 +560,7 @@ Arc::MCC_Status ARexService::ESGetResourceInfo(ARexGMConfig& config,Arc::XMLNode
     // TODO: use move instead of copy
     services.NewChild(manager);
   }
+  snapshot->Release();
   return Arc::MCC_Status(Arc::STATUS_OK);
 }
 
@@ -465,40 +603,14 @@ Arc::MCC_Status ARexService::ESQueryResourceInfo(ARexGMConfig& config,Arc::XMLNo
     out.Destroy();
     return Arc::MCC_Status(Arc::STATUS_OK);
   }
-  // WARNING. Suboptimal temporary solution.
-  int h = infodoc_.OpenDocument();
-  if(h == -1) ESFAULT("Failed to open resource information file");
-  ::lseek(h,0,SEEK_SET);
-  struct stat st;
-  if((::fstat(h,&st) != 0) || (st.st_size == 0)) {
-    ::close(h);
-    ESFAULT("Failed to stat resource information file");
-  };
-  char* buf = (char*)::malloc(st.st_size+1);
-  if(!buf) {
-    ::close(h);
-    ESFAULT("Failed to allocate memory for resource information");
-  };
-  off_t p = 0;
-  for(;p<st.st_size;) {
-    ssize_t l = ::read(h,buf+p,st.st_size-p);
-    if(l == 0) break;
-    if(l == -1) {
-      if(errno != EAGAIN) {
-        ::free(buf);
-        ::close(h);
-        ESFAULT("Failed to read resource information file");
-      };
-    };
-    p+=l;
-  };
-  buf[p] = 0;
-  ::close(h);
-  Arc::XMLNode doc(buf);
-  ::free(buf); buf=NULL;
+  // Copy is needed because document is modified for lookup
+  InformationSnapshot* snapshot = infodoc_.AcquireSnapshot();
+  if(!snapshot) ESFAULT("Resource information is not available");
   Arc::XMLNode rdoc;
-  doc["Domains"]["AdminDomain"]["Services"].Move(rdoc);
-  if((!doc) || (!rdoc)) {
+  Arc::XMLNode services = snapshot->Document()["Domains"]["AdminDomain"]["Services"];
+  if((bool)services) services.New(rdoc);
+  snapshot->Release();
+  if(!rdoc) {
     ESFAULT("Failed to parse resource information document");
   };
 
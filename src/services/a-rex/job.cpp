@@ -36,6 +36,7 @@
 #include "grid-manager/jobs/JobsList.h"
 #include "grid-manager/run/RunPlugin.h"
 #include "grid-manager/files/ControlFileHandling.h"
+#include "grid-manager/files/JobStateIndex.h"
 #include "delegation/DelegationStores.h"
 #include "delegation/DelegationStore.h"
 
@@ -805,6 +806,7 @@ void ARexJob::make_new_job(std::string const& job_desc_str,const std::string& de
     failure_type_=ARexJobInternalError;
     return;
   };
+  if(config_.GmConfig().GetJobStateIndex()) config_.GmConfig().GetJobStateIndex()->SetSession(id_,true);
   // Create input status file to tell downloader we
   // are handling input in clever way.
   job_input_status_add_file(job,config_.GmConfig());
@@ -0,0 +1,74 @@
+#!/bin/bash
+#
+# Mock LRMS helper for testing A-REX communication with persistent LRMS
+# helper process (see lrmshelper option in [lrms] block of arc.conf).
+#
+# Requests are read from stdin and processed in batches - everything which is
+# available at the time of reading is handled together, like real helper
+# would combine jobs into a single call to LRMS. No LRMS is contacted. Every
+# submitted job gets LRMS id "mock-<number>" which is also written into grami
+# file same way as submit-*-job does. Batch sizes are reported to stderr which
+# normally ends up in A-REX log.
+#
+# Behaviour is controlled by environment variables:
+#   MOCK_LRMS_HELPER_CODE  - code reported for every request (default 0)
+#   MOCK_LRMS_HELPER_DELAY - seconds to sleep before replying to each batch
+#   MOCK_LRMS_HELPER_EXIT  - exit after this many requests to test recovery
+#   MOCK_LRMS_HELPER_DONE  - if set to "yes" submitted jobs are immediately
+#                            marked as finished with exit code 0
+#
+# Cancelled jobs are always marked as finished because A-REX waits for that
+# after successful cancellation.
+
+code=${MOCK_LRMS_HELPER_CODE:-0}
+delay=${MOCK_LRMS_HELPER_DELAY:-0}
+exit_after=${MOCK_LRMS_HELPER_EXIT:-0}
+mark_done=${MOCK_LRMS_HELPER_DONE:-no}
+
+# Arguments are same as for scripts: --config <arc.conf>. Not needed here.
+
+handled=0
+lrms_id=0
+
+process() {
+  # op id uid gid grami
+  local control_dir=`dirname "$5"`
+  if [ "$1" = "SUBMIT" ]; then
+    lrms_id=$(( lrms_id + 1 ))
+    if [ "$code" = "0" ]; then
+      echo "joboption_jobid=mock-$lrms_id" >> "$5"
+      if [ "$mark_done" = "yes" ]; then
+        echo "0 Mock job finished" > "${control_dir}/job.$2.lrms_done"
+      fi
+      echo "$2 SUBMIT 0 mock-$lrms_id"
+    else
+      echo "$2 SUBMIT $code"
+    fi
+  elif [ "$1" = "CANCEL" ]; then
+    if [ "$code" = "0" ]; then
+      echo "-1 Job was cancelled" > "${control_dir}/job.$2.lrms_done"
+    fi
+    echo "$2 CANCEL $code"
+  else
+    echo "mock-lrms-helper: unknown request: $*" 1>&2
+  fi
+}
+
+while read -r op id uid gid grami; do
+  batch=("$op $id $uid $gid $grami")
+  # Collect requests which are already waiting
+  while read -r -t 0 && read -r op id uid gid grami; do
+    batch+=("$op $id $uid $gid $grami")
+  done
+  echo "mock-lrms-helper: processing batch of ${#batch[@]} requests" 1>&2
+  [ "$delay" != "0" ] && sleep "$delay"
+  for request in "${batch[@]}"; do
+    process $request
+    handled=$(( handled + 1 ))
+    if [ "$exit_after" != "0" ] && [ "$handled" -ge "$exit_after" ]; then
+      echo "mock-lrms-helper: exiting after $handled requests" 1>&2
+      exit 1
+    fi
+  done
+done
+exit 0
@@ -0,0 +1,42 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <list>
+
+#include <arc/CheckSum.h>
+#include <arc/DateTime.h>
+#include <arc/StringConv.h>
+
+#include "ConditionalRequest.h"
+
+namespace ARex {
+
+std::string JobsListingTag(unsigned long long int generation, const std::string& dn, const std::string& filter) {
+  std::string key = dn + "\n" + filter;
+  Arc::CRC32Sum crc;
+  crc.start();
+  crc.add((void*)key.c_str(), key.length());
+  crc.end();
+  return "\"" + Arc::tostring(generation) + "-" + Arc::inttostr((unsigned long long int)crc.crc(), 16) + "\"";
+}
+
+bool IsNotModified(const std::string& etag, time_t modified,
+                   const std::string& if_none_match, const std::string& if_modified_since) {
+  if(!if_none_match.empty()) {
+    std::list<std::string> tags;
+    Arc::tokenize(if_none_match, tags, ",");
+    for(std::list<std::string>::iterator tag = tags.begin(); tag != tags.end(); ++tag) {
+      std::string t = Arc::trim(*tag," ");
+      if((t == etag) || (t == "*") || (t == "W/"+etag)) return true;
+    }
+    return false;
+  }
+  if(!if_modified_since.empty()) {
+    Arc::Time since(if_modified_since);
+    if((since.GetTime() != (time_t)(-1)) && (modified <= since.GetTime())) return true;
+  }
+  return false;
+}
+
+} // namespace ARex
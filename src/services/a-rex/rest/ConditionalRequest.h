@@ -0,0 +1,26 @@
+#ifndef __ARC_AREX_REST_CONDITIONALREQUEST_H__
+#define __ARC_AREX_REST_CONDITIONALREQUEST_H__
+
+#include <string>
+
+#include <time.h>
+
+namespace ARex {
+
+/// Makes entity tag for listing of jobs.
+/** Tag depends on generation of jobs owned by user and on user's identity
+  and requested states filter. So responses which differ in content never
+  share same tag even if generations happen to match. */
+std::string JobsListingTag(unsigned long long int generation, const std::string& dn, const std::string& filter);
+
+/// Checks conditional request headers against current validators.
+/** Returns true if client's copy identified by if_none_match or
+  if_modified_since is current. If-None-Match takes precedence over
+  If-Modified-Since as required by RFC 7232. Empty header values mean
+  corresponding header is not present. */
+bool IsNotModified(const std::string& etag, time_t modified,
+                   const std::string& if_none_match, const std::string& if_modified_since);
+
+} // namespace ARex
+
+#endif // __ARC_AREX_REST_CONDITIONALREQUEST_H__
@@ -16,7 +16,11 @@
 #include "../FileChunks.h"
 #include "../delegation/DelegationStores.h"
 #include "../grid-manager/files/ControlFileHandling.h"
+#include "../grid-manager/files/JobStateIndex.h"
+#include "../grid-manager/jobs/JobsList.h"
+#include "../arex.h"
 
+#include "ConditionalRequest.h"
 #include "rest.h"
 
 namespace Arc {
@@ -254,6 +258,10 @@ static void RenderResponse(Arc::XMLNode xml, ResponseFormat format, std::string&
     }
 }
 
+static void RenderInfo(Arc::XMLNode xml, int format, std::string& output) {
+    RenderResponse(xml, (ResponseFormat)format, output);
+}
+
 static void ExtractRange(Arc::Message& inmsg, off_t& range_start, off_t& range_end) {
   range_start = 0;
   range_end = (off_t)(-1);
@@ -632,9 +640,10 @@ static void convertActivityStatusREST(const std::string& gm_state,std::string& r
 }
 
 ARexRest::ARexRest(Arc::Config *cfg, Arc::PluginArgument *parg, GMConfig& config,
-                   ARex::DelegationStores& delegation_stores,unsigned int& all_jobs_count):
+                   ARex::DelegationStores& delegation_stores,unsigned int& all_jobs_count,
+                   OptimizedInformationContainer& infodoc):
        logger_(Arc::Logger::rootLogger, "A-REX REST"),
-       config_(config),delegation_stores_(delegation_stores),all_jobs_count_(all_jobs_count) {
+       config_(config),delegation_stores_(delegation_stores),all_jobs_count_(all_jobs_count),infodoc_(infodoc) {
   endpoint_=(std::string)((*cfg)["endpoint"]);
   uname_=(std::string)((*cfg)["usermap"]["defaultLocalName"]);
 }
@@ -728,6 +737,20 @@ Arc::MCC_Status ARexRest::processInfo(Arc::Message& inmsg,Arc::Message& outmsg,
     return HTTPFault(inmsg,outmsg,501,"Schema not implemented");
   }
 
+  // Published document is rendered only once for every format
+  InformationSnapshot* snapshot = infodoc_.AcquireSnapshot();
+  if(snapshot) {
+    if((bool)(snapshot->Document())) {
+      ResponseFormat outFormat = ProcessAcceptedFormat(inmsg,outmsg);
+      std::string mime = outmsg.Attributes()->get("HTTP:content-type");
+      Arc::MCC_Status result = HTTPResponse(inmsg, outmsg, snapshot->Rendered(outFormat, &RenderInfo), mime);
+      snapshot->Release();
+      return result;
+    }
+    snapshot->Release();
+  }
+
+  // Information was not collected yet by this instance
   std::string infoStr;
   Arc::FileRead(config_.ControlDir()+G_DIR_SEPARATOR_S+"info.xml", infoStr);
   XMLNode infoXml(infoStr);
@@ -858,6 +881,40 @@ Arc::MCC_Status ARexRest::processDelegation(Arc::Message& inmsg,Arc::Message& ou
 
 // ---------------------------- JOBS ---------------------------------
 
+// Returns index of jobs states if it is available and holds all jobs.
+static JobStateIndex* GetJobStateIndex(ARexConfigContext& config) {
+  JobStateIndex* index = config.GmConfig().GetJobStateIndex();
+  if(!index) return NULL;
+  if(!index->Complete()) {
+    std::list<std::string> ids;
+    if(!JobsList::GetAllJobIds(config.GmConfig(),ids)) return NULL;
+    index->Populate(config.GmConfig(),ids);
+    if(!index->Complete()) return NULL;
+  }
+  return index;
+}
+
+// Checks conditional headers of request against state of user's jobs in
+// index and sets validators in response. Returns true if client's copy is current.
+static bool ListingNotModified(Arc::Message& inmsg, Arc::Message& outmsg, JobStateIndex& index,
+                               const std::string& dn, const std::string& filter) {
+  std::string etag = JobsListingTag(index.Generation(dn),dn,filter);
+  Arc::Time modified(index.LastModified(dn));
+  outmsg.Attributes()->set("HTTP:etag",etag);
+  outmsg.Attributes()->set("HTTP:last-modified",modified.str(Arc::RFC1123Time));
+  return IsNotModified(etag,modified.GetTime(),
+                       inmsg.Attributes()->get("HTTP:if-none-match"),
+                       inmsg.Attributes()->get("HTTP:if-modified-since"));
+}
+
+static Arc::MCC_Status HTTPNotModified(Arc::Message& inmsg, Arc::Message& outmsg) {
+  Arc::PayloadRaw* outpayload = new Arc::PayloadRaw();
+  delete outmsg.Payload(outpayload);
+  outmsg.Attributes()->set("HTTP:CODE","304");
+  outmsg.Attributes()->set("HTTP:REASON","Not Modified");
+  return Arc::MCC_Status(Arc::STATUS_OK);
+}
+
 static bool processJobInfo(Arc::Message& inmsg,ARexConfigContext& config, Arc::Logger& logger, std::string const & id, XMLNode jobXml);
 static bool processJobStatus(Arc::Message& inmsg,ARexConfigContext& config, Arc::Logger& logger, std::string const & id, XMLNode jobXml);
 static bool processJobKill(Arc::Message& inmsg,ARexConfigContext& config, Arc::Logger& logger, std::string const & id, XMLNode jobXml);
@@ -888,6 +945,30 @@ Arc::MCC_Status ARexRest::processJobs(Arc::Message& inmsg,Arc::Message& outmsg,P
     std::list<std::string> states;
     tokenize(context["state"], states, ",");
     XMLNode listXml("<jobs/>");
+    JobStateIndex* index = GetJobStateIndex(*config);
+    if(index) {
+      // Answer from memory
+      if(ListingNotModified(inmsg,outmsg,*index,config->GridName(),context["state"]))
+        return HTTPNotModified(inmsg,outmsg);
+      std::list<std::pair<std::string,JobStateIndex::Entry> > jobs;
+      index->Jobs(config->GridName(),jobs);
+      for(std::list<std::pair<std::string,JobStateIndex::Entry> >::iterator job = jobs.begin(); job != jobs.end(); ++job) {
+        // Jobs without session directory are not presented to clients
+        if(!job->second.session_exists) continue;
+        std::string rest_state;
+        if(!states.empty()) {
+          convertActivityStatusREST(GMJob::get_state_name(job->second.state),rest_state,
+                                    job->second.failed,job->second.pending,
+                                    job->second.failed_state,job->second.failed_cause);
+          if(std::find(states.begin(),states.end(),rest_state) == states.end()) continue;
+        }
+        XMLNode jobXml = listXml.NewChild("job");
+        jobXml.NewChild("id") = job->first;
+        if(!rest_state.empty())
+          jobXml.NewChild("state") = rest_state;
+      }
+      return HTTPResponse(inmsg, outmsg, listXml);
+    }
     std::list<std::string> ids = ARexJob::Jobs(*config,logger_);
     for(std::list<std::string>::iterator itId = ids.begin(); itId != ids.end(); ++itId) {
       std::string rest_state;
@@ -1154,6 +1235,20 @@ static bool processJobInfo(Arc::Message& inmsg,ARexConfigContext& config, Arc::L
 }
 
 static bool processJobStatus(Arc::Message& inmsg,ARexConfigContext& config, Arc::Logger& logger, std::string const & id, XMLNode jobXml) {
+  JobStateIndex* index = GetJobStateIndex(config);
+  JobStateIndex::Entry entry;
+  if(index && index->Get(id,entry) && entry.local_known && entry.state_known &&
+     (entry.dn == config.GridName()) && entry.session_exists) {
+    // Job owner asks - answer from memory. Others need full authorization check below.
+    std::string rest_state;
+    convertActivityStatusREST(GMJob::get_state_name(entry.state),rest_state,
+                              entry.failed,entry.pending,entry.failed_state,entry.failed_cause);
+    jobXml.NewChild("status-code") = "200";
+    jobXml.NewChild("reason") = "OK";
+    jobXml.NewChild("id") = id;
+    jobXml.NewChild("state") = rest_state;
+    return true;
+  }
   ARexJob job(id,config,logger);
   if(!job) {
     // There is no such job
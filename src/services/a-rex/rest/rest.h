@@ -9,10 +9,11 @@
 
 namespace ARex {
 
+  class OptimizedInformationContainer;
 
   class ARexRest {
    public:
-    ARexRest(Arc::Config *cfg, Arc::PluginArgument *parg, GMConfig& config, ARex::DelegationStores& delegation_stores, unsigned int& all_jobs_count);
+    ARexRest(Arc::Config *cfg, Arc::PluginArgument *parg, GMConfig& config, ARex::DelegationStores& delegation_stores, unsigned int& all_jobs_count, OptimizedInformationContainer& infodoc);
     virtual ~ARexRest(void);
     Arc::MCC_Status process(Arc::Message& inmsg,Arc::Message& outmsg);
 
@@ -34,6 +35,7 @@ namespace ARex {
     ARex::GMConfig& config_;
     ARex::DelegationStores& delegation_stores_;
     unsigned int& all_jobs_count_;
+    OptimizedInformationContainer& infodoc_;
 
     Arc::MCC_Status processVersions(Arc::Message& inmsg,Arc::Message& outmsg,ProcessingContext& context);
 
@@ -0,0 +1,82 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <arc/DateTime.h>
+
+#include "../rest/ConditionalRequest.h"
+
+class ConditionalRequestTest
+  : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(ConditionalRequestTest);
+  CPPUNIT_TEST(TestTag);
+  CPPUNIT_TEST(TestIfNoneMatch);
+  CPPUNIT_TEST(TestIfModifiedSince);
+  CPPUNIT_TEST(TestPrecedence);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void TestTag();
+  void TestIfNoneMatch();
+  void TestIfModifiedSince();
+  void TestPrecedence();
+};
+
+static const std::string user1("/O=Grid/CN=User 1");
+static const std::string user2("/O=Grid/CN=User 2");
+
+void ConditionalRequestTest::TestTag() {
+  std::string tag = ARex::JobsListingTag(5, user1, "");
+  CPPUNIT_ASSERT_EQUAL(std::string("\""), tag.substr(0, 1));
+  CPPUNIT_ASSERT_EQUAL(std::string("\""), tag.substr(tag.length() - 1));
+  CPPUNIT_ASSERT_EQUAL(tag, ARex::JobsListingTag(5, user1, ""));
+  // Different generation, user or states filter give different listing
+  CPPUNIT_ASSERT(tag != ARex::JobsListingTag(6, user1, ""));
+  CPPUNIT_ASSERT(tag != ARex::JobsListingTag(5, user2, ""));
+  CPPUNIT_ASSERT(tag != ARex::JobsListingTag(5, user1, "RUNNING"));
+  CPPUNIT_ASSERT(ARex::JobsListingTag(5, user1, "RUNNING") != ARex::JobsListingTag(5, user1, "FINISHED"));
+}
+
+void ConditionalRequestTest::TestIfNoneMatch() {
+  std::string tag = ARex::JobsListingTag(5, user1, "");
+  std::string other = ARex::JobsListingTag(5, user2, "");
+  time_t modified = 1000000;
+  CPPUNIT_ASSERT(!ARex::IsNotModified(tag, modified, "", ""));
+  CPPUNIT_ASSERT(ARex::IsNotModified(tag, modified, tag, ""));
+  CPPUNIT_ASSERT(ARex::IsNotModified(tag, modified, "W/" + tag, ""));
+  CPPUNIT_ASSERT(ARex::IsNotModified(tag, modified, "*", ""));
+  CPPUNIT_ASSERT(ARex::IsNotModified(tag, modified, other + ", " + tag, ""));
+  CPPUNIT_ASSERT(!ARex::IsNotModified(tag, modified, other, ""));
+  // Tag of same generation for another user does not match
+  CPPUNIT_ASSERT(!ARex::IsNotModified(other, modified, tag, ""));
+}
+
+void ConditionalRequestTest::TestIfModifiedSince() {
+  std::string tag = ARex::JobsListingTag(5, user1, "");
+  Arc::Time modified(1000000);
+  std::string same = modified.str(Arc::RFC1123Time);
+  std::string before = Arc::Time(999999).str(Arc::RFC1123Time);
+  std::string after = Arc::Time(1000001).str(Arc::RFC1123Time);
+  CPPUNIT_ASSERT(ARex::IsNotModified(tag, modified.GetTime(), "", same));
+  CPPUNIT_ASSERT(ARex::IsNotModified(tag, modified.GetTime(), "", after));
+  CPPUNIT_ASSERT(!ARex::IsNotModified(tag, modified.GetTime(), "", before));
+  CPPUNIT_ASSERT(!ARex::IsNotModified(tag, modified.GetTime(), "", "not a date"));
+}
+
+void ConditionalRequestTest::TestPrecedence() {
+  std::string tag = ARex::JobsListingTag(5, user1, "");
+  std::string old_tag = ARex::JobsListingTag(4, user1, "");
+  Arc::Time modified(1000000);
+  std::string after = Arc::Time(1000001).str(Arc::RFC1123Time);
+  std::string before = Arc::Time(999999).str(Arc::RFC1123Time);
+  // If-None-Match decides when present
+  CPPUNIT_ASSERT(!ARex::IsNotModified(tag, modified.GetTime(), old_tag, after));
+  CPPUNIT_ASSERT(ARex::IsNotModified(tag, modified.GetTime(), tag, before));
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ConditionalRequestTest);
@@ -0,0 +1,82 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "../InformationDocument.h"
+
+class InformationDocumentTest
+  : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(InformationDocumentTest);
+  CPPUNIT_TEST(TestSame);
+  CPPUNIT_TEST(TestCreationTime);
+  CPPUNIT_TEST(TestChanged);
+  CPPUNIT_TEST(TestValidity);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void TestSame();
+  void TestCreationTime();
+  void TestChanged();
+  void TestValidity();
+};
+
+static std::string Document(const std::string& creation, const std::string& running = "3", const std::string& validity = "10800") {
+  return "<Domains>\n"
+         "  <ComputingService BaseType=\"Service\" CreationTime=\"" + creation + "\" Validity=\"" + validity + "\">\n"
+         "    <RunningJobs>" + running + "</RunningJobs>\n"
+         "    <ComputingEndpoint BaseType=\"Endpoint\" CreationTime=\"" + creation + "\" Validity=\"" + validity + "\">\n"
+         "    </ComputingEndpoint>\n"
+         "  </ComputingService>\n"
+         "</Domains>\n";
+}
+
+static bool Changed(const std::string& old_doc, const std::string& new_doc, time_t age = 0) {
+  time_t now = 1000000;
+  return ARex::InformationChanged(old_doc.c_str(), old_doc.length(), now - age,
+                                  new_doc.c_str(), new_doc.length(), now);
+}
+
+void InformationDocumentTest::TestSame() {
+  CPPUNIT_ASSERT(!Changed(Document("2024-01-01T10:00:00Z"), Document("2024-01-01T10:00:00Z")));
+  CPPUNIT_ASSERT(!Changed("", ""));
+}
+
+void InformationDocumentTest::TestCreationTime() {
+  // Only time of producing document differs
+  CPPUNIT_ASSERT(!Changed(Document("2024-01-01T10:00:00Z"), Document("2024-01-01T10:10:00Z")));
+  // Values of different length are skipped too
+  CPPUNIT_ASSERT(!Changed(Document("2024-01-01T10:00:00Z"), Document("2024-01-01T10:10:00.123Z")));
+  // But attribute must be present in both
+  std::string doc = Document("2024-01-01T10:00:00Z");
+  std::string nodoc(doc);
+  nodoc.erase(nodoc.find(" CreationTime="), std::string(" CreationTime=\"2024-01-01T10:00:00Z\"").length());
+  CPPUNIT_ASSERT(Changed(doc, nodoc));
+  CPPUNIT_ASSERT(Changed(nodoc, doc));
+}
+
+void InformationDocumentTest::TestChanged() {
+  CPPUNIT_ASSERT(Changed(Document("2024-01-01T10:00:00Z", "3"), Document("2024-01-01T10:10:00Z", "4")));
+  CPPUNIT_ASSERT(Changed(Document("2024-01-01T10:00:00Z", "3"), Document("2024-01-01T10:00:00Z", "30")));
+  CPPUNIT_ASSERT(Changed(Document("2024-01-01T10:00:00Z", "30"), Document("2024-01-01T10:00:00Z", "3")));
+  // Truncated document
+  std::string doc = Document("2024-01-01T10:00:00Z");
+  CPPUNIT_ASSERT(Changed(doc, doc.substr(0, doc.length() - 1)));
+  CPPUNIT_ASSERT(Changed(doc.substr(0, doc.length() - 1), doc));
+  CPPUNIT_ASSERT(Changed("", doc));
+  CPPUNIT_ASSERT(Changed(Document("2024-01-01T10:00:00Z", "3", "10800"), Document("2024-01-01T10:00:00Z", "3", "3600")));
+}
+
+void InformationDocumentTest::TestValidity() {
+  // Document is published again before information expires
+  CPPUNIT_ASSERT(!Changed(Document("2024-01-01T10:00:00Z"), Document("2024-01-01T11:00:00Z"), 3600));
+  CPPUNIT_ASSERT(Changed(Document("2024-01-01T10:00:00Z"), Document("2024-01-01T11:30:00Z"), 5400));
+  CPPUNIT_ASSERT(!Changed(Document("2024-01-01T10:00:00Z", "3", "600"), Document("2024-01-01T10:04:00Z", "3", "600"), 240));
+  CPPUNIT_ASSERT(Changed(Document("2024-01-01T10:00:00Z", "3", "600"), Document("2024-01-01T10:05:00Z", "3", "600"), 300));
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(InformationDocumentTest);
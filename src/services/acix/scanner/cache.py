@@ -5,10 +5,11 @@ resource to fetch a bloom filter from
 import time
 
 from twisted.python import log
-from twisted.internet import task
+from twisted.internet import defer, task, threads
 from twisted.application import service
 
 from acix.core import bloomfilter
+from acix.scanner import cacheindex, pscan
 
 
 CAPACITY_CHUNK = 10000  # 10k entries is the least we bother with
@@ -26,12 +27,13 @@ class _Counter(object):
 
 class Cache(service.Service):
 
-    def __init__(self, scanner, capacity, refresh_interval, cache_url):
+    def __init__(self, scanner, capacity, refresh_interval, cache_url, use_index=False):
 
         self.scanner = scanner
         self.capacity = capacity
         self.refresh_interval = refresh_interval
         self.cache_url = cache_url
+        self.use_index = use_index
 
         self.cache_task = task.LoopingCall(self.renewCache)
 
@@ -45,6 +47,7 @@ class Cache(service.Service):
         log.msg("  Directory        : %s" % self.scanner.dir())
         log.msg("  Capacity         : %s" % self.capacity)
         log.msg("  Refresh interval : %i" % self.refresh_interval)
+        log.msg("  Use cache index  : %s" % self.use_index)
         log.msg("-" * 60)
 
         self.cache_task.start(self.refresh_interval)
@@ -55,6 +58,14 @@ class Cache(service.Service):
     def renewCache(self):
         n_bits = bloomfilter.calculateSize(capacity=self.capacity)
 
+        if self.use_index:
+            indexes = [ cacheindex.CacheIndex(cache_dir) for cache_dir in self.scanner.dir() ]
+            if indexes and all(index.size() == n_bits for index in indexes):
+                t0 = time.time()
+                d = threads.deferToThread(cacheindex.readIndexes, indexes)
+                d.addCallbacks(self._indexDone, self._indexFailed, callbackArgs=(t0,))
+                return d
+
         log.msg("Renewing cache. Filter capacity %i, size: %i bits" % (self.capacity, n_bits))
         filter = bloomfilter.BloomFilter(n_bits)
 
@@ -65,10 +76,66 @@ class Cache(service.Service):
             filter.add(key)
 
         t0 = time.time()
-        d = self.scanner.scan(addEntry)
+        if self.use_index:
+            d = self._seedIndexes(n_bits, addEntry)
+        else:
+            d = self.scanner.scan(addEntry)
         d.addCallback(self._scanDone, filter, t0, file_counter)
         return d
 
+    def _seedIndexes(self, n_bits, addEntry):
+        # Each cache directory is scanned separately in order to know
+        # which index the files belong to
+        defs = []
+        for cache_dir in self.scanner.dir():
+            index = cacheindex.CacheIndex(cache_dir)
+            keys = []
+            try:
+                # Created before scanning, so files added meanwhile are not lost
+                index.create(n_bits)
+            except (IOError, OSError) as e:
+                log.msg("Failed to create cache index in %s: %s" % (cache_dir, e))
+                index = None
+
+            def addIndexEntry(key, keys=keys):
+                keys.append(key)
+                addEntry(key)
+
+            def seed(_, index=index, keys=keys):
+                if index is not None:
+                    return threads.deferToThread(index.update, keys, 1)
+
+            def err(failure, cache_dir=cache_dir):
+                log.msg("Failed to seed cache index in %s" % cache_dir)
+                log.err(failure)
+
+            # Files still being downloaded are added to index by A-REX when
+            # download finishes, and partial files are never added
+            d = pscan.CacheScanner([cache_dir], self.scanner.cache_dump, skip_locked=True).scan(addIndexEntry)
+            d.addCallback(seed)
+            d.addErrback(err)
+            defs.append(d)
+
+        return defer.DeferredList(defs)
+
+    def _indexDone(self, result, t0):
+        td = time.time() - t0
+
+        self.cache, n_files = result
+        self.generation_time = time.time()
+        self.hashes = bloomfilter.DEFAULT_HASHES[:]
+
+        log.msg("Cache updated from index. Time taken: %f seconds. Entries: %i" % (round(td, 2), n_files))
+        if n_files == 0:
+            return
+
+        # Changed capacity makes index to be recreated on next cache run
+        self.checkCapacity(n_files)
+
+    def _indexFailed(self, failure):
+        log.msg("Failed to read cache index, keeping previous cache")
+        log.err(failure)
+
     def _scanDone(self, _, filter, t0, file_counter):
         td = time.time() - t0
 
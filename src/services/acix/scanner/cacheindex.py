@@ -0,0 +1,164 @@
+"""
+Access to the bloom filter index kept in cache directories.
+
+The index file is created and seeded by the scanner and then kept up to
+date by A-REX when files are downloaded to or removed from the cache (see
+FileCacheIndex in src/hed/libs/data). Files removed by cache-clean are
+listed in a separate file and are applied here. This way the filter can be
+published without scanning the whole cache every time.
+
+File layout (numbers are little-endian):
+  magic, size, number of files, reserved - 32 bytes header
+  size bytes of counters
+  size/8 bytes of bits - same as serialized BloomFilter
+"""
+
+import errno
+import fcntl
+import os
+import struct
+
+from acix.core import bloomfilter
+
+
+INDEX_FILE = 'acix.index'
+REMOVED_FILE = 'acix.removed'
+
+MAGIC = b'ACIXIDX1'
+HEADER = struct.Struct('<8sQQQ')
+COUNTER_MAX = 255
+
+
+
+def positions(key, size):
+    if isinstance(key, bytes):
+        key = key.decode()
+    ords = [ ord(c) for c in key ]
+    return [ bloomfilter.HASHES[hash](ords) % size for hash in bloomfilter.DEFAULT_HASHES ]
+
+
+
+class CacheIndex(object):
+
+    def __init__(self, cache_dir):
+        self.index_file = os.path.join(cache_dir, INDEX_FILE)
+        self.removed_file = os.path.join(cache_dir, REMOVED_FILE)
+
+
+    def _readHeader(self, f):
+        header = f.read(HEADER.size)
+        if len(header) != HEADER.size:
+            raise ValueError('Truncated index file %s' % self.index_file)
+        magic, size, entries, _ = HEADER.unpack(header)
+        if magic != MAGIC:
+            raise ValueError('Bad index file %s' % self.index_file)
+        return size, entries
+
+
+    def size(self):
+        """
+        Return number of filter positions or None if there is no usable index.
+        """
+        try:
+            with open(self.index_file, 'rb') as f:
+                fcntl.flock(f, fcntl.LOCK_SH)
+                return self._readHeader(f)[0]
+        except (IOError, OSError, ValueError):
+            return None
+
+
+    def create(self, size):
+        """
+        Create empty index replacing existing one. A-REX starts registering
+        files in it immediately.
+        """
+        tmp_file = '%s.%i' % (self.index_file, os.getpid())
+        with open(tmp_file, 'wb') as f:
+            f.write(HEADER.pack(MAGIC, size, 0, 0))
+            f.truncate(HEADER.size + size + size // 8)
+        os.rename(tmp_file, self.index_file)
+        # removals recorded for previous index do not apply to new one
+        try:
+            os.unlink(self.removed_file)
+        except OSError:
+            pass
+
+
+    def update(self, keys, delta):
+        """
+        Register (delta 1) or unregister (delta -1) files with given keys.
+        """
+        if not keys:
+            return
+        with open(self.index_file, 'r+b') as f:
+            fcntl.flock(f, fcntl.LOCK_EX)
+            size, entries = self._readHeader(f)
+            counters = bytearray(f.read(size))
+            bits = bytearray(f.read(size // 8))
+            for key in keys:
+                for i in positions(key, size):
+                    counter = counters[i]
+                    # saturated counter lost track of number of files
+                    if counter == COUNTER_MAX or (counter == 0 and delta < 0):
+                        continue
+                    counter += delta
+                    counters[i] = counter
+                    if counter == 0:
+                        bits[i // 8] &= ~(1 << (i % 8)) & 0xFF
+                    else:
+                        bits[i // 8] |= 1 << (i % 8)
+            entries = max(entries + delta * len(keys), 0)
+            f.seek(0)
+            f.write(HEADER.pack(MAGIC, size, entries, 0))
+            f.write(counters)
+            f.write(bits)
+
+
+    def applyRemoved(self):
+        """
+        Unregister files listed by cache-clean as removed.
+        """
+        try:
+            f = open(self.removed_file, 'r+')
+        except IOError as e:
+            if e.errno == errno.ENOENT:
+                return 0
+            raise
+        with f:
+            fcntl.flock(f, fcntl.LOCK_EX)
+            keys = [ line.strip() for line in f if line.strip() ]
+            self.update(keys, -1)
+            f.truncate(0)
+        return len(keys)
+
+
+    def read(self):
+        """
+        Return tuple of (serialized filter, number of files).
+        """
+        with open(self.index_file, 'rb') as f:
+            fcntl.flock(f, fcntl.LOCK_SH)
+            size, entries = self._readHeader(f)
+            f.seek(HEADER.size + size)
+            bits = f.read(size // 8)
+        return bits, entries
+
+
+
+def readIndexes(indexes):
+    """
+    Apply pending removals and return tuple of (filter, number of files)
+    combined from all indexes. All indexes must have same size.
+    """
+    bits = None
+    entries = 0
+    for index in indexes:
+        index.applyRemoved()
+        index_bits, index_entries = index.read()
+        if bits is None:
+            bits = bytearray(index_bits)
+        else:
+            for i, b in enumerate(bytearray(index_bits)):
+                bits[i] |= b
+        entries += index_entries
+    return bytes(bits), entries
@@ -24,7 +24,7 @@ DEFAULT_WS_INTERFACE = 'https://hostname:443/arex' # in case not defined in arc.
 ARC_CONF = '/etc/arc.conf'
 
 def getCacheConf():
-    '''Return a tuple of (cache_url, cache_dump, cache_host, cache_port, x509_host_key, x509_host_cert, x509_cert_dir)'''
+    '''Return a tuple of (cache_url, cache_dump, cache_index, cache_host, cache_port, x509_host_key, x509_host_cert, x509_cert_dir)'''
 
     config.parse_arc_conf(os.environ['ARC_CONFIG'] if 'ARC_CONFIG' in os.environ else ARC_CONF)
 
@@ -39,6 +39,7 @@ def getCacheConf():
         cache_url = '%s/cache' % arex_url
 
     cache_dump = config.get_value('cachedump', 'acix-scanner') == 'yes'
+    cache_index = config.get_value('cacheindex', 'acix-scanner') == 'yes'
     cache_host = config.get_value('hostname', 'acix-scanner') or CACHE_INTERFACE
     cache_port = int(config.get_value('port', 'acix-scanner') or CACHE_SSL_PORT)
 
@@ -46,16 +47,16 @@ def getCacheConf():
     x509_host_cert = config.get_value('x509_host_cert', ['acix-scanner', 'common']) or DEFAULT_HOST_CERT
     x509_cert_dir = config.get_value('x509_cert_dir', ['acix-scanner', 'common']) or DEFAULT_CERTIFICATES
 
-    return (cache_url, cache_dump, cache_host, cache_port, x509_host_key, x509_host_cert, x509_cert_dir)
+    return (cache_url, cache_dump, cache_index, cache_host, cache_port, x509_host_key, x509_host_cert, x509_cert_dir)
 
 
 def createCacheApplication(use_ssl=SSL_DEFAULT, port=None, cache_dir=None,
                            capacity=DEFAULT_CAPACITY, refresh_interval=DEFAULT_CACHE_REFRESH_INTERVAL):
 
-    (cache_url, cache_dump, cache_host, cache_port, x509_host_key, x509_host_cert, x509_cert_dir) = getCacheConf()
+    (cache_url, cache_dump, cache_index, cache_host, cache_port, x509_host_key, x509_host_cert, x509_cert_dir) = getCacheConf()
 
     scanner = pscan.CacheScanner(cache_dir, cache_dump)
-    cs = cache.Cache(scanner, capacity, refresh_interval, cache_url)
+    cs = cache.Cache(scanner, capacity, refresh_interval, cache_url, cache_index)
 
     cr = cacheresource.CacheResource(cs)
 
@@ -33,6 +33,7 @@ import time
 f = None
 t = time.time()
 dump_file = '%s'
+skip_locked = %s
 if dump_file:
     f = tempfile.NamedTemporaryFile('wt', delete=False)
     m = shelve.open(tempfile.gettempdir() + '/ARC-ACIX/.db')
@@ -40,6 +41,8 @@ if dump_file:
 for dirpath, dirnames, filenames in os.walk('%s'):
     for filename in filenames:
         if filename.endswith('.meta') and os.path.exists(os.path.join(dirpath, filename[:-5])):
+            if skip_locked and os.path.exists(os.path.join(dirpath, filename[:-5] + '.lock')):
+                continue
             url = dirpath.rsplit('/')[-1] + filename.split('.')[0]
             print(url + "\\r\\n", end=' ')
             if dump_file and time.time() < t + 300: # Don't spend more than 5 mins looking up URLs
@@ -102,13 +105,15 @@ def getARCCacheDirs():
 
 class CacheScanner(object):
 
-    def __init__(self, cache_dir=[], cache_dump=False):
+    def __init__(self, cache_dir=[], cache_dump=False, skip_locked=False):
 
         if not cache_dir:
             cache_dir = getARCCacheDirs()
 
         self.cache_dir = cache_dir
         self.cache_dump = cache_dump
+        # Files being downloaded (or left by failed download) have a lock
+        self.skip_locked = skip_locked
 
 
     def dir(self):
@@ -125,7 +130,7 @@ class CacheScanner(object):
             except: pass
 
         for cd in self.cache_dir:
-            program = SCAN_PROGRAM_DUMP % (dump_file, cd)
+            program = SCAN_PROGRAM_DUMP % (dump_file, self.skip_locked, cd)
 
             tf = tempfile.NamedTemporaryFile('wt')
             tf.write(program)
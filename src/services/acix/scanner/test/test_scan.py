@@ -83,3 +83,19 @@ class ScanTestCase(unittest.TestCase):
         self.failUnlessIn('9f4f96f6aada65ef3dafce1af2e36ba8428aeb03', l)
         self.failUnlessIn('dc294265ad76c92fe388f4f3c452734b10064ac2', l)
 
+
+    @defer.inlineCallbacks
+    def testScanSkipLocked(self):
+
+        f = open(self.tmpdir+'/cache/data/6b/27f066ef9e22d2e3e40c668cae72e9e163fafd.lock', 'w')
+        f.write('1234@localhost')
+        f.close()
+
+        l = []
+        yield pscan.CacheScanner([self.tmpdir+'/cache']).scan(lambda url : l.append(url.decode()))
+        self.failUnlessIn('6b27f066ef9e22d2e3e40c668cae72e9e163fafd', l)
+
+        l = []
+        yield pscan.CacheScanner([self.tmpdir+'/cache'], skip_locked=True).scan(lambda url : l.append(url.decode()))
+        self.failIfIn('6b27f066ef9e22d2e3e40c668cae72e9e163fafd', l)
+        self.failUnlessIn('a57c87cedbb464eb765a9fa8b8d506686cf0d0ee', l)
@@ -0,0 +1,117 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <arc/StringConv.h>
+
+#include "DataDeliveryQuery.h"
+
+namespace DataStaging {
+
+  typedef std::map<std::string, DeliveryActiveDTRs::iterator> DeliveryIndex;
+
+  static void IndexActiveDTRs(DeliveryActiveDTRs& active_dtrs, DeliveryIndex& dtrs) {
+    for (DeliveryActiveDTRs::iterator i = active_dtrs.begin(); i != active_dtrs.end(); ++i) {
+      dtrs[i->first->get_id()] = i;
+    }
+  }
+
+  int DeliveryQueryWaitTime(Arc::XMLNode query, int max_wait_time) {
+    if (!query["WaitTime"]) return 0;
+    int wait_time = Arc::stringtoi((std::string)query["WaitTime"]);
+    if (wait_time > max_wait_time) wait_time = max_wait_time;
+    if (wait_time < 0) wait_time = 0;
+    return wait_time;
+  }
+
+  bool DeliveryQueryChanged(Arc::XMLNode query, DeliveryActiveDTRs& active_dtrs) {
+    DeliveryIndex dtrs;
+    IndexActiveDTRs(active_dtrs, dtrs);
+    for (Arc::XMLNode dtrnode = query["DTR"]; dtrnode; ++dtrnode) {
+      DeliveryIndex::iterator i = dtrs.find((std::string)dtrnode["ID"]);
+      // DTRs which are not active any more are reported at once
+      if (i == dtrs.end()) return true;
+      DTR_ptr dtr = i->second->first;
+      if (dtr->error() || dtr->get_status() == DTRStatus::TRANSFERRED) return true;
+    }
+    return false;
+  }
+
+  void DeliveryQueryResults(Arc::XMLNode query, Arc::XMLNode results,
+                            DeliveryActiveDTRs& active_dtrs,
+                            DeliveryArchivedDTRs& archived_dtrs,
+                            Arc::Logger& logger) {
+
+    bool changes_only = ((std::string)query["ChangesOnly"] == "true");
+    DeliveryIndex dtrs;
+    IndexActiveDTRs(active_dtrs, dtrs);
+
+    for (Arc::XMLNode dtrnode = query["DTR"]; dtrnode; ++dtrnode) {
+
+      std::string dtrid((std::string)dtrnode["ID"]);
+
+      DeliveryIndex::iterator index_it = dtrs.find(dtrid);
+
+      if (index_it == dtrs.end()) {
+        Arc::XMLNode resultelement = results.NewChild("Result");
+        resultelement.NewChild("ID") = dtrid;
+
+        // if not in active list, look in archived list
+        DeliveryArchivedDTRs::const_iterator arc_it = archived_dtrs.find(dtrid);
+        if (arc_it != archived_dtrs.end()) {
+          resultelement.NewChild("ResultCode") = arc_it->second.first;
+          resultelement.NewChild("ErrorDescription") = arc_it->second.second;
+          continue;
+        }
+
+        logger.msg(Arc::ERROR, "No such DTR %s", dtrid);
+        resultelement.NewChild("ResultCode") = "SERVICE_ERROR";
+        resultelement.NewChild("ErrorDescription") = "No such DTR";
+        continue;
+      }
+
+      DeliveryActiveDTRs::iterator dtr_it = index_it->second;
+      DTR_ptr dtr = dtr_it->first;
+      bool finished = (dtr->error() || dtr->get_status() == DTRStatus::TRANSFERRED);
+
+      if (!finished && changes_only && dtrnode["BytesTransferred"] &&
+          Arc::stringtoull((std::string)dtrnode["BytesTransferred"]) == dtr->get_bytes_transferred()) {
+        // Nothing new to report
+        continue;
+      }
+
+      Arc::XMLNode resultelement = results.NewChild("Result");
+      resultelement.NewChild("ID") = dtrid;
+      if (finished || !changes_only) resultelement.NewChild("Log") = dtr_it->second->str();
+      resultelement.NewChild("BytesTransferred") = Arc::tostring(dtr->get_bytes_transferred());
+
+      if (dtr->error()) {
+        logger.msg(Arc::INFO, "DTR %s failed: %s", dtrid, dtr->get_error_status().GetDesc());
+        resultelement.NewChild("ResultCode") = "TRANSFER_ERROR";
+        resultelement.NewChild("ErrorDescription") = dtr->get_error_status().GetDesc();
+        resultelement.NewChild("ErrorStatus") = Arc::tostring(dtr->get_error_status().GetErrorStatus());
+        resultelement.NewChild("ErrorLocation") = Arc::tostring(dtr->get_error_status().GetErrorLocation());
+        resultelement.NewChild("TransferTime") = Arc::tostring(dtr->get_transfer_time());
+        archived_dtrs[dtrid] = std::pair<std::string, std::string>("TRANSFER_ERROR", dtr->get_error_status().GetDesc());
+      }
+      else if (dtr->get_status() == DTRStatus::TRANSFERRED) {
+        logger.msg(Arc::INFO, "DTR %s finished successfully", dtrid);
+        resultelement.NewChild("ResultCode") = "TRANSFERRED";
+        resultelement.NewChild("TransferTime") = Arc::tostring(dtr->get_transfer_time());
+        // pass calculated checksum back to Scheduler (eg to insert in catalog)
+        if (dtr->get_destination()->CheckCheckSum()) resultelement.NewChild("CheckSum") = dtr->get_destination()->GetCheckSum();
+        archived_dtrs[dtrid] = std::pair<std::string, std::string>("TRANSFERRED", "");
+      }
+      else {
+        logger.msg(Arc::VERBOSE, "DTR %s still in progress (%lluB transferred)",
+                   dtrid, dtr->get_bytes_transferred());
+        resultelement.NewChild("ResultCode") = "TRANSFERRING";
+        continue;
+      }
+      // Terminal state
+      active_dtrs.erase(dtr_it);
+      dtrs.erase(index_it);
+    }
+  }
+
+} // namespace DataStaging
@@ -0,0 +1,39 @@
+#ifndef DATADELIVERYQUERY_H_
+#define DATADELIVERYQUERY_H_
+
+#include <map>
+#include <sstream>
+#include <string>
+
+#include <arc/Logger.h>
+#include <arc/Thread.h>
+#include <arc/XMLNode.h>
+
+#include <arc/data-staging/DTR.h>
+
+namespace DataStaging {
+
+  /// Active DTRs mapped to the stream with the transfer log
+  typedef std::map<DTR_ptr, Arc::ThreadedPointer<std::stringstream> > DeliveryActiveDTRs;
+  /// Archived DTRs, ID mapped to final state and short explanation
+  typedef std::map<std::string, std::pair<std::string, std::string> > DeliveryArchivedDTRs;
+
+  /// Time in seconds a DataDeliveryQuery asks to wait, limited to max_wait_time
+  int DeliveryQueryWaitTime(Arc::XMLNode query, int max_wait_time);
+
+  /// Returns true if any DTR in DataDeliveryQuery is finished or not active any more
+  bool DeliveryQueryChanged(Arc::XMLNode query, DeliveryActiveDTRs& active_dtrs);
+
+  /// Add Result elements for DTRs in DataDeliveryQuery to results.
+  /**
+   * Results of finished DTRs are moved from active_dtrs to archived_dtrs.
+   * Caller must hold locks protecting both lists.
+   */
+  void DeliveryQueryResults(Arc::XMLNode query, Arc::XMLNode results,
+                            DeliveryActiveDTRs& active_dtrs,
+                            DeliveryArchivedDTRs& archived_dtrs,
+                            Arc::Logger& logger);
+
+} // namespace DataStaging
+
+#endif /* DATADELIVERYQUERY_H_ */
@@ -118,6 +118,8 @@ namespace DataStaging {
       }
     }
     if (current_processes > 0) --current_processes;
+    // wake up queries waiting for changes
+    dtrs_changed.broadcast();
   }
 
   /*
@@ -329,11 +331,21 @@ namespace DataStaging {
    <DataDeliveryQuery>
      <DTR>
        <ID>id</ID>
+       <BytesTransferred>1234</BytesTransferred>
      </DTR>
      <DTR>
      ...
+     <WaitTime>10</WaitTime>
+     <ChangesOnly>true</ChangesOnly>
    </DataDeliveryQuery>
 
+   All DTRs of a client should be queried in one request. If WaitTime (in
+   seconds) is given the response is delayed until one of the DTRs finishes
+   or the time passes. If ChangesOnly is true then results for DTRs still in
+   transfer are returned only if BytesTransferred differs from the value
+   given in the request and Log is returned only for finished DTRs. This way
+   the client can keep one request outstanding and get only changes.
+
    Returns:
    <DataDeliveryQueryResponse>
      <DataDeliveryQueryResult>
@@ -350,86 +362,41 @@ namespace DataStaging {
        </Result>
        ...
      </DataDeliveryQueryResult>
+     <WaitTime>10</WaitTime>
    </DataDeliveryQueryResponse>
+
+   WaitTime in response is the time actually allowed for waiting and tells
+   the client that bulk queries and waiting are supported.
    */
   Arc::MCC_Status DataDeliveryService::Query(Arc::XMLNode in, Arc::XMLNode out) {
 
     Arc::XMLNode resp = out.NewChild("DataDeliveryQueryResponse");
     Arc::XMLNode results = resp.NewChild("DataDeliveryQueryResult");
 
-    for(int n = 0;;++n) {
-      Arc::XMLNode dtrnode = in["DataDeliveryQuery"]["DTR"][n];
-
-      if (!dtrnode) break;
-
-      std::string dtrid((std::string)dtrnode["ID"]);
-
-      Arc::XMLNode resultelement = results.NewChild("Result");
-      resultelement.NewChild("ID") = dtrid;
-
-      active_dtrs_lock.lock();
-      std::map<DTR_ptr, sstream_ptr>::iterator dtr_it = active_dtrs.begin();
-      for (; dtr_it != active_dtrs.end(); ++dtr_it) {
-        if (dtr_it->first->get_id() == dtrid) break;
-      }
-
-      if (dtr_it == active_dtrs.end()) {
+    Arc::XMLNode query = in["DataDeliveryQuery"];
+    int wait_time = DeliveryQueryWaitTime(query, max_wait_time);
+    resp.NewChild("WaitTime") = Arc::tostring(wait_time);
+    if (wait_time > 0) {
+      // Wait for any of the DTRs to finish. The condition is signalled every
+      // time a DTR comes back from Delivery, so check again after wake up.
+      Arc::Time deadline(Arc::Time() + Arc::Period(wait_time));
+      for (;;) {
+        active_dtrs_lock.lock();
+        bool changed = DeliveryQueryChanged(query, active_dtrs);
         active_dtrs_lock.unlock();
-
-        // if not in active list, look in archived list
-        archived_dtrs_lock.lock();
-        std::map<std::string, std::pair<std::string, std::string> >::const_iterator arc_it = archived_dtrs.find(dtrid);
-        if (arc_it != archived_dtrs.end()) {
-          resultelement.NewChild("ResultCode") = archived_dtrs[dtrid].first;
-          resultelement.NewChild("ErrorDescription") = archived_dtrs[dtrid].second;
-          archived_dtrs_lock.unlock();
-          continue;
-        }
-        archived_dtrs_lock.unlock();
-
-        logger.msg(Arc::ERROR, "No such DTR %s", dtrid);
-        resultelement.NewChild("ResultCode") = "SERVICE_ERROR";
-        resultelement.NewChild("ErrorDescription") = "No such DTR";
-        continue;
+        if (changed) break;
+        Arc::Time now;
+        if (now >= deadline) break;
+        Arc::Period remaining(deadline - now);
+        dtrs_changed.wait(remaining.GetPeriod()*1000 + remaining.GetPeriodNanoseconds()/1000000 + 1);
       }
-
-      DTR_ptr dtr = dtr_it->first;
-      resultelement.NewChild("Log") = dtr_it->second->str();
-      resultelement.NewChild("BytesTransferred") = Arc::tostring(dtr->get_bytes_transferred());
-
-      if (dtr->error()) {
-        logger.msg(Arc::INFO, "DTR %s failed: %s", dtrid, dtr->get_error_status().GetDesc());
-        resultelement.NewChild("ResultCode") = "TRANSFER_ERROR";
-        resultelement.NewChild("ErrorDescription") = dtr->get_error_status().GetDesc();
-        resultelement.NewChild("ErrorStatus") = Arc::tostring(dtr->get_error_status().GetErrorStatus());
-        resultelement.NewChild("ErrorLocation") = Arc::tostring(dtr->get_error_status().GetErrorLocation());
-        resultelement.NewChild("TransferTime") = Arc::tostring(dtr->get_transfer_time());
-        archived_dtrs_lock.lock();
-        archived_dtrs[dtrid] = std::pair<std::string, std::string>("TRANSFER_ERROR", dtr->get_error_status().GetDesc());
-        archived_dtrs_lock.unlock();
-      }
-      else if (dtr->get_status() == DTRStatus::TRANSFERRED) {
-        logger.msg(Arc::INFO, "DTR %s finished successfully", dtrid);
-        resultelement.NewChild("ResultCode") = "TRANSFERRED";
-        resultelement.NewChild("TransferTime") = Arc::tostring(dtr->get_transfer_time());
-        // pass calculated checksum back to Scheduler (eg to insert in catalog)
-        if (dtr->get_destination()->CheckCheckSum()) resultelement.NewChild("CheckSum") = dtr->get_destination()->GetCheckSum();
-        archived_dtrs_lock.lock();
-        archived_dtrs[dtrid] = std::pair<std::string, std::string>("TRANSFERRED", "");
-        archived_dtrs_lock.unlock();
-      }
-      else {
-        logger.msg(Arc::VERBOSE, "DTR %s still in progress (%lluB transferred)",
-                   dtrid, dtr->get_bytes_transferred());
-        resultelement.NewChild("ResultCode") = "TRANSFERRING";
-        active_dtrs_lock.unlock();
-        return Arc::MCC_Status(Arc::STATUS_OK);
-      }
-      // Terminal state
-      //delete dtr_it->second;
-      active_dtrs.erase(dtr_it);
-      active_dtrs_lock.unlock();
     }
+
+    active_dtrs_lock.lock();
+    archived_dtrs_lock.lock();
+    DeliveryQueryResults(query, results, active_dtrs, archived_dtrs, logger);
+    archived_dtrs_lock.unlock();
+    active_dtrs_lock.unlock();
     return Arc::MCC_Status(Arc::STATUS_OK);
   }
 
@@ -555,7 +522,8 @@ namespace DataStaging {
   DataDeliveryService::DataDeliveryService(Arc::Config *cfg, Arc::PluginArgument* parg)
     : Service(cfg,parg),
       max_processes(100),
-      current_processes(0) {
+      current_processes(0),
+      max_wait_time(60) {
 
     valid = false;
     // Set medium format for logging
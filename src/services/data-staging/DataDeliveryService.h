@@ -11,6 +11,8 @@
 
 #include <arc/data-staging/DataDelivery.h>
 
+#include "DataDeliveryQuery.h"
+
 namespace DataStaging {
 
   /// Service for the Delivery layer of data staging.
@@ -36,6 +38,11 @@ namespace DataStaging {
    * deleted. This archived list is also kept in memory. In case a transfer is
    * never queried, a separate thread moves any transfers which completed more
    * than one hour ago to the archived list.
+   *
+   * A client should query all its DTRs in one request. Optionally the query
+   * can wait until one of the DTRs finishes and return only DTRs whose state
+   * changed, so that the number of queries depends on the number of changes
+   * rather than on the number of transfers.
    */
   class DataDeliveryService: public Arc::Service, DTRCallback {
 
@@ -62,6 +69,11 @@ namespace DataStaging {
     std::map<std::string, std::pair<std::string, std::string> > archived_dtrs;
     /// Lock for archive DTRs list
     Arc::SimpleCondition archived_dtrs_lock;
+    /// Signalled when a DTR comes back from Delivery, to wake up queries
+    /// waiting for changes
+    Arc::SimpleCondition dtrs_changed;
+    /// Maximum time in seconds a query may wait for changes
+    int max_wait_time;
     /// Object to manage Delivery processes
     DataDelivery delivery;
     /// Container for delegated credentials
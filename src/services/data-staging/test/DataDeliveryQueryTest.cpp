@@ -0,0 +1,217 @@
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <arc/StringConv.h>
+#include <arc/User.h>
+
+#include "../DataDeliveryQuery.h"
+
+using namespace DataStaging;
+
+static Arc::Logger logger(Arc::Logger::getRootLogger(), "DataDeliveryQueryTest");
+
+class DataDeliveryQueryTest
+  : public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(DataDeliveryQueryTest);
+  CPPUNIT_TEST(TestWaitTime);
+  CPPUNIT_TEST(TestChanged);
+  CPPUNIT_TEST(TestBulkResults);
+  CPPUNIT_TEST(TestChangesOnly);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void TestWaitTime();
+  void TestChanged();
+  void TestBulkResults();
+  void TestChangesOnly();
+
+  void setUp();
+  void tearDown();
+
+private:
+  DTR_ptr AddDTR(const std::string& log);
+  Arc::XMLNode Result(Arc::XMLNode results, const std::string& id);
+
+  std::list<DTRLogDestination> logs;
+  Arc::UserConfig cfg;
+  DeliveryActiveDTRs active;
+  DeliveryArchivedDTRs archived;
+  int count;
+};
+
+void DataDeliveryQueryTest::setUp() {
+  active.clear();
+  archived.clear();
+  count = 0;
+}
+
+void DataDeliveryQueryTest::tearDown() {
+  active.clear();
+  archived.clear();
+}
+
+DTR_ptr DataDeliveryQueryTest::AddDTR(const std::string& log) {
+  ++count;
+  DTR_ptr dtr(new DTR("mock://mocksrc/" + Arc::tostring(count), "mock://mockdest/" + Arc::tostring(count),
+                      cfg, "123456789", Arc::User().get_uid(), logs, "DataDeliveryQueryTest"));
+  CPPUNIT_ASSERT(*dtr);
+  dtr->set_status(DTRStatus::TRANSFERRING);
+  Arc::ThreadedPointer<std::stringstream> stream(new std::stringstream);
+  *stream << log;
+  active[dtr] = stream;
+  return dtr;
+}
+
+Arc::XMLNode DataDeliveryQueryTest::Result(Arc::XMLNode results, const std::string& id) {
+  for (Arc::XMLNode result = results["Result"]; result; ++result) {
+    if ((std::string)result["ID"] == id) return result;
+  }
+  return Arc::XMLNode();
+}
+
+void DataDeliveryQueryTest::TestWaitTime() {
+  Arc::XMLNode query("<DataDeliveryQuery><DTR><ID>1</ID></DTR></DataDeliveryQuery>");
+  CPPUNIT_ASSERT_EQUAL(0, DeliveryQueryWaitTime(query, 60));
+  query.NewChild("WaitTime") = "10";
+  CPPUNIT_ASSERT_EQUAL(10, DeliveryQueryWaitTime(query, 60));
+  query["WaitTime"] = "100";
+  CPPUNIT_ASSERT_EQUAL(60, DeliveryQueryWaitTime(query, 60));
+  query["WaitTime"] = "-5";
+  CPPUNIT_ASSERT_EQUAL(0, DeliveryQueryWaitTime(query, 60));
+}
+
+void DataDeliveryQueryTest::TestChanged() {
+  DTR_ptr dtr1 = AddDTR("log1");
+  DTR_ptr dtr2 = AddDTR("log2");
+
+  Arc::XMLNode query("<DataDeliveryQuery/>");
+  query.NewChild("DTR").NewChild("ID") = dtr1->get_id();
+  query.NewChild("DTR").NewChild("ID") = dtr2->get_id();
+  CPPUNIT_ASSERT(!DeliveryQueryChanged(query, active));
+
+  // Any finished transfer wakes up the query
+  dtr2->set_status(DTRStatus::TRANSFERRED);
+  CPPUNIT_ASSERT(DeliveryQueryChanged(query, active));
+
+  dtr2->set_status(DTRStatus::TRANSFERRING);
+  dtr2->set_error_status(DTRErrorStatus::TRANSFER_SPEED_ERROR, DTRErrorStatus::ERROR_TRANSFER, "Too slow");
+  CPPUNIT_ASSERT(DeliveryQueryChanged(query, active));
+
+  // So does a transfer which is not active any more
+  Arc::XMLNode unknown("<DataDeliveryQuery><DTR><ID>unknown</ID></DTR></DataDeliveryQuery>");
+  CPPUNIT_ASSERT(DeliveryQueryChanged(unknown, active));
+}
+
+void DataDeliveryQueryTest::TestBulkResults() {
+  DTR_ptr running = AddDTR("running log");
+  running->set_bytes_transferred(100);
+  DTR_ptr done = AddDTR("done log");
+  done->set_status(DTRStatus::TRANSFERRED);
+  DTR_ptr failed = AddDTR("failed log");
+  failed->set_error_status(DTRErrorStatus::TRANSFER_SPEED_ERROR, DTRErrorStatus::ERROR_TRANSFER, "Too slow");
+  archived["archived"] = std::pair<std::string, std::string>("TRANSFERRED", "");
+
+  // Running transfer first, results for the rest must follow it
+  Arc::XMLNode query("<DataDeliveryQuery/>");
+  query.NewChild("DTR").NewChild("ID") = running->get_id();
+  query.NewChild("DTR").NewChild("ID") = done->get_id();
+  query.NewChild("DTR").NewChild("ID") = failed->get_id();
+  query.NewChild("DTR").NewChild("ID") = "archived";
+  query.NewChild("DTR").NewChild("ID") = "unknown";
+  Arc::XMLNode results("<DataDeliveryQueryResult/>");
+  DeliveryQueryResults(query, results, active, archived, logger);
+
+  CPPUNIT_ASSERT_EQUAL(5, results.Size());
+
+  Arc::XMLNode result = Result(results, running->get_id());
+  CPPUNIT_ASSERT(result);
+  CPPUNIT_ASSERT_EQUAL(std::string("TRANSFERRING"), (std::string)result["ResultCode"]);
+  CPPUNIT_ASSERT_EQUAL(std::string("100"), (std::string)result["BytesTransferred"]);
+  CPPUNIT_ASSERT_EQUAL(std::string("running log"), (std::string)result["Log"]);
+
+  result = Result(results, done->get_id());
+  CPPUNIT_ASSERT(result);
+  CPPUNIT_ASSERT_EQUAL(std::string("TRANSFERRED"), (std::string)result["ResultCode"]);
+  CPPUNIT_ASSERT_EQUAL(std::string("done log"), (std::string)result["Log"]);
+
+  result = Result(results, failed->get_id());
+  CPPUNIT_ASSERT(result);
+  CPPUNIT_ASSERT_EQUAL(std::string("TRANSFER_ERROR"), (std::string)result["ResultCode"]);
+  CPPUNIT_ASSERT_EQUAL(std::string("Too slow"), (std::string)result["ErrorDescription"]);
+
+  result = Result(results, "archived");
+  CPPUNIT_ASSERT(result);
+  CPPUNIT_ASSERT_EQUAL(std::string("TRANSFERRED"), (std::string)result["ResultCode"]);
+
+  result = Result(results, "unknown");
+  CPPUNIT_ASSERT(result);
+  CPPUNIT_ASSERT_EQUAL(std::string("SERVICE_ERROR"), (std::string)result["ResultCode"]);
+
+  // Finished transfers are moved to archive
+  CPPUNIT_ASSERT_EQUAL(1, (int)active.size());
+  CPPUNIT_ASSERT(active.find(running) != active.end());
+  CPPUNIT_ASSERT_EQUAL(std::string("TRANSFERRED"), archived[done->get_id()].first);
+  CPPUNIT_ASSERT_EQUAL(std::string("TRANSFER_ERROR"), archived[failed->get_id()].first);
+
+  // Next query of finished transfers is answered from archive
+  Arc::XMLNode again("<DataDeliveryQuery/>");
+  again.NewChild("DTR").NewChild("ID") = done->get_id();
+  Arc::XMLNode again_results("<DataDeliveryQueryResult/>");
+  DeliveryQueryResults(again, again_results, active, archived, logger);
+  CPPUNIT_ASSERT_EQUAL(1, again_results.Size());
+  CPPUNIT_ASSERT_EQUAL(std::string("TRANSFERRED"), (std::string)again_results["Result"]["ResultCode"]);
+  CPPUNIT_ASSERT(!again_results["Result"]["Log"]);
+}
+
+void DataDeliveryQueryTest::TestChangesOnly() {
+  DTR_ptr unchanged = AddDTR("unchanged log");
+  unchanged->set_bytes_transferred(100);
+  DTR_ptr changed = AddDTR("changed log");
+  changed->set_bytes_transferred(200);
+  DTR_ptr fresh = AddDTR("fresh log");
+  DTR_ptr done = AddDTR("done log");
+  done->set_bytes_transferred(300);
+  done->set_status(DTRStatus::TRANSFERRED);
+
+  Arc::XMLNode query("<DataDeliveryQuery/>");
+  Arc::XMLNode dtrnode = query.NewChild("DTR");
+  dtrnode.NewChild("ID") = unchanged->get_id();
+  dtrnode.NewChild("BytesTransferred") = "100";
+  dtrnode = query.NewChild("DTR");
+  dtrnode.NewChild("ID") = changed->get_id();
+  dtrnode.NewChild("BytesTransferred") = "100";
+  // No previous result known by client
+  query.NewChild("DTR").NewChild("ID") = fresh->get_id();
+  dtrnode = query.NewChild("DTR");
+  dtrnode.NewChild("ID") = done->get_id();
+  dtrnode.NewChild("BytesTransferred") = "300";
+  query.NewChild("ChangesOnly") = "true";
+
+  Arc::XMLNode results("<DataDeliveryQueryResult/>");
+  DeliveryQueryResults(query, results, active, archived, logger);
+
+  CPPUNIT_ASSERT_EQUAL(3, results.Size());
+  CPPUNIT_ASSERT(!Result(results, unchanged->get_id()));
+
+  // Log is only sent for finished transfers
+  Arc::XMLNode result = Result(results, changed->get_id());
+  CPPUNIT_ASSERT(result);
+  CPPUNIT_ASSERT_EQUAL(std::string("TRANSFERRING"), (std::string)result["ResultCode"]);
+  CPPUNIT_ASSERT_EQUAL(std::string("200"), (std::string)result["BytesTransferred"]);
+  CPPUNIT_ASSERT(!result["Log"]);
+
+  result = Result(results, fresh->get_id());
+  CPPUNIT_ASSERT(result);
+  CPPUNIT_ASSERT_EQUAL(std::string("TRANSFERRING"), (std::string)result["ResultCode"]);
+
+  result = Result(results, done->get_id());
+  CPPUNIT_ASSERT(result);
+  CPPUNIT_ASSERT_EQUAL(std::string("TRANSFERRED"), (std::string)result["ResultCode"]);
+  CPPUNIT_ASSERT_EQUAL(std::string("done log"), (std::string)result["Log"]);
+}
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DataDeliveryQueryTest);
@@ -0,0 +1,117 @@
+// -*- indent-tabs-mode: nil -*-
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+// perftest_tlshandshake.cpp
+//
+// Compares time needed to make new HTTPS connection and send single
+// request with full TLS handshake and with resumed TLS session. Every
+// request is sent through new client hence new connection. Credentials
+// are taken from user configuration same way as for ARC client tools.
+
+#include <iostream>
+#include <string>
+#include <stdlib.h>
+#include <string.h>
+#include <glibmm/timer.h>
+
+#include <arc/Logger.h>
+#include <arc/StringConv.h>
+#include <arc/URL.h>
+#include <arc/UserConfig.h>
+#include <arc/crypto/OpenSSL.h>
+#include <arc/message/MCC.h>
+#include <arc/message/PayloadRaw.h>
+#include <arc/communication/ClientInterface.h>
+
+static bool runRequests(const Arc::MCCConfig& cfg, const Arc::URL& url, int count,
+                        double& seconds, unsigned long long& full, unsigned long long& resumed) {
+  unsigned long long full_before = 0;
+  unsigned long long resumed_before = 0;
+  Arc::OpenSSLHandshakeCounters(full_before, resumed_before);
+  Glib::TimeVal tBefore;
+  Glib::TimeVal tAfter;
+  tBefore.assign_current_time();
+  for(int n = 0; n < count; ++n) {
+    Arc::ClientHTTP client(cfg, url, 60);
+    Arc::PayloadRaw req;
+    Arc::HTTPClientInfo info;
+    Arc::PayloadRawInterface* resp = NULL;
+    Arc::MCC_Status status = client.process("GET", &req, &info, &resp);
+    if(resp) delete resp;
+    if(!status) {
+      // Any HTTP response is fine but connection must work
+      std::cerr << "Request failed: " << std::string(status) << std::endl;
+      return false;
+    }
+  }
+  tAfter.assign_current_time();
+  seconds = tAfter.as_double() - tBefore.as_double();
+  Arc::OpenSSLHandshakeCounters(full, resumed);
+  full -= full_before;
+  resumed -= resumed_before;
+  return true;
+}
+
+static void printResult(const std::string& title, int count, double seconds,
+                        unsigned long long full, unsigned long long resumed) {
+  std::cout << title << ": " << (seconds * 1000.0 / count) << " ms per connection, "
+            << full << " full and " << resumed << " resumed handshakes" << std::endl;
+}
+
+int main(int argc, char* argv[]){
+  int debug_level = -1;
+  Arc::LogStream logcerr(std::cerr);
+
+  while(argc >= 4) {
+    if(strcmp(argv[1],"-d") == 0) {
+      debug_level=Arc::istring_to_level(argv[2]);
+      argv[2]=argv[0]; argv+=2; argc-=2;
+    } else {
+      break;
+    };
+  }
+  if(debug_level >= 0) {
+    Arc::Logger::getRootLogger().setThreshold((Arc::LogLevel)debug_level);
+    Arc::Logger::getRootLogger().addDestination(logcerr);
+  }
+  int count = 0;
+  if ((argc != 3) || !Arc::stringto(argv[2], count) || (count <= 0)) {
+    std::cerr << "Wrong number of arguments!" << std::endl
+              << std::endl
+              << "Usage:" << std::endl
+              << "perftest_tlshandshake [-d debug] url connections" << std::endl
+              << std::endl
+              << "Arguments:" << std::endl
+              << "url         The https url of any HTTP service." << std::endl
+              << "connections The number of connections made in every mode." << std::endl
+              << "-d debug    The textual representation of desired debug level. Available " << std::endl
+              << "            levels: DEBUG, VERBOSE, INFO, WARNING, ERROR, FATAL." << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  Arc::URL url(argv[1]);
+  if (!url || (url.Protocol() != "https")) {
+    std::cerr << "URL must be https: " << argv[1] << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  Arc::UserConfig usercfg("");
+  Arc::MCCConfig mcc_cfg;
+  usercfg.ApplyToConfig(mcc_cfg);
+
+  double seconds = 0;
+  unsigned long long full = 0;
+  unsigned long long resumed = 0;
+
+  Arc::OpenSSLSessionReuse(false);
+  if (!runRequests(mcc_cfg, url, count, seconds, full, resumed)) exit(EXIT_FAILURE);
+  printResult("without reuse", count, seconds, full, resumed);
+
+  Arc::OpenSSLSessionReuse(true);
+  // First connection makes full handshake and fills cache
+  if (!runRequests(mcc_cfg, url, 1, seconds, full, resumed)) exit(EXIT_FAILURE);
+  if (!runRequests(mcc_cfg, url, count, seconds, full, resumed)) exit(EXIT_FAILURE);
+  printResult("with reuse", count, seconds, full, resumed);
+  return 0;
+}